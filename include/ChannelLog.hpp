@@ -0,0 +1,111 @@
+/**
+ * @file ChannelLog.hpp
+ * @brief 채널(채팅방, 전체 채널)별 메시지 순번과 최근 메시지 재전송 로그를 관리하는 `ChannelLog`를 정의합니다.
+ * @details 채널로 전달되는 모든 메시지에는 채널마다 1씩 증가하는 순번과, 순번이 어느 실행의 것인지 나타내는 에포크가 붙습니다.
+ *          클라이언트는 마지막으로 받은 `<에포크>.<순번>`을 기억했다가 재접속 후 `/since`로 그 이후 메시지만 다시 받습니다.
+ *          최근 메시지는 메모리에서 바로 돌려주고, 메모리에서 밀려난 오래된 구간만 `MessageHistory`에서 읽습니다.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class ChannelLog
+ * @brief 채널별 순번 발급기와 크기가 제한된 메모리 재전송 로그.
+ * @details 모든 메서드는 스레드 안전합니다. 채널마다 별도의 뮤텍스를 두어 서로 다른 채널의 전달이 서로를 막지 않습니다.
+ *          순번은 이 노드 안에서만 유효합니다. (클러스터의 다른 노드는 같은 메시지에 다른 순번을 붙입니다.)
+ *          순번은 프로세스가 바뀌거나(재시작, 무중단 교체) 채널이 정리된 뒤 다시 생기면 1부터 다시 매겨집니다.
+ *          그래서 채널 상태를 만들 때마다 새 에포크를 정하고, 요청한 에포크가 다르면 처음부터 다시 보냅니다.
+ */
+class ChannelLog {
+public:
+    /// 전체(전역) 채널 이름. 방 이름에는 쓸 수 없는 값이 아니므로 `/since`에서만 이 의미로 해석합니다.
+    static constexpr const char* global_channel = "*";
+
+    /// 로그에 보관된 메시지 하나
+    struct Entry {
+        std::uint64_t seq;       ///< 채널 내 순번 (1부터 시작)
+        std::string message;     ///< 순번 태그가 붙은, 클라이언트에 전달된 그대로의 메시지
+    };
+
+    /// `since`의 결과
+    struct Replay {
+        std::vector<Entry> entries;   ///< 메모리에 남아 있는 요청 구간의 메시지 (순번 오름차순)
+        std::uint64_t missing = 0;    ///< 메모리에서 이미 밀려나 히스토리에서 읽어야 하는 메시지 수
+        std::uint64_t last_seq = 0;   ///< 채널의 마지막 순번
+        std::string epoch;            ///< 채널의 에포크
+    };
+
+    /**
+     * @brief 생성자. 이 프로세스의 에포크를 무작위로 정합니다.
+     * @param capacity 채널마다 메모리에 보관할 최대 메시지 수.
+     * @param idle_ttl 보관 메시지를 비운(`drop_entries`) 채널을 이 시간 동안 쓰지 않으면 정리합니다.
+     */
+    explicit ChannelLog(std::size_t capacity = 1024, std::chrono::steady_clock::duration idle_ttl = std::chrono::minutes(10));
+
+    /**
+     * @brief 메시지에 다음 순번을 붙여 로그에 추가합니다.
+     * @param channel 채널 이름.
+     * @param message 전달할 메시지.
+     * @param deliver 붙인 순번과 순번 태그가 붙은 메시지를 받아 실제로 전달(하고 히스토리에 기록)하는 함수.
+     *                채널 잠금 안에서 호출되므로 같은 채널의 메시지는 순번 순서대로 전달되고 기록됩니다.
+     *                잠금을 오래 잡지 않도록 히스토리 한 줄 추가보다 무거운 작업은 하면 안 됩니다.
+     * @return 붙인 순번.
+     */
+    std::uint64_t append(const std::string& channel, const std::string& message,
+                         const std::function<void(std::uint64_t seq, const std::string& stamped)>& deliver = nullptr);
+
+    /**
+     * @brief `epoch`의 `after_seq` 다음 순번부터의 메시지를 돌려줍니다.
+     * @details `epoch`가 채널의 에포크와 다르거나 (다른 실행의 순번) `after_seq`가 채널의 마지막 순번보다 크면
+     *          0부터 요청한 것으로 취급합니다.
+     */
+    Replay since(const std::string& channel, const std::string& epoch, std::uint64_t after_seq) const;
+
+    /// 채널의 마지막 순번. 메시지가 없었으면 0.
+    std::uint64_t last_seq(const std::string& channel) const;
+
+    /// 채널의 에포크. 채널이 없으면 이 프로세스의 에포크.
+    std::string epoch(const std::string& channel) const;
+
+    /// 채널의 보관 메시지를 비웁니다. 순번은 유지되어 `idle_ttl` 안에 채널이 다시 생기면 이어서 증가합니다.
+    void drop_entries(const std::string& channel);
+
+    /// 지금 상태를 들고 있는 채널 수 (테스트 및 진단용)
+    std::size_t channel_count() const;
+
+    /// `message` 앞에 `#<channel>:<epoch>.<seq> ` 태그를 붙입니다.
+    static std::string stamp(const std::string& channel, const std::string& epoch, std::uint64_t seq, const std::string& message);
+
+private:
+    /// 채널 하나의 상태
+    struct Channel {
+        mutable std::mutex mutex;
+        std::string epoch;
+        std::uint64_t last_seq = 0;
+        std::deque<Entry> entries;   ///< 최근 메시지 (`capacity_` 이하)
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    /// 채널 상태를 찾습니다. `create`가 true이면 없을 때 만듭니다.
+    std::shared_ptr<Channel> find_channel(const std::string& channel, bool create) const;
+    /// 보관 메시지가 없고 `idle_ttl_` 동안 쓰이지 않은 채널을 지웁니다. `channels_mutex_`를 잡고 호출합니다.
+    void evict_idle(std::chrono::steady_clock::time_point now) const;
+
+    std::size_t capacity_;
+    std::chrono::steady_clock::duration idle_ttl_;
+    std::uint64_t epoch_base_;                     ///< 이 프로세스의 에포크 (채널마다 `next_generation_`을 더함)
+    mutable std::uint64_t next_generation_ = 1;    ///< `channels_mutex_`로 보호
+    mutable std::chrono::steady_clock::time_point last_sweep_;
+    mutable std::mutex channels_mutex_;   ///< `channels_` 맵 보호 (짧게만 잠금)
+    mutable std::map<std::string, std::shared_ptr<Channel>> channels_;
+};
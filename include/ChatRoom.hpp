@@ -5,8 +5,12 @@
 #pragma once
 
 #include "SessionInterface.hpp" // SessionPtr을 위해 SessionInterface 포함
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <vector>
 
@@ -14,13 +18,18 @@
  * @class ChatRoom
  * @brief 단일 채팅방을 나타내는 클래스.
  * @details 채팅방의 이름, 참여자 목록을 관리하고, 해당 방에만 메시지를 브로드캐스트하는 기능을 제공합니다.
- *          `ChatServer`에 의해 생성되고 관리됩니다.
+ *          `ChatServer`에 의해 생성되고 관리됩니다. 한 세션이 여러 방에 동시에 참여할 수 있으므로
+ *          세션의 활성 방(`current_room`)은 방이 아니라 `ChatServer`가 관리합니다.
  */
 class ChatRoom {
 private:
     std::string name_; ///< 채팅방의 고유한 이름
-    std::set<SessionPtr> participants_; ///< 채팅방에 참여 중인 세션들의 집합. `SessionPtr`은 `std::shared_ptr<SessionInterface>`입니다.
+    std::unordered_set<SessionPtr> participants_; ///< 채팅방에 참여 중인 세션들의 집합 (방 -> 멤버 색인). `SessionPtr`은 `std::shared_ptr<SessionInterface>`입니다.
     size_t max_participants_; ///< 최대 참여 가능 인원 수
+    std::vector<std::pair<const SessionInterface*, std::string>> roster_; ///< 멤버 명단 (세션, 입장 시 닉네임). 퇴장 시 마지막 항목과 자리를 바꿔 지운다.
+    std::unordered_map<const SessionInterface*, std::size_t> roster_index_; ///< 세션 -> `roster_` 위치
+    std::uint64_t roster_version_ = 0; ///< 명단이 바뀔 때마다 1씩 증가하는 버전
+    mutable std::map<std::size_t, std::string> roster_pages_; ///< 페이지 번호 -> 만들어 둔 명단 문자열 (명단이 바뀌면 비움)
     // ChatServer에 대한 참조가 필요하다면 추가
     // ChatServer& server_; 
 
@@ -34,8 +43,9 @@ public:
     /**
      * @brief 세션을 채팅방에 참여시킵니다.
      * @param participant 참여할 세션의 `SessionPtr`.
+     * @return 참여했으면 true, 방이 가득 찼으면 false.
      */
-    void join(SessionPtr participant);
+    bool join(SessionPtr participant);
 
     /**
      * @brief 세션을 채팅방에서 퇴장시킵니다.
@@ -47,13 +57,44 @@ public:
      * @brief `join`의 별칭(alias)입니다.
      * @param participant 참여할 세션.
      */
-    void add_participant(SessionPtr participant) { join(participant); }  // alias for join
+    bool add_participant(SessionPtr participant) { return join(participant); }  // alias for join
 
     /**
      * @brief `leave`의 별칭(alias)입니다.
      * @param participant 퇴장할 세션.
      */
     void remove_participant(SessionPtr participant) { leave(participant); } // alias for leave
+    /**
+     * @brief 참여자를 입장/퇴장 알림 없이 다른 세션으로 바꿉니다. (재접속으로 세션 객체가 바뀐 경우)
+     * @param from 기존 참여자 세션.
+     * @param to 새 세션.
+     * @return `from`이 참여자였으면 true.
+     */
+    bool replace_participant(const SessionPtr& from, const SessionPtr& to);
+
+    /**
+     * @brief 참여자의 명단상 닉네임을 바꿉니다. (참여 중 닉네임을 변경한 경우)
+     * @return `participant`가 참여자였으면 true.
+     */
+    bool rename_participant(const SessionPtr& participant, const std::string& nickname);
+
+    /// 명단 한 페이지에 담는 최대 닉네임 수
+    static constexpr std::size_t roster_page_size = 50;
+
+    /// 명단 버전. 입장, 퇴장, 닉네임 변경 시 증가합니다.
+    std::uint64_t roster_version() const { return roster_version_; }
+
+    /// 명단 페이지 수 (참여자가 없으면 0)
+    std::size_t roster_page_count() const { return (roster_.size() + roster_page_size - 1) / roster_page_size; }
+
+    /**
+     * @brief 명단의 한 페이지를 `"a, b, c"` 형태로 반환합니다.
+     * @param page 1부터 시작하는 페이지 번호. 범위를 벗어나면 빈 문자열.
+     * @details 만든 문자열은 명단이 바뀔 때까지 재사용하므로, 비용은 방 크기가 아니라 페이지 크기에 비례합니다.
+     *          입장한 멤버는 맨 끝에 붙지만, 퇴장하면 마지막 멤버가 빈자리로 옮겨지므로 명단 순서는 유지되지 않습니다.
+     *          따라서 버전이 다른 페이지를 이어 붙이면 이름이 빠지거나 겹칠 수 있습니다.
+     */
+    const std::string& roster_page(std::size_t page) const;
 
     /**
      * @brief 채팅방에 참여한 모든 세션에게 메시지를 브로드캐스트합니다.
@@ -62,6 +103,21 @@ public:
      */
     void broadcast(const std::string& message, SessionPtr sender);
 
+    /**
+     * @brief `broadcast`가 참여자에게 전달할 형태로 메시지를 포맷합니다.
+     * @param message 원본 메시지. `*`로 시작하는 시스템 메시지는 그대로 반환됩니다.
+     * @param sender_nick 발신자 닉네임.
+     * @return 참여자에게 그대로 전달할 수 있는 메시지.
+     */
+    std::string format_message(const std::string& message, const std::string& sender_nick) const;
+
+    /**
+     * @brief 이미 포맷된 메시지를 참여자들에게 그대로 전달합니다.
+     * @param formatted_message `format_message`로 만든 메시지 (다른 노드에서 중계된 메시지 등).
+     * @param exclude 전달에서 제외할 세션. `nullptr`이면 모든 참여자에게 전달합니다.
+     */
+    void deliver_formatted(const std::string& formatted_message, const SessionPtr& exclude);
+
     /**
      * @brief 현재 채팅방에 참여 중인 모든 사용자의 닉네임 목록을 반환합니다.
      * @return std::vector<std::string> 닉네임 목록.
@@ -94,7 +150,7 @@ public:
 
     /**
      * @brief 참여자 세션 목록을 반환합니다.
-     * @return const std::set<SessionPtr>& 참여자 세션의 집합.
+     * @return const std::unordered_set<SessionPtr>& 참여자 세션의 집합.
      */
-    const std::set<SessionPtr>& sessions() const { return participants_; }
+    const std::unordered_set<SessionPtr>& sessions() const { return participants_; }
 };
\ No newline at end of file
@@ -13,7 +13,9 @@
 #include <set>
 #include <map> 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#include <deque>
 #include <mutex>
 #include <atomic>
 #include <functional>
@@ -24,88 +26,37 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/beast/core/error.hpp>
 
 // Project includes
 #include "SessionInterface.hpp"
+#include "ChannelLog.hpp"
+#include "EphemeralEvents.hpp"
+#include "cluster/ClusterBus.hpp"
+#include "cluster/NicknameDirectory.hpp"
+#include "cluster/RoomRouter.hpp"
+#include "HistoryMaintenance.hpp"
+#include "UserStore.hpp"
+#include "PasswordHasher.hpp"
 
 // Forward declarations
 // class ChatSession; // 이제 필요 없음
 class ChatServer;
 // class ChatListener; // TCP 리스너 제거됨
-class UserAccount;
 class FileTransferInfo;
 class MessageHistory;
+class HistoryReplicator;
+struct HistoryQuery;
+struct HistoryQueryResult;
 class ChatRoom;
+class ParkedSession;
+class FileSpool;
 
 namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
 namespace beast = boost::beast;
 
-/**
- * @class UserAccount
- * @brief 사용자 계정 정보를 저장하는 클래스.
- * 
- * 사용자 인증 및 권한 관리를 위한 정보를 저장한다.
- */
-class UserAccount {
-private:
-    std::string username_;     ///< 사용자명
-    std::string password_hash_; ///< 비밀번호 해시
-    bool is_admin_ = false;    ///< 관리자 여부
-    std::string last_ip_;      ///< 마지막 접속 IP
-    std::string last_login_;   ///< 마지막 로그인 시간
-
-public:
-    /**
-     * @brief UserAccount 생성자.
-     * @param username 사용자명.
-     * @param password_hash 비밀번호 해시.
-     * @param is_admin 관리자 여부.
-     */
-    UserAccount(const std::string& username, 
-                const std::string& password_hash, 
-                bool is_admin = false);
-    
-    /**
-     * @brief 사용자 비밀번호 확인.
-     * @param password_hash 확인할 비밀번호 해시.
-     * @return 일치하면 true.
-     */
-    bool check_password(const std::string& password_hash) const;
-    
-    /**
-     * @brief 비밀번호 변경.
-     * @param new_password_hash 새 비밀번호 해시.
-     */
-    void set_password(const std::string& new_password_hash);
-    
-    /**
-     * @brief 관리자 권한 설정.
-     * @param is_admin 관리자 여부.
-     */
-    void set_admin(bool is_admin);
-    
-    /**
-     * @brief 관리자 여부 확인.
-     * @return 관리자이면 true.
-     */
-    bool is_admin() const { return is_admin_; }
-    
-    /**
-     * @brief 로그인 정보 업데이트.
-     * @param ip 접속 IP.
-     * @param login_time 로그인 시간.
-     */
-    void update_login_info(const std::string& ip, const std::string& login_time);
-    
-    /**
-     * @brief 사용자명 반환.
-     * @return 사용자명.
-     */
-    const std::string& username() const { return username_; }
-};
-
 /**
  * @class FileTransferInfo
  * @brief 파일 전송 정보를 저장하는 클래스.
@@ -242,11 +193,35 @@ private:
     
     // 채팅방 관리
     std::map<std::string, std::shared_ptr<ChatRoom>> rooms_;  ///< 채팅방 이름 -> 채팅방 객체 맵
+    std::unordered_map<const SessionInterface*, std::unordered_set<std::string>> session_rooms_; ///< 세션 -> 참여 중인 방 이름 색인 (`rooms_mutex_`로 보호)
     std::mutex rooms_mutex_;              ///< 채팅방 컬렉션 보호 뮤텍스
     
     // 사용자 및 파일 전송 관리
-    std::unordered_map<std::string, std::shared_ptr<UserAccount>> users_; ///< 사용자 계정 정보
-    std::unordered_map<std::string, std::shared_ptr<FileTransferInfo>> file_transfers_; ///< 진행 중인 파일 전송 작업
+    std::unique_ptr<UserStore> users_;    ///< 사용자 계정 저장소 (`load_users`에서 연다)
+    std::string users_path_;              ///< 계정 저장 경로 접두사 (비어 있으면 메모리에만 보관)
+    std::unique_ptr<PasswordHasher> password_hasher_; ///< 비밀번호 해시 전용 작업 스레드 (채팅 strand를 막지 않음)
+    CredentialCache login_tokens_;        ///< 로그인에 성공한 사용자의 재접속 토큰 (비밀번호 확인 생략용)
+    std::map<const SessionInterface*, std::string> session_accounts_; ///< 로그인한 세션 -> 계정 이름 (`strand_`에서만 접근)
+
+    /// 파일 전송 하나의 중계 상태 (흐름 제어)
+    struct FileRelay {
+        std::shared_ptr<FileTransferInfo> info;   ///< 전송 정보 및 진행률
+        std::size_t in_flight = 0;                ///< 수신자 큐에 들어가 아직 전송이 끝나지 않은 조각 수
+        std::function<void()> paused_sender;      ///< 창이 가득 차 읽기를 멈춘 송신자를 다시 읽게 하는 함수
+        std::shared_ptr<net::steady_timer> stall_timer; ///< 송신자가 멈춘 동안 수신자가 진행하지 않으면 전송을 실패시키는 타이머
+        /// 디스크에 쌓아 둔 조각. 파일을 열고 읽고 쓰는 일은 `strand`에서만 하며 `transfers_mutex_`를 잡지 않는다.
+        struct Spill {
+            net::strand<net::io_context::executor_type> strand; ///< 이 전송의 임시 파일 작업 순서를 지키는 strand
+            std::unique_ptr<FileSpool> file;      ///< 첫 조각을 쌓을 때 `strand`에서 연다
+        };
+        std::shared_ptr<Spill> spill;             ///< 임시 파일 (`file_spill_dir_`가 있을 때만)
+        std::size_t spooled = 0;                  ///< 임시 파일에 쌓았거나 쌓도록 맡긴 뒤 아직 꺼내지 않은 조각 수
+    };
+    std::unordered_map<std::string, FileRelay> file_transfers_; ///< 진행 중인 파일 전송 작업 (`transfers_mutex_`로 보호)
+    std::mutex transfers_mutex_;          ///< 파일 전송 상태 보호 뮤텍스 (잠근 채로 세션 함수를 호출하지 않음)
+    std::size_t file_chunk_window_ = 4;   ///< 전송당 수신자 큐에 동시에 둘 최대 조각 수
+    std::string file_spill_dir_;          ///< 창을 넘는 조각을 쌓아 둘 디렉터리 (비어 있으면 송신자 읽기를 멈춤)
+    std::chrono::milliseconds file_stall_timeout_{30000}; ///< 송신자 읽기를 멈춘 뒤 수신자가 조각을 하나도 받지 않으면 전송을 실패시키는 시간 (0이면 사용 안 함)
     
     // 스레드 안전 및 동시성 제어
     net::strand<net::io_context::executor_type> strand_; ///< 서버 상태 접근 직렬화를 위한 스트랜드
@@ -257,9 +232,66 @@ private:
     std::string config_file_;             ///< 설정 파일 경로 
     std::string history_dir_;             ///< 히스토리 저장 디렉토리
     std::unique_ptr<MessageHistory> history_; ///< 메시지 히스토리 관리자
-    
+    std::shared_ptr<HistoryReplicator> history_replicator_; ///< 히스토리 팔로워로 기록을 복제 (없으면 nullptr)
+    bool replica_reads_ = false;          ///< 스크롤백/검색을 팔로워에서 읽을지 여부
+    ChannelLog channel_log_;              ///< 채널별 메시지 순번 및 최근 메시지 재전송 로그
+    
+    // 클러스터 (다중 노드)
+    std::shared_ptr<ClusterBus> cluster_bus_;   ///< 노드 간 메시지 버스 (단일 노드 모드에서는 nullptr)
+    std::string node_id_;                      ///< 클러스터 내 이 노드의 ID
+    ClusterDeduplicator cluster_dedup_;        ///< 수신 메시지 중복 제거기 (`strand_` 위에서만 접근)
+    RoomRouter room_router_;                   ///< 방 소유 노드 및 구독 노드 관리 (`cluster_mutex_`로 보호)
+    NicknameDirectory nick_directory_;         ///< 닉네임 임대 및 위치 캐시 (`cluster_mutex_`로 보호)
+    std::mutex cluster_mutex_;                 ///< `room_router_`, `nick_directory_` 보호 뮤텍스 (`rooms_mutex_`, `nicknames_mutex_` 다음에 잠금)
+    std::map<std::string, std::string> node_incarnations_; ///< 노드 ID -> 시작 식별자 (재시작 감지용, `strand_`에서만 접근)
+    std::string incarnation_;                  ///< 이 노드의 시작 식별자
+    net::steady_timer cluster_timer_;          ///< 하트비트 전송 및 노드 만료 검사 타이머
+    std::chrono::milliseconds cluster_heartbeat_interval_{1000}; ///< 하트비트 간격 (만료는 3배)
+
+    /// 디렉터리 노드의 응답을 기다리는 닉네임 선점 요청
+    struct PendingNicknameClaim {
+        std::weak_ptr<SessionInterface> session;  ///< 닉네임을 요청한 세션
+        std::function<void(bool)> handler;        ///< 결과 콜백
+        std::chrono::steady_clock::time_point deadline; ///< 응답이 없으면 실패로 처리할 시각
+    };
+    std::map<std::string, PendingNicknameClaim> pending_nick_claims_; ///< 닉네임 -> 대기 중인 선점 요청 (`strand_`에서만 접근)
+
+    /// 디렉터리 노드의 위치 응답을 기다리는 개인 메시지 (전달이 확인되어야 보낸 사람에게 알리고 기록)
+    struct PendingPrivateMessage {
+        std::weak_ptr<SessionInterface> sender;   ///< 보낸 세션
+        std::string sender_nick;                  ///< 보낸 사람 닉네임
+        std::string receiver_nick;                ///< 받는 사람 닉네임
+        std::string message;                      ///< 원문
+        std::chrono::steady_clock::time_point deadline; ///< 응답이 없으면 실패로 알릴 시각
+    };
+    std::deque<PendingPrivateMessage> pending_private_; ///< 보낸 순서대로 쌓인 응답 대기 개인 메시지 (`cluster_mutex_`로 보호)
+
+    // 세션 재개 (모바일 재접속)
+    /// 재접속 토큰 하나에 묶인 세션 상태
+    struct ResumeEntry {
+        std::string secret;                          ///< 토큰에서 ID 뒤의 비밀값 (상수 시간에 비교)
+        std::weak_ptr<SessionInterface> live;        ///< 연결 중인 세션
+        std::shared_ptr<ParkedSession> parked;       ///< 연결이 끊긴 동안 자리를 지키는 세션 (없으면 연결 중)
+        std::shared_ptr<net::steady_timer> expiry;   ///< 유예 기간 만료 타이머
+    };
+    std::map<std::string, ResumeEntry> resume_entries_;            ///< 토큰 ID -> 세션 상태 (`strand_`에서만 접근)
+    std::map<const SessionInterface*, std::string> resume_tokens_; ///< 연결 중인 세션 -> 토큰 (`strand_`에서만 접근)
+    std::chrono::milliseconds resume_grace_{60000};                ///< 재접속 유예 기간 (0이면 사용 안 함)
+
+    // 일회성 이벤트 (입력 중 표시, 활동 중 알림)
+    EphemeralCoalescer ephemeral_;                   ///< 전송 대기 중인 일회성 이벤트 (`strand_`에서만 접근)
+    net::steady_timer ephemeral_timer_;              ///< 일회성 이벤트 전송 타이머 (대기 중인 이벤트가 있을 때만 동작)
+    std::chrono::milliseconds ephemeral_window_{250}; ///< 일회성 이벤트를 모으는 주기 (방마다 주기당 최대 한 줄)
+
+    // drain (무중단 재시작)
+    net::steady_timer drain_timer_;                  ///< 세션을 나누어 닫는 타이머 (`strand_` 위에서 동작)
+    std::vector<SessionPtr> drain_queue_;            ///< 아직 닫지 않은 세션 (무작위 순서, `strand_`에서만 접근)
+    std::size_t drain_batch_size_ = 1;               ///< 한 번에 닫을 세션 수
+    std::function<void()> on_drained_;               ///< drain 완료 시 호출할 함수
+
     // 상태 플래그
     std::atomic<bool> stopped_{false};    ///< 서버 중지 상태 플래그 (원자적 접근)
+    std::atomic<bool> draining_{false};   ///< drain 진행 여부 (퇴장 알림 억제용)
     bool require_auth_ = false;           ///< 사용자 인증 필요 여부
     
     // Variables for shutdown synchronization
@@ -299,6 +331,82 @@ public:
      */
     void stop();
 
+    /**
+     * @brief 연결된 세션을 `window` 동안 나누어 종료합니다. (무중단 재시작 시 이전 프로세스에서 사용)
+     * @param window 모든 세션을 닫을 때까지 걸리는 시간. 세션은 무작위 순서로 일정 간격마다 조금씩 닫힙니다.
+     * @param on_drained 마지막 세션까지 닫은 뒤 `strand_` 위에서 호출되는 함수. 보통 `stop()`과 프로세스 종료를 수행합니다.
+     * @details 새 프로세스가 이미 같은 리스닝 소켓으로 연결을 받고 있으므로, 닫힌 클라이언트는 곧바로 새 프로세스에 재접속합니다.
+     *          한꺼번에 끊지 않으므로 재접속도 `window`에 걸쳐 분산됩니다.
+     *          drain 중에는 퇴장 알림을 브로드캐스트하지 않습니다.
+     */
+    void drain(std::chrono::milliseconds window, std::function<void()> on_drained);
+
+    /**
+     * @brief 디스크 저장소를 새 프로세스에 넘기기 위해 닫습니다. (무중단 재시작 시 이전 프로세스에서 `drain` 전에 사용)
+     * @details 계정 저장소를 닫아 잠금을 풀며, 이후 이 프로세스에서 계정 등록/변경은 실패하고 종료 시 합치기도 하지 않습니다.
+     *          히스토리도 닫으므로 drain 중인 세션의 메시지는 기록되지 않으며, 히스토리 복제기도 멈춰 팔로워를 새 프로세스에 넘깁니다.
+     *          새 프로세스는 이 함수가 끝난 뒤에 같은 저장소를 엽니다.
+     */
+    void release_storage();
+
+    /**
+     * @brief 연결이 끊긴 세션의 닉네임과 방 멤버십을 유지하는 기간을 설정합니다. `run()` 이전에 호출해야 합니다.
+     * @param grace 유예 기간. 0이면 연결이 끊기는 즉시 퇴장 처리합니다.
+     */
+    void set_resume_grace_period(std::chrono::milliseconds grace) { resume_grace_ = grace; }
+
+    /**
+     * @brief 세션에 재접속 토큰을 발급합니다 (비동기).
+     * @param session 토큰을 받을 세션. 이미 발급된 토큰이 있으면 그 토큰을 다시 돌려줍니다.
+     * @param handler 발급된 토큰을 받을 콜백. 세션의 스트랜드에서 호출됩니다.
+     */
+    void issue_resume_token_async(SessionPtr session, std::function<void(std::string)> handler);
+
+    /**
+     * @brief 재접속 토큰으로 이전 세션의 닉네임, 방 멤버십, 놓친 메시지를 새 세션으로 옮깁니다 (비동기).
+     * @param token 이전 연결에서 받은 재접속 토큰. 한 번 사용하면 폐기됩니다.
+     * @param session 새로 연결된 세션. 아직 닉네임을 정하지 않은 상태여야 합니다.
+     * @param handler 결과 콜백. 세션의 스트랜드에서 호출됩니다.
+     * @details 이전 연결이 아직 끊긴 것으로 감지되지 않았으면(모바일 네트워크 전환 등) 이전 연결을 닫고 넘겨받습니다.
+     *          성공 시 복원 안내 메시지와 놓친 메시지가 새 세션에 순서대로 전달됩니다.
+     */
+    void resume_session_async(const std::string& token, SessionPtr session, std::function<void(bool)> handler);
+
+    /**
+     * @brief 클러스터 모드를 활성화합니다.
+     * @param bus 노드 간 메시지 버스 (`InProcessBus`, `SocketBus` 등).
+     * @param node_id 클러스터 내에서 유일한 이 노드의 ID.
+     * @param heartbeat_interval 노드 생존 알림 간격. 이 간격의 3배 동안 소식이 없는 노드는 클러스터에서 제외됩니다.
+     * @details 이후 `broadcast`, `broadcast_to_room`, `send_private_message`는 로컬 전달과 함께
+     *          버스에 메시지를 발행하고, 다른 노드가 발행한 메시지는 이 노드의 세션에 전달됩니다.
+     *          채팅방 메시지는 일관된 해싱으로 정해진 방 소유 노드를 거쳐, 그 방의 멤버가 있는 노드에만 전달됩니다.
+     *          `run()` 이전에 한 번만 호출해야 합니다.
+     */
+    void enable_cluster(std::shared_ptr<ClusterBus> bus, const std::string& node_id,
+                        std::chrono::milliseconds heartbeat_interval = std::chrono::milliseconds(1000));
+
+    /**
+     * @brief 채팅방의 소유 노드 ID를 반환합니다. 단일 노드 모드에서는 빈 문자열입니다.
+     * @param room_name 방 이름.
+     */
+    std::string room_owner(const std::string& room_name);
+
+    /**
+     * @brief 현재 클러스터에 살아 있는 것으로 보이는 노드 목록 (자기 자신 포함).
+     */
+    std::vector<std::string> cluster_nodes();
+
+    /**
+     * @brief 클러스터 모드 여부.
+     * @return 버스가 연결되어 있으면 true.
+     */
+    bool is_clustered() const { return cluster_bus_ != nullptr; }
+
+    /**
+     * @brief 이 노드의 클러스터 ID를 반환합니다. 단일 노드 모드에서는 빈 문자열입니다.
+     */
+    const std::string& node_id() const { return node_id_; }
+
     /** 
      * @brief 설정 파일 로드.
      * @param config_file_ 로 지정된 경로에서 설정을 로드한다. (구현 필요)
@@ -314,15 +422,16 @@ public:
     bool save_config();
     
     /**
-     * @brief 사용자 계정 정보 로드.
-     * @details 사용자 계정 파일에서 정보를 로드하여 `users_` 멤버를 채운다. (구현 필요)
+     * @brief 사용자 계정 저장소 열기.
+     * @details `users_path_`의 스냅샷을 매핑하고 변경 로그를 재생하여 `users_`를 연다.
      * @return 성공 시 true, 실패 시 false.
      */
     bool load_users();
     
     /**
      * @brief 현재 사용자 계정 정보를 파일에 저장.
-     * @details `users_` 멤버의 정보를 사용자 계정 파일에 저장한다. (구현 필요)
+     * @details 변경은 이미 로그에 기록되어 있으므로, 쌓인 변경분을 스냅샷으로 합쳐 다음 시작을 빠르게 한다.
+     *          `release_storage`로 저장소를 넘긴 뒤에는 새 프로세스의 파일이므로 아무것도 하지 않는다.
      * @return 성공 시 true, 실패 시 false.
      */
     bool save_users();
@@ -369,6 +478,7 @@ public:
      * @param handler 작업 완료 시 호출될 콜백 함수. `void(bool success)` 형태.
      * @details 닉네임 유효성 검사 후, Strand 위에서 중복 확인 및 등록을 시도하고, 
      *          결과(성공/실패)를 콜백 함수를 통해 비동기적으로 전달한다.
+     *          등록된 계정과 같은 이름의 닉네임은 그 계정으로 로그인한 세션만 쓸 수 있다.
      */
     void try_register_nickname_async(const std::string& nickname, 
                                       SessionPtr session, 
@@ -424,6 +534,9 @@ public:
      * @param room_name 입장할 채팅방 이름 (유효성 검사 수행).
      * @param session 입장할 세션 (`shared_ptr`).
      * @return 성공 시 true, 실패 시 false.
+     * @details 이미 참여 중인 다른 방에서는 나가지 않으며 (세션당 최대 `max_rooms_per_session`개),
+     *          입장한 방이 세션의 활성 방(`current_room`, 방 이름 없이 보낸 메시지의 대상)이 된다.
+     *          이미 참여 중인 방이면 활성 방만 바꾼다.
      */
     bool join_room(const std::string& room_name, SessionPtr session);
     
@@ -442,10 +555,43 @@ public:
      * @brief 현재 참여 중인 채팅방에서 퇴장 (동기).
      * @param room_name 퇴장할 채팅방 이름.
      * @param session 퇴장할 세션 (`shared_ptr`).
-     * @return 성공 시 true, 실패 시 false.
+     * @return 성공 시 true, 참여 중이 아니면 false.
+     * @details 활성 방에서 나가면 남은 방 중 하나가 활성 방이 된다.
      */
     bool leave_room(const std::string& room_name, SessionPtr session);
 
+    /// 세션당 동시에 참여할 수 있는 최대 방 수
+    static constexpr std::size_t max_rooms_per_session = 32;
+
+    /// 세션이 `room_name` 방에 참여 중인지 확인한다.
+    bool is_in_room(const std::string& room_name, const SessionPtr& session);
+
+    /**
+     * @brief 입력 중 표시(`typing`), 활동 중 알림(`active`) 같은 일회성 이벤트를 방에 보낸다.
+     * @param room_name 이벤트를 보낼 방. 세션이 참여 중이어야 한다.
+     * @param session 이벤트를 보낸 세션.
+     * @param kind 이벤트 종류 (`typing` 또는 `active`).
+     * @return 종류가 올바르지 않으면 false.
+     * @details 히스토리 기록, 순번, 클러스터 전달 없이 이 노드의 방 멤버에게만 전달한다.
+     *          같은 (방, 사용자)의 이벤트는 `ephemeral_window_` 안에서 하나로 합쳐지고,
+     *          방마다 주기당 한 줄(최대 20명)로 묶여 `deliver_ephemeral`로 전달된다.
+     */
+    bool send_ephemeral_event(const std::string& room_name, SessionPtr session, const std::string& kind);
+
+    /// 일회성 이벤트를 모으는 주기를 바꾼다. `run()` 전에 호출해야 한다.
+    void set_ephemeral_window(std::chrono::milliseconds window) { ephemeral_window_ = window; }
+
+    /// 세션이 참여 중인 방 이름 목록 (정렬됨)
+    std::vector<std::string> rooms_of(const SessionPtr& session);
+
+    /**
+     * @brief 방 명단의 한 페이지를 클라이언트에 보낼 한 줄로 만든다.
+     * @param room_name 방 이름.
+     * @param page 1부터 시작하는 페이지 번호.
+     * @return `* '<방>' 멤버 (<인원>) <페이지>/<전체 페이지> [v<버전>]: a, b, ...` 형태. 방이나 페이지가 없으면 빈 문자열.
+     */
+    std::string room_roster_page(const std::string& room_name, std::size_t page);
+
     /**
      * @brief 특정 세션이 참여 중인 모든 채팅방에서 퇴장시킨다.
      * @param session 퇴장시킬 세션 (`shared_ptr`).
@@ -480,26 +626,151 @@ public:
                            const std::string& message, 
                            SessionPtr sender);
                          
-    // 사용자 인증/등록/수정/삭제 메서드 선언 (구현 필요)
-    bool authenticate_user(const std::string& username, const std::string& password, SessionPtr session);
-    bool register_user(const std::string& username, const std::string& password, bool is_admin = false);
+    /// 계정 인증/등록 결과
+    enum class AuthStatus {
+        Ok,      ///< 성공
+        Failed,  ///< 사용자명/비밀번호/토큰이 맞지 않거나 이미 있는 사용자명
+        Busy     ///< 해시 작업 큐가 가득 참 (잠시 후 다시 시도)
+    };
+
+    /**
+     * @brief 비밀번호로 로그인합니다 (비동기).
+     * @param username 사용자명.
+     * @param password 평문 비밀번호.
+     * @param session 로그인할 세션. 성공하면 인증 상태가 됩니다.
+     * @param handler 결과와 재접속용 로그인 토큰을 받을 콜백. 세션의 스트랜드에서 호출됩니다.
+     * @details 비밀번호 확인은 `password_hasher_`의 작업 스레드에서 실행하므로 채팅 처리를 막지 않습니다.
+     *          없는 사용자명이어도 같은 시간이 걸리도록 더미 해시를 확인합니다.
+     */
+    void authenticate_user_async(const std::string& username, const std::string& password, SessionPtr session,
+                                 std::function<void(AuthStatus, std::string token)> handler);
+
+    /**
+     * @brief 이전 로그인에서 받은 토큰으로 로그인합니다 (비동기). 비밀번호 해시를 계산하지 않습니다.
+     * @param handler 결과와 같은 토큰을 받을 콜백. 세션의 스트랜드에서 호출됩니다.
+     */
+    void authenticate_token_async(const std::string& username, const std::string& token, SessionPtr session,
+                                  std::function<void(AuthStatus, std::string token)> handler);
+
+    /**
+     * @brief 새 계정을 등록합니다 (비동기).
+     * @param handler 결과 콜백. 세션의 스트랜드에서 호출됩니다.
+     * @details 비밀번호 해시는 작업 스레드에서 계산하고, 같은 사용자명이 먼저 등록되면 실패합니다.
+     *          계정은 같은 이름의 닉네임에 묶이므로, 그 닉네임을 다른 세션이 쓰고 있으면 실패합니다.
+     *          묶기 전에 그 닉네임으로 오간 귓속말은 계정에 보여 주지 않습니다.
+     */
+    void register_user_async(const std::string& username, const std::string& password, SessionPtr session,
+                             std::function<void(AuthStatus)> handler);
+
+    // 사용자 수정/삭제 메서드 선언 (구현 필요)
     bool update_user(const std::string& username, const std::string& new_password, int is_admin, SessionPtr admin_session);
     bool delete_user(const std::string& username, SessionPtr admin_session);
     
-    // 파일 전송 관련 메서드 선언 (구현 필요)
+    // 파일 전송 (바이너리 프레임 중계)
+    static constexpr std::size_t file_id_length = 16;          ///< 전송 ID 길이. 모든 바이너리 프레임은 전송 ID로 시작한다.
+    static constexpr std::size_t max_file_chunk = 64 * 1024;   ///< 프레임 하나에 담을 수 있는 최대 파일 데이터 크기
+    static constexpr std::size_t max_file_size = 1ull << 30;   ///< 전송할 수 있는 최대 파일 크기
+
+    /**
+     * @brief 같은 노드의 `receiver_nick`에게 파일 전송을 제안한다.
+     * @return 새 전송 ID. 수신자가 없거나 크기가 올바르지 않으면 빈 문자열.
+     * @details 수신자에게 `* FILE_OFFER <ID> <보낸사람> <크기> <파일명>`을 보낸다.
+     */
     std::string init_file_transfer(const std::string& filename, size_t filesize, SessionPtr sender, const std::string& receiver_nick);
+
+    /// 수신자가 전송을 수락한다. 송신자에게 `* FILE_ACCEPTED <ID>`를 보내며, 이후 송신자는 바이너리 프레임을 보낸다.
     bool accept_file_transfer(const std::string& transfer_id, SessionPtr session);
+
+    /// 대기 중인 전송은 수신자가 거절하고, 진행 중인 전송은 어느 쪽이든 취소한다.
     bool reject_file_transfer(const std::string& transfer_id, SessionPtr session);
-    bool process_file_data(const std::string& transfer_id, const char* data, size_t length, SessionPtr session);
+
+    /**
+     * @brief 송신자가 보낸 바이너리 프레임(`<전송 ID><데이터>`)을 수신자에게 그대로 중계한다.
+     * @param frame 수신한 프레임. 복사하지 않고 수신자 전송 큐에서 공유한다.
+     * @param on_ready 송신자가 다음 프레임을 읽어도 될 때 호출된다. false를 반환하면 호출되지 않는다.
+     * @return 진행 중인 전송의 송신자가 아니거나 크기가 맞지 않으면 false.
+     * @details 수신자 큐에 `file_chunk_window_`개의 조각이 쌓이면 `on_ready` 호출을 미뤄 송신자 읽기를 멈춘다.
+     *          `file_stall_timeout_` 동안 수신자가 조각을 하나도 받지 않으면 전송을 `stalled`로 실패시키고 송신자를 다시 읽게 한다.
+     *          `file_spill_dir_`가 있으면 대신 임시 파일에 쌓고, 전송별 strand에서 쓰기가 끝나면 송신자가 계속 읽는다.
+     */
+    bool process_file_data(const std::string& transfer_id, std::shared_ptr<const std::string> frame,
+                           SessionPtr session, std::function<void()> on_ready);
+
+    /// 모든 데이터가 수신자에게 전달된 전송을 끝내고 양쪽에 `* FILE_DONE <ID>`를 보낸다. 아직 남은 데이터가 있으면 false.
     bool complete_file_transfer(const std::string& transfer_id, SessionPtr session);
+
+    /// 창을 넘는 조각을 쌓아 둘 디렉터리를 지정한다. 빈 문자열이면 디스크를 쓰지 않고 송신자 읽기를 멈춘다.
+    void set_file_spill_dir(const std::string& dir) { file_spill_dir_ = dir; }
+
+    /// 송신자 읽기를 멈춘 전송을 수신자가 진행하지 않을 때 실패시키기까지의 시간을 바꾼다. 0이면 수신자가 나갈 때까지 기다린다.
+    void set_file_stall_timeout(std::chrono::milliseconds timeout) { file_stall_timeout_ = timeout; }
+
+    /// 전송당 수신자 큐에 동시에 둘 최대 조각 수를 바꾼다. `run()` 전에 호출해야 한다.
+    void set_file_chunk_window(std::size_t window) { file_chunk_window_ = window == 0 ? 1 : window; }
+
+    /// 계정 저장 경로 접두사를 지정한다. (`<경로>.snapshot`, `<경로>.log`) `run()` 전에 호출해야 한다.
+    void set_users_path(const std::string& path) { users_path_ = path; }
+
+    /**
+     * @brief 비밀번호 해시 작업 스레드를 다시 만든다. `run()` 전에 호출해야 한다.
+     * @param threads 동시에 계산할 해시 수.
+     * @param max_queue 대기할 수 있는 최대 요청 수. 넘으면 로그인/등록을 바로 거절한다.
+     * @param params 새 비밀번호에 사용할 scrypt 비용.
+     */
+    void set_password_hashing(std::size_t threads, std::size_t max_queue, KdfParams params);
+
+    /// 로그인 토큰의 유효 기간을 바꾼다. 0이면 토큰을 발급하지 않는다.
+    void set_login_token_ttl(std::chrono::seconds ttl) { login_tokens_.set_ttl(ttl); }
     
     // 메시지 히스토리 관련 메서드 선언 (구현 필요)
     void set_history_enabled(bool enable);
     bool is_history_enabled() const;
+
+    /// 히스토리 보존 정책을 설정하고, 주기가 0보다 크면 백그라운드 정리(오래된 기록 정리/보관, 작은 블록 병합)를 시작한다.
+    void set_history_retention(const RetentionConfig& config);
+
+    /**
+     * @brief 히스토리 기록을 팔로워 프로세스로 복제합니다.
+     * @param replicator 팔로워에 접속할 복제기.
+     * @param serve_reads true면 `/since`의 히스토리 구간과 `/search`를 팔로워에서 읽습니다.
+     *                    팔로워가 연결되어 있지 않거나 응답이 늦으면 이 노드의 히스토리에서 읽습니다.
+     * @details `run()` 이전에 한 번만 호출해야 합니다.
+     */
+    void enable_history_replication(std::shared_ptr<HistoryReplicator> replicator, bool serve_reads = true);
     std::vector<std::string> load_global_history(size_t limit = 50);
     std::vector<std::string> load_private_history(const std::string& user1, const std::string& user2, size_t limit = 50);
     std::vector<std::string> load_room_history(const std::string& room, size_t limit = 50);
 
+    /**
+     * @brief 채널에서 `after_seq` 이후에 전달된 메시지를 세션에 다시 보냅니다.
+     * @param channel 방 이름, 또는 전체 채널이면 `ChannelLog::global_channel`.
+     * @param epoch 클라이언트가 마지막으로 받은 메시지의 에포크. 채널의 에포크와 다르면 처음부터 보냅니다.
+     * @param after_seq 클라이언트가 마지막으로 받은 순번.
+     * @param session 메시지를 받을 세션.
+     * @details 메모리 로그에 남아 있는 구간은 순번 태그가 붙은 원래 메시지 그대로 보냅니다.
+     *          이미 밀려난 앞부분은 `* REPLAY_HISTORY <channel> <n>` 뒤에 `<시각> #<순번> [...]` 형식의 히스토리 줄로 보냅니다.
+     *          히스토리에 기록되지 않는 입장/퇴장 알림과 다른 노드에서 중계된 메시지는 이 구간에서 빠집니다.
+     *          마지막에 `* REPLAY_END <channel> <epoch>.<last_seq>`를 보냅니다. 재전송 중 도착한 실시간 메시지와
+     *          순서가 섞일 수 있으므로 클라이언트는 순번으로 중복을 걸러야 합니다.
+     */
+    void replay_channel_async(const std::string& channel, const std::string& epoch, std::uint64_t after_seq, SessionPtr session);
+
+    /**
+     * @brief 채팅방과 귓속말 기록을 검색해 세션에 한 페이지를 보냅니다.
+     * @param query 검색어 (모든 단어를 포함하는 메시지, 관련도와 최신 순).
+     * @param room 비어 있지 않으면 이 방의 기록만 찾습니다.
+     * @param page 1부터 시작하는 페이지 번호 (페이지당 10줄).
+     * @param session 결과를 받을 세션. 닉네임과 같은 계정으로 로그인했으면 그 닉네임이 참여한 귓속말도 포함합니다.
+     * @details `* SEARCH <전체 건수> <페이지>/<전체 페이지>` 뒤에 `  [#방] <기록 줄>` 또는 `  [PM] <기록 줄>`을 보냅니다.
+     */
+    void search_history_async(const std::string& query, const std::string& room, std::size_t page, SessionPtr session);
+
+    /// 채널의 마지막 순번. (테스트 및 진단용)
+    std::uint64_t channel_last_seq(const std::string& channel) const { return channel_log_.last_seq(channel); }
+
+    /// 채널의 에포크. (테스트 및 진단용)
+    std::string channel_epoch(const std::string& channel) const { return channel_log_.epoch(channel); }
+
 private:
     /** 
      * @brief 내부적으로 리스너를 생성하고 시작하는 함수.
@@ -509,6 +780,12 @@ private:
      */
     bool start_listening();
 
+    /**
+     * @brief 히스토리 질의를 팔로워(사용 중이면) 또는 이 노드의 히스토리에서 실행합니다.
+     * @param done 결과를 받을 함수. `ioc_` 또는 복제기의 strand에서 호출됩니다.
+     */
+    void read_history_async(HistoryQuery query, std::function<void(HistoryQueryResult)> done);
+
     /** 
      * @brief 서버 종료 시그널(SIGINT, SIGTERM) 대기 시작.
      * @details `signals_` 객체를 사용하여 비동기적으로 시그널을 기다리고, 수신 시 `stop()` 메서드를 호출한다.
@@ -516,9 +793,9 @@ private:
     void do_await_stop();
     
     /**
-     * @brief 비밀번호 해싱 함수 (구현 필요).
+     * @brief 비밀번호를 scrypt로 해시합니다. 호출한 스레드에서 계산하므로 strand 위에서 호출하면 안 됩니다.
      * @param password 평문 비밀번호.
-     * @return 해시된 비밀번호 문자열 (예: bcrypt, scrypt 사용 권장).
+     * @return `$scrypt$...` 형식의 해시. 실패하면 빈 문자열.
      */
     std::string hash_password(const std::string& password);
     
@@ -532,5 +809,140 @@ private:
     // Strand 내부에서 호출될 헬퍼 함수들
     void broadcast_impl(const std::string& message, const SessionPtr& sender);
     void leave_all_rooms_impl(const SessionPtr& session);
+
+    /// 세션이 참여 중인 모든 방의 명단에서 닉네임을 바꿉니다. `rooms_mutex_`를 잠급니다.
+    void rename_in_rooms(const SessionPtr& session, const std::string& nickname);
+
+    /// 모인 일회성 이벤트를 방마다 한 줄로 보내고, 남은 이벤트가 있으면 다음 주기를 예약합니다. `strand_` 위에서 실행됩니다.
+    void flush_ephemeral_events();
+
+    /// 수신자가 파일 조각 하나를 보낸 뒤 호출됩니다. 쌓아 둔 조각을 보내거나 멈춘 송신자를 다시 읽게 합니다.
+    void on_file_chunk_sent(const std::string& transfer_id);
+
+    /// 송신자 읽기를 멈춘 전송에 `file_stall_timeout_` 타이머를 건다. `transfers_mutex_`를 잠근 채 호출해야 합니다.
+    void arm_file_stall_timer(const std::string& transfer_id, FileRelay& relay);
+
+    /// 전송을 실패로 끝내고 양쪽에 `* FILE_FAILED <ID> <이유>`를 보냅니다. `transfers_mutex_`를 잠급니다.
+    void fail_file_transfer(const std::string& transfer_id, const std::string& reason);
+
+    /// 세션이 보내거나 받는 중인 모든 전송을 실패로 끝냅니다.
+    void abort_file_transfers(const SessionPtr& session);
+
+    /// 방 알림 메시지에 방 순번을 붙여 참여자에게 전달합니다. 호출 측이 `rooms_mutex_`를 잡고 있어도 됩니다.
+    void deliver_room_notice(const std::shared_ptr<ChatRoom>& room, const std::string& notice, const SessionPtr& exclude);
+
+    /// 세션을 방, 닉네임, 세션 목록에서 제거하고 퇴장을 알립니다. `strand_` 위에서 실행됩니다.
+    void remove_session_impl(const SessionPtr& session);
+
+    /**
+     * @brief 연결이 끊긴 세션을 `ParkedSession`으로 바꿔 끼우고 유예 기간 타이머를 시작합니다. `strand_` 위에서 실행됩니다.
+     * @return 세션을 보관했으면 true. 닉네임이 없거나 유예 기간이 0이면 false.
+     */
+    bool park_session(const std::string& token, const SessionPtr& session);
+
+    /// `from`이 차지하던 세션 목록, 닉네임, 방 멤버십 자리를 `to`로 바꿉니다. `strand_` 위에서 실행됩니다.
+    void replace_session(const SessionPtr& from, const SessionPtr& to);
+
+    /// 로그인 결과를 세션에 알립니다. 성공하면 세션의 계정을 `session_accounts_`에 먼저 기록합니다.
+    void finish_login(SessionPtr session, const std::string& username, bool ok, std::string token,
+                      std::function<void(AuthStatus, std::string)> handler);
+
+    /// 유예 기간이 끝난 보관 세션을 퇴장 처리합니다. `strand_` 위에서 실행됩니다.
+    void expire_parked_session(const std::string& token);
+
+    /// 토큰의 ID로 항목을 찾고 비밀값을 상수 시간에 비교합니다. 맞지 않으면 `end()`. `strand_` 위에서 실행됩니다.
+    std::map<std::string, ResumeEntry>::iterator find_resume_entry(const std::string& token);
+
+    /// 토큰이 맞으면 항목을 지웁니다. `strand_` 위에서 실행됩니다.
+    void erase_resume_entry(const std::string& token);
     void try_register_nickname_impl(const std::string& nickname_copy, std::weak_ptr<SessionInterface> weak_session, std::function<void(bool)> handler);
+
+    /**
+     * @brief `nicknames_`에서 닉네임 중복을 확인하고 등록합니다. 이전 닉네임 매핑은 제거합니다.
+     * @param check_only true이면 등록하지 않고 사용 가능 여부만 확인합니다.
+     * @return 등록(또는 등록 가능) 시 true.
+     */
+    bool register_nickname_local(const std::string& nickname, const SessionPtr& session, bool check_only = false);
+
+    /**
+     * @brief 클러스터 모드에서 닉네임을 등록합니다. `strand_` 위에서 실행됩니다.
+     * @details 로컬 중복 확인 후 닉네임의 디렉터리 노드에 선점을 요청하고, 승인되면 로컬에 등록합니다.
+     */
+    void claim_nickname_in_cluster(const std::string& nickname, const SessionPtr& session, std::function<void(bool)> handler);
+
+    /// 선점 결과를 반영하여 로컬 등록을 마치고 결과 콜백을 호출합니다. `strand_` 위에서 실행됩니다.
+    void finish_nickname_claim(const std::string& nickname, std::weak_ptr<SessionInterface> weak_session,
+                               std::function<void(bool)> handler, bool granted);
+
+    /// 닉네임을 관리하는 디렉터리 노드 ID
+    std::string nickname_directory_node(const std::string& nickname);
+
+    /// 디렉터리 노드에 닉네임 임대를 반납합니다.
+    void release_nickname_lease(const std::string& nickname);
+
+    /// 이 노드의 모든 닉네임 임대를 디렉터리 노드별로 묶어 갱신합니다. `strand_` 위에서 실행됩니다.
+    void renew_nickname_leases();
+
+    /// `route_private_message`의 결과
+    enum class PrivateRoute {
+        NotFound,  ///< 받는 사람이 없다고 확정됨
+        Sent,      ///< 받는 사람의 노드로 보냄
+        Pending    ///< 디렉터리 노드를 거쳐 보냈으며, 위치 응답이 오면 보낸 사람에게 결과를 알림
+    };
+
+    /**
+     * @brief 로컬에 없는 수신자에게 개인 메시지를 보냅니다.
+     * @details 캐시된 위치가 있으면 그 노드로 바로 보내고, 없으면 디렉터리 노드를 거쳐 보냅니다.
+     *          디렉터리 노드가 다른 노드이면 `pending_private_`에 넣어 두고 `NickLocation` 응답을 기다립니다.
+     */
+    PrivateRoute route_private_message(const SessionPtr& sender, const std::string& receiver_nick,
+                                       const std::string& sender_nick, const std::string& message);
+
+    /// 보낸 사람에게 개인 메시지 확인을 보내고 히스토리에 기록합니다.
+    void confirm_private_message(const SessionPtr& sender, const std::string& sender_nick,
+                                 const std::string& receiver_nick, const std::string& message);
+
+    /// 로컬 세션에 개인 메시지를 전달합니다. 수신자가 없으면 false.
+    bool deliver_private_locally(const std::string& receiver_nick, const std::string& formatted);
+
+    /**
+     * @brief 클러스터 버스에 메시지를 발행합니다. 단일 노드 모드에서는 아무 것도 하지 않습니다.
+     * @param kind 메시지 종류.
+     * @param target 방 이름 또는 수신자 닉네임.
+     * @param sender 발신자 닉네임.
+     * @param payload 수신 노드가 세션에 그대로 전달할 메시지.
+     * @param target_node 받을 노드. 비어 있으면 다른 모든 노드.
+     */
+    void publish_to_cluster(ClusterMessage::Kind kind, const std::string& target,
+                            const std::string& sender, const std::string& payload,
+                            const std::string& target_node = "");
+
+    /**
+     * @brief 포맷된 방 메시지를 클러스터로 보냅니다.
+     * @details 이 노드가 소유 노드이면 구독 노드마다 `RoomForward`를 보내고,
+     *          아니면 소유 노드에 `Room`을 한 번 보내 팬아웃을 맡깁니다.
+     *          링에 이 노드만 있는 동안(첫 하트비트 전)은 모든 노드에 `RoomForward`를 발행합니다.
+     */
+    void route_room_message(const std::string& room_name, const std::string& sender_nick, const std::string& formatted);
+
+    /// 로컬에 방이 생겼을 때 소유 노드에 구독을 요청합니다. (`rooms_mutex_` 보유 상태에서 호출 가능)
+    void on_local_room_created(const std::string& room_name);
+
+    /// 로컬 방이 사라졌을 때 소유 노드에 구독 해지를 요청합니다. (`rooms_mutex_` 보유 상태에서 호출 가능)
+    void on_local_room_removed(const std::string& room_name);
+
+    /// drain 대기열에서 한 묶음의 세션을 닫고 다음 묶음을 예약합니다. `strand_` 위에서 실행됩니다.
+    void drain_next_batch();
+
+    /// 하트비트를 보내고 만료된 노드를 정리하는 주기 작업을 예약합니다. `strand_` 위에서 실행됩니다.
+    void schedule_cluster_tick();
+
+    /// 링 변경 후 소유 노드가 바뀐 로컬 방을 새 소유 노드에 다시 구독하고, 닉네임 임대를 새 디렉터리 노드로 옮깁니다.
+    void rebalance_rooms();
+
+    /**
+     * @brief 다른 노드가 발행한 메시지를 로컬 세션에 전달합니다. `strand_` 위에서 실행됩니다.
+     * @param msg 수신한 클러스터 메시지.
+     */
+    void on_cluster_message(const ClusterMessage& msg);
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+/**
+ * @file EphemeralEvents.hpp
+ * @brief 입력 중 표시, 활동 중 알림 같은 일회성 이벤트를 모아 보내는 `EphemeralCoalescer`를 정의합니다.
+ * @details 일회성 이벤트는 일반 메시지와 달리 히스토리에 기록하지 않고 순번도 붙이지 않습니다.
+ *          같은 (방, 사용자)의 이벤트는 한 번의 전송 주기 안에서 마지막 것 하나로 합쳐지고,
+ *          방마다 주기당 한 줄로 묶어 보냅니다.
+ */
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @class EphemeralCoalescer
+ * @brief 방별로 대기 중인 일회성 이벤트를 (방, 닉네임) 단위로 합치는 버퍼.
+ * @details 스레드 안전하지 않습니다. `ChatServer`의 `strand_` 위에서만 사용합니다.
+ */
+class EphemeralCoalescer {
+public:
+    /// 방 하나에 보낼 묶음
+    struct Batch {
+        std::string room;   ///< 방 이름
+        std::string line;   ///< `~ <방> <종류>:<닉네임>,... ...` 형태의 한 줄
+    };
+
+    /**
+     * @brief 생성자.
+     * @param max_users_per_flush 한 번의 전송에서 방마다 담을 최대 사용자 수. 나머지는 다음 주기로 미룹니다.
+     */
+    explicit EphemeralCoalescer(std::size_t max_users_per_flush = 20);
+
+    /**
+     * @brief 이벤트를 추가합니다. 같은 (방, 닉네임)의 대기 중인 이벤트는 새 이벤트로 바뀝니다.
+     * @return 추가 전 대기 중인 이벤트가 하나도 없었으면 true. (전송 타이머를 시작해야 함)
+     */
+    bool add(const std::string& room, const std::string& nickname, const std::string& kind);
+
+    /// 방마다 최대 `max_users_per_flush`명의 이벤트를 꺼내 묶음으로 만듭니다.
+    std::vector<Batch> flush();
+
+    bool empty() const { return pending_.empty(); }
+
+private:
+    std::size_t max_users_per_flush_;
+    std::map<std::string, std::map<std::string, std::string>> pending_; ///< 방 -> 닉네임 -> 이벤트 종류
+};
@@ -0,0 +1,50 @@
+/**
+ * @file FileSpool.hpp
+ * @brief 파일 전송 중 수신자가 따라오지 못한 조각을 디스크에 잠시 쌓아 두는 `FileSpool`을 정의합니다.
+ * @details 조각은 `[길이(4바이트)][프레임]` 형태로 임시 파일 끝에 이어 쓰고, 앞에서부터 순서대로 꺼냅니다.
+ *          메모리에는 읽기/쓰기 위치만 두므로 파일이 커져도 서버 메모리 사용량은 늘지 않습니다.
+ */
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+
+/**
+ * @class FileSpool
+ * @brief 바이너리 프레임을 순서대로 저장하고 꺼내는 임시 파일 큐.
+ * @details 스레드 안전하지 않습니다. `ChatServer`는 전송마다 하나의 strand에서만 사용합니다.
+ *          소멸 시 임시 파일을 삭제합니다.
+ */
+class FileSpool {
+public:
+    /**
+     * @brief 생성자. `path`에 빈 임시 파일을 만듭니다.
+     * @param path 임시 파일 경로 (`FileTransferInfo::temp_path()`).
+     */
+    explicit FileSpool(std::string path);
+    ~FileSpool();
+
+    FileSpool(const FileSpool&) = delete;
+    FileSpool& operator=(const FileSpool&) = delete;
+
+    /// 파일을 열지 못했으면 false
+    bool is_open() const { return file_.is_open(); }
+
+    /// 프레임을 파일 끝에 추가합니다. 쓰기에 실패하면 false.
+    bool push(const std::string& frame);
+
+    /// 가장 오래된 프레임을 읽어 돌려줍니다. 비어 있거나 읽기에 실패하면 nullptr.
+    std::shared_ptr<const std::string> pop();
+
+    bool empty() const { return pending_ == 0; }
+    std::size_t pending() const { return pending_; }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    std::fstream file_;
+    std::streamoff read_pos_ = 0;   ///< 다음에 읽을 프레임의 시작 위치
+    std::size_t pending_ = 0;       ///< 아직 꺼내지 않은 프레임 수
+};
@@ -0,0 +1,87 @@
+/**
+ * @file HistoryMaintenance.hpp
+ * @brief 히스토리 보존 정책과 정리 작업의 I/O 속도 제한을 정의합니다.
+ * @details 정리 작업 자체는 `MessageHistory::run_maintenance`가 채널마다 수행합니다.
+ *          보존 기간이나 크기를 넘은 오래된 블록을 버리거나 보관 디렉터리로 옮기고, 작은 블록을 합칩니다.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * @struct RetentionPolicy
+ * @brief 채널 하나의 보존 정책. 0은 제한 없음.
+ */
+struct RetentionPolicy {
+    std::chrono::hours max_age{0};   ///< 이보다 오래된 메시지를 정리 (블록 단위라 조금 더 남을 수 있음)
+    std::uint64_t max_bytes = 0;     ///< 채널의 저장 크기가 이를 넘으면 오래된 것부터 정리
+
+    bool unlimited() const { return max_age.count() == 0 && max_bytes == 0; }
+};
+
+/**
+ * @struct RetentionConfig
+ * @brief 히스토리 정리 작업 설정.
+ * @details 채널 키는 `global`, `rooms/<방>`, `private`(모든 귓속말)입니다. `rooms`는 모든 방에 적용됩니다.
+ */
+struct RetentionConfig {
+    RetentionPolicy defaults;                          ///< 따로 지정하지 않은 채널의 정책
+    std::map<std::string, RetentionPolicy> channels;   ///< 채널(또는 `rooms`)별 정책
+    std::string archive_dir;                           ///< 비어 있지 않으면 정리한 메시지를 버리지 않고 이곳에 압축해 보관
+    std::uint64_t io_bytes_per_second = 4 * 1024 * 1024; ///< 정리 작업의 읽기+쓰기 속도 상한 (0이면 제한 없음)
+    std::chrono::minutes interval{60};                 ///< 정리 주기 (0이면 백그라운드 정리를 하지 않음)
+
+    /// 채널에 적용할 정책. 정확히 같은 키, `rooms/`로 시작하면 `rooms`, 그 외에는 `defaults` 순으로 찾습니다.
+    const RetentionPolicy& policy_for(const std::string& channel) const;
+
+    /**
+     * @brief `rooms/lobby=30d,private=90d:200mb,global=500mb` 형식의 채널별 정책을 읽어 `channels`에 더합니다.
+     * @return 형식이 잘못된 항목이 있으면 false (올바른 항목은 반영).
+     */
+    bool parse_overrides(const std::string& spec);
+
+    /// `30d`, `12h`, `200mb`, `64kb`, `30d:200mb` 형식의 정책 하나를 읽습니다.
+    static bool parse_policy(const std::string& text, RetentionPolicy& policy);
+};
+
+/**
+ * @class IoRateLimiter
+ * @brief 토큰 버킷 방식의 바이트 속도 제한기.
+ * @details 정리 작업이 디스크를 오래 점유해 실시간 기록을 느리게 하지 않도록, 읽고 쓰기 전에 `acquire`로 허락을 받습니다.
+ *          한 번에 최대 1초 분량까지 몰아 쓸 수 있습니다. 스레드 안전하지 않습니다. (정리 스레드 전용)
+ */
+class IoRateLimiter {
+public:
+    /// @param bytes_per_second 초당 허용 바이트 (0이면 제한 없음)
+    explicit IoRateLimiter(std::uint64_t bytes_per_second);
+
+    /**
+     * @brief `bytes`만큼 쓸 수 있을 때까지 기다립니다.
+     * @param stop 기다리는 도중 true가 되면 바로 돌아옵니다.
+     * @return 허락을 받았으면 true, `stop`으로 중단했으면 false.
+     */
+    bool acquire(std::uint64_t bytes, const std::atomic<bool>& stop);
+
+private:
+    std::uint64_t rate_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+/**
+ * @struct MaintenanceReport
+ * @brief 정리 한 번의 결과. (로그와 테스트용)
+ */
+struct MaintenanceReport {
+    std::size_t channels_compacted = 0;   ///< 파일을 다시 쓴 채널 수
+    std::size_t blocks_dropped = 0;       ///< 보존 정책으로 정리한 블록 수
+    std::size_t blocks_merged = 0;        ///< 합쳐서 없어진 작은 블록 수
+    std::size_t private_dropped = 0;      ///< 정리한 귓속말 수
+    std::size_t lines_archived = 0;       ///< 보관 디렉터리로 옮긴 줄 수
+    std::uint64_t bytes_reclaimed = 0;    ///< 줄어든 저장 크기
+};
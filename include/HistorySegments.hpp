@@ -0,0 +1,233 @@
+/**
+ * @file HistorySegments.hpp
+ * @brief 히스토리 파일 하나를 활성 세그먼트와 압축된 블록으로 나누어 저장하는 `SegmentedLog`를 정의합니다.
+ * @details 새 메시지는 지금처럼 `<이름>.txt`(활성 세그먼트)에 한 줄씩 추가합니다.
+ *          활성 세그먼트가 `segment_bytes`를 넘으면 `<이름>.seal`(봉인 대기 세그먼트)로 이름만 바꾸고 새 활성 세그먼트를 시작합니다.
+ *          봉인 대기 세그먼트는 소유자(`MessageHistory`)가 잠금 밖에서 `block_bytes` 단위 블록으로 압축해 `<이름>.blk`에 붙이고,
+ *          블록마다 줄 번호와 시각 범위를 `<이름>.idx`에 기록한 뒤 지웁니다.
+ *          오래된 구간을 읽을 때는 색인으로 필요한 블록만 찾아 압축을 풉니다.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class HistoryCodec
+ * @brief 히스토리 블록 압축기. zstd와 채팅 문장으로 학습한 사전을 사용합니다.
+ * @details `CHERRY_HAVE_ZSTD` 없이 빌드하면 블록을 압축하지 않고 그대로 저장합니다. (블록 색인과 임의 접근은 그대로 동작)
+ *          사전은 처음 봉인하는 세그먼트의 줄로 한 번 학습해 `dict_path`에 저장하고, 이후 모든 블록이 같은 사전을 씁니다.
+ *          스레드 안전하지 않습니다. 인스턴스마다 한 잠금 안에서만 사용합니다. (읽기용은 기록 잠금, 봉인용은 봉인 잠금)
+ */
+class HistoryCodec {
+public:
+    /// 블록 저장 방식 (색인에 기록)
+    enum class Method : std::uint8_t {
+        Raw = 0,         ///< 압축하지 않음
+        Zstd = 1,        ///< zstd
+        ZstdDict = 2     ///< zstd + 학습한 사전
+    };
+
+    /**
+     * @brief 생성자. `dict_path`에 사전이 있으면 불러옵니다.
+     * @param dict_path 학습한 사전을 저장할 경로.
+     * @param level zstd 압축 수준.
+     */
+    explicit HistoryCodec(std::string dict_path, int level = 9);
+    ~HistoryCodec();
+
+    HistoryCodec(const HistoryCodec&) = delete;
+    HistoryCodec& operator=(const HistoryCodec&) = delete;
+
+    /// 사전이 없으면 `samples`로 학습해 저장합니다. 표본이 부족하거나 zstd 없이 빌드했으면 아무것도 하지 않습니다.
+    void train_if_needed(const std::vector<std::string>& samples);
+
+    /// 블록을 압축합니다. 압축하지 못하면 `Raw`로 그대로 담습니다.
+    Method compress(const std::string& raw, std::string& out);
+
+    /// 블록 압축을 풉니다. 실패하면 false.
+    bool decompress(Method method, const std::string& stored, std::size_t raw_size, std::string& out);
+
+    bool has_dictionary() const { return !dictionary_.empty(); }
+
+    /// 학습한 사전 (없으면 빈 문자열)
+    const std::string& dictionary() const { return dictionary_; }
+
+    /// 다른 압축기가 학습한 사전을 씁니다. 이미 사전이 있으면 아무것도 하지 않습니다.
+    void use_dictionary(const std::string& dictionary);
+
+private:
+    struct Contexts;
+    void load_dictionary();
+
+    std::string dict_path_;
+    int level_;
+    std::string dictionary_;
+    std::unique_ptr<Contexts> contexts_; ///< zstd 압축/해제 컨텍스트와 준비된 사전
+};
+
+/**
+ * @class SegmentedLog
+ * @brief 활성 세그먼트와 봉인된 압축 블록으로 이루어진 히스토리 파일 하나.
+ * @details 줄 번호는 이 파일에 기록된 순서대로 0부터 매깁니다. (봉인된 블록, 봉인 대기 세그먼트, 활성 세그먼트 순)
+ *          봉인된 블록의 색인은 메모리에 두고, 두 세그먼트의 줄 수와 크기만 따로 셉니다. 스레드 안전하지 않습니다.
+ *          `append`는 압축하지 않습니다. 봉인은 `prepare_seal` → `build_seal`(잠금 밖) → `install_seal` 순서로 소유자가 합니다.
+ */
+class SegmentedLog {
+public:
+    /// `<이름>.idx`에 기록하는 블록 색인. 파일에는 필드마다 정해진 너비의 리틀 엔디언으로 씁니다. (`index_record_size`)
+    struct BlockIndex {
+        std::uint64_t offset = 0;        ///< `<이름>.blk` 안의 시작 위치
+        std::uint32_t stored_size = 0;   ///< 저장된(압축된) 크기
+        std::uint32_t raw_size = 0;      ///< 압축을 푼 크기
+        std::uint64_t first_line = 0;    ///< 첫 줄 번호
+        std::uint32_t line_count = 0;    ///< 줄 수
+        std::uint8_t method = 0;         ///< `HistoryCodec::Method`
+        char first_time[20] = {};        ///< 첫 줄의 시각 (`YYYY-MM-DD HH:MM:SS`)
+        char last_time[20] = {};         ///< 마지막 줄의 시각
+    };
+
+    /**
+     * @brief 블록 정리 결과. 잠금 밖에서 `rewrite`로 만들고 잠금 안에서 `install`로 적용합니다.
+     */
+    struct Rewrite {
+        std::string base_path;
+        std::size_t snapshot_blocks = 0;  ///< `rewrite`가 본 블록 수 (이후 봉인된 블록은 `install`이 옮겨 붙임)
+        std::vector<BlockIndex> index;    ///< 새 색인
+        std::size_t dropped = 0;          ///< 버린 블록 수
+        std::size_t merged = 0;           ///< 합쳐서 없어진 블록 수
+        std::uint64_t bytes_before = 0;   ///< 정리 전 블록 파일 크기
+        std::uint64_t bytes_after = 0;    ///< 정리 후 블록 파일 크기 (`install` 전 기준)
+    };
+
+    /**
+     * @brief 봉인 대기 세그먼트 하나를 압축한 결과. 잠금 안에서 `prepare_seal`로 만들고 잠금 밖에서 `build_seal`로 채웁니다.
+     */
+    struct Seal {
+        std::string base_path;
+        std::size_t block_bytes = 0;
+        std::uint64_t first_line = 0;     ///< 봉인 대기 세그먼트의 첫 줄 번호
+        std::uint64_t line_count = 0;     ///< 봉인 대기 세그먼트의 줄 수
+        std::vector<BlockIndex> index;    ///< 새 블록 색인 (`offset`은 `data` 안의 위치, `install_seal`이 고침)
+        std::string data;                 ///< 새 블록 데이터
+    };
+
+    /// `<이름>.idx` 레코드 하나의 크기
+    static constexpr std::size_t index_record_size = 72;
+
+    /// 읽거나 쓰기 전에 바이트 수를 넘겨 허락을 받는 함수. false면 정리를 중단합니다.
+    using Throttle = std::function<bool(std::uint64_t bytes)>;
+
+    /**
+     * @brief 앞쪽 `drop`개 블록을 빼고 원본 크기가 `block_bytes`의 절반보다 작은 연속 블록을 합쳐 `<이름>.blk.compact`를 씁니다.
+     * @param base_path 확장자를 뺀 파일 경로.
+     * @param blocks 잠금 안에서 복사한 색인.
+     * @param drop 버릴 앞쪽 블록 수.
+     * @param codec 블록을 풀고 다시 압축할 압축기. 실시간 기록과 따로 쓰는 인스턴스여야 합니다.
+     * @param block_bytes 합친 블록 하나의 최대 원본 크기.
+     * @param throttle 읽기/쓰기 속도 제한.
+     * @param on_dropped 비어 있지 않으면 버리는 블록의 줄을 하나씩 넘깁니다. (보관용)
+     * @param out 결과.
+     * @return 성공하면 true. 실패하거나 중단하면 임시 파일을 지우고 false.
+     * @details 블록 파일은 끝에 붙이기만 하므로 잠금 없이 읽어도 됩니다.
+     */
+    static bool rewrite(const std::string& base_path, const std::vector<BlockIndex>& blocks, std::size_t drop,
+                        HistoryCodec& codec, std::size_t block_bytes, const Throttle& throttle,
+                        const std::function<void(const std::string&)>& on_dropped, Rewrite& out);
+
+    /**
+     * @brief 생성자. 기존 색인과 활성 세그먼트를 읽어 줄 수를 셉니다.
+     * @param base_path 확장자를 뺀 파일 경로 (예: `history/rooms/lobby`).
+     * @param codec 블록 압축기 (`MessageHistory`가 소유).
+     * @param segment_bytes 활성 세그먼트를 봉인하는 크기.
+     * @param block_bytes 압축 블록 하나의 최대 원본 크기.
+     */
+    SegmentedLog(std::string base_path, HistoryCodec& codec, std::size_t segment_bytes, std::size_t block_bytes);
+
+    /// 활성 세그먼트에 한 줄을 추가하고, 크기를 넘으면 봉인 대기 세그먼트로 돌립니다. (`rotate_if_full`) 파일을 열지 못하면 false.
+    bool append(const std::string& line);
+
+    /// 봉인 대기 세그먼트가 없고 활성 세그먼트가 비어 있지 않으면 활성 세그먼트를 봉인 대기 세그먼트로 돌립니다. 돌렸으면 true.
+    bool rotate();
+
+    /// 활성 세그먼트가 `segment_bytes`를 넘었으면 `rotate`합니다. 돌렸으면 true.
+    bool rotate_if_full();
+
+    /// 봉인을 기다리는 세그먼트가 있는지
+    bool has_pending() const { return pending_lines_ > 0; }
+
+    /// 봉인 대기 세그먼트를 압축할 정보를 `seal`에 담습니다. 봉인할 세그먼트가 없으면 false.
+    bool prepare_seal(Seal& seal) const;
+
+    /**
+     * @brief 봉인 대기 세그먼트를 읽어 블록으로 압축합니다. 잠금 밖에서 호출합니다.
+     * @param codec 압축기. 사전이 없으면 세그먼트의 줄로 학습합니다. 실시간 읽기와 따로 쓰는 인스턴스여야 합니다.
+     * @details 봉인 대기 세그먼트는 `install_seal` 전까지 바뀌지 않으므로 잠금 없이 읽어도 됩니다.
+     */
+    static bool build_seal(Seal& seal, HistoryCodec& codec);
+
+    /// `build_seal` 결과를 블록 파일과 색인 끝에 붙이고 봉인 대기 세그먼트를 지웁니다. 그사이 세그먼트가 바뀌었으면 false.
+    bool install_seal(Seal& seal);
+
+    /// 마지막 `limit`줄 (0이면 전체). 활성 세그먼트로 부족할 때만 뒤쪽 블록부터 압축을 풉니다.
+    std::vector<std::string> last_lines(std::size_t limit);
+
+    /// 줄 번호 `first`부터 최대 `count`줄. 해당 줄이 든 블록만 압축을 풉니다.
+    std::vector<std::string> lines(std::uint64_t first, std::size_t count);
+
+    /// 시각이 `[from, to]` 안인 줄. 시각 범위가 겹치는 블록만 압축을 풉니다. 형식은 `YYYY-MM-DD HH:MM:SS` (앞부분만 써도 됨).
+    std::vector<std::string> time_range(const std::string& from, const std::string& to);
+
+    /// 봉인 대기 세그먼트와 활성 세그먼트를 이 자리에서 블록으로 압축해 봉인합니다. (보관 파일처럼 실시간 기록이 없는 파일용)
+    void seal();
+
+    /**
+     * @brief `rewrite` 결과를 적용합니다. 그사이 봉인된 블록을 새 파일 끝에 옮기고 `.blk`, `.idx`를 바꿉니다.
+     * @details 줄 번호는 바뀌지 않습니다. 정리된 앞부분의 줄은 더 이상 읽히지 않을 뿐입니다.
+     */
+    bool install(Rewrite& rewrite);
+
+    /// 전체 줄 수 (봉인된 블록 + 봉인 대기 세그먼트 + 활성 세그먼트). 정리된 앞부분도 포함하므로 마지막 줄 번호 + 1입니다.
+    std::uint64_t line_count() const { return sealed_lines_ + pending_lines_ + active_lines_; }
+
+    /// 아직 남아 있는 첫 줄 번호 (앞부분이 정리되면 0보다 큼)
+    std::uint64_t first_line() const { return index_.empty() ? 0 : index_.front().first_line; }
+
+    /// 아직 봉인되지 않은 크기 (봉인 대기 세그먼트 + 활성 세그먼트)
+    std::uint64_t active_bytes() const { return pending_bytes_ + active_bytes_; }
+
+    /// 봉인되지 않은 첫 줄의 시각 (비어 있으면 빈 문자열)
+    std::string first_active_time() const;
+
+    const std::vector<BlockIndex>& blocks() const { return index_; }
+
+    /// 지금까지 압축을 푼 블록 수
+    std::size_t blocks_decoded() const { return blocks_decoded_; }
+
+private:
+    /// 봉인 대기 세그먼트와 활성 세그먼트의 줄 (기록 순)
+    std::vector<std::string> read_active() const;
+    bool read_block(const BlockIndex& block, std::vector<std::string>& out);
+    /// 봉인 대기 세그먼트를 `codec_`으로 이 자리에서 봉인합니다.
+    void seal_pending();
+
+    std::string base_path_;
+    std::string active_path_;
+    std::string pending_path_;
+    std::string blocks_path_;
+    std::string index_path_;
+    HistoryCodec& codec_;
+    std::size_t segment_bytes_;
+    std::size_t block_bytes_;
+    std::vector<BlockIndex> index_;
+    std::uint64_t sealed_lines_ = 0;
+    std::uint64_t pending_lines_ = 0;
+    std::uint64_t pending_bytes_ = 0;
+    std::uint64_t active_lines_ = 0;
+    std::uint64_t active_bytes_ = 0;
+    std::size_t blocks_decoded_ = 0;
+};
@@ -6,6 +6,7 @@
 #include <boost/asio/strand.hpp> ///< strand 사용 권장
 #include <cstdlib>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <thread>
@@ -54,6 +55,17 @@ public:
         net::io_context& ioc,
         tcp::endpoint endpoint);
 
+    /**
+     * @brief 이미 리스닝 중인 소켓을 넘겨받는 HttpListener 생성자. (무중단 재시작 시 이전 프로세스에서 인계)
+     * @param ioc Boost.Asio io_context 참조.
+     * @param protocol 넘겨받은 소켓의 프로토콜 (v4/v6).
+     * @param native_socket 리스닝 중인 네이티브 소켓 핸들. 소유권이 acceptor로 넘어간다.
+     */
+    HttpListener(
+        net::io_context& ioc,
+        const tcp& protocol,
+        tcp::acceptor::native_handle_type native_socket);
+
     /**
      * @brief 리스너를 시작하여 비동기적으로 연결 수락을 시작한다.
      *
@@ -61,7 +73,24 @@ public:
      */
     void run();
 
+    /**
+     * @brief 새 연결 수락을 멈춘다. 이미 수락된 세션은 영향을 받지 않는다.
+     */
+    void stop();
+
+    /// @brief 리스닝 소켓의 네이티브 핸들. (다른 프로세스로 인계할 때 사용)
+    tcp::acceptor::native_handle_type native_handle() { return acceptor_.native_handle(); }
+
+    /// @brief 리스닝 중인 로컬 엔드포인트. 닫힌 경우 기본값.
+    tcp::endpoint local_endpoint() const { beast::error_code ec; return acceptor_.local_endpoint(ec); }
+
 private:
+    /**
+     * @brief `GOOGLE_MAPS_API_KEY` 환경 변수로 `PlacesApiHandler`를 생성한다.
+     * @throws std::runtime_error 환경 변수가 없거나 비어 있는 경우.
+     */
+    void init_places_handler();
+
     /**
      * @brief 비동기적으로 클라이언트 연결을 대기한다.
      *
@@ -115,6 +144,24 @@ public:
      */
     void stop();
 
+    /**
+     * @brief 직접 바인딩하는 대신 이미 리스닝 중인 소켓을 사용하도록 지정한다. `run()` 전에 호출해야 한다.
+     * @param protocol 넘겨받은 소켓의 프로토콜 (v4/v6).
+     * @param native_socket 리스닝 중인 네이티브 소켓 핸들. 소유권이 서버로 넘어간다.
+     */
+    void adopt_listener(const tcp& protocol, tcp::acceptor::native_handle_type native_socket);
+
+    /**
+     * @brief 새 연결 수락만 멈춘다. 처리 중인 요청은 `stop()` 호출 전까지 계속 처리된다.
+     */
+    void stop_accepting();
+
+    /**
+     * @brief 리스닝 소켓의 네이티브 핸들. 리스너가 없으면 -1.
+     * @param ipv6 [out] 리스닝 소켓이 IPv6인지 여부.
+     */
+    int listener_native_handle(bool& ipv6) const;
+
 private:
     std::string address_;       ///< @brief 서버가 바인딩될 IP 주소.
     unsigned short port_;       ///< @brief 서버가 리슨할 포트 번호.
@@ -123,4 +170,6 @@ private:
     net::io_context ioc_; ///< @brief Beast HTTP 서버용 자체 io_context. 스레드 수를 생성 시 지정.
     std::vector<std::thread> io_threads_; ///< @brief io_context를 실행하는 IO 스레드들.
     std::shared_ptr<HttpListener> listener_{ nullptr }; ///< @brief HTTP 연결을 수락하는 리스너 객체.
+    std::optional<tcp> adopted_protocol_; ///< @brief 넘겨받은 리스닝 소켓의 프로토콜. (`adopt_listener` 호출 시)
+    tcp::acceptor::native_handle_type adopted_socket_ = -1; ///< @brief 넘겨받은 리스닝 소켓 핸들.
 };
\ No newline at end of file
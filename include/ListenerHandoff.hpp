@@ -0,0 +1,130 @@
+/**
+ * @file ListenerHandoff.hpp
+ * @brief 무중단 재시작을 위해 리스닝 소켓을 새 프로세스로 넘기는 `HandoffServer`/`HandoffClient`를 정의합니다.
+ * @details 실행 중인(이전) 프로세스는 `HandoffServer`로 Unix 소켓에서 대기합니다.
+ *          새 프로세스는 시작 시 `HandoffClient`로 접속하여 리스닝 소켓들을 `SCM_RIGHTS`로 넘겨받고,
+ *          `confirm()`으로 인계를 알린 뒤 이전 프로세스가 디스크 저장소(계정, 히스토리)를 닫았다는 답을 받고 나서
+ *          저장소를 열고 accept를 시작합니다. 이전 프로세스는 `READY`를 받은 뒤에야 accept를 멈추고 기존 연결을
+ *          나누어 종료(drain)하므로, 리스닝 소켓이 닫혀 있는 순간이 없고(그사이 연결은 backlog에서 기다림)
+ *          클라이언트 재접속도 한꺼번에 몰리지 않습니다.
+ *
+ *          프로토콜 (모두 한 번의 `sendmsg`/`recvmsg`):
+ *          1. 새 프로세스 -> 이전 프로세스: `HANDOFF 1\n`
+ *          2. 이전 프로세스 -> 새 프로세스: 줄마다 `<이름> <4|6>` 형태의 목록 + 같은 순서의 파일 디스크립터
+ *          3. 새 프로세스 -> 이전 프로세스: `READY\n` (이 메시지 없이 연결이 끊기거나 시간이 지나면 이전 프로세스는 계속 동작)
+ *          4. 이전 프로세스 -> 새 프로세스: `RELEASED\n` (인계 처리 함수가 저장소를 닫고 돌아온 뒤)
+ *
+ *          POSIX 전용이며, Windows에서는 항상 실패합니다.
+ */
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#ifndef _WIN32
+#include <boost/asio/local/stream_protocol.hpp>
+#endif
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @struct HandoffSocket
+ * @brief 프로세스 간에 넘기는 리스닝 소켓 하나.
+ */
+struct HandoffSocket {
+    std::string name;   ///< 소켓 이름 (예: "ws", "http")
+    int fd = -1;        ///< 네이티브 소켓 핸들. 보내는 쪽에서는 빌려준 것이며, 받는 쪽에서는 소유권을 가짐
+    bool ipv6 = false;  ///< IPv6 소켓 여부 (acceptor에 다시 붙일 때 프로토콜 지정용)
+};
+
+#ifndef _WIN32
+
+/**
+ * @class HandoffServer
+ * @brief 이전 프로세스에서 새 프로세스의 인계 요청을 기다리는 서버.
+ * @details 한 번에 한 연결만 처리하며, 인계가 끝나면(`READY` 수신) 더 이상 요청을 받지 않습니다.
+ *          인계가 끝난 뒤에는 소켓 경로를 지우지 않습니다. 새 프로세스가 같은 경로에 자신의 서버를 열기 때문입니다.
+ */
+class HandoffServer : public std::enable_shared_from_this<HandoffServer> {
+public:
+    /// 인계할 소켓 목록을 만드는 함수. 요청이 올 때마다 호출됩니다.
+    using SocketProvider = std::function<std::vector<HandoffSocket>()>;
+    /// 새 프로세스가 준비 완료를 알렸을 때 호출되는 함수. 돌아오면 새 프로세스에 `RELEASED`를 보내므로, 저장소를 닫는 일은 여기서 끝내야 합니다.
+    using HandoffHandler = std::function<void()>;
+
+    /**
+     * @brief 생성자.
+     * @param ioc 비동기 작업에 사용할 io_context.
+     * @param path Unix 소켓 경로. 이미 파일이 있으면 지우고 새로 엽니다.
+     * @param provider 인계할 소켓 목록 제공 함수.
+     * @param on_handoff 인계 완료 시 호출될 함수.
+     * @param ready_timeout 소켓을 보낸 뒤 `READY`를 기다리는 시간. 넘기면 그 연결을 끊고 다음 요청을 받습니다.
+     */
+    HandoffServer(net::io_context& ioc, const std::string& path, SocketProvider provider, HandoffHandler on_handoff,
+                  std::chrono::milliseconds ready_timeout = std::chrono::seconds(30));
+
+    /// 인계 요청 대기를 시작합니다.
+    void run();
+
+    /**
+     * @brief 대기를 멈춥니다.
+     * @param remove_path 소켓 경로도 지울지 여부. 인계 없이 종료할 때만 true로 호출해야 합니다.
+     */
+    void stop(bool remove_path);
+
+private:
+    void do_accept();
+    void on_request(std::shared_ptr<net::local::stream_protocol::socket> peer, const std::string& request);
+    void await_ready(std::shared_ptr<net::local::stream_protocol::socket> peer);
+
+    net::local::stream_protocol::acceptor acceptor_;
+    std::string path_;
+    SocketProvider provider_;
+    HandoffHandler on_handoff_;
+    std::chrono::milliseconds ready_timeout_;
+    bool handed_off_ = false;
+};
+
+#endif // _WIN32
+
+/**
+ * @class HandoffClient
+ * @brief 새 프로세스에서 이전 프로세스의 리스닝 소켓을 넘겨받는 클라이언트.
+ * @details 블로킹 호출로 동작하며 서버 시작 전에 한 번만 사용합니다.
+ */
+class HandoffClient {
+public:
+    HandoffClient() = default;
+    ~HandoffClient();
+    HandoffClient(const HandoffClient&) = delete;
+    HandoffClient& operator=(const HandoffClient&) = delete;
+
+    /**
+     * @brief 이전 프로세스에 리스닝 소켓을 요청합니다.
+     * @param path 이전 프로세스의 Unix 소켓 경로.
+     * @param timeout 응답 대기 시간.
+     * @return 소켓을 받았으면 true. 이전 프로세스가 없거나 응답이 잘못되었으면 false.
+     */
+    bool request(const std::string& path, std::chrono::milliseconds timeout = std::chrono::milliseconds(3000));
+
+    /**
+     * @brief 받은 소켓 중 이름이 일치하는 것을 꺼냅니다. 꺼낸 소켓의 소유권은 호출자에게 넘어갑니다.
+     * @return 없으면 `fd`가 -1인 값.
+     */
+    HandoffSocket take(const std::string& name);
+
+    /**
+     * @brief 인계를 확정하고, 이전 프로세스가 저장소를 닫았다는 답(`RELEASED`)을 기다립니다. 이후 이전 프로세스는 drain을 시작합니다.
+     * @param timeout 답을 기다리는 시간. 이전 프로세스가 봉인/합치기를 끝낼 때까지 걸릴 수 있습니다.
+     * @return 답을 받았으면 true. false이면 이전 프로세스가 아직 저장소를 쓰고 있을 수 있습니다.
+     */
+    bool confirm(std::chrono::milliseconds timeout = std::chrono::seconds(30));
+
+private:
+    int conn_ = -1;
+    std::vector<HandoffSocket> sockets_;
+};
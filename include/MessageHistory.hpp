@@ -1,23 +1,151 @@
 // include/MessageHistory.hpp
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <string>
 #include <vector>
 #include <memory> // Needed for unique_ptr if used elsewhere, or just general practice
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "HistoryMaintenance.hpp"
+
+class HistoryCodec;
+class SegmentedLog;
+class SearchIndex;
+class PrivateMessageStore;
+
+/**
+ * @struct HistoryRecord
+ * @brief 히스토리에 추가된 기록 한 줄과 그 위치. 복제 스트림으로 팔로워에 보내면 팔로워가 같은 파일에 그대로 추가한다.
+ */
+struct HistoryRecord {
+    enum class Kind : std::uint8_t {
+        Global = 0,
+        Room = 1,
+        Private = 2
+    };
+    Kind kind = Kind::Global;
+    std::string room;       ///< `Room`: 채팅방 이름
+    std::string sender;     ///< `Private`: 보낸 사람
+    std::string receiver;   ///< `Private`: 받는 사람
+    std::string line;       ///< 시각을 포함한 기록 줄
+};
 
 /**
  * @class MessageHistory
  * @brief 채팅 메시지 기록을 파일 시스템에 저장하고 불러오는 클래스.
  *
  * 전역, 개인, 채팅방 메시지를 각각 다른 디렉토리와 파일에 저장하여 관리한다.
+ * 개인 메시지는 대화마다 파일을 만들지 않고 `PrivateMessageStore`(`private/messages.log`) 하나에 모은다.
  * 기록 기능은 활성화/비활성화할 수 있다.
+ * 전역과 채팅방 파일은 `SegmentedLog`로 관리되어, 최근 메시지는 압축하지 않은 활성 세그먼트(`.txt`)에,
+ * 오래된 메시지는 압축된 블록(`.blk`)과 블록 색인(`.idx`)에 저장된다.
+ * 활성 세그먼트가 가득 차면 기록 경로에서는 파일 이름만 바꾸고, 압축은 봉인 스레드가 잠금 밖에서 한 뒤 색인만 잠금 안에서 바꾼다.
+ * 채팅방과 귓속말 기록은 `SearchIndex`로 전문 검색할 수 있다. 시작할 때 기존 기록은 백그라운드에서 색인한다.
+ * 줄 번호와 색인은 프로세스 메모리에 있으므로 디렉터리의 `.lock`에 배타적 `flock`을 잡아 한 프로세스만 쓰게 한다.
+ * 다른 프로세스가 이미 잠갔으면 기록을 끈 채로 시작한다.
  */
 class MessageHistory {
+public:
+    /// @brief 검색 결과 한 페이지.
+    struct SearchResult {
+        size_t total = 0;                  ///< 조건에 맞는 전체 메시지 수
+        std::vector<std::string> lines;    ///< `[#방]` 또는 `[PM]`을 붙인 기록 줄 (점수, 최신 순)
+    };
+
 private:
     /// @brief 채팅 기록이 저장될 기본 디렉토리 경로.
     std::string history_dir_;
     /// @brief 메시지 기록 기능 활성화 여부.
     bool enabled_ = false;
+    /// @brief 디렉터리 잠금을 얻지 못했거나 `close()`로 닫혀, 더 이상 파일을 바꾸지 않는다. (바꿀 때는 `history_mutex`를 잡는다)
+    std::atomic<bool> closed_{false};
+    /// @brief `<history_dir>/.lock` 파일. 닫으면 `flock`도 풀린다.
+    int lock_fd_ = -1;
+    /// @brief 활성 세그먼트를 봉인하는 크기.
+    size_t segment_bytes_ = 1024 * 1024;
+    /// @brief 압축 블록 하나의 최대 원본 크기.
+    size_t block_bytes_ = 64 * 1024;
+    /// @brief 블록 압축기 (모든 파일이 같은 사전을 공유). 기록 잠금 안에서 읽기에 쓴다.
+    std::unique_ptr<HistoryCodec> codec_;
+    /// @brief 봉인용 압축기. 사전 학습도 여기서만 한다. `seal_mutex_`로 보호.
+    std::unique_ptr<HistoryCodec> seal_codec_;
+    /// @brief 봉인을 한 번에 하나만 하도록 막는다. (봉인 스레드와 정리 스레드)
+    std::mutex seal_mutex_;
+    /// @brief 봉인할 파일 대기열 (`sealer_mutex_`로 보호).
+    std::deque<std::string> seal_queue_;
+    std::set<std::string> seal_queued_;
+    /// @brief 대기열에서 꺼내 봉인 중인 파일 수 (`sealer_mutex_`로 보호).
+    size_t sealing_ = 0;
+    bool stop_sealer_ = false;
+    std::mutex sealer_mutex_;
+    std::condition_variable sealer_cv_;
+    /// @brief 봉인 대기 세그먼트를 압축하는 스레드.
+    std::thread sealer_thread_;
+    /// @brief 확장자를 뺀 파일 경로 -> 열린 히스토리 파일.
+    std::map<std::string, std::unique_ptr<SegmentedLog>> logs_;
+    /// @brief 모든 개인 메시지를 담는 저장소.
+    std::unique_ptr<PrivateMessageStore> private_store_;
+    /// @brief 기록을 추가할 때마다 호출할 함수 (`history_mutex`로 보호).
+    std::function<void(const HistoryRecord&)> append_listener_;
+    /// @brief 채팅방/귓속말 기록의 전문 검색 색인.
+    std::unique_ptr<SearchIndex> search_;
+    /// @brief 시작 전에 있던 기록을 색인하는 백그라운드 작업.
+    std::shared_future<void> backfill_;
+    /// @brief 백필 중단 요청 (소멸 시).
+    std::atomic<bool> stop_backfill_{false};
+
+    /// @brief 백필할 채널 하나 (시작 시점의 줄 수까지).
+    struct BackfillStream {
+        std::string channel;
+        std::vector<std::string> participants;
+        std::uint64_t first_line = 0;
+        std::uint64_t line_count = 0;
+    };
+
+    /// @brief 보존 정책과 정리 주기 (`maintenance_mutex_`로 보호).
+    RetentionConfig retention_;
+    std::mutex maintenance_mutex_;
+    std::condition_variable maintenance_cv_;
+    /// @brief `run_maintenance`가 한 번에 하나만 실행되도록 막는다. (보관용 압축기와 임시 파일 공유)
+    std::mutex maintenance_run_mutex_;
+    /// @brief 주기적으로 `run_maintenance`를 실행하는 스레드.
+    std::thread maintenance_thread_;
+    /// @brief 정리 중단 요청 (소멸 시).
+    std::atomic<bool> stop_maintenance_{false};
+
+    /// @brief `base_path`의 히스토리 파일을 열어 돌려준다. 호출 측이 잠금을 잡고 있어야 한다.
+    SegmentedLog& log_for(const std::string& base_path);
+    /// @brief 검색 채널(`rooms/<방>` 또는 `private/...`)의 줄을 읽는다. 호출 측이 잠금을 잡고 있어야 한다.
+    std::vector<std::string> read_channel(const std::string& channel, const std::vector<std::string>& participants,
+                                          std::uint64_t first_line, size_t count);
+    /// @brief 기록 한 줄을 파일과 검색 색인에 추가하고 `append_listener_`에 알린다.
+    bool append_record(const HistoryRecord& record);
+    /// @brief `base_path`를 봉인 대기열에 넣는다. 기록 잠금 안에서 호출해도 된다.
+    void schedule_seal(const std::string& base_path);
+    /// @brief 대기열의 파일을 하나씩 봉인한다.
+    void sealer_loop();
+    /// @brief `base_path`의 봉인 대기 세그먼트를 압축해 설치한다. 기록 잠금은 세그먼트 정보를 읽고 색인을 바꿀 때만 잡는다.
+    /// @return 설치한 뒤 활성 세그먼트가 다시 가득 차 봉인할 세그먼트가 또 생겼으면 true.
+    bool seal_log(const std::string& base_path);
+    /// @brief 시작 시점까지 기록된 채팅방/귓속말 줄을 조금씩 읽어 색인한다.
+    void backfill_search(std::vector<BackfillStream> streams);
+    /// @brief `interval`마다 `run_maintenance`를 실행한다.
+    void maintenance_loop();
+    /// @brief 전역/채팅방 파일 하나의 오래된 블록을 정리하고 작은 블록을 합친다.
+    void maintain_log(const std::string& channel, const RetentionConfig& config, HistoryCodec* archive_codec,
+                      IoRateLimiter& limiter, MaintenanceReport& report);
+    /// @brief 개인 메시지 저장소의 오래된 레코드를 정리한다.
+    void maintain_private(const RetentionConfig& config, HistoryCodec* archive_codec, IoRateLimiter& limiter,
+                          MaintenanceReport& report);
 public:
     /**
      * @brief MessageHistory 생성자.
@@ -30,12 +158,20 @@ public:
      */
     ~MessageHistory();
 
+    /**
+     * @brief 기록을 끄고 봉인/정리 스레드를 멈춘 뒤 디렉터리 잠금을 푼다. 이후 기록과 읽기는 모두 아무것도 하지 않는다.
+     * @details 무중단 재시작에서 이전 프로세스가 새 프로세스에 히스토리를 넘길 때 호출한다.
+     *          봉인하지 못한 세그먼트는 `.seal`로 남아 새 프로세스가 열 때 봉인한다.
+     */
+    void close();
+
     /**
      * @brief 전역 메시지를 기록한다.
      * @param message 기록할 메시지 내용.
      * @param sender 발신자 닉네임 (선택사항).
+     * @param seq 전달할 때 붙인 채널 순번. 0이 아니면 `<시각> #<순번> [<보낸 사람>]: <본문>`으로 기록한다.
      */
-    void log_global_message(const std::string& message, const std::string& sender = "");
+    void log_global_message(const std::string& message, const std::string& sender = "", std::uint64_t seq = 0);
     
     /**
      * @brief 개인 메시지(귓속말)를 기록한다.
@@ -50,8 +186,29 @@ public:
      * @param room_name 채팅방 이름.
      * @param message 기록할 메시지 내용.
      * @param sender 발신자 닉네임 (선택사항).
+     * @param seq 전달할 때 붙인 채널 순번. 0이 아니면 `<시각> #<순번> [<보낸 사람>]: <본문>`으로 기록한다.
+     */
+    void log_room_message(const std::string& room_name, const std::string& message, const std::string& sender = "",
+                          std::uint64_t seq = 0);
+
+    /**
+     * @brief 기록 줄에 붙은 채널 순번을 읽는다.
+     * @return 순번. 순번 없이 기록된 줄이면 0.
+     */
+    static std::uint64_t line_seq(const std::string& line);
+
+    /**
+     * @brief 기록이 추가될 때마다 호출할 함수를 지정한다. (복제용)
+     * @param listener 기록 잠금 안에서 기록 순서대로 호출되므로 오래 걸리는 일을 하면 안 된다. 빈 함수면 해제.
      */
-    void log_room_message(const std::string& room_name, const std::string& message, const std::string& sender = "");
+    void set_append_listener(std::function<void(const HistoryRecord&)> listener);
+
+    /**
+     * @brief 다른 노드에서 복제된 기록을 시각을 바꾸지 않고 그대로 추가한다.
+     * @param record 리더의 `set_append_listener`로 받은 기록.
+     * @return 추가했으면 true.
+     */
+    bool apply_record(const HistoryRecord& record);
 
     /**
      * @brief 전역 메시지 기록을 불러온다.
@@ -77,6 +234,78 @@ public:
      */
     std::vector<std::string> load_room_history(const std::string& room_name, size_t limit = 0);
 
+    /**
+     * @brief 채팅방 기록을 줄 번호로 읽는다. 해당 줄이 든 압축 블록만 푼다.
+     * @param room_name 채팅방 이름.
+     * @param first_line 첫 줄 번호 (0부터, 기록된 순서).
+     * @param count 읽을 최대 줄 수.
+     * @return 메시지 기록 벡터.
+     */
+    std::vector<std::string> load_room_range(const std::string& room_name, std::uint64_t first_line, size_t count);
+
+    /**
+     * @brief 채팅방 기록을 시각 범위로 읽는다. 시각 범위가 겹치는 압축 블록만 푼다.
+     * @param room_name 채팅방 이름.
+     * @param from 시작 시각 (`YYYY-MM-DD HH:MM:SS`, 앞부분만 써도 됨. 비어 있으면 처음부터).
+     * @param to 끝 시각 (같은 형식, 포함. 비어 있으면 끝까지).
+     * @return 메시지 기록 벡터.
+     */
+    std::vector<std::string> load_room_between(const std::string& room_name, const std::string& from, const std::string& to);
+
+    /// @brief 전역 기록을 줄 번호로 읽는다. (`load_room_range` 참고)
+    std::vector<std::string> load_global_range(std::uint64_t first_line, size_t count);
+
+    /// @brief 전역 기록을 시각 범위로 읽는다. (`load_room_between` 참고)
+    std::vector<std::string> load_global_between(const std::string& from, const std::string& to);
+
+    /**
+     * @brief 세그먼트 크기를 바꾼다. 기록을 시작하기 전에 호출해야 한다.
+     * @param segment_bytes 활성 세그먼트를 봉인하는 크기 (0이면 봉인하지 않음).
+     * @param block_bytes 압축 블록 하나의 최대 원본 크기.
+     */
+    void set_segment_limits(size_t segment_bytes, size_t block_bytes);
+
+    /**
+     * @brief 채팅방과 귓속말 기록을 검색한다. 색인과 파일 읽기만 하므로 호출 스레드만 잠시 쓴다.
+     * @param query 검색어 (모든 단어를 포함하는 메시지를 찾는다).
+     * @param nickname 검색하는 사용자. 이 사용자가 참여한 귓속말만 결과에 포함한다. 비어 있으면 귓속말은 제외한다.
+     * @param room_name 비어 있지 않으면 이 채팅방 기록만 찾는다.
+     * @param offset 건너뛸 결과 수.
+     * @param limit 돌려줄 최대 결과 수.
+     * @param private_since 이 시각(Unix 초)보다 나중에 기록된 귓속말만 포함한다. 닉네임이 계정에 묶이기 전의 귓속말을 가린다.
+     * @return 검색 결과 한 페이지.
+     */
+    SearchResult search(const std::string& query, const std::string& nickname, const std::string& room_name,
+                        size_t offset, size_t limit, std::uint64_t private_since = 0);
+
+    /**
+     * @brief 예전 형식의 대화별 개인 메시지 파일(`private/<u1>_<u2>.txt/.blk/.idx`)을 저장소로 가져온다.
+     * @return 가져온 대화 수.
+     * @details 가져온 파일은 `private/migrated/`로 옮기므로 다시 실행해도 중복되지 않는다.
+     *          가져온 줄은 저장소 끝에 붙으므로 새 형식으로 서버를 시작하기 전에 실행해야 대화 순서가 맞는다.
+     */
+    size_t migrate_private_files();
+
+    /**
+     * @brief 보존 정책을 설정하고, `config.interval`이 0보다 크면 백그라운드 정리를 시작한다.
+     * @param config 채널별 보존 기간/크기, 보관 디렉터리, I/O 속도 제한, 정리 주기.
+     */
+    void set_retention(const RetentionConfig& config);
+
+    /**
+     * @brief 정리를 한 번 실행한다. 백그라운드 스레드가 호출하며, 테스트에서는 직접 호출한다.
+     * @return 정리 결과.
+     * @details 채널마다 잠금 안에서 색인만 복사하고, 파일 읽기/쓰기는 잠금 밖에서 속도를 제한해 수행한 뒤
+     *          잠금 안에서 파일을 바꾼다. 따라서 실시간 기록은 정리 중에도 거의 기다리지 않는다.
+     */
+    MaintenanceReport run_maintenance();
+
+    /// @brief 가득 찬 세그먼트가 모두 봉인될 때까지 기다린다. (주로 테스트용)
+    void flush_sealing();
+
+    /// @brief 기존 기록의 백필을 포함해 지금까지 기록한 메시지가 모두 색인에 반영될 때까지 기다린다. (주로 테스트용)
+    void flush_search_index();
+
     /**
      * @brief 메시지 기록 기능 활성화 여부를 반환한다.
      * @return true이면 활성화, false이면 비활성화.
@@ -87,5 +316,5 @@ public:
      * @brief 메시지 기록 기능을 활성화/비활성화한다.
      * @param enabled 활성화 여부.
      */
-    void set_enabled(bool enabled) { enabled_ = enabled; }
+    void set_enabled(bool enabled) { enabled_ = enabled && !closed_; }
 };
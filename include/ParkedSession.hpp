@@ -0,0 +1,74 @@
+/**
+ * @file ParkedSession.hpp
+ * @brief 연결이 끊긴 클라이언트의 자리를 재접속 유예 기간 동안 대신 지키는 `ParkedSession`을 정의합니다.
+ * @details 클라이언트 연결이 끊기면 `ChatServer`는 세션을 바로 제거하지 않고 `ParkedSession`으로 바꿔 끼웁니다.
+ *          닉네임과 채팅방 멤버십은 그대로 유지되고, 그동안 이 세션으로 전달된 메시지는 백로그에 쌓입니다.
+ *          클라이언트가 재접속 토큰(`/resume`)으로 돌아오면 새 세션이 자리를 넘겨받고 백로그를 한 번에 받습니다.
+ */
+#pragma once
+
+#include "SessionInterface.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+
+/**
+ * @class ParkedSession
+ * @brief 네트워크 연결 없이 메시지를 백로그에 보관하는 `SessionInterface` 구현체.
+ * @details `deliver`는 어느 스레드에서든 호출될 수 있으므로 내부 뮤텍스로 보호합니다.
+ *          `resume_into` 이후에는 늦게 도착한 메시지를 새 세션으로 그대로 넘깁니다.
+ */
+class ParkedSession : public SessionInterface, public std::enable_shared_from_this<ParkedSession> {
+public:
+    /**
+     * @brief 생성자.
+     * @param ioc 스트랜드를 만들 io_context.
+     * @param nickname 끊긴 세션의 닉네임.
+     * @param remote_id 끊긴 세션의 원격 식별자.
+     * @param current_room 끊긴 세션이 참여 중이던 방 이름.
+     * @param max_backlog 보관할 최대 메시지 수. 넘치면 오래된 메시지부터 버립니다.
+     */
+    ParkedSession(net::io_context& ioc, const std::string& nickname, const std::string& remote_id,
+                  const std::string& current_room, std::size_t max_backlog = 256);
+
+    void deliver(const std::string& msg) override;
+    void deliver_ephemeral(const std::string&) override {} ///< 연결이 끊긴 동안의 일회성 이벤트는 보관하지 않습니다.
+    void stop_session() override {}
+    const std::string& nickname() const override { return nickname_; }
+    const std::string& remote_id() const override { return remote_id_; }
+    net::strand<net::any_io_executor>& get_strand() override { return strand_; }
+    bool is_authenticated() const override { return authenticated_; }
+    void set_nickname(const std::string& nick) override { nickname_ = nick; }
+    void set_authenticated(bool auth) override { authenticated_ = auth; }
+    const std::string& current_room() const override { return current_room_; }
+    void set_current_room(const std::string& room_name) override { current_room_ = room_name; }
+    std::shared_ptr<SessionInterface> shared_from_this() override {
+        return std::enable_shared_from_this<ParkedSession>::shared_from_this();
+    }
+
+    /**
+     * @brief 쌓인 백로그를 `target`에 순서대로 전달하고, 이후 도착하는 메시지도 `target`으로 넘깁니다.
+     * @return 전달한 메시지 수.
+     */
+    std::size_t resume_into(const SessionPtr& target);
+
+    /// 백로그가 넘쳐 버린 메시지 수
+    std::size_t dropped() const;
+
+private:
+    net::strand<net::any_io_executor> strand_;
+    std::string nickname_;
+    std::string remote_id_;
+    std::string current_room_;
+    bool authenticated_ = false;
+
+    mutable std::mutex mutex_;
+    std::deque<std::string> backlog_;   ///< 연결이 끊긴 동안 받은 메시지 (`mutex_`로 보호)
+    std::size_t max_backlog_;
+    std::size_t dropped_ = 0;           ///< 넘쳐서 버린 메시지 수
+    SessionPtr forward_to_;             ///< `resume_into` 이후 메시지를 넘길 세션
+};
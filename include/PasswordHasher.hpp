@@ -0,0 +1,128 @@
+/**
+ * @file PasswordHasher.hpp
+ * @brief 비밀번호 해시(scrypt)를 전용 작업 스레드에서 계산하는 `PasswordHasher`와 로그인 토큰 캐시 `CredentialCache`를 정의합니다.
+ * @details scrypt는 일부러 수십 밀리초와 수십 MB 메모리를 쓰는 함수이므로 io_context 스레드나 strand에서 직접 호출하면
+ *          그동안 채팅 메시지 처리가 멈춥니다. `PasswordHasher`는 크기가 정해진 작업 큐와 스레드를 따로 두고,
+ *          큐가 가득 차면 요청을 바로 거절하여 로그인이 몰려도 채팅 처리와 메모리 사용이 늘지 않게 합니다.
+ *          `CredentialCache`는 로그인에 성공한 사용자에게 짧은 기간 유효한 토큰을 발급해 재접속 시 해시 계산을 건너뛰게 합니다.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct KdfParams
+ * @brief scrypt 비용 설정. 기본값(N=2^15, r=8, p=1)은 해시 하나에 약 32MB 메모리를 씁니다.
+ */
+struct KdfParams {
+    int log2_n = 15;  ///< CPU/메모리 비용 N = 2^log2_n
+    int r = 8;        ///< 블록 크기
+    int p = 1;        ///< 병렬화 계수
+};
+
+/**
+ * @class PasswordHasher
+ * @brief 비밀번호 해시 계산/검증을 전용 스레드 풀에서 실행합니다.
+ * @details 저장 형식은 `$scrypt$ln=<log2 N>,r=<r>,p=<p>$<솔트 hex>$<키 hex>`이며, 검증은 저장된 값의 비용 설정을 따릅니다.
+ *          완료 콜백은 작업 스레드에서 호출되므로, 호출하는 쪽이 필요한 strand로 넘겨야 합니다.
+ */
+class PasswordHasher {
+public:
+    /**
+     * @brief 생성자. 작업 스레드를 시작합니다.
+     * @param threads 작업 스레드 수 (동시에 계산하는 해시 수).
+     * @param max_queue 대기할 수 있는 최대 작업 수. 넘으면 `*_async`가 false를 돌려줍니다.
+     * @param params 새 해시에 사용할 비용 설정.
+     */
+    explicit PasswordHasher(std::size_t threads = 2, std::size_t max_queue = 256, KdfParams params = {});
+    ~PasswordHasher();
+
+    PasswordHasher(const PasswordHasher&) = delete;
+    PasswordHasher& operator=(const PasswordHasher&) = delete;
+
+    /// 비밀번호를 해시합니다. 실패하면 `done("")`. 큐가 가득 찼거나 중지되었으면 false를 돌려주고 `done`을 호출하지 않습니다.
+    bool hash_async(std::string password, std::function<void(std::string encoded)> done);
+
+    /// 비밀번호가 저장된 해시와 맞는지 확인합니다. 큐가 가득 찼거나 중지되었으면 false를 돌려주고 `done`을 호출하지 않습니다.
+    bool verify_async(std::string password, std::string encoded, std::function<void(bool ok)> done);
+
+    /// 대기 중인 작업을 버리고 스레드를 멈춥니다. 실행 중인 작업은 끝날 때까지 기다립니다.
+    void stop();
+
+    /// 대기 중인 작업 수
+    std::size_t queued() const;
+
+    /// 새 해시에 사용하는 비용 설정
+    const KdfParams& params() const { return params_; }
+
+    /// 비밀번호를 해시합니다. (호출한 스레드에서 계산) 실패하면 빈 문자열.
+    static std::string hash(const std::string& password, const KdfParams& params);
+
+    /// 비밀번호가 저장된 해시와 맞는지 확인합니다. (호출한 스레드에서 계산) 형식이 잘못되었으면 false.
+    static bool verify(const std::string& password, const std::string& encoded);
+
+private:
+    bool submit(std::function<void()> job);
+    void worker_loop();
+
+    KdfParams params_;
+    std::size_t max_queue_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;   ///< `mutex_`로 보호
+    bool stopped_ = false;                     ///< `mutex_`로 보호
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * @class CredentialCache
+ * @brief 비밀번호 확인을 마친 사용자에게 발급한 로그인 토큰 목록.
+ * @details 토큰은 `ttl` 동안 몇 번이든 쓸 수 있으며, 비밀번호가 바뀌거나 계정이 지워지면 `revoke_user`로 폐기합니다.
+ *          `max_entries`를 넘으면 가장 먼저 발급한 토큰부터 버립니다. 스레드 안전합니다.
+ */
+class CredentialCache {
+public:
+    explicit CredentialCache(std::chrono::seconds ttl = std::chrono::minutes(10), std::size_t max_entries = 100000);
+
+    /// 유효 기간을 바꿉니다. 이미 발급한 토큰에는 적용되지 않습니다. 0이면 토큰을 발급하지 않습니다.
+    void set_ttl(std::chrono::seconds ttl);
+
+    /// `username`에게 새 토큰을 발급합니다. 유효 기간이 0이면 빈 문자열.
+    std::string issue(const std::string& username);
+
+    /// 토큰이 `username`에게 발급되었고 아직 유효하면 true.
+    bool check(const std::string& username, const std::string& token);
+
+    /// `username`의 토큰을 모두 폐기합니다.
+    void revoke_user(const std::string& username);
+
+    /// 보관 중인 토큰 수 (만료된 것 포함)
+    std::size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Entry {
+        std::string username;
+        Clock::time_point expires;
+    };
+
+    /// 만료되었거나 한도를 넘은 토큰을 발급 순으로 버린다. 호출 측이 잠금을 잡고 있어야 한다.
+    void purge(Clock::time_point now);
+
+    std::chrono::seconds ttl_;
+    std::size_t max_entries_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;           ///< 토큰 -> 사용자
+    std::deque<std::pair<Clock::time_point, std::string>> order_; ///< 발급 순 (만료 시각, 토큰)
+};
@@ -0,0 +1,125 @@
+/**
+ * @file PrivateMessageStore.hpp
+ * @brief 모든 귓속말 기록을 파일 하나에 모아 저장하는 `PrivateMessageStore`를 정의합니다.
+ * @details 예전에는 대화 상대 쌍마다 `private/<u1>_<u2>.txt`를 만들어 사용자가 늘수록 작은 파일이 수십만 개 생겼습니다.
+ *          이제는 `private/messages.log` 하나에 레코드를 이어 붙이고, 대화별 레코드 위치 목록을 메모리에 둡니다.
+ *          기존 쌍 파일은 `MessageHistory::migrate_private_files`(`CherryRecorder-MigratePM` 도구)로 가져옵니다.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PrivateMessageStore
+ * @brief 로그 구조의 귓속말 저장소와 대화별 색인.
+ * @details 레코드 형식은 `[u32 전체 길이][u16 이름1 길이][u16 이름2 길이][이름1][이름2][기록 줄]`입니다. (리틀 엔디언)
+ *          파일을 열어 둔 채 끝에 붙이므로 메시지마다 파일을 열고 닫지 않고, 대화의 마지막 N줄은 색인으로 위치를 찾아 그 레코드만 읽습니다.
+ *          열 때 레코드 머리만 훑어 색인을 다시 만들고, 중간에 멈춰 잘린 마지막 레코드는 잘라 냅니다.
+ *          두 사용자 이름은 정렬해 저장하므로 (alice, bob)과 (bob, alice)는 같은 대화입니다.
+ *          스레드 안전하지 않습니다. `MessageHistory`의 잠금 안에서만 사용합니다.
+ */
+class PrivateMessageStore {
+public:
+    /// 대화 상대 쌍 (정렬됨)
+    using Conversation = std::pair<std::string, std::string>;
+
+    /**
+     * @brief 레코드 정리 결과. 잠금 밖에서 `rewrite`로 만들고 잠금 안에서 `install`로 적용합니다.
+     */
+    struct Rewrite {
+        std::uint64_t scanned_end = 0;                         ///< `rewrite`가 읽은 끝 위치
+        std::uint64_t written = 0;                             ///< 새 파일 크기 (`install` 전 기준)
+        std::unordered_map<std::string, std::uint64_t> dropped; ///< 대화 키 -> 버린 줄 수
+        std::size_t dropped_records = 0;
+    };
+
+    /// 레코드를 남길지 판단하는 함수 (대화 상대, 기록 줄, 레코드 시작 위치)
+    using KeepFn = std::function<bool(const Conversation& users, const std::string& line, std::uint64_t offset)>;
+
+    /**
+     * @brief 생성자. 로그 파일을 열고(없으면 만들고) 색인을 만듭니다.
+     * @param path 로그 파일 경로 (예: `history/private/messages.log`).
+     */
+    explicit PrivateMessageStore(std::string path);
+
+    PrivateMessageStore(const PrivateMessageStore&) = delete;
+    PrivateMessageStore& operator=(const PrivateMessageStore&) = delete;
+
+    bool is_open() const { return out_.is_open(); }
+
+    /// 대화에 기록 줄 하나를 붙입니다. 실패하면 false.
+    bool append(const std::string& user1, const std::string& user2, const std::string& line);
+
+    /// 대화의 줄 수
+    std::uint64_t line_count(const std::string& user1, const std::string& user2) const;
+
+    /// 대화의 마지막 `limit`줄 (0이면 전체)
+    std::vector<std::string> last_lines(const std::string& user1, const std::string& user2, std::size_t limit);
+
+    /// 대화의 줄 번호 `first`부터 최대 `count`줄
+    std::vector<std::string> lines(const std::string& user1, const std::string& user2, std::uint64_t first, std::size_t count);
+
+    /// 기록이 있는 모든 대화
+    std::vector<Conversation> conversations() const;
+
+    /// 대화에 남아 있는 첫 줄 번호 (앞부분이 정리되면 0보다 큼)
+    std::uint64_t first_line(const std::string& user1, const std::string& user2) const;
+
+    /// 모든 줄이 정리된 대화까지 포함한 모든 대화의 첫 줄 번호
+    std::vector<std::pair<Conversation, std::uint64_t>> first_lines() const;
+
+    /// 파일에서 가장 먼저 기록된 줄 (비어 있으면 빈 문자열)
+    std::string oldest_line();
+
+    /// 로그 파일 크기
+    std::uint64_t size_bytes() const { return end_offset_; }
+
+    /**
+     * @brief `end`까지의 레코드 중 `keep`이 false인 것을 빼고 `<경로>.compact`에 씁니다. 잠금 밖에서 호출합니다.
+     * @param path 로그 파일 경로.
+     * @param end 잠금 안에서 읽은 `size_bytes()`. 그 뒤에 붙은 레코드는 `install`이 옮깁니다.
+     * @param keep 남길 레코드 판단.
+     * @param throttle 읽기/쓰기 전에 바이트 수를 넘겨 허락을 받는 함수. false면 중단합니다.
+     * @param on_dropped 비어 있지 않으면 버리는 줄을 넘깁니다. (보관용)
+     * @param out 결과.
+     * @return 성공하면 true. 실패하거나 중단하면 임시 파일을 지우고 false.
+     */
+    static bool rewrite(const std::string& path, std::uint64_t end, const KeepFn& keep,
+                        const std::function<bool(std::uint64_t)>& throttle,
+                        const std::function<void(const std::string&)>& on_dropped, Rewrite& out);
+
+    /**
+     * @brief `rewrite` 결과를 적용합니다. 그사이 붙은 레코드를 새 파일 끝에 옮기고 파일을 바꾼 뒤 색인을 다시 만듭니다.
+     * @details 대화별 줄 번호는 바뀌지 않습니다. 버린 줄 수만큼 첫 줄 번호가 늘어납니다. (프로세스가 다시 시작하면 0부터)
+     */
+    bool install(const Rewrite& rewrite);
+
+private:
+    struct Record {
+        std::uint64_t offset;   ///< 기록 줄의 파일 내 위치
+        std::uint32_t length;   ///< 기록 줄의 길이
+    };
+    struct Entry {
+        Conversation users;
+        std::uint64_t base = 0;        ///< 첫 레코드의 줄 번호 (정리로 버린 줄 수)
+        std::vector<Record> records;   ///< 기록 순
+    };
+
+    static std::string key_of(const std::string& user1, const std::string& user2);
+    void load();
+    bool read_line(const Record& record, std::string& out);
+    const Entry* find(const std::string& user1, const std::string& user2) const;
+
+    std::string path_;
+    std::ofstream out_;
+    std::ifstream in_;
+    std::uint64_t end_offset_ = 0;
+    std::unordered_map<std::string, Entry> index_;   ///< 대화 키 -> 대화 상대와 레코드 위치
+};
@@ -0,0 +1,152 @@
+/**
+ * @file SearchIndex.hpp
+ * @brief 채팅 기록 전문 검색용 역색인 `SearchIndex`를 정의합니다.
+ * @details 히스토리에 기록된 메시지 한 줄이 문서 하나입니다. 문서는 (채널, 줄 번호)로 가리키고
+ *          본문은 색인에 두지 않으므로, 결과를 보여 줄 때는 `MessageHistory`에서 해당 줄만 읽습니다.
+ *          한글은 띄어쓰기와 조사 때문에 단어 단위로 찾기 어려우므로 음절 2-gram으로, 그 밖의 문자는 단어 단위로 색인합니다.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class SearchIndex
+ * @brief 메시지를 모아 배치로 반영하는 증분 역색인.
+ * @details `add`는 대기열에 넣기만 하므로 메시지 전달 경로를 막지 않습니다.
+ *          색인 스레드가 `batch_size`개가 모이거나 `flush_interval`이 지나면 토큰화한 뒤 짧게 쓰기 잠금을 잡고 반영합니다.
+ *          포스팅 목록은 문서 번호 차이와 단어 빈도를 varint로 이어 붙인 바이트열입니다.
+ *          모든 public 메서드는 스레드 안전합니다.
+ */
+class SearchIndex {
+public:
+    /// 검색 결과 하나
+    struct Hit {
+        std::string channel;       ///< 채널 키 (예: `rooms/lobby`, `private/alice_bob`)
+        std::uint64_t line = 0;    ///< 채널 히스토리 안의 줄 번호
+        double score = 0;          ///< 점수 (높을수록 먼저)
+        std::vector<std::string> participants; ///< 귓속말 채널의 참여자
+    };
+
+    /// 검색 결과 한 페이지
+    struct Page {
+        std::size_t total = 0;     ///< 조건에 맞는 전체 문서 수
+        std::vector<Hit> hits;     ///< 요청한 구간의 결과 (점수, 최신 순)
+    };
+
+    /// 채널 키, 참여자(귓속말 채널만), 기록 시각(Unix 초)을 받아 검색 대상인지 판단하는 함수
+    using Filter = std::function<bool(const std::string& channel, const std::vector<std::string>& participants,
+                                      std::uint64_t time)>;
+
+    /**
+     * @brief 생성자. 색인 스레드를 시작합니다.
+     * @param batch_size 한 번에 반영할 최대 문서 수.
+     * @param flush_interval 문서가 적어도 이 간격마다 반영합니다.
+     */
+    explicit SearchIndex(std::size_t batch_size = 256,
+                         std::chrono::milliseconds flush_interval = std::chrono::milliseconds(200));
+
+    /// 대기 중인 문서를 반영하고 색인 스레드를 멈춥니다.
+    ~SearchIndex();
+
+    SearchIndex(const SearchIndex&) = delete;
+    SearchIndex& operator=(const SearchIndex&) = delete;
+
+    /**
+     * @brief 문서를 색인 대기열에 넣습니다.
+     * @param channel 채널 키.
+     * @param line 채널 히스토리 안의 줄 번호.
+     * @param text 색인할 본문.
+     * @param participants 귓속말 채널의 참여자 (처음 본 채널에서만 기록).
+     * @param time 기록 시각 (Unix 초). `Filter`에 그대로 넘깁니다.
+     */
+    void add(const std::string& channel, std::uint64_t line, std::string text, std::vector<std::string> participants = {},
+             std::uint64_t time = 0);
+
+    /// 지금까지 `add`한 문서가 모두 반영될 때까지 기다립니다.
+    void flush();
+
+    /**
+     * @brief 채널에서 `first_line`보다 앞의 줄은 정리되었다고 표시합니다. 이후 검색에서 그 문서는 세지도 돌려주지도 않습니다.
+     * @details 포스팅은 그대로 두므로 메모리는 줄지 않습니다. 줄 번호는 정리 후에도 바뀌지 않으므로 번호 하나로 충분합니다.
+     *          값은 늘어나기만 합니다.
+     */
+    void set_floor(const std::string& channel, std::uint64_t first_line);
+
+    /**
+     * @brief 모든 검색어 토큰을 포함하는 문서를 점수 순으로 찾습니다.
+     * @param query 검색어.
+     * @param filter 검색 대상 채널 판단 함수 (비어 있으면 전체).
+     * @param offset 건너뛸 결과 수.
+     * @param limit 돌려줄 최대 결과 수.
+     * @details 한 음절 한글 검색어는 그 음절로 시작하는 2-gram을 모두 합쳐 찾습니다.
+     */
+    Page search(const std::string& query, const Filter& filter, std::size_t offset, std::size_t limit) const;
+
+    /// 색인에 반영된 문서 수
+    std::size_t document_count() const;
+
+    /// 본문을 색인 토큰으로 나눕니다. (한글 음절 2-gram, 그 밖의 단어는 소문자 단어)
+    static std::vector<std::string> tokenize(const std::string& text);
+
+private:
+    struct Pending {
+        std::string channel;
+        std::uint64_t line;
+        std::string text;
+        std::vector<std::string> participants;
+        std::uint64_t time;
+    };
+    struct Document {
+        std::uint32_t channel;     ///< `channels_` 번호
+        std::uint32_t time;        ///< 기록 시각 (Unix 초, 채움 바이트 자리에 두어 크기는 그대로)
+        std::uint64_t line;
+    };
+    struct Channel {
+        std::string key;
+        std::vector<std::string> participants;
+        std::uint64_t floor = 0;   ///< 이보다 앞의 줄은 히스토리에서 정리됨
+    };
+    struct Postings {
+        std::string bytes;         ///< (문서 번호 차이, 빈도) varint 쌍
+        std::uint32_t last_doc = 0;
+        std::uint32_t count = 0;   ///< 문서 빈도
+    };
+
+    void run();
+    void apply(std::vector<Pending>& batch);
+    void collect(const Postings& postings, std::unordered_map<std::uint32_t, std::uint32_t>& out) const;
+
+    std::size_t batch_size_;
+    std::chrono::milliseconds flush_interval_;
+
+    // 대기열 (`queue_mutex_`로 보호)
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable applied_cv_;
+    std::deque<Pending> queue_;
+    std::uint64_t queued_ = 0;     ///< 지금까지 넣은 문서 수
+    std::uint64_t applied_ = 0;    ///< 지금까지 반영한 문서 수
+    bool stopping_ = false;
+    bool flush_requested_ = false; ///< `flush`가 배치를 기다리지 말고 바로 반영하라고 요청함
+
+    // 색인 (`index_mutex_`로 보호)
+    mutable std::shared_mutex index_mutex_;
+    std::map<std::string, Postings> terms_;              ///< 토큰 -> 포스팅 (접두어 검색을 위해 정렬)
+    std::vector<Document> documents_;
+    std::vector<Channel> channels_;
+    std::unordered_map<std::string, std::uint32_t> channel_ids_;
+
+    std::thread worker_;
+};
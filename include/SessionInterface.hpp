@@ -7,6 +7,7 @@
 
 #include <string>
 #include <memory>
+#include <functional>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
 
@@ -20,6 +21,12 @@ public:
     
     /// 클라이언트에게 메시지 전달
     virtual void deliver(const std::string& msg) = 0;
+
+    /// 입력 중 표시 같은 일회성 이벤트 전달. 전송이 밀려 있으면 일반 메시지보다 먼저 버려도 된다.
+    virtual void deliver_ephemeral(const std::string& msg) { deliver(msg); }
+
+    /// 파일 조각(바이너리 프레임) 전달. 프레임을 보내거나 버린 뒤 `on_sent`를 호출한다. 바이너리를 보낼 수 없는 세션이면 false.
+    virtual bool deliver_binary(std::shared_ptr<const std::string>, std::function<void()>) { return false; }
     
     /// 세션 종료
     virtual void stop_session() = 0;
@@ -0,0 +1,211 @@
+/**
+ * @file UserStore.hpp
+ * @brief 사용자 계정(`UserAccount`)과 계정을 디스크에 저장하는 `UserStore`를 정의합니다.
+ * @details 계정은 `<경로>.snapshot`(해시 테이블을 포함한 바이너리 스냅샷)과 `<경로>.log`(변경 기록)에 나누어 저장합니다.
+ *          시작할 때 스냅샷은 mmap으로 매핑만 하고 파싱하지 않으므로, 계정이 수백만 개여도 로그 재생 시간만 걸립니다.
+ *          변경은 로그 끝에 붙이고 메모리의 변경분 맵에 반영하며, 변경분이 쌓이면 백그라운드에서 새 스냅샷으로 합칩니다.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @class UserAccount
+ * @brief 사용자 계정 정보를 저장하는 클래스.
+ *
+ * 사용자 인증 및 권한 관리를 위한 정보를 저장한다.
+ */
+class UserAccount {
+private:
+    std::string username_;     ///< 사용자명
+    std::string password_hash_; ///< 비밀번호 해시
+    bool is_admin_ = false;    ///< 관리자 여부
+    std::string last_ip_;      ///< 마지막 접속 IP
+    std::string last_login_;   ///< 마지막 로그인 시간
+    std::uint64_t bound_at_ = 0; ///< 같은 이름의 닉네임을 계정에 묶은 시각 (Unix 초, 0이면 아직 묶지 않음)
+
+public:
+    /**
+     * @brief UserAccount 생성자.
+     * @param username 사용자명.
+     * @param password_hash 비밀번호 해시.
+     * @param is_admin 관리자 여부.
+     */
+    UserAccount(const std::string& username,
+                const std::string& password_hash,
+                bool is_admin = false);
+
+    /**
+     * @brief 사용자 비밀번호 확인.
+     * @param password_hash 확인할 비밀번호 해시.
+     * @return 일치하면 true.
+     */
+    bool check_password(const std::string& password_hash) const;
+
+    /**
+     * @brief 비밀번호 변경.
+     * @param new_password_hash 새 비밀번호 해시.
+     */
+    void set_password(const std::string& new_password_hash);
+
+    /**
+     * @brief 관리자 권한 설정.
+     * @param is_admin 관리자 여부.
+     */
+    void set_admin(bool is_admin);
+
+    /**
+     * @brief 관리자 여부 확인.
+     * @return 관리자이면 true.
+     */
+    bool is_admin() const { return is_admin_; }
+
+    /**
+     * @brief 로그인 정보 업데이트.
+     * @param ip 접속 IP.
+     * @param login_time 로그인 시간.
+     */
+    void update_login_info(const std::string& ip, const std::string& login_time);
+
+    /**
+     * @brief 같은 이름의 닉네임을 계정에 묶은 시각을 기록합니다.
+     * @param time Unix 초. 이보다 먼저 그 닉네임으로 오간 귓속말은 계정에 보여 주지 않습니다.
+     */
+    void bind_nickname(std::uint64_t time);
+
+    /**
+     * @brief 사용자명 반환.
+     * @return 사용자명.
+     */
+    const std::string& username() const { return username_; }
+
+    /// 비밀번호 해시
+    const std::string& password_hash() const { return password_hash_; }
+    /// 마지막 접속 IP
+    const std::string& last_ip() const { return last_ip_; }
+    /// 마지막 로그인 시간
+    const std::string& last_login() const { return last_login_; }
+    /// 닉네임을 계정에 묶은 시각 (Unix 초, 0이면 아직 묶지 않음)
+    std::uint64_t bound_at() const { return bound_at_; }
+};
+
+/**
+ * @class UserStore
+ * @brief 스냅샷 + 변경 로그 구조의 계정 저장소.
+ * @details 조회는 `write_mutex_`를 잡지 않고 현재 상태(스냅샷 매핑과 변경분 맵)의 `shared_ptr`를 가져와 읽으므로,
+ *          로그 기록(fdatasync)이나 합치기를 기다리지 않습니다. 다만 `std::atomic<std::shared_ptr>`는 libstdc++에서
+ *          lock-free가 아니어서 포인터를 가져오고 게시하는 짧은 구간은 내부 잠금으로 직렬화됩니다.
+ *          찾기는 변경분 맵에서 먼저 찾고, 없으면 스냅샷의 해시 테이블을 선형 탐사합니다.
+ *          변경은 `write_mutex_` 안에서 로그에 기록한 뒤 변경분 맵 전체를 복사해 바꾼 새 상태를 게시하므로,
+ *          변경 한 건의 비용은 쌓인 변경분 수(최대 `compact_after`)에 비례합니다.
+ *          변경분 맵은 `compact_after`개를 넘지 않도록 백그라운드 스레드가 새 스냅샷으로 합치고 로그를 비웁니다.
+ *          합치는 동안에도 조회와 변경은 계속되며, 그사이 바뀐 계정은 새 로그로 옮깁니다.
+ *          스냅샷 형식 (리틀 엔디언):
+ *          `[magic 8][u64 계정 수][u64 버킷 수][버킷: u64 레코드 위치 (0이면 빈칸)...][레코드...]`,
+ *          레코드는 `[u16 이름 길이][u16 해시 길이][u16 IP 길이][u16 로그인 시간 길이][u8 플래그][이름][해시][IP][로그인 시간]`이고,
+ *          플래그에 0x02가 있으면 끝에 `[u64 닉네임을 묶은 시각]`이 붙습니다.
+ *          로그는 `[u32 길이][u8 종류 (1: 저장, 2: 삭제)][레코드]`의 연속이며, 중간에 멈춰 잘린 마지막 항목은 열 때 잘라 냅니다.
+ *          경로가 비어 있으면 파일 없이 메모리에서만 같은 방식으로 동작합니다.
+ *          파일을 쓰는 저장소는 `<경로>.lock`에 배타적 `flock`을 잡습니다. 다른 프로세스가 이미 열고 있으면
+ *          열기에 실패하므로(`is_open()`이 false), 두 프로세스가 같은 로그에 번갈아 쓰거나 서로의 스냅샷을 덮어쓰지 않습니다.
+ */
+class UserStore {
+public:
+    /**
+     * @brief 생성자. 스냅샷을 매핑하고 로그를 재생한 뒤 백그라운드 합치기를 시작합니다.
+     * @param path 저장 경로 접두사 (예: `users/accounts` -> `users/accounts.snapshot`, `users/accounts.log`). 비어 있으면 메모리 전용.
+     * @param compact_after 변경분이 이 개수에 이르면 스냅샷으로 합칩니다.
+     * @param compact_interval 변경분이 적어도 이 주기마다 합칩니다. (0이면 개수 기준만 사용)
+     */
+    explicit UserStore(std::string path,
+                       std::size_t compact_after = 4096,
+                       std::chrono::milliseconds compact_interval = std::chrono::minutes(10));
+    ~UserStore();
+
+    UserStore(const UserStore&) = delete;
+    UserStore& operator=(const UserStore&) = delete;
+
+    /// 열기에 성공했는지 여부. 스냅샷이 손상되었거나, 로그를 열 수 없거나, 다른 프로세스가 잠그고 있거나, `close()` 뒤에는 false이며, 이때 변경은 모두 실패합니다.
+    bool is_open() const { return open_; }
+
+    /**
+     * @brief 합치기를 멈추고 로그와 잠금 파일을 닫습니다. 이후 조회는 마지막 상태를 그대로 읽고 변경은 모두 실패합니다.
+     * @details 무중단 재시작에서 이전 프로세스가 새 프로세스에 저장소를 넘길 때 호출합니다. 닫을 때 합치지 않으므로,
+     *          남은 변경분은 로그에 그대로 있다가 새 프로세스가 열 때 재생합니다.
+     */
+    void close();
+
+    /// 계정을 찾습니다. 없으면 nullptr. 어느 스레드에서나 호출할 수 있으며 진행 중인 변경이나 합치기를 기다리지 않습니다.
+    std::shared_ptr<const UserAccount> find(std::string_view username) const;
+
+    /// 계정이 있는지 여부
+    bool contains(std::string_view username) const;
+
+    /// 계정 수
+    std::size_t size() const;
+
+    /// 계정을 저장합니다. (있으면 덮어씀) 로그에 기록하지 못하면 false.
+    bool put(const UserAccount& account);
+
+    /// 같은 이름의 계정이 없을 때만 저장합니다. 이미 있거나 로그에 기록하지 못하면 false.
+    bool insert(const UserAccount& account);
+
+    /// 계정을 삭제합니다. 없거나 로그에 기록하지 못하면 false.
+    bool remove(const std::string& username);
+
+    /**
+     * @brief 변경분을 새 스냅샷으로 합치고 로그를 비웁니다. 백그라운드 스레드가 호출하며, 종료 시 직접 불러도 됩니다.
+     * @return 성공하거나 합칠 변경분이 없으면 true.
+     */
+    bool compact();
+
+    /// 아직 스냅샷에 합치지 않은 변경 수
+    std::size_t pending_changes() const;
+
+private:
+    struct Snapshot;
+    /// 이름 -> 계정 (nullptr이면 삭제됨)
+    using Overlay = std::unordered_map<std::string, std::shared_ptr<const UserAccount>>;
+    /// 조회가 읽는 불변 상태. 변경할 때마다 새로 만들어 `state_`로 게시합니다.
+    struct State {
+        std::shared_ptr<const Snapshot> snapshot;
+        Overlay overlay;
+        std::size_t count = 0;
+    };
+
+    bool load();
+    /// 계정을 로그에 기록하고 새 상태를 게시한다. `overwrite`가 false면 같은 이름이 있을 때 실패한다.
+    bool store(const UserAccount& account, bool overwrite);
+    bool replay_log();
+    bool append_log(char kind, const UserAccount& account);
+    bool reopen_log(const Overlay& overlay);
+    void compaction_loop();
+
+    std::string path_;
+    std::size_t compact_after_;
+    std::chrono::milliseconds compact_interval_;
+    std::atomic<bool> open_{false};
+    int log_fd_ = -1;
+    int lock_fd_ = -1;   ///< `<경로>.lock`. 닫으면 `flock`도 풀린다.
+
+    std::atomic<std::shared_ptr<const State>> state_;
+    /// 변경과 합치기 적용을 직렬화
+    std::mutex write_mutex_;
+    /// `compact`가 한 번에 하나만 실행되도록 막는다.
+    std::mutex compact_run_mutex_;
+
+    std::mutex compact_mutex_;
+    std::condition_variable compact_cv_;
+    std::thread compact_thread_;
+    bool stop_compaction_ = false;   ///< `compact_mutex_`로 보호
+};
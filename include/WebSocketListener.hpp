@@ -33,9 +33,32 @@ public:
                       tcp::endpoint endpoint, 
                       std::shared_ptr<ChatServer> server);
 
+    /**
+     * @brief 이미 리스닝 중인 소켓을 넘겨받는 생성자. (무중단 재시작 시 이전 프로세스에서 인계)
+     * @param ioc io_context.
+     * @param protocol 넘겨받은 소켓의 프로토콜 (v4/v6).
+     * @param native_socket 리스닝 중인 네이티브 소켓 핸들. 소유권이 acceptor로 넘어간다.
+     * @param server ChatServer.
+     */
+    WebSocketListener(net::io_context& ioc,
+                      const tcp& protocol,
+                      tcp::acceptor::native_handle_type native_socket,
+                      std::shared_ptr<ChatServer> server);
+
     
     // Start accepting connections
     void run();
+
+    /**
+     * @brief 새 연결 수락을 멈춘다. 이미 연결된 세션은 영향을 받지 않는다.
+     */
+    void stop();
+
+    /// @brief 리스닝 소켓의 네이티브 핸들. (다른 프로세스로 인계할 때 사용)
+    tcp::acceptor::native_handle_type native_handle() { return acceptor_.native_handle(); }
+
+    /// @brief 리스닝 중인 로컬 엔드포인트. 닫힌 경우 기본값.
+    tcp::endpoint local_endpoint() const { beast::error_code ec; return acceptor_.local_endpoint(ec); }
     
 private:
     /**
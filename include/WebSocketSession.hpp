@@ -17,6 +17,7 @@
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
+#include <functional>
 #include <memory>
 #include <queue>
 #include <string>
@@ -44,7 +45,13 @@ private:
   beast::flat_buffer buffer_; ///< 메시지 읽기를 위한 버퍼
   std::shared_ptr<ChatServer> server_; ///< 세션이 속한 ChatServer에 대한 포인터
   net::strand<net::any_io_executor> strand_; ///< 세션 내 비동기 핸들러의 직렬 실행을 보장하는 스트랜드
-  std::queue<std::shared_ptr<const std::string>> write_msgs_; ///< 전송 대기 중인 메시지를 저장하는 큐
+  /// 전송 대기 중인 프레임 하나
+  struct OutgoingFrame {
+    std::shared_ptr<const std::string> data; ///< 보낼 내용 (파일 조각은 송신자에게서 받은 버퍼를 그대로 공유)
+    bool binary = false;                     ///< 바이너리 프레임 여부
+    std::function<void()> on_sent;           ///< 전송이 끝난 뒤 호출할 함수 (파일 조각 흐름 제어용)
+  };
+  std::queue<OutgoingFrame> write_msgs_; ///< 전송 대기 중인 메시지를 저장하는 큐
   bool is_writing_ = false; ///< 현재 쓰기 작업이 진행 중인지 나타내는 플래그
   
   std::string nickname_;     ///< 클라이언트가 설정한 닉네임
@@ -55,6 +62,7 @@ private:
   // 보안 및 리소스 관리 설정
   static constexpr std::size_t max_message_size_ = 1024 * 1024; // 1MB 메시지 크기 제한
   static constexpr std::size_t max_queue_size_ = 100; // 최대 전송 대기 큐 크기
+  static constexpr std::size_t ephemeral_queue_limit_ = 10; // 일회성 이벤트를 버리기 시작하는 큐 크기
 
 public:
   /**
@@ -85,6 +93,19 @@ public:
    */
   void deliver(const std::string &msg) override;
 
+  /**
+   * @brief 일회성 이벤트를 전송 큐에 추가합니다. 큐가 `ephemeral_queue_limit_` 이상 밀려 있으면 버립니다.
+   * @override
+   */
+  void deliver_ephemeral(const std::string &msg) override;
+
+  /**
+   * @brief 파일 조각을 바이너리 프레임으로 전송 큐에 추가합니다. 큐 크기 제한과 관계없이 항상 추가합니다.
+   * @details 조각 수는 `ChatServer`가 전송마다 창 크기로 제한하므로 큐가 무한히 늘어나지 않습니다.
+   * @override
+   */
+  bool deliver_binary(std::shared_ptr<const std::string> frame, std::function<void()> on_sent) override;
+
   /**
    * @brief 세션을 중지하고 WebSocket 연결을 정상적으로 닫습니다.
    * @override
@@ -145,6 +166,12 @@ private:
    */
   void process_message(const std::string &message);
 
+  /**
+   * @brief 수신한 바이너리 프레임(파일 조각)을 `ChatServer`로 넘깁니다.
+   * @return 다음 메시지를 바로 읽어도 되면 true. false이면 서버가 흐름 제어에 따라 읽기를 다시 시작합니다.
+   */
+  bool process_binary(std::shared_ptr<const std::string> frame);
+
   /**
    * @brief 사용자 인증을 처리합니다. (현재는 구현되지 않음)
    * @param username 사용자 이름.
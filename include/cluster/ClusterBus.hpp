@@ -0,0 +1,203 @@
+/**
+ * @file ClusterBus.hpp
+ * @brief 여러 `ChatServer` 노드 간 메시지를 중계하는 클러스터 버스 인터페이스를 정의합니다.
+ * @details 클러스터 모드에서 `broadcast`, `broadcast_to_room`, `send_private_message`는
+ *          로컬 세션에 전달한 뒤 `ClusterBus`에 메시지를 발행(publish)하고,
+ *          모든 노드는 버스를 구독하여 다른 노드가 발행한 메시지를 자신의 세션에 전달합니다.
+ *          버스 구현은 교체 가능하며, 현재 프로세스 내부 버스(`InProcessBus`)와
+ *          로컬 TCP/Unix 소켓 브로커 기반 버스(`SocketBus`)를 제공합니다.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct ClusterMessage
+ * @brief 노드 간에 전달되는 단일 채팅 메시지.
+ * @details `origin_node`와 `msg_id`의 조합은 클러스터 전체에서 유일하며, 수신 측 중복 제거에 사용됩니다.
+ */
+struct ClusterMessage {
+    /// 메시지 종류
+    enum class Kind : std::uint8_t {
+        Global = 1,           ///< 전역 브로드캐스트
+        Room = 2,             ///< 채팅방 메시지를 소유 노드에 보내 팬아웃을 요청 (`target` = 방 이름)
+        Private = 3,          ///< 수신자가 접속한 노드에 직접 보내는 개인 메시지 (`target` = 수신자 닉네임)
+        RoomForward = 4,      ///< 소유 노드가 구독 노드에 전달하는 채팅방 메시지 (`target` = 방 이름)
+        Subscribe = 5,        ///< 소유 노드에 방 구독 요청 (`target` = 방 이름)
+        Unsubscribe = 6,      ///< 소유 노드에 방 구독 해지 요청 (`target` = 방 이름)
+        Heartbeat = 7,        ///< 노드 생존 알림 (멤버십 관리)
+        NickClaim = 8,        ///< 디렉터리 노드에 닉네임 선점 요청 (`target` = 닉네임)
+        NickClaimResult = 9,  ///< 선점 요청 결과 (`target` = 닉네임, `payload` = "granted" 또는 "denied")
+        NickRenew = 10,       ///< 디렉터리 노드에 닉네임 임대 갱신 (`payload` = 줄바꿈으로 구분한 닉네임 목록)
+        NickRelease = 11,     ///< 디렉터리 노드에 닉네임 임대 반납 (`target` = 닉네임)
+        PrivateLookup = 12,   ///< 수신자 위치를 모를 때 디렉터리 노드를 거쳐 보내는 개인 메시지 (`target` = 수신자 닉네임)
+        NickLocation = 13     ///< 디렉터리 노드의 위치 응답 (`target` = 닉네임, `payload` = 노드 ID, 없으면 빈 문자열)
+    };
+
+    Kind kind = Kind::Global;   ///< 메시지 종류
+    std::string origin_node;    ///< 메시지를 발행한 노드 ID
+    std::string target_node;    ///< 받을 노드 ID. 비어 있으면 발행 노드를 제외한 모든 노드
+    std::uint64_t msg_id = 0;   ///< 발행 노드 내에서 전달 순서대로 단조 증가하는 메시지 ID (버스가 붙임)
+    std::string target;         ///< 방 이름 또는 수신자 닉네임 (`Global`이면 빈 문자열)
+    std::string sender;         ///< 발신자 닉네임 (시스템 메시지는 "system")
+    std::string payload;        ///< 세션에 그대로 전달할 수 있도록 포맷이 끝난 메시지 본문
+
+    /**
+     * @brief 메시지 묶음(batch)을 하나의 바이너리 프레임 본문으로 직렬화합니다.
+     * @param batch 직렬화할 메시지 목록.
+     * @return 직렬화된 바이트열.
+     */
+    static std::string encode_batch(const std::vector<ClusterMessage>& batch);
+
+    /**
+     * @brief `encode_batch`로 만든 프레임 본문을 메시지 목록으로 복원합니다.
+     * @param frame 프레임 본문.
+     * @param[out] out 복원된 메시지가 뒤에 추가될 벡터.
+     * @return 프레임이 올바르면 true, 손상되었으면 false (이 경우 `out`은 부분적으로 채워질 수 있음).
+     */
+    static bool decode_batch(std::string_view frame, std::vector<ClusterMessage>& out);
+};
+
+/**
+ * @class ClusterDeduplicator
+ * @brief 발행 노드별 메시지 ID 창(window)을 유지하여 중복 수신을 걸러내는 클래스.
+ * @details 노드마다 "여기까지는 모두 받았다"는 하한(floor)과 그보다 큰 ID들의 집합을 유지합니다.
+ *          재연결이나 브로커 재전송으로 같은 메시지가 두 번 도착해도 한 번만 통과시킵니다.
+ *          스레드 안전하지 않으므로 호출자가 직렬화해야 합니다 (`ChatServer`에서는 strand 위에서 사용).
+ */
+class ClusterDeduplicator {
+public:
+    /**
+     * @brief 생성자.
+     * @param max_window 노드별로 기억할 비연속 ID의 최대 개수. 초과하면 가장 오래된 공백은 유실로 간주합니다.
+     */
+    explicit ClusterDeduplicator(std::size_t max_window = 4096) : max_window_(max_window) {}
+
+    /**
+     * @brief 메시지를 처음 보는 것인지 확인하고 기록합니다.
+     * @param origin 발행 노드 ID.
+     * @param msg_id 메시지 ID.
+     * @return 처음 보는 메시지이면 true, 중복이면 false.
+     */
+    bool accept(const std::string& origin, std::uint64_t msg_id);
+
+    /**
+     * @brief 특정 노드에 대한 기록을 제거합니다. (노드가 클러스터를 떠난 경우)
+     * @param origin 제거할 노드 ID.
+     */
+    void forget(const std::string& origin) { windows_.erase(origin); }
+
+private:
+    struct Window {
+        std::uint64_t floor = 0;        ///< 이 값 이하의 ID는 모두 수신 완료
+        std::set<std::uint64_t> above;  ///< floor 초과로 수신된 비연속 ID
+    };
+    std::unordered_map<std::string, Window> windows_;
+    std::size_t max_window_;
+};
+
+/**
+ * @class ClusterBus
+ * @brief 노드 간 메시지 버스의 추상 인터페이스.
+ * @details 구현체는 `publish`된 메시지를 `target_node`가 지정되면 그 노드에만,
+ *          비어 있으면 발행 노드를 제외한 모든 노드의 핸들러로 전달해야 합니다.
+ *          전달 순서는 발행 노드 단위로 보존되어야 하며, 중복 전달은 허용됩니다 (수신 측에서 제거).
+ *          `msg_id`는 구현체가 그 전달 순서대로 붙입니다. 수신 측 `ClusterDeduplicator`는 처음 본 ID 아래를
+ *          이미 받은 것으로 보므로, 여러 스레드에서 발행하더라도 ID와 전달 순서가 어긋나면 안 됩니다.
+ *          핸들러는 버스 내부 스레드에서 호출될 수 있으므로 수신 측에서 자체적으로 직렬화해야 합니다.
+ */
+class ClusterBus {
+public:
+    /// 수신 메시지 핸들러 타입
+    using Handler = std::function<void(const ClusterMessage&)>;
+
+    virtual ~ClusterBus() = default;
+
+    /**
+     * @brief 버스에 노드를 연결하고 수신을 시작합니다.
+     * @param node_id 이 노드의 클러스터 내 고유 ID.
+     * @param handler 다른 노드가 발행한 메시지를 받을 콜백.
+     */
+    virtual void start(const std::string& node_id, Handler handler) = 0;
+
+    /**
+     * @brief 메시지를 다른 노드(들)에 발행합니다.
+     * @param msg 발행할 메시지. 구현체에 따라 즉시 또는 묶음으로 전송됩니다. `origin_node`와 `msg_id`는 버스가 채웁니다.
+     */
+    virtual void publish(ClusterMessage msg) = 0;
+
+    /**
+     * @brief 버스 연결을 종료합니다. 이후 핸들러는 호출되지 않습니다.
+     */
+    virtual void stop() = 0;
+
+protected:
+    /// 첫 `msg_id` 직전 값. 노드가 다시 시작해도 이전 ID보다 크도록 현재 시각(마이크로초)을 씁니다.
+    static std::uint64_t initial_msg_id();
+};
+
+/**
+ * @class InProcessBusHub
+ * @brief 같은 프로세스 안의 여러 `InProcessBus`를 연결하는 허브.
+ * @details 테스트나 단일 호스트에서 여러 `ChatServer` 인스턴스를 띄울 때 사용합니다.
+ */
+class InProcessBusHub : public std::enable_shared_from_this<InProcessBusHub> {
+public:
+    /**
+     * @brief 노드를 허브에 등록합니다.
+     * @param node_id 노드 ID.
+     * @param handler 메시지 수신 콜백.
+     */
+    void attach(const std::string& node_id, ClusterBus::Handler handler);
+
+    /**
+     * @brief 노드를 허브에서 제거합니다.
+     * @param node_id 노드 ID.
+     */
+    void detach(const std::string& node_id);
+
+    /**
+     * @brief `target_node`에만, 또는 발행 노드를 제외한 모든 노드에 메시지를 전달합니다.
+     * @param msg 전달할 메시지.
+     */
+    void dispatch(const ClusterMessage& msg);
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, ClusterBus::Handler> nodes_;
+};
+
+/**
+ * @class InProcessBus
+ * @brief `InProcessBusHub`를 통해 같은 프로세스의 노드끼리 메시지를 주고받는 버스.
+ * @details 직렬화나 묶음 전송 없이 발행 즉시 다른 노드의 핸들러를 호출합니다.
+ *          ID를 붙이고 핸들러를 호출하는 동안 잠가 두므로 동시에 발행해도 ID 순서대로 전달됩니다.
+ */
+class InProcessBus : public ClusterBus {
+public:
+    /**
+     * @brief 생성자.
+     * @param hub 연결할 허브.
+     */
+    explicit InProcessBus(std::shared_ptr<InProcessBusHub> hub) : hub_(std::move(hub)) {}
+    ~InProcessBus() override { stop(); }
+
+    void start(const std::string& node_id, Handler handler) override;
+    void publish(ClusterMessage msg) override;
+    void stop() override;
+
+private:
+    std::shared_ptr<InProcessBusHub> hub_;
+    std::string node_id_;
+    std::mutex publish_mutex_;                    ///< ID를 붙이고 전달하는 순서를 맞춤
+    std::uint64_t last_msg_id_ = initial_msg_id(); ///< 마지막으로 붙인 ID (`publish_mutex_`로 보호)
+};
@@ -0,0 +1,70 @@
+/**
+ * @file HashRing.hpp
+ * @brief 가상 노드를 사용하는 일관된 해싱(consistent hashing) 링을 정의합니다.
+ * @details 채팅방 소유 노드 결정 등, 키를 노드에 고르게 분배하면서 노드가 추가/제거될 때
+ *          재배치되는 키를 최소화해야 하는 곳에서 사용합니다.
+ *          모든 노드가 같은 결과를 얻어야 하므로 해시 함수는 플랫폼과 무관하게 결정적입니다.
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+
+/**
+ * @class HashRing
+ * @brief 노드마다 여러 개의 가상 노드를 링 위에 배치하여 키의 소유 노드를 결정하는 클래스.
+ * @details 스레드 안전하지 않으므로 호출자가 직렬화해야 합니다.
+ */
+class HashRing {
+public:
+    /**
+     * @brief 생성자.
+     * @param virtual_nodes 노드 하나당 링에 배치할 가상 노드 수. 클수록 분배가 고르지만 메모리를 더 사용합니다.
+     */
+    explicit HashRing(std::size_t virtual_nodes = 128) : virtual_nodes_(virtual_nodes > 0 ? virtual_nodes : 1) {}
+
+    /**
+     * @brief 노드를 링에 추가합니다.
+     * @param node 노드 ID.
+     * @return 새로 추가되었으면 true, 이미 있으면 false.
+     */
+    bool add_node(const std::string& node);
+
+    /**
+     * @brief 노드를 링에서 제거합니다.
+     * @param node 노드 ID.
+     * @return 제거되었으면 true, 없던 노드이면 false.
+     */
+    bool remove_node(const std::string& node);
+
+    /// 노드가 링에 있는지 확인합니다.
+    bool contains(const std::string& node) const { return nodes_.count(node) > 0; }
+
+    /**
+     * @brief 키를 소유하는 노드를 반환합니다.
+     * @param key 채팅방 이름 등의 키.
+     * @return 소유 노드 ID. 링이 비어 있으면 빈 문자열.
+     */
+    std::string owner(std::string_view key) const;
+
+    /// 링에 있는 노드 목록
+    const std::set<std::string>& nodes() const { return nodes_; }
+
+    /// 링에 있는 노드 수
+    std::size_t size() const { return nodes_.size(); }
+
+    /**
+     * @brief 링에서 사용하는 64비트 해시 함수 (FNV-1a + splitmix64 마무리).
+     * @param data 해시할 바이트열.
+     * @return 해시 값.
+     */
+    static std::uint64_t hash(std::string_view data);
+
+private:
+    std::size_t virtual_nodes_;
+    std::set<std::string> nodes_;
+    std::map<std::uint64_t, std::string> ring_; ///< 가상 노드 해시 -> 노드 ID
+};
@@ -0,0 +1,235 @@
+/**
+ * @file HistoryReplication.hpp
+ * @brief 히스토리 기록 스트림을 팔로워 프로세스로 복제하는 `HistoryReplicator`(리더)와 `HistoryFollower`(팔로워)를 정의합니다.
+ * @details 리더는 `MessageHistory::set_append_listener`로 받은 기록에 순번을 붙여 묶음으로 보내고,
+ *          팔로워는 받은 기록을 자신의 `MessageHistory`에 그대로 추가한 뒤 마지막으로 적용한 순번을 확인 응답(ack)합니다.
+ *          리더는 확인받지 못한 기록을 `max_unacked`개까지 보관했다가 다시 접속하면 이어서 보냅니다.
+ *          같은 연결로 스크롤백/검색 질의를 보내 팔로워가 답하게 할 수 있으며, 질의는 앞서 보낸 기록 뒤에 처리되므로
+ *          리더에서 방금 기록한 메시지도 스크롤백 결과에 포함됩니다.
+ *          (검색 색인은 리더에서와 마찬가지로 잠시 뒤에 반영됩니다.)
+ *          프레임은 4바이트 big-endian 길이 접두사, 프레임 종류 1바이트, varint/문자열 필드로 구성됩니다.
+ *          주소 형식은 `parse_bus_endpoint`와 같습니다. (`tcp://<ip>:<port>`, `unix://<path>`)
+ */
+#pragma once
+
+#include "MessageHistory.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace net = boost::asio;
+
+/**
+ * @struct HistoryQuery
+ * @brief 팔로워에게 보내는 히스토리 읽기 질의.
+ */
+struct HistoryQuery {
+    enum class Kind : std::uint8_t {
+        Global = 0,   ///< 전역 기록의 마지막 `limit`줄
+        Room = 1,     ///< `room`의 마지막 `limit`줄
+        Private = 2,  ///< `user1`과 `user2`의 마지막 `limit`줄
+        Search = 3    ///< `nickname`이 `text`를 검색 (`room`이 있으면 그 방만), `offset`부터 `limit`개. 귓속말은 `private_since` 이후만
+    };
+    Kind kind = Kind::Global;
+    std::string room;
+    std::string user1;
+    std::string user2;
+    std::string text;
+    std::string nickname;
+    std::uint64_t offset = 0;
+    std::uint64_t limit = 0;
+    std::uint64_t private_since = 0;
+};
+
+/**
+ * @struct HistoryQueryResult
+ * @brief 질의 결과. 검색이 아니면 `total`은 `lines.size()`입니다.
+ */
+struct HistoryQueryResult {
+    std::uint64_t total = 0;
+    std::vector<std::string> lines;
+};
+
+/**
+ * @brief 질의를 `history`에서 실행합니다. 팔로워가 답할 때와 리더가 직접 읽을 때 모두 사용합니다.
+ */
+HistoryQueryResult run_history_query(MessageHistory& history, const HistoryQuery& query);
+
+/**
+ * @class HistoryReplicator
+ * @brief 리더 쪽 복제기. 팔로워에 접속해 기록을 보내고 질의를 전달합니다.
+ * @details 모든 상태는 하나의 strand에서만 다룹니다. 연결이 끊기면 1초 후 다시 접속하며,
+ *          그동안 쌓인 기록은 `max_unacked`개까지 보관합니다. 넘치면 가장 오래된 기록부터 버리고 경고합니다.
+ *          보내지 못한 기록을 버렸거나 팔로워가 보관 구간보다 뒤처진 채로 다시 접속하면 팔로워에 빠진 구간이 생긴 것이므로,
+ *          이 리더 프로세스가 끝날 때까지 `readable()`이 false가 되고 질의도 바로 실패합니다.
+ *          (팔로워는 멈춘 리더의 히스토리 디렉터리를 복사해 둘 다 다시 시작해야 합니다.)
+ */
+class HistoryReplicator : public std::enable_shared_from_this<HistoryReplicator> {
+public:
+    /// 질의 결과 콜백. 팔로워가 답하면 `ok`가 true, 연결이 없거나 시간이 지나면 false. 복제기의 strand에서 호출됩니다.
+    using QueryHandler = std::function<void(bool ok, HistoryQueryResult result)>;
+
+    /**
+     * @brief 생성자.
+     * @param ioc 복제기가 사용할 io_context.
+     * @param follower_uri 접속할 팔로워 주소.
+     * @param flush_interval 묶음 전송 대기 시간.
+     * @param max_batch 한 프레임에 담을 최대 기록 수.
+     * @param max_unacked 확인받지 못한 기록을 보관할 최대 개수.
+     */
+    HistoryReplicator(net::io_context& ioc,
+                      std::string follower_uri,
+                      std::chrono::milliseconds flush_interval = std::chrono::milliseconds(5),
+                      std::size_t max_batch = 256,
+                      std::size_t max_unacked = 100000);
+    ~HistoryReplicator();
+
+    /// 팔로워에 접속을 시작합니다.
+    void start();
+
+    /// 남은 기록을 보낸 뒤 연결을 닫습니다. 대기 중인 질의는 실패로 끝납니다.
+    void stop();
+
+    /// 기록 하나에 순번을 붙여 보냅니다. 어느 스레드에서나 호출할 수 있으며, 호출 순서가 전송 순서입니다.
+    void publish(const HistoryRecord& record);
+
+    /**
+     * @brief 팔로워에 질의를 보냅니다.
+     * @param query 질의.
+     * @param timeout 이 시간 안에 답이 없으면 `handler(false, {})`.
+     * @param handler 결과 콜백.
+     */
+    void query(HistoryQuery query, std::chrono::milliseconds timeout, QueryHandler handler);
+
+    /// 팔로워와 연결되어 이어 보낼 위치를 맞춘 상태인지 여부
+    bool ready() const { return ready_; }
+    /// 팔로워에 빠진 기록이 생겼는지 여부. 한 번 생기면 이 리더 프로세스 동안 유지됩니다.
+    bool has_gap() const { return gap_; }
+    /// 팔로워에 읽기를 맡겨도 되는지 여부 (연결되어 있고 빠진 구간이 없음)
+    bool readable() const { return ready_ && !gap_; }
+    /// 지금까지 붙인 마지막 순번
+    std::uint64_t last_seq() const { return last_seq_; }
+    /// 팔로워가 적용했다고 확인한 마지막 순번
+    std::uint64_t acked_seq() const { return acked_seq_; }
+
+private:
+    struct PendingQuery {
+        QueryHandler handler;
+        std::shared_ptr<net::steady_timer> timer;
+    };
+
+    void do_connect();
+    void on_connect(boost::system::error_code ec);
+    void schedule_reconnect();
+    void do_read_header();
+    void do_read_body(std::size_t length);
+    void on_frame(const std::string& body);
+    void on_ack(std::uint64_t seq);
+    void schedule_flush();
+    void flush();
+    void send(std::shared_ptr<const std::string> frame);
+    void do_write();
+    void fail_queries();
+    void mark_gap();
+    void close_socket();
+
+    net::strand<net::io_context::executor_type> strand_;
+    net::generic::stream_protocol::socket socket_;
+    net::steady_timer flush_timer_;
+    net::steady_timer reconnect_timer_;
+    std::string follower_uri_;
+    std::chrono::milliseconds flush_interval_;
+    std::size_t max_batch_;
+    std::size_t max_unacked_;
+
+    std::uint64_t epoch_;                                       ///< 이 리더 프로세스의 식별값 (재시작하면 바뀜)
+    std::deque<std::pair<std::uint64_t, HistoryRecord>> unacked_; ///< 순번 -> 기록 (확인받지 못한 것)
+    std::uint64_t next_send_seq_ = 1;                           ///< 아직 보내지 않은 첫 순번
+    std::atomic<std::uint64_t> last_seq_{0};
+    std::atomic<std::uint64_t> acked_seq_{0};
+    std::size_t dropped_ = 0;                                   ///< 보관 한도를 넘어 버린 기록 수
+    std::uint64_t next_query_id_ = 1;
+    std::map<std::uint64_t, PendingQuery> queries_;
+
+    std::deque<std::shared_ptr<const std::string>> write_queue_;
+    std::array<unsigned char, 4> header_{};
+    std::string body_;
+    bool connected_ = false;
+    std::atomic<bool> ready_{false};
+    std::atomic<bool> gap_{false};                              ///< 팔로워에 빠진 기록이 있음
+    bool writing_ = false;
+    bool flush_scheduled_ = false;
+    bool stopped_ = false;
+};
+
+/**
+ * @class HistoryFollower
+ * @brief 팔로워 쪽 서버. 리더의 기록을 자신의 `MessageHistory`에 적용하고 질의에 답합니다.
+ * @details 한 번에 리더 하나만 받습니다. 리더가 연결되어 있는 동안 다른 식별값의 리더가 인사하면 그 연결을 거절하고,
+ *          같은 식별값이면 (리더가 다시 접속한 것이므로) 이전 연결을 닫고 새 연결로 바꿉니다.
+ *          두 리더가 번갈아 연결을 빼앗으면 식별값이 바뀔 때마다 적용 위치가 되돌아가 기록이 중복되기 때문입니다.
+ *          마지막으로 적용한 (리더 식별값, 순번)을 `state_path`에 기록해 두므로, 팔로워를 다시 시작해도
+ *          리더가 보관 중인 기록부터 이어 받습니다. 기록 적용은 strand에서 순서대로, 질의는 io_context의
+ *          다른 스레드에서 실행합니다.
+ */
+class HistoryFollower : public std::enable_shared_from_this<HistoryFollower> {
+public:
+    /**
+     * @brief 생성자. 지정된 주소에 바인드하고 리슨을 시작합니다.
+     * @param ioc 팔로워가 사용할 io_context.
+     * @param listen_uri 리슨할 주소.
+     * @param history 복제 기록을 저장할 히스토리.
+     * @param state_path 적용 위치를 저장할 파일 경로.
+     * @throw boost::system::system_error 바인드/리슨 실패 시.
+     */
+    HistoryFollower(net::io_context& ioc, const std::string& listen_uri, MessageHistory& history, std::string state_path);
+    ~HistoryFollower();
+
+    /// 비동기 accept 루프를 시작합니다.
+    void run();
+
+    /// 리스닝을 중단하고 리더 연결을 닫습니다.
+    void stop();
+
+    /// 마지막으로 적용한 순번
+    std::uint64_t applied_seq() const { return applied_seq_; }
+
+private:
+    class Connection;
+    friend class Connection;
+
+    void do_accept();
+    void on_accept(boost::system::error_code ec, net::generic::stream_protocol::socket socket);
+    std::optional<std::uint64_t> on_hello(Connection& connection, std::uint64_t epoch);
+    std::uint64_t apply(std::vector<std::pair<std::uint64_t, HistoryRecord>>& records);
+    void load_state();
+    void save_state();
+
+    net::io_context& ioc_;
+    net::strand<net::io_context::executor_type> strand_;
+    net::basic_socket_acceptor<net::generic::stream_protocol> acceptor_;
+    MessageHistory& history_;
+    std::string state_path_;
+    std::string unix_path_;  ///< Unix 소켓으로 리슨하는 경우 종료 시 삭제할 경로
+    std::shared_ptr<Connection> leader_;                   ///< 인사를 받아들인 리더 연결
+    std::vector<std::weak_ptr<Connection>> connections_;  ///< 인사 전인 연결까지 포함한 모든 연결 (`stop`에서 닫음)
+    std::uint64_t epoch_ = 0;
+    std::atomic<std::uint64_t> applied_seq_{0};
+    bool stopped_ = false;
+};
@@ -0,0 +1,107 @@
+/**
+ * @file NicknameDirectory.hpp
+ * @brief 클러스터 전체의 닉네임 소유권을 임대(lease) 방식으로 관리하는 `NicknameDirectory`를 정의합니다.
+ * @details 각 닉네임은 `HashRing`으로 정해지는 디렉터리 노드가 관리합니다. 닉네임을 쓰려는 노드는
+ *          디렉터리 노드에 선점(claim)을 요청하고, 승인되면 일정 시간 동안 유효한 임대를 받습니다.
+ *          소유 노드는 주기적으로 임대를 갱신하며, 갱신이 끊긴 닉네임은 만료되어 다른 노드가 쓸 수 있습니다.
+ *          닉네임마다 디렉터리 노드가 다르므로 등록에 전역 잠금이 필요 없습니다.
+ *          조회 측은 알아낸 닉네임 위치를 임대 기간만큼 캐시하여 다음 개인 메시지를 소유 노드로 바로 보냅니다.
+ *          이 클래스는 네트워크 I/O 없이 상태만 관리하며, 실제 메시지 교환은 `ChatServer`가 담당합니다.
+ */
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+
+/**
+ * @class NicknameDirectory
+ * @brief 디렉터리 노드 측의 닉네임 임대 목록과 조회 측의 위치 캐시를 함께 보관하는 클래스.
+ * @details 스레드 안전하지 않으므로 호출자가 직렬화해야 합니다.
+ */
+class NicknameDirectory {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 생성자.
+     * @param lease_duration 임대 유효 기간. 위치 캐시의 유효 기간으로도 사용됩니다.
+     */
+    explicit NicknameDirectory(clock::duration lease_duration = std::chrono::seconds(3))
+        : lease_duration_(lease_duration) {}
+
+    /// 임대 유효 기간
+    clock::duration lease_duration() const { return lease_duration_; }
+
+    // --- 디렉터리 노드 측 ---
+
+    /**
+     * @brief 닉네임 선점을 시도합니다.
+     * @param nickname 닉네임.
+     * @param node 요청한 노드 ID.
+     * @param now 현재 시각.
+     * @return 비어 있거나, 임대가 만료되었거나, 이미 같은 노드가 가진 경우 true (임대 시작/연장).
+     */
+    bool claim(const std::string& nickname, const std::string& node, clock::time_point now);
+
+    /**
+     * @brief 닉네임 임대를 갱신합니다. 디렉터리가 모르는 닉네임이면 새로 등록합니다. (디렉터리 노드가 바뀐 경우)
+     * @return 다른 노드가 유효한 임대를 가지고 있어 갱신하지 못했으면 false.
+     */
+    bool renew(const std::string& nickname, const std::string& node, clock::time_point now);
+
+    /**
+     * @brief 닉네임 임대를 반납합니다. 다른 노드의 임대는 건드리지 않습니다.
+     */
+    void release(const std::string& nickname, const std::string& node);
+
+    /**
+     * @brief 닉네임의 현재 소유 노드를 반환합니다.
+     * @return 유효한 임대가 없으면 빈 문자열.
+     */
+    std::string holder(const std::string& nickname, clock::time_point now) const;
+
+    /**
+     * @brief 이 노드가 더 이상 디렉터리 노드가 아닌 닉네임의 임대를 버립니다. (링 변경 후)
+     * @param is_owner 닉네임의 디렉터리 노드가 이 노드인지 판별하는 함수.
+     */
+    void retain_owned(const std::function<bool(const std::string&)>& is_owner);
+
+    // --- 조회 측 위치 캐시 ---
+
+    /// 닉네임이 `node`에 있다는 사실을 임대 기간 동안 캐시합니다.
+    void cache_location(const std::string& nickname, const std::string& node, clock::time_point now);
+
+    /// 캐시된 닉네임 위치. 없거나 만료되었으면 빈 문자열.
+    std::string cached_location(const std::string& nickname, clock::time_point now) const;
+
+    /// 닉네임의 위치 캐시를 지웁니다.
+    void invalidate(const std::string& nickname) { cache_.erase(nickname); }
+
+    // --- 공통 ---
+
+    /**
+     * @brief 클러스터를 떠난 노드의 임대와 그 노드를 가리키는 캐시를 제거합니다.
+     */
+    void drop_node(const std::string& node);
+
+    /**
+     * @brief 만료된 임대와 캐시 항목을 정리합니다.
+     * @return 제거된 임대 수.
+     */
+    std::size_t expire(clock::time_point now);
+
+    /// 이 노드가 관리하는 유효/만료 전 임대 수
+    std::size_t lease_count() const { return leases_.size(); }
+
+private:
+    struct Entry {
+        std::string node;              ///< 소유 노드 ID
+        clock::time_point expires_at;  ///< 만료 시각
+    };
+
+    clock::duration lease_duration_;
+    std::map<std::string, Entry> leases_; ///< 디렉터리 노드로서 관리하는 닉네임 -> 임대
+    std::map<std::string, Entry> cache_;  ///< 조회로 알게 된 닉네임 -> 위치
+};
@@ -0,0 +1,123 @@
+/**
+ * @file RoomRouter.hpp
+ * @brief 클러스터에서 채팅방 소유 노드와 노드 간 전달(forwarding) 구독을 관리하는 `RoomRouter`를 정의합니다.
+ * @details 각 채팅방은 `HashRing`으로 정해지는 소유 노드(owner)를 가집니다.
+ *          다른 노드에 방 멤버가 있으면 그 노드는 소유 노드에 한 번만 구독하고,
+ *          방 메시지는 소유 노드를 거쳐 구독 노드마다 한 번씩만 전달됩니다.
+ *          따라서 노드 간 트래픽은 전체 노드 수가 아니라 (방, 노드) 쌍의 수에 비례합니다.
+ *          이 클래스는 네트워크 I/O 없이 상태만 관리하며, 실제 메시지 발행은 `ChatServer`가 담당합니다.
+ */
+#pragma once
+
+#include "cluster/HashRing.hpp"
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class RoomRouter
+ * @brief 클러스터 멤버십, 방 소유 노드, 방별 구독 노드를 추적하는 클래스.
+ * @details 스레드 안전하지 않으므로 호출자가 직렬화해야 합니다.
+ */
+class RoomRouter {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 생성자. 자기 자신은 항상 링에 포함됩니다.
+     * @param self_node 이 노드의 ID.
+     * @param virtual_nodes 노드당 가상 노드 수.
+     */
+    explicit RoomRouter(const std::string& self_node = "", std::size_t virtual_nodes = 128);
+
+    /// 이 노드의 ID
+    const std::string& self() const { return self_; }
+
+    // --- 멤버십 ---
+
+    /**
+     * @brief 다른 노드의 하트비트를 기록합니다.
+     * @param node 하트비트를 보낸 노드.
+     * @param now 수신 시각.
+     * @return 처음 보는 노드라서 링이 바뀌었으면 true.
+     */
+    bool observe_node(const std::string& node, clock::time_point now);
+
+    /**
+     * @brief 노드를 즉시 클러스터에서 제거합니다. (정상 종료 알림 등)
+     * @return 링이 바뀌었으면 true.
+     */
+    bool remove_node(const std::string& node);
+
+    /**
+     * @brief `timeout` 동안 하트비트가 없던 노드를 제거합니다.
+     * @return 제거된 노드 목록.
+     */
+    std::vector<std::string> expire_nodes(clock::time_point now, clock::duration timeout);
+
+    /// 현재 살아 있는 노드 목록 (자기 자신 포함)
+    const std::set<std::string>& nodes() const { return ring_.nodes(); }
+
+    // --- 방 소유 ---
+
+    /// 방의 소유 노드
+    std::string owner_of(const std::string& room) const { return ring_.owner(room); }
+
+    /// 이 노드가 방의 소유 노드인지 여부
+    bool is_owner(const std::string& room) const { return ring_.owner(room) == self_; }
+
+    // --- 구독 노드 측 (이 노드에 방 멤버가 있을 때) ---
+
+    /**
+     * @brief 이 노드에 방 멤버가 생겼음을 기록합니다.
+     * @param room 방 이름.
+     * @return 구독 요청을 보내야 할 소유 노드. 자기 자신이 소유자이거나 이미 추적 중이면 빈 문자열.
+     */
+    std::string track_local_room(const std::string& room);
+
+    /**
+     * @brief 이 노드에서 방 멤버가 모두 나갔음을 기록합니다.
+     * @param room 방 이름.
+     * @return 구독 해지 요청을 보내야 할 소유 노드. 필요 없으면 빈 문자열.
+     */
+    std::string untrack_local_room(const std::string& room);
+
+    /**
+     * @brief 링이 바뀐 뒤 로컬 방들의 소유 노드를 다시 계산합니다.
+     * @return 소유 노드가 바뀌어 새로 구독해야 하는 (방, 새 소유 노드) 목록. 자기 자신이 소유자가 된 방은 제외됩니다.
+     * @details 소유권을 잃은 방의 구독자 목록도 함께 정리합니다.
+     */
+    std::vector<std::pair<std::string, std::string>> rebalance();
+
+    /**
+     * @brief 특정 노드가 소유한 로컬 방 목록을 반환합니다. (소유 노드가 재시작되어 구독을 다시 보내야 할 때)
+     * @param node 소유 노드 ID.
+     */
+    std::vector<std::string> local_rooms_owned_by(const std::string& node) const;
+
+    // --- 소유 노드 측 ---
+
+    /// 다른 노드의 방 구독을 기록합니다.
+    void add_subscriber(const std::string& room, const std::string& node);
+
+    /// 다른 노드의 방 구독을 해지합니다.
+    void remove_subscriber(const std::string& room, const std::string& node);
+
+    /**
+     * @brief 방 메시지를 전달할 구독 노드 목록을 반환합니다.
+     * @param room 방 이름.
+     * @param exclude 제외할 노드 (메시지를 보낸 노드).
+     */
+    std::vector<std::string> subscribers(const std::string& room, const std::string& exclude = "") const;
+
+private:
+    std::string self_;
+    HashRing ring_;
+    std::map<std::string, clock::time_point> last_seen_;            ///< 다른 노드의 마지막 하트비트 시각
+    std::map<std::string, std::string> local_rooms_;                ///< 로컬 멤버가 있는 방 -> 마지막으로 계산한 소유 노드
+    std::map<std::string, std::set<std::string>> subscribers_;      ///< (소유 방) -> 구독 노드
+};
@@ -0,0 +1,150 @@
+/**
+ * @file SocketBus.hpp
+ * @brief TCP/Unix 소켓 기반의 로컬 브로커(`BusBroker`)와 그 클라이언트 버스(`SocketBus`)를 정의합니다.
+ * @details 각 노드의 `SocketBus`는 하나의 `BusBroker`에 접속하고, 브로커는 한 노드가 보낸 프레임을
+ *          대상 노드에게만, 또는 대상이 없으면 다른 모든 노드에 그대로 중계합니다.
+ *          프레임은 4바이트 big-endian 길이 접두사, 프레임 종류와 대상 노드로 된 라우팅 헤더,
+ *          `ClusterMessage::encode_batch`로 만든 메시지 묶음으로 구성됩니다.
+ *          주소 형식은 `tcp://<host>:<port>` 또는 `unix://<path>` 입니다.
+ */
+#pragma once
+
+#include "cluster/ClusterBus.hpp"
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace net = boost::asio;
+
+/**
+ * @brief 버스 주소 문자열을 소켓 엔드포인트로 변환합니다.
+ * @param uri `tcp://<host>:<port>` 또는 `unix://<path>` 형식의 주소.
+ * @return 변환된 엔드포인트.
+ * @throw std::invalid_argument 형식이 잘못된 경우.
+ */
+net::generic::stream_protocol::endpoint parse_bus_endpoint(const std::string& uri);
+
+/**
+ * @class BusBroker
+ * @brief 접속한 모든 `SocketBus` 노드 사이에서 프레임을 중계하는 브로커.
+ * @details 브로커는 라우팅 헤더만 읽고 메시지 묶음은 해석하지 않습니다. 대상 노드가 지정된 프레임은
+ *          그 노드에만, 나머지는 보낸 노드를 제외한 모든 노드의 쓰기 큐에 공유 버퍼로 넣습니다.
+ *          한 피어의 쓰기 큐가 `max_peer_queue_bytes`를 넘으면 (읽지 않는 느린 노드) 그 피어의 연결을 끊어
+ *          브로커 메모리가 한 노드 때문에 끝없이 늘지 않게 합니다. 모든 핸들러는 하나의 strand에서 실행됩니다.
+ */
+class BusBroker : public std::enable_shared_from_this<BusBroker> {
+public:
+    /**
+     * @brief 생성자. 지정된 주소에 바인드하고 리슨을 시작합니다.
+     * @param ioc 브로커가 사용할 io_context.
+     * @param listen_uri 리슨할 주소 (`parse_bus_endpoint` 형식).
+     * @param max_peer_queue_bytes 피어 하나에 쌓아 둘 수 있는 미전송 프레임의 최대 바이트 수.
+     * @throw boost::system::system_error 바인드/리슨 실패 시.
+     */
+    BusBroker(net::io_context& ioc, const std::string& listen_uri,
+              std::size_t max_peer_queue_bytes = 64 * 1024 * 1024);
+    ~BusBroker();
+
+    /// 비동기 accept 루프를 시작합니다.
+    void run();
+
+    /// 리스닝을 중단하고 모든 피어 연결을 닫습니다.
+    void stop();
+
+private:
+    class Peer;
+    friend class Peer;
+
+    void do_accept();
+    void on_accept(boost::system::error_code ec, net::generic::stream_protocol::socket socket);
+    void register_peer(const std::shared_ptr<Peer>& peer, const std::string& node_id);
+    void relay(const Peer* from, const std::string& target, std::shared_ptr<const std::string> frame);
+    void remove_peer(const std::shared_ptr<Peer>& peer);
+
+    net::strand<net::io_context::executor_type> strand_;
+    net::basic_socket_acceptor<net::generic::stream_protocol> acceptor_;
+    std::set<std::shared_ptr<Peer>> peers_;
+    std::map<std::string, std::shared_ptr<Peer>> peers_by_id_; ///< 노드 ID -> 피어 (단독 전달용)
+    std::string unix_path_;  ///< Unix 소켓으로 리슨하는 경우 종료 시 삭제할 경로
+    std::size_t max_peer_queue_bytes_;
+    bool stopped_ = false;
+};
+
+/**
+ * @class SocketBus
+ * @brief `BusBroker`에 접속하여 메시지를 묶음 단위로 주고받는 `ClusterBus` 구현체.
+ * @details `publish`된 메시지는 `flush_interval` 동안 또는 `max_batch`개가 모일 때까지 모았다가
+ *          대상 노드별 연속 구간마다 하나의 프레임으로 전송합니다. 접속 직후에는 `Hello` 프레임으로
+ *          자신의 노드 ID를 브로커에 알립니다. 브로커 연결이 끊기면 일정 시간 후 재접속하며,
+ *          연결이 없는 동안 발행된 메시지는 `max_pending`개까지 보관됩니다. 끊기기 전에 프레임으로 묶었지만
+ *          아직 다 쓰지 못한 프레임도 버리지 않고 재접속 후 다시 보냅니다 (브로커가 이미 받은 프레임이
+ *          한 번 더 전달될 수는 있습니다). 쓰기 큐는 `max_queued_bytes`까지만 쌓고 넘치면 오래된 프레임부터 버립니다.
+ */
+class SocketBus : public ClusterBus, public std::enable_shared_from_this<SocketBus> {
+public:
+    /**
+     * @brief 생성자.
+     * @param ioc 버스가 사용할 io_context.
+     * @param broker_uri 접속할 브로커 주소.
+     * @param flush_interval 묶음 전송 대기 시간.
+     * @param max_batch 한 프레임에 담을 최대 메시지 수.
+     */
+    SocketBus(net::io_context& ioc,
+              std::string broker_uri,
+              std::chrono::milliseconds flush_interval = std::chrono::milliseconds(5),
+              std::size_t max_batch = 256);
+    ~SocketBus() override;
+
+    void start(const std::string& node_id, Handler handler) override;
+    void publish(ClusterMessage msg) override;
+    void stop() override;
+
+private:
+    void do_connect();
+    void on_connect(boost::system::error_code ec);
+    void schedule_reconnect();
+    void do_read_header();
+    void do_read_body(std::size_t length);
+    void schedule_flush();
+    void flush();
+    void do_write();
+    void on_write(boost::system::error_code ec);
+    void enqueue(std::shared_ptr<const std::string> frame);
+    void close_socket();
+
+    net::strand<net::io_context::executor_type> strand_;
+    net::generic::stream_protocol::socket socket_;
+    net::steady_timer flush_timer_;
+    net::steady_timer reconnect_timer_;
+    std::string broker_uri_;
+    std::chrono::milliseconds flush_interval_;
+    std::size_t max_batch_;
+    static constexpr std::size_t max_pending_ = 10000;  ///< 연결이 없을 때 보관할 최대 메시지 수
+    static constexpr std::size_t max_queued_bytes_ = 64 * 1024 * 1024;  ///< 쓰기 큐에 쌓아 둘 최대 바이트 수
+
+    std::string node_id_;
+    std::uint64_t last_msg_id_ = initial_msg_id();           ///< 마지막으로 붙인 메시지 ID (strand에서 발행 순서대로 붙임)
+    Handler handler_;
+    std::vector<ClusterMessage> pending_;                    ///< 아직 프레임으로 묶이지 않은 메시지
+    std::deque<std::shared_ptr<const std::string>> write_queue_;  ///< 전송 대기 중인 프레임 (맨 앞은 쓰는 중일 수 있음)
+    std::size_t queued_bytes_ = 0;                           ///< `write_queue_`에 든 프레임의 바이트 합
+    std::array<unsigned char, 4> header_{};
+    std::string body_;
+    bool connected_ = false;
+    bool writing_ = false;
+    bool flush_scheduled_ = false;
+    bool stopped_ = false;
+};
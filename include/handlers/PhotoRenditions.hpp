@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file PhotoRenditions.hpp
+ * @brief 장소 사진 원본을 한 번 받아 크기 등급(`thumb`, `medium`, `full`)과 형식(JPEG, WebP)별 사본을 만들고 디스크에 보관한다.
+ *
+ * - 원본은 사진 참조마다 한 번만 Google에서 받고, 내용 해시(SHA-256)로 이름 붙여 저장한다. 같은 사진이 다른 참조로 와도 한 벌만 둔다.
+ *   디스크 캐시가 없으면 최근 원본 몇 개만 메모리에 둔다.
+ * - 축소/인코딩은 크기가 정해진 작업 큐와 전용 스레드에서 한다. (HTTP IO 스레드에서 디코딩하지 않음)
+ *   큐가 가득 차면 기다리지 않고 원본을 그대로 보낸다. (`Photo::fallback`, 클라이언트가 캐시하지 않도록 표시)
+ * - 원본이 목표 너비보다 작은 JPEG 요청에는 원본을 그대로 보내고 같은 내용의 사본 파일은 만들지 않는다.
+ * - JPEG 디코딩은 libjpeg-turbo의 DCT 단계 축소(1/2, 1/4, 1/8)로 필요한 크기에 가깝게 읽은 뒤 나머지만 면적 평균으로 줄인다.
+ * - 빌드에 libjpeg-turbo가 없으면 축소 없이 원본을, libwebp가 없으면 WebP 요청에 JPEG를 보낸다.
+ *
+ * 디스크 파일 (`cache_dir` 아래, 임시 파일에 쓴 뒤 이름을 바꿔 반쯤 쓴 파일을 읽지 않음):
+ * - `ref-<참조 해시>`: 원본 내용 해시와 Content-Type
+ * - `<내용 해시>.orig`: 원본
+ * - `<내용 해시>-<너비>.jpg|.webp`: 사본
+ *
+ * 합계가 `max_disk_bytes`를 넘으면 가장 오래 읽지 않은 파일부터 지운다.
+ * @see PlacesApiHandler::handlePlacePhoto
+ */
+
+/**
+ * @struct PhotoRenditionsConfig
+ * @brief `PhotoRenditions` 설정값
+ */
+struct PhotoRenditionsConfig {
+    std::string cache_dir;                       ///< 원본/사본을 둘 디렉터리. 비어 있으면 최근 원본만 메모리에 둠
+    std::size_t memory_originals = 32;           ///< `cache_dir`가 비어 있을 때 메모리에 둘 최근 원본 수
+    std::uint64_t max_disk_bytes = 512ull << 20; ///< 디스크 사용 상한 (넘으면 오래 읽지 않은 파일부터 지움)
+    std::size_t threads = 2;                     ///< 축소/인코딩 작업 스레드 수
+    std::size_t max_queue = 32;                  ///< 대기할 수 있는 최대 작업 수 (넘으면 원본을 보냄)
+    int jpeg_quality = 80;                       ///< 사본 JPEG 품질 (1-100)
+    int webp_quality = 75;                       ///< 사본 WebP 품질 (1-100)
+};
+
+/**
+ * @class PhotoRenditions
+ * @brief 장소 사진 사본 생성기 + 디스크 캐시. 스레드 안전하다.
+ */
+class PhotoRenditions {
+public:
+    enum class Format { Jpeg, Webp };
+
+    /// Google에서 받은 원본
+    struct Original {
+        std::string hash;           ///< 내용 해시 (hex)
+        std::string bytes;
+        std::string content_type;
+    };
+
+    /// 클라이언트에 보낼 사진
+    struct Photo {
+        std::string bytes;
+        std::string content_type;
+        std::string etag;           ///< 내용 해시 + 너비 + 형식 (따옴표 포함)
+        bool fallback = false;      ///< 요청한 사본을 만들지 못해 원본을 대신 보냄 (나중 요청은 사본을 받으므로 캐시하면 안 됨)
+    };
+
+    /// 사본 생성/디스크 캐시 통계 (메트릭용)
+    struct Metrics {
+        std::uint64_t disk_hits = 0;     ///< 디스크에 있던 사본으로 답한 수
+        std::uint64_t rendered = 0;      ///< 새로 만든 사본 수
+        std::uint64_t fallbacks = 0;     ///< 큐가 가득 찼거나 디코딩에 실패해 원본을 보낸 수
+        std::uint64_t evicted = 0;       ///< 디스크 한도 때문에 지운 파일 수
+        std::uint64_t disk_bytes = 0;    ///< 현재 디스크 사용량
+    };
+
+    explicit PhotoRenditions(PhotoRenditionsConfig config = {});
+
+    /// 대기 중인 작업을 버리고 스레드를 멈춘다. (기다리던 요청은 원본을 받음)
+    ~PhotoRenditions();
+
+    PhotoRenditions(const PhotoRenditions&) = delete;
+    PhotoRenditions& operator=(const PhotoRenditions&) = delete;
+
+    /// 크기 등급 이름을 목표 너비로 바꾼다. `thumb` 320, `medium` 800, `full` 0(원본 크기). 모르는 이름은 nullopt.
+    static std::optional<int> widthFor(const std::string& size_class);
+
+    /// 형식 이름(`jpeg`, `webp`)을 찾는다. 모르는 이름은 nullopt.
+    static std::optional<Format> parseFormat(const std::string& name);
+
+    /// 이 빌드가 사진을 축소할 수 있는지 (libjpeg-turbo)
+    static bool canResize();
+
+    /// 이 빌드가 `format`으로 인코딩할 수 있는지 (WebP는 libwebp)
+    static bool canEncode(Format format);
+
+    /**
+     * @brief 디스크에 있는 사본을 찾는다.
+     * @param width `widthFor`의 너비 (0이면 원본 크기)
+     * @return 사본(또는 원본 그대로 보내도 되는 요청이면 원본). 없으면 nullopt.
+     */
+    std::optional<Photo> lookup(const std::string& reference, int width, Format format);
+
+    /// 디스크(디스크 캐시가 없으면 메모리)에 있는 원본을 찾는다. 없으면 nullopt (Google에서 받아 `storeOriginal`로 넣어야 함).
+    std::optional<Original> original(const std::string& reference);
+
+    /// Google에서 받은 원본을 디스크(디스크 캐시가 없으면 메모리)에 넣고 내용 해시를 붙여 돌려준다.
+    Original storeOriginal(const std::string& reference, std::string bytes, std::string content_type);
+
+    /**
+     * @brief 원본으로 사본을 만들어 디스크에 넣고 돌려준다. 작업 스레드에서 만드는 동안 호출한 스레드는 기다린다.
+     * @note 축소할 수 없거나(코덱 없음, JPEG가 아님) 필요 없으면(원본이 더 작음) 원본을 돌려준다.
+     * 큐가 가득 찼거나 디코딩에 실패하면 `fallback`을 표시한 원본을 돌려준다.
+     */
+    Photo render(const Original& original, int width, Format format);
+
+    Metrics metrics() const;
+
+    const PhotoRenditionsConfig& config() const { return m_config; }
+
+private:
+    /// 디스크 파일 이름 (`cache_dir` 기준)
+    std::filesystem::path renditionPath(const std::string& hash, int width, Format format) const;
+    std::filesystem::path originalPath(const std::string& hash) const;
+    std::filesystem::path refPath(const std::string& reference) const;
+
+    /// 요청을 만족하는 파일이 원본 그대로인지 (원본 크기 JPEG, 또는 이 빌드가 축소할 수 없음)
+    bool servesOriginal(int width, Format format) const;
+    /// 이 빌드가 인코딩할 수 있는 형식으로 바꾼다. (WebP를 못 만들면 JPEG)
+    static Format effectiveFormat(Format format);
+
+    /// 파일을 읽고 수정 시각을 지금으로 바꾼다. (오래 읽지 않은 파일부터 지우기 위해)
+    std::optional<std::string> readFile(const std::filesystem::path& path);
+    /// 임시 파일에 쓴 뒤 이름을 바꾸고 디스크 사용량을 갱신한다. 실패하면 false.
+    bool writeFile(const std::filesystem::path& path, const std::string& data);
+    /// 수정 시각이 오래된 파일부터 한도의 90%까지 지운다. 호출 측이 `m_diskMutex`를 잡고 있어야 한다.
+    void evictLocked();
+    /// 디렉터리를 만들고, 남은 임시 파일을 지우고, 디스크 사용량을 센다.
+    void scanDisk();
+
+    /// 원본을 디코딩/축소/인코딩한다. (작업 스레드에서 호출) 실패하면 nullopt.
+    std::optional<std::string> encode(const Original& original, int width, Format format) const;
+
+    bool submit(std::function<void()> job);
+    void workerLoop();
+
+    static std::string sha256Hex(const std::string& data);
+    static std::string etagFor(const std::string& hash, int width, Format format);
+    static const char* contentTypeFor(Format format);
+
+    PhotoRenditionsConfig m_config;
+    std::filesystem::path m_dir;   ///< 비어 있으면 디스크 캐시 사용 안 함
+
+    mutable std::mutex m_diskMutex; ///< `m_diskBytes`와 지우기를 보호
+    std::uint64_t m_diskBytes = 0;
+    std::atomic<std::uint64_t> m_tmpCounter{0};
+
+    std::atomic<std::uint64_t> m_diskHits{0};
+    std::atomic<std::uint64_t> m_rendered{0};
+    std::atomic<std::uint64_t> m_fallbacks{0};
+    std::atomic<std::uint64_t> m_evicted{0};
+
+    std::mutex m_memoryMutex; ///< `m_memoryOriginals`/`m_memoryByRef` 보호
+    std::list<std::pair<std::string, Original>> m_memoryOriginals; ///< (참조, 원본), 최근에 쓴 것이 앞 (디스크 캐시가 없을 때)
+    std::unordered_map<std::string, std::list<std::pair<std::string, Original>>::iterator> m_memoryByRef;
+
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueCv;
+    std::deque<std::function<void()>> m_jobs;   ///< `m_queueMutex`로 보호
+    bool m_stopped = false;                     ///< `m_queueMutex`로 보호
+    std::vector<std::thread> m_workers;
+};
@@ -5,12 +5,24 @@
 #include <boost/beast/version.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <memory>
 #include <unordered_map>
 #include <chrono>
+#include <future>
 #include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "handlers/PlacesCache.hpp"
+#include "handlers/PlacesLocalIndex.hpp"
+#include "handlers/PhotoRenditions.hpp"
+#include "handlers/UpstreamGuard.hpp"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -18,6 +30,28 @@ namespace json = boost::json;
 namespace net = boost::asio;
 namespace ssl = boost::asio::ssl;
 
+/**
+ * @struct PlacesPrefetchConfig
+ * @brief 검색 결과 상위 장소의 상세 정보를 미리 받아 두는 기능의 설정값
+ */
+struct PlacesPrefetchConfig {
+    std::size_t top_k = 3;          ///< 검색 결과 중 미리 받을 장소 수 (0이면 사용 안 함)
+    std::size_t per_minute = 120;   ///< 분당 미리 받기 호출 예산 (Google API 할당량 보호)
+    double max_utilization = 0.5;   ///< 동시성 한도의 이 비율까지만 미리 받기에 사용 (나머지는 사용자 요청용)
+};
+
+/**
+ * @struct PlacesProjection
+ * @brief 클라이언트가 고를 수 있는 응답 필드 범위 (`summary`, `full`)
+ * @details 필드가 적을수록 Google 요금 등급이 낮고 응답도 작다. 캐시는 projection별로 따로 두며,
+ * 넓은 projection의 신선한 항목은 좁은 projection 요청에도 쓴다.
+ */
+struct PlacesProjection {
+    const char* name;             ///< 요청에서 쓰는 이름
+    const char* detailsFields;    ///< 상세 조회 `fields` 파라미터 (응답에 남길 최상위 필드이기도 함)
+    const char* searchFieldMask;  ///< 검색 요청 `X-Goog-FieldMask` 헤더
+};
+
 /**
  * @class PlacesApiHandler
  * @brief Google Places API 프록시 핸들러 클래스
@@ -30,21 +64,37 @@ public:
     /**
      * @brief 생성자
      * @param api_key Google Places API 키
+     * @param guard_config Google API 호출 앞에 두는 동시성 제한기/서킷 브레이커 설정
+     * @param cache_config 응답 캐시 설정 (soft/hard TTL, 스냅샷 경로)
+     * @param prefetch_config 검색 결과 상세 정보 미리 받기 설정
+     * @param local_config 검색 결과로 본 장소를 모아 Google 없이 답하는 로컬 색인 설정
+     * @param photo_config 장소 사진 크기별/형식별 사본 생성과 디스크 캐시 설정
      */
-    explicit PlacesApiHandler(const std::string& api_key);
+    explicit PlacesApiHandler(const std::string& api_key, UpstreamGuardConfig guard_config = {},
+                              PlacesCacheConfig cache_config = {}, PlacesPrefetchConfig prefetch_config = {},
+                              PlacesLocalIndexConfig local_config = {}, PhotoRenditionsConfig photo_config = {});
+
+    /**
+     * @brief 소멸자. 진행 중인 백그라운드 갱신을 기다린 뒤 캐시 스냅샷을 저장한다.
+     */
+    ~PlacesApiHandler();
 
     /**
      * @brief 주변 장소 검색 요청 처리
-     * @param req HTTP 요청 (JSON 형식의 body에 latitude, longitude, radius 포함)
+     * @param req HTTP 요청 (JSON 형식의 body에 latitude, longitude, radius, 선택적으로 projection(기본 `summary`) 포함)
      * @return HTTP 응답 (JSON 형식의 장소 목록)
+     *
+     * @note 요청한 원 안의 답을 로컬 색인이 빠짐없이 알고 있으면 Google을 호출하지 않는다. (`X-Places-Source: local`)
      */
     http::response<http::string_body> handleNearbySearch(
         const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req);
 
     /**
      * @brief 텍스트 기반 장소 검색 요청 처리
-     * @param req HTTP 요청 (JSON 형식의 body에 query, 선택적으로 latitude, longitude, radius 포함)
+     * @param req HTTP 요청 (JSON 형식의 body에 query, 선택적으로 latitude, longitude, radius, projection(기본 `summary`) 포함)
      * @return HTTP 응답 (JSON 형식의 장소 목록)
+     *
+     * @note 검색어에 맞는 신선한 장소를 로컬 색인에서 충분히 찾으면 Google을 호출하지 않는다.
      */
     http::response<http::string_body> handleTextSearch(
         const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req);
@@ -52,44 +102,132 @@ public:
     /**
      * @brief 장소 상세 정보 요청 처리
      * @param place_id 장소 ID (URL 경로에서 추출됨)
-     * @return HTTP 응답 (JSON 형식의 장소 상세 정보)
+     * @param projection 응답 필드 범위 이름 (`summary` 또는 `full`, URL 쿼리 `projection`에서 추출됨)
+     * @return HTTP 응답 (JSON 형식의 장소 상세 정보). 모르는 projection이면 400.
      * 
-     * @note 이 함수는 Google Places API의 장소 정보를 그대로 반환한다.
-     * 필요 시 응답 형식을 변환하는 로직을 추가할 수 있다.
+     * @note 이 함수는 Google Places API의 장소 정보 중 projection에 속한 필드만 반환한다.
      */
     http::response<http::string_body> handlePlaceDetails(
-        const std::string& place_id);
+        const std::string& place_id,
+        const std::string& projection = "full");
+
+    /**
+     * @brief 여러 장소의 상세 정보를 한 번에 조회
+     * @param req HTTP 요청 (JSON body: `{"ids": ["<placeId>", ...], "projection": "full"}`, 최대 `MAX_BATCH_IDS`개)
+     * @return HTTP 응답 (JSON: `{"places": [{"id", "status", "place" 또는 "error"}, ...]}`, 요청 순서 유지)
+     *
+     * @note 캐시에 있는 장소는 바로 채우고, 나머지는 `m_fanoutPool`에서 동시에 가져온다.
+     * 동시 호출 수는 `m_guard`의 동시성 한도를 따르며, 한도에 걸린 장소는 `BATCH_PERMIT_WAIT`까지 허가를 기다린다.
+     * 그래도 허가받지 못하거나 서킷이 열려 있으면 해당 항목만 503으로 표시한다.
+     * 응답 본문은 모든 장소가 준비된 뒤 한 번에 보내며, 그동안 호출한 HTTP IO 스레드는 기다린다.
+     */
+    http::response<http::string_body> handleBatchDetails(
+        const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req);
+
+    /**
+     * @brief 입력 중인 검색어의 자동 완성 요청 처리. Google을 호출하지 않는다.
+     * @param req HTTP 요청 (JSON body: `{"input": "스타", "latitude", "longitude", "limit"}`, 위치와 limit(기본 5, 최대 10)은 선택)
+     * @return HTTP 응답 (JSON: `{"suggestions": [{"id", "name", "addr", "loc", "distance"}, ...]}`, 점수 순)
+     *
+     * @note 지금까지 캐시에 들어온 검색/상세 응답의 장소 이름과 주소로 추천하며, 위치가 있으면 가까운 장소를,
+     * 그다음 리뷰가 많고 자주 검색된 장소를 앞에 둔다.
+     */
+    http::response<http::string_body> handleAutocomplete(
+        const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req);
 
     /**
      * @brief 장소 사진 요청 처리
      * @param photo_reference 사진 참조 ID (URL 경로에서 추출됨)
-     * @return HTTP 응답 (이미지 바이너리 데이터)
+     * @param size 크기 등급 (`thumb` 320px, `medium` 800px, `full` 원본). 모르는 이름이면 400
+     * @param format 형식 (`jpeg`, `webp`). 모르는 이름이면 400, 서버가 WebP를 만들 수 없으면 JPEG
+     * @param if_none_match 요청의 `If-None-Match` 헤더 (ETag가 같으면 304)
+     * @return HTTP 응답 (이미지 바이너리 데이터, `ETag`/`Cache-Control` 포함)
      * 
      * @note Google Places Photo API를 프록시하여 이미지를 반환한다.
      * 클라이언트에서 API 키가 노출되지 않도록 서버에서 중계한다.
+     * 원본은 사진마다 한 번만 받고(같은 사진을 동시에 요청해도 한 번), 크기/형식별 사본은 `PhotoRenditions`가 만들어 디스크에 둔다.
      */
     http::response<http::string_body> handlePlacePhoto(
-        const std::string& photo_reference);
+        const std::string& photo_reference,
+        const std::string& size = "full",
+        const std::string& format = "jpeg",
+        const std::string& if_none_match = "");
+
+    /**
+     * @brief Google API 호출 제한기/서킷 브레이커 상태를 Prometheus 텍스트 형식으로 반환
+     * @return HTTP 응답 (text/plain)
+     */
+    http::response<http::string_body> handleMetrics() const;
+
+    /**
+     * @brief 장소 목록 파일을 로컬 색인에 넣는다.
+     * @param path 한 줄에 검색 응답 장소 항목(`{"id", "name", "addr", "loc": {"lat", "lng"}, ...}`) 하나씩 있는 JSON-lines 파일
+     * @return 넣은 장소 수 (파일이 없으면 0)
+     * @note 가져온 장소는 텍스트 검색에만 쓴다. 주변 검색은 Google이 빠짐없이 돌려준 영역만 로컬에서 답한다.
+     */
+    std::size_t importLocalPlaces(const std::string& path);
+
+    /// 로컬 장소 색인 (테스트 및 메트릭용)
+    const PlacesLocalIndex& localIndex() const { return m_local; }
+
+    /// Google API 호출 제한기/서킷 브레이커 (테스트 및 메트릭용)
+    const UpstreamGuard& upstreamGuard() const { return m_guard; }
+
+    /// 이름으로 projection을 찾는다. 없으면 nullptr.
+    static const PlacesProjection* findProjection(const std::string& name);
+
+    /// Google Places API 호출 함수 (`callGooglePlacesApi`와 같은 인자와 반환 형식)
+    using UpstreamTransport = std::function<json::value(
+        http::verb, const std::string&, const json::value&, const std::string&)>;
+
+    /**
+     * @brief Google Places API를 실제로 호출하는 대신 `transport`를 쓴다. (테스트용, 요청을 처리하기 전에 설정)
+     * @note `m_guard`와 캐시는 그대로 거치므로 제한기/캐시/미리 받기 동작을 네트워크 없이 확인할 수 있다.
+     */
+    void setUpstreamTransport(UpstreamTransport transport) { m_transport = std::move(transport); }
 
 private:
     std::string m_apiKey; ///< Google Places API 키
+    UpstreamTransport m_transport; ///< 설정되면 `callGooglePlacesApi` 대신 사용 (테스트용)
     
-    // 캐시 구조체
-    struct CacheEntry {
-        json::value data;
-        std::chrono::steady_clock::time_point timestamp;
+    UpstreamGuard m_guard; ///< 모든 Google API 호출 앞에 두는 적응형 동시성 제한기 + 서킷 브레이커
+    PlacesCache m_cache; ///< 응답 캐시 (soft TTL이 지나면 오래된 응답을 보내고 백그라운드에서 갱신)
+    PlacesPrefetchConfig m_prefetch; ///< 상세 정보 미리 받기 설정
+    std::mutex m_prefetchMutex;
+    double m_prefetchTokens; ///< 남은 미리 받기 예산 (토큰 버킷, `m_prefetchMutex`로 보호)
+    std::chrono::steady_clock::time_point m_prefetchRefilled; ///< 마지막으로 예산을 채운 시각
+    std::atomic<std::uint64_t> m_prefetchStarted{0}; ///< 시작한 미리 받기 수
+    std::atomic<std::uint64_t> m_prefetchSkipped{0}; ///< 예산/한도 때문에 건너뛴 미리 받기 수
+    PlacesLocalIndex m_local; ///< 검색 결과로 본 장소의 위치/텍스트 색인 (Google보다 먼저 조회)
+    std::atomic<std::uint64_t> m_localHits{0}; ///< 로컬 색인으로 답한 검색 수
+    std::atomic<std::uint64_t> m_localMisses{0}; ///< 로컬 색인으로 답하지 못해 Google에 넘긴 검색 수
+    static constexpr std::size_t SEARCH_RESULT_COUNT = 5; ///< 검색 한 번에 돌려주는 최대 장소 수 (클라이언트가 5개만 표시)
+    std::atomic<std::uint64_t> m_autocompleteRequests{0}; ///< 자동 완성 요청 수
+    PhotoRenditions m_photos; ///< 장소 사진 크기별/형식별 사본 + 디스크 캐시
+    std::atomic<std::uint64_t> m_photoFetches{0}; ///< Google에서 사진 원본을 받은 수
+
+    /// 사진 원본 받기 결과
+    struct PhotoFetch {
+        std::optional<PhotoRenditions::Original> original; ///< 받았으면 원본
+        http::response<http::string_body> error;           ///< 못 받았으면 그대로 보낼 오류 응답
     };
-    
-    // 캐시 저장소 (키: 요청 파라미터의 해시, 값: 캐시된 응답)
-    std::unordered_map<std::string, CacheEntry> m_cache;
-    mutable std::mutex m_cacheMutex;
-    static constexpr auto CACHE_DURATION = std::chrono::minutes(5); // 캐시 유효 시간
+    std::mutex m_photoFetchMutex;
+    std::unordered_map<std::string, std::shared_future<PhotoFetch>> m_photoFetchesInFlight; ///< 참조 -> 진행 중인 원본 받기 (`m_photoFetchMutex`로 보호)
+    static constexpr std::size_t MAX_AUTOCOMPLETE_INPUT = 100; ///< 자동 완성 입력 최대 바이트 수
+    static constexpr std::size_t MAX_AUTOCOMPLETE_RESULTS = 10; ///< 자동 완성 최대 추천 수
+    static constexpr std::size_t MAX_BATCH_IDS = 20; ///< 배치 상세 조회 한 번에 받을 수 있는 최대 장소 수
+    static constexpr std::chrono::milliseconds BATCH_PERMIT_WAIT{3000}; ///< 배치 상세 조회가 `m_guard` 허가를 기다리는 최대 시간
+    net::thread_pool m_fanoutPool{8}; ///< 배치 상세 조회에서 캐시에 없는 장소를 동시에 가져오는 스레드
+    net::thread_pool m_backgroundPool{2}; ///< 캐시 갱신/미리 받기용 스레드 (HTTP IO 스레드를 막지 않음)
 
     /**
      * @brief Google Places API 요청 실행
      * @param method HTTP 메서드 (GET 또는 POST)
      * @param endpoint API 엔드포인트 URI
      * @param requestData 요청 데이터 (POST용)
+     * @param fieldMask POST 요청의 `X-Goog-FieldMask` (비어 있으면 `summary` projection의 마스크)
+     * @param[out] fetched 주어지면 이번 호출에서 Google이 200으로 답했는지 기록한다. (캐시에서 꺼낸 응답이면 false)
+     * @param permit_wait 동시성 한도에 걸렸을 때 `m_guard` 허가를 기다릴 최대 시간 (기본은 기다리지 않음)
      * @return API 응답 JSON 또는 오류 정보
      * 
      * @note 오류 발생 시 반환되는 JSON에는 "__error_status_code"와 "__error_body" 필드가 포함되며,
@@ -98,7 +236,121 @@ private:
     json::value requestGooglePlacesApi(
         http::verb method,
         const std::string& endpoint, 
-        const json::value& requestData);
+        const json::value& requestData,
+        const std::string& fieldMask = "",
+        bool* fetched = nullptr,
+        std::chrono::milliseconds permit_wait = std::chrono::milliseconds(0));
+
+    /**
+     * @brief `m_guard`의 허가 없이 Google Places API를 실제로 호출한다. (`fetchThroughGuard`에서만 사용)
+     * @return `requestGooglePlacesApi`와 같은 형식. 연결/TLS 오류 시 "error" 필드만 있는 객체.
+     */
+    json::value callGooglePlacesApi(
+        http::verb method,
+        const std::string& endpoint,
+        const json::value& requestData,
+        const std::string& fieldMask);
+
+    /**
+     * @brief `m_guard`를 거쳐 Google Places API를 호출한다. 허가받지 못하면 503 오류 객체를 돌려준다.
+     * @param[out] status_code 업스트림 상태 코드 (연결 오류는 0, 거절은 503)
+     * @param max_utilization 동시성 한도 중 이 비율까지만 사용 (백그라운드 작업용, `UpstreamGuard::tryAcquire` 참고)
+     * @param permit_wait 동시성 한도에 걸렸을 때 허가를 기다릴 최대 시간 (`UpstreamGuard::acquire` 참고)
+     */
+    json::value fetchThroughGuard(
+        http::verb method,
+        const std::string& endpoint,
+        const json::value& requestData,
+        const std::string& fieldMask,
+        int& status_code,
+        double max_utilization = 1.0,
+        std::chrono::milliseconds permit_wait = std::chrono::milliseconds(0));
+
+    /// 캐시 키 (메서드 + 엔드포인트, POST면 요청 본문과 필드 마스크 포함)
+    static std::string cacheKey(
+        http::verb method,
+        const std::string& endpoint,
+        const json::value& requestData,
+        const std::string& fieldMask = "");
+
+    /// 가장 넓은 projection (미리 받기용)
+    static const PlacesProjection& fullProjection();
+
+    /// 장소 상세 정보 요청 URL (`fields`가 projection에 맞춰짐)
+    static std::string detailsEndpoint(const std::string& place_id, const PlacesProjection& projection);
+
+    /// 캐시에서 신선한 상세 정보를 찾는다. 같은 projection이 없으면 더 넓은 projection 항목을 잘라 쓴다.
+    std::optional<json::value> cachedDetails(const std::string& place_id, const PlacesProjection& projection);
+
+    /// 같은 검색(POST)의 더 넓은 projection 응답이 캐시에 신선하게 있으면 좁은 projection에 맞춰 잘라 돌려준다.
+    std::optional<json::value> cachedWiderSearch(const std::string& endpoint, const json::value& requestData,
+                                                 const PlacesProjection& projection);
+
+    /// `cachedDetails`로 채울 수 없으면 Google Places API에서 가져온다. (`permit_wait`는 `requestGooglePlacesApi` 참고)
+    json::value fetchDetails(const std::string& place_id, const PlacesProjection& projection,
+                             std::chrono::milliseconds permit_wait = std::chrono::milliseconds(0));
+
+    /**
+     * @brief 검색 결과(`places` 배열) 상위 `top_k`개 장소의 상세 정보를 백그라운드에서 캐시에 받아 둔다.
+     * @param search_result `requestGooglePlacesApi`가 돌려준 검색 결과
+     */
+    void prefetchDetails(const json::value& search_result);
+
+    /// 미리 받기 예산에서 하나를 꺼낸다. 남은 예산이 없으면 false.
+    bool takePrefetchToken();
+
+    /**
+     * @brief Google이 방금 돌려준 주변 검색 결과(`places` 배열)로 빠짐없이 받은 원을 로컬 색인의 커버된 영역으로 기록한다.
+     * @note 장소 자체는 `cacheResponse`가 한 번만 넣는다. (두 번 넣으면 자동 완성 인기도가 두 번 오른다)
+     * @param radius 주변 검색 반경 (m)
+     */
+    void markNearbyCovered(const json::value& search_result, double latitude, double longitude, double radius);
+
+    /**
+     * @brief 업스트림 응답을 캐시에 저장하고 그 안의 장소를 로컬 색인에 넣는다. (캐시가 채워지는 만큼 자동 완성 색인도 자람)
+     */
+    void cacheResponse(const std::string& key, json::value data);
+
+    /**
+     * @brief 캐시에 저장된(저장할) 응답의 장소를 로컬 색인에 넣는다.
+     * @param key 캐시 키. 검색(POST)이면 `places` 배열을, 상세 조회(GET)면 장소 하나를 넣는다.
+     * 주변 검색 응답의 장소는 주변 검색에서 본 장소로 표시한다.
+     * @param stored 응답을 받은 시각 (로컬 색인의 신선도)
+     */
+    void ingestCachedResponse(const std::string& key, const json::value& data, PlacesCache::Clock::time_point stored);
+
+    /// 로컬 색인 결과를 검색 응답(`{"places": [...]}`)으로 만든다.
+    http::response<http::string_body> createLocalResponse(
+        const std::vector<PlacesLocalIndex::Hit>& hits,
+        bool detailed,
+        const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req);
+
+    /**
+     * @brief 캐시 항목을 백그라운드에서 갱신한다. 같은 키의 갱신이 이미 진행 중이면 아무것도 하지 않는다.
+     */
+    void scheduleRefresh(
+        const std::string& key,
+        http::verb method,
+        const std::string& endpoint,
+        const json::value& requestData,
+        const std::string& fieldMask);
+
+    /**
+     * @brief Google Places Photo API에서 사진 원본(최대 너비 1600px)을 받는다. 302 리다이렉트를 따라간다.
+     * @return 성공하면 200 응답(본문은 이미지, Content-Type은 업스트림 값), 아니면 그대로 보낼 오류 응답
+     */
+    http::response<http::string_body> fetchPhotoOriginal(const std::string& photo_reference);
+
+    /**
+     * @brief 사진 원본을 찾고, 없으면 Google에서 받아 `m_photos`에 넣는다.
+     * @note 같은 참조를 받는 중이면 새로 받지 않고 그 결과를 기다린다. (`PlacesCache::beginRefresh`처럼 키마다 한 번)
+     */
+    PhotoFetch loadPhotoOriginal(const std::string& photo_reference);
+
+    /// 사진 응답을 만든다. `if_none_match`에 사진의 ETag가 있으면 본문 없이 304. 대신 보낸 원본(`fallback`)은 캐시하지 않게 한다.
+    http::response<http::string_body> createPhotoResponse(
+        const PhotoRenditions::Photo& photo,
+        const std::string& if_none_match);
 
     /**
      * @brief 오류 응답 생성
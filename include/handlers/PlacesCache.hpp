@@ -0,0 +1,117 @@
+#pragma once
+
+#include <boost/json.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace json = boost::json;
+
+/**
+ * @file PlacesCache.hpp
+ * @brief Google Places 응답 캐시. soft/hard TTL로 오래된 응답을 바로 보내면서 뒤에서 갱신하고, 주기적으로 디스크에 저장한다.
+ *
+ * - soft TTL 안: 신선한 응답. 업스트림을 호출하지 않는다.
+ * - soft TTL ~ hard TTL: 오래된 응답을 바로 보내고, 호출 측이 백그라운드에서 갱신한다.
+ * - hard TTL 이후: 업스트림을 다시 호출해야 한다. 업스트림이 실패하거나 거절되었을 때만 대신 보낸다.
+ *
+ * 저장 시각은 `system_clock` 기준이므로 스냅샷을 다시 읽어도 나이가 이어진다.
+ * @see PlacesApiHandler
+ */
+
+/**
+ * @struct PlacesCacheConfig
+ * @brief `PlacesCache` 설정값
+ */
+struct PlacesCacheConfig {
+    std::chrono::seconds soft_ttl{std::chrono::hours(1)};   ///< 이 시간이 지나면 백그라운드 갱신
+    std::chrono::seconds hard_ttl{std::chrono::hours(24)};  ///< 이 시간이 지나면 업스트림을 다시 호출
+    std::size_t max_entries = 10000;                        ///< 보관할 최대 항목 수 (넘으면 오래된 것부터 버림)
+    std::string snapshot_path;                              ///< 스냅샷 파일 경로. 비어 있으면 디스크에 저장하지 않음
+    std::chrono::seconds snapshot_interval{std::chrono::minutes(5)}; ///< 스냅샷 저장 주기
+};
+
+/**
+ * @class PlacesCache
+ * @brief 요청 키별 Places 응답(JSON) 캐시. 스레드 안전하다.
+ */
+class PlacesCache {
+public:
+    using Clock = std::chrono::system_clock;
+
+    /// 조회 결과 상태
+    enum class State {
+        Miss,     ///< 없음
+        Fresh,    ///< soft TTL 안
+        Stale,    ///< soft TTL ~ hard TTL (바로 보내고 갱신)
+        Expired   ///< hard TTL 이후 (업스트림 실패 시에만 사용)
+    };
+
+    struct Lookup {
+        State state = State::Miss;
+        json::value data;
+        std::chrono::seconds age{0};
+    };
+
+    /// 생성자. `snapshot_path`가 있으면 스냅샷을 읽어 들이고 주기 저장 스레드를 시작한다.
+    explicit PlacesCache(PlacesCacheConfig config = {});
+
+    /// 주기 저장 스레드를 멈추고 마지막 스냅샷을 저장한다.
+    ~PlacesCache();
+
+    PlacesCache(const PlacesCache&) = delete;
+    PlacesCache& operator=(const PlacesCache&) = delete;
+
+    Lookup lookup(const std::string& key) const;
+
+    /// 응답을 저장한다. 저장 시각은 지금.
+    void put(const std::string& key, json::value data);
+
+    /// 같은 키의 백그라운드 갱신이 진행 중이 아니면 진행 중으로 표시하고 true를 돌려준다.
+    bool beginRefresh(const std::string& key);
+
+    /// `beginRefresh`로 표시한 갱신이 끝났음을 알린다.
+    void endRefresh(const std::string& key);
+
+    /// 스냅샷 파일에서 hard TTL이 지나지 않은 항목을 읽어 들인다. 파일이 없으면 false.
+    bool load();
+
+    /// 현재 항목을 스냅샷 파일에 저장한다. (임시 파일에 쓴 뒤 이름 변경) 경로가 없거나 실패하면 false.
+    bool save() const;
+
+    /// 주기 저장 스레드를 멈춘다. 저장은 하지 않는다.
+    void stop();
+
+    std::size_t size() const;
+
+    /// 모든 항목에 대해 `fn(키, 응답, 저장 시각)`을 부른다. 잠금을 잡은 채로 부르므로 `fn`에서 캐시를 쓰면 안 된다.
+    void forEach(const std::function<void(const std::string&, const json::value&, Clock::time_point)>& fn) const;
+
+    const PlacesCacheConfig& config() const { return m_config; }
+
+private:
+    struct Entry {
+        json::value data;
+        Clock::time_point stored;
+    };
+
+    /// 한도를 넘었으면 오래된 항목을 한 번에 10%씩 버린다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void evictLocked();
+    void snapshotLoop();
+
+    PlacesCacheConfig m_config;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::unordered_set<std::string> m_refreshing;   ///< 백그라운드 갱신 중인 키
+
+    std::mutex m_snapshotMutex;
+    std::condition_variable m_snapshotCv;
+    bool m_stopped = false;                          ///< `m_snapshotMutex`로 보호
+    std::thread m_snapshotThread;
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file PlacesLocalIndex.hpp
+ * @brief Google 검색 결과로 본 장소를 모아 두고, 충분히 알고 있는 지역/검색어는 Google 없이 답하는 로컬 장소 색인.
+ *
+ * - 위치: R-tree(Boost.Geometry)로 반경 검색. 주변 검색이 한 번 끝난 원(반경 안 장소를 빠짐없이 받은 영역)을
+ *   "커버된 영역"으로 기록하고, 새 주변 검색의 답이 커버된 영역 안에서만 정해지면 로컬에서 답한다.
+ * - 텍스트: 장소 이름/주소 단어의 3-gram 색인. 검색어의 모든 단어로 시작하는 단어를 가진 장소가 충분히 많으면 로컬에서 답한다.
+ * - 자동 완성: 같은 단어를 정렬된 맵에도 두고, 입력 중인 마지막 단어로 시작하는 단어 구간만 훑어 추천한다.
+ *
+ * 장소와 커버된 영역은 `max_age`가 지나면 답하는 데 쓰지 않는다. (Google 약관상 장기 보관 대상이 아님)
+ * @see PlacesApiHandler
+ */
+
+/**
+ * @struct PlacesLocalIndexConfig
+ * @brief `PlacesLocalIndex` 설정값
+ */
+struct PlacesLocalIndexConfig {
+    std::chrono::seconds max_age{std::chrono::hours(24)};   ///< 이보다 오래전에 본 장소/영역은 쓰지 않음 (0이면 로컬 응답 사용 안 함)
+    std::size_t max_places = 50000;                         ///< 보관할 최대 장소 수 (넘으면 오래된 것부터 버림)
+    std::size_t min_text_results = 5;                       ///< 텍스트 검색을 로컬에서 답하려면 필요한 최소 결과 수
+};
+
+/**
+ * @class PlacesLocalIndex
+ * @brief 장소 위치 R-tree + 이름/주소 3-gram 색인. 스레드 안전하다. (읽기는 공유 잠금)
+ */
+class PlacesLocalIndex {
+public:
+    using Clock = std::chrono::system_clock;
+
+    /// 색인에 넣는 장소 (검색 응답의 장소 항목과 같은 필드)
+    struct Place {
+        std::string id;
+        std::string name;
+        std::string address;
+        double latitude = 0;
+        double longitude = 0;
+        std::optional<double> rating;
+        std::optional<std::int64_t> rating_count;
+        std::string photo;              ///< 첫 사진 이름 (없으면 빈 문자열)
+        bool detailed = false;          ///< `full` projection으로 받아 평점/사진 필드가 채워졌는지
+        bool from_nearby = false;       ///< 주변 검색(음식점/카페 종류 제한)에서 본 장소인지
+        Clock::time_point seen{};       ///< 마지막으로 본 시각 (비어 있으면 `upsert`가 지금으로 채움)
+    };
+
+    /// 검색 결과 하나
+    struct Hit {
+        Place place;
+        double distance_m = 0;          ///< 검색 중심에서의 거리 (중심이 없으면 0)
+        double score = 0;               ///< 자동 완성 점수 (높을수록 먼저)
+    };
+
+    explicit PlacesLocalIndex(PlacesLocalIndexConfig config = {});
+
+    PlacesLocalIndex(const PlacesLocalIndex&) = delete;
+    PlacesLocalIndex& operator=(const PlacesLocalIndex&) = delete;
+
+    /// 장소를 넣거나 갱신한다. 기존 항목의 `from_nearby`/`detailed` 정보는 유지한다.
+    void upsert(Place place);
+
+    /**
+     * @brief 주변 검색이 중심에서 `radius_m` 안의 해당 종류 장소를 빠짐없이 돌려주었음을 기록한다.
+     * @details 결과 수가 요청한 최대 개수에 닿았으면 호출 측이 가장 먼 결과까지의 거리를 넘겨야 한다.
+     */
+    void markCovered(double latitude, double longitude, double radius_m);
+
+    /**
+     * @brief 주변 검색(거리순)을 로컬에서 답한다.
+     * @param detailed 평점/사진 필드가 필요한지 (`full` projection)
+     * @return 답이 커버된 영역 안에서 정해지고 모든 결과가 신선하면 거리순 결과, 아니면 nullopt (업스트림 호출 필요)
+     */
+    std::optional<std::vector<Hit>> nearby(double latitude, double longitude, double radius_m,
+                                           std::size_t limit, bool detailed) const;
+
+    /**
+     * @brief 텍스트 검색을 로컬에서 답한다.
+     * @param center 위치 편향 (위도, 경도). 없으면 전국 검색.
+     * @param radius_m `center`가 있을 때 결과를 제한할 반경
+     * @return 검색어의 모든 단어로 시작하는 단어를 이름/주소에 가진 신선한 장소가 `min_text_results`개 이상이면
+     *         (이름 일치 수, 거리) 순 결과, 아니면 nullopt
+     */
+    std::optional<std::vector<Hit>> search(const std::string& query,
+                                           std::optional<std::pair<double, double>> center, double radius_m,
+                                           std::size_t limit, bool detailed) const;
+
+    /**
+     * @brief 입력 중인 검색어로 장소 이름/주소를 추천한다. 업스트림을 호출하지 않는다.
+     * @param input 입력 중인 검색어. 마지막 단어는 입력 중인 접두어로, 앞 단어들도 단어 접두어로 맞춘다.
+     * @param center 사용자 위치 (위도, 경도). 있으면 가까운 장소를 앞에 둔다.
+     * @return 점수 순 결과. 점수는 이름 일치 비율 + 가까움(1km에서 0.5) + 인기도(평점 수, 검색 결과에 나온 횟수)
+     * @note 이름/주소는 자주 바뀌지 않으므로 `max_age`와 관계없이 색인에 남은 장소를 모두 쓴다.
+     */
+    std::vector<Hit> autocomplete(const std::string& input, std::optional<std::pair<double, double>> center,
+                                  std::size_t limit) const;
+
+    std::size_t size() const;
+
+    const PlacesLocalIndexConfig& config() const { return m_config; }
+
+    /// 두 좌표 사이의 거리(m, 구면 근사)
+    static double distanceMeters(double lat1, double lng1, double lat2, double lng2);
+
+    /// 색인 단어로 나눈다. (ASCII는 소문자로, 영숫자/비 ASCII 문자가 아닌 것은 구분자)
+    static std::vector<std::string> words(const std::string& text);
+
+private:
+    using Point = boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian>; ///< (경도, 위도)
+    using Box = boost::geometry::model::box<Point>;
+    using PointValue = std::pair<Point, std::uint32_t>;   ///< 장소 위치 -> `m_slots` 번호
+    using AreaValue = std::pair<Box, std::uint32_t>;      ///< 커버된 영역의 외접 사각형 -> `m_areas` 번호
+    using RtreeParams = boost::geometry::index::quadratic<16>;
+
+    struct Slot {
+        Place place;
+        std::vector<std::string> words;   ///< 이름 단어 다음에 주소 단어
+        std::size_t name_words = 0;       ///< `words` 중 이름에서 나온 단어 수
+        std::size_t postings = 0;         ///< 이 장소가 `m_postings`에 넣은 항목 수
+        std::uint32_t seen_count = 0;     ///< 검색 결과/응답에서 본 횟수 (자동 완성 인기도)
+        bool live = false;
+    };
+
+    struct Area {
+        double latitude;
+        double longitude;
+        double radius_m;
+        Clock::time_point seen;
+    };
+
+    bool isFresh(Clock::time_point seen, Clock::time_point now) const;
+    /// 중심에서 `reach_m` 안이 신선한 커버된 영역 하나에 모두 들어가는지. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    bool coveredLocked(double latitude, double longitude, double reach_m, Clock::time_point now) const;
+    /// 이름/주소를 단어로 나눠 3-gram 색인과 자동 완성 단어 맵에 넣는다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void indexLocked(std::uint32_t slot);
+    void postTrigramsLocked(std::uint32_t slot);
+    /// 자동 완성 단어 맵에서 슬롯을 뺀다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void removeTermsLocked(std::uint32_t slot);
+    void removeLocked(std::uint32_t slot);
+    /// 장소가 한도를 넘으면 오래된 것부터 10%를 버리고, 버린 장소가 들어 있던 커버된 영역도 버린다.
+    /// 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void evictLocked();
+    /// 지운 장소의 3-gram 항목이 많이 쌓이면 색인을 다시 만든다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void compactPostingsLocked();
+    /// 만료된 영역을 지우고 영역 R-tree를 다시 만든다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void compactAreasLocked(Clock::time_point now);
+    /// `kept`를 남은 영역으로 하여 영역 R-tree를 다시 만든다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void rebuildAreasLocked(std::vector<Area> kept);
+
+    /// 단어의 3-gram (앞에 공백 두 개를 붙여 단어 시작을 표시). 검색어 단어의 3-gram이 모두 있으면 그 단어로 시작할 수 있다.
+    static std::vector<std::string> trigrams(const std::string& word);
+    static Box boxAround(double latitude, double longitude, double radius_m);
+
+    PlacesLocalIndexConfig m_config;
+    mutable std::shared_mutex m_mutex;
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_freeSlots;
+    std::unordered_map<std::string, std::uint32_t> m_byId;   ///< 장소 ID -> `m_slots` 번호
+    boost::geometry::index::rtree<PointValue, RtreeParams> m_points;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> m_postings; ///< 3-gram -> 슬롯 (지운 장소 항목이 남을 수 있어 결과는 다시 확인)
+    std::size_t m_postingCount = 0;
+    std::size_t m_stalePostings = 0;
+    std::map<std::string, std::vector<std::uint32_t>> m_terms; ///< 단어 -> 슬롯 (접두어 검색을 위해 정렬)
+    std::vector<Area> m_areas;
+    boost::geometry::index::rtree<AreaValue, RtreeParams> m_areaTree;
+    std::size_t m_areaCompactAt = 1024;   ///< 영역이 이만큼 쌓이면 만료된 것을 정리
+
+    static constexpr std::size_t AUTOCOMPLETE_SCAN_LIMIT = 4096; ///< 자동 완성 한 번에 훑는 최대 후보 수 (짧은 접두어도 빠르게)
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file UpstreamGuard.hpp
+ * @brief Google API 같은 외부 업스트림 호출 앞에 두는 적응형 동시성 제한기와 서킷 브레이커.
+ *
+ * 동시에 진행 중인 업스트림 호출 수를 AIMD(가산 증가/승산 감소)로 조절한다.
+ * 응답이 빠르고 성공하면 한도를 천천히 늘리고, 429/5xx/연결 오류나 목표 지연을 넘는 응답이 오면 한도를 절반으로 줄인다.
+ * 최근 호출의 오류율이 임계값을 넘으면 서킷을 열어 일정 시간 업스트림을 호출하지 않고 바로 실패(또는 캐시 응답)하게 한다.
+ * @see PlacesApiHandler
+ */
+
+/**
+ * @struct UpstreamGuardConfig
+ * @brief `UpstreamGuard` 설정값
+ */
+struct UpstreamGuardConfig {
+    std::size_t initial_limit = 16;   ///< 시작 동시성 한도
+    std::size_t min_limit = 2;        ///< 줄일 수 있는 최소 한도
+    std::size_t max_limit = 64;       ///< 늘릴 수 있는 최대 한도
+    double backoff_ratio = 0.5;       ///< 혼잡 신호를 받았을 때 한도에 곱할 값
+    std::chrono::milliseconds latency_target{1500}; ///< 이보다 오래 걸린 성공 응답은 혼잡 신호로 본다
+    std::size_t window_size = 50;     ///< 오류율을 계산할 최근 호출 수
+    std::size_t min_calls = 10;       ///< 서킷을 열기 전에 필요한 최소 호출 수
+    double failure_threshold = 0.5;   ///< 이 오류율 이상이면 서킷을 연다
+    std::chrono::milliseconds open_duration{10000}; ///< 서킷을 연 뒤 시험 호출을 보내기까지 기다리는 시간
+};
+
+/**
+ * @class UpstreamGuard
+ * @brief 업스트림 호출 허가를 발급하고 결과를 받아 동시성 한도와 서킷 상태를 조절한다. 스레드 안전하다.
+ * @details 호출 측은 `tryAcquire()`(또는 기다리는 `acquire()`)로 허가를 받은 뒤 업스트림을 호출하고, 끝나면 반드시 `release()`로 결과를 알려야 한다.
+ * 서킷이 열린 동안에는 `open_duration`이 지날 때마다 시험 호출 하나만 허가하며(half-open),
+ * 시험 호출이 성공하면 서킷을 닫고 실패하면 다시 연다.
+ */
+class UpstreamGuard {
+public:
+    /// 호출 결과
+    enum class Outcome {
+        Success,   ///< 2xx 응답
+        Failure,   ///< 429, 5xx, 연결/TLS 오류 (업스트림 상태 문제)
+        Ignored    ///< 그 밖의 4xx (요청 자체의 문제이므로 한도/오류율에 반영하지 않음)
+    };
+
+    /// 서킷 상태
+    enum class CircuitState { Closed, Open, HalfOpen };
+
+    /// 허가 요청 결과
+    enum class Admission {
+        Admitted,     ///< 호출해도 됨
+        Overloaded,   ///< 동시성 한도에 걸림
+        CircuitOpen   ///< 서킷이 열려 있음
+    };
+
+    /// 한 번의 허가. `Admitted`일 때만 `release()`에 넘겨야 한다.
+    struct Permit {
+        Admission admission = Admission::Overloaded;
+        bool probe = false;   ///< half-open 상태의 시험 호출인지
+        std::chrono::steady_clock::time_point started;
+
+        bool admitted() const { return admission == Admission::Admitted; }
+    };
+
+    /// 현재 상태와 누적 카운터 (메트릭용)
+    struct Metrics {
+        double limit = 0;
+        std::size_t in_flight = 0;
+        CircuitState state = CircuitState::Closed;
+        double error_rate = 0;               ///< 최근 `window_size`개 호출 중 실패 비율
+        double latency_ewma_ms = 0;          ///< 성공 응답 지연의 지수 이동 평균
+        std::uint64_t admitted = 0;
+        std::uint64_t rejected_overload = 0;
+        std::uint64_t rejected_open = 0;
+        std::uint64_t successes = 0;
+        std::uint64_t failures = 0;
+        std::uint64_t circuit_opens = 0;
+    };
+
+    explicit UpstreamGuard(UpstreamGuardConfig config = {});
+
+    /**
+     * @brief 업스트림 호출 허가를 요청한다. 기다리지 않고 바로 결과를 돌려준다.
+     * @param max_utilization 동시성 한도 중 이 비율까지만 허가한다. 1보다 작으면 미리 받기 같은 백그라운드 작업으로 보고
+     *        서킷이 닫혀 있을 때만 허가한다. (시험 호출은 사용자 요청에 맡김)
+     */
+    Permit tryAcquire(double max_utilization = 1.0);
+
+    /**
+     * @brief 동시성 한도에 걸리면 다른 호출이 끝나기를 최대 `max_wait`까지 기다렸다가 허가를 요청한다.
+     * @details 서킷이 열려 있으면 기다리지 않고 바로 돌려준다. 나머지는 `tryAcquire`와 같다.
+     */
+    Permit acquire(std::chrono::milliseconds max_wait, double max_utilization = 1.0);
+
+    /// 허가받은 호출이 끝났음을 알린다.
+    void release(const Permit& permit, Outcome outcome);
+
+    /// HTTP 상태 코드(연결 실패는 0)를 호출 결과로 분류한다.
+    static Outcome classify(int status_code);
+
+    Metrics metrics() const;
+
+    /// 메트릭을 Prometheus 텍스트 형식으로 만든다. 각 이름 앞에 `prefix`를 붙인다.
+    std::string metricsText(const std::string& prefix) const;
+
+    static const char* toString(CircuitState state);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// 허가 여부를 정한다. 거절 카운터는 세지 않는다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    Permit admit(Clock::time_point now, double max_utilization);
+    /// 서킷을 연다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void openCircuit(Clock::time_point now);
+    /// 최근 호출 기록에 결과를 넣는다. 호출 측이 `m_mutex`를 잡고 있어야 한다.
+    void record(bool failed);
+    double errorRate() const;
+
+    UpstreamGuardConfig m_config;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;   ///< 허가가 반납되면 `acquire`에서 기다리는 호출을 깨운다
+    double m_limit;
+    std::size_t m_inFlight = 0;
+    CircuitState m_state = CircuitState::Closed;
+    Clock::time_point m_openedAt{};
+    bool m_probeInFlight = false;
+    Clock::time_point m_lastDecrease{};   ///< 한 번의 혼잡에 여러 번 줄이지 않도록 마지막 감소 시각
+    std::vector<bool> m_window;           ///< 최근 호출 결과 (true = 실패), 원형 버퍼
+    std::size_t m_windowNext = 0;
+    std::size_t m_windowFailures = 0;
+    double m_latencyEwmaMs = 0;
+    Metrics m_counters;                   ///< 누적 카운터만 사용
+};
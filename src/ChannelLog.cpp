@@ -0,0 +1,162 @@
+/**
+ * @file ChannelLog.cpp
+ * @brief `ChannelLog` 클래스의 구현부입니다.
+ */
+
+#include "ChannelLog.hpp"
+
+#include <random>
+
+namespace {
+    std::string to_hex(std::uint64_t value)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string out;
+        do {
+            out.insert(out.begin(), digits[value & 0xF]);
+            value >>= 4;
+        } while (value != 0);
+        return out;
+    }
+}
+
+/**
+ * @details 에포크는 시각과 무작위 값으로 정해, 같은 초에 교체된 후속 프로세스와도 겹치지 않게 합니다.
+ */
+ChannelLog::ChannelLog(std::size_t capacity, std::chrono::steady_clock::duration idle_ttl)
+    : capacity_(capacity == 0 ? 1 : capacity),
+      idle_ttl_(idle_ttl),
+      last_sweep_(std::chrono::steady_clock::now())
+{
+    std::random_device random;
+    auto now = static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    // 채널마다 더하는 세대 값이 넘치지 않도록 위쪽 비트만 쓴다.
+    epoch_base_ = ((now ^ (static_cast<std::uint64_t>(random()) << 32) ^ random()) & 0xFFFFFFFFFFull) << 20;
+}
+
+/**
+ * @details 새 채널을 만들 때 가끔(`idle_ttl_`마다 한 번) 쓰이지 않는 채널을 정리합니다.
+ *          맵이 자라는 것은 새 채널이 생길 때뿐이므로 정리도 그때만 하면 됩니다.
+ */
+std::shared_ptr<ChannelLog::Channel> ChannelLog::find_channel(const std::string &channel, bool create) const
+{
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    auto it = channels_.find(channel);
+    if (it != channels_.end())
+        return it->second;
+    if (!create)
+        return nullptr;
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_sweep_ >= idle_ttl_) {
+        last_sweep_ = now;
+        evict_idle(now);
+    }
+    auto state = std::make_shared<Channel>();
+    state->epoch = to_hex(epoch_base_ + next_generation_++);
+    state->last_used = now;
+    channels_.emplace(channel, state);
+    return state;
+}
+
+/**
+ * @details 채널 잠금을 잡고 있는 스레드가 `channels_mutex_`를 기다릴 수 있으므로 채널 잠금은 `try_lock`으로만 잡습니다.
+ *          다른 곳에서 아직 들고 있는 채널(진행 중인 `append`/`since`)은 건너뜁니다.
+ */
+void ChannelLog::evict_idle(std::chrono::steady_clock::time_point now) const
+{
+    for (auto it = channels_.begin(); it != channels_.end();) {
+        auto &state = it->second;
+        bool idle = false;
+        if (state.use_count() == 1 && state->mutex.try_lock()) {
+            idle = state->entries.empty() && now - state->last_used >= idle_ttl_;
+            state->mutex.unlock();
+        }
+        it = idle ? channels_.erase(it) : std::next(it);
+    }
+}
+
+/**
+ * @details 순번 발급, 로그 추가, 전달을 하나의 채널 잠금 안에서 처리합니다.
+ *          잠금 밖에서 전달하면 두 발신자가 받은 순번과 실제 전달 순서가 뒤바뀔 수 있습니다.
+ */
+std::uint64_t ChannelLog::append(const std::string &channel, const std::string &message,
+                                 const std::function<void(std::uint64_t, const std::string &)> &deliver)
+{
+    auto state = find_channel(channel, true);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    std::uint64_t seq = ++state->last_seq;
+    std::string stamped = stamp(channel, state->epoch, seq, message);
+    if (deliver)
+        deliver(seq, stamped);
+    state->entries.push_back(Entry{seq, std::move(stamped)});
+    while (state->entries.size() > capacity_)
+        state->entries.pop_front();
+    state->last_used = std::chrono::steady_clock::now();
+    return seq;
+}
+
+ChannelLog::Replay ChannelLog::since(const std::string &channel, const std::string &epoch, std::uint64_t after_seq) const
+{
+    Replay replay;
+    auto state = find_channel(channel, false);
+    if (!state) {
+        replay.epoch = to_hex(epoch_base_);
+        return replay;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    replay.last_seq = state->last_seq;
+    replay.epoch = state->epoch;
+    if (epoch != state->epoch || after_seq > state->last_seq)
+        after_seq = 0; // 다른 실행(또는 정리되기 전 채널)의 순번: 처음부터 다시 보낸다.
+    if (after_seq == state->last_seq)
+        return replay;
+
+    std::uint64_t first_retained = state->entries.empty() ? state->last_seq + 1 : state->entries.front().seq;
+    if (after_seq + 1 < first_retained)
+        replay.missing = first_retained - after_seq - 1;
+
+    // 순번은 연속이므로 시작 위치를 바로 계산할 수 있다.
+    std::size_t start = after_seq + 1 > first_retained ? static_cast<std::size_t>(after_seq + 1 - first_retained) : 0;
+    replay.entries.assign(state->entries.begin() + static_cast<std::ptrdiff_t>(start), state->entries.end());
+    return replay;
+}
+
+std::uint64_t ChannelLog::last_seq(const std::string &channel) const
+{
+    auto state = find_channel(channel, false);
+    if (!state)
+        return 0;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->last_seq;
+}
+
+std::string ChannelLog::epoch(const std::string &channel) const
+{
+    auto state = find_channel(channel, false);
+    if (!state)
+        return to_hex(epoch_base_);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->epoch;
+}
+
+void ChannelLog::drop_entries(const std::string &channel)
+{
+    auto state = find_channel(channel, false);
+    if (!state)
+        return;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->entries.clear();
+    state->last_used = std::chrono::steady_clock::now();
+}
+
+std::size_t ChannelLog::channel_count() const
+{
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    return channels_.size();
+}
+
+std::string ChannelLog::stamp(const std::string &channel, const std::string &epoch, std::uint64_t seq, const std::string &message)
+{
+    return "#" + channel + ":" + epoch + "." + std::to_string(seq) + " " + message;
+}
@@ -9,7 +9,7 @@
 #include <algorithm>
 #include <memory>
 #include <mutex>
-#include <set>
+#include <unordered_set>
 #include <string>
 #include <vector>
 
@@ -24,37 +24,97 @@ ChatRoom::ChatRoom(const std::string &name)
 }
 
 /**
- * @details 채팅방이 가득 차지 않았는지 확인한 후, `participants_` 셋에 세션을 추가합니다.
- *          세션 객체 자체에도 현재 참여 중인 방의 이름을 기록합니다.
- *          입장 사실을 자신을 포함한 모든 참여자에게 브로드캐스트합니다.
+ * @details 채팅방이 가득 차지 않았는지 확인한 후, `participants_` 셋과 명단에 세션을 추가합니다.
+ *          입장 알림은 `ChatServer`가 명단 버전과 함께 보냅니다.
  */
-void ChatRoom::join(SessionPtr participant) {
+bool ChatRoom::join(SessionPtr participant) {
   if (participants_.size() >= max_participants_) {
     participant->deliver("Error: 방 '" + name_ + "'이(가) 꽉 찼습니다.\r\n");
-    return;
+    return false;
+  }
+  if (!participants_.insert(participant).second) {
+    return true;
   }
-  participants_.insert(participant);
-  participant->set_current_room(name_); // 세션에 현재 방 정보 업데이트
+  roster_index_[participant.get()] = roster_.size();
+  roster_.emplace_back(participant.get(), participant->nickname());
+  ++roster_version_;
+  roster_pages_.clear();
+  return true;
+}
 
-  std::string join_msg =
-      "* " + participant->nickname() + "님이 '" + name_ + "' 방에 입장했습니다.\r\n";
-  broadcast(join_msg, nullptr); // 방의 모든 참여자에게 입장 사실 알림
+/**
+ * @details 같은 사용자가 계속 참여 중인 것이므로 다른 참여자에게 아무것도 알리지 않으며, 최대 인원 검사도 하지 않습니다.
+ */
+bool ChatRoom::replace_participant(const SessionPtr &from, const SessionPtr &to) {
+  if (participants_.erase(from) == 0) {
+    return false;
+  }
+  participants_.insert(to);
+  auto index_it = roster_index_.find(from.get());
+  if (index_it != roster_index_.end()) {
+    std::size_t index = index_it->second;
+    roster_index_.erase(index_it);
+    roster_[index].first = to.get();
+    roster_index_[to.get()] = index;
+  }
+  return true;
 }
 
 /**
  * @details `participants_` 셋에서 해당 세션을 제거합니다.
- *          성공적으로 제거되면, 세션의 현재 방 정보를 초기화하고,
- *          퇴장 사실을 남은 모든 참여자에게 브로드캐스트합니다.
+ *          명단에서는 마지막 항목을 빈 자리로 옮겨 상수 시간에 지웁니다. 퇴장 알림은 `ChatServer`가 보냅니다.
  */
 void ChatRoom::leave(SessionPtr participant) {
-  size_t erased_count = participants_.erase(participant);
-  if (erased_count > 0) {
-    participant->set_current_room(""); // 세션의 방 정보 클리어
+  if (participants_.erase(participant) == 0) {
+    return;
+  }
+  auto index_it = roster_index_.find(participant.get());
+  if (index_it == roster_index_.end()) {
+    return;
+  }
+  std::size_t index = index_it->second;
+  roster_index_.erase(index_it);
+  if (index + 1 != roster_.size()) {
+    roster_[index] = std::move(roster_.back());
+    roster_index_[roster_[index].first] = index;
+  }
+  roster_.pop_back();
+  ++roster_version_;
+  roster_pages_.clear();
+}
 
-    std::string leave_msg =
-        "* " + participant->nickname() + "님이 '" + name_ + "' 방에서 나갔습니다.\r\n";
-    broadcast(leave_msg, nullptr); // 방에 남아있는 참여자들에게 퇴장 사실 알림
+bool ChatRoom::rename_participant(const SessionPtr &participant, const std::string &nickname) {
+  auto index_it = roster_index_.find(participant.get());
+  if (index_it == roster_index_.end()) {
+    return false;
   }
+  if (roster_[index_it->second].second != nickname) {
+    roster_[index_it->second].second = nickname;
+    ++roster_version_;
+    roster_pages_.clear();
+  }
+  return true;
+}
+
+const std::string &ChatRoom::roster_page(std::size_t page) const {
+  static const std::string empty_page;
+  if (page == 0 || page > roster_page_count()) {
+    return empty_page;
+  }
+  auto cached = roster_pages_.find(page);
+  if (cached != roster_pages_.end()) {
+    return cached->second;
+  }
+  std::string names;
+  std::size_t begin = (page - 1) * roster_page_size;
+  std::size_t end = std::min(begin + roster_page_size, roster_.size());
+  for (std::size_t i = begin; i < end; ++i) {
+    if (i != begin) {
+      names += ", ";
+    }
+    names += roster_[i].second;
+  }
+  return roster_pages_.emplace(page, std::move(names)).first->second;
 }
 
 /**
@@ -64,31 +124,34 @@ void ChatRoom::leave(SessionPtr participant) {
  * @note `sender`가 `nullptr`인 경우, 시스템 메시지로 간주하여 모든 참여자에게 전송됩니다.
  */
 void ChatRoom::broadcast(const std::string &message, SessionPtr sender) {
+  deliver_formatted(format_message(message, sender ? sender->nickname() : "system"), sender);
+}
+
+std::string ChatRoom::format_message(const std::string &message, const std::string &sender_nick) const {
   // 방 이름을 포함하도록 메시지 포맷팅 (이 부분은 서버 로직에 따라 변경될 수 있음)
-  std::string formatted_message;
-    if (message.find("*") == 0) { // 시스템 메시지인 경우
-        formatted_message = message;
-    } else {
-        formatted_message = "[" + (sender ? sender->nickname() : "system") + " @ " + name_ + "]: " + message + "\r\n";
-    }
+  if (message.find("*") == 0) { // 시스템 메시지인 경우
+    return message;
+  }
+  return "[" + sender_nick + " @ " + name_ + "]: " + message + "\r\n";
+}
 
+void ChatRoom::deliver_formatted(const std::string &formatted_message, const SessionPtr &exclude) {
   for (const auto &participant : participants_) {
-    // sender가 nullptr (시스템 메시지) 이거나, participant가 sender가 아닌 경우에만 전송
-    if (participant != sender) {
+    // exclude가 nullptr (시스템 메시지) 이거나, participant가 exclude가 아닌 경우에만 전송
+    if (participant != exclude) {
       participant->deliver(formatted_message);
     }
   }
 }
 
 /**
- * @details `participants_` 셋을 순회하며 각 세션의 `nickname()`을 호출하여
- *          닉네임 목록을 `std::vector<std::string>` 형태로 만들어 반환합니다.
+ * @details 세션마다 `nickname()`을 호출하지 않고 명단에 저장된 닉네임을 그대로 복사합니다.
  */
 std::vector<std::string> ChatRoom::get_participant_nicknames() const {
   std::vector<std::string> nicknames;
-  nicknames.reserve(participants_.size());
-  for (const auto &p : participants_) {
-    nicknames.push_back(p->nickname());
+  nicknames.reserve(roster_.size());
+  for (const auto &entry : roster_) {
+    nicknames.push_back(entry.second);
   }
   return nicknames;
 }
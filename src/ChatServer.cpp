@@ -10,6 +10,9 @@
 #include "ChatRoom.hpp"
 #include "MessageHistory.hpp"
 #include "WebSocketSession.hpp"
+#include "ParkedSession.hpp"
+#include "FileSpool.hpp"
+#include "cluster/HistoryReplication.hpp"
 #include "spdlog/spdlog.h"
 
 #include <memory>
@@ -17,13 +20,47 @@
 #include <atomic>
 #include <vector>
 #include <map>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cstdio>
+#include <filesystem>
 
 #include <boost/asio/dispatch.hpp>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
 
 namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
 namespace beast = boost::beast;
 
+namespace {
+    /// drain 시 세션 묶음을 닫는 간격
+    constexpr std::chrono::milliseconds drain_interval{100};
+    /// `/since` 요청 한 번에 히스토리에서 읽어 보낼 최대 줄 수
+    constexpr std::uint64_t max_history_replay = 500;
+    /// 등록할 수 있는 사용자명의 최대 길이
+    constexpr std::size_t max_username_length = 32;
+    /// 받아들이는 비밀번호의 최대 길이 (해시 계산 비용 제한)
+    constexpr std::size_t max_password_length = 1024;
+    /// 재접속 토큰의 난수 바이트 수 (16진수로 두 배 길이)
+    constexpr std::size_t resume_token_bytes = 24;
+    /// 재접속 토큰 앞부분 중 항목을 찾는 데 쓰는 ID의 길이 (나머지는 상수 시간에 비교하는 비밀값)
+    constexpr std::size_t resume_token_id_length = 16;
+    /// `/search` 결과 한 페이지의 줄 수
+    constexpr std::size_t search_page_size = 10;
+    /// 팔로워가 히스토리 질의에 답하기를 기다리는 시간 (넘으면 이 노드에서 읽음)
+    constexpr std::chrono::milliseconds replica_read_timeout{2000};
+
+    /// 계정에 닉네임을 묶은 시각으로 쓰는 현재 Unix 초
+    std::uint64_t unix_now()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+}
+
 //------------------------------------------------------------------------------
 // ChatServer Implementation
 //------------------------------------------------------------------------------
@@ -44,10 +81,15 @@ ChatServer::ChatServer(net::io_context &ioc,
       config_file_(config_file),
       history_dir_(history_dir),
       history_(std::make_unique<MessageHistory>(history_dir)),
+      cluster_timer_(strand_),
+      ephemeral_timer_(strand_),
+      drain_timer_(strand_),
       stopped_(false),
       require_auth_(false)
 {
     spdlog::info("[ChatServer {}] Initializing for port {}", fmt::ptr(this), port_);
+    users_ = std::make_unique<UserStore>("");
+    password_hasher_ = std::make_unique<PasswordHasher>();
 }
 
 ChatServer::~ChatServer()
@@ -119,6 +161,20 @@ void ChatServer::stop()
 
     signals_.cancel();
 
+    if (cluster_bus_)
+    {
+        publish_to_cluster(ClusterMessage::Kind::Heartbeat, "", "system", "leave");
+        net::post(strand_, [this]() { cluster_timer_.cancel(); });
+        cluster_bus_->stop();
+    }
+
+    net::post(strand_, [this]() { ephemeral_timer_.cancel(); });
+
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        file_transfers_.clear();
+    }
+
     net::post(ioc_, [this]()
               {
         signals_.cancel();
@@ -129,6 +185,9 @@ void ChatServer::stop()
             auto sessions_copy = sessions_;
             sessions_.clear();
             nicknames_.clear();
+            resume_entries_.clear();
+            session_accounts_.clear();
+            resume_tokens_.clear();
 
             for (auto& session_ptr : sessions_copy) {
                 net::dispatch(session_ptr->get_strand(), [session = session_ptr]() {
@@ -140,11 +199,17 @@ void ChatServer::stop()
 
             std::lock_guard<std::mutex> lock(rooms_mutex_);
             rooms_.clear();
+            session_rooms_.clear();
 
             spdlog::info("[ChatServer {}] Session/Room clear initiated (strand context).", fmt::ptr(this));
         });
 
+        password_hasher_->stop();
+        if (history_replicator_) {
+            history_replicator_->stop();
+        }
         if (history_) {
+            history_->set_append_listener(nullptr);
             history_.reset();
             spdlog::info("[ChatServer {}] History reset.", fmt::ptr(this));
         }
@@ -154,6 +219,56 @@ void ChatServer::stop()
         spdlog::info("[ChatServer {}] Server stop sequence initiated on io_context.", fmt::ptr(this)); });
 }
 
+/**
+ * @details 세션 목록을 섞은 뒤 100ms마다 한 묶음씩 닫아 `window` 안에 모든 세션을 닫습니다.
+ *          닫는 순서를 섞는 이유는 먼저 접속한 클라이언트(대개 같은 지역/망)가 한꺼번에 재접속하지 않게 하기 위함입니다.
+ *          drain 도중 스스로 나간 세션은 `stop_session`이 한 번 더 호출될 수 있으나 세션 쪽에서 무시됩니다.
+ */
+void ChatServer::drain(std::chrono::milliseconds window, std::function<void()> on_drained)
+{
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, window, on_drained = std::move(on_drained)]() mutable {
+        if (stopped_ || draining_.exchange(true)) {
+            return;
+        }
+        drain_queue_.assign(sessions_.begin(), sessions_.end());
+        std::shuffle(drain_queue_.begin(), drain_queue_.end(), std::mt19937{std::random_device{}()});
+
+        std::size_t batches = static_cast<std::size_t>(std::max<std::chrono::milliseconds::rep>(1, window / drain_interval));
+        drain_batch_size_ = std::max<std::size_t>(1, (drain_queue_.size() + batches - 1) / batches);
+        on_drained_ = std::move(on_drained);
+
+        spdlog::info("[ChatServer {}] Draining {} session(s) over {}ms ({} per {}ms).",
+                     fmt::ptr(this), drain_queue_.size(), window.count(), drain_batch_size_, drain_interval.count());
+        drain_next_batch();
+    });
+}
+
+void ChatServer::drain_next_batch()
+{
+    std::size_t count = std::min(drain_batch_size_, drain_queue_.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        SessionPtr session = std::move(drain_queue_.back());
+        drain_queue_.pop_back();
+        net::dispatch(session->get_strand(), [session]() { session->stop_session(); });
+    }
+
+    if (drain_queue_.empty()) {
+        spdlog::info("[ChatServer {}] Drain complete.", fmt::ptr(this));
+        if (auto on_drained = std::move(on_drained_)) {
+            on_drained();
+        }
+        return;
+    }
+
+    drain_timer_.expires_after(drain_interval);
+    drain_timer_.async_wait([this, self = shared_from_this()](boost::system::error_code ec) {
+        if (!ec && !stopped_) {
+            drain_next_batch();
+        }
+    });
+}
+
 /**
  * @details `signals_` 객체를 사용하여 비동기적으로 종료 시그널을 기다립니다.
  *          시그널을 받으면 `stop()` 메서드를 호출하여 서버를 안전하게 종료시킵니다.
@@ -172,265 +287,1091 @@ void ChatServer::do_await_stop()
 }
 
 /**
- * @details `net::dispatch`를 사용하여 `strand_` 위에서 작업을 수행함으로써 스레드 안전성을 보장합니다.
- *          `sessions_` 셋에 새로운 세션을 추가하고 로그를 남깁니다.
- *          만약 세션이 초기 `remote_id`가 아닌 실제 닉네임을 가지고 있다면 (재접속 등의 경우),
- *          입장 메시지를 브로드캐스트합니다.
+ * @details 메시지 ID는 현재 시각(마이크로초)에서 시작하여, 노드가 같은 ID로 재시작하더라도
+ *          이전 실행보다 큰 ID를 발행하도록 합니다. 버스 핸들러는 어느 스레드에서 호출되든
+ *          `strand_`로 넘겨 처리하며, 서버가 먼저 소멸된 경우에는 무시합니다.
  */
-void ChatServer::join(SessionPtr session)
+void ChatServer::enable_cluster(std::shared_ptr<ClusterBus> bus, const std::string &node_id,
+                                std::chrono::milliseconds heartbeat_interval)
 {
-    if (!session || stopped_)
+    if (!bus || node_id.empty())
+    {
+        spdlog::error("[ChatServer {}] enable_cluster: bus and node_id are required.", fmt::ptr(this));
         return;
-    auto self = shared_from_this();
-    net::dispatch(strand_, [this, self, session]()
-                  {
-        if (stopped_) return;
-        sessions_.insert(session);
-        spdlog::info("[ChatServer {}] Client '{}' ({}) joined. Total sessions: {}",
-                fmt::ptr(this), session->nickname(), session->remote_id(), sessions_.size());
-        
-        // Only broadcast join message if user has set a proper nickname (not IP:PORT)
-        if (session->nickname() != session->remote_id()) {
-            std::string join_msg = "* 사용자 '" + session->nickname() + "'님이 입장했습니다.\r\n";
-            broadcast_impl(join_msg, session);
-        } });
+    }
+    if (cluster_bus_)
+    {
+        spdlog::warn("[ChatServer {}] Cluster mode already enabled as node '{}'.", fmt::ptr(this), node_id_);
+        return;
+    }
+
+    node_id_ = node_id;
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    incarnation_ = std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    cluster_heartbeat_interval_ = heartbeat_interval;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        room_router_ = RoomRouter(node_id_);
+        nick_directory_ = NicknameDirectory(heartbeat_interval * 3);
+    }
+    cluster_bus_ = std::move(bus);
+
+    std::weak_ptr<ChatServer> weak_self = weak_from_this();
+    cluster_bus_->start(node_id_, [this, weak_self](const ClusterMessage &msg)
+                        {
+        auto self = weak_self.lock();
+        if (!self || stopped_) return;
+        net::post(strand_, [this, self, msg]() { on_cluster_message(msg); }); });
+
+    // 첫 하트비트를 바로 보내 다른 노드가 이 노드를 링에 추가하도록 한다.
+    net::post(strand_, [this, self = shared_from_this()]() { schedule_cluster_tick(); });
+
+    spdlog::info("[ChatServer {}] Cluster mode enabled as node '{}'.", fmt::ptr(this), node_id_);
+}
+
+std::string ChatServer::room_owner(const std::string &room_name)
+{
+    if (!cluster_bus_)
+        return {};
+    std::lock_guard<std::mutex> lock(cluster_mutex_);
+    return room_router_.owner_of(room_name);
+}
+
+std::vector<std::string> ChatServer::cluster_nodes()
+{
+    std::lock_guard<std::mutex> lock(cluster_mutex_);
+    const auto &nodes = room_router_.nodes();
+    return std::vector<std::string>(nodes.begin(), nodes.end());
 }
 
 /**
- * @details `net::dispatch`와 `strand_`를 사용하여 동기화된 컨텍스트에서 다음을 수행합니다:
- *          1. 세션이 참여 중인 모든 방에서 퇴장시킵니다 (`leave_all_rooms_impl`).
- *          2. 세션이 유효한 닉네임을 가졌다면, 해당 닉네임을 `nicknames_` 맵에서 제거합니다 (`unregister_nickname`).
- *          3. `sessions_` 셋에서 세션을 제거합니다.
- *          4. 세션이 유효한 닉네임을 가졌었다면, 퇴장 메시지를 전체에 브로드캐스트합니다.
+ * @details 하트비트와 닉네임 임대 갱신을 보낸 뒤, 하트비트 간격의 3배 동안 소식이 없는 노드를 링에서 제거하고
+ *          소유 노드가 바뀐 방을 다시 구독합니다. 응답이 없는 닉네임 선점 요청은 실패로 처리하고,
+ *          위치 응답이 없는 개인 메시지는 전달을 확인하지 못했다고 보낸 사람에게 알립니다.
  */
-void ChatServer::leave(SessionPtr session)
+void ChatServer::schedule_cluster_tick()
 {
-    if (!session)
+    if (stopped_ || !cluster_bus_)
         return;
 
-    std::string nickname = session->nickname();
-    std::string remote_id = session->remote_id();
+    publish_to_cluster(ClusterMessage::Kind::Heartbeat, "", "system", incarnation_);
+    renew_nickname_leases();
 
-    auto self = shared_from_this();
-    net::dispatch(strand_, [this, self, session, nickname, remote_id]() mutable
-                  {
-        if (stopped_) return;
-        leave_all_rooms_impl(session);
-        if (!nickname.empty() && nickname != remote_id) {
-            unregister_nickname(nickname);
+    auto now = RoomRouter::clock::now();
+    std::vector<std::string> expired;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        expired = room_router_.expire_nodes(now, cluster_heartbeat_interval_ * 3);
+        for (const auto &node : expired)
+            nick_directory_.drop_node(node);
+        nick_directory_.expire(now);
+    }
+    if (!expired.empty())
+    {
+        for (const auto &node : expired)
+        {
+            spdlog::warn("[ChatServer {}] Cluster node '{}' timed out.", fmt::ptr(this), node);
+            node_incarnations_.erase(node);
+            cluster_dedup_.forget(node);
         }
-        size_t erased_count = sessions_.erase(session);
-        if (erased_count > 0) {
-            spdlog::info("[ChatServer {}] Client '{}' ({}) left. Session erased. Total sessions: {}",
-                    fmt::ptr(this), nickname, remote_id, sessions_.size());
-            // Only broadcast leave message if user had set a proper nickname (not IP:PORT)
-            if (!nickname.empty() && nickname != remote_id) {
-                std::string leave_msg = "* 사용자 '" + nickname + "'님이 퇴장했습니다.\r\n";
-                broadcast_impl(leave_msg, nullptr);
-            }
-        } else {
-            spdlog::warn("[ChatServer {}] Client '{}' ({}) leave called, but session not found.",
-                    fmt::ptr(this), nickname, remote_id);
-        } });
+        rebalance_rooms();
+    }
+
+    for (auto it = pending_nick_claims_.begin(); it != pending_nick_claims_.end();)
+    {
+        if (it->second.deadline > now)
+        {
+            ++it;
+            continue;
+        }
+        spdlog::warn("[ChatServer {}] Nickname claim for '{}' timed out.", fmt::ptr(this), it->first);
+        auto claim = std::move(it->second);
+        std::string nickname = it->first;
+        it = pending_nick_claims_.erase(it);
+        finish_nickname_claim(nickname, claim.session, std::move(claim.handler), false);
+    }
+
+    std::vector<PendingPrivateMessage> unanswered;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        while (!pending_private_.empty() && pending_private_.front().deadline <= now)
+        {
+            unanswered.push_back(std::move(pending_private_.front()));
+            pending_private_.pop_front();
+        }
+    }
+    for (const auto &entry : unanswered)
+    {
+        spdlog::warn("[ChatServer {}] Directory lookup for PM from {} to {} timed out.", fmt::ptr(this), entry.sender_nick, entry.receiver_nick);
+        if (auto sender = entry.sender.lock())
+            sender->deliver("Error: 사용자 '" + entry.receiver_nick + "'에게 보낸 메시지의 전달을 확인하지 못했습니다.\r\n");
+    }
+
+    cluster_timer_.expires_after(cluster_heartbeat_interval_);
+    cluster_timer_.async_wait([this, self = shared_from_this()](boost::system::error_code ec)
+                              {
+        if (!ec) schedule_cluster_tick(); });
 }
 
-/**
- * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
- *          `sessions_`의 복사본을 만들어 순회하면서, 각 세션의 `strand`에 `deliver` 작업을 `post`합니다.
- *          이는 각 세션의 쓰기 큐를 독립적으로 관리하고, `sessions_` 컬렉션의 변경에 영향을 받지 않도록 합니다.
- *          메시지 발신자는 브로드캐스트 대상에서 제외됩니다.
- */
-void ChatServer::broadcast_impl(const std::string &message, const SessionPtr &sender)
+void ChatServer::rebalance_rooms()
 {
-    spdlog::debug("[ChatServer {}] Broadcasting globally (sender: {}): {}", 
-                  fmt::ptr(this), 
-                  sender ? sender->remote_id() : "system", // Log sender ID for clarity
-                  message);
-                  
-    // Capture sessions by value to iterate safely even if sessions_ modified concurrently (though protected by strand)
-    auto sessions_copy = sessions_;
-    
-    for (const auto &session_ptr : sessions_copy)
-    {
-        // Check if the session is valid and not the sender
-        if (session_ptr && session_ptr != sender) 
-        {
-            // Post the deliver task to the session's own strand
-            net::post(session_ptr->get_strand(), 
-                      [session = session_ptr, message, server_ptr = fmt::ptr(this)]() { // Capture necessary data
-                // Check session validity again inside the posted task
-                if (session) { 
-                    spdlog::trace("[ChatServer {} -> Session {} strand] Delivering broadcast message.", 
-                                 server_ptr, fmt::ptr(session.get()));
-                    session->deliver(message); 
-                }
-            });
-        } else if (session_ptr == sender) {
-             spdlog::trace("[ChatServer {}] Skipping broadcast to sender: {}", fmt::ptr(this), sender->remote_id());
-        }
+    std::vector<std::pair<std::string, std::string>> moved;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        moved = room_router_.rebalance();
+        nick_directory_.retain_owned([this](const std::string &nickname)
+                                     { return room_router_.is_owner("nick:" + nickname); });
     }
-    
-    // Log global message to history (if enabled)
-    if (history_)
+    for (const auto &[room_name, owner] : moved)
     {
-        // Assuming history logging doesn't need to be on the strand, or handled internally by MessageHistory
-        history_->log_global_message(message, sender ? sender->nickname() : "system");
+        spdlog::info("[ChatServer {}] Room '{}' now owned by '{}'. Re-subscribing.", fmt::ptr(this), room_name, owner);
+        publish_to_cluster(ClusterMessage::Kind::Subscribe, room_name, "system", "", owner);
     }
+    // 새 디렉터리 노드가 다른 노드의 선점을 승인하기 전에 기존 임대를 알 수 있도록 즉시 갱신한다.
+    renew_nickname_leases();
 }
 
-/**
- * @details 외부에서 `broadcast`를 호출하면, 실제 구현부인 `broadcast_impl`이
- *          `strand_` 위에서 실행되도록 `net::post`를 통해 작업을 예약합니다.
- */
-void ChatServer::broadcast(const std::string &message, SessionPtr sender)
+std::string ChatServer::nickname_directory_node(const std::string &nickname)
 {
-    if (stopped_)
-            return;
-    auto self = shared_from_this();
-    // Post the implementation to the server's strand
-    net::post(strand_, [this, self, message, sender]()
-              { 
-                  // Check stop condition again inside strand
-                  if (stopped_) return;
-                  broadcast_impl(message, sender); 
-              });
+    std::lock_guard<std::mutex> lock(cluster_mutex_);
+    return room_router_.owner_of("nick:" + nickname);
+}
+
+void ChatServer::release_nickname_lease(const std::string &nickname)
+{
+    if (!cluster_bus_)
+        return;
+    std::string directory = nickname_directory_node(nickname);
+    if (directory == node_id_)
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        nick_directory_.release(nickname, node_id_);
+        return;
+    }
+    publish_to_cluster(ClusterMessage::Kind::NickRelease, nickname, "system", "", directory);
 }
 
 /**
- * @details `rooms_mutex_`로 `rooms_` 맵을 보호하며 해당 채팅방을 찾습니다.
- *          찾은 채팅방 객체의 `broadcast` 메서드를 호출하여 방 참여자들에게 메시지를 전달합니다.
+ * @details 디렉터리 노드마다 `NickRenew` 메시지 하나에 닉네임 목록을 담아 보내므로
+ *          갱신 트래픽은 닉네임 수가 아니라 디렉터리 노드 수에 비례합니다.
  */
-bool ChatServer::broadcast_to_room(const std::string &room_name,
-                                   const std::string &message,
-                                   SessionPtr sender)
+void ChatServer::renew_nickname_leases()
 {
-    if (stopped_)
-        return false;
-    std::shared_ptr<ChatRoom> room;
+    if (!cluster_bus_)
+        return;
+    std::vector<std::string> local_nicks;
     {
-        std::lock_guard<std::mutex> lock(rooms_mutex_);
-        auto room_it = rooms_.find(room_name);
-        if (room_it == rooms_.end())
+        std::lock_guard<std::mutex> lock(nicknames_mutex_);
+        for (const auto &[nickname, weak_session] : nicknames_)
         {
-            spdlog::error("[ChatServer {}] broadcast_to_room: Room '{}' not found.", fmt::ptr(this), room_name);
-            return false;
+            if (!weak_session.expired())
+                local_nicks.push_back(nickname);
         }
-        room = room_it->second;
     }
-    if (room)
+
+    std::map<std::string, std::string> batches; // 디렉터리 노드 -> 줄바꿈으로 구분한 닉네임 목록
     {
-        spdlog::debug("Broadcasting to room [{}]: {}", room_name, message);
-        room->broadcast(message, sender);
-        if (history_)
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        auto now = NicknameDirectory::clock::now();
+        for (const auto &nickname : local_nicks)
         {
-            history_->log_room_message(room_name, message, sender ? sender->nickname() : "system");
+            std::string directory = room_router_.owner_of("nick:" + nickname);
+            if (directory == node_id_)
+            {
+                if (!nick_directory_.renew(nickname, node_id_, now))
+                    spdlog::warn("[ChatServer {}] Nickname '{}' is leased to another node.", fmt::ptr(this), nickname);
+                continue;
+            }
+            auto &batch = batches[directory];
+            if (!batch.empty())
+                batch.push_back('\n');
+            batch.append(nickname);
         }
-        return true;
     }
-    return false;
+    for (const auto &[directory, batch] : batches)
+        publish_to_cluster(ClusterMessage::Kind::NickRenew, "", "system", batch, directory);
 }
 
-/**
- * @details 비동기적으로 수신자 닉네임을 찾아(`find_session_by_nickname_async`),
- *          수신자가 존재하면 메시지를 `deliver`하고, 송신자에게도 확인 메시지를 보냅니다.
- *          수신자가 없으면 송신자에게 에러 메시지를 보냅니다.
- */
-bool ChatServer::send_private_message(const std::string &message,
-                                      SessionPtr sender,
-                                      const std::string &receiver_nick)
+bool ChatServer::deliver_private_locally(const std::string &receiver_nick, const std::string &formatted)
 {
-    if (stopped_ || !sender || receiver_nick.empty() || message.empty())
+    SessionPtr receiver;
+    {
+        std::lock_guard<std::mutex> lock(nicknames_mutex_);
+        auto it = nicknames_.find(receiver_nick);
+        if (it != nicknames_.end())
+            receiver = it->second.lock();
+    }
+    if (!receiver)
         return false;
-    auto self = shared_from_this();
-    std::string sender_nick = sender->nickname();
-    std::string message_copy = message;
-
-    find_session_by_nickname_async(receiver_nick,
-                                   [this, self, sender, sender_nick, receiver_nick, message_copy](SessionPtr receiver_session)
-                                   {
-                                       if (stopped_)
-                                           return;
-                                       if (receiver_session)
-                                       {
-                                           std::string formatted_msg = "[PM from " + sender_nick + "]: " + message_copy + "\r\n";
-                                           receiver_session->deliver(formatted_msg);
-                                           std::string confirmation_msg = "* To " + receiver_nick + ": " + message_copy + "\r\n";
-                                           sender->deliver(confirmation_msg);
-                                           if (history_)
-                                           {
-                                               history_->log_private_message(message_copy, sender_nick, receiver_nick);
-                                           }
-                                           spdlog::info("PM sent from {} to {}", sender_nick, receiver_nick);
-                                       }
-                                       else
-                                       {
-                                           std::string error_msg = "Error: 사용자 '" + receiver_nick + "'을(를) 찾을 수 없거나 오프라인 상태입니다.\r\n";
-                                           sender->deliver(error_msg);
-                                           spdlog::info("PM failed: Receiver {} not found for sender {}", receiver_nick, sender_nick);
-                                       }
-                                   });
+    net::post(receiver->get_strand(), [receiver, formatted]()
+              { receiver->deliver(formatted); });
     return true;
 }
 
 /**
- * @details 닉네임 유효성을 먼저 검사하고, 통과하면 `try_register_nickname_impl`을
- *          `strand_` 위에서 실행하도록 `net::dispatch`를 통해 예약합니다.
+ * @details 위치 캐시가 있으면 수신자 노드로 바로(1홉) 보냅니다. 캐시가 없으면 닉네임의 디렉터리 노드로 보내고,
+ *          디렉터리 노드가 수신자 노드로 전달하면서 위치를 응답해 이후 메시지는 캐시로 바로 보냅니다.
+ *          디렉터리 노드가 이 노드이면 임대 목록에서 바로 수신자 노드를 찾습니다.
+ *          디렉터리를 거치면 받는 사람이 없을 수 있으므로, 응답보다 먼저 대기 목록에 넣어 두고 확인과 기록은 응답 때 합니다.
  */
-void ChatServer::try_register_nickname_async(const std::string &nickname,
-                                             SessionPtr session,
-                                             std::function<void(bool)> handler)
+ChatServer::PrivateRoute ChatServer::route_private_message(const SessionPtr &sender, const std::string &receiver_nick,
+                                                           const std::string &sender_nick, const std::string &message)
 {
-    if (stopped_)
+    if (!cluster_bus_)
+        return PrivateRoute::NotFound;
+    std::string formatted = "[PM from " + sender_nick + "]: " + message + "\r\n";
+    std::string target;
+    std::string directory;
     {
-        net::post(ioc_, [handler]()
-                  { handler(false); });
-        return;
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        auto now = NicknameDirectory::clock::now();
+        target = nick_directory_.cached_location(receiver_nick, now);
+        directory = room_router_.owner_of("nick:" + receiver_nick);
+        if (target.empty() && directory == node_id_)
+        {
+            target = nick_directory_.holder(receiver_nick, now);
+            if (target.empty() || target == node_id_)
+                return PrivateRoute::NotFound;
+        }
+        if (target.empty() || target == node_id_)
+            pending_private_.push_back(PendingPrivateMessage{sender, sender_nick, receiver_nick, message,
+                                                             std::chrono::steady_clock::now() + cluster_heartbeat_interval_ * 3});
     }
-    if (nickname.empty() || nickname.find_first_of(" \t\n\r\f\v") != std::string::npos ||
-        nickname.length() > 20 || nickname == "Server" || nickname == "system")
+    if (!target.empty() && target != node_id_)
     {
-        spdlog::error("[ChatServer {}] Invalid nickname format attempt (pre-check): '{}'", fmt::ptr(this), nickname);
-        net::post(ioc_, [handler]()
-                  { handler(false); });
+        publish_to_cluster(ClusterMessage::Kind::Private, receiver_nick, sender_nick, formatted, target);
+        return PrivateRoute::Sent;
+    }
+    publish_to_cluster(ClusterMessage::Kind::PrivateLookup, receiver_nick, sender_nick, formatted, directory);
+    return PrivateRoute::Pending;
+}
+
+void ChatServer::confirm_private_message(const SessionPtr &sender, const std::string &sender_nick,
+                                         const std::string &receiver_nick, const std::string &message)
+{
+    if (history_)
+        history_->log_private_message(message, sender_nick, receiver_nick);
+    sender->deliver("* To " + receiver_nick + ": " + message + "\r\n");
+}
+
+void ChatServer::on_local_room_created(const std::string &room_name)
+{
+    if (!cluster_bus_)
         return;
+    std::string owner;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        owner = room_router_.track_local_room(room_name);
     }
-    std::string nickname_copy = nickname;
-    std::weak_ptr<SessionInterface> weak_session = session;
-    auto self = shared_from_this();
-    net::dispatch(strand_, [this, self, nickname_copy, weak_session, handler = std::move(handler)]() mutable
-                  { try_register_nickname_impl(nickname_copy, weak_session, std::move(handler)); });
+    if (!owner.empty())
+        publish_to_cluster(ClusterMessage::Kind::Subscribe, room_name, "system", "", owner);
+}
+
+void ChatServer::on_local_room_removed(const std::string &room_name)
+{
+    channel_log_.drop_entries(room_name); // 순번은 유지, 이후 재전송 요청은 히스토리에서 처리
+    if (!cluster_bus_)
+        return;
+    std::string owner;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        owner = room_router_.untrack_local_room(room_name);
+    }
+    if (!owner.empty())
+        publish_to_cluster(ClusterMessage::Kind::Unsubscribe, room_name, "system", "", owner);
 }
 
 /**
- * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
- *          `nicknames_mutex_`로 `nicknames_` 맵을 보호하면서 다음을 수행합니다:
- *          1. 요청된 닉네임이 이미 사용 중인지 확인합니다.
- *             - 사용 중이지만 `weak_ptr`이 만료되었다면, 해당 항목을 제거하고 등록 가능으로 처리합니다.
- *             - 같은 세션이 재요청한 경우 등록 가능으로 처리합니다.
- *          2. 등록이 가능하다면, 이전 닉네임이 있었다면 해당 매핑을 제거합니다.
- *          3. 새로운 닉네임과 세션을 `nicknames_` 맵에 등록합니다.
- *          최종 결과를 콜백 핸들러를 통해 비동기적으로 전달합니다.
+ * @details 시작(또는 재합류) 직후 첫 하트비트를 받기 전에는 링에 이 노드만 있어 모든 방의 소유자가 자신이 되고,
+ *          구독 노드도 아직 없습니다. 이때 소유 노드 경로로 보내면 다른 노드의 멤버가 메시지를 놓치므로,
+ *          다른 노드를 알게 될 때까지는 `RoomForward`를 모든 노드에 한 번 발행합니다.
+ *          `RoomForward`는 받은 노드에서 로컬 전달만 하므로 중복 팬아웃은 생기지 않습니다.
  */
-void ChatServer::try_register_nickname_impl(const std::string &nickname_copy,
-                                            std::weak_ptr<SessionInterface> weak_session,
-                                            std::function<void(bool)> handler)
+void ChatServer::route_room_message(const std::string &room_name, const std::string &sender_nick, const std::string &formatted)
 {
-    bool success = false;
-    SessionPtr session = weak_session.lock();
-    if (!session) {
-        spdlog::error("[ChatServer {}] Session expired during nickname registration for '{}'", fmt::ptr(this), nickname_copy);
-        net::post(ioc_, [handler = std::move(handler)]() { handler(false); });
+    if (!cluster_bus_)
         return;
+    std::string owner;
+    std::vector<std::string> targets;
+    bool alone = false;
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        alone = room_router_.nodes().size() <= 1;
+        owner = room_router_.owner_of(room_name);
+        if (owner == node_id_)
+            targets = room_router_.subscribers(room_name);
     }
-
-    spdlog::debug("[ChatServer {}] try_register_nickname_impl (strand): '{}' for session {}", fmt::ptr(this), nickname_copy, fmt::ptr(session.get()));
-    std::string old_nick = session->nickname();
-    bool can_register = false;
-
-    // Lock the nicknames_ mutex before accessing the map
+    if (alone)
     {
-        std::lock_guard<std::mutex> lock(nicknames_mutex_); 
-        auto it = nicknames_.find(nickname_copy);
+        publish_to_cluster(ClusterMessage::Kind::RoomForward, room_name, sender_nick, formatted);
+        return;
+    }
+    if (owner != node_id_)
+    {
+        publish_to_cluster(ClusterMessage::Kind::Room, room_name, sender_nick, formatted, owner);
+        return;
+    }
+    for (const auto &node : targets)
+    {
+        publish_to_cluster(ClusterMessage::Kind::RoomForward, room_name, sender_nick, formatted, node);
+    }
+}
+
+void ChatServer::publish_to_cluster(ClusterMessage::Kind kind, const std::string &target,
+                                    const std::string &sender, const std::string &payload,
+                                    const std::string &target_node)
+{
+    if (!cluster_bus_)
+        return;
+    ClusterMessage msg;
+    msg.kind = kind;
+    msg.target_node = target_node;
+    msg.target = target;
+    msg.sender = sender;
+    msg.payload = payload;
+    cluster_bus_->publish(std::move(msg));
+}
+
+/**
+ * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
+ *          자신이 발행한 메시지와 이미 받은 메시지는 버리고, 종류에 따라 로컬 세션에만 전달합니다.
+ *          히스토리 기록과 재발행은 하지 않습니다 (발행한 노드가 기록).
+ */
+void ChatServer::on_cluster_message(const ClusterMessage &msg)
+{
+    if (stopped_ || msg.origin_node == node_id_)
+        return;
+    if (!cluster_dedup_.accept(msg.origin_node, msg.msg_id))
+    {
+        spdlog::trace("[ChatServer {}] Duplicate cluster message {}#{} dropped.", fmt::ptr(this), msg.origin_node, msg.msg_id);
+        return;
+    }
+
+    switch (msg.kind)
+    {
+    case ClusterMessage::Kind::Global:
+        // 순번은 노드마다 따로 붙인다. (수신 노드의 재전송 로그에도 남긴다)
+        channel_log_.append(ChannelLog::global_channel, msg.payload, [this](std::uint64_t, const std::string &stamped) {
+            for (const auto &session_ptr : sessions_)
+            {
+                net::post(session_ptr->get_strand(), [session = session_ptr, stamped]()
+                          { session->deliver(stamped); });
+            }
+        });
+        break;
+    case ClusterMessage::Kind::Room:
+    case ClusterMessage::Kind::RoomForward:
+    {
+        std::shared_ptr<ChatRoom> room;
+        {
+            std::lock_guard<std::mutex> lock(rooms_mutex_);
+            auto room_it = rooms_.find(msg.target);
+            if (room_it != rooms_.end())
+                room = room_it->second;
+        }
+        if (room)
+        {
+            channel_log_.append(msg.target, msg.payload, [&](std::uint64_t, const std::string &stamped) {
+                room->deliver_formatted(stamped, nullptr);
+            });
+        }
+        if (msg.kind == ClusterMessage::Kind::Room)
+        {
+            // 소유 노드로서 보낸 노드를 제외한 구독 노드에 한 번씩 전달
+            std::vector<std::string> targets;
+            {
+                std::lock_guard<std::mutex> lock(cluster_mutex_);
+                targets = room_router_.subscribers(msg.target, msg.origin_node);
+            }
+            for (const auto &node : targets)
+                publish_to_cluster(ClusterMessage::Kind::RoomForward, msg.target, msg.sender, msg.payload, node);
+        }
+        break;
+    }
+    case ClusterMessage::Kind::Subscribe:
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        room_router_.add_subscriber(msg.target, msg.origin_node);
+        break;
+    }
+    case ClusterMessage::Kind::Unsubscribe:
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        room_router_.remove_subscriber(msg.target, msg.origin_node);
+        break;
+    }
+    case ClusterMessage::Kind::Heartbeat:
+    {
+        bool ring_changed = false;
+        std::vector<std::string> resubscribe;
+        {
+            std::lock_guard<std::mutex> lock(cluster_mutex_);
+            if (msg.payload == "leave")
+            {
+                ring_changed = room_router_.remove_node(msg.origin_node);
+                nick_directory_.drop_node(msg.origin_node);
+            }
+            else
+            {
+                ring_changed = room_router_.observe_node(msg.origin_node, RoomRouter::clock::now());
+                // 링에서 빠지기 전에 재시작한 노드는 구독 정보를 잃었으므로 다시 구독한다.
+                auto &known = node_incarnations_[msg.origin_node];
+                if (!ring_changed && !known.empty() && known != msg.payload)
+                    resubscribe = room_router_.local_rooms_owned_by(msg.origin_node);
+                known = msg.payload;
+            }
+        }
+        if (msg.payload == "leave")
+        {
+            node_incarnations_.erase(msg.origin_node);
+            cluster_dedup_.forget(msg.origin_node);
+            spdlog::info("[ChatServer {}] Cluster node '{}' left.", fmt::ptr(this), msg.origin_node);
+        }
+        else if (ring_changed)
+        {
+            spdlog::info("[ChatServer {}] Cluster node '{}' joined.", fmt::ptr(this), msg.origin_node);
+            // 새 노드가 이 노드를 바로 알 수 있도록 즉시 응답
+            publish_to_cluster(ClusterMessage::Kind::Heartbeat, "", "system", incarnation_, msg.origin_node);
+        }
+        if (ring_changed)
+            rebalance_rooms();
+        for (const auto &room_name : resubscribe)
+            publish_to_cluster(ClusterMessage::Kind::Subscribe, room_name, "system", "", msg.origin_node);
+        break;
+    }
+    case ClusterMessage::Kind::Private:
+    {
+        if (deliver_private_locally(msg.target, msg.payload))
+            break;
+        // 보낸 노드의 위치 캐시가 오래된 경우: 캐시를 지우게 하고 디렉터리 노드를 거쳐 다시 보낸다.
+        std::string directory = nickname_directory_node(msg.target);
+        if (directory == node_id_)
+        {
+            // 이 노드가 디렉터리이면 현재 보유 노드를 바로 찾아 보낸다.
+            std::string holder;
+            {
+                std::lock_guard<std::mutex> lock(cluster_mutex_);
+                holder = nick_directory_.holder(msg.target, NicknameDirectory::clock::now());
+            }
+            bool delivered = !holder.empty() && holder != node_id_ && holder != msg.origin_node;
+            if (delivered)
+                publish_to_cluster(ClusterMessage::Kind::Private, msg.target, msg.sender, msg.payload, holder);
+            publish_to_cluster(ClusterMessage::Kind::NickLocation, msg.target, delivered ? "" : msg.sender,
+                               delivered ? holder : "", msg.origin_node);
+        }
+        else if (directory == msg.origin_node)
+        {
+            // 보낸 노드가 디렉터리인데도 받는 사람을 못 찾았으므로 보낸 사람에게 실패를 알리게 한다.
+            publish_to_cluster(ClusterMessage::Kind::NickLocation, msg.target, msg.sender, "", msg.origin_node);
+        }
+        else
+        {
+            publish_to_cluster(ClusterMessage::Kind::NickLocation, msg.target, "", "", msg.origin_node);
+            publish_to_cluster(ClusterMessage::Kind::PrivateLookup, msg.target, msg.sender, msg.payload, directory);
+        }
+        break;
+    }
+    case ClusterMessage::Kind::PrivateLookup:
+    {
+        std::string holder;
+        {
+            std::lock_guard<std::mutex> lock(cluster_mutex_);
+            holder = nick_directory_.holder(msg.target, NicknameDirectory::clock::now());
+        }
+        bool delivered = false;
+        if (holder == node_id_)
+            delivered = deliver_private_locally(msg.target, msg.payload);
+        else if (!holder.empty() && holder != msg.origin_node)
+        {
+            publish_to_cluster(ClusterMessage::Kind::Private, msg.target, msg.sender, msg.payload, holder);
+            delivered = true;
+        }
+        // 보낸 노드가 대기 중인 메시지를 찾을 수 있도록 전달했을 때도 보낸 사람을 함께 응답한다.
+        publish_to_cluster(ClusterMessage::Kind::NickLocation, msg.target, msg.sender,
+                           delivered ? holder : "", msg.origin_node);
+        break;
+    }
+    case ClusterMessage::Kind::NickLocation:
+    {
+        std::optional<PendingPrivateMessage> pending;
+        {
+            std::lock_guard<std::mutex> lock(cluster_mutex_);
+            if (msg.payload.empty())
+                nick_directory_.invalidate(msg.target);
+            else
+                nick_directory_.cache_location(msg.target, msg.payload, NicknameDirectory::clock::now());
+            auto it = std::find_if(pending_private_.begin(), pending_private_.end(), [&msg](const PendingPrivateMessage &entry)
+                                   { return entry.receiver_nick == msg.target && entry.sender_nick == msg.sender; });
+            if (it != pending_private_.end())
+            {
+                pending = std::move(*it);
+                pending_private_.erase(it);
+            }
+        }
+        if (pending && !msg.payload.empty())
+        {
+            if (auto sender = pending->sender.lock())
+                confirm_private_message(sender, pending->sender_nick, pending->receiver_nick, pending->message);
+            spdlog::info("PM from {} to {} delivered via directory", msg.sender, msg.target);
+        }
+        else if (msg.payload.empty() && !msg.sender.empty())
+        {
+            deliver_private_locally(msg.sender, "Error: 사용자 '" + msg.target + "'을(를) 찾을 수 없거나 오프라인 상태입니다.\r\n");
+            spdlog::info("PM failed: Receiver {} not found in cluster for sender {}", msg.target, msg.sender);
+        }
+        break;
+    }
+    case ClusterMessage::Kind::NickClaim:
+    {
+        bool granted;
+        {
+            std::lock_guard<std::mutex> lock(cluster_mutex_);
+            granted = nick_directory_.claim(msg.target, msg.origin_node, NicknameDirectory::clock::now());
+        }
+        publish_to_cluster(ClusterMessage::Kind::NickClaimResult, msg.target, "system",
+                           granted ? "granted" : "denied", msg.origin_node);
+        break;
+    }
+    case ClusterMessage::Kind::NickClaimResult:
+    {
+        auto it = pending_nick_claims_.find(msg.target);
+        if (it == pending_nick_claims_.end())
+        {
+            // 시간 초과로 포기한 요청이 늦게 승인되었으면 임대를 돌려준다.
+            if (msg.payload == "granted")
+                publish_to_cluster(ClusterMessage::Kind::NickRelease, msg.target, "system", "", msg.origin_node);
+            break;
+        }
+        auto claim = std::move(it->second);
+        pending_nick_claims_.erase(it);
+        finish_nickname_claim(msg.target, claim.session, std::move(claim.handler), msg.payload == "granted");
+        break;
+    }
+    case ClusterMessage::Kind::NickRenew:
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        auto now = NicknameDirectory::clock::now();
+        std::string_view names = msg.payload;
+        while (!names.empty())
+        {
+            auto pos = names.find('\n');
+            std::string nickname(names.substr(0, pos));
+            names = pos == std::string_view::npos ? std::string_view() : names.substr(pos + 1);
+            if (!nickname.empty() && !nick_directory_.renew(nickname, msg.origin_node, now))
+                spdlog::warn("[ChatServer {}] Node '{}' renewed nickname '{}' leased to another node.",
+                             fmt::ptr(this), msg.origin_node, nickname);
+        }
+        break;
+    }
+    case ClusterMessage::Kind::NickRelease:
+    {
+        std::lock_guard<std::mutex> lock(cluster_mutex_);
+        nick_directory_.release(msg.target, msg.origin_node);
+        break;
+    }
+    }
+}
+
+/**
+ * @details `net::dispatch`를 사용하여 `strand_` 위에서 작업을 수행함으로써 스레드 안전성을 보장합니다.
+ *          `sessions_` 셋에 새로운 세션을 추가하고 로그를 남깁니다.
+ *          만약 세션이 초기 `remote_id`가 아닌 실제 닉네임을 가지고 있다면 (재접속 등의 경우),
+ *          입장 메시지를 브로드캐스트합니다.
+ */
+void ChatServer::join(SessionPtr session)
+{
+    if (!session || stopped_)
+        return;
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, session]()
+                  {
+        if (stopped_) return;
+        sessions_.insert(session);
+        spdlog::info("[ChatServer {}] Client '{}' ({}) joined. Total sessions: {}",
+                fmt::ptr(this), session->nickname(), session->remote_id(), sessions_.size());
+        
+        // Only broadcast join message if user has set a proper nickname (not IP:PORT)
+        if (session->nickname() != session->remote_id()) {
+            std::string join_msg = "* 사용자 '" + session->nickname() + "'님이 입장했습니다.\r\n";
+            broadcast_impl(join_msg, session);
+        } });
+}
+
+/**
+ * @details 세션이 보내거나 받던 파일 전송은 연결이 끊기면 이어갈 수 없으므로 먼저 실패로 끝냅니다.
+ *          그 다음 `net::dispatch`와 `strand_`를 사용하여 동기화된 컨텍스트에서 다음을 수행합니다:
+ *          1. 이미 제거되었거나 다른 세션에 자리를 넘긴 세션이면 무시합니다.
+ *          2. 재접속 토큰이 있으면 `park_session`으로 유예 기간 동안 자리를 보관합니다.
+ *          3. 그 외에는 `remove_session_impl`로 방, 닉네임, 세션 목록에서 제거하고 퇴장을 알립니다.
+ */
+void ChatServer::leave(SessionPtr session)
+{
+    if (!session)
+        return;
+
+    abort_file_transfers(session);
+
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, session]()
+                  {
+        if (stopped_) return;
+        std::string token;
+        if (auto token_it = resume_tokens_.find(session.get()); token_it != resume_tokens_.end()) {
+            token = token_it->second;
+            resume_tokens_.erase(token_it);
+        }
+        if (sessions_.count(session) == 0) {
+            spdlog::debug("[ChatServer {}] Client '{}' ({}) leave called, but session already removed.",
+                    fmt::ptr(this), session->nickname(), session->remote_id());
+            erase_resume_entry(token);
+            return;
+        }
+        if (!token.empty() && park_session(token, session)) {
+            return;
+        }
+        erase_resume_entry(token);
+        remove_session_impl(session); });
+}
+
+/**
+ * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
+ *          1. 세션이 참여 중인 모든 방에서 퇴장시킵니다 (`leave_all_rooms_impl`).
+ *          2. 닉네임이 이 세션에 등록되어 있으면 `nicknames_` 맵에서 제거합니다 (`unregister_nickname`).
+ *          3. `sessions_` 셋에서 세션을 제거하고, 유효한 닉네임이었다면 퇴장 메시지를 브로드캐스트합니다.
+ */
+void ChatServer::remove_session_impl(const SessionPtr &session)
+{
+    std::string nickname = session->nickname();
+    std::string remote_id = session->remote_id();
+
+    leave_all_rooms_impl(session);
+    session_accounts_.erase(session.get());
+    if (!nickname.empty() && nickname != remote_id) {
+        bool owns_nickname;
+        {
+            std::lock_guard<std::mutex> lock(nicknames_mutex_);
+            auto it = nicknames_.find(nickname);
+            owns_nickname = it != nicknames_.end() && (it->second.expired() || it->second.lock() == session);
+        }
+        if (owns_nickname)
+            unregister_nickname(nickname);
+    }
+    size_t erased_count = sessions_.erase(session);
+    if (erased_count > 0) {
+        spdlog::info("[ChatServer {}] Client '{}' ({}) left. Session erased. Total sessions: {}",
+                fmt::ptr(this), nickname, remote_id, sessions_.size());
+        // Only broadcast leave message if user had set a proper nickname (not IP:PORT)
+        // drain 중에는 퇴장이 재접속으로 이어지므로 알리지 않는다.
+        if (!nickname.empty() && nickname != remote_id && !draining_) {
+            std::string leave_msg = "* 사용자 '" + nickname + "'님이 퇴장했습니다.\r\n";
+            broadcast_impl(leave_msg, nullptr);
+        }
+    }
+}
+
+/**
+ * @details 토큰은 `RAND_bytes`로 만든 192비트 난수를 16진수로 표현한 값이며 `strand_` 위에서 발급합니다.
+ *          앞 64비트는 항목을 찾는 ID이고, 나머지 128비트는 비밀값으로 `find_resume_entry`가 상수 시간에 비교합니다.
+ */
+void ChatServer::issue_resume_token_async(SessionPtr session, std::function<void(std::string)> handler)
+{
+    if (!session || stopped_ || resume_grace_.count() <= 0)
+        return;
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, session, handler = std::move(handler)]() mutable {
+        if (stopped_ || sessions_.count(session) == 0)
+            return;
+        std::string &token = resume_tokens_[session.get()];
+        if (token.empty()) {
+            unsigned char random[resume_token_bytes];
+            std::string id;
+            do {
+                if (RAND_bytes(random, sizeof(random)) != 1) {
+                    resume_tokens_.erase(session.get());
+                    spdlog::error("[ChatServer {}] RAND_bytes failed; no resume token issued.", fmt::ptr(this));
+                    return;
+                }
+                token.clear();
+                for (unsigned char byte : random) {
+                    char hex[3];
+                    std::snprintf(hex, sizeof(hex), "%02x", byte);
+                    token += hex;
+                }
+                id = token.substr(0, resume_token_id_length);
+            } while (resume_entries_.count(id) > 0);
+            resume_entries_[id] = ResumeEntry{token.substr(resume_token_id_length), session, nullptr, nullptr};
+        }
+        net::post(session->get_strand(), [handler = std::move(handler), token]() { handler(token); });
+    });
+}
+
+/**
+ * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
+ *          보관 세션은 닉네임과 방 멤버십을 그대로 이어받으므로 다른 사용자에게 퇴장 알림이 가지 않으며,
+ *          클러스터 모드에서는 닉네임 임대도 계속 갱신되어 유예 기간 동안 다른 노드가 닉네임을 가져갈 수 없습니다.
+ */
+bool ChatServer::park_session(const std::string &token, const SessionPtr &session)
+{
+    if (resume_grace_.count() <= 0 || draining_ || session->nickname() == session->remote_id())
+        return false;
+    auto it = find_resume_entry(token);
+    if (it == resume_entries_.end())
+        return false;
+
+    auto parked = std::make_shared<ParkedSession>(ioc_, session->nickname(), session->remote_id(), session->current_room());
+    replace_session(session, parked);
+    it->second.live.reset();
+    it->second.parked = parked;
+    it->second.expiry = std::make_shared<net::steady_timer>(strand_, resume_grace_);
+    it->second.expiry->async_wait([this, self = shared_from_this(), token](boost::system::error_code ec) {
+        if (!ec && !stopped_)
+            expire_parked_session(token);
+    });
+    spdlog::info("[ChatServer {}] Client '{}' ({}) disconnected. Keeping session for {}ms.",
+                 fmt::ptr(this), session->nickname(), session->remote_id(), resume_grace_.count());
+    return true;
+}
+
+void ChatServer::replace_session(const SessionPtr &from, const SessionPtr &to)
+{
+    sessions_.erase(from);
+    sessions_.insert(to);
+    session_accounts_.erase(from.get()); // 재개한 연결은 다시 로그인해야 귓속말을 검색할 수 있다
+    {
+        std::lock_guard<std::mutex> lock(nicknames_mutex_);
+        auto it = nicknames_.find(to->nickname());
+        if (it != nicknames_.end() && it->second.lock() == from)
+            it->second = to;
+    }
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto joined = session_rooms_.extract(from.get());
+    if (joined.empty())
+        return;
+    for (const auto &room_name : joined.mapped()) {
+        auto it = rooms_.find(room_name);
+        if (it != rooms_.end())
+            it->second->replace_participant(from, to);
+    }
+    joined.key() = to.get();
+    session_rooms_.insert(std::move(joined));
+}
+
+std::map<std::string, ChatServer::ResumeEntry>::iterator ChatServer::find_resume_entry(const std::string &token)
+{
+    if (token.size() != resume_token_bytes * 2)
+        return resume_entries_.end();
+    auto it = resume_entries_.find(token.substr(0, resume_token_id_length));
+    if (it == resume_entries_.end() ||
+        CRYPTO_memcmp(it->second.secret.data(), token.data() + resume_token_id_length, it->second.secret.size()) != 0)
+        return resume_entries_.end();
+    return it;
+}
+
+void ChatServer::erase_resume_entry(const std::string &token)
+{
+    auto it = find_resume_entry(token);
+    if (it != resume_entries_.end())
+        resume_entries_.erase(it);
+}
+
+void ChatServer::expire_parked_session(const std::string &token)
+{
+    auto it = find_resume_entry(token);
+    if (it == resume_entries_.end() || !it->second.parked)
+        return;
+    SessionPtr parked = it->second.parked;
+    resume_entries_.erase(it);
+    spdlog::info("[ChatServer {}] Resume grace period for '{}' expired.", fmt::ptr(this), parked->nickname());
+    remove_session_impl(parked);
+}
+
+/**
+ * @details 새 세션이 이미 닉네임을 정했거나 방에 들어가 있으면 상태가 섞이므로 거부합니다.
+ *          토큰은 한 번만 쓸 수 있으며, 새 세션은 접속 시 발급받은 자신의 토큰을 계속 사용합니다.
+ */
+void ChatServer::resume_session_async(const std::string &token, SessionPtr session, std::function<void(bool)> handler)
+{
+    if (!session || stopped_)
+        return;
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, token, session, handler = std::move(handler)]() mutable {
+        auto fail = [&]() {
+            net::post(session->get_strand(), [handler = std::move(handler)]() { handler(false); });
+        };
+        auto it = find_resume_entry(token);
+        if (stopped_ || it == resume_entries_.end() || sessions_.count(session) == 0 ||
+            session->nickname() != session->remote_id() || !session->current_room().empty())
+            return fail();
+
+        if (!it->second.parked) {
+            // 이전 연결이 아직 살아 있는 것으로 보이면 닫고 그 자리를 넘겨받는다.
+            SessionPtr previous = it->second.live.lock();
+            if (!previous || previous == session)
+                return fail();
+            resume_tokens_.erase(previous.get());
+            if (!park_session(token, previous))
+                return fail();
+            net::dispatch(previous->get_strand(), [previous]() { previous->stop_session(); });
+        }
+
+        std::shared_ptr<ParkedSession> parked = it->second.parked;
+        it->second.expiry->cancel();
+        resume_entries_.erase(it);
+
+        session->set_nickname(parked->nickname());
+        session->set_current_room(parked->current_room());
+        replace_session(parked, session);
+
+        std::string notice = "* 세션이 복원되었습니다. 닉네임: " + parked->nickname();
+        std::vector<std::string> joined = rooms_of(session);
+        for (std::size_t i = 0; i < joined.size(); ++i)
+            notice += (i == 0 ? ", 방: " : ", ") + joined[i];
+        if (parked->dropped() > 0)
+            notice += " (오래된 메시지 " + std::to_string(parked->dropped()) + "개 생략)";
+        session->deliver(notice + "\r\n");
+        std::size_t replayed = parked->resume_into(session);
+        spdlog::info("[ChatServer {}] Session '{}' resumed by {} ({} message(s) replayed).",
+                     fmt::ptr(this), parked->nickname(), session->remote_id(), replayed);
+        net::post(session->get_strand(), [handler = std::move(handler)]() { handler(true); });
+    });
+}
+
+/**
+ * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
+ *          `sessions_`의 복사본을 만들어 순회하면서, 각 세션의 `strand`에 `deliver` 작업을 `post`합니다.
+ *          이는 각 세션의 쓰기 큐를 독립적으로 관리하고, `sessions_` 컬렉션의 변경에 영향을 받지 않도록 합니다.
+ *          메시지 발신자는 브로드캐스트 대상에서 제외됩니다.
+ */
+void ChatServer::broadcast_impl(const std::string &message, const SessionPtr &sender)
+{
+    spdlog::debug("[ChatServer {}] Broadcasting globally (sender: {}): {}", 
+                  fmt::ptr(this), 
+                  sender ? sender->remote_id() : "system", // Log sender ID for clarity
+                  message);
+                  
+    // Capture sessions by value to iterate safely even if sessions_ modified concurrently (though protected by strand)
+    auto sessions_copy = sessions_;
+    
+    std::string sender_nick = sender ? sender->nickname() : "system";
+    channel_log_.append(ChannelLog::global_channel, message, [&](std::uint64_t seq, const std::string &stamped) {
+        for (const auto &session_ptr : sessions_copy)
+        {
+            // Check if the session is valid and not the sender
+            if (session_ptr && session_ptr != sender) 
+            {
+                // Post the deliver task to the session's own strand
+                net::post(session_ptr->get_strand(), 
+                          [session = session_ptr, stamped, server_ptr = fmt::ptr(this)]() { // Capture necessary data
+                    // Check session validity again inside the posted task
+                    if (session) { 
+                        spdlog::trace("[ChatServer {} -> Session {} strand] Delivering broadcast message.", 
+                                     server_ptr, fmt::ptr(session.get()));
+                        session->deliver(stamped); 
+                    }
+                });
+            } else if (session_ptr == sender) {
+                 spdlog::trace("[ChatServer {}] Skipping broadcast to sender: {}", fmt::ptr(this), sender->remote_id());
+            }
+        }
+        // 채널 잠금 안에서 순번과 함께 기록하므로 히스토리 줄은 순번 순서대로 쌓인다 (`/since`가 순번으로 구간을 고름).
+        if (history_)
+            history_->log_global_message(message, sender_nick, seq);
+    });
+    
+    publish_to_cluster(ClusterMessage::Kind::Global, "", sender_nick, message);
+}
+
+/**
+ * @details 외부에서 `broadcast`를 호출하면, 실제 구현부인 `broadcast_impl`이
+ *          `strand_` 위에서 실행되도록 `net::post`를 통해 작업을 예약합니다.
+ */
+void ChatServer::broadcast(const std::string &message, SessionPtr sender)
+{
+    if (stopped_)
+            return;
+    auto self = shared_from_this();
+    // Post the implementation to the server's strand
+    net::post(strand_, [this, self, message, sender]()
+              { 
+                  // Check stop condition again inside strand
+                  if (stopped_) return;
+                  broadcast_impl(message, sender); 
+              });
+}
+
+/**
+ * @details `rooms_mutex_`로 `rooms_` 맵을 보호하며 해당 채팅방을 찾습니다.
+ *          찾은 채팅방 객체의 `broadcast` 메서드를 호출하여 방 참여자들에게 메시지를 전달합니다.
+ *          클러스터 모드에서는 포맷된 메시지를 방 소유 노드를 거쳐 방 멤버가 있는 다른 노드에도 전달합니다.
+ */
+bool ChatServer::broadcast_to_room(const std::string &room_name,
+                                   const std::string &message,
+                                   SessionPtr sender)
+{
+    if (stopped_)
+        return false;
+    std::shared_ptr<ChatRoom> room;
+    {
+        std::lock_guard<std::mutex> lock(rooms_mutex_);
+        auto room_it = rooms_.find(room_name);
+        if (room_it == rooms_.end())
+        {
+            spdlog::error("[ChatServer {}] broadcast_to_room: Room '{}' not found.", fmt::ptr(this), room_name);
+            return false;
+        }
+        room = room_it->second;
+    }
+    if (room)
+    {
+        spdlog::debug("Broadcasting to room [{}]: {}", room_name, message);
+        std::string sender_nick = sender ? sender->nickname() : "system";
+        std::string formatted = room->format_message(message, sender_nick);
+        channel_log_.append(room_name, formatted, [&](std::uint64_t seq, const std::string &stamped) {
+            room->deliver_formatted(stamped, sender);
+            if (history_)
+                history_->log_room_message(room_name, message, sender_nick, seq);
+        });
+        route_room_message(room_name, sender_nick, formatted);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @details 비동기적으로 수신자 닉네임을 찾아(`find_session_by_nickname_async`),
+ *          수신자가 존재하면 메시지를 `deliver`하고, 송신자에게도 확인 메시지를 보냅니다.
+ *          수신자가 로컬에 없고 클러스터 모드이면 닉네임 디렉터리로 수신자 노드를 찾아 그 노드에만 보냅니다.
+ *          디렉터리 노드를 거치는 경우에는 전달 여부를 알 수 없으므로, 확인 메시지와 히스토리 기록은 위치 응답이 온 뒤에 합니다.
+ *          그 외에는 송신자에게 에러 메시지를 보냅니다.
+ */
+bool ChatServer::send_private_message(const std::string &message,
+                                      SessionPtr sender,
+                                      const std::string &receiver_nick)
+{
+    if (stopped_ || !sender || receiver_nick.empty() || message.empty())
+        return false;
+    auto self = shared_from_this();
+    std::string sender_nick = sender->nickname();
+    std::string message_copy = message;
+
+    find_session_by_nickname_async(receiver_nick,
+                                   [this, self, sender, sender_nick, receiver_nick, message_copy](SessionPtr receiver_session)
+                                   {
+                                       if (stopped_)
+                                           return;
+                                       if (receiver_session)
+                                       {
+                                           std::string formatted_msg = "[PM from " + sender_nick + "]: " + message_copy + "\r\n";
+                                           receiver_session->deliver(formatted_msg);
+                                           confirm_private_message(sender, sender_nick, receiver_nick, message_copy);
+                                           spdlog::info("PM sent from {} to {}", sender_nick, receiver_nick);
+                                           return;
+                                       }
+                                       switch (route_private_message(sender, receiver_nick, sender_nick, message_copy))
+                                       {
+                                       case PrivateRoute::Sent:
+                                           confirm_private_message(sender, sender_nick, receiver_nick, message_copy);
+                                           spdlog::info("PM from {} to {} published to cluster", sender_nick, receiver_nick);
+                                           break;
+                                       case PrivateRoute::Pending:
+                                           spdlog::info("PM from {} to {} awaiting directory lookup", sender_nick, receiver_nick);
+                                           break;
+                                       case PrivateRoute::NotFound:
+                                       {
+                                           std::string error_msg = "Error: 사용자 '" + receiver_nick + "'을(를) 찾을 수 없거나 오프라인 상태입니다.\r\n";
+                                           sender->deliver(error_msg);
+                                           spdlog::info("PM failed: Receiver {} not found for sender {}", receiver_nick, sender_nick);
+                                           break;
+                                       }
+                                       }
+                                   });
+    return true;
+}
+
+/**
+ * @details 닉네임 유효성을 먼저 검사하고, 통과하면 `try_register_nickname_impl`을
+ *          `strand_` 위에서 실행하도록 `net::dispatch`를 통해 예약합니다.
+ */
+void ChatServer::try_register_nickname_async(const std::string &nickname,
+                                             SessionPtr session,
+                                             std::function<void(bool)> handler)
+{
+    if (stopped_)
+    {
+        net::post(ioc_, [handler]()
+                  { handler(false); });
+        return;
+    }
+    if (nickname.empty() || nickname.find_first_of(" \t\n\r\f\v") != std::string::npos ||
+        nickname.length() > 20 || nickname == "Server" || nickname == "system")
+    {
+        spdlog::error("[ChatServer {}] Invalid nickname format attempt (pre-check): '{}'", fmt::ptr(this), nickname);
+        net::post(ioc_, [handler]()
+                  { handler(false); });
+        return;
+    }
+    std::string nickname_copy = nickname;
+    std::weak_ptr<SessionInterface> weak_session = session;
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, nickname_copy, weak_session, handler = std::move(handler)]() mutable
+                  { try_register_nickname_impl(nickname_copy, weak_session, std::move(handler)); });
+}
+
+/**
+ * @details 이 함수는 반드시 `strand_` 위에서 실행되어야 합니다.
+ *          단일 노드 모드에서는 `register_nickname_local`로 바로 등록하고,
+ *          클러스터 모드에서는 `claim_nickname_in_cluster`로 디렉터리 노드의 승인을 먼저 받습니다.
+ *          최종 결과는 콜백 핸들러를 통해 비동기적으로 전달합니다.
+ */
+void ChatServer::try_register_nickname_impl(const std::string &nickname_copy,
+                                            std::weak_ptr<SessionInterface> weak_session,
+                                            std::function<void(bool)> handler)
+{
+    SessionPtr session = weak_session.lock();
+    if (!session) {
+        spdlog::error("[ChatServer {}] Session expired during nickname registration for '{}'", fmt::ptr(this), nickname_copy);
+        net::post(ioc_, [handler = std::move(handler)]() { handler(false); });
+        return;
+    }
+
+    spdlog::debug("[ChatServer {}] try_register_nickname_impl (strand): '{}' for session {}", fmt::ptr(this), nickname_copy, fmt::ptr(session.get()));
+    // 계정에 묶인 닉네임은 그 계정으로 로그인한 세션만 쓸 수 있다.
+    if (users_->contains(nickname_copy)) {
+        auto account = session_accounts_.find(session.get());
+        if (account == session_accounts_.end() || account->second != nickname_copy) {
+            spdlog::warn("[ChatServer {}] Nickname '{}' belongs to an account the session is not logged into.", fmt::ptr(this), nickname_copy);
+            net::post(session->get_strand(), [handler = std::move(handler)]() { handler(false); });
+            return;
+        }
+    }
+    if (cluster_bus_) {
+        claim_nickname_in_cluster(nickname_copy, session, std::move(handler));
+        return;
+    }
+
+    bool final_result = register_nickname_local(nickname_copy, session);
+    // Post the result back to the original context (usually io_context)
+    net::post(session->get_strand(), [handler = std::move(handler), final_result]() { handler(final_result); });
+}
+
+/**
+ * @details `nicknames_mutex_`로 `nicknames_` 맵을 보호하면서 다음을 수행합니다:
+ *          1. 요청된 닉네임이 이미 사용 중인지 확인합니다.
+ *             - 사용 중이지만 `weak_ptr`이 만료되었다면, 해당 항목을 제거하고 등록 가능으로 처리합니다.
+ *             - 같은 세션이 재요청한 경우 등록 가능으로 처리합니다.
+ *          2. 등록이 가능하다면, 이전 닉네임이 있었다면 해당 매핑을 제거합니다.
+ *          3. 새로운 닉네임과 세션을 `nicknames_` 맵에 등록합니다.
+ */
+bool ChatServer::register_nickname_local(const std::string &nickname_copy, const SessionPtr &session, bool check_only)
+{
+    bool success = false;
+    std::string old_nick = session->nickname();
+    bool can_register = false;
+
+    // Lock the nicknames_ mutex before accessing the map
+    {
+        std::lock_guard<std::mutex> lock(nicknames_mutex_); 
+        auto it = nicknames_.find(nickname_copy);
         
         if (it == nicknames_.end()) {
             can_register = true;
@@ -449,12 +1390,18 @@ void ChatServer::try_register_nickname_impl(const std::string &nickname_copy,
             }
         }
 
+        if (check_only) {
+            return can_register;
+        }
+
         if (can_register) {
             // Remove old nickname mapping *if* it belongs to the current session
             if (!old_nick.empty() && old_nick != nickname_copy && old_nick != session->remote_id()) {
                 auto old_it = nicknames_.find(old_nick);
                 // Check if the old nickname exists and points to the same session
-                if (auto locked_old_session = old_it->second.lock(); locked_old_session == session) {
+                if (old_it == nicknames_.end()) {
+                    // Old nickname was never registered (or already removed)
+                } else if (auto locked_old_session = old_it->second.lock(); locked_old_session == session) {
                    nicknames_.erase(old_it); // Erase requires the lock
                    spdlog::info("[ChatServer {}] Removed old nickname '{}' for session {} (strand).", fmt::ptr(this), old_nick, fmt::ptr(session.get()));
                 } else if (!locked_old_session) {
@@ -470,20 +1417,80 @@ void ChatServer::try_register_nickname_impl(const std::string &nickname_copy,
         }
     } // Mutex lock scope ends here
 
-    bool final_result = success;
-    // Post the result back to the original context (usually io_context)
-    net::post(session->get_strand(), [handler = std::move(handler), final_result]() { handler(final_result); });
+    if (success && nickname_copy != old_nick)
+        rename_in_rooms(session, nickname_copy);
+    return success;
+}
+
+/**
+ * @details 같은 닉네임에 대한 선점 요청이 이미 진행 중이면 바로 실패합니다.
+ *          디렉터리 노드가 이 노드이면 임대 목록에서 바로 결정하고, 아니면 `NickClaim`을 보내
+ *          `NickClaimResult`가 올 때까지 요청을 보관합니다. 임대 기간 안에 응답이 없으면 실패로 처리합니다.
+ */
+void ChatServer::claim_nickname_in_cluster(const std::string &nickname, const SessionPtr &session,
+                                           std::function<void(bool)> handler)
+{
+    if (!register_nickname_local(nickname, session, true) || pending_nick_claims_.count(nickname) > 0)
+    {
+        net::post(session->get_strand(), [handler = std::move(handler)]() { handler(false); });
+        return;
+    }
+
+    std::string directory = nickname_directory_node(nickname);
+    if (directory == node_id_)
+    {
+        bool granted;
+        {
+            std::lock_guard<std::mutex> lock(cluster_mutex_);
+            granted = nick_directory_.claim(nickname, node_id_, NicknameDirectory::clock::now());
+        }
+        finish_nickname_claim(nickname, session, std::move(handler), granted);
+        return;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + cluster_heartbeat_interval_ * 3;
+    pending_nick_claims_[nickname] = PendingNicknameClaim{session, std::move(handler), deadline};
+    publish_to_cluster(ClusterMessage::Kind::NickClaim, nickname, "system", "", directory);
+}
+
+/**
+ * @details 승인되었더라도 그 사이 세션이 종료되었거나 로컬에서 닉네임이 선점되었으면 임대를 반납합니다.
+ *          등록에 성공하면 세션의 이전 닉네임 임대도 반납합니다.
+ */
+void ChatServer::finish_nickname_claim(const std::string &nickname, std::weak_ptr<SessionInterface> weak_session,
+                                       std::function<void(bool)> handler, bool granted)
+{
+    SessionPtr session = weak_session.lock();
+    if (!session)
+    {
+        if (granted)
+            release_nickname_lease(nickname);
+        net::post(ioc_, [handler = std::move(handler)]() { handler(false); });
+        return;
+    }
+    if (!granted)
+        spdlog::error("[ChatServer {}] Nickname '{}' is leased to another node.", fmt::ptr(this), nickname);
+
+    std::string old_nick = session->nickname();
+    bool success = granted && register_nickname_local(nickname, session);
+    if (granted && !success)
+        release_nickname_lease(nickname);
+    if (success && !old_nick.empty() && old_nick != nickname && old_nick != session->remote_id())
+        release_nickname_lease(old_nick);
+
+    net::post(session->get_strand(), [handler = std::move(handler), success]() { handler(success); });
 }
 
 /**
  * @details `nicknames_mutex_`로 보호하면서 `nicknames_` 맵에서 해당 닉네임을 찾아 제거합니다.
+ *          클러스터 모드에서는 디렉터리 노드에 닉네임 임대도 반납합니다.
  */
 void ChatServer::unregister_nickname(const std::string &nickname)
 {
     if (nickname.empty())
         return;
     // Lock the mutex before accessing nicknames_
-    std::lock_guard<std::mutex> lock(nicknames_mutex_); 
+    std::unique_lock<std::mutex> lock(nicknames_mutex_); 
     auto it = nicknames_.find(nickname);
     if (it != nicknames_.end()) {
         // We might want to double-check if the weak_ptr matches the session being removed,
@@ -491,6 +1498,8 @@ void ChatServer::unregister_nickname(const std::string &nickname)
         nicknames_.erase(it);
         spdlog::info("[ChatServer {}] Nickname '{}' unregistered (strand).", fmt::ptr(this), nickname);
     }
+    lock.unlock();
+    release_nickname_lease(nickname);
 }
 
 /**
@@ -565,36 +1574,35 @@ void ChatServer::get_user_list_async(std::function<void(std::vector<std::string>
 
 /**
  * @brief 사용자를 특정 채팅방에 참여시킵니다. (동기 버전)
+ * @details 방 -> 멤버 색인(`ChatRoom::participants_`)과 세션 -> 방 색인(`session_rooms_`)을
+ *          `rooms_mutex_` 아래에서 함께 갱신하므로 입장/퇴장은 참여 중인 방 수와 무관하게 상수 시간입니다.
  */
 bool ChatServer::join_room(const std::string& room_name, SessionPtr session)
 {
     if (stopped_ || !session) return false;
     
-    bool success = false;
-    std::string old_room_name = session->current_room();
     std::string nickname = session->nickname();
     std::shared_ptr<ChatRoom> target_room = nullptr;
+    std::string join_confirm;
+    std::string join_notice;
     
     {
         std::lock_guard<std::mutex> lock(rooms_mutex_);
-        if (!old_room_name.empty() && old_room_name != room_name)
+        auto joined_it = session_rooms_.find(session.get());
+        if (joined_it != session_rooms_.end() && joined_it->second.count(room_name) > 0)
         {
-            auto old_room_it = rooms_.find(old_room_name);
-            if (old_room_it != rooms_.end())
-            {
-                auto& old_room = old_room_it->second;
-                std::string leave_notice = "* 사용자 '" + nickname + "'님이 '" + old_room_name + "' 방에서 나갔습니다.\r\n";
-                old_room->broadcast(leave_notice, session);
-                old_room->remove_participant(session);
-                spdlog::info("User '{}' removed from old room '{}'", nickname, old_room_name);
-                if (old_room->empty())
-                {
-                    rooms_.erase(old_room_it);
-                    spdlog::info("Old room '{}' removed.", old_room_name);
-                }
-            }
+            // 이미 참여 중인 방: 활성 방만 바꾼다.
+            session->set_current_room(room_name);
+            session->deliver("* '" + room_name + "' 방이 활성 방이 되었습니다.\r\n");
+            return true;
+        }
+        if (joined_it != session_rooms_.end() && joined_it->second.size() >= max_rooms_per_session)
+        {
+            session->deliver("Error: 동시에 참여할 수 있는 방은 최대 " + std::to_string(max_rooms_per_session) + "개입니다.\r\n");
+            return false;
         }
         
+        bool created = false;
         auto room_it = rooms_.find(room_name);
         if (room_it == rooms_.end())
         {
@@ -602,6 +1610,8 @@ bool ChatServer::join_room(const std::string& room_name, SessionPtr session)
             {
                 target_room = std::make_shared<ChatRoom>(room_name);
                 rooms_[room_name] = target_room;
+                created = true;
+                on_local_room_created(room_name);
                 spdlog::info("Created new room: {}", room_name);
             }
             catch (const std::exception& e)
@@ -615,47 +1625,44 @@ bool ChatServer::join_room(const std::string& room_name, SessionPtr session)
             target_room = room_it->second;
         }
         
-        if (target_room)
-        {
-            target_room->add_participant(session);
-            session->set_current_room(room_name);
-            success = true;
-        }
-    }
-    
-    if (success && target_room)
-    {
-        std::string join_confirm = "* '" + room_name + "' 방에 입장했습니다.\r\n";
-        auto members = target_room->sessions();
-        join_confirm += "* 현재 멤버 (" + std::to_string(members.size()) + "): ";
-        bool first = true;
-        size_t valid_member_count = 0;
-        std::string member_list_str;
-        
-        for (const auto& member : members)
+        if (!target_room)
+            return false;
+        if (!target_room->add_participant(session))
         {
-            if (member)
+            if (created)
             {
-                valid_member_count++;
-                if (!first)
-                    member_list_str += ", ";
-                member_list_str += member->nickname() + (member == session ? " (You)" : "");
-                first = false;
+                rooms_.erase(room_name);
+                on_local_room_removed(room_name);
             }
+            return false;
         }
-        join_confirm.replace(join_confirm.find(std::to_string(members.size())), 
-                             std::to_string(members.size()).length(), 
-                             std::to_string(valid_member_count));
-        join_confirm += member_list_str;
-        join_confirm += "\r\n";
-        session->deliver(join_confirm);
-        
-        std::string join_notice = "* 사용자 '" + nickname + "'님이 방에 들어왔습니다.\r\n";
-        target_room->broadcast(join_notice, session);
-        spdlog::info("User '{}' joined room '{}' successfully.", nickname, room_name);
+        session_rooms_[session.get()].insert(room_name);
+        session->set_current_room(room_name);
+
+        // 입장한 세션에는 캐시된 첫 페이지만, 기존 멤버에게는 변경분(입장한 닉네임)과 명단 버전만 보낸다.
+        // 입장한 세션은 명단 맨 끝에 붙으므로, 한 페이지면 캐시된 페이지 바로 뒤에 "(You)"를 붙이면 자기 이름에 붙는다.
+        std::size_t member_count = target_room->participant_count();
+        std::string version = " [v" + std::to_string(target_room->roster_version()) + "]";
+        join_confirm = "* '" + room_name + "' 방에 입장했습니다.\r\n";
+        join_confirm += "* 현재 멤버 (" + std::to_string(member_count) + "): " + target_room->roster_page(1);
+        if (target_room->roster_page_count() > 1)
+        {
+            join_confirm += " 외 " + std::to_string(member_count - ChatRoom::roster_page_size) + "명 (" +
+                            nickname + " (You) 포함, /members " + room_name + " 2)";
+        }
+        else
+        {
+            join_confirm += " (You)";
+        }
+        join_confirm += version + "\r\n";
+        join_notice = "* 사용자 '" + nickname + "'님이 방에 들어왔습니다." + version + "\r\n";
     }
     
-    return success;
+    session->deliver(join_confirm);
+    deliver_room_notice(target_room, join_notice, session);
+    spdlog::info("User '{}' joined room '{}' successfully.", nickname, room_name);
+    
+    return true;
 }
 
 void ChatServer::join_room_async(const std::string& room_name,
@@ -692,76 +1699,184 @@ bool ChatServer::leave_room(const std::string& room_name, SessionPtr session)
 {
     if (stopped_ || !session) return false;
     
-    bool success = false;
     std::string nickname = session->nickname();
-    std::shared_ptr<ChatRoom> room_ptr = nullptr;
+    std::string next_active = session->current_room();
     
     {
         std::lock_guard<std::mutex> lock(rooms_mutex_);
+        auto joined_it = session_rooms_.find(session.get());
+        if (joined_it == session_rooms_.end() || joined_it->second.erase(room_name) == 0)
+        {
+            spdlog::error("Attempted to leave room '{}' but '{}' is not a member.", room_name, nickname);
+            return false;
+        }
+        if (next_active == room_name)
+            next_active = joined_it->second.empty() ? "" : *joined_it->second.begin();
+        if (joined_it->second.empty())
+            session_rooms_.erase(joined_it);
+        
         auto room_it = rooms_.find(room_name);
         if (room_it != rooms_.end())
         {
-            room_ptr = room_it->second;
-            std::string leave_notice = "* 사용자 '" + nickname + "'님이 '" + room_name + "' 방에서 나갔습니다.\r\n";
-            room_ptr->broadcast(leave_notice, session);
+            auto room_ptr = room_it->second;
             room_ptr->remove_participant(session);
+            std::string leave_notice = "* 사용자 '" + nickname + "'님이 '" + room_name + "' 방에서 나갔습니다. [v" +
+                                       std::to_string(room_ptr->roster_version()) + "]\r\n";
+            deliver_room_notice(room_ptr, leave_notice, session);
             spdlog::info("User '{}' left room '{}'.", nickname, room_name);
             if (room_ptr->empty())
             {
                 spdlog::info("Room '{}' is empty, removing.", room_name);
                 rooms_.erase(room_it);
+                on_local_room_removed(room_name);
             }
-            success = true;
         }
-        else
+    }
+    
+    session->set_current_room(next_active);
+    session->deliver("* '" + room_name + "' 방에서 퇴장했습니다.\r\n");
+    return true;
+}
+
+void ChatServer::leave_room_async(const std::string& room_name,
+                                 SessionPtr session,
+                                 std::function<void(bool)> handler)
+{
+    if (stopped_)
+    {
+        net::post(ioc_, [handler]() { handler(false); });
+        return;
+    }
+    if (!session || room_name.empty())
+    {
+        spdlog::error("Leave room request invalid: session null or empty room name '{}'", room_name);
+        net::post(ioc_, [handler]() { handler(false); });
+        return;
+    }
+    
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, room_name, session, handler = std::move(handler)]() mutable {
+        bool result = leave_room(room_name, session);
+        net::post(ioc_, [handler = std::move(handler), result]() {
+             handler(result);
+        });
+    });
+}
+
+void ChatServer::leave_all_rooms_impl(const SessionPtr& session)
+{
+    if (!session) return;
+    
+    for (const auto& room_name : rooms_of(session))
+    {
+        leave_room(room_name, session);
+    }
+}
+
+bool ChatServer::is_in_room(const std::string& room_name, const SessionPtr& session)
+{
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto joined_it = session_rooms_.find(session.get());
+    return joined_it != session_rooms_.end() && joined_it->second.count(room_name) > 0;
+}
+
+std::vector<std::string> ChatServer::rooms_of(const SessionPtr& session)
+{
+    std::vector<std::string> result;
+    {
+        std::lock_guard<std::mutex> lock(rooms_mutex_);
+        auto joined_it = session_rooms_.find(session.get());
+        if (joined_it != session_rooms_.end())
+            result.assign(joined_it->second.begin(), joined_it->second.end());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::string ChatServer::room_roster_page(const std::string& room_name, std::size_t page)
+{
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto room_it = rooms_.find(room_name);
+    if (room_it == rooms_.end())
+        return "";
+    const auto& room = room_it->second;
+    if (page == 0 || page > room->roster_page_count())
+        return "";
+    return "* '" + room_name + "' 멤버 (" + std::to_string(room->participant_count()) + ") " +
+           std::to_string(page) + "/" + std::to_string(room->roster_page_count()) +
+           " [v" + std::to_string(room->roster_version()) + "]: " + room->roster_page(page) + "\r\n";
+}
+
+void ChatServer::rename_in_rooms(const SessionPtr& session, const std::string& nickname)
+{
+    std::lock_guard<std::mutex> lock(rooms_mutex_);
+    auto joined_it = session_rooms_.find(session.get());
+    if (joined_it == session_rooms_.end())
+        return;
+    for (const auto& room_name : joined_it->second)
+    {
+        auto room_it = rooms_.find(room_name);
+        if (room_it != rooms_.end())
+            room_it->second->rename_participant(session, nickname);
+    }
+}
+
+bool ChatServer::send_ephemeral_event(const std::string& room_name, SessionPtr session, const std::string& kind)
+{
+    if (kind != "typing" && kind != "active")
+        return false;
+    if (stopped_ || !session)
+        return true;
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, room_name, session, kind]() {
+        if (stopped_ || !is_in_room(room_name, session))
+            return;
+        if (ephemeral_.add(room_name, session->nickname(), kind))
         {
-            spdlog::error("Attempted to leave room '{}' but it was not found.", room_name);
+            ephemeral_timer_.expires_after(ephemeral_window_);
+            ephemeral_timer_.async_wait([this, self](boost::system::error_code ec) {
+                if (!ec && !stopped_)
+                    flush_ephemeral_events();
+            });
         }
-    }
-    
-    if (success)
-    {
-        session->set_current_room("");
-        session->deliver("* '" + room_name + "' 방에서 퇴장했습니다.\r\n");
-    }
-    
-    return success;
+    });
+    return true;
 }
 
-void ChatServer::leave_room_async(const std::string& room_name,
-                                 SessionPtr session,
-                                 std::function<void(bool)> handler)
+/**
+ * @details 방 멤버 목록은 묶음마다 한 번만 복사하고, 각 세션에는 `deliver_ephemeral`로 전달하여
+ *          전송이 밀린 세션에서는 일반 메시지보다 먼저 버려지게 합니다.
+ */
+void ChatServer::flush_ephemeral_events()
 {
-    if (stopped_)
+    for (const auto& batch : ephemeral_.flush())
     {
-        net::post(ioc_, [handler]() { handler(false); });
-        return;
+        std::vector<SessionPtr> members;
+        {
+            std::lock_guard<std::mutex> lock(rooms_mutex_);
+            auto room_it = rooms_.find(batch.room);
+            if (room_it == rooms_.end())
+                continue;
+            members.assign(room_it->second->sessions().begin(), room_it->second->sessions().end());
+        }
+        for (const auto& member : members)
+            member->deliver_ephemeral(batch.line);
     }
-    if (!session || room_name.empty() || session->current_room() != room_name)
+    if (!ephemeral_.empty())
     {
-        spdlog::error("Leave room request invalid: session null, empty room name, or not in room '{}'", room_name);
-        net::post(ioc_, [handler]() { handler(false); });
-        return;
-    }
-    
-    auto self = shared_from_this();
-    net::dispatch(strand_, [this, self, room_name, session, handler = std::move(handler)]() mutable {
-        bool result = leave_room(room_name, session);
-        net::post(ioc_, [handler = std::move(handler), result]() {
-             handler(result);
+        ephemeral_timer_.expires_after(ephemeral_window_);
+        ephemeral_timer_.async_wait([this, self = shared_from_this()](boost::system::error_code ec) {
+            if (!ec && !stopped_)
+                flush_ephemeral_events();
         });
-    });
+    }
 }
 
-void ChatServer::leave_all_rooms_impl(const SessionPtr& session)
+void ChatServer::deliver_room_notice(const std::shared_ptr<ChatRoom>& room, const std::string& notice, const SessionPtr& exclude)
 {
-    if (!session) return;
-    
-    std::string current_room = session->current_room();
-    if (!current_room.empty())
-    {
-        leave_room(current_room, session);
-    }
+    channel_log_.append(room->name(), room->format_message(notice, "system"), [&](std::uint64_t, const std::string &stamped) {
+        room->deliver_formatted(stamped, exclude);
+    });
 }
 
 bool ChatServer::load_config()
@@ -778,14 +1893,150 @@ bool ChatServer::save_config()
 
 bool ChatServer::load_users()
 {
-    spdlog::info("[Server {}] load_users() (Placeholder)", fmt::ptr(this));
+    users_ = std::make_unique<UserStore>(users_path_);
+    if (!users_->is_open())
+    {
+        spdlog::error("[Server {}] Failed to open user store '{}'", fmt::ptr(this), users_path_);
+        return false;
+    }
+    spdlog::info("[Server {}] Loaded {} user accounts", fmt::ptr(this), users_->size());
     return true;
 }
 
 bool ChatServer::save_users()
 {
-    spdlog::info("[Server {}] save_users() (Placeholder)", fmt::ptr(this));
-    return true;
+    if (!users_ || !users_->is_open())
+        return true;
+    return users_->compact();
+}
+
+/**
+ * @details 계정 저장소는 닫아도 마지막 상태를 계속 읽을 수 있으므로, drain 중인 세션의 로그인 확인은 그대로 동작합니다.
+ *          히스토리는 줄 번호가 이 프로세스 메모리에만 있어 새 프로세스와 함께 쓰면 파일이 깨지므로 완전히 닫습니다.
+ *          drain 중인 세션의 메시지는 전달되지만 기록되지 않고, 스크롤백과 검색은 빈 결과를 돌려줍니다.
+ *          복제기도 여기서 멈춥니다. 새 프로세스의 복제기와 같은 팔로워에 번갈아 접속하면 팔로워가 식별값이 바뀔 때마다
+ *          적용 위치를 되돌려 기록이 중복되고 빠진 구간으로 표시되기 때문입니다.
+ */
+void ChatServer::release_storage()
+{
+    if (history_replicator_)
+    {
+        history_replicator_->stop();
+    }
+    if (history_)
+    {
+        history_->close();
+        spdlog::info("[ChatServer {}] History released for the new process.", fmt::ptr(this));
+    }
+    if (users_)
+    {
+        users_->close();
+        spdlog::info("[ChatServer {}] User store released for the new process.", fmt::ptr(this));
+    }
+}
+
+void ChatServer::set_password_hashing(std::size_t threads, std::size_t max_queue, KdfParams params)
+{
+    password_hasher_ = std::make_unique<PasswordHasher>(threads, max_queue, params);
+}
+
+/**
+ * @details 계정 조회는 저장소의 변경이나 합치기를 기다리지 않고 끝나고, 비밀번호 확인만 작업 스레드로 넘긴다.
+ *          없는 사용자명이면 같은 비용으로 해시만 계산하고 실패로 답하여, 응답 시간으로 계정 존재 여부를 알 수 없게 한다.
+ */
+void ChatServer::authenticate_user_async(const std::string &username, const std::string &password, SessionPtr session,
+                                         std::function<void(AuthStatus, std::string)> handler)
+{
+    if (!session || stopped_)
+        return;
+    auto self = shared_from_this();
+    auto finish = [this, self, session, username, handler](bool ok) {
+        std::string token = ok ? login_tokens_.issue(username) : std::string();
+        if (ok)
+            spdlog::info("[ChatServer {}] User '{}' logged in", fmt::ptr(this), username);
+        finish_login(session, username, ok, std::move(token), handler);
+    };
+
+    auto account = users_->find(username);
+    bool queued = account ? password_hasher_->verify_async(password, account->password_hash(), finish)
+                          : password_hasher_->hash_async(password, [finish](std::string) { finish(false); });
+    if (!queued) {
+        spdlog::warn("[ChatServer {}] Password hashing queue full. Rejecting login for '{}'", fmt::ptr(this), username);
+        net::post(session->get_strand(), [handler]() { handler(AuthStatus::Busy, ""); });
+    }
+}
+
+void ChatServer::authenticate_token_async(const std::string &username, const std::string &token, SessionPtr session,
+                                          std::function<void(AuthStatus, std::string)> handler)
+{
+    if (!session || stopped_)
+        return;
+    bool ok = !token.empty() && users_->contains(username) && login_tokens_.check(username, token);
+    finish_login(session, username, ok, ok ? token : std::string(), std::move(handler));
+}
+
+/**
+ * @details 계정은 응답보다 먼저 `strand_`에 기록하므로, 로그인 응답을 받은 직후의 `/search`도 귓속말을 볼 수 있습니다.
+ *          닉네임에 묶이기 전에 만든 계정은 이번 로그인 시각에 묶어, 그 전의 귓속말은 보여 주지 않습니다.
+ */
+void ChatServer::finish_login(SessionPtr session, const std::string &username, bool ok, std::string token,
+                              std::function<void(AuthStatus, std::string)> handler)
+{
+    if (ok) {
+        auto account = users_->find(username);
+        if (account && account->bound_at() == 0) {
+            UserAccount bound = *account;
+            bound.bind_nickname(unix_now());
+            users_->put(bound);
+        }
+    }
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, session, username, ok, token = std::move(token), handler = std::move(handler)]() mutable {
+        if (ok && sessions_.count(session) > 0)
+            session_accounts_[session.get()] = username;
+        net::post(session->get_strand(), [session, handler = std::move(handler), ok, token = std::move(token)]() {
+            if (ok)
+                session->set_authenticated(true);
+            handler(ok ? AuthStatus::Ok : AuthStatus::Failed, token);
+        });
+    });
+}
+
+/**
+ * @details 이미 있는 사용자명은 해시를 계산하기 전에 거절하고, 해시가 끝난 뒤에는 `UserStore::insert`로 다시 확인하여
+ *          같은 사용자명으로 동시에 등록해도 하나만 성공한다.
+ */
+void ChatServer::register_user_async(const std::string &username, const std::string &password, SessionPtr session,
+                                     std::function<void(AuthStatus)> handler)
+{
+    if (!session || stopped_)
+        return;
+    bool valid = !username.empty() && username.size() <= max_username_length && !password.empty() &&
+                 password.size() <= max_password_length &&
+                 std::none_of(username.begin(), username.end(), [](unsigned char c) { return c <= 0x20 || c == 0x7F; });
+    bool nickname_taken;
+    {
+        std::lock_guard<std::mutex> lock(nicknames_mutex_);
+        auto it = nicknames_.find(username);
+        nickname_taken = it != nicknames_.end() && !it->second.expired() && it->second.lock() != session;
+    }
+    if (!valid || nickname_taken || users_->contains(username)) {
+        net::post(session->get_strand(), [handler = std::move(handler)]() { handler(AuthStatus::Failed); });
+        return;
+    }
+    auto self = shared_from_this();
+    bool queued = password_hasher_->hash_async(password, [this, self, session, username, handler](std::string encoded) {
+        UserAccount account(username, encoded);
+        account.bind_nickname(unix_now());
+        bool ok = !encoded.empty() && users_->insert(account);
+        if (ok)
+            spdlog::info("[ChatServer {}] Registered user '{}'", fmt::ptr(this), username);
+        net::post(session->get_strand(), [handler, ok]() { handler(ok ? AuthStatus::Ok : AuthStatus::Failed); });
+    });
+    if (!queued) {
+        spdlog::warn("[ChatServer {}] Password hashing queue full. Rejecting registration for '{}'", fmt::ptr(this), username);
+        net::post(session->get_strand(), [handler]() { handler(AuthStatus::Busy); });
+    }
 }
 
 void ChatServer::set_history_enabled(bool enable)
@@ -799,6 +2050,47 @@ bool ChatServer::is_history_enabled() const
     return history_ ? history_->is_enabled() : false; 
 }
 
+void ChatServer::set_history_retention(const RetentionConfig& config)
+{
+    if (history_)
+        history_->set_retention(config);
+}
+
+void ChatServer::enable_history_replication(std::shared_ptr<HistoryReplicator> replicator, bool serve_reads)
+{
+    if (!replicator || !history_)
+        return;
+    history_replicator_ = std::move(replicator);
+    replica_reads_ = serve_reads;
+    history_->set_append_listener([replicator = history_replicator_](const HistoryRecord &record) {
+        replicator->publish(record);
+    });
+    history_replicator_->start();
+    spdlog::info("[ChatServer {}] History replication enabled (reads from follower: {}).", fmt::ptr(this), serve_reads);
+}
+
+/**
+ * @details 팔로워가 실패하면 같은 질의를 `ioc_`에서 다시 실행하므로, 팔로워가 없어도 결과는 항상 돌아옵니다.
+ */
+void ChatServer::read_history_async(HistoryQuery query, std::function<void(HistoryQueryResult)> done)
+{
+    auto self = shared_from_this();
+    auto read_local = [this, self](const HistoryQuery &query, const std::function<void(HistoryQueryResult)> &done) {
+        done(history_ && !stopped_ ? run_history_query(*history_, query) : HistoryQueryResult{});
+    };
+    if (!history_replicator_ || !replica_reads_ || !history_replicator_->readable())
+    {
+        net::post(ioc_, [read_local, query = std::move(query), done = std::move(done)]() { read_local(query, done); });
+        return;
+    }
+    history_replicator_->query(query, replica_read_timeout,
+                               [this, self, read_local, query, done](bool ok, HistoryQueryResult result) mutable {
+        if (ok)
+            return done(std::move(result));
+        net::post(ioc_, [read_local, query = std::move(query), done = std::move(done)]() { read_local(query, done); });
+    });
+}
+
 std::vector<std::string> ChatServer::load_global_history(size_t limit)
 {
     return history_ ? history_->load_global_history(limit) : std::vector<std::string>();
@@ -814,10 +2106,114 @@ std::vector<std::string> ChatServer::load_room_history(const std::string &room,
     return history_ ? history_->load_room_history(room, limit) : std::vector<std::string>();
 }
 
+/**
+ * @details 히스토리 파일을 읽을 수 있으므로 `ioc_`에서 실행하여 호출한 세션의 스트랜드를 막지 않습니다.
+ *          채널 메시지는 채널 잠금 안에서 `<시각> #<순번> [...]` 형식으로 기록되므로 히스토리 줄은 순번 순서대로 쌓입니다.
+ *          메모리 로그에서 밀려난 순번 구간의 줄만 순번으로 골라 보냅니다. 입장/퇴장 알림과 다른 노드에서 중계된 메시지는
+ *          순번만 받고 이 노드의 히스토리에는 없으므로 그 순번은 건너뜁니다.
+ *          끝에서부터 읽다가 순번이 없거나 줄지 않는 줄을 만나면 이전 실행(순번이 다시 1부터 시작)의 기록이므로 멈춥니다.
+ *          에포크가 다른 요청은 `ChannelLog::since`가 처음부터 보내도록 바꾸므로, 다른 실행의 순번으로 구간을 고르지 않습니다.
+ */
+void ChatServer::replay_channel_async(const std::string &channel, const std::string &epoch, std::uint64_t after_seq,
+                                      SessionPtr session)
+{
+    if (stopped_ || !session)
+        return;
+    auto self = shared_from_this();
+    net::post(ioc_, [this, self, channel, epoch, after_seq, session]() {
+        if (stopped_)
+            return;
+        auto replay = std::make_shared<ChannelLog::Replay>(channel_log_.since(channel, epoch, after_seq));
+        // 히스토리에서 보낼 순번 구간 [first_seq, end_seq)
+        std::uint64_t end_seq = replay->entries.empty() ? replay->last_seq + 1 : replay->entries.front().seq;
+        std::uint64_t first_seq = end_seq - std::min(replay->missing, max_history_replay);
+
+        // 히스토리 줄(`lines`가 null이면 보내지 않음)과 메모리 로그의 메시지를 한 번에 보낸다.
+        auto finish = [this, self, channel, after_seq, session, replay, first_seq, end_seq](const std::vector<std::string> *lines) {
+            std::vector<std::string> out;
+            if (lines)
+            {
+                std::vector<const std::string *> picked;
+                std::uint64_t next = std::numeric_limits<std::uint64_t>::max();
+                for (auto it = lines->rbegin(); it != lines->rend(); ++it)
+                {
+                    std::uint64_t seq = MessageHistory::line_seq(*it);
+                    if (seq == 0 || seq >= next || seq < first_seq)
+                        break;
+                    next = seq;
+                    if (seq < end_seq)
+                        picked.push_back(&*it);
+                }
+                out.push_back("* REPLAY_HISTORY " + channel + " " + std::to_string(picked.size()) + "\r\n");
+                for (auto it = picked.rbegin(); it != picked.rend(); ++it)
+                    out.push_back(**it + "\r\n");
+            }
+            for (auto &entry : replay->entries)
+                out.push_back(std::move(entry.message));
+            out.push_back("* REPLAY_END " + channel + " " + replay->epoch + "." + std::to_string(replay->last_seq) + "\r\n");
+
+            spdlog::debug("[ChatServer {}] Replaying channel '{}' after #{} to {}: {} from log, {} missing.",
+                          fmt::ptr(this), channel, after_seq, session->remote_id(), replay->entries.size(), replay->missing);
+            net::post(session->get_strand(), [session, out = std::move(out)]() {
+                for (const auto &msg : out)
+                    session->deliver(msg);
+            });
+        };
+
+        if (replay->missing == 0 || !is_history_enabled())
+            return finish(nullptr);
+        HistoryQuery query;
+        query.kind = channel == ChannelLog::global_channel ? HistoryQuery::Kind::Global : HistoryQuery::Kind::Room;
+        query.room = channel;
+        // 순번마다 줄이 많아야 하나이므로, 지금까지 붙은 순번 수만큼 읽으면 구간의 줄이 모두 들어온다.
+        query.limit = channel_log_.last_seq(channel) + 1 - first_seq;
+        read_history_async(std::move(query), [finish](HistoryQueryResult result) {
+            finish(&result.lines);
+        });
+    });
+}
+
+/**
+ * @details 색인 조회와 결과 줄 읽기를 `ioc_`(또는 팔로워)에서 실행하여 세션 스트랜드와 브로드캐스트 경로를 막지 않습니다.
+ *          결과는 한 번의 `deliver`로 보내 다른 메시지와 섞이지 않게 합니다.
+ */
+void ChatServer::search_history_async(const std::string &query, const std::string &room, std::size_t page, SessionPtr session)
+{
+    if (stopped_ || !session || !history_)
+        return;
+    std::size_t page_index = page == 0 ? 0 : page - 1;
+    HistoryQuery search;
+    search.kind = HistoryQuery::Kind::Search;
+    search.text = query;
+    search.room = room;
+    search.offset = page_index * search_page_size;
+    search.limit = search_page_size;
+    auto self = shared_from_this();
+    net::dispatch(strand_, [this, self, search = std::move(search), query, page_index, session]() mutable {
+        // 그 닉네임의 계정으로 로그인한 세션에만, 닉네임을 계정에 묶은 뒤의 귓속말을 보여 준다.
+        auto account = session_accounts_.find(session.get());
+        if (account != session_accounts_.end() && account->second == session->nickname()) {
+            auto stored = users_->find(account->second);
+            search.nickname = session->nickname();
+            search.private_since = stored ? stored->bound_at() : unix_now();
+        }
+        read_history_async(std::move(search), [this, query, page_index, session](HistoryQueryResult result) {
+            std::uint64_t pages = std::max<std::uint64_t>(1, (result.total + search_page_size - 1) / search_page_size);
+
+            std::string out = "* SEARCH " + std::to_string(result.total) + " " + std::to_string(page_index + 1) + "/" +
+                              std::to_string(pages) + "\r\n";
+            for (const auto &line : result.lines)
+                out += "  " + line + "\r\n";
+
+            spdlog::debug("[ChatServer {}] Search '{}' by {}: {} hit(s).", fmt::ptr(this), query, session->nickname(), result.total);
+            net::post(session->get_strand(), [session, out = std::move(out)]() { session->deliver(out); });
+        });
+    });
+}
+
 std::string ChatServer::hash_password(const std::string &password)
 {
-    spdlog::info("hash_password (Placeholder - DO NOT USE IN PRODUCTION)");
-    return "hashed_" + password;
+    return PasswordHasher::hash(password, password_hasher_->params());
 }
 
 void ChatServer::system_broadcast(const std::string &message) 
@@ -825,28 +2221,327 @@ void ChatServer::system_broadcast(const std::string &message)
     broadcast(message, nullptr); 
 }
 
-UserAccount::UserAccount(const std::string &username, const std::string &password_hash, bool is_admin)
-    : username_(username), password_hash_(password_hash), is_admin_(is_admin) {}
+/**
+ * @details 전송 ID는 64비트 난수의 16진수 표현이며, 바이너리 프레임 앞에 그대로 붙어 어떤 전송의 조각인지 나타냅니다.
+ *          수신자는 이 노드에 접속한 세션만 가능합니다. (클러스터의 다른 노드로는 중계하지 않습니다.)
+ */
+std::string ChatServer::init_file_transfer(const std::string &filename, size_t filesize, SessionPtr sender, const std::string &receiver_nick)
+{
+    if (stopped_ || !sender || filename.empty() || filesize == 0 || filesize > max_file_size)
+        return "";
+    SessionPtr receiver;
+    {
+        std::lock_guard<std::mutex> lock(nicknames_mutex_);
+        auto it = nicknames_.find(receiver_nick);
+        if (it != nicknames_.end())
+            receiver = it->second.lock();
+    }
+    if (!receiver || receiver == sender)
+        return "";
 
-bool UserAccount::check_password(const std::string &ph) const 
-{ 
-    return password_hash_ == ph; 
+    std::string id;
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        static thread_local std::mt19937_64 rng{std::random_device{}()};
+        do
+        {
+            char buffer[file_id_length + 1];
+            std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(rng()));
+            id = buffer;
+        } while (file_transfers_.count(id) > 0);
+        file_transfers_[id].info = std::make_shared<FileTransferInfo>(id, filename, filesize, sender, receiver);
+    }
+    spdlog::info("[ChatServer {}] File transfer {} offered: {} -> {} ({} bytes)",
+                 fmt::ptr(this), id, sender->nickname(), receiver_nick, filesize);
+    receiver->deliver("* FILE_OFFER " + id + " " + sender->nickname() + " " + std::to_string(filesize) + " " + filename + "\r\n");
+    return id;
 }
 
-void UserAccount::set_password(const std::string &nph) 
-{ 
-    password_hash_ = nph; 
+bool ChatServer::accept_file_transfer(const std::string &transfer_id, SessionPtr session)
+{
+    SessionPtr sender;
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        auto it = file_transfers_.find(transfer_id);
+        if (it == file_transfers_.end())
+            return false;
+        auto &info = *it->second.info;
+        if (info.receiver() != session || info.status() != FileTransferInfo::Status::Pending)
+            return false;
+        info.set_status(FileTransferInfo::Status::InProgress);
+        sender = info.sender();
+    }
+    sender->deliver("* FILE_ACCEPTED " + transfer_id + "\r\n");
+    return true;
 }
 
-void UserAccount::set_admin(bool ia) 
-{ 
-    is_admin_ = ia; 
+bool ChatServer::reject_file_transfer(const std::string &transfer_id, SessionPtr session)
+{
+    SessionPtr sender;
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        auto it = file_transfers_.find(transfer_id);
+        if (it == file_transfers_.end())
+            return false;
+        auto &info = *it->second.info;
+        if (info.status() == FileTransferInfo::Status::Pending)
+        {
+            if (info.receiver() != session)
+                return false;
+            info.set_status(FileTransferInfo::Status::Rejected);
+            sender = info.sender();
+            file_transfers_.erase(it);
+        }
+        else if (info.sender() != session && info.receiver() != session)
+        {
+            return false;
+        }
+    }
+    if (sender)
+    {
+        sender->deliver("* FILE_REJECTED " + transfer_id + "\r\n");
+        return true;
+    }
+    fail_file_transfer(transfer_id, "cancelled");
+    return true;
+}
+
+/**
+ * @details 프레임은 수신자 전송 큐에 그대로 들어가므로 중계 과정에서 다시 복사하지 않습니다.
+ *          전송당 수신자 큐에는 최대 `file_chunk_window_`개(각 `max_file_chunk` 이하)의 조각만 있으므로
+ *          파일 크기와 관계없이 메모리 사용량이 제한되고, 같은 큐의 채팅 메시지도 조각 몇 개 뒤에서 바로 나갑니다.
+ *          임시 파일에 쌓인 조각이 있으면 순서를 지키기 위해 새 조각도 임시 파일 뒤에 쌓습니다.
+ *          임시 파일 쓰기는 전송별 strand로 넘겨 다른 전송이 `transfers_mutex_`에서 디스크 쓰기를 기다리지 않게 하고,
+ *          송신자는 쓰기가 끝난 뒤에 다시 읽게 하여 쓰기를 기다리는 조각이 메모리에 쌓이지 않게 합니다.
+ *          쓰기와 읽기 작업은 잠금 안에서 strand에 맡기므로 strand에서도 장부와 같은 순서로 실행됩니다.
+ */
+bool ChatServer::process_file_data(const std::string &transfer_id, std::shared_ptr<const std::string> frame,
+                                   SessionPtr session, std::function<void()> on_ready)
+{
+    if (!frame || frame->size() <= file_id_length)
+        return false;
+    std::size_t payload = frame->size() - file_id_length;
+
+    SessionPtr receiver;
+    std::shared_ptr<const std::string> to_deliver;
+    std::function<void()> resume;
+    std::string failure;
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        auto it = file_transfers_.find(transfer_id);
+        if (it == file_transfers_.end())
+            return false;
+        FileRelay &relay = it->second;
+        auto &info = *relay.info;
+        if (info.sender() != session || info.status() != FileTransferInfo::Status::InProgress)
+            return false;
+
+        if (payload > max_file_chunk || info.bytes_transferred() + payload > info.filesize())
+        {
+            failure = "size mismatch";
+        }
+        else
+        {
+            info.update_bytes_transferred(info.bytes_transferred() + payload);
+            bool window_full = relay.in_flight >= file_chunk_window_ || relay.spooled > 0;
+            if (window_full && !file_spill_dir_.empty())
+            {
+                if (!relay.spill)
+                {
+                    info.set_temp_path((std::filesystem::path(file_spill_dir_) / (transfer_id + ".part")).string());
+                    relay.spill = std::make_shared<FileRelay::Spill>(net::make_strand(ioc_));
+                }
+                ++relay.spooled;
+                auto spill = relay.spill;
+                net::post(spill->strand, [this, self = shared_from_this(), spill, transfer_id, path = info.temp_path(),
+                                          frame = std::move(frame), on_ready = std::move(on_ready)]()
+                          {
+                    if (!spill->file)
+                        spill->file = std::make_unique<FileSpool>(path);
+                    if (spill->file->push(*frame))
+                        on_ready();
+                    else
+                        fail_file_transfer(transfer_id, "spill failed"); });
+            }
+            else
+            {
+                ++relay.in_flight;
+                to_deliver = std::move(frame);
+                receiver = info.receiver();
+                if (relay.in_flight < file_chunk_window_ || !file_spill_dir_.empty())
+                    resume = std::move(on_ready);
+                else
+                {
+                    relay.paused_sender = std::move(on_ready);
+                    arm_file_stall_timer(transfer_id, relay);
+                }
+            }
+        }
+    }
+
+    if (!failure.empty())
+    {
+        fail_file_transfer(transfer_id, failure);
+        return false;
+    }
+    if (to_deliver)
+    {
+        auto self = shared_from_this();
+        if (!receiver->deliver_binary(to_deliver, [self, transfer_id]() { self->on_file_chunk_sent(transfer_id); }))
+        {
+            fail_file_transfer(transfer_id, "receiver cannot accept binary frames");
+            return false;
+        }
+    }
+    if (resume)
+        resume();
+    return true;
+}
+
+/**
+ * @details 임시 파일에 쌓인 조각이 있으면 그 조각으로 창을 다시 채우고, 없으면 멈춘 송신자를 깨웁니다.
+ *          마지막 조각까지 수신자에게 전달되면 전송을 완료합니다. 남은 조각을 임시 파일에서 읽지 못하면 전송을 실패시킵니다.
+ *          임시 파일 읽기는 쓰기와 마찬가지로 전송별 strand에서 하고, 창 자리는 잠금 안에서 미리 잡아 둡니다.
+ */
+void ChatServer::on_file_chunk_sent(const std::string &transfer_id)
+{
+    SessionPtr receiver;
+    std::function<void()> resume;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        auto it = file_transfers_.find(transfer_id);
+        if (it == file_transfers_.end())
+            return;
+        FileRelay &relay = it->second;
+        auto &info = *relay.info;
+        if (relay.in_flight > 0)
+            --relay.in_flight;
+        receiver = info.receiver();
+        if (relay.spooled > 0)
+        {
+            --relay.spooled;
+            ++relay.in_flight;
+            auto spill = relay.spill;
+            net::post(spill->strand, [this, self = shared_from_this(), spill, transfer_id, receiver]()
+                      {
+                auto chunk = spill->file ? spill->file->pop() : nullptr;
+                if (!chunk)
+                {
+                    fail_file_transfer(transfer_id, "spill read failed");
+                    return;
+                }
+                receiver->deliver_binary(chunk, [self, transfer_id]() { self->on_file_chunk_sent(transfer_id); }); });
+        }
+        else if (relay.paused_sender && relay.in_flight < file_chunk_window_)
+        {
+            resume = std::move(relay.paused_sender);
+            relay.paused_sender = nullptr;
+            if (relay.stall_timer)
+                relay.stall_timer->cancel();
+            relay.stall_timer.reset();
+        }
+        finished = relay.in_flight == 0 && relay.spooled == 0 && info.bytes_transferred() == info.filesize();
+    }
+
+    if (resume)
+        resume();
+    if (finished)
+        complete_file_transfer(transfer_id, receiver);
+}
+
+/**
+ * @details 송신자는 읽기를 멈춘 동안 `/rejectfile`도 보낼 수 없으므로, 수신자가 멈추면 서버가 대신 전송을 끝냅니다.
+ *          타이머가 울렸을 때 이미 송신자를 깨웠거나 다른 타이머로 바뀌었으면 아무것도 하지 않습니다.
+ *          전송 상태가 지워지면 타이머도 함께 소멸하면서 대기가 취소됩니다.
+ */
+void ChatServer::arm_file_stall_timer(const std::string &transfer_id, FileRelay &relay)
+{
+    if (file_stall_timeout_.count() <= 0)
+        return;
+    auto timer = std::make_shared<net::steady_timer>(strand_, file_stall_timeout_);
+    relay.stall_timer = timer;
+    timer->async_wait([this, self = shared_from_this(), transfer_id, armed = timer.get()](boost::system::error_code ec) {
+        if (ec || stopped_)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(transfers_mutex_);
+            auto it = file_transfers_.find(transfer_id);
+            if (it == file_transfers_.end() || !it->second.paused_sender || it->second.stall_timer.get() != armed)
+                return;
+        }
+        fail_file_transfer(transfer_id, "stalled");
+    });
+}
+
+bool ChatServer::complete_file_transfer(const std::string &transfer_id, SessionPtr session)
+{
+    std::shared_ptr<FileTransferInfo> info;
+    std::shared_ptr<FileRelay::Spill> spill; // 임시 파일 삭제는 잠금 밖에서
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        auto it = file_transfers_.find(transfer_id);
+        if (it == file_transfers_.end())
+            return false;
+        FileRelay &relay = it->second;
+        if (relay.info->sender() != session && relay.info->receiver() != session)
+            return false;
+        if (relay.info->status() != FileTransferInfo::Status::InProgress || relay.in_flight > 0 ||
+            relay.info->bytes_transferred() != relay.info->filesize() || relay.spooled > 0)
+            return false;
+        info = relay.info;
+        spill = std::move(relay.spill);
+        info->set_status(FileTransferInfo::Status::Completed);
+        file_transfers_.erase(it);
+    }
+    spdlog::info("[ChatServer {}] File transfer {} completed ({} bytes)", fmt::ptr(this), transfer_id, info->filesize());
+    std::string done = "* FILE_DONE " + transfer_id + "\r\n";
+    info->sender()->deliver(done);
+    info->receiver()->deliver(done);
+    return true;
+}
+
+/**
+ * @details 멈춘 송신자가 있으면 다시 읽게 합니다. 이후 이 전송의 프레임은 `process_file_data`에서 거부됩니다.
+ *          임시 파일은 `FileSpool`이 소멸하면서 삭제합니다. (남은 임시 파일 작업이 있으면 그 작업이 끝난 뒤)
+ */
+void ChatServer::fail_file_transfer(const std::string &transfer_id, const std::string &reason)
+{
+    std::shared_ptr<FileTransferInfo> info;
+    std::function<void()> resume;
+    std::shared_ptr<FileRelay::Spill> spill; // 임시 파일 삭제는 잠금 밖에서
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        auto it = file_transfers_.find(transfer_id);
+        if (it == file_transfers_.end())
+            return;
+        info = it->second.info;
+        resume = std::move(it->second.paused_sender);
+        spill = std::move(it->second.spill);
+        info->set_status(FileTransferInfo::Status::Failed);
+        file_transfers_.erase(it);
+    }
+    spdlog::warn("[ChatServer {}] File transfer {} failed: {}", fmt::ptr(this), transfer_id, reason);
+    std::string failed = "* FILE_FAILED " + transfer_id + " " + reason + "\r\n";
+    info->sender()->deliver(failed);
+    info->receiver()->deliver(failed);
+    if (resume)
+        resume();
 }
 
-void UserAccount::update_login_info(const std::string &ip, const std::string &time)
+void ChatServer::abort_file_transfers(const SessionPtr &session)
 {
-    last_ip_ = ip;
-    last_login_ = time;
+    std::vector<std::string> ids;
+    {
+        std::lock_guard<std::mutex> lock(transfers_mutex_);
+        for (const auto &[id, relay] : file_transfers_)
+        {
+            if (relay.info->sender() == session || relay.info->receiver() == session)
+                ids.push_back(id);
+        }
+    }
+    for (const auto &id : ids)
+        fail_file_transfer(id, "disconnected");
 }
 
 FileTransferInfo::FileTransferInfo(const std::string &id, const std::string &filename, size_t filesize,
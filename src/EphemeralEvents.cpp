@@ -0,0 +1,51 @@
+/**
+ * @file EphemeralEvents.cpp
+ * @brief `EphemeralCoalescer` 클래스의 구현부입니다.
+ */
+
+#include "EphemeralEvents.hpp"
+
+#include <iterator>
+
+EphemeralCoalescer::EphemeralCoalescer(std::size_t max_users_per_flush)
+    : max_users_per_flush_(max_users_per_flush == 0 ? 1 : max_users_per_flush)
+{
+}
+
+bool EphemeralCoalescer::add(const std::string &room, const std::string &nickname, const std::string &kind)
+{
+    bool was_empty = pending_.empty();
+    pending_[room][nickname] = kind;
+    return was_empty;
+}
+
+/**
+ * @details 한 방의 이벤트를 종류별로 모아 `~ lobby typing:alice,bob active:carol` 한 줄로 만듭니다.
+ */
+std::vector<EphemeralCoalescer::Batch> EphemeralCoalescer::flush()
+{
+    std::vector<Batch> batches;
+    batches.reserve(pending_.size());
+    for (auto room_it = pending_.begin(); room_it != pending_.end();)
+    {
+        auto &users = room_it->second;
+        std::map<std::string, std::string> by_kind; // 종류 -> "alice,bob"
+        std::size_t taken = 0;
+        for (auto user_it = users.begin(); user_it != users.end() && taken < max_users_per_flush_; ++taken)
+        {
+            std::string &names = by_kind[user_it->second];
+            if (!names.empty())
+                names += ",";
+            names += user_it->first;
+            user_it = users.erase(user_it);
+        }
+
+        std::string line = "~ " + room_it->first;
+        for (const auto &[kind, names] : by_kind)
+            line += " " + kind + ":" + names;
+        batches.push_back(Batch{room_it->first, line + "\r\n"});
+
+        room_it = users.empty() ? pending_.erase(room_it) : std::next(room_it);
+    }
+    return batches;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file FileSpool.cpp
+ * @brief `FileSpool` 클래스의 구현부입니다.
+ */
+
+#include "FileSpool.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+FileSpool::FileSpool(std::string path)
+    : path_(std::move(path))
+{
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+}
+
+FileSpool::~FileSpool()
+{
+    file_.close();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+bool FileSpool::push(const std::string &frame)
+{
+    if (!file_.is_open())
+        return false;
+    std::uint32_t length = static_cast<std::uint32_t>(frame.size());
+    file_.clear();
+    file_.seekp(0, std::ios::end);
+    file_.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    file_.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+    if (!file_)
+        return false;
+    ++pending_;
+    return true;
+}
+
+/**
+ * @details 쓰기와 읽기가 같은 스트림을 쓰므로 매번 읽기 위치로 이동한 뒤 읽습니다.
+ *          디스크에서 읽은 프레임은 새 버퍼에 담기므로 이후 수신자 큐에서는 복사 없이 공유됩니다.
+ */
+std::shared_ptr<const std::string> FileSpool::pop()
+{
+    if (pending_ == 0 || !file_.is_open())
+        return nullptr;
+    std::uint32_t length = 0;
+    file_.clear();
+    file_.seekg(read_pos_);
+    file_.read(reinterpret_cast<char *>(&length), sizeof(length));
+    auto frame = std::make_shared<std::string>(length, '\0');
+    file_.read(frame->data(), static_cast<std::streamsize>(length));
+    if (!file_)
+        return nullptr;
+    read_pos_ += static_cast<std::streamoff>(sizeof(length) + length);
+    --pending_;
+    return frame;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file HistoryMaintenance.cpp
+ * @brief 히스토리 보존 정책 해석과 `IoRateLimiter`의 구현부입니다.
+ */
+
+#include "HistoryMaintenance.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+const RetentionPolicy& RetentionConfig::policy_for(const std::string& channel) const
+{
+    if (auto it = channels.find(channel); it != channels.end())
+        return it->second;
+    if (channel.rfind("rooms/", 0) == 0) {
+        if (auto it = channels.find("rooms"); it != channels.end())
+            return it->second;
+    }
+    return defaults;
+}
+
+bool RetentionConfig::parse_policy(const std::string& text, RetentionPolicy& policy)
+{
+    RetentionPolicy parsed;
+    std::istringstream parts(text);
+    std::string part;
+    bool any = false;
+    while (std::getline(parts, part, ':')) {
+        std::size_t digits = 0;
+        while (digits < part.size() && std::isdigit(static_cast<unsigned char>(part[digits])))
+            ++digits;
+        if (digits == 0)
+            return false;
+        std::uint64_t value = 0;
+        try {
+            value = std::stoull(part.substr(0, digits));
+        } catch (const std::out_of_range&) {
+            return false;
+        }
+        std::string unit = part.substr(digits);
+        std::transform(unit.begin(), unit.end(), unit.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (unit == "d")
+            parsed.max_age = std::chrono::hours(value * 24);
+        else if (unit == "h")
+            parsed.max_age = std::chrono::hours(value);
+        else if (unit == "gb")
+            parsed.max_bytes = value << 30;
+        else if (unit == "mb")
+            parsed.max_bytes = value << 20;
+        else if (unit == "kb")
+            parsed.max_bytes = value << 10;
+        else
+            return false;
+        any = true;
+    }
+    if (!any)
+        return false;
+    policy = parsed;
+    return true;
+}
+
+bool RetentionConfig::parse_overrides(const std::string& spec)
+{
+    bool ok = true;
+    std::istringstream entries(spec);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        entry.erase(0, entry.find_first_not_of(" \t"));
+        entry.erase(entry.find_last_not_of(" \t") + 1);
+        if (entry.empty())
+            continue;
+        auto eq = entry.find('=');
+        RetentionPolicy policy;
+        if (eq == std::string::npos || eq == 0 || !parse_policy(entry.substr(eq + 1), policy)) {
+            ok = false;
+            continue;
+        }
+        channels[entry.substr(0, eq)] = policy;
+    }
+    return ok;
+}
+
+IoRateLimiter::IoRateLimiter(std::uint64_t bytes_per_second)
+    : rate_(bytes_per_second),
+      tokens_(static_cast<double>(bytes_per_second)),
+      last_(std::chrono::steady_clock::now())
+{
+}
+
+/**
+ * @details 토큰이 모자라면 모자란 만큼 채워질 때까지 최대 100ms씩 나누어 자면서 `stop`을 확인합니다.
+ *          1초 분량보다 큰 요청도 토큰을 빚으로 남기고 통과시키므로, 평균 속도는 지키면서 큰 블록 하나에 막히지 않습니다.
+ */
+bool IoRateLimiter::acquire(std::uint64_t bytes, const std::atomic<bool>& stop)
+{
+    if (rate_ == 0)
+        return !stop;
+    while (!stop) {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_).count();
+        last_ = now;
+        tokens_ = std::min(static_cast<double>(rate_), tokens_ + elapsed * static_cast<double>(rate_));
+        if (tokens_ > 0) {
+            tokens_ -= static_cast<double>(bytes);
+            return true;
+        }
+        double wait = -tokens_ / static_cast<double>(rate_);
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(wait, 0.1)));
+    }
+    return false;
+}
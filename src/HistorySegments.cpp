@@ -0,0 +1,718 @@
+/**
+ * @file HistorySegments.cpp
+ * @brief `HistoryCodec`, `SegmentedLog` 클래스의 구현부입니다.
+ */
+
+#include "HistorySegments.hpp"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#ifdef CHERRY_HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    /// 사전 최대 크기
+    constexpr std::size_t dictionary_capacity = 16 * 1024;
+    /// 사전 학습에 필요한 최소 표본 수 (zstd는 표본이 너무 적으면 학습에 실패)
+    constexpr std::size_t min_training_samples = 256;
+    /// 줄 앞의 시각 길이 (`YYYY-MM-DD HH:MM:SS`)
+    constexpr std::size_t timestamp_length = 19;
+    /// 색인 레코드에서 필드가 차지하는 크기 (나머지는 0으로 채움)
+    constexpr std::size_t index_fields_size = 69;
+
+    std::string timestamp_of(const std::string& line)
+    {
+        return line.size() >= timestamp_length ? line.substr(0, timestamp_length) : std::string();
+    }
+
+    /// `time`의 앞부분이 `[from, to]` 안인지 확인합니다. `from`, `to`는 앞부분만 줄 수 있습니다.
+    bool time_within(const std::string& first, const std::string& last, const std::string& from, const std::string& to)
+    {
+        bool after_from = from.empty() || last.compare(0, from.size(), from) >= 0;
+        bool before_to = to.empty() || first.compare(0, to.size(), to) <= 0;
+        return after_from && before_to;
+    }
+
+    /**
+     * @brief 줄을 `block_bytes` 이하의 블록으로 묶어 압축하고 `data` 끝에 붙입니다.
+     * @param offset `data`의 첫 바이트가 블록 파일에서 놓일 위치.
+     */
+    void pack_blocks(const std::vector<std::string>& lines, std::uint64_t first_line, std::size_t block_bytes,
+                     HistoryCodec& codec, std::uint64_t offset, std::vector<SegmentedLog::BlockIndex>& index, std::string& data)
+    {
+        std::uint64_t next_line = first_line;
+        std::size_t i = 0;
+        while (i < lines.size()) {
+            std::string raw;
+            std::size_t begin = i;
+            while (i < lines.size() && (raw.empty() || raw.size() + lines[i].size() + 1 <= block_bytes)) {
+                raw += lines[i];
+                raw += '\n';
+                ++i;
+            }
+            std::string stored;
+            SegmentedLog::BlockIndex block;
+            block.method = static_cast<std::uint8_t>(codec.compress(raw, stored));
+            block.offset = offset + data.size();
+            block.stored_size = static_cast<std::uint32_t>(stored.size());
+            block.raw_size = static_cast<std::uint32_t>(raw.size());
+            block.first_line = next_line;
+            block.line_count = static_cast<std::uint32_t>(i - begin);
+            std::string first = timestamp_of(lines[begin]);
+            std::string last = timestamp_of(lines[i - 1]);
+            std::memcpy(block.first_time, first.data(), first.size());
+            std::memcpy(block.last_time, last.data(), last.size());
+            data += stored;
+            next_line += block.line_count;
+            index.push_back(block);
+        }
+    }
+
+    void put_le(std::string& out, std::uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    std::uint64_t get_le(const char* in, int bytes)
+    {
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+        return value;
+    }
+
+    /**
+     * @brief 색인 레코드 하나를 `out` 끝에 붙입니다.
+     * @details 배치는 x86-64/arm64에서 구조체를 그대로 쓰던 예전 파일과 같습니다. (u64 위치, u32 저장 크기, u32 원본 크기,
+     *          u64 첫 줄, u32 줄 수, u8 방식, 시각 20바이트 두 개, 0 세 바이트)
+     */
+    void encode_index(std::string& out, const SegmentedLog::BlockIndex& block)
+    {
+        put_le(out, block.offset, 8);
+        put_le(out, block.stored_size, 4);
+        put_le(out, block.raw_size, 4);
+        put_le(out, block.first_line, 8);
+        put_le(out, block.line_count, 4);
+        put_le(out, block.method, 1);
+        out.append(block.first_time, sizeof(block.first_time));
+        out.append(block.last_time, sizeof(block.last_time));
+        out.append(SegmentedLog::index_record_size - index_fields_size, '\0');
+    }
+
+    SegmentedLog::BlockIndex decode_index(const char* in)
+    {
+        SegmentedLog::BlockIndex block;
+        block.offset = get_le(in, 8);
+        block.stored_size = static_cast<std::uint32_t>(get_le(in + 8, 4));
+        block.raw_size = static_cast<std::uint32_t>(get_le(in + 12, 4));
+        block.first_line = get_le(in + 16, 8);
+        block.line_count = static_cast<std::uint32_t>(get_le(in + 24, 4));
+        block.method = static_cast<std::uint8_t>(get_le(in + 28, 1));
+        std::memcpy(block.first_time, in + 29, sizeof(block.first_time));
+        std::memcpy(block.last_time, in + 49, sizeof(block.last_time));
+        return block;
+    }
+
+    /// 색인 레코드를 파일에 씁니다. `mode`는 덧붙이기 또는 새로 쓰기.
+    bool write_index(const std::string& path, const std::vector<SegmentedLog::BlockIndex>& blocks, std::ios::openmode mode)
+    {
+        std::string data;
+        data.reserve(blocks.size() * SegmentedLog::index_record_size);
+        for (const auto& block : blocks)
+            encode_index(data, block);
+        std::ofstream file(path, mode | std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        return static_cast<bool>(file);
+    }
+
+    std::vector<std::string> read_lines(const std::string& path)
+    {
+        std::vector<std::string> lines;
+        std::ifstream file(path, std::ios::binary);
+        std::string line;
+        while (std::getline(file, line))
+            lines.push_back(std::move(line));
+        return lines;
+    }
+
+    /// 블록 파일에서 블록 하나의 저장된 바이트를 읽습니다.
+    bool read_stored(std::ifstream& file, const SegmentedLog::BlockIndex& block, std::string& stored)
+    {
+        stored.assign(block.stored_size, '\0');
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(block.offset));
+        return static_cast<bool>(file.read(stored.data(), static_cast<std::streamsize>(stored.size())));
+    }
+
+    void split_lines(const std::string& raw, std::vector<std::string>& out)
+    {
+        std::size_t start = 0;
+        while (start < raw.size()) {
+            std::size_t end = raw.find('\n', start);
+            if (end == std::string::npos)
+                end = raw.size();
+            out.emplace_back(raw, start, end - start);
+            start = end + 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// HistoryCodec Implementation
+//------------------------------------------------------------------------------
+struct HistoryCodec::Contexts {
+#ifdef CHERRY_HAVE_ZSTD
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    ZSTD_CDict* cdict = nullptr;
+    ZSTD_DDict* ddict = nullptr;
+
+    ~Contexts()
+    {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+#endif
+};
+
+HistoryCodec::HistoryCodec(std::string dict_path, int level)
+    : dict_path_(std::move(dict_path)), level_(level), contexts_(std::make_unique<Contexts>())
+{
+    std::ifstream file(dict_path_, std::ios::binary);
+    if (file.is_open())
+        dictionary_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    load_dictionary();
+}
+
+HistoryCodec::~HistoryCodec() = default;
+
+void HistoryCodec::use_dictionary(const std::string& dictionary)
+{
+    if (!dictionary_.empty() || dictionary.empty())
+        return;
+    dictionary_ = dictionary;
+    load_dictionary();
+}
+
+void HistoryCodec::load_dictionary()
+{
+#ifdef CHERRY_HAVE_ZSTD
+    if (dictionary_.empty())
+        return;
+    contexts_->cdict = ZSTD_createCDict(dictionary_.data(), dictionary_.size(), level_);
+    contexts_->ddict = ZSTD_createDDict(dictionary_.data(), dictionary_.size());
+    if (!contexts_->cdict || !contexts_->ddict) {
+        spdlog::warn("Failed to load history dictionary {}", dict_path_);
+        dictionary_.clear();
+    }
+#endif
+}
+
+/**
+ * @details 채팅 한 줄은 수십 바이트로 짧아 블록 안의 반복만으로는 압축률이 낮습니다.
+ *          닉네임, 시각 형식, 자주 쓰는 표현을 사전으로 미리 알려 주면 작은 블록도 잘 압축됩니다.
+ */
+void HistoryCodec::train_if_needed(const std::vector<std::string>& samples)
+{
+#ifdef CHERRY_HAVE_ZSTD
+    if (!dictionary_.empty() || samples.size() < min_training_samples)
+        return;
+    std::string buffer;
+    std::vector<std::size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        buffer += sample;
+        sizes.push_back(sample.size());
+    }
+    std::string dictionary(dictionary_capacity, '\0');
+    std::size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), buffer.data(),
+                                             sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        spdlog::debug("History dictionary training skipped: {}", ZDICT_getErrorName(size));
+        return;
+    }
+    dictionary.resize(size);
+    std::ofstream file(dict_path_, std::ios::binary | std::ios::trunc);
+    file.write(dictionary.data(), static_cast<std::streamsize>(dictionary.size()));
+    if (!file) {
+        spdlog::warn("Failed to save history dictionary {}", dict_path_);
+        return;
+    }
+    dictionary_ = std::move(dictionary);
+    load_dictionary();
+    spdlog::info("Trained history dictionary ({} bytes) from {} lines", dictionary_.size(), samples.size());
+#else
+    (void)samples;
+#endif
+}
+
+HistoryCodec::Method HistoryCodec::compress(const std::string& raw, std::string& out)
+{
+#ifdef CHERRY_HAVE_ZSTD
+    out.resize(ZSTD_compressBound(raw.size()));
+    std::size_t size = contexts_->cdict
+        ? ZSTD_compress_usingCDict(contexts_->cctx, out.data(), out.size(), raw.data(), raw.size(), contexts_->cdict)
+        : ZSTD_compressCCtx(contexts_->cctx, out.data(), out.size(), raw.data(), raw.size(), level_);
+    if (!ZSTD_isError(size) && size < raw.size()) {
+        out.resize(size);
+        return contexts_->cdict ? Method::ZstdDict : Method::Zstd;
+    }
+#endif
+    out = raw;
+    return Method::Raw;
+}
+
+bool HistoryCodec::decompress(Method method, const std::string& stored, std::size_t raw_size, std::string& out)
+{
+    if (method == Method::Raw) {
+        out = stored;
+        return true;
+    }
+#ifdef CHERRY_HAVE_ZSTD
+    if (method == Method::ZstdDict && !contexts_->ddict)
+        return false;
+    out.resize(raw_size);
+    std::size_t size = method == Method::ZstdDict
+        ? ZSTD_decompress_usingDDict(contexts_->dctx, out.data(), out.size(), stored.data(), stored.size(), contexts_->ddict)
+        : ZSTD_decompressDCtx(contexts_->dctx, out.data(), out.size(), stored.data(), stored.size());
+    return !ZSTD_isError(size) && size == raw_size;
+#else
+    (void)stored;
+    (void)raw_size;
+    (void)out;
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// SegmentedLog Implementation
+//------------------------------------------------------------------------------
+SegmentedLog::SegmentedLog(std::string base_path, HistoryCodec& codec, std::size_t segment_bytes, std::size_t block_bytes)
+    : base_path_(base_path),
+      active_path_(base_path + ".txt"),
+      pending_path_(base_path + ".seal"),
+      blocks_path_(base_path + ".blk"),
+      index_path_(base_path + ".idx"),
+      codec_(codec),
+      segment_bytes_(segment_bytes),
+      block_bytes_(std::max<std::size_t>(1, block_bytes))
+{
+    // 정리(`install`) 도중 멈췄으면 마무리하거나 되돌린다.
+    std::error_code ec;
+    if (fs::exists(index_path_ + ".compact", ec)) {
+        if (fs::exists(blocks_path_ + ".compact", ec)) {
+            fs::remove(blocks_path_ + ".compact", ec);
+            fs::remove(index_path_ + ".compact", ec);
+        } else {
+            fs::rename(index_path_ + ".compact", index_path_, ec);
+        }
+    } else {
+        fs::remove(blocks_path_ + ".compact", ec);
+    }
+
+    std::ifstream index(index_path_, std::ios::binary);
+    char record[index_record_size];
+    while (index.read(record, sizeof(record))) {
+        BlockIndex block = decode_index(record);
+        sealed_lines_ = block.first_line + block.line_count;
+        index_.push_back(block);
+    }
+
+    // 봉인하던 중에 멈췄으면 봉인 대기 세그먼트가 남아 있다. 소유자가 다시 봉인한다.
+    std::string line;
+    std::ifstream pending(pending_path_, std::ios::binary);
+    while (std::getline(pending, line)) {
+        ++pending_lines_;
+        pending_bytes_ += line.size() + 1;
+    }
+
+    std::ifstream active(active_path_, std::ios::binary);
+    while (std::getline(active, line)) {
+        ++active_lines_;
+        active_bytes_ += line.size() + 1;
+    }
+}
+
+bool SegmentedLog::append(const std::string& line)
+{
+    std::ofstream file(active_path_, std::ios::app | std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file << line << '\n';
+    file.close();
+    ++active_lines_;
+    active_bytes_ += line.size() + 1;
+    rotate_if_full();
+    return true;
+}
+
+/**
+ * @details 파일 이름만 바꾸므로 세그먼트 크기와 상관없이 금방 끝납니다. 봉인 대기 세그먼트가 이미 있으면
+ *          (봉인이 밀렸으면) 활성 세그먼트를 계속 키우고, 그 봉인이 끝난 뒤 다시 돌립니다.
+ */
+bool SegmentedLog::rotate()
+{
+    if (pending_lines_ > 0 || active_lines_ == 0)
+        return false;
+    std::error_code ec;
+    fs::rename(active_path_, pending_path_, ec);
+    if (ec) {
+        spdlog::error("Failed to rotate history segment {}: {}", active_path_, ec.message());
+        return false;
+    }
+    std::ofstream(active_path_, std::ios::app | std::ios::binary);
+    pending_lines_ = active_lines_;
+    pending_bytes_ = active_bytes_;
+    active_lines_ = 0;
+    active_bytes_ = 0;
+    return true;
+}
+
+bool SegmentedLog::rotate_if_full()
+{
+    return segment_bytes_ > 0 && active_bytes_ >= segment_bytes_ && rotate();
+}
+
+bool SegmentedLog::prepare_seal(Seal& seal) const
+{
+    if (pending_lines_ == 0)
+        return false;
+    seal = Seal{};
+    seal.base_path = base_path_;
+    seal.block_bytes = block_bytes_;
+    seal.first_line = sealed_lines_;
+    seal.line_count = pending_lines_;
+    return true;
+}
+
+bool SegmentedLog::build_seal(Seal& seal, HistoryCodec& codec)
+{
+    std::vector<std::string> lines = read_lines(seal.base_path + ".seal");
+    if (lines.size() != seal.line_count) {
+        spdlog::error("History segment {}.seal has {} lines, expected {}", seal.base_path, lines.size(), seal.line_count);
+        return false;
+    }
+    codec.train_if_needed(lines);
+    seal.index.clear();
+    seal.data.clear();
+    pack_blocks(lines, seal.first_line, seal.block_bytes, codec, 0, seal.index, seal.data);
+    return true;
+}
+
+/**
+ * @details 블록 데이터를 먼저 쓰고 색인을 나중에 씁니다. 색인 쓰기 전에 멈추면 색인에 없는 블록 데이터만 남으므로
+ *          읽기에는 영향이 없습니다. 색인을 쓴 뒤 봉인 대기 세그먼트를 지우기 전에 멈추면 그 세그먼트가 한 번 중복될 수 있습니다.
+ */
+bool SegmentedLog::install_seal(Seal& seal)
+{
+    if (pending_lines_ == 0 || seal.first_line != sealed_lines_ || seal.line_count != pending_lines_)
+        return false;
+
+    std::error_code ec;
+    std::uint64_t offset = fs::exists(blocks_path_, ec) ? fs::file_size(blocks_path_, ec) : 0;
+    std::ofstream blocks(blocks_path_, std::ios::app | std::ios::binary);
+    if (!blocks.is_open()) {
+        spdlog::error("Failed to open history blocks {}", blocks_path_);
+        return false;
+    }
+    blocks.write(seal.data.data(), static_cast<std::streamsize>(seal.data.size()));
+    blocks.close();
+    if (!blocks) {
+        spdlog::error("Failed to write history blocks {}", blocks_path_);
+        return false;
+    }
+
+    for (auto& block : seal.index)
+        block.offset += offset;
+    if (!write_index(index_path_, seal.index, std::ios::app)) {
+        spdlog::error("Failed to write history index {}", index_path_);
+        return false;
+    }
+
+    fs::remove(pending_path_, ec);
+    index_.insert(index_.end(), seal.index.begin(), seal.index.end());
+    sealed_lines_ += pending_lines_;
+    pending_lines_ = 0;
+    pending_bytes_ = 0;
+    spdlog::debug("Sealed {} lines of {} into {} blocks", seal.line_count, base_path_, seal.index.size());
+    return true;
+}
+
+void SegmentedLog::seal_pending()
+{
+    Seal seal;
+    if (prepare_seal(seal) && build_seal(seal, codec_))
+        install_seal(seal);
+}
+
+void SegmentedLog::seal()
+{
+    seal_pending();
+    if (rotate())
+        seal_pending();
+}
+
+/**
+ * @details 버리는 블록은 보관할 때만 압축을 풉니다. 남기는 블록 중 작은 블록이 이어진 구간은 풀어서 다시 묶고,
+ *          나머지는 저장된 바이트를 그대로 옮깁니다. 줄 번호와 시각 범위는 원래 값을 유지합니다.
+ */
+bool SegmentedLog::rewrite(const std::string& base_path, const std::vector<BlockIndex>& blocks, std::size_t drop,
+                           HistoryCodec& codec, std::size_t block_bytes, const Throttle& throttle,
+                           const std::function<void(const std::string&)>& on_dropped, Rewrite& out)
+{
+    out = Rewrite{};
+    out.base_path = base_path;
+    out.snapshot_blocks = blocks.size();
+    drop = std::min(drop, blocks.size());
+    block_bytes = std::max<std::size_t>(1, block_bytes);
+    const std::string blocks_path = base_path + ".blk";
+    const std::string compact_path = blocks_path + ".compact";
+
+    std::ifstream in(blocks_path, std::ios::binary);
+    std::ofstream file(compact_path, std::ios::trunc | std::ios::binary);
+    if (!in.is_open() || !file.is_open())
+        return false;
+    auto fail = [&]() {
+        file.close();
+        std::error_code ec;
+        fs::remove(compact_path, ec);
+        return false;
+    };
+
+    auto decode = [&](const BlockIndex& block, std::vector<std::string>& lines) {
+        std::string stored;
+        std::string raw;
+        if (!throttle(block.stored_size) || !read_stored(in, block, stored) ||
+            !codec.decompress(static_cast<HistoryCodec::Method>(block.method), stored, block.raw_size, raw))
+            return false;
+        split_lines(raw, lines);
+        return true;
+    };
+
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+        out.bytes_before += blocks[i].stored_size;
+    for (std::size_t i = 0; i < drop; ++i) {
+        if (on_dropped && blocks[i].line_count > 0) {
+            std::vector<std::string> lines;
+            if (!decode(blocks[i], lines))
+                return fail();
+            for (const auto& line : lines)
+                on_dropped(line);
+        }
+    }
+    out.dropped = drop;
+
+    std::uint64_t offset = 0;
+    std::size_t i = drop;
+    while (i < blocks.size()) {
+        // 빈 표식 블록은 버린다. (`install`이 필요하면 다시 만든다)
+        if (blocks[i].line_count == 0) {
+            ++out.merged;
+            ++i;
+            continue;
+        }
+        std::size_t run_end = i;
+        while (run_end < blocks.size() && blocks[run_end].line_count > 0 && blocks[run_end].raw_size < block_bytes / 2)
+            ++run_end;
+
+        std::string data;
+        if (run_end - i >= 2) {
+            std::vector<std::string> lines;
+            for (std::size_t j = i; j < run_end; ++j) {
+                if (!decode(blocks[j], lines))
+                    return fail();
+            }
+            std::size_t before = out.index.size();
+            pack_blocks(lines, blocks[i].first_line, block_bytes, codec, offset, out.index, data);
+            out.merged += (run_end - i) - (out.index.size() - before);
+            i = run_end;
+        } else {
+            BlockIndex block = blocks[i];
+            if (!throttle(block.stored_size) || !read_stored(in, block, data))
+                return fail();
+            block.offset = offset;
+            out.index.push_back(block);
+            ++i;
+        }
+        if (!throttle(data.size()))
+            return fail();
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        offset += data.size();
+    }
+    file.close();
+    if (!file)
+        return fail();
+    out.bytes_after = offset;
+    return true;
+}
+
+/**
+ * @details 새 색인을 `.idx.compact`에 먼저 쓰고 `.blk`, `.idx` 순서로 바꿉니다.
+ *          그 사이에 멈추면 다음에 열 때 생성자가 `.idx.compact`로 마무리합니다.
+ */
+bool SegmentedLog::install(Rewrite& rewrite)
+{
+    const std::string compact_blocks = blocks_path_ + ".compact";
+    const std::string compact_index = index_path_ + ".compact";
+    std::error_code ec;
+    if (rewrite.snapshot_blocks > index_.size()) {
+        fs::remove(compact_blocks, ec);
+        return false;
+    }
+    {
+        std::ofstream file(compact_blocks, std::ios::app | std::ios::binary);
+        std::ifstream in(blocks_path_, std::ios::binary);
+        std::uint64_t offset = rewrite.bytes_after;
+        bool copied = true;
+        for (std::size_t i = rewrite.snapshot_blocks; i < index_.size() && copied; ++i) {
+            BlockIndex block = index_[i];
+            std::string stored;
+            copied = read_stored(in, block, stored);
+            if (!copied)
+                break;
+            file.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+            block.offset = offset;
+            offset += stored.size();
+            rewrite.index.push_back(block);
+        }
+        if (rewrite.index.empty()) {
+            // 모두 정리되어도 줄 번호가 이어지도록 빈 표식 블록을 남긴다.
+            BlockIndex marker;
+            marker.first_line = sealed_lines_;
+            rewrite.index.push_back(marker);
+        }
+        file.close();
+        bool indexed = write_index(compact_index, rewrite.index, std::ios::trunc);
+        if (!copied || !file || !indexed) {
+            spdlog::error("Failed to write compacted history {}", blocks_path_);
+            fs::remove(compact_blocks, ec);
+            fs::remove(compact_index, ec);
+            return false;
+        }
+    }
+    fs::rename(compact_blocks, blocks_path_, ec);
+    if (ec) {
+        spdlog::error("Failed to install compacted history {}: {}", blocks_path_, ec.message());
+        fs::remove(compact_blocks, ec);
+        fs::remove(compact_index, ec);
+        return false;
+    }
+    index_ = rewrite.index;
+    fs::rename(compact_index, index_path_, ec);
+    if (ec)
+        spdlog::error("Failed to install compacted history index {}: {} (recovered on next open)", index_path_, ec.message());
+    return true;
+}
+
+std::string SegmentedLog::first_active_time() const
+{
+    std::ifstream file(pending_lines_ > 0 ? pending_path_ : active_path_, std::ios::binary);
+    std::string line;
+    std::getline(file, line);
+    return timestamp_of(line);
+}
+
+std::vector<std::string> SegmentedLog::last_lines(std::size_t limit)
+{
+    std::vector<std::string> active = read_active();
+    if (limit == 0)
+        return lines(0, static_cast<std::size_t>(line_count()));
+    if (active.size() >= limit)
+        return std::vector<std::string>(active.end() - static_cast<std::ptrdiff_t>(limit), active.end());
+    std::uint64_t total = sealed_lines_ + active.size();
+    std::uint64_t first = total > limit ? total - limit : 0;
+    return lines(first, limit);
+}
+
+std::vector<std::string> SegmentedLog::lines(std::uint64_t first, std::size_t count)
+{
+    std::vector<std::string> result;
+    std::uint64_t end = first + count;
+    auto block_it = std::upper_bound(index_.begin(), index_.end(), first,
+                                     [](std::uint64_t line, const BlockIndex& block) { return line < block.first_line; });
+    if (block_it != index_.begin())
+        --block_it;
+    for (; block_it != index_.end() && block_it->first_line < end; ++block_it) {
+        if (block_it->first_line + block_it->line_count <= first)
+            continue;
+        std::vector<std::string> block_lines;
+        if (!read_block(*block_it, block_lines))
+            return result;
+        for (std::size_t j = 0; j < block_lines.size(); ++j) {
+            std::uint64_t line_no = block_it->first_line + j;
+            if (line_no >= first && line_no < end)
+                result.push_back(std::move(block_lines[j]));
+        }
+    }
+    if (end > sealed_lines_) {
+        std::vector<std::string> active = read_active();
+        std::uint64_t start = first > sealed_lines_ ? first - sealed_lines_ : 0;
+        for (std::uint64_t j = start; j < active.size() && sealed_lines_ + j < end; ++j)
+            result.push_back(std::move(active[static_cast<std::size_t>(j)]));
+    }
+    return result;
+}
+
+std::vector<std::string> SegmentedLog::time_range(const std::string& from, const std::string& to)
+{
+    std::vector<std::string> result;
+    auto take = [&](std::vector<std::string>& candidates) {
+        for (auto& line : candidates) {
+            std::string time = timestamp_of(line);
+            if (time_within(time, time, from, to))
+                result.push_back(std::move(line));
+        }
+    };
+    for (const auto& block : index_) {
+        std::string first(block.first_time, strnlen(block.first_time, sizeof(block.first_time)));
+        std::string last(block.last_time, strnlen(block.last_time, sizeof(block.last_time)));
+        if (!time_within(first, last, from, to))
+            continue;
+        std::vector<std::string> block_lines;
+        if (read_block(block, block_lines))
+            take(block_lines);
+    }
+    std::vector<std::string> active = read_active();
+    take(active);
+    return result;
+}
+
+std::vector<std::string> SegmentedLog::read_active() const
+{
+    if (pending_lines_ == 0)
+        return read_lines(active_path_);
+    std::vector<std::string> lines = read_lines(pending_path_);
+    std::vector<std::string> active = read_lines(active_path_);
+    lines.insert(lines.end(), std::make_move_iterator(active.begin()), std::make_move_iterator(active.end()));
+    return lines;
+}
+
+bool SegmentedLog::read_block(const BlockIndex& block, std::vector<std::string>& out)
+{
+    std::ifstream file(blocks_path_, std::ios::binary);
+    std::string stored(block.stored_size, '\0');
+    file.seekg(static_cast<std::streamoff>(block.offset));
+    file.read(stored.data(), static_cast<std::streamsize>(stored.size()));
+    std::string raw;
+    if (!file || !codec_.decompress(static_cast<HistoryCodec::Method>(block.method), stored, block.raw_size, raw)) {
+        spdlog::error("Failed to read history block at {} in {}", block.offset, blocks_path_);
+        return false;
+    }
+    ++blocks_decoded_;
+    split_lines(raw, out);
+    return true;
+}
@@ -3,6 +3,7 @@
 #include <boost/asio/dispatch.hpp> // net::dispatch 사용
 #include <boost/core/ignore_unused.hpp> // boost::ignore_unused 사용
 
+#include <algorithm> // std::min
 #include <chrono>
 #include <exception> // std::terminate, std::exception
 #include <memory>
@@ -43,6 +44,32 @@ void fail(beast::error_code ec, char const* what)
     fprintf(stderr, "Error: %s: %s\n", what, ec.message().c_str());
 }
 
+// 경로 뒤의 쿼리 문자열(`?a=1&b=2`)을 떼어 내 돌려준다. 없으면 빈 문자열.
+std::string split_query(std::string& path)
+{
+    auto query_pos = path.find('?');
+    if (query_pos == std::string::npos) {
+        return "";
+    }
+    std::string query = path.substr(query_pos + 1);
+    path.erase(query_pos);
+    return query;
+}
+
+// 쿼리 문자열에서 `name` 값을 찾는다. 없으면 `fallback`.
+std::string query_param(const std::string& query, const std::string& name, const std::string& fallback)
+{
+    std::stringstream params(query);
+    std::string param;
+    std::string value = fallback;
+    while (std::getline(params, param, '&')) {
+        if (param.rfind(name + "=", 0) == 0) {
+            value = param.substr(name.length() + 1);
+        }
+    }
+    return value;
+}
+
 class HttpSession : public std::enable_shared_from_this<HttpSession>
 {
     beast::tcp_stream stream_; ///< @brief TCP 소켓을 감싸는 Beast 스트림 객체. 비동기 I/O 작업을 수행한다.
@@ -150,6 +177,9 @@ private:
         if (req_.method() == http::verb::get && req_.target() == "/health") {
             handle_health_check_request(); // Health Check 요청 처리
         }
+        else if (req_.method() == http::verb::get && req_.target() == "/metrics") {
+            handle_metrics_request(); // Google API 호출 제한기/서킷 브레이커 메트릭
+        }
         else if (req_.method() == http::verb::get && req_.target() == "/maps/key") {
             handle_maps_key_request(); // Google Maps API 키 요청 처리
         }
@@ -161,6 +191,13 @@ private:
             fprintf(stdout, "[HttpSession %p] Places API 요청 감지: /places/search\n", (void*)this);
             handle_places_search_request(); // 장소 검색 요청 처리
         }
+        else if (req_.method() == http::verb::post && req_.target() == "/places/autocomplete") {
+            handle_places_autocomplete_request(); // 입력 중 검색어 자동 완성 (Google 호출 없음)
+        }
+        else if (req_.method() == http::verb::post && req_.target() == "/places/details:batch") {
+            fprintf(stdout, "[HttpSession %p] Places API 요청 감지: /places/details:batch\n", (void*)this);
+            handle_places_batch_details_request(); // 여러 장소 상세 정보 한 번에 조회
+        }
         else if (req_.method() == http::verb::post && req_.target() == "/places/details") {
             // fprintf(stdout, "[HttpSession %p] Places API 요청 감지: /places/details (POST - Deprecated)\n", (void*)this);
             // handle_place_details_request(); // 기존 방식 제거
@@ -171,8 +208,10 @@ private:
             // 경로에서 Place ID 추출
             std::string target_path(req_.target()); // string_view를 std::string으로 변환
             std::string place_id = target_path.substr(std::string("/places/details/").length());
+            // 쿼리 문자열(`?projection=summary`)은 ID에서 떼어 낸다. 기본 projection은 `full`
+            std::string projection = query_param(split_query(place_id), "projection", "full");
             if (!place_id.empty()) {
-                handle_place_details_request(place_id); // 추출한 ID 전달
+                handle_place_details_request(place_id, projection); // 추출한 ID 전달
             }
             else {
                 // Place ID가 없는 경우 잘못된 요청 처리
@@ -184,8 +223,12 @@ private:
             // 경로에서 Photo Reference 추출
             std::string target_path(req_.target()); // string_view를 std::string으로 변환
             std::string photo_reference = target_path.substr(std::string("/place/photo/").length());
+            // 쿼리 문자열(`?size=thumb&format=webp`)은 참조에서 떼어 낸다. 기본은 원본 크기 JPEG
+            std::string query = split_query(photo_reference);
+            std::string size = query_param(query, "size", "full");
+            std::string format = query_param(query, "format", "jpeg");
             if (!photo_reference.empty()) {
-                handle_place_photo_request(photo_reference); // 추출한 참조 ID 전달
+                handle_place_photo_request(photo_reference, size, format); // 추출한 참조 ID 전달
             }
             else {
                 // Photo Reference가 없는 경우 잘못된 요청 처리
@@ -235,29 +278,58 @@ private:
         send_response(std::move(res));
     }
     
+    /**
+     * @brief 검색어 자동 완성 요청 처리 (로컬 장소 색인에서 바로 답함)
+     */
+    void handle_places_autocomplete_request() {
+        http::response<http::string_body> res = places_handler_->handleAutocomplete(req_);
+        send_response(std::move(res));
+    }
+
+    /**
+     * @brief 여러 장소의 상세 정보 요청 처리 (캐시에 없는 장소는 동시에 가져옴)
+     */
+    void handle_places_batch_details_request() {
+        http::response<http::string_body> res = places_handler_->handleBatchDetails(req_);
+        send_response(std::move(res));
+    }
+
     /**
      * @brief 장소 상세 정보 요청 처리 (Place ID 인자 받도록 수정)
      * @param place_id URL 경로에서 추출한 장소 ID
+     * @param projection URL 쿼리에서 추출한 응답 필드 범위 (`summary` 또는 `full`)
      */
-    void handle_place_details_request(const std::string& place_id) { // place_id 인자 추가
+    void handle_place_details_request(const std::string& place_id, const std::string& projection) { // place_id 인자 추가
         fprintf(stdout, "[HttpSession %p] Handling /places/details request for ID: %s\n", (void*)this, place_id.c_str());
         
         // Google Places API 상세 정보 요청 처리 후 응답 반환
-        ///< @note 현재는 Google API 응답 형식을 그대로 클라이언트에 반환합니다.
-        ///< @todo 필요 시 응답 형식을 변환하는 transformPlaceDetails 함수를 구현할 수 있습니다.
-        http::response<http::string_body> res = places_handler_->handlePlaceDetails(place_id);
+        ///< @note Google API 응답 중 projection에 속한 필드만 클라이언트에 반환합니다.
+        http::response<http::string_body> res = places_handler_->handlePlaceDetails(place_id, projection);
+        send_response(std::move(res));
+    }
+
+    /**
+     * @brief Google API 호출 제한기/서킷 브레이커 메트릭 요청 처리 (Prometheus 텍스트 형식)
+     */
+    void handle_metrics_request() {
+        http::response<http::string_body> res = places_handler_->handleMetrics();
+        res.keep_alive(req_.keep_alive());
         send_response(std::move(res));
     }
 
     /**
      * @brief 장소 사진 요청 처리
      * @param photo_reference URL 경로에서 추출한 사진 참조 ID
+     * @param size 크기 등급 (`thumb`, `medium`, `full`)
+     * @param format 이미지 형식 (`jpeg`, `webp`)
      */
-    void handle_place_photo_request(const std::string& photo_reference) { 
-        fprintf(stdout, "[HttpSession %p] Handling /place/photo request for reference: %s\n", (void*)this, photo_reference.c_str());
+    void handle_place_photo_request(const std::string& photo_reference, const std::string& size, const std::string& format) { 
+        fprintf(stdout, "[HttpSession %p] Handling /place/photo request for reference: %s (size=%s, format=%s)\n",
+                (void*)this, photo_reference.c_str(), size.c_str(), format.c_str());
         
-        // Google Places Photo API를 통해 이미지 가져오기
-        http::response<http::string_body> res = places_handler_->handlePlacePhoto(photo_reference);
+        // 크기/형식별 사본을 받는다. (없으면 원본을 한 번 받아 서버에서 만든다)
+        http::response<http::string_body> res = places_handler_->handlePlacePhoto(
+            photo_reference, size, format, std::string(req_[http::field::if_none_match]));
         send_response(std::move(res));
     }
 
@@ -466,6 +538,34 @@ HttpListener::HttpListener(
     }
     
     // 여기서 PlacesApiHandler 초기화 (한 번만 생성)
+    init_places_handler();
+}
+
+/**
+ * @brief 인계받은 리스닝 소켓용 HttpListener 생성자 구현부.
+ */
+HttpListener::HttpListener(
+    net::io_context& ioc,
+    const tcp& protocol,
+    tcp::acceptor::native_handle_type native_socket)
+    : ioc_(ioc)
+    , acceptor_(net::make_strand(ioc))
+{
+    beast::error_code ec;
+    acceptor_.assign(protocol, native_socket, ec);
+    if (ec) {
+        fail(ec, "assign");
+        throw beast::system_error{ ec };
+    }
+    fprintf(stdout, "[HttpListener %p] Adopted inherited listening socket (fd: %d)\n",
+        (void*)this, static_cast<int>(native_socket));
+    init_places_handler();
+}
+
+/**
+ * @brief PlacesApiHandler 초기화 함수 구현부.
+ */
+void HttpListener::init_places_handler() {
     const char* api_key = std::getenv("GOOGLE_MAPS_API_KEY");
     if (api_key != nullptr && strlen(api_key) > 0) {
         fprintf(stdout, "[HttpListener %p] Google Maps API 키 로드됨 (길이: %zu)\n", 
@@ -482,8 +582,66 @@ HttpListener::HttpListener(
     
     std::string google_api_key = api_key;
     
+    // Google API 호출 제한기/서킷 브레이커 설정 (환경 변수가 없으면 기본값)
+    auto env_int = [](const char* name, long fallback) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || value[0] == '\0') {
+            return fallback;
+        }
+        char* end = nullptr;
+        long parsed = std::strtol(value, &end, 10);
+        return (end != value && *end == '\0' && parsed > 0) ? parsed : fallback;
+    };
+    UpstreamGuardConfig guard_config;
+    guard_config.max_limit = static_cast<std::size_t>(env_int("PLACES_UPSTREAM_MAX_CONCURRENCY", static_cast<long>(guard_config.max_limit)));
+    guard_config.initial_limit = std::min(guard_config.initial_limit, guard_config.max_limit);
+    guard_config.latency_target = std::chrono::milliseconds(env_int("PLACES_UPSTREAM_LATENCY_TARGET_MS", static_cast<long>(guard_config.latency_target.count())));
+    guard_config.failure_threshold = env_int("PLACES_CIRCUIT_FAILURE_PERCENT", 50) / 100.0;
+    guard_config.open_duration = std::chrono::seconds(env_int("PLACES_CIRCUIT_OPEN_SECONDS", 10));
+
+    // 응답 캐시 설정 (스냅샷 경로가 비어 있으면 디스크에 저장하지 않음)
+    PlacesCacheConfig cache_config;
+    const char* cache_path = std::getenv("PLACES_CACHE_PATH");
+    cache_config.snapshot_path = cache_path != nullptr ? cache_path : "cache/places.snapshot";
+    cache_config.soft_ttl = std::chrono::seconds(env_int("PLACES_CACHE_SOFT_TTL_SECONDS", static_cast<long>(cache_config.soft_ttl.count())));
+    cache_config.hard_ttl = std::chrono::seconds(env_int("PLACES_CACHE_HARD_TTL_SECONDS", static_cast<long>(cache_config.hard_ttl.count())));
+    cache_config.snapshot_interval = std::chrono::seconds(env_int("PLACES_CACHE_SNAPSHOT_SECONDS", static_cast<long>(cache_config.snapshot_interval.count())));
+
+    // 검색 결과 상세 정보 미리 받기 설정 (PLACES_PREFETCH_TOP_K=0이면 사용 안 함)
+    PlacesPrefetchConfig prefetch_config;
+    const char* prefetch_top_k = std::getenv("PLACES_PREFETCH_TOP_K");
+    if (prefetch_top_k != nullptr && std::string(prefetch_top_k) == "0") {
+        prefetch_config.top_k = 0;
+    } else {
+        prefetch_config.top_k = static_cast<std::size_t>(env_int("PLACES_PREFETCH_TOP_K", static_cast<long>(prefetch_config.top_k)));
+    }
+    prefetch_config.per_minute = static_cast<std::size_t>(env_int("PLACES_PREFETCH_PER_MINUTE", static_cast<long>(prefetch_config.per_minute)));
+
+    // 로컬 장소 색인 설정 (PLACES_LOCAL_MAX_AGE_SECONDS=0이면 로컬 응답 사용 안 함)
+    PlacesLocalIndexConfig local_config;
+    const char* local_max_age = std::getenv("PLACES_LOCAL_MAX_AGE_SECONDS");
+    if (local_max_age != nullptr && std::string(local_max_age) == "0") {
+        local_config.max_age = std::chrono::seconds(0);
+    } else {
+        local_config.max_age = std::chrono::seconds(env_int("PLACES_LOCAL_MAX_AGE_SECONDS", static_cast<long>(local_config.max_age.count())));
+    }
+    local_config.max_places = static_cast<std::size_t>(env_int("PLACES_LOCAL_MAX_PLACES", static_cast<long>(local_config.max_places)));
+    local_config.min_text_results = static_cast<std::size_t>(env_int("PLACES_LOCAL_MIN_TEXT_RESULTS", static_cast<long>(local_config.min_text_results)));
+
+    // 장소 사진 사본 설정 (PLACES_PHOTO_CACHE_DIR가 빈 문자열이면 디스크에 두지 않음)
+    PhotoRenditionsConfig photo_config;
+    const char* photo_dir = std::getenv("PLACES_PHOTO_CACHE_DIR");
+    photo_config.cache_dir = photo_dir != nullptr ? photo_dir : "cache/photos";
+    photo_config.max_disk_bytes = static_cast<std::uint64_t>(env_int("PLACES_PHOTO_CACHE_MAX_MB", static_cast<long>(photo_config.max_disk_bytes >> 20))) << 20;
+    photo_config.threads = static_cast<std::size_t>(env_int("PLACES_PHOTO_THREADS", static_cast<long>(photo_config.threads)));
+    photo_config.max_queue = static_cast<std::size_t>(env_int("PLACES_PHOTO_QUEUE", static_cast<long>(photo_config.max_queue)));
+
     // 장소 API 핸들러 생성 (멤버 변수에 저장)
-    places_handler_ = std::make_shared<PlacesApiHandler>(google_api_key);
+    places_handler_ = std::make_shared<PlacesApiHandler>(google_api_key, guard_config, cache_config, prefetch_config, local_config, photo_config);
+    const char* local_import = std::getenv("PLACES_LOCAL_IMPORT_PATH");
+    if (local_import != nullptr && local_import[0] != '\0') {
+        places_handler_->importLocalPlaces(local_import);
+    }
     fprintf(stdout, "[HttpListener %p] PlacesApiHandler 생성됨 (싱글톤)\n", (void*)this);
 }
 
@@ -496,6 +654,17 @@ void HttpListener::run() {
     do_accept();
 }
 
+/**
+ * @brief 리스너 중지 함수 구현부.
+ */
+void HttpListener::stop() {
+    // acceptor는 strand 위에서만 다루므로 닫기도 strand로 넘긴다.
+    net::post(acceptor_.get_executor(), [self = shared_from_this()]() {
+        beast::error_code ec;
+        self->acceptor_.close(ec);
+    });
+}
+
 /**
  * @brief 비동기 accept 함수 구현부.
  */
@@ -512,6 +681,11 @@ void HttpListener::do_accept() {
  * @brief 비동기 accept 완료 콜백 함수 구현부.
  */
 void HttpListener::on_accept(beast::error_code ec, tcp::socket socket) {
+    // stop()으로 acceptor가 닫혔으면 accept 루프를 끝낸다.
+    if (ec == net::error::operation_aborted || !acceptor_.is_open()) {
+        return;
+    }
+
     // 오류 발생 시 보고
     if (ec) {
         fail(ec, "accept");
@@ -571,7 +745,13 @@ void HttpServer::run() {
 
     // Listener 생성 및 실행 (io_context 및 엔드포인트 전달)
     try {
-        listener_ = std::make_shared<HttpListener>(ioc_, tcp::endpoint{ addr, port });
+        if (adopted_protocol_) {
+            listener_ = std::make_shared<HttpListener>(ioc_, *adopted_protocol_, adopted_socket_);
+            adopted_protocol_.reset();
+        }
+        else {
+            listener_ = std::make_shared<HttpListener>(ioc_, tcp::endpoint{ addr, port });
+        }
         listener_->run(); ///< Listener의 비동기 accept 루프 시작
     }
     catch (const std::exception& e) {
@@ -611,6 +791,35 @@ void HttpServer::run() {
     fprintf(stdout, "[HttpServer %p] run() method finished, IO threads are running.\n", (void*)this);
 }
 
+/**
+ * @brief 리스닝 소켓 인계 지정 함수 구현부.
+ */
+void HttpServer::adopt_listener(const tcp& protocol, tcp::acceptor::native_handle_type native_socket) {
+    adopted_protocol_ = protocol;
+    adopted_socket_ = native_socket;
+}
+
+/**
+ * @brief 연결 수락 중지 함수 구현부.
+ */
+void HttpServer::stop_accepting() {
+    if (listener_) {
+        listener_->stop();
+    }
+}
+
+/**
+ * @brief 리스닝 소켓 핸들 조회 함수 구현부.
+ */
+int HttpServer::listener_native_handle(bool& ipv6) const {
+    if (!listener_) {
+        return -1;
+    }
+    auto endpoint = listener_->local_endpoint();
+    ipv6 = endpoint.address().is_v6();
+    return static_cast<int>(listener_->native_handle());
+}
+
 /**
  * @brief 서버 중지 함수 구현부.
  */
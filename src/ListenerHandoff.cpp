@@ -0,0 +1,340 @@
+/**
+ * @file ListenerHandoff.cpp
+ * @brief `HandoffServer`, `HandoffClient` 클래스의 구현부입니다.
+ */
+
+#include "ListenerHandoff.hpp"
+
+#include <spdlog/spdlog.h>
+
+#ifndef _WIN32
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr const char* handoff_request = "HANDOFF 1\n";
+    constexpr const char* handoff_ready = "READY\n";
+    constexpr const char* handoff_released = "RELEASED\n";
+    constexpr std::size_t max_handoff_fds = 16;
+
+#ifndef _WIN32
+    /// `data`와 함께 `fds`를 `SCM_RIGHTS`로 보낸다.
+    bool send_with_fds(int conn, const std::string& data, const std::vector<int>& fds)
+    {
+        if (fds.size() > max_handoff_fds) {
+            return false;
+        }
+        iovec iov{const_cast<char*>(data.data()), data.size()};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * max_handoff_fds), 0);
+        if (!fds.empty()) {
+            msg.msg_control = control.data();
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+            std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+        }
+        ssize_t sent;
+        do {
+            sent = ::sendmsg(conn, &msg, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+        return sent == static_cast<ssize_t>(data.size());
+    }
+
+    /// 한 번의 `recvmsg`로 데이터와 함께 전달된 파일 디스크립터를 받는다.
+    bool recv_with_fds(int conn, std::string& data, std::vector<int>& fds)
+    {
+        char buffer[4096];
+        iovec iov{buffer, sizeof(buffer)};
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * max_handoff_fds), 0);
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+
+        ssize_t received;
+        do {
+            received = ::recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+        } while (received < 0 && errno == EINTR);
+        if (received <= 0) {
+            return false;
+        }
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const auto* received_fds = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+                fds.insert(fds.end(), received_fds, received_fds + count);
+            }
+        }
+        data.assign(buffer, static_cast<std::size_t>(received));
+        // 컨트롤 버퍼가 잘렸으면 일부 디스크립터가 유실되었으므로 실패로 처리한다.
+        return (msg.msg_flags & MSG_CTRUNC) == 0;
+    }
+#endif
+}
+
+#ifndef _WIN32
+
+//------------------------------------------------------------------------------
+// HandoffServer
+//------------------------------------------------------------------------------
+HandoffServer::HandoffServer(net::io_context& ioc, const std::string& path, SocketProvider provider, HandoffHandler on_handoff,
+                             std::chrono::milliseconds ready_timeout)
+    : acceptor_(ioc), path_(path), provider_(std::move(provider)), on_handoff_(std::move(on_handoff)),
+      ready_timeout_(ready_timeout)
+{
+    ::unlink(path_.c_str());
+    net::local::stream_protocol::endpoint endpoint(path_);
+    acceptor_.open(endpoint.protocol());
+    acceptor_.bind(endpoint);
+    acceptor_.listen(1);
+    spdlog::info("[HandoffServer] Waiting for hot-upgrade requests on {}", path_);
+}
+
+void HandoffServer::run()
+{
+    do_accept();
+}
+
+void HandoffServer::stop(bool remove_path)
+{
+    net::post(acceptor_.get_executor(), [self = shared_from_this(), remove_path]() {
+        boost::system::error_code ec;
+        self->acceptor_.close(ec);
+        if (remove_path && !self->handed_off_) {
+            ::unlink(self->path_.c_str());
+        }
+    });
+}
+
+void HandoffServer::do_accept()
+{
+    acceptor_.async_accept([self = shared_from_this()](boost::system::error_code ec, net::local::stream_protocol::socket socket) {
+        if (ec) {
+            if (ec != net::error::operation_aborted) {
+                spdlog::error("[HandoffServer] Accept failed: {}", ec.message());
+            }
+            return;
+        }
+        auto peer = std::make_shared<net::local::stream_protocol::socket>(std::move(socket));
+        auto request = std::make_shared<net::streambuf>(64);
+        net::async_read_until(*peer, *request, '\n',
+            [self, peer, request](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    spdlog::warn("[HandoffServer] Failed to read hot-upgrade request: {}", ec.message());
+                    return self->do_accept();
+                }
+                std::string line{net::buffers_begin(request->data()), net::buffers_end(request->data())};
+                self->on_request(peer, line);
+            });
+    });
+}
+
+/**
+ * @details 요청이 올바르면 소켓 목록과 디스크립터를 보내고 `READY`를 기다립니다.
+ *          보낸 디스크립터는 이 프로세스에서도 계속 열려 있으므로, 새 프로세스가 준비될 때까지 accept를 계속합니다.
+ */
+void HandoffServer::on_request(std::shared_ptr<net::local::stream_protocol::socket> peer, const std::string& request)
+{
+    if (request != handoff_request) {
+        spdlog::warn("[HandoffServer] Unknown hot-upgrade request. Ignored.");
+        return do_accept();
+    }
+
+    std::ostringstream manifest;
+    std::vector<int> fds;
+    for (const auto& socket : provider_()) {
+        if (socket.fd < 0) {
+            continue;
+        }
+        manifest << socket.name << ' ' << (socket.ipv6 ? 6 : 4) << '\n';
+        fds.push_back(socket.fd);
+    }
+    if (!send_with_fds(peer->native_handle(), manifest.str(), fds)) {
+        spdlog::error("[HandoffServer] Failed to send listening sockets: {}", std::strerror(errno));
+        return do_accept();
+    }
+    spdlog::info("[HandoffServer] Sent {} listening socket(s). Waiting for new process to be ready...", fds.size());
+    await_ready(std::move(peer));
+}
+
+/**
+ * @details 새 프로세스가 소켓을 받고 멈추면 다음 인계 요청을 받을 수 없으므로, `ready_timeout_`이 지나면 연결을 닫습니다.
+ *          닫힌 연결의 읽기는 오류로 끝나며, 그 완료 핸들러가 다시 accept를 시작합니다.
+ */
+void HandoffServer::await_ready(std::shared_ptr<net::local::stream_protocol::socket> peer)
+{
+    auto reply = std::make_shared<net::streambuf>(64);
+    auto deadline = std::make_shared<net::steady_timer>(acceptor_.get_executor(), ready_timeout_);
+    deadline->async_wait([self = shared_from_this(), peer](boost::system::error_code ec) {
+        if (ec) {
+            return;
+        }
+        spdlog::warn("[HandoffServer] No READY within {} ms. Dropping hot-upgrade connection.", self->ready_timeout_.count());
+        boost::system::error_code ignored;
+        peer->close(ignored);
+    });
+    net::async_read_until(*peer, *reply, '\n',
+        [self = shared_from_this(), peer, reply, deadline](boost::system::error_code ec, std::size_t) {
+            deadline->cancel();
+            std::string line{net::buffers_begin(reply->data()), net::buffers_end(reply->data())};
+            if (ec || line != handoff_ready) {
+                spdlog::warn("[HandoffServer] New process did not confirm hot upgrade. Keep serving.");
+                return self->do_accept();
+            }
+            spdlog::info("[HandoffServer] New process is taking over. Handing off.");
+            self->handed_off_ = true;
+            boost::system::error_code ignored;
+            self->acceptor_.close(ignored);
+            if (self->on_handoff_) {
+                self->on_handoff_();
+            }
+            // 인계 처리 함수가 저장소를 닫았으므로 새 프로세스가 열어도 된다. 짧은 한 줄이므로 바로 보낸다.
+            net::write(*peer, net::buffer(std::string(handoff_released)), ignored);
+            peer->close(ignored);
+        });
+}
+
+#endif // _WIN32
+
+//------------------------------------------------------------------------------
+// HandoffClient
+//------------------------------------------------------------------------------
+HandoffClient::~HandoffClient()
+{
+#ifndef _WIN32
+    for (const auto& socket : sockets_) {
+        ::close(socket.fd);
+    }
+    if (conn_ >= 0) {
+        ::close(conn_);
+    }
+#endif
+}
+
+bool HandoffClient::request(const std::string& path, std::chrono::milliseconds timeout)
+{
+#ifdef _WIN32
+    (void)path;
+    (void)timeout;
+    return false;
+#else
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        spdlog::error("[HandoffClient] Socket path too long: {}", path);
+        return false;
+    }
+    conn_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn_ < 0) {
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    if (::connect(conn_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        spdlog::info("[HandoffClient] No running process to take over at {} ({}).", path, std::strerror(errno));
+        ::close(conn_);
+        conn_ = -1;
+        return false;
+    }
+
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+    ::setsockopt(conn_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    std::string manifest;
+    std::vector<int> fds;
+    if (!send_with_fds(conn_, handoff_request, {}) || !recv_with_fds(conn_, manifest, fds)) {
+        spdlog::error("[HandoffClient] Hot-upgrade handshake failed: {}", std::strerror(errno));
+        for (int fd : fds) {
+            ::close(fd);
+        }
+        ::close(conn_);
+        conn_ = -1;
+        return false;
+    }
+
+    std::istringstream lines(manifest);
+    std::string name;
+    int family = 0;
+    std::size_t index = 0;
+    while (lines >> name >> family && index < fds.size()) {
+        sockets_.push_back(HandoffSocket{name, fds[index++], family == 6});
+    }
+    for (; index < fds.size(); ++index) {
+        ::close(fds[index]); // 목록에 없는 디스크립터는 쓰지 않는다.
+    }
+    spdlog::info("[HandoffClient] Received {} listening socket(s) from running process.", sockets_.size());
+    return !sockets_.empty();
+#endif
+}
+
+HandoffSocket HandoffClient::take(const std::string& name)
+{
+    for (auto it = sockets_.begin(); it != sockets_.end(); ++it) {
+        if (it->name == name) {
+            HandoffSocket socket = *it;
+            sockets_.erase(it);
+            return socket;
+        }
+    }
+    return HandoffSocket{name, -1, false};
+}
+
+/**
+ * @details `RELEASED` 한 줄은 한 번의 `recv`로 다 오지 않을 수 있으므로 줄 끝까지 읽는다.
+ */
+bool HandoffClient::confirm(std::chrono::milliseconds timeout)
+{
+#ifdef _WIN32
+    (void)timeout;
+    return false;
+#else
+    if (conn_ < 0) {
+        return false;
+    }
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+    ::setsockopt(conn_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    bool ok = send_with_fds(conn_, handoff_ready, {});
+    std::string reply;
+    while (ok && (reply.empty() || reply.back() != '\n') && reply.size() < 64) {
+        char buffer[64];
+        ssize_t received;
+        do {
+            received = ::recv(conn_, buffer, sizeof(buffer), 0);
+        } while (received < 0 && errno == EINTR);
+        if (received <= 0) {
+            break;
+        }
+        reply.append(buffer, static_cast<std::size_t>(received));
+    }
+    ::close(conn_);
+    conn_ = -1;
+    if (ok && reply != handoff_released) {
+        spdlog::error("[HandoffClient] Previous process did not confirm releasing its storage.");
+        return false;
+    }
+    return ok;
+#endif
+}
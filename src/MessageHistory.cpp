@@ -1,5 +1,8 @@
 // src/MessageHistory.cpp
 #include "MessageHistory.hpp" // Include the header for the class definition
+#include "HistorySegments.hpp"
+#include "SearchIndex.hpp"
+#include "PrivateMessageStore.hpp"
 #include "spdlog/spdlog.h"     // Include spdlog for logging
 #include <vector>
 #include <string>
@@ -9,6 +12,17 @@
 #include <chrono>
 #include <mutex>
 #include <iomanip>
+#include <algorithm>
+#include <set>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -18,13 +32,27 @@ static std::mutex history_mutex;
 // 전방 선언
 namespace {
     std::string get_timestamp();
-    std::vector<std::string> read_last_lines(const std::string& filename, size_t limit);
+    std::string format_timestamp(std::chrono::system_clock::time_point time_point);
+    bool history_exists(const std::string& base_path);
+    std::string message_text(const std::string& entry);
+    std::uint64_t entry_time(const std::string& entry);
+    std::string seq_tag(std::uint64_t seq);
+    std::vector<std::string> private_participants(const std::string& entry);
+
+    /// 백필할 때 잠금 한 번에 읽는 줄 수
+    constexpr size_t backfill_chunk = 512;
+    
+    /// 기록 줄/블록 색인의 시각 (`YYYY-MM-DD HH:MM:SS`) 길이
+    constexpr size_t timestamp_length = 19;
 }
 
 //------------------------------------------------------------------------------
 // MessageHistory Implementation
 //------------------------------------------------------------------------------
-MessageHistory::MessageHistory(const std::string &history_dir) : history_dir_(history_dir)
+MessageHistory::MessageHistory(const std::string &history_dir)
+    : history_dir_(history_dir),
+      codec_(std::make_unique<HistoryCodec>(history_dir + "/history.dict")),
+      seal_codec_(std::make_unique<HistoryCodec>(history_dir + "/history.dict"))
 {
     try {
         // history_dir가 존재하지 않으면 생성
@@ -32,40 +60,117 @@ MessageHistory::MessageHistory(const std::string &history_dir) : history_dir_(hi
             fs::create_directories(history_dir_);
         }
         
+#ifndef _WIN32
+        // 활성 세그먼트의 줄 수와 색인은 이 프로세스의 메모리에만 있으므로, 두 프로세스가 같은 디렉터리에 쓰면 기록이 깨진다.
+        lock_fd_ = ::open((history_dir_ + "/.lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (lock_fd_ < 0 || ::flock(lock_fd_, LOCK_EX | LOCK_NB) != 0)
+            throw std::runtime_error("directory is in use by another process (" + std::string(std::strerror(errno)) + ")");
+#endif
+
         // 글로벌 히스토리, 개인 메시지, 채팅방 히스토리 디렉토리 생성
         fs::create_directories(history_dir_ + "/global");
         fs::create_directories(history_dir_ + "/private");
         fs::create_directories(history_dir_ + "/rooms");
         
+        private_store_ = std::make_unique<PrivateMessageStore>(history_dir_ + "/private/messages.log");
+        for (const auto& entry : fs::directory_iterator(history_dir_ + "/private")) {
+            auto ext = entry.path().extension();
+            if (ext == ".txt" || ext == ".idx") {
+                spdlog::warn("Legacy per-pair private history found in {}/private. Run CherryRecorder-MigratePM to import it.", history_dir_);
+                break;
+            }
+        }
+        
+        // 기존 기록은 지금까지의 줄 수만 정해 두고 백그라운드에서 색인한다. 이후 기록은 바로 색인한다.
+        search_ = std::make_unique<SearchIndex>();
+        std::set<std::string> rooms;
+        for (const auto& entry : fs::directory_iterator(history_dir_ + "/rooms")) {
+            auto ext = entry.path().extension();
+            if (ext == ".txt" || ext == ".seal" || ext == ".idx")
+                rooms.insert(entry.path().stem().string());
+        }
+        std::vector<BackfillStream> streams;
+        {
+            std::lock_guard<std::mutex> lock(history_mutex);
+            for (const auto& room : rooms)
+            {
+                SegmentedLog& log = log_for(history_dir_ + "/rooms/" + room);
+                streams.push_back(BackfillStream{"rooms/" + room, {}, log.first_line(), log.line_count()});
+            }
+            for (const auto& [user1, user2] : private_store_->conversations())
+                streams.push_back(BackfillStream{"private/" + user1 + "_" + user2, {user1, user2},
+                                                 private_store_->first_line(user1, user2), private_store_->line_count(user1, user2)});
+        }
+        if (!streams.empty()) {
+            backfill_ = std::async(std::launch::async, [this, streams = std::move(streams)]() mutable {
+                backfill_search(std::move(streams));
+            }).share();
+        }
+        
+        sealer_thread_ = std::thread(&MessageHistory::sealer_loop, this);
         enabled_ = true;
         spdlog::info("MessageHistory initialized with directory: {}", history_dir_);
     }
     catch (const std::exception& e) {
-        spdlog::error("Failed to initialize MessageHistory: {}", e.what());
+        spdlog::error("Failed to initialize MessageHistory in {}: {}", history_dir_, e.what());
         enabled_ = false;
+        closed_ = true;
     }
 }
 
 MessageHistory::~MessageHistory()
 {
+    close();
     spdlog::info("MessageHistory destroyed");
 }
 
-void MessageHistory::log_global_message(const std::string &message, const std::string &sender)
+/**
+ * @details 기록 잠금 안에서 닫힘 표시를 하므로, 이 함수가 돌아온 뒤에는 어떤 스레드도 파일을 바꾸지 않는다.
+ *          봉인/정리 스레드는 잠금을 다시 잡을 때 닫힘 표시를 보고 바꾸지 않은 채 끝난다.
+ */
+void MessageHistory::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        closed_ = true;
+        enabled_ = false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mutex_);
+        stop_maintenance_ = true;
+    }
+    maintenance_cv_.notify_all();
+    if (maintenance_thread_.joinable())
+        maintenance_thread_.join();
+    // 봉인하지 못한 세그먼트는 `.seal`로 남아 다음에 열 때 다시 봉인한다.
+    {
+        std::lock_guard<std::mutex> lock(sealer_mutex_);
+        stop_sealer_ = true;
+    }
+    sealer_cv_.notify_all();
+    if (sealer_thread_.joinable())
+        sealer_thread_.join();
+    stop_backfill_ = true;
+    if (backfill_.valid())
+        backfill_.wait();
+#ifndef _WIN32
+    if (lock_fd_ >= 0) {
+        ::close(lock_fd_);
+        lock_fd_ = -1;
+    }
+#endif
+}
+
+void MessageHistory::log_global_message(const std::string &message, const std::string &sender, std::uint64_t seq)
 {
     if (!enabled_)
         return;
     
     try {
-        std::string timestamp = get_timestamp();
-        std::string log_entry = timestamp + " [" + (sender.empty() ? "system" : sender) + "]: " + message;
-        
-        std::lock_guard<std::mutex> lock(history_mutex);
-        std::ofstream file(history_dir_ + "/global/history.txt", std::ios::app);
-        if (file.is_open()) {
-            file << log_entry << std::endl;
-            file.close();
-        }
+        HistoryRecord record;
+        record.kind = HistoryRecord::Kind::Global;
+        record.line = get_timestamp() + seq_tag(seq) + " [" + (sender.empty() ? "system" : sender) + "]: " + message;
+        append_record(record);
     }
     catch (const std::exception& e) {
         spdlog::error("Failed to log global message: {}", e.what());
@@ -78,51 +183,107 @@ void MessageHistory::log_private_message(const std::string &message, const std::
         return;
     
     try {
-        std::string timestamp = get_timestamp();
-        std::string log_entry = timestamp + " [" + sender + " -> " + receiver + "]: " + message;
-        
-        // 두 사용자 ID를 알파벳 순으로 정렬하여 일관된 파일명 생성
-        std::string user1 = sender;
-        std::string user2 = receiver;
-        if (user1 > user2) std::swap(user1, user2);
-        
-        std::string filename = history_dir_ + "/private/" + user1 + "_" + user2 + ".txt";
-        
-        std::lock_guard<std::mutex> lock(history_mutex);
-        std::ofstream file(filename, std::ios::app);
-        if (file.is_open()) {
-            file << log_entry << std::endl;
-            file.close();
-        }
+        HistoryRecord record;
+        record.kind = HistoryRecord::Kind::Private;
+        record.sender = sender;
+        record.receiver = receiver;
+        record.line = get_timestamp() + " [" + sender + " -> " + receiver + "]: " + message;
+        append_record(record);
     }
     catch (const std::exception& e) {
         spdlog::error("Failed to log private message: {}", e.what());
     }
 }
 
-void MessageHistory::log_room_message(const std::string &room_name, const std::string &message, const std::string &sender)
+void MessageHistory::log_room_message(const std::string &room_name, const std::string &message, const std::string &sender,
+                                      std::uint64_t seq)
 {
     if (!enabled_)
         return;
     
     try {
-        std::string timestamp = get_timestamp();
-        std::string log_entry = timestamp + " [" + (sender.empty() ? "system" : sender) + "]: " + message;
-        
-        std::string filename = history_dir_ + "/rooms/" + room_name + ".txt";
-        
-        std::lock_guard<std::mutex> lock(history_mutex);
-        std::ofstream file(filename, std::ios::app);
-        if (file.is_open()) {
-            file << log_entry << std::endl;
-            file.close();
-        }
+        HistoryRecord record;
+        record.kind = HistoryRecord::Kind::Room;
+        record.room = room_name;
+        record.line = get_timestamp() + seq_tag(seq) + " [" + (sender.empty() ? "system" : sender) + "]: " + message;
+        append_record(record);
     }
     catch (const std::exception& e) {
         spdlog::error("Failed to log room message: {}", e.what());
     }
 }
 
+void MessageHistory::set_append_listener(std::function<void(const HistoryRecord&)> listener)
+{
+    std::lock_guard<std::mutex> lock(history_mutex);
+    append_listener_ = std::move(listener);
+}
+
+bool MessageHistory::apply_record(const HistoryRecord &record)
+{
+    if (!enabled_)
+        return false;
+    // 방 이름은 파일 경로가 되므로 디렉터리를 벗어나는 이름은 받지 않는다.
+    if (record.kind == HistoryRecord::Kind::Room &&
+        (record.room.empty() || record.room.find('/') != std::string::npos || record.room.find('\\') != std::string::npos || record.room == ".."))
+        return false;
+    
+    try {
+        return append_record(record);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to apply replicated history record: {}", e.what());
+        return false;
+    }
+}
+
+/**
+ * @details 귓속말은 두 사용자 ID를 정렬해 대화 키를 만든다. 검색 색인에는 기록 줄에서 본문만 넣는다.
+ *          알림은 잠금 안에서 하므로 받는 쪽은 파일에 기록된 순서대로 받는다.
+ *          세그먼트가 가득 차면 `SegmentedLog::append`는 파일 이름만 바꾸므로, 여기서는 봉인 스레드에 넘기기만 한다.
+ */
+bool MessageHistory::append_record(const HistoryRecord &record)
+{
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (closed_)
+        return false;
+    bool appended = false;
+    switch (record.kind) {
+    case HistoryRecord::Kind::Global: {
+        std::string base_path = history_dir_ + "/global/history";
+        SegmentedLog& log = log_for(base_path);
+        appended = log.append(record.line);
+        if (log.has_pending())
+            schedule_seal(base_path);
+        break;
+    }
+    case HistoryRecord::Kind::Room: {
+        std::string channel = "rooms/" + record.room;
+        std::string base_path = history_dir_ + "/" + channel;
+        SegmentedLog& log = log_for(base_path);
+        appended = log.append(record.line);
+        if (log.has_pending())
+            schedule_seal(base_path);
+        if (appended && search_)
+            search_->add(channel, log.line_count() - 1, message_text(record.line), {}, entry_time(record.line));
+        break;
+    }
+    case HistoryRecord::Kind::Private: {
+        std::string user1 = record.sender;
+        std::string user2 = record.receiver;
+        if (user1 > user2) std::swap(user1, user2);
+        appended = private_store_->append(user1, user2, record.line);
+        if (appended && search_)
+            search_->add("private/" + user1 + "_" + user2, private_store_->line_count(user1, user2) - 1,
+                         message_text(record.line), {user1, user2}, entry_time(record.line));
+        break;
+    }
+    }
+    if (appended && append_listener_)
+        append_listener_(record);
+    return appended;
+}
+
 std::vector<std::string> MessageHistory::load_global_history(size_t limit)
 {
     std::vector<std::string> result;
@@ -130,11 +291,11 @@ std::vector<std::string> MessageHistory::load_global_history(size_t limit)
     
     try {
         std::lock_guard<std::mutex> lock(history_mutex);
-        std::string filename = history_dir_ + "/global/history.txt";
+        std::string base_path = history_dir_ + "/global/history";
         
-        if (!fs::exists(filename)) return result;
+        if (!history_exists(base_path)) return result;
         
-        result = read_last_lines(filename, limit);
+        result = log_for(base_path).last_lines(limit);
     }
     catch (const std::exception& e) {
         spdlog::error("Failed to load global history: {}", e.what());
@@ -149,17 +310,8 @@ std::vector<std::string> MessageHistory::load_private_history(const std::string
     if (!enabled_) return result;
     
     try {
-        // 두 사용자 ID를 알파벳 순으로 정렬하여 일관된 파일명 생성
-        std::string u1 = user1;
-        std::string u2 = user2;
-        if (u1 > u2) std::swap(u1, u2);
-        
-        std::string filename = history_dir_ + "/private/" + u1 + "_" + u2 + ".txt";
-        
-        if (!fs::exists(filename)) return result;
-        
         std::lock_guard<std::mutex> lock(history_mutex);
-        result = read_last_lines(filename, limit);
+        result = private_store_->last_lines(user1, user2, limit);
     }
     catch (const std::exception& e) {
         spdlog::error("Failed to load private history: {}", e.what());
@@ -174,12 +326,12 @@ std::vector<std::string> MessageHistory::load_room_history(const std::string &ro
     if (!enabled_) return result;
     
     try {
-        std::string filename = history_dir_ + "/rooms/" + room_name + ".txt";
+        std::string base_path = history_dir_ + "/rooms/" + room_name;
         
-        if (!fs::exists(filename)) return result;
+        if (!history_exists(base_path)) return result;
         
         std::lock_guard<std::mutex> lock(history_mutex);
-        result = read_last_lines(filename, limit);
+        result = log_for(base_path).last_lines(limit);
     }
     catch (const std::exception& e) {
         spdlog::error("Failed to load room history: {}", e.what());
@@ -188,13 +340,651 @@ std::vector<std::string> MessageHistory::load_room_history(const std::string &ro
     return result;
 }
 
+std::vector<std::string> MessageHistory::load_room_range(const std::string &room_name, std::uint64_t first_line, size_t count)
+{
+    std::vector<std::string> result;
+    if (!enabled_) return result;
+    
+    try {
+        std::string base_path = history_dir_ + "/rooms/" + room_name;
+        if (!history_exists(base_path)) return result;
+        
+        std::lock_guard<std::mutex> lock(history_mutex);
+        result = log_for(base_path).lines(first_line, count);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to load room history range: {}", e.what());
+    }
+    
+    return result;
+}
+
+std::vector<std::string> MessageHistory::load_room_between(const std::string &room_name, const std::string &from, const std::string &to)
+{
+    std::vector<std::string> result;
+    if (!enabled_) return result;
+    
+    try {
+        std::string base_path = history_dir_ + "/rooms/" + room_name;
+        if (!history_exists(base_path)) return result;
+        
+        std::lock_guard<std::mutex> lock(history_mutex);
+        result = log_for(base_path).time_range(from, to);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to load room history between {} and {}: {}", from, to, e.what());
+    }
+    
+    return result;
+}
+
+std::vector<std::string> MessageHistory::load_global_range(std::uint64_t first_line, size_t count)
+{
+    std::vector<std::string> result;
+    if (!enabled_) return result;
+    
+    try {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        std::string base_path = history_dir_ + "/global/history";
+        if (!history_exists(base_path)) return result;
+        
+        result = log_for(base_path).lines(first_line, count);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to load global history range: {}", e.what());
+    }
+    
+    return result;
+}
+
+std::vector<std::string> MessageHistory::load_global_between(const std::string &from, const std::string &to)
+{
+    std::vector<std::string> result;
+    if (!enabled_) return result;
+    
+    try {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        std::string base_path = history_dir_ + "/global/history";
+        if (!history_exists(base_path)) return result;
+        
+        result = log_for(base_path).time_range(from, to);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to load global history between {} and {}: {}", from, to, e.what());
+    }
+    
+    return result;
+}
+
+void MessageHistory::set_segment_limits(size_t segment_bytes, size_t block_bytes)
+{
+    std::lock_guard<std::mutex> lock(history_mutex);
+    segment_bytes_ = segment_bytes;
+    block_bytes_ = block_bytes;
+    logs_.clear();
+}
+
+/**
+ * @details 채팅방 기록은 누구나 입장하며 받아 보는 기록이므로 모두 검색 대상이고,
+ *          귓속말 기록은 `nickname`이 보내거나 받은 것만 포함한다. `nickname`이 비어 있으면 귓속말은 제외한다.
+ *          결과 줄은 색인에 본문이 없으므로 해당 줄이 든 블록만 읽어 채운다.
+ */
+MessageHistory::SearchResult MessageHistory::search(const std::string &query, const std::string &nickname,
+                                                    const std::string &room_name, size_t offset, size_t limit,
+                                                    std::uint64_t private_since)
+{
+    SearchResult result;
+    if (!enabled_ || !search_) return result;
+    
+    const std::string room_channel = "rooms/" + room_name;
+    auto filter = [&](const std::string& channel, const std::vector<std::string>& participants, std::uint64_t time) {
+        if (!room_name.empty())
+            return channel == room_channel;
+        if (channel.rfind("rooms/", 0) == 0)
+            return true;
+        return !nickname.empty() && time > private_since &&
+               std::find(participants.begin(), participants.end(), nickname) != participants.end();
+    };
+    SearchIndex::Page page = search_->search(query, filter, offset, limit);
+    result.total = page.total;
+    
+    try {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        for (const auto& hit : page.hits) {
+            auto lines = read_channel(hit.channel, hit.participants, hit.line, 1);
+            if (lines.empty()) continue;
+            bool is_room = hit.channel.rfind("rooms/", 0) == 0;
+            result.lines.push_back((is_room ? "[#" + hit.channel.substr(6) + "] " : std::string("[PM] ")) + lines.front());
+        }
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to read search results for '{}': {}", query, e.what());
+    }
+    
+    return result;
+}
+
+/**
+ * @details 순번은 시각 바로 뒤의 ` #<숫자> ` 자리에만 있다. 본문에 `#`이 있어도 그 자리가 아니면 순번으로 읽지 않는다.
+ */
+std::uint64_t MessageHistory::line_seq(const std::string &line)
+{
+    std::size_t pos = timestamp_length + 2;
+    if (line.size() <= pos || line.compare(timestamp_length, 2, " #") != 0)
+        return 0;
+    std::uint64_t seq = 0;
+    std::size_t digits = 0;
+    for (; pos < line.size() && line[pos] >= '0' && line[pos] <= '9' && digits < 19; ++pos, ++digits)
+        seq = seq * 10 + static_cast<std::uint64_t>(line[pos] - '0');
+    return digits > 0 && pos < line.size() && line[pos] == ' ' ? seq : 0;
+}
+
+void MessageHistory::schedule_seal(const std::string &base_path)
+{
+    std::lock_guard<std::mutex> lock(sealer_mutex_);
+    if (stop_sealer_ || !seal_queued_.insert(base_path).second)
+        return;
+    seal_queue_.push_back(base_path);
+    sealer_cv_.notify_all();
+}
+
+/**
+ * @details 봉인 중인 파일은 끝날 때까지 `seal_queued_`에 남겨 같은 세그먼트를 두 번 넣지 않는다.
+ *          봉인이 밀리는 동안 활성 세그먼트가 다시 가득 찼으면 대기열 끝에 다시 넣는다.
+ */
+void MessageHistory::sealer_loop()
+{
+    std::unique_lock<std::mutex> lock(sealer_mutex_);
+    while (true) {
+        sealer_cv_.wait(lock, [this] { return stop_sealer_ || !seal_queue_.empty(); });
+        if (stop_sealer_)
+            break;
+        std::string base_path = std::move(seal_queue_.front());
+        seal_queue_.pop_front();
+        ++sealing_;
+        lock.unlock();
+        bool again = false;
+        try {
+            again = seal_log(base_path);
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Failed to seal history {}: {}", base_path, e.what());
+        }
+        lock.lock();
+        --sealing_;
+        if (again)
+            seal_queue_.push_back(base_path);
+        else
+            seal_queued_.erase(base_path);
+        sealer_cv_.notify_all();
+    }
+}
+
+/**
+ * @details 압축(처음이면 사전 학습도)은 잠금 밖에서 봉인용 압축기로 한다. 봉인용 압축기가 학습한 사전은
+ *          새 블록을 색인에 넣기 전에 읽기용 압축기에도 넘겨, 읽는 쪽이 언제나 블록을 풀 수 있게 한다.
+ */
+bool MessageHistory::seal_log(const std::string &base_path)
+{
+    std::lock_guard<std::mutex> seal_lock(seal_mutex_);
+    SegmentedLog::Seal seal;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        if (closed_ || !log_for(base_path).prepare_seal(seal))
+            return false;
+    }
+    if (!SegmentedLog::build_seal(seal, *seal_codec_)) {
+        spdlog::error("Failed to seal history segment {}", base_path);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (closed_)
+        return false;
+    codec_->use_dictionary(seal_codec_->dictionary());
+    SegmentedLog& log = log_for(base_path);
+    return log.install_seal(seal) && log.rotate_if_full();
+}
+
+void MessageHistory::flush_sealing()
+{
+    std::unique_lock<std::mutex> lock(sealer_mutex_);
+    if (!sealer_thread_.joinable())
+        return;
+    sealer_cv_.wait(lock, [this] { return stop_sealer_ || (seal_queue_.empty() && sealing_ == 0); });
+}
+
+void MessageHistory::flush_search_index()
+{
+    if (backfill_.valid())
+        backfill_.wait();
+    if (search_)
+        search_->flush();
+}
+
+/**
+ * @details 잠금은 `backfill_chunk`줄을 읽는 동안만 잡아 새 메시지 기록을 오래 막지 않는다.
+ *          청크마다 색인 반영을 기다려 대기열이 한없이 커지지 않게 한다.
+ */
+void MessageHistory::backfill_search(std::vector<BackfillStream> streams)
+{
+    size_t indexed = 0;
+    for (const auto& stream : streams) {
+        for (std::uint64_t first = stream.first_line; first < stream.line_count && !stop_backfill_; first += backfill_chunk) {
+            std::vector<std::string> lines;
+            try {
+                std::lock_guard<std::mutex> lock(history_mutex);
+                size_t count = static_cast<size_t>(std::min<std::uint64_t>(backfill_chunk, stream.line_count - first));
+                lines = read_channel(stream.channel, stream.participants, first, count);
+            }
+            catch (const std::exception& e) {
+                spdlog::error("Failed to backfill search index for {}: {}", stream.channel, e.what());
+                break;
+            }
+            for (size_t i = 0; i < lines.size(); ++i) {
+                search_->add(stream.channel, first + i, message_text(lines[i]), stream.participants, entry_time(lines[i]));
+            }
+            indexed += lines.size();
+            search_->flush();
+        }
+    }
+    spdlog::info("Search index backfill finished: {} messages", indexed);
+}
+
+std::vector<std::string> MessageHistory::read_channel(const std::string &channel, const std::vector<std::string> &participants,
+                                                      std::uint64_t first_line, size_t count)
+{
+    if (channel.rfind("private/", 0) == 0)
+        return participants.size() == 2 ? private_store_->lines(participants[0], participants[1], first_line, count)
+                                        : std::vector<std::string>();
+    return log_for(history_dir_ + "/" + channel).lines(first_line, count);
+}
+
+/**
+ * @details 파일마다 대화 상대를 첫 줄의 `[보낸 사람 -> 받는 사람]`에서 읽는다. 닉네임에 `_`가 들어갈 수 있어
+ *          파일 이름으로는 두 사람을 나눌 수 없기 때문이다. 첫 줄을 해석하지 못한 파일은 옮기지 않고 남겨 둔다.
+ *          봉인된 블록이 있는 파일도 `SegmentedLog`로 읽으므로 전체 줄을 기록 순서대로 가져온다.
+ */
+size_t MessageHistory::migrate_private_files()
+{
+    if (!private_store_) return 0;
+    
+    const std::string private_dir = history_dir_ + "/private";
+    std::set<std::string> stems;
+    for (const auto& entry : fs::directory_iterator(private_dir)) {
+        auto ext = entry.path().extension();
+        if (entry.is_regular_file() && (ext == ".txt" || ext == ".idx"))
+            stems.insert(entry.path().stem().string());
+    }
+    
+    size_t migrated = 0;
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (closed_) return 0;
+    for (const auto& stem : stems) {
+        const std::string base_path = private_dir + "/" + stem;
+        try {
+            std::vector<std::string> lines;
+            {
+                SegmentedLog log(base_path, *codec_, 0, block_bytes_);
+                lines = log.lines(0, static_cast<size_t>(log.line_count()));
+            }
+            std::vector<std::string> participants = lines.empty() ? std::vector<std::string>() : private_participants(lines.front());
+            if (participants.size() != 2) {
+                spdlog::warn("Skipping private history {}: cannot tell the participants", base_path);
+                continue;
+            }
+            for (const auto& line : lines) {
+                if (!private_store_->append(participants[0], participants[1], line))
+                    throw std::runtime_error("append to private message store failed");
+            }
+            
+            fs::create_directories(private_dir + "/migrated");
+            for (const char* ext : {".txt", ".blk", ".idx"}) {
+                if (fs::exists(base_path + ext))
+                    fs::rename(base_path + ext, private_dir + "/migrated/" + stem + ext);
+            }
+            ++migrated;
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Failed to migrate private history {}: {}", base_path, e.what());
+        }
+    }
+    
+    spdlog::info("Migrated {} private conversation file(s) into {}/messages.log", migrated, private_dir);
+    return migrated;
+}
+
+void MessageHistory::set_retention(const RetentionConfig &config)
+{
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mutex_);
+        retention_ = config;
+    }
+    maintenance_cv_.notify_all();
+    if (enabled_ && config.interval.count() > 0 && !maintenance_thread_.joinable())
+        maintenance_thread_ = std::thread(&MessageHistory::maintenance_loop, this);
+}
+
+/**
+ * @details 설정을 바꾸면 깨어나 새 주기로 다시 기다린다. 주기가 0이면 다시 설정될 때까지 쉰다.
+ */
+void MessageHistory::maintenance_loop()
+{
+    std::unique_lock<std::mutex> lock(maintenance_mutex_);
+    while (!stop_maintenance_) {
+        auto interval = retention_.interval;
+        if (interval.count() <= 0) {
+            maintenance_cv_.wait(lock);
+            continue;
+        }
+        if (maintenance_cv_.wait_for(lock, interval) != std::cv_status::timeout)
+            continue;
+        lock.unlock();
+        try {
+            run_maintenance();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("History maintenance failed: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * @details 채널마다 따로 정리하므로 한 채널에서 실패해도 나머지는 계속한다.
+ *          소멸자가 중단을 요청하면 속도 제한 대기 중에도 바로 멈추고, 쓰던 임시 파일은 지운다.
+ */
+MaintenanceReport MessageHistory::run_maintenance()
+{
+    MaintenanceReport report;
+    if (!enabled_) return report;
+    
+    std::lock_guard<std::mutex> run_lock(maintenance_run_mutex_);
+    RetentionConfig config;
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mutex_);
+        config = retention_;
+    }
+    IoRateLimiter limiter(config.io_bytes_per_second);
+    std::unique_ptr<HistoryCodec> archive_codec;
+    if (!config.archive_dir.empty()) {
+        fs::create_directories(config.archive_dir);
+        archive_codec = std::make_unique<HistoryCodec>(config.archive_dir + "/history.dict");
+    }
+    
+    std::set<std::string> channels{"global"};
+    for (const auto& entry : fs::directory_iterator(history_dir_ + "/rooms")) {
+        auto ext = entry.path().extension();
+        if (ext == ".txt" || ext == ".seal" || ext == ".idx")
+            channels.insert("rooms/" + entry.path().stem().string());
+    }
+    for (const auto& channel : channels) {
+        if (stop_maintenance_) break;
+        try {
+            maintain_log(channel, config, archive_codec.get(), limiter, report);
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Failed to maintain history {}: {}", channel, e.what());
+        }
+    }
+    if (!stop_maintenance_) {
+        try {
+            maintain_private(config, archive_codec.get(), limiter, report);
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Failed to maintain private history: {}", e.what());
+        }
+    }
+    
+    if (report.channels_compacted > 0) {
+        spdlog::info("History maintenance: {} channel(s), {} block(s) dropped, {} merged, {} private message(s) dropped, {} line(s) archived, {} byte(s) reclaimed",
+                     report.channels_compacted, report.blocks_dropped, report.blocks_merged, report.private_dropped,
+                     report.lines_archived, report.bytes_reclaimed);
+    }
+    return report;
+}
+
+/**
+ * @details 블록 단위로만 버리므로 보존 기간이 지난 줄이 블록 하나만큼 더 남을 수 있다.
+ *          기간 정리는 가장 오래된 블록이 기간을 10%(최소 1시간) 더 넘겼을 때만 시작해, 매 주기마다 파일을 다시 쓰지 않는다.
+ *          크기 정리는 상한의 90%까지 줄여 같은 이유로 여유를 둔다.
+ */
+void MessageHistory::maintain_log(const std::string &channel, const RetentionConfig &config, HistoryCodec *archive_codec,
+                                  IoRateLimiter &limiter, MaintenanceReport &report)
+{
+    const RetentionPolicy& policy = config.policy_for(channel);
+    const std::string relative = channel == "global" ? "global/history" : channel;
+    const std::string base_path = history_dir_ + "/" + relative;
+    
+    std::string cutoff;
+    std::string trigger;
+    if (policy.max_age.count() > 0) {
+        auto now = std::chrono::system_clock::now();
+        cutoff = format_timestamp(now - policy.max_age);
+        trigger = format_timestamp(now - policy.max_age - std::max<std::chrono::hours>(policy.max_age / 10, std::chrono::hours(1)));
+    }
+    
+    std::vector<SegmentedLog::BlockIndex> blocks;
+    std::uint64_t total = 0;
+    size_t block_bytes = 0;
+    bool seal_first = false;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        if (closed_ || !history_exists(base_path)) return;
+        SegmentedLog& log = log_for(base_path);
+        // 봉인되지 않은 줄에 오래된 줄이 있으면 먼저 봉인해야 블록 단위로 정리할 수 있다.
+        std::string first_active = log.first_active_time();
+        bool active_expired = !trigger.empty() && !first_active.empty() && first_active < trigger;
+        std::uint64_t size = log.active_bytes();
+        for (const auto& block : log.blocks())
+            size += block.stored_size;
+        seal_first = active_expired || (policy.max_bytes > 0 && size > policy.max_bytes && log.active_bytes() > 0);
+        if (seal_first)
+            log.rotate();
+    }
+    if (seal_first) {
+        // 압축은 잠금 밖에서 한다. 봉인이 밀려 있어 돌리지 못했으면 밀린 세그먼트를 먼저 봉인하고 활성 세그먼트를 다시 돌린다.
+        bool again = seal_log(base_path);
+        if (!again) {
+            std::lock_guard<std::mutex> lock(history_mutex);
+            again = !closed_ && log_for(base_path).rotate();
+        }
+        if (again && seal_log(base_path))
+            schedule_seal(base_path);
+    }
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        SegmentedLog& log = log_for(base_path);
+        blocks = log.blocks();
+        total = log.active_bytes();
+        block_bytes = block_bytes_;
+    }
+    for (const auto& block : blocks)
+        total += block.stored_size;
+    
+    auto time_of = [](const char (&field)[20]) { return std::string(field, strnlen(field, sizeof(field))); };
+    size_t drop = 0;
+    size_t dropped_data = 0;
+    std::uint64_t remaining = total;
+    bool age_trigger = false;
+    if (!cutoff.empty()) {
+        for (const auto& block : blocks) {
+            if (block.line_count > 0) {
+                age_trigger = time_of(block.last_time) < trigger;
+                break;
+            }
+        }
+        while (drop < blocks.size() && (blocks[drop].line_count == 0 || time_of(blocks[drop].last_time) < cutoff)) {
+            dropped_data += blocks[drop].line_count > 0 ? 1 : 0;
+            remaining -= blocks[drop].stored_size;
+            ++drop;
+        }
+    }
+    bool over_size = policy.max_bytes > 0 && total > policy.max_bytes;
+    if (over_size) {
+        const std::uint64_t target = policy.max_bytes / 10 * 9;
+        while (drop < blocks.size() && remaining > target) {
+            dropped_data += blocks[drop].line_count > 0 ? 1 : 0;
+            remaining -= blocks[drop].stored_size;
+            ++drop;
+        }
+    }
+    bool merge_run = false;
+    for (size_t i = drop; i + 1 < blocks.size() && !merge_run; ++i) {
+        merge_run = blocks[i].line_count > 0 && blocks[i + 1].line_count > 0 &&
+                    blocks[i].raw_size < block_bytes / 2 && blocks[i + 1].raw_size < block_bytes / 2;
+    }
+    if (!merge_run && (dropped_data == 0 || !(age_trigger || over_size)))
+        return;
+    
+    // 보관 파일은 정리 스레드만 쓰므로 잠금 없이 기록한다. 정리가 실패하면 다음 주기에 같은 줄이 다시 보관될 수 있다.
+    std::unique_ptr<SegmentedLog> archive;
+    size_t archived = 0;
+    std::function<void(const std::string&)> on_dropped;
+    if (archive_codec && dropped_data > 0) {
+        const std::string archive_path = config.archive_dir + "/" + relative;
+        fs::create_directories(fs::path(archive_path).parent_path());
+        archive = std::make_unique<SegmentedLog>(archive_path, *archive_codec, 0, block_bytes);
+        on_dropped = [&](const std::string& line) {
+            if (archive->append(line)) ++archived;
+        };
+    }
+    
+    // 실시간 기록의 압축기는 잠금 안에서만 쓰므로, 지금 저장된 사전으로 따로 만든다.
+    HistoryCodec codec(history_dir_ + "/history.dict");
+    SegmentedLog::Rewrite rewrite;
+    auto throttle = [&](std::uint64_t bytes) { return limiter.acquire(bytes, stop_maintenance_); };
+    if (!SegmentedLog::rewrite(base_path, blocks, drop, codec, block_bytes, throttle, on_dropped, rewrite)) {
+        if (!stop_maintenance_)
+            spdlog::warn("Failed to compact history {}", base_path);
+        return;
+    }
+    if (archive)
+        archive->seal();
+    
+    bool installed = false;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        SegmentedLog& log = log_for(base_path);
+        installed = !closed_ && log.install(rewrite);
+        // 검색 결과를 채울 때 이 잠금을 잡으므로, 여기서 바꾸면 지워진 줄을 가리키는 결과가 나가지 않는다.
+        if (installed && search_ && channel != "global")
+            search_->set_floor(channel, log.first_line());
+    }
+    if (!installed)
+        return;
+    ++report.channels_compacted;
+    report.blocks_dropped += rewrite.dropped;
+    report.blocks_merged += rewrite.merged;
+    report.lines_archived += archived;
+    report.bytes_reclaimed += rewrite.bytes_before > rewrite.bytes_after ? rewrite.bytes_before - rewrite.bytes_after : 0;
+    spdlog::debug("Compacted history {}: {} block(s) dropped, {} merged", base_path, rewrite.dropped, rewrite.merged);
+}
+
+/**
+ * @details 귓속말은 한 파일에 기록 순서대로 쌓이므로 앞쪽 레코드부터 정리된다.
+ *          기간 정리와 크기 정리의 여유는 `maintain_log`와 같다.
+ */
+void MessageHistory::maintain_private(const RetentionConfig &config, HistoryCodec *archive_codec,
+                                      IoRateLimiter &limiter, MaintenanceReport &report)
+{
+    const RetentionPolicy& policy = config.policy_for("private");
+    if (!private_store_ || policy.unlimited()) return;
+    
+    std::string cutoff;
+    std::string trigger;
+    if (policy.max_age.count() > 0) {
+        auto now = std::chrono::system_clock::now();
+        cutoff = format_timestamp(now - policy.max_age);
+        trigger = format_timestamp(now - policy.max_age - std::max<std::chrono::hours>(policy.max_age / 10, std::chrono::hours(1)));
+    }
+    
+    std::uint64_t end = 0;
+    std::string oldest;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        end = private_store_->size_bytes();
+        oldest = private_store_->oldest_line();
+    }
+    bool age_trigger = !trigger.empty() && !oldest.empty() && oldest.compare(0, timestamp_length, trigger) < 0;
+    bool over_size = policy.max_bytes > 0 && end > policy.max_bytes;
+    if (!age_trigger && !over_size)
+        return;
+    
+    const std::uint64_t drop_until = over_size ? end - policy.max_bytes / 10 * 9 : 0;
+    auto keep = [&](const PrivateMessageStore::Conversation&, const std::string& line, std::uint64_t offset) {
+        return offset >= drop_until && (cutoff.empty() || line.compare(0, timestamp_length, cutoff) >= 0);
+    };
+    
+    std::unique_ptr<SegmentedLog> archive;
+    size_t archived = 0;
+    std::function<void(const std::string&)> on_dropped;
+    if (archive_codec) {
+        fs::create_directories(config.archive_dir + "/private");
+        archive = std::make_unique<SegmentedLog>(config.archive_dir + "/private/messages", *archive_codec, 0, block_bytes_);
+        on_dropped = [&](const std::string& line) {
+            if (archive->append(line)) ++archived;
+        };
+    }
+    
+    const std::string path = history_dir_ + "/private/messages.log";
+    PrivateMessageStore::Rewrite rewrite;
+    auto throttle = [&](std::uint64_t bytes) { return limiter.acquire(bytes, stop_maintenance_); };
+    if (!PrivateMessageStore::rewrite(path, end, keep, throttle, on_dropped, rewrite)) {
+        if (!stop_maintenance_)
+            spdlog::warn("Failed to compact private history {}", path);
+        return;
+    }
+    if (archive)
+        archive->seal();
+    
+    bool installed = false;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        installed = !closed_ && private_store_->install(rewrite);
+        if (installed && search_) {
+            for (const auto& [users, first] : private_store_->first_lines()) {
+                if (first > 0)
+                    search_->set_floor("private/" + users.first + "_" + users.second, first);
+            }
+        }
+    }
+    if (!installed)
+        return;
+    ++report.channels_compacted;
+    report.private_dropped += rewrite.dropped_records;
+    report.lines_archived += archived;
+    report.bytes_reclaimed += end > rewrite.written ? end - rewrite.written : 0;
+    spdlog::debug("Compacted private history {}: {} message(s) dropped", path, rewrite.dropped_records);
+}
+
+/**
+ * @details 처음 여는 파일은 색인을 읽고 봉인 대기/활성 세그먼트의 줄 수를 센 뒤 캐시합니다.
+ *          이후에는 색인을 메모리에서 바로 사용합니다.
+ */
+SegmentedLog &MessageHistory::log_for(const std::string &base_path)
+{
+    auto &log = logs_[base_path];
+    if (!log) {
+        log = std::make_unique<SegmentedLog>(base_path, *codec_, segment_bytes_, block_bytes_);
+        // 지난번에 봉인하지 못하고 끝난 세그먼트
+        if (log->has_pending())
+            schedule_seal(base_path);
+    }
+    return *log;
+}
+
 // 익명 네임스페이스 내의 유틸리티 함수 구현
 namespace {
     // 타임스탬프 생성
     std::string get_timestamp()
     {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
+        return format_timestamp(std::chrono::system_clock::now());
+    }
+    
+    // 기록 줄과 같은 형식의 현지 시각 문자열
+    std::string format_timestamp(std::chrono::system_clock::time_point time_point)
+    {
+        auto time = std::chrono::system_clock::to_time_t(time_point);
         
         std::stringstream ss;
         struct tm timeinfo;
@@ -209,26 +999,49 @@ namespace {
         return ss.str();
     }
 
-    // 파일의 마지막 N줄 읽기
-    std::vector<std::string> read_last_lines(const std::string& filename, size_t limit)
+    // 활성 세그먼트, 봉인 대기 세그먼트, 봉인된 블록 색인 중 하나라도 있는지 확인
+    bool history_exists(const std::string& base_path)
     {
-        std::vector<std::string> lines;
-        std::ifstream file(filename);
-        
-        if (!file.is_open()) return lines;
-        
-        // 파일의 모든 줄을 읽어옴
-        std::string line;
-        while (std::getline(file, line)) {
-            lines.push_back(line);
-        }
-        
-        // limit가 0이거나 라인 수보다 크면 모든 줄 반환
-        if (limit == 0 || limit >= lines.size()) {
-            return lines;
-        }
-        
-        // 마지막 limit 줄만 반환
-        return std::vector<std::string>(lines.end() - limit, lines.end());
+        return fs::exists(base_path + ".txt") || fs::exists(base_path + ".seal") || fs::exists(base_path + ".idx");
+    }
+
+    // "<시각> [<보낸 사람>]: <본문>" 형식의 기록 줄에서 본문만 꺼냄
+    std::string message_text(const std::string& entry)
+    {
+        auto pos = entry.find("]: ");
+        return pos == std::string::npos ? entry : entry.substr(pos + 3);
+    }
+
+    // 기록 줄 앞의 현지 시각을 Unix 초로 바꿈 (읽을 수 없으면 0)
+    std::uint64_t entry_time(const std::string& entry)
+    {
+        std::tm timeinfo{};
+        std::istringstream in(entry.substr(0, timestamp_length));
+        in >> std::get_time(&timeinfo, "%Y-%m-%d %H:%M:%S");
+        if (in.fail())
+            return 0;
+        timeinfo.tm_isdst = -1;
+        std::time_t time = std::mktime(&timeinfo);
+        return time < 0 ? 0 : static_cast<std::uint64_t>(time);
+    }
+
+    // 시각 뒤에 붙이는 " #<순번>" (순번이 0이면 빈 문자열)
+    std::string seq_tag(std::uint64_t seq)
+    {
+        return seq == 0 ? std::string() : " #" + std::to_string(seq);
     }
-}
\ No newline at end of file
+
+    // "<시각> [<보낸 사람> -> <받는 사람>]: <본문>" 형식의 귓속말 기록에서 두 사람을 꺼냄
+    std::vector<std::string> private_participants(const std::string& entry)
+    {
+        auto open = entry.find(" [");
+        auto close = entry.find("]: ");
+        if (open == std::string::npos || close == std::string::npos || close < open)
+            return {};
+        std::string pair = entry.substr(open + 2, close - open - 2);
+        auto arrow = pair.find(" -> ");
+        if (arrow == std::string::npos)
+            return {};
+        return {pair.substr(0, arrow), pair.substr(arrow + 4)};
+    }
+}
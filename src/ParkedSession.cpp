@@ -0,0 +1,56 @@
+/**
+ * @file ParkedSession.cpp
+ * @brief `ParkedSession` 클래스의 구현부입니다.
+ */
+
+#include "ParkedSession.hpp"
+
+ParkedSession::ParkedSession(net::io_context& ioc, const std::string& nickname, const std::string& remote_id,
+                             const std::string& current_room, std::size_t max_backlog)
+    : strand_(net::make_strand(net::any_io_executor(ioc.get_executor()))),
+      nickname_(nickname),
+      remote_id_(remote_id),
+      current_room_(current_room),
+      max_backlog_(max_backlog)
+{
+}
+
+void ParkedSession::deliver(const std::string& msg)
+{
+    SessionPtr target;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!forward_to_) {
+            if (backlog_.size() >= max_backlog_) {
+                backlog_.pop_front();
+                ++dropped_;
+            }
+            backlog_.push_back(msg);
+            return;
+        }
+        target = forward_to_;
+    }
+    target->deliver(msg);
+}
+
+/**
+ * @details 백로그를 넘기는 동안에도 다른 스레드가 `deliver`를 호출할 수 있으므로,
+ *          전달 대상 지정과 백로그 전달을 같은 잠금 안에서 처리하여 순서가 뒤바뀌지 않게 합니다.
+ */
+std::size_t ParkedSession::resume_into(const SessionPtr& target)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = backlog_.size();
+    for (const auto& msg : backlog_) {
+        target->deliver(msg);
+    }
+    backlog_.clear();
+    forward_to_ = target;
+    return count;
+}
+
+std::size_t ParkedSession::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
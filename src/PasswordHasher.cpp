@@ -0,0 +1,277 @@
+/**
+ * @file PasswordHasher.cpp
+ * @brief `PasswordHasher`와 `CredentialCache` 클래스의 구현부입니다.
+ */
+
+#include "PasswordHasher.hpp"
+#include "spdlog/spdlog.h"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+namespace {
+    constexpr std::size_t salt_size = 16;
+    constexpr std::size_t key_size = 32;
+    /// 저장된 해시의 비용이 이보다 크면 거부한다. (손상된 값으로 메모리를 과하게 쓰지 않도록)
+    constexpr int max_log2_n = 20;
+    constexpr int max_r = 32;
+    constexpr int max_p = 16;
+
+    std::string to_hex(const unsigned char* data, std::size_t size)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string out;
+        out.reserve(size * 2);
+        for (std::size_t i = 0; i < size; ++i) {
+            out.push_back(digits[data[i] >> 4]);
+            out.push_back(digits[data[i] & 0x0F]);
+        }
+        return out;
+    }
+
+    bool from_hex(const std::string& hex, std::vector<unsigned char>& out)
+    {
+        auto value = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        };
+        if (hex.empty() || hex.size() % 2 != 0)
+            return false;
+        out.resize(hex.size() / 2);
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            int high = value(hex[2 * i]);
+            int low = value(hex[2 * i + 1]);
+            if (high < 0 || low < 0)
+                return false;
+            out[i] = static_cast<unsigned char>((high << 4) | low);
+        }
+        return true;
+    }
+
+    bool scrypt(const std::string& password, const unsigned char* salt, std::size_t salt_length,
+                const KdfParams& params, unsigned char* key, std::size_t key_length)
+    {
+        if (params.log2_n < 1 || params.log2_n > max_log2_n || params.r < 1 || params.r > max_r ||
+            params.p < 1 || params.p > max_p)
+            return false;
+        const std::uint64_t n = 1ull << params.log2_n;
+        // scrypt가 쓰는 메모리 (128 * r * (N + p)) 에 여유를 둔 상한
+        const std::uint64_t max_mem = 128ull * params.r * (n + params.p) + (1u << 20);
+        return EVP_PBE_scrypt(password.data(), password.size(), salt, salt_length, n,
+                              static_cast<std::uint64_t>(params.r), static_cast<std::uint64_t>(params.p),
+                              max_mem, key, key_length) == 1;
+    }
+}
+
+PasswordHasher::PasswordHasher(std::size_t threads, std::size_t max_queue, KdfParams params)
+    : params_(params),
+      max_queue_(max_queue == 0 ? 1 : max_queue)
+{
+    threads = std::max<std::size_t>(threads, 1);
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(&PasswordHasher::worker_loop, this);
+}
+
+PasswordHasher::~PasswordHasher()
+{
+    stop();
+}
+
+void PasswordHasher::stop()
+{
+    std::deque<std::function<void()>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ && workers_.empty())
+            return;
+        stopped_ = true;
+        dropped.swap(jobs_);
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers_.clear();
+    if (!dropped.empty())
+        spdlog::info("PasswordHasher stopped. Dropped {} queued jobs.", dropped.size());
+}
+
+std::size_t PasswordHasher::queued() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+bool PasswordHasher::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || jobs_.size() >= max_queue_)
+            return false;
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+bool PasswordHasher::hash_async(std::string password, std::function<void(std::string encoded)> done)
+{
+    return submit([this, password = std::move(password), done = std::move(done)]() {
+        done(hash(password, params_));
+    });
+}
+
+bool PasswordHasher::verify_async(std::string password, std::string encoded, std::function<void(bool ok)> done)
+{
+    return submit([password = std::move(password), encoded = std::move(encoded), done = std::move(done)]() {
+        done(verify(password, encoded));
+    });
+}
+
+/**
+ * @details 작업 하나가 예외를 던져도 스레드는 계속 다음 작업을 처리한다.
+ */
+void PasswordHasher::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return stopped_ || !jobs_.empty(); });
+        if (stopped_)
+            return;
+        auto job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+        try {
+            job();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("PasswordHasher job failed: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+std::string PasswordHasher::hash(const std::string& password, const KdfParams& params)
+{
+    unsigned char salt[salt_size];
+    unsigned char key[key_size];
+    if (RAND_bytes(salt, sizeof(salt)) != 1 || !scrypt(password, salt, sizeof(salt), params, key, sizeof(key))) {
+        spdlog::error("PasswordHasher: scrypt failed (ln={}, r={}, p={})", params.log2_n, params.r, params.p);
+        return "";
+    }
+    char cost[64];
+    std::snprintf(cost, sizeof(cost), "ln=%d,r=%d,p=%d", params.log2_n, params.r, params.p);
+    return "$scrypt$" + std::string(cost) + "$" + to_hex(salt, sizeof(salt)) + "$" + to_hex(key, sizeof(key));
+}
+
+bool PasswordHasher::verify(const std::string& password, const std::string& encoded)
+{
+    // $scrypt$ln=..,r=..,p=..$<salt>$<key>
+    const std::string prefix = "$scrypt$";
+    if (encoded.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    auto cost_end = encoded.find('$', prefix.size());
+    if (cost_end == std::string::npos)
+        return false;
+    auto salt_end = encoded.find('$', cost_end + 1);
+    if (salt_end == std::string::npos)
+        return false;
+
+    KdfParams params;
+    char tail = 0;
+    std::string cost = encoded.substr(prefix.size(), cost_end - prefix.size());
+    if (std::sscanf(cost.c_str(), "ln=%d,r=%d,p=%d%c", &params.log2_n, &params.r, &params.p, &tail) != 3)
+        return false;
+
+    std::vector<unsigned char> salt;
+    std::vector<unsigned char> expected;
+    if (!from_hex(encoded.substr(cost_end + 1, salt_end - cost_end - 1), salt) ||
+        !from_hex(encoded.substr(salt_end + 1), expected) || expected.size() > 256)
+        return false;
+
+    std::vector<unsigned char> key(expected.size());
+    if (!scrypt(password, salt.data(), salt.size(), params, key.data(), key.size()))
+        return false;
+    return CRYPTO_memcmp(key.data(), expected.data(), key.size()) == 0;
+}
+
+CredentialCache::CredentialCache(std::chrono::seconds ttl, std::size_t max_entries)
+    : ttl_(ttl),
+      max_entries_(max_entries == 0 ? 1 : max_entries)
+{
+}
+
+void CredentialCache::set_ttl(std::chrono::seconds ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = ttl;
+}
+
+std::string CredentialCache::issue(const std::string& username)
+{
+    unsigned char random[16];
+    if (RAND_bytes(random, sizeof(random)) != 1)
+        return "";
+    std::string token = to_hex(random, sizeof(random));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ttl_.count() <= 0)
+        return "";
+    auto now = Clock::now();
+    auto expires = now + ttl_;
+    entries_[token] = Entry{username, expires};
+    order_.emplace_back(expires, token);
+    purge(now);
+    return token;
+}
+
+bool CredentialCache::check(const std::string& username, const std::string& token)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(token);
+    if (it == entries_.end())
+        return false;
+    if (it->second.expires <= Clock::now()) {
+        entries_.erase(it);
+        return false;
+    }
+    return it->second.username == username;
+}
+
+void CredentialCache::revoke_user(const std::string& username)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.username == username)
+            it = entries_.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::size_t CredentialCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+/**
+ * @details `order_`에는 폐기된 토큰도 남아 있으므로 `entries_`에 없으면 건너뛴다.
+ */
+void CredentialCache::purge(Clock::time_point now)
+{
+    while (!order_.empty() && (order_.front().first <= now || order_.size() > max_entries_)) {
+        auto it = entries_.find(order_.front().second);
+        if (it != entries_.end() && it->second.expires == order_.front().first)
+            entries_.erase(it);
+        order_.pop_front();
+    }
+}
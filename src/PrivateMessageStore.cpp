@@ -0,0 +1,338 @@
+/**
+ * @file PrivateMessageStore.cpp
+ * @brief `PrivateMessageStore` 클래스의 구현부입니다.
+ */
+
+#include "PrivateMessageStore.hpp"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+    /// 레코드 머리 크기 (u32 길이 + u16 이름1 길이 + u16 이름2 길이)
+    constexpr std::size_t header_size = 8;
+
+    void put_le(std::string& out, std::uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    std::uint64_t get_le(const char* in, int bytes)
+    {
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+        return value;
+    }
+
+    /**
+     * @brief `offset`의 레코드를 읽습니다. `line`이 null이면 기록 줄은 건너뜁니다.
+     * @return 레코드 전체 크기. `end`를 넘거나 읽지 못하면 0.
+     */
+    std::uint64_t read_record(std::ifstream& file, std::uint64_t offset, std::uint64_t end,
+                              std::string& user1, std::string& user2, std::uint32_t& length, std::string* line)
+    {
+        char header[header_size];
+        if (offset + header_size > end || !file.read(header, header_size))
+            return 0;
+        auto total = static_cast<std::uint32_t>(get_le(header, 4));
+        auto length1 = static_cast<std::uint16_t>(get_le(header + 4, 2));
+        auto length2 = static_cast<std::uint16_t>(get_le(header + 6, 2));
+        if (total < static_cast<std::uint32_t>(length1) + length2 || offset + header_size + total > end)
+            return 0;
+        user1.assign(length1, '\0');
+        user2.assign(length2, '\0');
+        if (!file.read(user1.data(), length1) || !file.read(user2.data(), length2))
+            return 0;
+        length = total - length1 - length2;
+        if (line) {
+            line->assign(length, '\0');
+            if (!file.read(line->data(), length))
+                return 0;
+        } else {
+            file.seekg(length, std::ios::cur);
+        }
+        return header_size + total;
+    }
+
+    std::string encode_record(const std::string& first, const std::string& second, const std::string& line)
+    {
+        std::string record;
+        record.reserve(header_size + first.size() + second.size() + line.size());
+        put_le(record, first.size() + second.size() + line.size(), 4);
+        put_le(record, first.size(), 2);
+        put_le(record, second.size(), 2);
+        record += first;
+        record += second;
+        record += line;
+        return record;
+    }
+}
+
+PrivateMessageStore::PrivateMessageStore(std::string path)
+    : path_(std::move(path))
+{
+    load();
+    out_.open(path_, std::ios::app | std::ios::binary);
+    in_.open(path_, std::ios::binary);
+    if (!out_.is_open() || !in_.is_open())
+        spdlog::error("Failed to open private message store: {}", path_);
+}
+
+std::string PrivateMessageStore::key_of(const std::string& user1, const std::string& user2)
+{
+    return user1 < user2 ? user1 + '\0' + user2 : user2 + '\0' + user1;
+}
+
+/**
+ * @details 레코드 머리와 이름만 읽고 본문은 건너뛰므로, 파일 크기보다 레코드 수에 비례하는 시간이 듭니다.
+ *          파일 끝에서 잘린 레코드를 발견하면 그 앞까지 잘라 다음 레코드가 어긋나지 않게 합니다.
+ */
+void PrivateMessageStore::load()
+{
+    std::error_code ec;
+    std::uint64_t file_size = fs::exists(path_, ec) ? fs::file_size(path_, ec) : 0;
+    std::uint64_t offset = 0;
+
+    std::ifstream file(path_, std::ios::binary);
+    std::string user1;
+    std::string user2;
+    std::uint32_t length = 0;
+    while (file.is_open()) {
+        std::uint64_t size = read_record(file, offset, file_size, user1, user2, length, nullptr);
+        if (size == 0)
+            break;
+        Entry& entry = index_[key_of(user1, user2)];
+        if (entry.records.empty())
+            entry.users = {user1, user2};
+        entry.records.push_back(Record{offset + size - length, length});
+        offset += size;
+    }
+
+    if (offset < file_size) {
+        spdlog::warn("Truncating {} incomplete byte(s) at the end of {}", file_size - offset, path_);
+        fs::resize_file(path_, offset, ec);
+    }
+    end_offset_ = offset;
+}
+
+bool PrivateMessageStore::append(const std::string& user1, const std::string& user2, const std::string& line)
+{
+    if (!out_.is_open() || user1.size() > 0xFFFF || user2.size() > 0xFFFF || line.size() > 0xFFFF0000u)
+        return false;
+    const std::string& first = user1 < user2 ? user1 : user2;
+    const std::string& second = user1 < user2 ? user2 : user1;
+
+    std::string record = encode_record(first, second, line);
+    out_.write(record.data(), static_cast<std::streamsize>(record.size()));
+    out_.flush();
+    if (!out_) {
+        // 일부만 쓰였을 수 있으므로 잘라 내고 다시 연다.
+        out_.close();
+        std::error_code ec;
+        fs::resize_file(path_, end_offset_, ec);
+        out_.open(path_, std::ios::app | std::ios::binary);
+        return false;
+    }
+
+    Entry& entry = index_[key_of(first, second)];
+    if (entry.records.empty())
+        entry.users = {first, second};
+    entry.records.push_back(Record{end_offset_ + header_size + first.size() + second.size(), static_cast<std::uint32_t>(line.size())});
+    end_offset_ += record.size();
+    return true;
+}
+
+const PrivateMessageStore::Entry* PrivateMessageStore::find(const std::string& user1, const std::string& user2) const
+{
+    auto it = index_.find(key_of(user1, user2));
+    return it == index_.end() ? nullptr : &it->second;
+}
+
+std::uint64_t PrivateMessageStore::line_count(const std::string& user1, const std::string& user2) const
+{
+    const Entry* entry = find(user1, user2);
+    return entry ? entry->base + entry->records.size() : 0;
+}
+
+std::uint64_t PrivateMessageStore::first_line(const std::string& user1, const std::string& user2) const
+{
+    const Entry* entry = find(user1, user2);
+    return entry ? entry->base : 0;
+}
+
+std::vector<std::pair<PrivateMessageStore::Conversation, std::uint64_t>> PrivateMessageStore::first_lines() const
+{
+    std::vector<std::pair<Conversation, std::uint64_t>> result;
+    result.reserve(index_.size());
+    for (const auto& [key, entry] : index_)
+        result.emplace_back(entry.users, entry.base);
+    return result;
+}
+
+std::vector<std::string> PrivateMessageStore::last_lines(const std::string& user1, const std::string& user2, std::size_t limit)
+{
+    std::uint64_t total = line_count(user1, user2);
+    std::uint64_t first = limit == 0 || limit >= total ? 0 : total - limit;
+    return lines(user1, user2, first, static_cast<std::size_t>(total - first));
+}
+
+std::vector<std::string> PrivateMessageStore::lines(const std::string& user1, const std::string& user2, std::uint64_t first, std::size_t count)
+{
+    std::vector<std::string> result;
+    const Entry* entry = find(user1, user2);
+    if (!entry)
+        return result;
+    // 줄 번호를 정리 후 남은 레코드 위치로 바꾼다.
+    std::uint64_t end_line = first + count;
+    if (end_line <= entry->base)
+        return result;
+    std::uint64_t begin = first > entry->base ? first - entry->base : 0;
+    std::size_t end = static_cast<std::size_t>(std::min<std::uint64_t>(entry->records.size(), end_line - entry->base));
+    for (std::size_t i = static_cast<std::size_t>(begin); i < end; ++i) {
+        std::string line;
+        if (!read_line(entry->records[i], line))
+            break;
+        result.push_back(std::move(line));
+    }
+    return result;
+}
+
+std::vector<PrivateMessageStore::Conversation> PrivateMessageStore::conversations() const
+{
+    std::vector<Conversation> result;
+    result.reserve(index_.size());
+    for (const auto& [key, entry] : index_) {
+        if (!entry.records.empty())
+            result.push_back(entry.users);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::string PrivateMessageStore::oldest_line()
+{
+    std::string user1;
+    std::string user2;
+    std::string line;
+    std::uint32_t length = 0;
+    in_.clear();
+    in_.seekg(0);
+    return read_record(in_, 0, end_offset_, user1, user2, length, &line) > 0 ? line : std::string();
+}
+
+bool PrivateMessageStore::read_line(const Record& record, std::string& out)
+{
+    out.assign(record.length, '\0');
+    in_.clear();
+    in_.seekg(static_cast<std::streamoff>(record.offset));
+    return static_cast<bool>(in_.read(out.data(), record.length));
+}
+
+/**
+ * @details 레코드를 처음부터 순서대로 읽으므로 디스크를 순차로만 읽고 씁니다. 남기는 레코드는 바이트를 그대로 옮깁니다.
+ */
+bool PrivateMessageStore::rewrite(const std::string& path, std::uint64_t end, const KeepFn& keep,
+                                  const std::function<bool(std::uint64_t)>& throttle,
+                                  const std::function<void(const std::string&)>& on_dropped, Rewrite& out)
+{
+    out = Rewrite{};
+    const std::string compact_path = path + ".compact";
+    std::ifstream in(path, std::ios::binary);
+    std::ofstream file(compact_path, std::ios::trunc | std::ios::binary);
+    if (!in.is_open() || !file.is_open())
+        return false;
+    auto fail = [&]() {
+        file.close();
+        std::error_code ec;
+        fs::remove(compact_path, ec);
+        return false;
+    };
+
+    std::uint64_t offset = 0;
+    Conversation users;
+    std::string line;
+    std::uint32_t length = 0;
+    while (offset < end) {
+        std::uint64_t size = read_record(in, offset, end, users.first, users.second, length, &line);
+        if (size == 0 || !throttle(size))
+            return fail();
+        if (keep(users, line, offset)) {
+            std::string record = encode_record(users.first, users.second, line);
+            if (!throttle(record.size()))
+                return fail();
+            file.write(record.data(), static_cast<std::streamsize>(record.size()));
+            out.written += record.size();
+        } else {
+            ++out.dropped[key_of(users.first, users.second)];
+            ++out.dropped_records;
+            if (on_dropped)
+                on_dropped(line);
+        }
+        offset += size;
+    }
+    file.close();
+    if (!file)
+        return fail();
+    out.scanned_end = end;
+    return true;
+}
+
+/**
+ * @details 파일을 바꾼 뒤 색인을 처음부터 다시 만들고, 대화마다 이전 첫 줄 번호에 버린 줄 수를 더해 줄 번호를 유지합니다.
+ */
+bool PrivateMessageStore::install(const Rewrite& rewrite)
+{
+    const std::string compact_path = path_ + ".compact";
+    std::error_code ec;
+    if (rewrite.scanned_end > end_offset_) {
+        fs::remove(compact_path, ec);
+        return false;
+    }
+    out_.flush();
+    {
+        std::ofstream file(compact_path, std::ios::app | std::ios::binary);
+        std::string tail(static_cast<std::size_t>(end_offset_ - rewrite.scanned_end), '\0');
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(rewrite.scanned_end));
+        if (!in_.read(tail.data(), static_cast<std::streamsize>(tail.size())))
+            tail.clear();
+        file.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+        file.close();
+        if (!file || tail.size() != end_offset_ - rewrite.scanned_end) {
+            spdlog::error("Failed to copy new private messages into {}", compact_path);
+            fs::remove(compact_path, ec);
+            return false;
+        }
+    }
+
+    // 모든 줄을 버린 대화도 빈 항목으로 남겨, 새 메시지의 줄 번호가 예전 번호와 겹치지 않게 한다.
+    std::unordered_map<std::string, Entry> previous;
+    for (auto& [key, entry] : index_) {
+        auto it = rewrite.dropped.find(key);
+        previous[key] = Entry{std::move(entry.users), entry.base + (it == rewrite.dropped.end() ? 0 : it->second), {}};
+    }
+    out_.close();
+    in_.close();
+    fs::rename(compact_path, path_, ec);
+    if (ec) {
+        spdlog::error("Failed to install compacted private messages {}: {}", path_, ec.message());
+        fs::remove(compact_path, ec);
+    }
+
+    index_.clear();
+    load();
+    for (auto& [key, old_entry] : previous) {
+        Entry& entry = index_[key];
+        entry.users = std::move(old_entry.users);
+        entry.base = old_entry.base;
+    }
+    out_.open(path_, std::ios::app | std::ios::binary);
+    in_.open(path_, std::ios::binary);
+    return !ec;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file SearchIndex.cpp
+ * @brief `SearchIndex` 클래스의 구현부입니다.
+ */
+
+#include "SearchIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+    constexpr char32_t hangul_first = 0xAC00;
+    constexpr char32_t hangul_last = 0xD7A3;
+
+    bool is_hangul(char32_t cp) { return cp >= hangul_first && cp <= hangul_last; }
+
+    /// 단어를 이루는 문자인지 확인합니다. (ASCII 영숫자와 한글 외의 비 ASCII 문자)
+    bool is_word(char32_t cp)
+    {
+        if (cp < 0x80)
+            return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+        return !is_hangul(cp) && cp != 0x3000; // 전각 공백 제외
+    }
+
+    /// UTF-8 문자 하나를 읽습니다. 잘못되거나 잘린 바이트는 하나씩 건너뛰며 구분자로 취급합니다.
+    char32_t next_code_point(const std::string& text, std::size_t pos, std::size_t& length)
+    {
+        unsigned char c = static_cast<unsigned char>(text[pos]);
+        std::size_t extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 : (c >> 3) == 0x1E ? 3 : 4;
+        length = 1;
+        if (extra == 4 || pos + extra >= text.size())
+            return extra == 0 ? c : U' ';
+        char32_t cp = extra == 0 ? c : extra == 1 ? (c & 0x1F) : extra == 2 ? (c & 0x0F) : (c & 0x07);
+        for (std::size_t i = 1; i <= extra; ++i) {
+            unsigned char next = static_cast<unsigned char>(text[pos + i]);
+            if ((next & 0xC0) != 0x80)
+                return U' ';
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        length = extra + 1;
+        return cp;
+    }
+
+    void put_varint(std::string& out, std::uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    std::uint64_t get_varint(const std::string& in, std::size_t& pos)
+    {
+        std::uint64_t value = 0;
+        int shift = 0;
+        while (pos < in.size()) {
+            unsigned char byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+            shift += 7;
+        }
+        return value;
+    }
+
+    /// 한 음절짜리 한글 토큰인지 확인합니다. (UTF-8로 3바이트)
+    bool is_single_syllable(const std::string& token)
+    {
+        std::size_t length = 0;
+        return token.size() == 3 && is_hangul(next_code_point(token, 0, length));
+    }
+}
+
+SearchIndex::SearchIndex(std::size_t batch_size, std::chrono::milliseconds flush_interval)
+    : batch_size_(batch_size == 0 ? 1 : batch_size),
+      flush_interval_(flush_interval),
+      worker_([this]() { run(); })
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void SearchIndex::add(const std::string& channel, std::uint64_t line, std::string text, std::vector<std::string> participants,
+                      std::uint64_t time)
+{
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        queue_.push_back(Pending{channel, line, std::move(text), std::move(participants), time});
+        ++queued_;
+        notify = queue_.size() >= batch_size_;
+    }
+    if (notify)
+        queue_cv_.notify_one();
+}
+
+void SearchIndex::flush()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    std::uint64_t target = queued_;
+    flush_requested_ = true;
+    queue_cv_.notify_one();
+    applied_cv_.wait(lock, [&]() { return applied_ >= target || stopping_; });
+}
+
+/**
+ * @details 아직 문서가 없는 채널이면 채널만 먼저 만들어, 대기열에 남아 있던 정리된 줄도 검색되지 않게 합니다.
+ */
+void SearchIndex::set_floor(const std::string& channel, std::uint64_t first_line)
+{
+    std::unique_lock<std::shared_mutex> lock(index_mutex_);
+    auto [it, inserted] = channel_ids_.try_emplace(channel, static_cast<std::uint32_t>(channels_.size()));
+    if (inserted)
+        channels_.push_back(Channel{channel, {}});
+    Channel& state = channels_[it->second];
+    state.floor = std::max(state.floor, first_line);
+}
+
+std::size_t SearchIndex::document_count() const
+{
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    return documents_.size();
+}
+
+/**
+ * @details 배치가 다 차기 전이라도 `flush_interval_`마다, 또는 `flush` 요청이 있으면 바로 반영합니다.
+ *          종료 시에는 남은 문서를 모두 반영하고 끝냅니다.
+ */
+void SearchIndex::run()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while (true) {
+        queue_cv_.wait_for(lock, flush_interval_, [this]() {
+            return stopping_ || flush_requested_ || queue_.size() >= batch_size_;
+        });
+        flush_requested_ = false;
+        if (queue_.empty()) {
+            if (stopping_)
+                break;
+            continue;
+        }
+        std::size_t count = std::min(queue_.size(), batch_size_);
+        std::vector<Pending> batch;
+        batch.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        lock.unlock();
+        apply(batch);
+        lock.lock();
+        applied_ += batch.size();
+        applied_cv_.notify_all();
+    }
+    applied_cv_.notify_all();
+}
+
+/**
+ * @details 토큰화는 잠금 밖에서 하고, 포스팅에 붙이는 동안만 쓰기 잠금을 잡습니다.
+ *          문서 번호는 반영 순서대로 늘어나므로 포스팅 끝에 차이만 붙이면 됩니다.
+ */
+void SearchIndex::apply(std::vector<Pending>& batch)
+{
+    std::vector<std::map<std::string, std::uint32_t>> frequencies(batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        for (auto& token : tokenize(batch[i].text))
+            ++frequencies[i][std::move(token)];
+    }
+
+    std::unique_lock<std::shared_mutex> lock(index_mutex_);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        auto [channel_it, inserted] = channel_ids_.try_emplace(batch[i].channel, static_cast<std::uint32_t>(channels_.size()));
+        if (inserted)
+            channels_.push_back(Channel{batch[i].channel, std::move(batch[i].participants)});
+        else if (channels_[channel_it->second].participants.empty())
+            channels_[channel_it->second].participants = std::move(batch[i].participants); // `set_floor`가 먼저 만든 채널
+        auto doc = static_cast<std::uint32_t>(documents_.size());
+        documents_.push_back(Document{channel_it->second, static_cast<std::uint32_t>(batch[i].time), batch[i].line});
+        for (const auto& [token, tf] : frequencies[i]) {
+            Postings& postings = terms_[token];
+            put_varint(postings.bytes, postings.count == 0 ? doc : doc - postings.last_doc);
+            put_varint(postings.bytes, tf);
+            postings.last_doc = doc;
+            ++postings.count;
+        }
+    }
+}
+
+void SearchIndex::collect(const Postings& postings, std::unordered_map<std::uint32_t, std::uint32_t>& out) const
+{
+    std::size_t pos = 0;
+    std::uint32_t doc = 0;
+    for (std::uint32_t i = 0; i < postings.count; ++i) {
+        doc += static_cast<std::uint32_t>(get_varint(postings.bytes, pos));
+        out[doc] += static_cast<std::uint32_t>(get_varint(postings.bytes, pos));
+    }
+}
+
+/**
+ * @details 문서 빈도가 가장 낮은 토큰부터 교집합을 구해 후보를 빨리 줄입니다.
+ *          점수는 tf·idf의 합이며, 같은 점수면 나중에 기록된 문서가 먼저입니다.
+ *          채널의 `floor`보다 앞의 문서는 히스토리에서 정리되었으므로 `total`에도 넣지 않습니다.
+ */
+SearchIndex::Page SearchIndex::search(const std::string& query, const Filter& filter, std::size_t offset, std::size_t limit) const
+{
+    Page page;
+    std::vector<std::string> tokens = tokenize(query);
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    if (tokens.empty())
+        return page;
+
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    double total_docs = static_cast<double>(documents_.size());
+
+    struct TermDocs {
+        std::unordered_map<std::uint32_t, std::uint32_t> tf;  ///< 문서 -> 빈도
+        double idf = 0;
+    };
+    std::vector<TermDocs> terms;
+    for (const auto& token : tokens) {
+        TermDocs term;
+        if (is_single_syllable(token)) {
+            for (auto it = terms_.lower_bound(token); it != terms_.end() && it->first.compare(0, token.size(), token) == 0; ++it)
+                collect(it->second, term.tf);
+        } else if (auto it = terms_.find(token); it != terms_.end()) {
+            collect(it->second, term.tf);
+        }
+        if (term.tf.empty())
+            return page;
+        term.idf = std::log(1.0 + total_docs / static_cast<double>(term.tf.size()));
+        terms.push_back(std::move(term));
+    }
+    std::sort(terms.begin(), terms.end(), [](const TermDocs& a, const TermDocs& b) { return a.tf.size() < b.tf.size(); });
+
+    std::vector<std::pair<double, std::uint32_t>> ranked;
+    for (const auto& [doc, tf] : terms.front().tf) {
+        double score = tf * terms.front().idf;
+        bool matched = true;
+        for (std::size_t i = 1; i < terms.size() && matched; ++i) {
+            auto it = terms[i].tf.find(doc);
+            matched = it != terms[i].tf.end();
+            if (matched)
+                score += it->second * terms[i].idf;
+        }
+        if (!matched)
+            continue;
+        const Document& document = documents_[doc];
+        const Channel& channel = channels_[document.channel];
+        if (document.line < channel.floor)
+            continue;
+        if (filter && !filter(channel.key, channel.participants, document.time))
+            continue;
+        ranked.emplace_back(score, doc);
+    }
+    page.total = ranked.size();
+    if (offset >= ranked.size())
+        return page;
+
+    std::size_t end = std::min(ranked.size(), offset + limit);
+    auto better = [](const auto& a, const auto& b) { return a.first != b.first ? a.first > b.first : a.second > b.second; };
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(end), ranked.end(), better);
+    for (std::size_t i = offset; i < end; ++i) {
+        const Document& doc = documents_[ranked[i].second];
+        const Channel& channel = channels_[doc.channel];
+        page.hits.push_back(Hit{channel.key, doc.line, ranked[i].first, channel.participants});
+    }
+    return page;
+}
+
+/**
+ * @details 한글 음절이 이어진 구간은 2-gram(한 음절뿐이면 그 음절)으로, 영숫자와 그 밖의 문자는 단어 단위로 나눕니다.
+ *          영문은 소문자로 바꿉니다. 예: "CherryRecorder 위치저장했어요" -> cherryrecorder, 위치, 치저, 저장, 장했, 했어, 어요
+ */
+std::vector<std::string> SearchIndex::tokenize(const std::string& text)
+{
+    std::vector<std::string> tokens;
+    std::string word;
+    std::vector<std::string> syllables;
+
+    auto end_word = [&]() {
+        if (!word.empty())
+            tokens.push_back(std::move(word));
+        word.clear();
+    };
+    auto end_hangul = [&]() {
+        if (syllables.size() == 1)
+            tokens.push_back(syllables.front());
+        for (std::size_t i = 0; i + 1 < syllables.size(); ++i)
+            tokens.push_back(syllables[i] + syllables[i + 1]);
+        syllables.clear();
+    };
+
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t length = 1;
+        char32_t cp = next_code_point(text, pos, length);
+        if (is_hangul(cp)) {
+            end_word();
+            syllables.push_back(text.substr(pos, length));
+        } else if (is_word(cp)) {
+            end_hangul();
+            if (cp < 0x80)
+                word.push_back(static_cast<char>(cp >= 'A' && cp <= 'Z' ? cp - 'A' + 'a' : cp));
+            else
+                word.append(text, pos, length);
+        } else {
+            end_word();
+            end_hangul();
+        }
+        pos += length;
+    }
+    end_word();
+    end_hangul();
+    return tokens;
+}
@@ -0,0 +1,716 @@
+/**
+ * @file UserStore.cpp
+ * @brief `UserAccount`와 `UserStore` 클래스의 구현부입니다.
+ */
+
+#include "UserStore.hpp"
+#include "spdlog/spdlog.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char snapshot_magic[8] = {'C', 'R', 'U', 'S', 'E', 'R', 'S', '1'};
+    /// 스냅샷 머리 크기 (magic + u64 계정 수 + u64 버킷 수)
+    constexpr std::size_t snapshot_header_size = 24;
+    /// 레코드 머리 크기 (u16 길이 4개 + u8 플래그)
+    constexpr std::size_t record_header_size = 9;
+    /// 로그 항목 머리 크기 (u32 길이)
+    constexpr std::size_t log_header_size = 4;
+    constexpr std::uint8_t flag_admin = 0x01;
+    /// 문자열 뒤에 닉네임을 묶은 시각 (u64)이 붙음
+    constexpr std::uint8_t flag_bound = 0x02;
+    constexpr char log_put = 1;
+    constexpr char log_remove = 2;
+
+    void put_le(std::string& out, std::uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    std::uint64_t get_le(const char* in, int bytes)
+    {
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+        return value;
+    }
+
+    /// 파일에 저장하므로 실행마다 같은 값을 내는 해시 (FNV-1a)
+    std::uint64_t name_hash(std::string_view name)
+    {
+        std::uint64_t hash = 1469598103934665603ull;
+        for (unsigned char c : name) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// 스냅샷/로그 안의 레코드 하나 (원본 버퍼를 가리킴)
+    struct RecordView {
+        std::string_view name;
+        std::string_view password_hash;
+        std::string_view last_ip;
+        std::string_view last_login;
+        std::uint64_t bound_at = 0;
+        std::uint8_t flags = 0;
+        std::size_t size = 0;
+    };
+
+    bool parse_record(const char* p, const char* end, RecordView& out)
+    {
+        if (p > end || static_cast<std::size_t>(end - p) < record_header_size)
+            return false;
+        std::size_t lengths[4];
+        std::size_t total = record_header_size;
+        for (int i = 0; i < 4; ++i) {
+            lengths[i] = static_cast<std::size_t>(get_le(p + 2 * i, 2));
+            total += lengths[i];
+        }
+        out.flags = static_cast<std::uint8_t>(p[8]);
+        if (out.flags & flag_bound)
+            total += 8;
+        if (static_cast<std::size_t>(end - p) < total)
+            return false;
+        const char* field = p + record_header_size;
+        std::string_view* targets[4] = {&out.name, &out.password_hash, &out.last_ip, &out.last_login};
+        for (int i = 0; i < 4; ++i) {
+            *targets[i] = std::string_view(field, lengths[i]);
+            field += lengths[i];
+        }
+        out.bound_at = (out.flags & flag_bound) ? get_le(field, 8) : 0;
+        out.size = total;
+        return true;
+    }
+
+    bool encode_record(std::string& out, const UserAccount& account)
+    {
+        const std::string* fields[4] = {&account.username(), &account.password_hash(), &account.last_ip(), &account.last_login()};
+        for (const auto* field : fields) {
+            if (field->size() > 0xFFFF)
+                return false;
+            put_le(out, field->size(), 2);
+        }
+        std::uint8_t flags = (account.is_admin() ? flag_admin : 0) | (account.bound_at() != 0 ? flag_bound : 0);
+        out.push_back(static_cast<char>(flags));
+        for (const auto* field : fields)
+            out.append(*field);
+        if (account.bound_at() != 0)
+            put_le(out, account.bound_at(), 8);
+        return true;
+    }
+
+    std::shared_ptr<const UserAccount> to_account(const RecordView& record)
+    {
+        auto account = std::make_shared<UserAccount>(std::string(record.name), std::string(record.password_hash),
+                                                     (record.flags & flag_admin) != 0);
+        account->update_login_info(std::string(record.last_ip), std::string(record.last_login));
+        account->bind_nickname(record.bound_at);
+        return account;
+    }
+
+    /**
+     * @brief 레코드 목록으로 스냅샷 바이트를 만들어 `write`에 순서대로 넘깁니다.
+     * @param records 이름과 인코딩된 레코드 (이름은 서로 다름).
+     */
+    template <typename Write>
+    bool emit_snapshot(const std::vector<std::pair<std::string_view, std::string_view>>& records, Write&& write)
+    {
+        std::uint64_t buckets = 16;
+        while (buckets < records.size() * 2)
+            buckets <<= 1;
+        const std::uint64_t mask = buckets - 1;
+
+        std::vector<std::uint64_t> table(buckets, 0);
+        std::uint64_t offset = snapshot_header_size + buckets * 8;
+        for (const auto& [name, record] : records) {
+            std::uint64_t slot = name_hash(name) & mask;
+            while (table[slot] != 0)
+                slot = (slot + 1) & mask;
+            table[slot] = offset;
+            offset += record.size();
+        }
+
+        std::string head(snapshot_magic, sizeof(snapshot_magic));
+        put_le(head, records.size(), 8);
+        put_le(head, buckets, 8);
+        std::string encoded;
+        encoded.reserve(table.size() * 8);
+        for (auto entry : table)
+            put_le(encoded, entry, 8);
+        if (!write(head.data(), head.size()) || !write(encoded.data(), encoded.size()))
+            return false;
+        for (const auto& entry : records) {
+            if (!write(entry.second.data(), entry.second.size()))
+                return false;
+        }
+        return true;
+    }
+
+    /// `fd`에 `data`를 모두 씁니다.
+    bool write_all(int fd, const char* data, std::size_t size)
+    {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    std::string log_entry(char kind, const std::string& record)
+    {
+        std::string entry;
+        put_le(entry, record.size() + 1, 4);
+        entry.push_back(kind);
+        entry.append(record);
+        return entry;
+    }
+}
+
+UserAccount::UserAccount(const std::string &username, const std::string &password_hash, bool is_admin)
+    : username_(username), password_hash_(password_hash), is_admin_(is_admin) {}
+
+bool UserAccount::check_password(const std::string &ph) const
+{
+    return password_hash_ == ph;
+}
+
+void UserAccount::set_password(const std::string &nph)
+{
+    password_hash_ = nph;
+}
+
+void UserAccount::set_admin(bool ia)
+{
+    is_admin_ = ia;
+}
+
+void UserAccount::update_login_info(const std::string &ip, const std::string &time)
+{
+    last_ip_ = ip;
+    last_login_ = time;
+}
+
+void UserAccount::bind_nickname(std::uint64_t time)
+{
+    bound_at_ = time;
+}
+
+/**
+ * @brief 매핑한 스냅샷 파일 (메모리 전용이면 `owned`에 담은 바이트).
+ */
+struct UserStore::Snapshot {
+    const char* data = nullptr;
+    std::size_t size = 0;
+    std::uint64_t count = 0;
+    std::uint64_t buckets = 0;
+    std::string owned;
+    void* mapping = nullptr;
+
+    Snapshot() = default;
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+    ~Snapshot()
+    {
+        if (mapping)
+            ::munmap(mapping, size);
+    }
+
+    /// `data`/`size`의 머리를 확인하고 `count`, `buckets`를 채웁니다.
+    bool parse_header()
+    {
+        if (size < snapshot_header_size || std::memcmp(data, snapshot_magic, sizeof(snapshot_magic)) != 0)
+            return false;
+        count = get_le(data + 8, 8);
+        buckets = get_le(data + 16, 8);
+        return buckets != 0 && (buckets & (buckets - 1)) == 0 &&
+               buckets <= (size - snapshot_header_size) / 8 && count <= buckets;
+    }
+
+    /// 첫 레코드 위치
+    const char* records() const { return data + snapshot_header_size + buckets * 8; }
+
+    /// 이름이 같은 레코드를 찾습니다.
+    bool find(std::string_view name, RecordView& out) const
+    {
+        if (buckets == 0)
+            return false;
+        const std::uint64_t mask = buckets - 1;
+        const char* table = data + snapshot_header_size;
+        std::uint64_t slot = name_hash(name) & mask;
+        for (std::uint64_t probe = 0; probe < buckets; ++probe, slot = (slot + 1) & mask) {
+            std::uint64_t offset = get_le(table + slot * 8, 8);
+            if (offset == 0 || offset >= size || !parse_record(data + offset, data + size, out))
+                return false;
+            if (out.name == name)
+                return true;
+        }
+        return false;
+    }
+
+    /// 스냅샷 파일을 읽기 전용으로 매핑합니다. 파일이 없으면 빈 스냅샷, 손상되었으면 nullptr.
+    static std::shared_ptr<Snapshot> map(const std::string& path)
+    {
+        auto snapshot = std::make_shared<Snapshot>();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return errno == ENOENT ? snapshot : nullptr;
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* mapping = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            return nullptr;
+        snapshot->mapping = mapping;
+        snapshot->data = static_cast<const char*>(mapping);
+        snapshot->size = static_cast<std::size_t>(st.st_size);
+        if (!snapshot->parse_header())
+            return nullptr;
+        return snapshot;
+    }
+};
+
+UserStore::UserStore(std::string path, std::size_t compact_after, std::chrono::milliseconds compact_interval)
+    : path_(std::move(path)),
+      compact_after_(compact_after == 0 ? 1 : compact_after),
+      compact_interval_(compact_interval)
+{
+    try {
+        open_ = load();
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Failed to open user store '{}': {}", path_, e.what());
+        open_ = false;
+    }
+    if (!open_) {
+        state_.store(std::make_shared<const State>(State{std::make_shared<const Snapshot>(), {}, 0}));
+        return;
+    }
+    compact_thread_ = std::thread(&UserStore::compaction_loop, this);
+}
+
+UserStore::~UserStore()
+{
+    close();
+}
+
+/**
+ * @details 진행 중인 합치기와 변경이 끝난 뒤 닫는다. 잠금 파일을 닫으면 `flock`이 풀려 다른 프로세스가 열 수 있다.
+ */
+void UserStore::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+        stop_compaction_ = true;
+    }
+    compact_cv_.notify_all();
+    if (compact_thread_.joinable())
+        compact_thread_.join();
+    std::lock_guard<std::mutex> run_lock(compact_run_mutex_);
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    open_ = false;
+    if (log_fd_ >= 0) {
+        ::close(log_fd_);
+        log_fd_ = -1;
+    }
+    if (lock_fd_ >= 0) {
+        ::close(lock_fd_);
+        lock_fd_ = -1;
+    }
+}
+
+/**
+ * @details 잠금을 먼저 잡아, 다른 프로세스가 쓰는 중인 스냅샷과 로그는 읽지도 않는다.
+ *          스냅샷은 매핑만 하고, 로그만 읽어 변경분 맵을 만든다.
+ */
+bool UserStore::load()
+{
+    if (path_.empty()) {
+        state_.store(std::make_shared<const State>(State{std::make_shared<const Snapshot>(), {}, 0}));
+        return true;
+    }
+    fs::path parent = fs::path(path_).parent_path();
+    if (!parent.empty())
+        fs::create_directories(parent);
+
+    lock_fd_ = ::open((path_ + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lock_fd_ < 0 || ::flock(lock_fd_, LOCK_EX | LOCK_NB) != 0) {
+        spdlog::error("User store '{}' is in use by another process ({}). Refusing to open it.", path_, std::strerror(errno));
+        return false;
+    }
+
+    auto snapshot = Snapshot::map(path_ + ".snapshot");
+    if (!snapshot) {
+        spdlog::error("User store snapshot '{}.snapshot' is corrupt. Refusing to modify accounts.", path_);
+        return false;
+    }
+    state_.store(std::make_shared<const State>(State{snapshot, {}, static_cast<std::size_t>(snapshot->count)}));
+    if (!replay_log())
+        return false;
+
+    log_fd_ = ::open((path_ + ".log").c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (log_fd_ < 0) {
+        spdlog::error("Failed to open user store log '{}.log': {}", path_, std::strerror(errno));
+        return false;
+    }
+    auto state = state_.load();
+    spdlog::info("User store '{}' loaded: {} accounts ({} pending changes)", path_, state->count, state->overlay.size());
+    return true;
+}
+
+/**
+ * @details 로그 크기는 합치기 주기로 제한되므로 통째로 읽는다. 잘린 마지막 항목은 파일에서도 잘라 낸다.
+ */
+bool UserStore::replay_log()
+{
+    const std::string log_path = path_ + ".log";
+    std::ifstream in(log_path, std::ios::binary);
+    if (!in)
+        return true;
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    auto state = std::make_shared<State>(*state_.load());
+    std::size_t pos = 0;
+    std::size_t applied = 0;
+    while (data.size() - pos >= log_header_size) {
+        auto length = static_cast<std::size_t>(get_le(data.data() + pos, 4));
+        if (length == 0 || data.size() - pos - log_header_size < length)
+            break;
+        const char* body = data.data() + pos + log_header_size;
+        RecordView record;
+        if (!parse_record(body + 1, body + length, record) || record.size != length - 1 ||
+            (body[0] != log_put && body[0] != log_remove))
+            break;
+
+        std::string name(record.name);
+        auto it = state->overlay.find(name);
+        RecordView existing;
+        bool existed = it != state->overlay.end() ? it->second != nullptr : state->snapshot->find(name, existing);
+        if (body[0] == log_put) {
+            state->overlay[name] = to_account(record);
+            if (!existed)
+                ++state->count;
+        } else {
+            state->overlay[name] = nullptr;
+            if (existed)
+                --state->count;
+        }
+        pos += log_header_size + length;
+        ++applied;
+    }
+    if (pos != data.size()) {
+        spdlog::warn("User store log '{}' has a truncated tail ({} bytes). Dropping it.", log_path, data.size() - pos);
+        std::error_code ec;
+        fs::resize_file(log_path, pos, ec);
+        if (ec) {
+            spdlog::error("Failed to truncate user store log '{}': {}", log_path, ec.message());
+            return false;
+        }
+    }
+    state_.store(std::shared_ptr<const State>(std::move(state)));
+    return true;
+}
+
+std::shared_ptr<const UserAccount> UserStore::find(std::string_view username) const
+{
+    auto state = state_.load();
+    if (!state->overlay.empty()) {
+        auto it = state->overlay.find(std::string(username));
+        if (it != state->overlay.end())
+            return it->second;
+    }
+    RecordView record;
+    if (!state->snapshot->find(username, record))
+        return nullptr;
+    return to_account(record);
+}
+
+bool UserStore::contains(std::string_view username) const
+{
+    auto state = state_.load();
+    if (!state->overlay.empty()) {
+        auto it = state->overlay.find(std::string(username));
+        if (it != state->overlay.end())
+            return it->second != nullptr;
+    }
+    RecordView record;
+    return state->snapshot->find(username, record);
+}
+
+std::size_t UserStore::size() const
+{
+    return state_.load()->count;
+}
+
+std::size_t UserStore::pending_changes() const
+{
+    return state_.load()->overlay.size();
+}
+
+bool UserStore::put(const UserAccount& account)
+{
+    return store(account, true);
+}
+
+bool UserStore::insert(const UserAccount& account)
+{
+    return store(account, false);
+}
+
+/**
+ * @details 읽는 쪽이 들고 있는 상태를 바꾸지 않도록 변경분 맵을 통째로 복사해 새 상태를 만든다.
+ *          복사는 `write_mutex_` 안에서 하므로 변경끼리는 변경분 크기만큼 서로 기다린다.
+ */
+bool UserStore::store(const UserAccount& account, bool overwrite)
+{
+    std::size_t pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        bool existed = contains(account.username());
+        if (!open_ || account.username().empty() || (existed && !overwrite) || !append_log(log_put, account))
+            return false;
+        auto next = std::make_shared<State>(*state_.load());
+        next->overlay[account.username()] = std::make_shared<const UserAccount>(account);
+        if (!existed)
+            ++next->count;
+        pending = next->overlay.size();
+        state_.store(std::shared_ptr<const State>(std::move(next)));
+    }
+    if (pending >= compact_after_) {
+        { std::lock_guard<std::mutex> lock(compact_mutex_); }
+        compact_cv_.notify_all();
+    }
+    return true;
+}
+
+bool UserStore::remove(const std::string& username)
+{
+    std::size_t pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (!open_ || !contains(username) || !append_log(log_remove, UserAccount(username, "")))
+            return false;
+        auto next = std::make_shared<State>(*state_.load());
+        next->overlay[username] = nullptr;
+        --next->count;
+        pending = next->overlay.size();
+        state_.store(std::shared_ptr<const State>(std::move(next)));
+    }
+    if (pending >= compact_after_) {
+        { std::lock_guard<std::mutex> lock(compact_mutex_); }
+        compact_cv_.notify_all();
+    }
+    return true;
+}
+
+/**
+ * @details 계정 변경은 드물고 잃으면 안 되므로 항목마다 fdatasync한다. 실패하면 쓰다 만 부분을 잘라 낸다.
+ */
+bool UserStore::append_log(char kind, const UserAccount& account)
+{
+    if (path_.empty())
+        return true;
+    std::string record;
+    if (!encode_record(record, account)) {
+        spdlog::warn("User store: account field too long for '{}'", account.username());
+        return false;
+    }
+    std::string entry = log_entry(kind, record);
+    off_t before = ::lseek(log_fd_, 0, SEEK_END);
+    if (!write_all(log_fd_, entry.data(), entry.size()) || ::fdatasync(log_fd_) != 0) {
+        spdlog::error("Failed to append to user store log '{}.log': {}", path_, std::strerror(errno));
+        if (before >= 0 && ::ftruncate(log_fd_, before) != 0)
+            spdlog::error("Failed to roll back user store log '{}.log'", path_);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @details 아직 합치지 않은 변경만 담은 새 로그를 만들어 기존 로그와 바꾼다.
+ *          실패하면 기존 로그를 그대로 쓴다. (로그 항목은 계정 전체를 덮어쓰므로 새 스냅샷 위에 다시 재생해도 같은 결과)
+ */
+bool UserStore::reopen_log(const Overlay& overlay)
+{
+    if (path_.empty())
+        return true;
+    const std::string log_path = path_ + ".log";
+    const std::string tmp_path = log_path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return false;
+    bool ok = true;
+    for (const auto& [name, account] : overlay) {
+        std::string record;
+        if (!encode_record(record, account ? *account : UserAccount(name, ""))) {
+            ok = false;
+            break;
+        }
+        std::string entry = log_entry(account ? log_put : log_remove, record);
+        if (!(ok = write_all(fd, entry.data(), entry.size())))
+            break;
+    }
+    ok = ok && ::fsync(fd) == 0;
+    if (!ok || std::rename(tmp_path.c_str(), log_path.c_str()) != 0) {
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    ::close(log_fd_);
+    ::close(fd);
+    log_fd_ = ::open(log_path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    return log_fd_ >= 0;
+}
+
+/**
+ * @details 시작 시점의 상태로 새 스냅샷을 잠금 밖에서 만들고, 그사이 바뀐 계정만 변경분으로 남긴다.
+ *          (변경분 항목은 바뀔 때마다 새 객체이므로 포인터가 같으면 스냅샷에 들어간 것)
+ *          스냅샷 파일을 바꾼 뒤 로그를 바꾸기 전에 멈추면, 다음 시작 때 이전 로그를 새 스냅샷 위에 다시 재생한다.
+ */
+bool UserStore::compact()
+{
+    std::lock_guard<std::mutex> run_lock(compact_run_mutex_);
+    if (!open_)
+        return false;
+    auto base = state_.load();
+    if (base->overlay.empty())
+        return true;
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<std::string_view, std::string_view>> records;
+    records.reserve(base->count);
+    const char* end = base->snapshot->data + base->snapshot->size;
+    for (const char* p = base->snapshot->buckets ? base->snapshot->records() : end; p < end;) {
+        RecordView record;
+        if (!parse_record(p, end, record))
+            break;
+        if (base->overlay.find(std::string(record.name)) == base->overlay.end())
+            records.emplace_back(record.name, std::string_view(p, record.size));
+        p += record.size;
+    }
+    std::vector<std::string> encoded;
+    encoded.reserve(base->overlay.size());
+    for (const auto& [name, account] : base->overlay) {
+        if (!account)
+            continue;
+        encoded.emplace_back();
+        encode_record(encoded.back(), *account);
+    }
+    for (const auto& record : encoded) {
+        RecordView view;
+        parse_record(record.data(), record.data() + record.size(), view);
+        records.emplace_back(view.name, record);
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    if (path_.empty()) {
+        snapshot->owned.reserve(snapshot_header_size + records.size() * 64);
+        emit_snapshot(records, [&](const char* data, std::size_t size) {
+            snapshot->owned.append(data, size);
+            return true;
+        });
+        snapshot->data = snapshot->owned.data();
+        snapshot->size = snapshot->owned.size();
+        snapshot->parse_header();
+    } else {
+        const std::string snapshot_path = path_ + ".snapshot";
+        const std::string tmp_path = snapshot_path + ".tmp";
+        std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+        if (!file) {
+            spdlog::error("Failed to create user store snapshot '{}': {}", tmp_path, std::strerror(errno));
+            return false;
+        }
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        bool ok = emit_snapshot(records, [&](const char* data, std::size_t size) {
+            return std::fwrite(data, 1, size, file) == size;
+        });
+        ok = std::fflush(file) == 0 && ok && ::fsync(::fileno(file)) == 0;
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok || std::rename(tmp_path.c_str(), snapshot_path.c_str()) != 0) {
+            spdlog::error("Failed to write user store snapshot '{}': {}", snapshot_path, std::strerror(errno));
+            ::unlink(tmp_path.c_str());
+            return false;
+        }
+        snapshot = Snapshot::map(snapshot_path);
+        if (!snapshot) {
+            spdlog::error("Failed to map new user store snapshot '{}'", snapshot_path);
+            return false;
+        }
+    }
+
+    std::size_t merged = 0;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto current = state_.load();
+        auto next = std::make_shared<State>();
+        next->snapshot = snapshot;
+        next->count = current->count;
+        for (const auto& [name, account] : current->overlay) {
+            auto it = base->overlay.find(name);
+            if (it == base->overlay.end() || it->second != account)
+                next->overlay.emplace(name, account);
+        }
+        if (!reopen_log(next->overlay)) {
+            spdlog::warn("Failed to rewrite user store log '{}.log'. Keeping the previous log.", path_);
+            next->overlay = current->overlay;
+        }
+        merged = current->overlay.size() - next->overlay.size();
+        state_.store(std::shared_ptr<const State>(std::move(next)));
+    }
+    spdlog::info("User store '{}' compacted: {} accounts, {} changes merged in {}ms", path_, records.size(), merged,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+    return true;
+}
+
+/**
+ * @details 변경분이 `compact_after_`개에 이르거나 주기가 지나면 합친다.
+ */
+void UserStore::compaction_loop()
+{
+    std::unique_lock<std::mutex> lock(compact_mutex_);
+    while (!stop_compaction_) {
+        auto ready = [this]() { return stop_compaction_ || pending_changes() >= compact_after_; };
+        if (compact_interval_.count() > 0)
+            compact_cv_.wait_for(lock, compact_interval_, ready);
+        else
+            compact_cv_.wait(lock, ready);
+        if (stop_compaction_)
+            break;
+        if (pending_changes() == 0)
+            continue;
+        lock.unlock();
+        try {
+            compact();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("User store compaction failed: {}", e.what());
+        }
+        lock.lock();
+    }
+}
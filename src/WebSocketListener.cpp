@@ -14,6 +14,26 @@ WebSocketListener::WebSocketListener(net::io_context& ioc,
     init_acceptor(endpoint);
 }
 
+// 인계받은 리스닝 소켓용 생성자
+WebSocketListener::WebSocketListener(net::io_context& ioc,
+                                     const tcp& protocol,
+                                     tcp::acceptor::native_handle_type native_socket,
+                                     std::shared_ptr<ChatServer> server)
+    : ioc_(ioc)
+    , acceptor_(net::make_strand(ioc))
+    , server_(server)
+{
+    beast::error_code ec;
+    acceptor_.assign(protocol, native_socket, ec);
+    if (ec) {
+        spdlog::error("WebSocketListener: Error adopting inherited socket: {}", ec.message());
+        throw beast::system_error{ec};
+    }
+    auto endpoint = local_endpoint();
+    spdlog::info("WebSocketListener: Adopted inherited socket listening on {}:{}",
+                 endpoint.address().to_string(), endpoint.port());
+}
+
 
 void WebSocketListener::init_acceptor(tcp::endpoint endpoint)
 {
@@ -56,6 +76,15 @@ void WebSocketListener::run()
     do_accept();
 }
 
+void WebSocketListener::stop()
+{
+    // acceptor는 strand 위에서만 다루므로 닫기도 strand로 넘긴다.
+    net::post(acceptor_.get_executor(), [self = shared_from_this()]() {
+        beast::error_code ec;
+        self->acceptor_.close(ec);
+    });
+}
+
 void WebSocketListener::do_accept()
 {
     // Accept a new connection
@@ -68,6 +97,11 @@ void WebSocketListener::do_accept()
 
 void WebSocketListener::on_accept(beast::error_code ec, tcp::socket socket)
 {
+    // stop()으로 acceptor가 닫혔으면 accept 루프를 끝낸다.
+    if (ec == net::error::operation_aborted || !acceptor_.is_open()) {
+        return;
+    }
+
     if (ec) {
         spdlog::error("WebSocketListener: Accept failed: {}", ec.message());
     } else {
@@ -6,6 +6,7 @@
 #include "ChatServer.hpp"
 #include <spdlog/spdlog.h>
 #include <boost/beast/core/buffers_to_string.hpp>
+#include <charconv>
 
 /**
  * @details TCP 소켓의 소유권을 WebSocket 스트림으로 이동시키고,
@@ -50,7 +51,7 @@ void WebSocketSession::run()
 /**
  * @details 핸드셰이크 성공 시, WebSocket 타임아웃 등 옵션을 설정하고
  *          `ChatServer`에 세션을 등록(`join`)합니다.
- *          클라이언트에게 환영 메시지를 전송한 후, 첫 비동기 읽기(`do_read`)를 시작합니다.
+ *          클라이언트에게 환영 메시지와 재접속 토큰(`* RESUME_TOKEN <토큰>`)을 전송한 후, 첫 비동기 읽기(`do_read`)를 시작합니다.
  *          실패 시 에러 로그를 남기고 세션을 종료합니다.
  */
 void WebSocketSession::on_accept(beast::error_code ec)
@@ -87,6 +88,23 @@ void WebSocketSession::on_accept(beast::error_code ec)
     deliver("* /nick <닉네임> - 닉네임 변경\r\n");
     deliver("* /pm <닉네임> <메시지> - 개인 메시지\r\n");
     deliver("* /list - 접속자 목록\r\n");
+    deliver("* /join <방이름> - 방 입장 (여러 방에 동시에 참여 가능, 입장한 방이 활성 방)\r\n");
+    deliver("* /to <방이름> <메시지> - 활성 방을 바꾸지 않고 참여 중인 방에 메시지 전송\r\n");
+    deliver("* /rooms - 참여 중인 방 목록\r\n");
+    deliver("* /members <방이름> [페이지] - 방 멤버 목록 (페이지당 50명)\r\n");
+    deliver("* /typing [방이름], /active [방이름] - 입력 중/활동 중 표시 (기록되지 않음)\r\n");
+    deliver("* /sendfile <닉네임> <크기> <파일명>, /acceptfile <ID>, /rejectfile <ID> - 파일 전송 (조각은 바이너리 프레임)\r\n");
+    deliver("* /resume <토큰> - 연결이 끊긴 세션 복원\r\n");
+    deliver("* /register <사용자명> <비밀번호>, /login <사용자명> <비밀번호> - 계정 등록/로그인 (/login -t <사용자명> <토큰>으로 재로그인)\r\n");
+    deliver("* /since <방이름|*> <에포크>.<순번> - 해당 순번 이후 놓친 메시지 다시 받기\r\n");
+    deliver("* /search [-r <방이름>] [-p <페이지>] <검색어> - 채팅방/귓속말 기록 검색\r\n");
+
+    // 재접속 토큰 발급 (연결이 끊겨도 유예 기간 안에 /resume으로 닉네임, 방, 놓친 메시지를 복원)
+    if (server_) {
+        server_->issue_resume_token_async(shared_from_this(), [self = shared_from_this()](std::string token) {
+            self->deliver("* RESUME_TOKEN " + token + "\r\n");
+        });
+    }
 }
 
 /**
@@ -135,6 +153,14 @@ void WebSocketSession::on_read(beast::error_code ec, std::size_t bytes_transferr
     std::string message = beast::buffers_to_string(buffer_.data());
     buffer_.consume(buffer_.size());
     
+    // 파일 조각은 흐름 제어에 따라 서버가 다음 읽기 시점을 정한다
+    if (ws_.got_binary()) {
+        if (process_binary(std::make_shared<const std::string>(std::move(message)))) {
+            do_read();
+        }
+        return;
+    }
+
     // 메시지 처리
     process_message(message);
     
@@ -142,6 +168,30 @@ void WebSocketSession::on_read(beast::error_code ec, std::size_t bytes_transferr
     do_read();
 }
 
+/**
+ * @details 프레임 앞 `ChatServer::file_id_length` 바이트가 전송 ID입니다.
+ *          서버가 프레임을 받아들이면 수신자 큐에 여유가 생길 때 `do_read`를 다시 호출하고,
+ *          거부하면 에러를 알리고 바로 다음 메시지를 읽습니다.
+ */
+bool WebSocketSession::process_binary(std::shared_ptr<const std::string> frame)
+{
+    if (!server_ || frame->size() <= ChatServer::file_id_length) {
+        deliver("Error: 파일 조각은 전송 ID로 시작해야 합니다.\r\n");
+        return true;
+    }
+    std::string transfer_id = frame->substr(0, ChatServer::file_id_length);
+    auto self = std::enable_shared_from_this<WebSocketSession>::shared_from_this();
+    bool accepted = server_->process_file_data(transfer_id, std::move(frame), shared_from_this(),
+        [self]() {
+            net::post(self->ws_.get_executor(), [self]() { self->do_read(); });
+        });
+    if (!accepted) {
+        deliver("Error: 진행 중인 파일 전송이 아니거나 조각 크기가 올바르지 않습니다: " + transfer_id + "\r\n");
+        return true;
+    }
+    return false;
+}
+
 /**
  * @details 수신된 메시지를 파싱하여 명령어와 일반 메시지를 구분하여 처리합니다.
  *          - `/nick`, `/pm`, `/list`, `/join`, `/leave` 등 다양한 명령어를 처리합니다.
@@ -154,7 +204,12 @@ void WebSocketSession::process_message(const std::string& message)
         return;
     }
     
-    spdlog::info("[WebSocketSession {}] Received: {}", nickname_, message);
+    // 비밀번호/토큰이 로그에 남지 않도록 계정/세션 복원 명령은 명령어만 기록한다.
+    if (message.rfind("/login", 0) == 0 || message.rfind("/register", 0) == 0 || message.rfind("/resume", 0) == 0) {
+        spdlog::info("[WebSocketSession {}] Received: {} (credentials omitted)", nickname_, message.substr(0, message.find(' ')));
+    } else {
+        spdlog::info("[WebSocketSession {}] Received: {}", nickname_, message);
+    }
     
     // 명령어 처리
     if (message[0] == '/') {
@@ -189,13 +244,113 @@ void WebSocketSession::process_message(const std::string& message)
                                 }
                             }
                         } else {
-                            deliver("Error: 닉네임 '" + new_nick + "'은(는) 이미 사용 중입니다.\r\n");
+                            deliver("Error: 닉네임 '" + new_nick + "'은(는) 이미 사용 중이거나 로그인하지 않은 계정의 이름입니다.\r\n");
                         }
                     });
             } else {
                 deliver("Error: 사용법: /nick <닉네임>\r\n");
             }
         }
+        else if (command == "/resume") {
+            std::string token;
+            iss >> token;
+            if (!token.empty()) {
+                server_->resume_session_async(token, shared_from_this(),
+                    [self = shared_from_this()](bool success) {
+                        if (!success) {
+                            self->deliver("Error: 세션을 복원할 수 없습니다. 토큰이 만료되었거나 이미 닉네임을 설정했습니다.\r\n");
+                        }
+                    });
+            } else {
+                deliver("Error: 사용법: /resume <토큰>\r\n");
+            }
+        }
+        else if (command == "/register") {
+            std::string username;
+            std::string password;
+            if (iss >> username >> password) {
+                server_->register_user_async(username, password, shared_from_this(),
+                    [self = shared_from_this(), username](ChatServer::AuthStatus status) {
+                        if (status == ChatServer::AuthStatus::Ok) {
+                            self->deliver("* 계정 '" + username + "'이(가) 등록되었습니다. /login으로 로그인하세요.\r\n");
+                        } else if (status == ChatServer::AuthStatus::Busy) {
+                            self->deliver("Error: 요청이 많아 지금은 처리할 수 없습니다. 잠시 후 다시 시도하세요.\r\n");
+                        } else {
+                            self->deliver("Error: 계정을 등록할 수 없습니다. 이미 있는 사용자명이거나 다른 사용자가 쓰는 닉네임이거나 형식이 올바르지 않습니다.\r\n");
+                        }
+                    });
+            } else {
+                deliver("Error: 사용법: /register <사용자명> <비밀번호>\r\n");
+            }
+        }
+        else if (command == "/login") {
+            std::string username;
+            std::string secret;
+            bool with_token = false;
+            iss >> username;
+            if (username == "-t") {
+                with_token = true;
+                iss >> username;
+            }
+            if (iss >> secret) {
+                auto on_login = [self = shared_from_this(), username](ChatServer::AuthStatus status, std::string token) {
+                    if (status == ChatServer::AuthStatus::Ok) {
+                        self->deliver("* LOGIN_OK " + username + (token.empty() ? "" : " " + token) + "\r\n");
+                    } else if (status == ChatServer::AuthStatus::Busy) {
+                        self->deliver("Error: 요청이 많아 지금은 처리할 수 없습니다. 잠시 후 다시 시도하세요.\r\n");
+                    } else {
+                        self->deliver("Error: 사용자명 또는 비밀번호가 올바르지 않습니다.\r\n");
+                    }
+                };
+                if (with_token) {
+                    server_->authenticate_token_async(username, secret, shared_from_this(), on_login);
+                } else {
+                    server_->authenticate_user_async(username, secret, shared_from_this(), on_login);
+                }
+            } else {
+                deliver("Error: 사용법: /login <사용자명> <비밀번호> 또는 /login -t <사용자명> <토큰>\r\n");
+            }
+        }
+        else if (command == "/since") {
+            std::string channel;
+            std::string position;
+            std::uint64_t after_seq = 0;
+            bool parsed = false;
+            if (iss >> channel >> position) {
+                // `<에포크>.<순번>`. 에포크 없이 순번만 보내면 어느 실행의 순번인지 알 수 없으므로 처음부터 받는다.
+                std::size_t dot = position.rfind('.');
+                const char* first = position.data() + (dot == std::string::npos ? 0 : dot + 1);
+                const char* last = position.data() + position.size();
+                auto [end, ec] = std::from_chars(first, last, after_seq);
+                parsed = first != last && ec == std::errc() && end == last;
+                position.resize(dot == std::string::npos ? 0 : dot);
+            }
+            if (parsed) {
+                server_->replay_channel_async(channel, position, after_seq, shared_from_this());
+            } else {
+                deliver("Error: 사용법: /since <방이름|*> <에포크>.<순번>\r\n");
+            }
+        }
+        else if (command == "/search") {
+            std::string room_name;
+            std::size_t page = 1;
+            std::string token;
+            std::string query;
+            while (iss >> token) {
+                if (query.empty() && token == "-r" && iss >> room_name) {
+                    continue;
+                }
+                if (query.empty() && token == "-p" && iss >> page) {
+                    continue;
+                }
+                query += (query.empty() ? "" : " ") + token;
+            }
+            if (query.empty() || page == 0) {
+                deliver("Error: 사용법: /search [-r <방이름>] [-p <페이지>] <검색어>\r\n");
+            } else {
+                server_->search_history_async(query, room_name, page, shared_from_this());
+            }
+        }
         else if (command == "/pm") {
             std::string target_nick;
             iss >> target_nick;
@@ -235,6 +390,81 @@ void WebSocketSession::process_message(const std::string& message)
                 deliver("Error: 사용법: /join <방이름>\r\n");
             }
         }
+        else if (command == "/to") {
+            std::string room_name;
+            iss >> room_name;
+            std::string room_message;
+            std::getline(iss, room_message);
+            room_message.erase(0, room_message.find_first_not_of(" \t"));
+            if (room_name.empty() || room_message.empty()) {
+                deliver("Error: 사용법: /to <방이름> <메시지>\r\n");
+            } else if (!server_->is_in_room(room_name, shared_from_this())) {
+                deliver("Error: '" + room_name + "' 방에 참여하고 있지 않습니다.\r\n");
+            } else {
+                server_->broadcast_to_room(room_name, room_message, shared_from_this());
+            }
+        }
+        else if (command == "/rooms") {
+            std::string room_list = "* 참여 중인 방:\r\n";
+            for (const auto& room_name : server_->rooms_of(shared_from_this())) {
+                room_list += "  - " + room_name + (room_name == current_room_ ? " (활성)" : "") + "\r\n";
+            }
+            deliver(room_list);
+        }
+        else if (command == "/typing" || command == "/active") {
+            std::string room_name;
+            if (!(iss >> room_name)) {
+                room_name = current_room_;
+            }
+            if (room_name.empty()) {
+                deliver("Error: 사용법: " + command + " [방이름] (참여 중인 방이 없습니다)\r\n");
+            } else {
+                // 자주 보내는 이벤트이므로 성공 응답은 보내지 않는다.
+                server_->send_ephemeral_event(room_name, shared_from_this(), command.substr(1));
+            }
+        }
+        else if (command == "/sendfile") {
+            std::string receiver_nick;
+            std::size_t filesize = 0;
+            std::string filename;
+            iss >> receiver_nick >> filesize;
+            std::getline(iss, filename);
+            filename.erase(0, filename.find_first_not_of(" \t"));
+            if (receiver_nick.empty() || filesize == 0 || filename.empty()) {
+                deliver("Error: 사용법: /sendfile <닉네임> <크기> <파일명>\r\n");
+            } else {
+                std::string transfer_id = server_->init_file_transfer(filename, filesize, shared_from_this(), receiver_nick);
+                if (transfer_id.empty()) {
+                    deliver("Error: 파일 전송을 시작할 수 없습니다. 받는 사람이 이 서버에 없거나 크기가 올바르지 않습니다.\r\n");
+                } else {
+                    deliver("* FILE_PENDING " + transfer_id + "\r\n");
+                }
+            }
+        }
+        else if (command == "/acceptfile" || command == "/rejectfile") {
+            std::string transfer_id;
+            iss >> transfer_id;
+            bool ok = command == "/acceptfile"
+                ? server_->accept_file_transfer(transfer_id, shared_from_this())
+                : server_->reject_file_transfer(transfer_id, shared_from_this());
+            if (!ok) {
+                deliver("Error: 파일 전송을 찾을 수 없습니다: " + transfer_id + "\r\n");
+            }
+        }
+        else if (command == "/members") {
+            std::string room_name;
+            std::size_t page = 1;
+            iss >> room_name;
+            if (!(iss >> page)) {
+                page = 1;
+            }
+            std::string roster = room_name.empty() ? "" : server_->room_roster_page(room_name, page);
+            if (!roster.empty()) {
+                deliver(roster);
+            } else {
+                deliver("Error: 사용법: /members <방이름> [페이지] (존재하는 방과 페이지여야 합니다)\r\n");
+            }
+        }
         else if (command == "/leave") {
             std::string room_name;
             iss >> room_name;
@@ -281,13 +511,51 @@ void WebSocketSession::deliver(const std::string& msg)
             }
             
             bool write_in_progress = !write_msgs_.empty();
-            write_msgs_.push(std::make_shared<const std::string>(msg));
+            write_msgs_.push(OutgoingFrame{std::make_shared<const std::string>(msg), false, nullptr});
             if (!write_in_progress && !is_writing_) {
                 do_write();
             }
         });
 }
 
+/**
+ * @details 일반 메시지가 큐를 다 채우기 전에 일회성 이벤트부터 버려, 느린 클라이언트에서도 채팅 메시지가 밀리지 않게 합니다.
+ */
+void WebSocketSession::deliver_ephemeral(const std::string& msg)
+{
+    auto self = shared_from_this();
+    net::post(strand_,
+        [this, self, msg]() {
+            if (write_msgs_.size() >= ephemeral_queue_limit_) {
+                spdlog::trace("[WebSocketSession {}] Write queue backed up, dropping ephemeral event", remote_id_);
+                return;
+            }
+            bool write_in_progress = !write_msgs_.empty();
+            write_msgs_.push(OutgoingFrame{std::make_shared<const std::string>(msg), false, nullptr});
+            if (!write_in_progress && !is_writing_) {
+                do_write();
+            }
+        });
+}
+
+/**
+ * @details 같은 버퍼를 큐에 넣으므로 송신자에게서 받은 조각을 다시 복사하지 않습니다.
+ *          `on_sent`는 실제로 소켓에 쓴 뒤 `on_write`에서 호출됩니다.
+ */
+bool WebSocketSession::deliver_binary(std::shared_ptr<const std::string> frame, std::function<void()> on_sent)
+{
+    auto self = shared_from_this();
+    net::post(strand_,
+        [this, self, frame = std::move(frame), on_sent = std::move(on_sent)]() mutable {
+            bool write_in_progress = !write_msgs_.empty();
+            write_msgs_.push(OutgoingFrame{std::move(frame), true, std::move(on_sent)});
+            if (!write_in_progress && !is_writing_) {
+                do_write();
+            }
+        });
+    return true;
+}
+
 /**
  * @details `write_msgs_` 큐가 비어있거나 이미 다른 쓰기 작업이 진행 중이면 아무것도 하지 않습니다.
  *          `is_writing_` 플래그를 설정하고 `ws_.async_write`를 호출하여 큐의 첫 번째 메시지를 전송합니다.
@@ -299,8 +567,9 @@ void WebSocketSession::do_write()
     }
     
     is_writing_ = true;
+    ws_.binary(write_msgs_.front().binary);
     ws_.async_write(
-        net::buffer(*write_msgs_.front()),
+        net::buffer(*write_msgs_.front().data),
         beast::bind_front_handler(
             &WebSocketSession::on_write,
             std::enable_shared_from_this<WebSocketSession>::shared_from_this()));
@@ -325,11 +594,15 @@ void WebSocketSession::on_write(beast::error_code ec, std::size_t bytes_transfer
         return;
     }
     
+    auto on_sent = std::move(write_msgs_.front().on_sent);
     write_msgs_.pop();
     
     if (!write_msgs_.empty()) {
         do_write();
     }
+    if (on_sent) {
+        on_sent();
+    }
 }
 
 /**
@@ -0,0 +1,222 @@
+/**
+ * @file ClusterBus.cpp
+ * @brief `ClusterMessage` 직렬화, `ClusterBus` 공통 함수, `ClusterDeduplicator`, `InProcessBus` 구현부입니다.
+ */
+
+#include "cluster/ClusterBus.hpp"
+#include "spdlog/spdlog.h"
+
+#include <chrono>
+#include <vector>
+
+namespace {
+    // 부호 없는 정수를 LEB128 varint로 기록한다.
+    void put_varint(std::string& out, std::uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void put_string(std::string& out, const std::string& value)
+    {
+        put_varint(out, value.size());
+        out.append(value);
+    }
+
+    bool get_varint(std::string_view& in, std::uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            auto byte = static_cast<unsigned char>(in.front());
+            in.remove_prefix(1);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool get_string(std::string_view& in, std::string& value)
+    {
+        std::uint64_t length = 0;
+        if (!get_varint(in, length) || length > in.size()) {
+            return false;
+        }
+        value.assign(in.data(), static_cast<std::size_t>(length));
+        in.remove_prefix(static_cast<std::size_t>(length));
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// ClusterMessage
+//------------------------------------------------------------------------------
+/**
+ * @details 프레임 본문은 `[varint 개수]` 뒤에 각 메시지의
+ *          `[kind 1바이트][origin][target_node][varint msg_id][target][sender][payload]`가 이어지는 형태입니다.
+ *          문자열 필드는 모두 varint 길이 접두사를 가집니다.
+ */
+std::string ClusterMessage::encode_batch(const std::vector<ClusterMessage>& batch)
+{
+    std::string out;
+    std::size_t estimate = 8;
+    for (const auto& msg : batch) {
+        estimate += 16 + msg.origin_node.size() + msg.target_node.size() + msg.target.size() + msg.sender.size() + msg.payload.size();
+    }
+    out.reserve(estimate);
+
+    put_varint(out, batch.size());
+    for (const auto& msg : batch) {
+        out.push_back(static_cast<char>(msg.kind));
+        put_string(out, msg.origin_node);
+        put_string(out, msg.target_node);
+        put_varint(out, msg.msg_id);
+        put_string(out, msg.target);
+        put_string(out, msg.sender);
+        put_string(out, msg.payload);
+    }
+    return out;
+}
+
+bool ClusterMessage::decode_batch(std::string_view frame, std::vector<ClusterMessage>& out)
+{
+    std::uint64_t count = 0;
+    if (!get_varint(frame, count)) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (frame.empty()) {
+            return false;
+        }
+        ClusterMessage msg;
+        auto kind = static_cast<std::uint8_t>(frame.front());
+        frame.remove_prefix(1);
+        if (kind < static_cast<std::uint8_t>(Kind::Global) || kind > static_cast<std::uint8_t>(Kind::NickLocation)) {
+            return false;
+        }
+        msg.kind = static_cast<Kind>(kind);
+        if (!get_string(frame, msg.origin_node) ||
+            !get_string(frame, msg.target_node) ||
+            !get_varint(frame, msg.msg_id) ||
+            !get_string(frame, msg.target) ||
+            !get_string(frame, msg.sender) ||
+            !get_string(frame, msg.payload)) {
+            return false;
+        }
+        out.push_back(std::move(msg));
+    }
+    return frame.empty();
+}
+
+//------------------------------------------------------------------------------
+// ClusterBus
+//------------------------------------------------------------------------------
+std::uint64_t ClusterBus::initial_msg_id()
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+//------------------------------------------------------------------------------
+// ClusterDeduplicator
+//------------------------------------------------------------------------------
+/**
+ * @details 처음 보는 노드는 받은 ID 바로 아래를 하한으로 삼습니다.
+ *          하한 초과 ID는 집합에 기록하고, 연속된 ID가 채워지면 하한을 끌어올립니다.
+ *          집합이 `max_window_`를 넘으면 가장 작은 ID까지 하한을 당겨 메모리 사용을 제한합니다.
+ */
+bool ClusterDeduplicator::accept(const std::string& origin, std::uint64_t msg_id)
+{
+    auto [it, inserted] = windows_.try_emplace(origin);
+    Window& window = it->second;
+    if (inserted) {
+        window.floor = msg_id > 0 ? msg_id - 1 : 0;
+    }
+
+    if (msg_id <= window.floor || !window.above.insert(msg_id).second) {
+        return false;
+    }
+
+    while (!window.above.empty() && *window.above.begin() == window.floor + 1) {
+        window.floor = *window.above.begin();
+        window.above.erase(window.above.begin());
+    }
+    while (window.above.size() > max_window_) {
+        window.floor = *window.above.begin();
+        window.above.erase(window.above.begin());
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// InProcessBusHub / InProcessBus
+//------------------------------------------------------------------------------
+void InProcessBusHub::attach(const std::string& node_id, ClusterBus::Handler handler)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_[node_id] = std::move(handler);
+    spdlog::info("[InProcessBusHub] Node '{}' attached. Nodes: {}", node_id, nodes_.size());
+}
+
+void InProcessBusHub::detach(const std::string& node_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_.erase(node_id);
+}
+
+/**
+ * @details 핸들러 목록을 복사한 뒤 락 밖에서 호출하여, 핸들러 안에서 다시 발행하더라도
+ *          교착 상태가 생기지 않도록 합니다.
+ */
+void InProcessBusHub::dispatch(const ClusterMessage& msg)
+{
+    std::vector<ClusterBus::Handler> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!msg.target_node.empty()) {
+            auto it = nodes_.find(msg.target_node);
+            if (it != nodes_.end()) {
+                targets.push_back(it->second);
+            }
+        } else {
+            targets.reserve(nodes_.size());
+            for (const auto& [node_id, handler] : nodes_) {
+                if (node_id != msg.origin_node) {
+                    targets.push_back(handler);
+                }
+            }
+        }
+    }
+    for (const auto& handler : targets) {
+        handler(msg);
+    }
+}
+
+void InProcessBus::start(const std::string& node_id, Handler handler)
+{
+    node_id_ = node_id;
+    hub_->attach(node_id_, std::move(handler));
+}
+
+void InProcessBus::publish(ClusterMessage msg)
+{
+    if (node_id_.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    msg.origin_node = node_id_;
+    msg.msg_id = ++last_msg_id_;
+    hub_->dispatch(msg);
+}
+
+void InProcessBus::stop()
+{
+    if (!node_id_.empty()) {
+        hub_->detach(node_id_);
+        node_id_.clear();
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file HashRing.cpp
+ * @brief `HashRing` 클래스의 구현부입니다.
+ */
+
+#include "cluster/HashRing.hpp"
+
+std::uint64_t HashRing::hash(std::string_view data)
+{
+    std::uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    // FNV-1a는 비슷한 문자열("node-1#0", "node-1#1")의 상위 비트가 고르게 퍼지지 않으므로 한 번 더 섞는다.
+    h += 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+/**
+ * @details 가상 노드 `i`의 위치는 `hash("<node>#<i>")`입니다.
+ *          드물게 두 가상 노드의 해시가 충돌하면 먼저 자리를 차지한 노드가 유지됩니다.
+ */
+bool HashRing::add_node(const std::string& node)
+{
+    if (!nodes_.insert(node).second) {
+        return false;
+    }
+    for (std::size_t i = 0; i < virtual_nodes_; ++i) {
+        ring_.emplace(hash(node + "#" + std::to_string(i)), node);
+    }
+    return true;
+}
+
+bool HashRing::remove_node(const std::string& node)
+{
+    if (nodes_.erase(node) == 0) {
+        return false;
+    }
+    for (auto it = ring_.begin(); it != ring_.end();) {
+        if (it->second == node) {
+            it = ring_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+/**
+ * @details 키의 해시 이상인 첫 가상 노드를 찾고, 없으면 링의 처음으로 돌아갑니다.
+ */
+std::string HashRing::owner(std::string_view key) const
+{
+    if (ring_.empty()) {
+        return {};
+    }
+    auto it = ring_.lower_bound(hash(key));
+    if (it == ring_.end()) {
+        it = ring_.begin();
+    }
+    return it->second;
+}
@@ -0,0 +1,908 @@
+/**
+ * @file HistoryReplication.cpp
+ * @brief `HistoryReplicator`, `HistoryFollower`와 복제 프레임 직렬화의 구현부입니다.
+ */
+
+#include "cluster/HistoryReplication.hpp"
+#include "cluster/SocketBus.hpp"
+#include "spdlog/spdlog.h"
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+    constexpr std::size_t max_frame_size = 16 * 1024 * 1024; // 16MB 프레임 크기 제한
+
+    // 프레임 본문 첫 바이트: 프레임 종류
+    enum class FrameType : unsigned char {
+        Hello = 0,    ///< 리더 -> 팔로워: 리더 식별값 (접속 직후)
+        Records = 1,  ///< 리더 -> 팔로워: 순번을 붙인 기록 묶음
+        Ack = 2,      ///< 팔로워 -> 리더: 마지막으로 적용한 순번
+        Query = 3,    ///< 리더 -> 팔로워: 읽기 질의
+        Result = 4    ///< 팔로워 -> 리더: 질의 결과
+    };
+
+    // 부호 없는 정수를 LEB128 varint로 기록한다.
+    void put_varint(std::string& out, std::uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void put_string(std::string& out, const std::string& value)
+    {
+        put_varint(out, value.size());
+        out.append(value);
+    }
+
+    bool get_varint(std::string_view& in, std::uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            auto byte = static_cast<unsigned char>(in.front());
+            in.remove_prefix(1);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool get_string(std::string_view& in, std::string& value)
+    {
+        std::uint64_t length = 0;
+        if (!get_varint(in, length) || length > in.size()) {
+            return false;
+        }
+        value.assign(in.data(), static_cast<std::size_t>(length));
+        in.remove_prefix(static_cast<std::size_t>(length));
+        return true;
+    }
+
+    bool get_byte(std::string_view& in, std::uint8_t& value)
+    {
+        if (in.empty()) {
+            return false;
+        }
+        value = static_cast<std::uint8_t>(in.front());
+        in.remove_prefix(1);
+        return true;
+    }
+
+    // [길이 4바이트 big-endian][종류 1바이트][내용]
+    std::shared_ptr<const std::string> make_frame(FrameType type, const std::string& payload)
+    {
+        auto frame = std::make_shared<std::string>();
+        frame->reserve(payload.size() + 5);
+        auto length = static_cast<std::uint32_t>(payload.size() + 1);
+        frame->push_back(static_cast<char>((length >> 24) & 0xFF));
+        frame->push_back(static_cast<char>((length >> 16) & 0xFF));
+        frame->push_back(static_cast<char>((length >> 8) & 0xFF));
+        frame->push_back(static_cast<char>(length & 0xFF));
+        frame->push_back(static_cast<char>(type));
+        frame->append(payload);
+        return frame;
+    }
+
+    std::shared_ptr<const std::string> make_varint_frame(FrameType type, std::uint64_t value)
+    {
+        std::string payload;
+        put_varint(payload, value);
+        return make_frame(type, payload);
+    }
+
+    std::size_t read_frame_length(const std::array<unsigned char, 4>& header)
+    {
+        return (static_cast<std::size_t>(header[0]) << 24) |
+               (static_cast<std::size_t>(header[1]) << 16) |
+               (static_cast<std::size_t>(header[2]) << 8) |
+               static_cast<std::size_t>(header[3]);
+    }
+
+    // [varint 순번][kind 1바이트][room][sender][receiver][line]
+    void put_record(std::string& out, std::uint64_t seq, const HistoryRecord& record)
+    {
+        put_varint(out, seq);
+        out.push_back(static_cast<char>(record.kind));
+        put_string(out, record.room);
+        put_string(out, record.sender);
+        put_string(out, record.receiver);
+        put_string(out, record.line);
+    }
+
+    bool get_record(std::string_view& in, std::uint64_t& seq, HistoryRecord& record)
+    {
+        std::uint8_t kind = 0;
+        if (!get_varint(in, seq) || !get_byte(in, kind) || kind > static_cast<std::uint8_t>(HistoryRecord::Kind::Private)) {
+            return false;
+        }
+        record.kind = static_cast<HistoryRecord::Kind>(kind);
+        return get_string(in, record.room) && get_string(in, record.sender) &&
+               get_string(in, record.receiver) && get_string(in, record.line);
+    }
+
+    // [varint ID][kind 1바이트][room][user1][user2][text][nickname][varint offset][varint limit][varint private_since]
+    std::string encode_query(std::uint64_t id, const HistoryQuery& query)
+    {
+        std::string out;
+        put_varint(out, id);
+        out.push_back(static_cast<char>(query.kind));
+        put_string(out, query.room);
+        put_string(out, query.user1);
+        put_string(out, query.user2);
+        put_string(out, query.text);
+        put_string(out, query.nickname);
+        put_varint(out, query.offset);
+        put_varint(out, query.limit);
+        put_varint(out, query.private_since);
+        return out;
+    }
+
+    bool decode_query(std::string_view in, std::uint64_t& id, HistoryQuery& query)
+    {
+        std::uint8_t kind = 0;
+        if (!get_varint(in, id) || !get_byte(in, kind) || kind > static_cast<std::uint8_t>(HistoryQuery::Kind::Search)) {
+            return false;
+        }
+        query.kind = static_cast<HistoryQuery::Kind>(kind);
+        return get_string(in, query.room) && get_string(in, query.user1) && get_string(in, query.user2) &&
+               get_string(in, query.text) && get_string(in, query.nickname) &&
+               get_varint(in, query.offset) && get_varint(in, query.limit) && get_varint(in, query.private_since);
+    }
+
+    // [varint ID][varint total][varint 줄 수][줄...]
+    std::string encode_result(std::uint64_t id, const HistoryQueryResult& result)
+    {
+        std::string out;
+        put_varint(out, id);
+        put_varint(out, result.total);
+        put_varint(out, result.lines.size());
+        for (const auto& line : result.lines) {
+            put_string(out, line);
+        }
+        return out;
+    }
+
+    bool decode_result(std::string_view in, std::uint64_t& id, HistoryQueryResult& result)
+    {
+        std::uint64_t count = 0;
+        if (!get_varint(in, id) || !get_varint(in, result.total) || !get_varint(in, count) || count > in.size()) {
+            return false;
+        }
+        result.lines.resize(static_cast<std::size_t>(count));
+        for (auto& line : result.lines) {
+            if (!get_string(in, line)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 방 이름은 파일 경로가 되므로 디렉터리를 벗어나는 이름은 질의하지 않는다.
+    bool safe_room_name(const std::string& room)
+    {
+        return room.find('/') == std::string::npos && room.find('\\') == std::string::npos && room != "..";
+    }
+}
+
+HistoryQueryResult run_history_query(MessageHistory& history, const HistoryQuery& query)
+{
+    HistoryQueryResult result;
+    const auto limit = static_cast<std::size_t>(query.limit);
+    switch (query.kind) {
+    case HistoryQuery::Kind::Global:
+        result.lines = history.load_global_history(limit);
+        break;
+    case HistoryQuery::Kind::Room:
+        result.lines = history.load_room_history(query.room, limit);
+        break;
+    case HistoryQuery::Kind::Private:
+        result.lines = history.load_private_history(query.user1, query.user2, limit);
+        break;
+    case HistoryQuery::Kind::Search: {
+        MessageHistory::SearchResult found =
+            history.search(query.text, query.nickname, query.room, static_cast<std::size_t>(query.offset), limit,
+                           query.private_since);
+        result.total = found.total;
+        result.lines = std::move(found.lines);
+        return result;
+    }
+    }
+    result.total = result.lines.size();
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// HistoryReplicator
+//------------------------------------------------------------------------------
+HistoryReplicator::HistoryReplicator(net::io_context& ioc,
+                                     std::string follower_uri,
+                                     std::chrono::milliseconds flush_interval,
+                                     std::size_t max_batch,
+                                     std::size_t max_unacked)
+    : strand_(net::make_strand(ioc)),
+      socket_(strand_),
+      flush_timer_(strand_),
+      reconnect_timer_(strand_),
+      follower_uri_(std::move(follower_uri)),
+      flush_interval_(flush_interval),
+      max_batch_(max_batch > 0 ? max_batch : 1),
+      max_unacked_(max_unacked > 0 ? max_unacked : 1),
+      epoch_(std::random_device{}() ^ static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()))
+{
+}
+
+HistoryReplicator::~HistoryReplicator()
+{
+    spdlog::info("[HistoryReplicator] Destroyed. Last seq {}, acked {}.", last_seq_.load(), acked_seq_.load());
+}
+
+void HistoryReplicator::start()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() {
+        self->stopped_ = false;
+        self->do_connect();
+    });
+}
+
+void HistoryReplicator::stop()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() {
+        if (self->stopped_) {
+            return;
+        }
+        self->flush();
+        self->stopped_ = true;
+        self->ready_ = false;
+        self->flush_timer_.cancel();
+        self->reconnect_timer_.cancel();
+        self->fail_queries();
+        // 이미 큐에 들어간 프레임이 없을 때만 바로 닫고, 있으면 마지막 쓰기 완료 후 닫는다.
+        if (!self->writing_) {
+            self->close_socket();
+        }
+    });
+}
+
+/**
+ * @details 순번은 strand에서 붙이므로 `MessageHistory`의 기록 잠금 안에서 호출하면 파일에 기록된 순서와 같습니다.
+ *          보관 한도를 넘으면 가장 오래된 기록을 버립니다. 이미 보낸 기록이면 팔로워에는 그대로 남고,
+ *          보내지 못한 기록이면 팔로워에 빠지게 되므로 경고합니다.
+ */
+void HistoryReplicator::publish(const HistoryRecord& record)
+{
+    net::post(strand_, [self = shared_from_this(), record]() mutable {
+        if (self->stopped_) {
+            return;
+        }
+        std::uint64_t seq = ++self->last_seq_;
+        self->unacked_.emplace_back(seq, std::move(record));
+        if (self->unacked_.size() > self->max_unacked_) {
+            std::uint64_t dropped_seq = self->unacked_.front().first;
+            self->unacked_.pop_front();
+            if (dropped_seq >= self->next_send_seq_) {
+                self->next_send_seq_ = dropped_seq + 1;
+                self->mark_gap();
+                if (self->dropped_++ % 10000 == 0) {
+                    spdlog::warn("[HistoryReplicator] Follower '{}' is behind by more than {} records. {} record(s) dropped; resync the follower from this node's history.",
+                                 self->follower_uri_, self->max_unacked_, self->dropped_);
+                }
+            }
+        }
+        if (!self->ready_) {
+            return;
+        }
+        if (self->last_seq_ - self->next_send_seq_ + 1 >= self->max_batch_) {
+            self->flush();
+        } else {
+            self->schedule_flush();
+        }
+    });
+}
+
+/**
+ * @details 질의를 보내기 전에 모아 둔 기록을 먼저 보내므로, 팔로워는 그 기록을 적용한 뒤 질의를 처리합니다.
+ *          빠진 구간이 있는 팔로워에는 보내지 않고 바로 실패시켜 호출한 쪽이 자신의 히스토리에서 읽게 합니다.
+ */
+void HistoryReplicator::query(HistoryQuery query, std::chrono::milliseconds timeout, QueryHandler handler)
+{
+    net::post(strand_, [self = shared_from_this(), query = std::move(query), timeout, handler = std::move(handler)]() mutable {
+        if (self->stopped_ || !self->ready_ || self->gap_) {
+            handler(false, HistoryQueryResult{});
+            return;
+        }
+        self->flush();
+        std::uint64_t id = self->next_query_id_++;
+        auto timer = std::make_shared<net::steady_timer>(self->strand_, timeout);
+        self->queries_[id] = PendingQuery{std::move(handler), timer};
+        timer->async_wait([self, id](boost::system::error_code ec) {
+            if (ec) {
+                return;
+            }
+            auto it = self->queries_.find(id);
+            if (it == self->queries_.end()) {
+                return;
+            }
+            QueryHandler expired = std::move(it->second.handler);
+            self->queries_.erase(it);
+            spdlog::warn("[HistoryReplicator] Query #{} to follower '{}' timed out.", id, self->follower_uri_);
+            expired(false, HistoryQueryResult{});
+        });
+        self->send(make_frame(FrameType::Query, encode_query(id, query)));
+    });
+}
+
+void HistoryReplicator::do_connect()
+{
+    net::generic::stream_protocol::endpoint endpoint;
+    try {
+        endpoint = parse_bus_endpoint(follower_uri_);
+    } catch (const std::exception& e) {
+        spdlog::error("[HistoryReplicator] Invalid follower uri '{}': {}", follower_uri_, e.what());
+        return;
+    }
+    socket_.async_connect(endpoint,
+        [self = shared_from_this()](boost::system::error_code ec) { self->on_connect(ec); });
+}
+
+void HistoryReplicator::on_connect(boost::system::error_code ec)
+{
+    if (stopped_) {
+        return;
+    }
+    if (ec) {
+        spdlog::warn("[HistoryReplicator] Connect to follower '{}' failed: {}", follower_uri_, ec.message());
+        return schedule_reconnect();
+    }
+    connected_ = true;
+    spdlog::info("[HistoryReplicator] Connected to follower '{}'", follower_uri_);
+    // 팔로워가 적용 위치를 알려 오면(`on_ack`) 그 다음부터 보낸다.
+    send(make_varint_frame(FrameType::Hello, epoch_));
+    do_read_header();
+}
+
+void HistoryReplicator::schedule_reconnect()
+{
+    close_socket();
+    connected_ = false;
+    ready_ = false;
+    writing_ = false;
+    write_queue_.clear();
+    fail_queries();
+    if (stopped_) {
+        return;
+    }
+    reconnect_timer_.expires_after(std::chrono::seconds(1));
+    reconnect_timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+        if (!ec && !self->stopped_) {
+            self->do_connect();
+        }
+    });
+}
+
+void HistoryReplicator::do_read_header()
+{
+    net::async_read(socket_, net::buffer(header_),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            if (self->stopped_) {
+                return;
+            }
+            if (ec) {
+                spdlog::warn("[HistoryReplicator] Follower read failed: {}", ec.message());
+                return self->schedule_reconnect();
+            }
+            std::size_t length = read_frame_length(self->header_);
+            if (length == 0 || length > max_frame_size) {
+                spdlog::error("[HistoryReplicator] Bad frame length ({} bytes). Reconnecting.", length);
+                return self->schedule_reconnect();
+            }
+            self->do_read_body(length);
+        });
+}
+
+void HistoryReplicator::do_read_body(std::size_t length)
+{
+    body_.resize(length);
+    net::async_read(socket_, net::buffer(body_),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            if (self->stopped_) {
+                return;
+            }
+            if (ec) {
+                spdlog::warn("[HistoryReplicator] Follower read failed: {}", ec.message());
+                return self->schedule_reconnect();
+            }
+            self->on_frame(self->body_);
+            if (self->connected_) {
+                self->do_read_header();
+            }
+        });
+}
+
+void HistoryReplicator::on_frame(const std::string& body)
+{
+    auto type = static_cast<FrameType>(body[0]);
+    std::string_view payload(body.data() + 1, body.size() - 1);
+    if (type == FrameType::Ack) {
+        std::uint64_t seq = 0;
+        if (get_varint(payload, seq)) {
+            return on_ack(seq);
+        }
+    } else if (type == FrameType::Result) {
+        std::uint64_t id = 0;
+        HistoryQueryResult result;
+        if (decode_result(payload, id, result)) {
+            auto it = queries_.find(id);
+            if (it == queries_.end()) {
+                return; // 이미 시간이 지난 질의
+            }
+            PendingQuery pending = std::move(it->second);
+            queries_.erase(it);
+            pending.timer->cancel();
+            pending.handler(true, std::move(result));
+            return;
+        }
+    }
+    spdlog::error("[HistoryReplicator] Malformed frame from follower ({} bytes). Reconnecting.", body.size());
+    schedule_reconnect();
+}
+
+/**
+ * @details 접속 후 첫 확인 응답은 팔로워가 이 리더에게서 마지막으로 적용한 순번이므로, 그 다음 순번부터 다시 보냅니다.
+ *          그 기록을 이미 보관 한도 때문에 버렸다면 팔로워에 빠진 구간이 생기므로 경고합니다.
+ */
+void HistoryReplicator::on_ack(std::uint64_t seq)
+{
+    if (!ready_) {
+        std::uint64_t oldest = unacked_.empty() ? last_seq_ + 1 : unacked_.front().first;
+        if (seq + 1 < oldest) {
+            spdlog::warn("[HistoryReplicator] Follower '{}' is at #{} but records up to #{} were dropped; resync the follower from this node's history.",
+                         follower_uri_, seq, oldest - 1);
+            mark_gap();
+        }
+        next_send_seq_ = std::max(seq + 1, oldest);
+        ready_ = true;
+        spdlog::info("[HistoryReplicator] Follower '{}' ready at #{} ({} record(s) to send).",
+                     follower_uri_, seq, last_seq_ + 1 - next_send_seq_);
+    }
+    if (seq > acked_seq_) {
+        acked_seq_ = seq;
+    }
+    while (!unacked_.empty() && unacked_.front().first <= seq) {
+        unacked_.pop_front();
+    }
+    flush();
+}
+
+void HistoryReplicator::schedule_flush()
+{
+    if (flush_scheduled_) {
+        return;
+    }
+    flush_scheduled_ = true;
+    flush_timer_.expires_after(flush_interval_);
+    flush_timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+        self->flush_scheduled_ = false;
+        if (!ec) {
+            self->flush();
+        }
+    });
+}
+
+void HistoryReplicator::flush()
+{
+    if (!ready_ || unacked_.empty()) {
+        return;
+    }
+    next_send_seq_ = std::max(next_send_seq_, unacked_.front().first);
+    while (next_send_seq_ <= last_seq_) {
+        auto index = static_cast<std::size_t>(next_send_seq_ - unacked_.front().first);
+        std::size_t count = std::min(max_batch_, unacked_.size() - index);
+        std::string payload;
+        put_varint(payload, count);
+        for (std::size_t i = index; i < index + count; ++i) {
+            put_record(payload, unacked_[i].first, unacked_[i].second);
+        }
+        send(make_frame(FrameType::Records, payload));
+        next_send_seq_ += count;
+    }
+}
+
+void HistoryReplicator::send(std::shared_ptr<const std::string> frame)
+{
+    write_queue_.push_back(std::move(frame));
+    if (!writing_) {
+        do_write();
+    }
+}
+
+void HistoryReplicator::do_write()
+{
+    if (write_queue_.empty()) {
+        writing_ = false;
+        if (stopped_) {
+            close_socket();
+        }
+        return;
+    }
+    writing_ = true;
+    auto frame = write_queue_.front();
+    net::async_write(socket_, net::buffer(*frame),
+        [self = shared_from_this(), frame](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                self->writing_ = false;
+                if (self->stopped_) {
+                    return;
+                }
+                spdlog::warn("[HistoryReplicator] Follower write failed: {}", ec.message());
+                return self->schedule_reconnect();
+            }
+            self->write_queue_.pop_front();
+            self->do_write();
+        });
+}
+
+/**
+ * @details 기록은 계속 보내 팔로워가 이후 구간은 따라오게 하되, 읽기는 더 이상 맡기지 않습니다.
+ */
+void HistoryReplicator::mark_gap()
+{
+    if (!gap_.exchange(true)) {
+        spdlog::error("[HistoryReplicator] Follower '{}' has missing records. Reads are served locally until it is resynced.",
+                      follower_uri_);
+    }
+}
+
+void HistoryReplicator::fail_queries()
+{
+    auto queries = std::move(queries_);
+    queries_.clear();
+    for (auto& [id, pending] : queries) {
+        pending.timer->cancel();
+        pending.handler(false, HistoryQueryResult{});
+    }
+}
+
+void HistoryReplicator::close_socket()
+{
+    boost::system::error_code ignored;
+    socket_.shutdown(net::socket_base::shutdown_both, ignored);
+    socket_.close(ignored);
+}
+
+//------------------------------------------------------------------------------
+// HistoryFollower::Connection
+//------------------------------------------------------------------------------
+/**
+ * @class HistoryFollower::Connection
+ * @brief 팔로워에 접속한 리더 하나와의 연결. 프레임을 읽어 처리하고 응답을 순서대로 쓴다.
+ */
+class HistoryFollower::Connection : public std::enable_shared_from_this<HistoryFollower::Connection> {
+public:
+    Connection(std::shared_ptr<HistoryFollower> follower, net::generic::stream_protocol::socket socket)
+        : follower_(std::move(follower)), socket_(std::move(socket)) {}
+
+    void start() { do_read_header(); }
+
+    void send(std::shared_ptr<const std::string> frame)
+    {
+        if (closed_) {
+            return;
+        }
+        write_queue_.push_back(std::move(frame));
+        if (!writing_) {
+            do_write();
+        }
+    }
+
+    void close()
+    {
+        closed_ = true;
+        boost::system::error_code ignored;
+        socket_.shutdown(net::socket_base::shutdown_both, ignored);
+        socket_.close(ignored);
+    }
+
+private:
+    void drop()
+    {
+        close();
+        if (follower_->leader_.get() == this) {
+            follower_->leader_.reset();
+            spdlog::info("[HistoryFollower] Leader disconnected at #{}.", follower_->applied_seq_.load());
+        }
+    }
+
+    void do_read_header()
+    {
+        net::async_read(socket_, net::buffer(header_),
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+                if (ec || self->closed_) {
+                    return self->drop();
+                }
+                std::size_t length = read_frame_length(self->header_);
+                if (length == 0 || length > max_frame_size) {
+                    spdlog::error("[HistoryFollower] Bad frame length ({} bytes). Dropping leader.", length);
+                    return self->drop();
+                }
+                self->do_read_body(length);
+            });
+    }
+
+    void do_read_body(std::size_t length)
+    {
+        body_.resize(length);
+        net::async_read(socket_, net::buffer(body_),
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+                if (ec || self->closed_) {
+                    return self->drop();
+                }
+                if (!self->on_frame()) {
+                    spdlog::error("[HistoryFollower] Malformed frame from leader ({} bytes). Dropping leader.", self->body_.size());
+                    return self->drop();
+                }
+                self->do_read_header();
+            });
+    }
+
+    bool on_frame()
+    {
+        auto type = static_cast<FrameType>(body_[0]);
+        std::string_view payload(body_.data() + 1, body_.size() - 1);
+        switch (type) {
+        case FrameType::Hello: {
+            std::uint64_t epoch = 0;
+            if (!get_varint(payload, epoch)) {
+                return false;
+            }
+            auto applied = follower_->on_hello(*this, epoch);
+            if (!applied) {
+                close();
+                return true;
+            }
+            send(make_varint_frame(FrameType::Ack, *applied));
+            return true;
+        }
+        case FrameType::Records: {
+            if (follower_->leader_.get() != this) {
+                return false;
+            }
+            std::uint64_t count = 0;
+            if (!get_varint(payload, count) || count > payload.size()) {
+                return false;
+            }
+            std::vector<std::pair<std::uint64_t, HistoryRecord>> records(static_cast<std::size_t>(count));
+            for (auto& [seq, record] : records) {
+                if (!get_record(payload, seq, record)) {
+                    return false;
+                }
+            }
+            send(make_varint_frame(FrameType::Ack, follower_->apply(records)));
+            return true;
+        }
+        case FrameType::Query: {
+            if (follower_->leader_.get() != this) {
+                return false;
+            }
+            std::uint64_t id = 0;
+            HistoryQuery query;
+            if (!decode_query(payload, id, query)) {
+                return false;
+            }
+            // 파일 읽기는 strand 밖에서 하여 기록 적용을 막지 않는다.
+            net::post(follower_->ioc_, [self = shared_from_this(), id, query = std::move(query)]() {
+                HistoryQueryResult result;
+                if (safe_room_name(query.room)) {
+                    result = run_history_query(self->follower_->history_, query);
+                }
+                auto frame = make_frame(FrameType::Result, encode_result(id, result));
+                net::post(self->follower_->strand_, [self, frame]() { self->send(frame); });
+            });
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    void do_write()
+    {
+        if (write_queue_.empty()) {
+            writing_ = false;
+            return;
+        }
+        writing_ = true;
+        auto frame = write_queue_.front();
+        net::async_write(socket_, net::buffer(*frame),
+            [self = shared_from_this(), frame](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    self->writing_ = false;
+                    return self->drop();
+                }
+                self->write_queue_.pop_front();
+                self->do_write();
+            });
+    }
+
+    std::shared_ptr<HistoryFollower> follower_;
+    net::generic::stream_protocol::socket socket_;
+    std::array<unsigned char, 4> header_{};
+    std::string body_;
+    std::deque<std::shared_ptr<const std::string>> write_queue_;
+    bool writing_ = false;
+    bool closed_ = false;
+};
+
+//------------------------------------------------------------------------------
+// HistoryFollower
+//------------------------------------------------------------------------------
+/**
+ * @details acceptor와 리더 소켓을 같은 strand에 묶어 기록 적용 순서와 적용 위치를 락 없이 관리합니다.
+ *          Unix 소켓 주소인 경우 남아 있는 소켓 파일을 먼저 삭제합니다.
+ */
+HistoryFollower::HistoryFollower(net::io_context& ioc, const std::string& listen_uri, MessageHistory& history, std::string state_path)
+    : ioc_(ioc),
+      strand_(net::make_strand(ioc)),
+      acceptor_(strand_),
+      history_(history),
+      state_path_(std::move(state_path))
+{
+    load_state();
+    auto endpoint = parse_bus_endpoint(listen_uri);
+    if (listen_uri.rfind("unix://", 0) == 0) {
+        unix_path_ = listen_uri.substr(7);
+        std::remove(unix_path_.c_str());
+    }
+
+    acceptor_.open(endpoint.protocol());
+    if (unix_path_.empty()) {
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+    }
+    acceptor_.bind(endpoint);
+    acceptor_.listen(net::socket_base::max_listen_connections);
+    spdlog::info("[HistoryFollower] Listening on {} (at #{})", listen_uri, applied_seq_.load());
+}
+
+HistoryFollower::~HistoryFollower()
+{
+    if (!unix_path_.empty()) {
+        std::remove(unix_path_.c_str());
+    }
+}
+
+void HistoryFollower::run()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() { self->do_accept(); });
+}
+
+void HistoryFollower::stop()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() {
+        self->stopped_ = true;
+        boost::system::error_code ignored;
+        self->acceptor_.close(ignored);
+        for (auto& weak : self->connections_) {
+            if (auto connection = weak.lock()) {
+                connection->close();
+            }
+        }
+        self->connections_.clear();
+        self->leader_.reset();
+        spdlog::info("[HistoryFollower] Stopped at #{}.", self->applied_seq_.load());
+    });
+}
+
+void HistoryFollower::do_accept()
+{
+    acceptor_.async_accept(
+        [self = shared_from_this()](boost::system::error_code ec, net::generic::stream_protocol::socket socket) {
+            self->on_accept(ec, std::move(socket));
+        });
+}
+
+void HistoryFollower::on_accept(boost::system::error_code ec, net::generic::stream_protocol::socket socket)
+{
+    if (stopped_) {
+        return;
+    }
+    if (ec) {
+        spdlog::error("[HistoryFollower] Accept failed: {}", ec.message());
+    } else {
+        std::erase_if(connections_, [](const std::weak_ptr<Connection>& weak) { return weak.expired(); });
+        auto connection = std::make_shared<Connection>(shared_from_this(), std::move(socket));
+        connections_.push_back(connection);
+        connection->start();
+    }
+    do_accept();
+}
+
+/**
+ * @details 다른 리더가 연결되어 있으면 식별값이 같을 때만 (같은 리더의 재접속) 새 연결로 바꾸고, 다르면 거절합니다.
+ *          거절당한 리더는 확인 응답을 받지 못하므로 빠진 구간으로 표시하지 않고 다시 접속을 시도합니다.
+ *          리더가 다시 시작하면 식별값이 바뀌고 순번이 1부터 다시 시작하므로 적용 위치를 0으로 되돌립니다.
+ */
+std::optional<std::uint64_t> HistoryFollower::on_hello(Connection& connection, std::uint64_t epoch)
+{
+    if (leader_ && leader_.get() != &connection) {
+        if (epoch != epoch_) {
+            spdlog::warn("[HistoryFollower] Refusing leader epoch {:x}: leader {:x} is still connected.", epoch, epoch_);
+            return std::nullopt;
+        }
+        spdlog::info("[HistoryFollower] Leader {:x} reconnected; closing its previous connection.", epoch);
+        leader_->close();
+    }
+    leader_ = connection.shared_from_this();
+    if (epoch != epoch_) {
+        spdlog::info("[HistoryFollower] New leader epoch {:x} (previous {:x} at #{}).", epoch, epoch_, applied_seq_.load());
+        epoch_ = epoch;
+        applied_seq_ = 0;
+        save_state();
+    }
+    return applied_seq_;
+}
+
+/**
+ * @details 이미 적용한 순번은 건너뛰어 재전송된 기록이 중복되지 않게 합니다.
+ *          적용 위치는 묶음마다 한 번 저장하므로, 저장 전에 멈추면 마지막 묶음이 한 번 더 적용될 수 있습니다.
+ */
+std::uint64_t HistoryFollower::apply(std::vector<std::pair<std::uint64_t, HistoryRecord>>& records)
+{
+    std::uint64_t applied = applied_seq_;
+    for (const auto& [seq, record] : records) {
+        if (seq <= applied) {
+            continue;
+        }
+        if (seq != applied + 1) {
+            spdlog::warn("[HistoryFollower] Gap in replication stream: #{} -> #{}.", applied, seq);
+        }
+        if (!history_.apply_record(record)) {
+            spdlog::warn("[HistoryFollower] Failed to apply record #{}.", seq);
+        }
+        applied = seq;
+    }
+    if (applied != applied_seq_) {
+        applied_seq_ = applied;
+        save_state();
+    }
+    return applied;
+}
+
+void HistoryFollower::load_state()
+{
+    std::ifstream file(state_path_);
+    std::uint64_t epoch = 0;
+    std::uint64_t seq = 0;
+    if (file >> std::hex >> epoch >> std::dec >> seq) {
+        epoch_ = epoch;
+        applied_seq_ = seq;
+    }
+}
+
+void HistoryFollower::save_state()
+{
+    const std::string temp_path = state_path_ + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        file << std::hex << epoch_ << ' ' << std::dec << applied_seq_.load() << '\n';
+        if (!file) {
+            spdlog::error("[HistoryFollower] Failed to write replication state {}", temp_path);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, state_path_, ec);
+    if (ec) {
+        spdlog::error("[HistoryFollower] Failed to save replication state {}: {}", state_path_, ec.message());
+    }
+}
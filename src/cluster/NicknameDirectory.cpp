@@ -0,0 +1,89 @@
+/**
+ * @file NicknameDirectory.cpp
+ * @brief `NicknameDirectory` 클래스의 구현부입니다.
+ */
+
+#include "cluster/NicknameDirectory.hpp"
+
+bool NicknameDirectory::claim(const std::string& nickname, const std::string& node, clock::time_point now)
+{
+    auto it = leases_.find(nickname);
+    if (it != leases_.end() && it->second.node != node && it->second.expires_at > now) {
+        return false;
+    }
+    leases_[nickname] = Entry{node, now + lease_duration_};
+    return true;
+}
+
+/**
+ * @details 디렉터리 노드가 바뀐 직후에는 새 디렉터리 노드가 기존 임대를 모르므로,
+ *          갱신 요청을 선점 요청과 같게 처리하여 임대 목록을 다시 채웁니다.
+ */
+bool NicknameDirectory::renew(const std::string& nickname, const std::string& node, clock::time_point now)
+{
+    return claim(nickname, node, now);
+}
+
+void NicknameDirectory::release(const std::string& nickname, const std::string& node)
+{
+    auto it = leases_.find(nickname);
+    if (it != leases_.end() && it->second.node == node) {
+        leases_.erase(it);
+    }
+}
+
+std::string NicknameDirectory::holder(const std::string& nickname, clock::time_point now) const
+{
+    auto it = leases_.find(nickname);
+    if (it == leases_.end() || it->second.expires_at <= now) {
+        return {};
+    }
+    return it->second.node;
+}
+
+void NicknameDirectory::retain_owned(const std::function<bool(const std::string&)>& is_owner)
+{
+    for (auto it = leases_.begin(); it != leases_.end();) {
+        it = is_owner(it->first) ? std::next(it) : leases_.erase(it);
+    }
+}
+
+void NicknameDirectory::cache_location(const std::string& nickname, const std::string& node, clock::time_point now)
+{
+    cache_[nickname] = Entry{node, now + lease_duration_};
+}
+
+std::string NicknameDirectory::cached_location(const std::string& nickname, clock::time_point now) const
+{
+    auto it = cache_.find(nickname);
+    if (it == cache_.end() || it->second.expires_at <= now) {
+        return {};
+    }
+    return it->second.node;
+}
+
+void NicknameDirectory::drop_node(const std::string& node)
+{
+    for (auto* entries : {&leases_, &cache_}) {
+        for (auto it = entries->begin(); it != entries->end();) {
+            it = it->second.node == node ? entries->erase(it) : std::next(it);
+        }
+    }
+}
+
+std::size_t NicknameDirectory::expire(clock::time_point now)
+{
+    std::size_t expired = 0;
+    for (auto it = leases_.begin(); it != leases_.end();) {
+        if (it->second.expires_at <= now) {
+            it = leases_.erase(it);
+            ++expired;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        it = it->second.expires_at <= now ? cache_.erase(it) : std::next(it);
+    }
+    return expired;
+}
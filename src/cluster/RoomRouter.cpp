@@ -0,0 +1,143 @@
+/**
+ * @file RoomRouter.cpp
+ * @brief `RoomRouter` 클래스의 구현부입니다.
+ */
+
+#include "cluster/RoomRouter.hpp"
+
+RoomRouter::RoomRouter(const std::string& self_node, std::size_t virtual_nodes)
+    : self_(self_node), ring_(virtual_nodes)
+{
+    if (!self_.empty()) {
+        ring_.add_node(self_);
+    }
+}
+
+bool RoomRouter::observe_node(const std::string& node, clock::time_point now)
+{
+    if (node.empty() || node == self_) {
+        return false;
+    }
+    last_seen_[node] = now;
+    return ring_.add_node(node);
+}
+
+/**
+ * @details 떠난 노드의 구독도 함께 지웁니다.
+ */
+bool RoomRouter::remove_node(const std::string& node)
+{
+    if (node == self_) {
+        return false;
+    }
+    last_seen_.erase(node);
+    for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+        it->second.erase(node);
+        it = it->second.empty() ? subscribers_.erase(it) : std::next(it);
+    }
+    return ring_.remove_node(node);
+}
+
+std::vector<std::string> RoomRouter::expire_nodes(clock::time_point now, clock::duration timeout)
+{
+    std::vector<std::string> expired;
+    for (const auto& [node, seen] : last_seen_) {
+        if (now - seen > timeout) {
+            expired.push_back(node);
+        }
+    }
+    for (const auto& node : expired) {
+        remove_node(node);
+    }
+    return expired;
+}
+
+std::string RoomRouter::track_local_room(const std::string& room)
+{
+    std::string owner = ring_.owner(room);
+    auto [it, inserted] = local_rooms_.try_emplace(room, owner);
+    if (!inserted || owner == self_) {
+        return {};
+    }
+    return owner;
+}
+
+std::string RoomRouter::untrack_local_room(const std::string& room)
+{
+    auto it = local_rooms_.find(room);
+    if (it == local_rooms_.end()) {
+        return {};
+    }
+    std::string owner = it->second;
+    local_rooms_.erase(it);
+    return owner == self_ ? std::string() : owner;
+}
+
+/**
+ * @details 이전 소유 노드에 대한 구독 해지는 보내지 않습니다.
+ *          이전 소유 노드도 같은 링 변경을 보고 소유권을 잃은 방의 구독자 목록을 스스로 정리하기 때문입니다.
+ */
+std::vector<std::pair<std::string, std::string>> RoomRouter::rebalance()
+{
+    std::vector<std::pair<std::string, std::string>> moved;
+    for (auto& [room, owner] : local_rooms_) {
+        std::string new_owner = ring_.owner(room);
+        if (new_owner != owner) {
+            owner = new_owner;
+            if (new_owner != self_) {
+                moved.emplace_back(room, new_owner);
+            }
+        }
+    }
+    for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+        it = ring_.owner(it->first) == self_ ? std::next(it) : subscribers_.erase(it);
+    }
+    return moved;
+}
+
+std::vector<std::string> RoomRouter::local_rooms_owned_by(const std::string& node) const
+{
+    std::vector<std::string> rooms;
+    for (const auto& [room, owner] : local_rooms_) {
+        if (owner == node) {
+            rooms.push_back(room);
+        }
+    }
+    return rooms;
+}
+
+void RoomRouter::add_subscriber(const std::string& room, const std::string& node)
+{
+    if (node.empty() || node == self_) {
+        return;
+    }
+    subscribers_[room].insert(node);
+}
+
+void RoomRouter::remove_subscriber(const std::string& room, const std::string& node)
+{
+    auto it = subscribers_.find(room);
+    if (it == subscribers_.end()) {
+        return;
+    }
+    it->second.erase(node);
+    if (it->second.empty()) {
+        subscribers_.erase(it);
+    }
+}
+
+std::vector<std::string> RoomRouter::subscribers(const std::string& room, const std::string& exclude) const
+{
+    std::vector<std::string> result;
+    auto it = subscribers_.find(room);
+    if (it == subscribers_.end()) {
+        return result;
+    }
+    result.reserve(it->second.size());
+    for (const auto& node : it->second) {
+        if (node != exclude) {
+            result.push_back(node);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,647 @@
+/**
+ * @file SocketBus.cpp
+ * @brief `BusBroker`와 `SocketBus`의 구현부입니다.
+ */
+
+#include "cluster/SocketBus.hpp"
+#include "spdlog/spdlog.h"
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+    constexpr std::size_t max_frame_size = 16 * 1024 * 1024; // 16MB 프레임 크기 제한
+
+    // 프레임 본문 첫 바이트: 프레임 종류
+    enum class FrameType : unsigned char {
+        Hello = 0, ///< 접속 직후 노드 ID를 알림 (라우팅 대상 = 자신의 노드 ID)
+        Data = 1   ///< 메시지 묶음 (라우팅 대상이 비어 있으면 전체 중계)
+    };
+
+    std::shared_ptr<const std::string> make_length_prefixed(const std::string& body)
+    {
+        auto frame = std::make_shared<std::string>();
+        frame->reserve(body.size() + 4);
+        auto length = static_cast<std::uint32_t>(body.size());
+        frame->push_back(static_cast<char>((length >> 24) & 0xFF));
+        frame->push_back(static_cast<char>((length >> 16) & 0xFF));
+        frame->push_back(static_cast<char>((length >> 8) & 0xFF));
+        frame->push_back(static_cast<char>(length & 0xFF));
+        frame->append(body);
+        return frame;
+    }
+
+    // 본문 = [종류 1바이트][대상 노드 길이 2바이트][대상 노드][메시지 묶음]
+    std::shared_ptr<const std::string> make_frame(FrameType type, const std::string& target, const std::string& batch)
+    {
+        std::string body;
+        body.reserve(3 + target.size() + batch.size());
+        body.push_back(static_cast<char>(type));
+        body.push_back(static_cast<char>((target.size() >> 8) & 0xFF));
+        body.push_back(static_cast<char>(target.size() & 0xFF));
+        body.append(target);
+        body.append(batch);
+        return make_length_prefixed(body);
+    }
+
+    bool is_hello_frame(const std::string& frame)
+    {
+        return frame.size() > 4 && static_cast<unsigned char>(frame[4]) == static_cast<unsigned char>(FrameType::Hello);
+    }
+
+    bool parse_route(std::string_view body, FrameType& type, std::string_view& target, std::string_view& batch)
+    {
+        if (body.size() < 3) {
+            return false;
+        }
+        auto raw_type = static_cast<unsigned char>(body[0]);
+        if (raw_type > static_cast<unsigned char>(FrameType::Data)) {
+            return false;
+        }
+        type = static_cast<FrameType>(raw_type);
+        std::size_t target_length = (static_cast<std::size_t>(static_cast<unsigned char>(body[1])) << 8) |
+                                    static_cast<unsigned char>(body[2]);
+        if (body.size() < 3 + target_length) {
+            return false;
+        }
+        target = body.substr(3, target_length);
+        batch = body.substr(3 + target_length);
+        return true;
+    }
+
+    std::size_t read_frame_length(const std::array<unsigned char, 4>& header)
+    {
+        return (static_cast<std::size_t>(header[0]) << 24) |
+               (static_cast<std::size_t>(header[1]) << 16) |
+               (static_cast<std::size_t>(header[2]) << 8) |
+               static_cast<std::size_t>(header[3]);
+    }
+}
+
+/**
+ * @details `unix://` 접두사는 로컬 소켓 경로로, `tcp://host:port`는 IP 주소와 포트로 해석합니다.
+ *          호스트 이름 해석은 하지 않으므로 TCP 주소는 IP 리터럴이어야 합니다.
+ */
+net::generic::stream_protocol::endpoint parse_bus_endpoint(const std::string& uri)
+{
+    const std::string unix_prefix = "unix://";
+    const std::string tcp_prefix = "tcp://";
+
+    if (uri.rfind(unix_prefix, 0) == 0) {
+        std::string path = uri.substr(unix_prefix.size());
+        if (path.empty()) {
+            throw std::invalid_argument("Empty unix socket path in bus uri: " + uri);
+        }
+        return net::generic::stream_protocol::endpoint(net::local::stream_protocol::endpoint(path));
+    }
+    if (uri.rfind(tcp_prefix, 0) == 0) {
+        std::string host_port = uri.substr(tcp_prefix.size());
+        auto colon = host_port.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 >= host_port.size()) {
+            throw std::invalid_argument("Bus uri must be tcp://<ip>:<port>: " + uri);
+        }
+        std::string host = host_port.substr(0, colon);
+        if (host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        }
+        int port = std::stoi(host_port.substr(colon + 1));
+        if (port <= 0 || port > 65535) {
+            throw std::invalid_argument("Bus uri port out of range: " + uri);
+        }
+        return net::generic::stream_protocol::endpoint(
+            net::ip::tcp::endpoint(net::ip::make_address(host), static_cast<unsigned short>(port)));
+    }
+    throw std::invalid_argument("Unsupported bus uri scheme: " + uri);
+}
+
+//------------------------------------------------------------------------------
+// BusBroker::Peer
+//------------------------------------------------------------------------------
+/**
+ * @class BusBroker::Peer
+ * @brief 브로커에 접속한 노드 하나와의 연결. 프레임을 읽어 브로커에 넘기고, 중계 프레임을 순서대로 쓴다.
+ * @details 첫 `Hello` 프레임으로 노드 ID를 알게 되며, 이후 그 ID를 대상으로 하는 프레임만 단독 전달받는다.
+ *          쓰기 큐가 브로커의 `max_peer_queue_bytes_`를 넘으면 `send`가 false를 돌려주고, 브로커가 연결을 끊는다.
+ */
+class BusBroker::Peer : public std::enable_shared_from_this<BusBroker::Peer> {
+public:
+    Peer(std::shared_ptr<BusBroker> broker, net::generic::stream_protocol::socket socket)
+        : broker_(std::move(broker)), socket_(std::move(socket)) {}
+
+    void start() { do_read_header(); }
+
+    const std::string& node_id() const { return node_id_; }
+    void set_node_id(const std::string& node_id) { node_id_ = node_id; }
+
+    bool send(std::shared_ptr<const std::string> frame)
+    {
+        if (queued_bytes_ + frame->size() > broker_->max_peer_queue_bytes_) {
+            return false;
+        }
+        queued_bytes_ += frame->size();
+        write_queue_.push_back(std::move(frame));
+        if (!writing_) {
+            do_write();
+        }
+        return true;
+    }
+
+    void close()
+    {
+        boost::system::error_code ignored;
+        socket_.shutdown(net::socket_base::shutdown_both, ignored);
+        socket_.close(ignored);
+    }
+
+private:
+    void do_read_header()
+    {
+        net::async_read(socket_, net::buffer(header_),
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    return self->broker_->remove_peer(self);
+                }
+                std::size_t length = read_frame_length(self->header_);
+                if (length > max_frame_size) {
+                    spdlog::error("[BusBroker] Frame too large ({} bytes). Dropping peer.", length);
+                    return self->broker_->remove_peer(self);
+                }
+                self->do_read_body(length);
+            });
+    }
+
+    void do_read_body(std::size_t length)
+    {
+        body_.resize(length);
+        net::async_read(socket_, net::buffer(body_),
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    return self->broker_->remove_peer(self);
+                }
+                FrameType type;
+                std::string_view target;
+                std::string_view batch;
+                if (!parse_route(self->body_, type, target, batch)) {
+                    spdlog::error("[BusBroker] Malformed frame from peer. Dropping peer.");
+                    return self->broker_->remove_peer(self);
+                }
+                if (type == FrameType::Hello) {
+                    self->broker_->register_peer(self, std::string(target));
+                } else {
+                    self->broker_->relay(self.get(), std::string(target), make_length_prefixed(self->body_));
+                }
+                self->do_read_header();
+            });
+    }
+
+    void do_write()
+    {
+        if (write_queue_.empty()) {
+            writing_ = false;
+            return;
+        }
+        writing_ = true;
+        auto frame = write_queue_.front();
+        net::async_write(socket_, net::buffer(*frame),
+            [self = shared_from_this(), frame](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    self->writing_ = false;
+                    return self->broker_->remove_peer(self);
+                }
+                self->queued_bytes_ -= frame->size();
+                self->write_queue_.pop_front();
+                self->do_write();
+            });
+    }
+
+    std::shared_ptr<BusBroker> broker_;
+    net::generic::stream_protocol::socket socket_;
+    std::string node_id_;
+    std::array<unsigned char, 4> header_{};
+    std::string body_;
+    std::deque<std::shared_ptr<const std::string>> write_queue_;
+    std::size_t queued_bytes_ = 0;
+    bool writing_ = false;
+};
+
+//------------------------------------------------------------------------------
+// BusBroker
+//------------------------------------------------------------------------------
+/**
+ * @details acceptor와 모든 피어 소켓을 같은 strand에 묶어 피어 집합과 쓰기 큐를 락 없이 관리합니다.
+ *          Unix 소켓 주소인 경우 남아 있는 소켓 파일을 먼저 삭제합니다.
+ */
+BusBroker::BusBroker(net::io_context& ioc, const std::string& listen_uri, std::size_t max_peer_queue_bytes)
+    : strand_(net::make_strand(ioc)),
+      acceptor_(strand_),
+      max_peer_queue_bytes_(max_peer_queue_bytes)
+{
+    auto endpoint = parse_bus_endpoint(listen_uri);
+    if (listen_uri.rfind("unix://", 0) == 0) {
+        unix_path_ = listen_uri.substr(7);
+        std::remove(unix_path_.c_str());
+    }
+
+    acceptor_.open(endpoint.protocol());
+    if (unix_path_.empty()) {
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+    }
+    acceptor_.bind(endpoint);
+    acceptor_.listen(net::socket_base::max_listen_connections);
+    spdlog::info("[BusBroker] Listening on {}", listen_uri);
+}
+
+BusBroker::~BusBroker()
+{
+    if (!unix_path_.empty()) {
+        std::remove(unix_path_.c_str());
+    }
+}
+
+void BusBroker::run()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() { self->do_accept(); });
+}
+
+void BusBroker::stop()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() {
+        self->stopped_ = true;
+        boost::system::error_code ignored;
+        self->acceptor_.close(ignored);
+        for (const auto& peer : self->peers_) {
+            peer->close();
+        }
+        self->peers_.clear();
+        self->peers_by_id_.clear();
+        spdlog::info("[BusBroker] Stopped.");
+    });
+}
+
+void BusBroker::do_accept()
+{
+    acceptor_.async_accept(
+        [self = shared_from_this()](boost::system::error_code ec, net::generic::stream_protocol::socket socket) {
+            self->on_accept(ec, std::move(socket));
+        });
+}
+
+void BusBroker::on_accept(boost::system::error_code ec, net::generic::stream_protocol::socket socket)
+{
+    if (stopped_) {
+        return;
+    }
+    if (ec) {
+        spdlog::error("[BusBroker] Accept failed: {}", ec.message());
+    } else {
+        auto peer = std::make_shared<Peer>(shared_from_this(), std::move(socket));
+        peers_.insert(peer);
+        peer->start();
+        spdlog::info("[BusBroker] Peer connected. Peers: {}", peers_.size());
+    }
+    do_accept();
+}
+
+/**
+ * @details 같은 노드 ID로 다시 접속한 경우 (재접속이 끊김 감지보다 빠른 경우) 새 연결로 교체합니다.
+ */
+void BusBroker::register_peer(const std::shared_ptr<Peer>& peer, const std::string& node_id)
+{
+    if (node_id.empty()) {
+        return;
+    }
+    peer->set_node_id(node_id);
+    peers_by_id_[node_id] = peer;
+    spdlog::info("[BusBroker] Peer registered as node '{}'.", node_id);
+}
+
+/**
+ * @details 쓰기 큐가 한도를 넘은 피어는 순회가 끝난 뒤에 끊습니다 (순회 중에 `peers_`를 지우지 않기 위해).
+ *          끊긴 노드는 재접속하면서 다시 `Hello`를 보내므로, 그 사이의 메시지만 잃습니다.
+ */
+void BusBroker::relay(const Peer* from, const std::string& target, std::shared_ptr<const std::string> frame)
+{
+    std::vector<std::shared_ptr<Peer>> overflowed;
+    if (!target.empty()) {
+        auto it = peers_by_id_.find(target);
+        if (it == peers_by_id_.end()) {
+            spdlog::debug("[BusBroker] No peer for target node '{}'. Frame dropped.", target);
+        } else if (!it->second->send(std::move(frame))) {
+            overflowed.push_back(it->second);
+        }
+    } else {
+        for (const auto& peer : peers_) {
+            if (peer.get() != from && !peer->send(frame)) {
+                overflowed.push_back(peer);
+            }
+        }
+    }
+    for (const auto& peer : overflowed) {
+        spdlog::warn("[BusBroker] Peer '{}' is not keeping up (write queue over {} bytes). Dropping peer.",
+                     peer->node_id(), max_peer_queue_bytes_);
+        remove_peer(peer);
+    }
+}
+
+void BusBroker::remove_peer(const std::shared_ptr<Peer>& peer)
+{
+    if (peers_.erase(peer) > 0) {
+        auto it = peers_by_id_.find(peer->node_id());
+        if (it != peers_by_id_.end() && it->second == peer) {
+            peers_by_id_.erase(it);
+        }
+        peer->close();
+        spdlog::info("[BusBroker] Peer disconnected. Peers: {}", peers_.size());
+    }
+}
+
+//------------------------------------------------------------------------------
+// SocketBus
+//------------------------------------------------------------------------------
+SocketBus::SocketBus(net::io_context& ioc,
+                     std::string broker_uri,
+                     std::chrono::milliseconds flush_interval,
+                     std::size_t max_batch)
+    : strand_(net::make_strand(ioc)),
+      socket_(strand_),
+      flush_timer_(strand_),
+      reconnect_timer_(strand_),
+      broker_uri_(std::move(broker_uri)),
+      flush_interval_(flush_interval),
+      max_batch_(max_batch > 0 ? max_batch : 1)
+{
+}
+
+SocketBus::~SocketBus()
+{
+    spdlog::info("[SocketBus {}] Destroyed.", node_id_);
+}
+
+void SocketBus::start(const std::string& node_id, Handler handler)
+{
+    net::dispatch(strand_, [self = shared_from_this(), node_id, handler = std::move(handler)]() mutable {
+        self->node_id_ = node_id;
+        self->handler_ = std::move(handler);
+        self->stopped_ = false;
+        self->do_connect();
+    });
+}
+
+/**
+ * @details 메시지를 `pending_`에 모으고, `max_batch_`에 도달하면 즉시, 아니면 `flush_interval_` 후에
+ *          하나의 프레임으로 묶어 전송합니다.
+ */
+void SocketBus::publish(ClusterMessage msg)
+{
+    net::post(strand_, [self = shared_from_this(), msg = std::move(msg)]() mutable {
+        if (self->stopped_) {
+            return;
+        }
+        msg.origin_node = self->node_id_;
+        msg.msg_id = ++self->last_msg_id_;
+        if (self->pending_.size() >= max_pending_) {
+            spdlog::warn("[SocketBus {}] Pending queue full, dropping oldest cluster message.", self->node_id_);
+            self->pending_.erase(self->pending_.begin());
+        }
+        self->pending_.push_back(std::move(msg));
+        if (self->pending_.size() >= self->max_batch_) {
+            self->flush();
+        } else {
+            self->schedule_flush();
+        }
+    });
+}
+
+void SocketBus::stop()
+{
+    net::dispatch(strand_, [self = shared_from_this()]() {
+        if (self->stopped_) {
+            return;
+        }
+        self->flush();
+        self->stopped_ = true;
+        self->flush_timer_.cancel();
+        self->reconnect_timer_.cancel();
+        self->handler_ = nullptr;
+        // 이미 큐에 들어간 프레임이 없을 때만 바로 닫고, 있으면 마지막 쓰기 완료 후 닫는다.
+        if (!self->writing_) {
+            self->close_socket();
+        }
+    });
+}
+
+void SocketBus::do_connect()
+{
+    net::generic::stream_protocol::endpoint endpoint;
+    try {
+        endpoint = parse_bus_endpoint(broker_uri_);
+    } catch (const std::exception& e) {
+        spdlog::error("[SocketBus {}] Invalid broker uri '{}': {}", node_id_, broker_uri_, e.what());
+        return;
+    }
+    socket_.async_connect(endpoint,
+        [self = shared_from_this()](boost::system::error_code ec) { self->on_connect(ec); });
+}
+
+void SocketBus::on_connect(boost::system::error_code ec)
+{
+    if (stopped_) {
+        return;
+    }
+    if (ec) {
+        spdlog::warn("[SocketBus {}] Connect to broker '{}' failed: {}", node_id_, broker_uri_, ec.message());
+        return schedule_reconnect();
+    }
+    connected_ = true;
+    spdlog::info("[SocketBus {}] Connected to broker '{}'", node_id_, broker_uri_);
+    auto hello = make_frame(FrameType::Hello, node_id_, "");
+    queued_bytes_ += hello->size();
+    write_queue_.push_front(std::move(hello));
+    do_read_header();
+    if (!writing_) {
+        do_write();
+    }
+    flush();
+}
+
+/**
+ * @details 쓰던 프레임을 포함해 `write_queue_`의 데이터 프레임은 그대로 두었다가 재접속 후 처음부터 다시 씁니다.
+ *          브로커는 길이 접두사로 프레임을 읽으므로, 끊긴 연결에 일부만 쓰인 프레임은 브로커 쪽에서 버려집니다.
+ *          아직 보내지 못한 `Hello`는 재접속 때 새로 넣으므로 여기서 뺍니다.
+ */
+void SocketBus::schedule_reconnect()
+{
+    close_socket();
+    connected_ = false;
+    writing_ = false;
+    if (!write_queue_.empty() && is_hello_frame(*write_queue_.front())) {
+        queued_bytes_ -= write_queue_.front()->size();
+        write_queue_.pop_front();
+    }
+    if (!write_queue_.empty()) {
+        spdlog::info("[SocketBus {}] Keeping {} unsent frame(s) for the next connection.", node_id_, write_queue_.size());
+    }
+    if (stopped_) {
+        return;
+    }
+    reconnect_timer_.expires_after(std::chrono::seconds(1));
+    reconnect_timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+        if (!ec && !self->stopped_) {
+            self->do_connect();
+        }
+    });
+}
+
+void SocketBus::do_read_header()
+{
+    net::async_read(socket_, net::buffer(header_),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            if (self->stopped_) {
+                return;
+            }
+            if (ec) {
+                spdlog::warn("[SocketBus {}] Broker read failed: {}", self->node_id_, ec.message());
+                return self->schedule_reconnect();
+            }
+            std::size_t length = read_frame_length(self->header_);
+            if (length > max_frame_size) {
+                spdlog::error("[SocketBus {}] Frame too large ({} bytes). Reconnecting.", self->node_id_, length);
+                return self->schedule_reconnect();
+            }
+            self->do_read_body(length);
+        });
+}
+
+void SocketBus::do_read_body(std::size_t length)
+{
+    body_.resize(length);
+    net::async_read(socket_, net::buffer(body_),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+            if (self->stopped_) {
+                return;
+            }
+            if (ec) {
+                spdlog::warn("[SocketBus {}] Broker read failed: {}", self->node_id_, ec.message());
+                return self->schedule_reconnect();
+            }
+            FrameType type;
+            std::string_view target;
+            std::string_view body;
+            std::vector<ClusterMessage> batch;
+            if (!parse_route(self->body_, type, target, body) || type != FrameType::Data ||
+                !ClusterMessage::decode_batch(body, batch)) {
+                spdlog::error("[SocketBus {}] Malformed frame from broker ({} bytes). Ignored.",
+                              self->node_id_, self->body_.size());
+            }
+            for (const auto& msg : batch) {
+                if (self->handler_ && msg.origin_node != self->node_id_) {
+                    self->handler_(msg);
+                }
+            }
+            self->do_read_header();
+        });
+}
+
+void SocketBus::schedule_flush()
+{
+    if (flush_scheduled_) {
+        return;
+    }
+    flush_scheduled_ = true;
+    flush_timer_.expires_after(flush_interval_);
+    flush_timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+        self->flush_scheduled_ = false;
+        if (!ec) {
+            self->flush();
+        }
+    });
+}
+
+void SocketBus::flush()
+{
+    if (pending_.empty() || !connected_) {
+        return;
+    }
+    // 같은 대상 노드로 가는 연속 구간을 하나의 프레임으로 묶어 발행 순서를 유지한다.
+    auto first = pending_.begin();
+    while (first != pending_.end()) {
+        auto last = first;
+        std::size_t count = 0;
+        while (last != pending_.end() && last->target_node == first->target_node && count < max_batch_) {
+            ++last;
+            ++count;
+        }
+        std::string target = first->target_node;
+        std::vector<ClusterMessage> batch(std::make_move_iterator(first), std::make_move_iterator(last));
+        enqueue(make_frame(FrameType::Data, target, ClusterMessage::encode_batch(batch)));
+        first = last;
+    }
+    pending_.clear();
+    if (!writing_) {
+        do_write();
+    }
+}
+
+void SocketBus::do_write()
+{
+    if (write_queue_.empty()) {
+        writing_ = false;
+        if (stopped_) {
+            close_socket();
+        }
+        return;
+    }
+    writing_ = true;
+    auto frame = write_queue_.front();
+    net::async_write(socket_, net::buffer(*frame),
+        [self = shared_from_this(), frame](boost::system::error_code ec, std::size_t) {
+            self->on_write(ec);
+        });
+}
+
+void SocketBus::on_write(boost::system::error_code ec)
+{
+    if (ec) {
+        writing_ = false;
+        spdlog::warn("[SocketBus {}] Broker write failed: {}", node_id_, ec.message());
+        return schedule_reconnect();
+    }
+    queued_bytes_ -= write_queue_.front()->size();
+    write_queue_.pop_front();
+    do_write();
+}
+
+/**
+ * @details 한도를 넘으면 가장 오래된 데이터 프레임부터 버립니다. 쓰는 중인 맨 앞 프레임은 버퍼가
+ *          `async_write`에 넘어가 있으므로 건드리지 않습니다.
+ */
+void SocketBus::enqueue(std::shared_ptr<const std::string> frame)
+{
+    queued_bytes_ += frame->size();
+    write_queue_.push_back(std::move(frame));
+    std::size_t keep = writing_ ? 1 : 0;
+    std::size_t dropped = 0;
+    while (queued_bytes_ > max_queued_bytes_ && write_queue_.size() > keep + 1) {
+        auto victim = write_queue_.begin() + static_cast<std::ptrdiff_t>(keep);
+        queued_bytes_ -= (*victim)->size();
+        write_queue_.erase(victim);
+        ++dropped;
+    }
+    if (dropped > 0) {
+        spdlog::warn("[SocketBus {}] Write queue over {} bytes, dropped {} oldest frame(s).",
+                     node_id_, max_queued_bytes_, dropped);
+    }
+}
+
+void SocketBus::close_socket()
+{
+    boost::system::error_code ignored;
+    socket_.shutdown(net::socket_base::shutdown_both, ignored);
+    socket_.close(ignored);
+}
@@ -0,0 +1,671 @@
+#include "../include/handlers/PhotoRenditions.hpp"
+
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#ifdef CHERRY_HAVE_JPEG
+#include <csetjmp>
+#include <cstdio>   // jpeglib.h가 FILE을 쓴다
+#include <jpeglib.h>
+#endif
+#ifdef CHERRY_HAVE_WEBP
+#include <webp/encode.h>
+#endif
+
+namespace {
+    struct SizeClass {
+        const char* name;
+        int width;   ///< 0이면 원본 크기
+    };
+
+    /// 원본은 Google에서 `maxwidth=1600`으로 받으므로 `full`은 원본 그대로
+    constexpr SizeClass kSizeClasses[] = {
+        {"thumb", 320},
+        {"medium", 800},
+        {"full", 0},
+    };
+
+    /// 이보다 큰 사진은 디코딩하지 않는다. (손상되었거나 악의적인 헤더로 메모리를 과하게 쓰지 않도록)
+    constexpr std::uint64_t kMaxPixels = 40'000'000;
+
+    bool isJpeg(const std::string& content_type) {
+        return content_type.find("jpeg") != std::string::npos || content_type.find("jpg") != std::string::npos;
+    }
+
+#ifdef CHERRY_HAVE_JPEG
+    /// RGB 8비트 이미지
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> rgb;
+    };
+
+    /// libjpeg 오류는 프로세스를 끝내지 않고 `setjmp` 지점으로 돌아온다.
+    struct JpegError {
+        jpeg_error_mgr mgr;
+        std::jmp_buf jump;
+    };
+
+    void onJpegError(j_common_ptr cinfo) {
+        std::longjmp(reinterpret_cast<JpegError*>(cinfo->err)->jump, 1);
+    }
+
+    void ignoreJpegMessage(j_common_ptr) {}
+
+    /// JPEG 헤더만 읽어 너비를 얻는다. (DCT 디코딩 없음) 읽을 수 없으면 0.
+    int readJpegWidth(const std::string& data) {
+        jpeg_decompress_struct cinfo;
+        JpegError err;
+        cinfo.err = jpeg_std_error(&err.mgr);
+        err.mgr.error_exit = onJpegError;
+        err.mgr.output_message = ignoreJpegMessage;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_decompress(&cinfo);
+            return 0;
+        }
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char*>(const_cast<char*>(data.data())),
+                     static_cast<unsigned long>(data.size()));
+        jpeg_read_header(&cinfo, TRUE);
+        const int width = static_cast<int>(cinfo.image_width);
+        jpeg_destroy_decompress(&cinfo);
+        return width;
+    }
+
+    /**
+     * @brief JPEG를 RGB로 디코딩한다. `target`이 있으면 DCT 단계 축소(1/2, 1/4, 1/8) 중
+     *        너비가 `target`보다 작아지지 않는 가장 작은 크기로 읽는다.
+     * @param source_width 원본 너비
+     */
+    bool decodeJpeg(const std::string& data, int target, Image& out, int& source_width) {
+        jpeg_decompress_struct cinfo;
+        JpegError err;
+        cinfo.err = jpeg_std_error(&err.mgr);
+        err.mgr.error_exit = onJpegError;
+        err.mgr.output_message = ignoreJpegMessage;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char*>(const_cast<char*>(data.data())),
+                     static_cast<unsigned long>(data.size()));
+        jpeg_read_header(&cinfo, TRUE);
+        source_width = static_cast<int>(cinfo.image_width);
+        if (static_cast<std::uint64_t>(cinfo.image_width) * cinfo.image_height > kMaxPixels) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+        cinfo.out_color_space = JCS_RGB;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = 1;
+        for (unsigned int denom = 8; target > 0 && denom > 1; denom /= 2) {
+            if (cinfo.image_width / denom >= static_cast<unsigned int>(target)) {
+                cinfo.scale_denom = denom;
+                break;
+            }
+        }
+        jpeg_start_decompress(&cinfo);
+        out.width = static_cast<int>(cinfo.output_width);
+        out.height = static_cast<int>(cinfo.output_height);
+        const std::size_t stride = static_cast<std::size_t>(out.width) * 3;
+        out.rgb.resize(stride * out.height);
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = out.rgb.data() + stride * cinfo.output_scanline;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        return true;
+    }
+
+    /// RGB를 JPEG로 인코딩한다. 결과 버퍼는 libjpeg가 malloc으로 잡으므로 호출 측이 `free`해야 한다.
+    bool compressJpeg(const Image& image, int quality, unsigned char** buffer, unsigned long* size) {
+        jpeg_compress_struct cinfo;
+        JpegError err;
+        cinfo.err = jpeg_std_error(&err.mgr);
+        err.mgr.error_exit = onJpegError;
+        err.mgr.output_message = ignoreJpegMessage;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_compress(&cinfo);
+            return false;
+        }
+        jpeg_create_compress(&cinfo);
+        jpeg_mem_dest(&cinfo, buffer, size);
+        cinfo.image_width = static_cast<JDIMENSION>(image.width);
+        cinfo.image_height = static_cast<JDIMENSION>(image.height);
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        cinfo.optimize_coding = TRUE;
+        jpeg_start_compress(&cinfo, TRUE);
+        const std::size_t stride = static_cast<std::size_t>(image.width) * 3;
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = const_cast<unsigned char*>(image.rgb.data()) + stride * cinfo.next_scanline;
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+        return true;
+    }
+
+    std::optional<std::string> encodeJpeg(const Image& image, int quality) {
+        unsigned char* buffer = nullptr;
+        unsigned long size = 0;
+        bool ok = compressJpeg(image, quality, &buffer, &size);
+        std::optional<std::string> out;
+        if (ok && buffer != nullptr) {
+            out.emplace(reinterpret_cast<const char*>(buffer), size);
+        }
+        std::free(buffer);
+        return out;
+    }
+
+    /**
+     * @brief 너비 `width`로 줄인다. (비율 유지, 면적 평균)
+     * @details DCT 단계 축소 뒤에는 남은 배율이 2배 미만이라 출력 화소 하나가 원본 화소 몇 개만 평균한다.
+     */
+    Image resizeArea(const Image& src, int width) {
+        Image dst;
+        dst.width = width;
+        dst.height = std::max(1, static_cast<int>((static_cast<long long>(src.height) * width + src.width / 2) / src.width));
+        dst.rgb.resize(static_cast<std::size_t>(dst.width) * dst.height * 3);
+
+        // 출력 열마다 원본 열 구간 [x0, x1)
+        std::vector<int> x_begin(dst.width), x_end(dst.width);
+        for (int x = 0; x < dst.width; ++x) {
+            x_begin[x] = static_cast<int>(static_cast<long long>(x) * src.width / dst.width);
+            x_end[x] = std::max(x_begin[x] + 1, static_cast<int>(static_cast<long long>(x + 1) * src.width / dst.width));
+        }
+        const std::size_t src_stride = static_cast<std::size_t>(src.width) * 3;
+        for (int y = 0; y < dst.height; ++y) {
+            int y0 = static_cast<int>(static_cast<long long>(y) * src.height / dst.height);
+            int y1 = std::max(y0 + 1, static_cast<int>(static_cast<long long>(y + 1) * src.height / dst.height));
+            unsigned char* out = dst.rgb.data() + static_cast<std::size_t>(y) * dst.width * 3;
+            for (int x = 0; x < dst.width; ++x) {
+                unsigned int sum[3] = {0, 0, 0};
+                for (int sy = y0; sy < y1; ++sy) {
+                    const unsigned char* in = src.rgb.data() + sy * src_stride + static_cast<std::size_t>(x_begin[x]) * 3;
+                    for (int sx = x_begin[x]; sx < x_end[x]; ++sx, in += 3) {
+                        sum[0] += in[0];
+                        sum[1] += in[1];
+                        sum[2] += in[2];
+                    }
+                }
+                const unsigned int count = static_cast<unsigned int>((y1 - y0) * (x_end[x] - x_begin[x]));
+                for (int c = 0; c < 3; ++c) {
+                    *out++ = static_cast<unsigned char>((sum[c] + count / 2) / count);
+                }
+            }
+        }
+        return dst;
+    }
+#endif
+
+#ifdef CHERRY_HAVE_WEBP
+    std::optional<std::string> encodeWebp(const Image& image, int quality) {
+        std::uint8_t* output = nullptr;
+        std::size_t size = WebPEncodeRGB(image.rgb.data(), image.width, image.height, image.width * 3,
+                                         static_cast<float>(quality), &output);
+        if (size == 0 || output == nullptr) {
+            return std::nullopt;
+        }
+        std::string out(reinterpret_cast<const char*>(output), size);
+        WebPFree(output);
+        return out;
+    }
+#endif
+}
+
+PhotoRenditions::PhotoRenditions(PhotoRenditionsConfig config)
+    : m_config(std::move(config)), m_dir(m_config.cache_dir) {
+    m_config.jpeg_quality = std::clamp(m_config.jpeg_quality, 1, 100);
+    m_config.webp_quality = std::clamp(m_config.webp_quality, 1, 100);
+    m_config.max_queue = std::max<std::size_t>(m_config.max_queue, 1);
+    if (!m_dir.empty()) {
+        scanDisk();
+    }
+    if (canResize()) {
+        std::size_t threads = std::max<std::size_t>(m_config.threads, 1);
+        m_workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            m_workers.emplace_back(&PhotoRenditions::workerLoop, this);
+        }
+    }
+}
+
+PhotoRenditions::~PhotoRenditions() {
+    std::deque<std::function<void()>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopped = true;
+        dropped.swap(m_jobs);
+    }
+    m_queueCv.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    // 버린 작업의 promise가 여기서 사라지며 기다리던 요청은 원본을 받는다.
+}
+
+std::optional<int> PhotoRenditions::widthFor(const std::string& size_class) {
+    for (const auto& entry : kSizeClasses) {
+        if (size_class == entry.name) {
+            return entry.width;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<PhotoRenditions::Format> PhotoRenditions::parseFormat(const std::string& name) {
+    if (name == "jpeg" || name == "jpg") {
+        return Format::Jpeg;
+    }
+    if (name == "webp") {
+        return Format::Webp;
+    }
+    return std::nullopt;
+}
+
+bool PhotoRenditions::canResize() {
+#ifdef CHERRY_HAVE_JPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PhotoRenditions::canEncode(Format format) {
+    if (format == Format::Jpeg) {
+        return canResize();
+    }
+#if defined(CHERRY_HAVE_JPEG) && defined(CHERRY_HAVE_WEBP)
+    return true;
+#else
+    return false;
+#endif
+}
+
+PhotoRenditions::Format PhotoRenditions::effectiveFormat(Format format) {
+    return canEncode(format) ? format : Format::Jpeg;
+}
+
+bool PhotoRenditions::servesOriginal(int width, Format format) const {
+    return !canResize() || (width == 0 && effectiveFormat(format) == Format::Jpeg);
+}
+
+std::optional<PhotoRenditions::Photo> PhotoRenditions::lookup(const std::string& reference, int width, Format format) {
+    if (m_dir.empty()) {
+        return std::nullopt;
+    }
+    format = effectiveFormat(format);
+    if (servesOriginal(width, format)) {
+        auto found = original(reference);
+        if (!found) {
+            return std::nullopt;
+        }
+        ++m_diskHits;
+        return Photo{std::move(found->bytes), std::move(found->content_type), etagFor(found->hash, 0, Format::Jpeg)};
+    }
+
+    auto ref = readFile(refPath(reference));
+    if (!ref) {
+        return std::nullopt;
+    }
+    std::string hash = ref->substr(0, ref->find('\n'));
+    auto bytes = readFile(renditionPath(hash, width, format));
+    if (!bytes) {
+        return std::nullopt;
+    }
+    ++m_diskHits;
+    return Photo{std::move(*bytes), contentTypeFor(format), etagFor(hash, width, format)};
+}
+
+std::optional<PhotoRenditions::Original> PhotoRenditions::original(const std::string& reference) {
+    if (m_dir.empty()) {
+        std::lock_guard<std::mutex> lock(m_memoryMutex);
+        auto it = m_memoryByRef.find(reference);
+        if (it == m_memoryByRef.end()) {
+            return std::nullopt;
+        }
+        m_memoryOriginals.splice(m_memoryOriginals.begin(), m_memoryOriginals, it->second);
+        return it->second->second;
+    }
+    auto ref = readFile(refPath(reference));
+    if (!ref) {
+        return std::nullopt;
+    }
+    // ref 파일: "<내용 해시>\n<Content-Type>\n"
+    std::istringstream lines(*ref);
+    Original result;
+    if (!std::getline(lines, result.hash) || !std::getline(lines, result.content_type) || result.hash.empty()) {
+        return std::nullopt;
+    }
+    auto bytes = readFile(originalPath(result.hash));
+    if (!bytes) {
+        return std::nullopt;
+    }
+    result.bytes = std::move(*bytes);
+    return result;
+}
+
+PhotoRenditions::Original PhotoRenditions::storeOriginal(const std::string& reference, std::string bytes,
+                                                         std::string content_type) {
+    Original result{sha256Hex(bytes), std::move(bytes), std::move(content_type)};
+    if (m_dir.empty()) {
+        // 디스크 캐시가 없으면 최근 원본만 메모리에 두어, 같은 사진의 다른 크기 요청이 Google에 다시 가지 않게 한다.
+        std::lock_guard<std::mutex> lock(m_memoryMutex);
+        if (m_config.memory_originals == 0) {
+            return result;
+        }
+        if (auto it = m_memoryByRef.find(reference); it != m_memoryByRef.end()) {
+            m_memoryOriginals.erase(it->second);
+            m_memoryByRef.erase(it);
+        }
+        m_memoryOriginals.emplace_front(reference, result);
+        m_memoryByRef[reference] = m_memoryOriginals.begin();
+        while (m_memoryOriginals.size() > m_config.memory_originals) {
+            m_memoryByRef.erase(m_memoryOriginals.back().first);
+            m_memoryOriginals.pop_back();
+        }
+    } else {
+        std::error_code ec;
+        if (std::filesystem::exists(originalPath(result.hash), ec) || writeFile(originalPath(result.hash), result.bytes)) {
+            writeFile(refPath(reference), result.hash + "\n" + result.content_type + "\n");
+        }
+    }
+    return result;
+}
+
+PhotoRenditions::Photo PhotoRenditions::render(const Original& original, int width, Format format) {
+    format = effectiveFormat(format);
+    auto as_original = [&original]() {
+        return Photo{original.bytes, original.content_type, etagFor(original.hash, 0, Format::Jpeg)};
+    };
+    // 요청한 사본 대신 보내는 원본. 나중에 만들 사본과 ETag가 겹치지 않게 하고 클라이언트가 캐시하지 않게 표시한다.
+    auto as_fallback = [&original, width, format]() {
+        std::string etag = etagFor(original.hash, width, format);
+        etag.insert(etag.size() - 1, "-fallback");
+        return Photo{original.bytes, original.content_type, std::move(etag), true};
+    };
+    // JPEG가 아니면 (Google 사진은 모두 JPEG) 디코딩하지 않고 원본을 보낸다.
+    if (servesOriginal(width, format) || !isJpeg(original.content_type)) {
+        return as_original();
+    }
+#ifdef CHERRY_HAVE_JPEG
+    // 원본이 목표 너비보다 작으면 확대하지 않고 원본을 쓴다. (같은 내용의 사본 파일을 따로 두지 않음)
+    if (format == Format::Jpeg && width > 0) {
+        const int source_width = readJpegWidth(original.bytes);
+        if (source_width > 0 && source_width <= width) {
+            return as_original();
+        }
+    }
+#endif
+
+    auto promise = std::make_shared<std::promise<std::optional<std::string>>>();
+    auto future = promise->get_future();
+    bool queued = submit([this, &original, width, format, promise]() {
+        try {
+            promise->set_value(encode(original, width, format));
+        }
+        catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    if (!queued) {
+        ++m_fallbacks;
+        return as_fallback();
+    }
+
+    // 작업이 끝나거나 버려질 때까지 기다린다. (버려지면 broken_promise)
+    std::optional<std::string> encoded;
+    try {
+        encoded = future.get();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[PhotoRenditions] Rendition failed: " << e.what() << std::endl;
+    }
+    if (!encoded) {
+        ++m_fallbacks;
+        return as_fallback();
+    }
+    ++m_rendered;
+    if (!m_dir.empty()) {
+        writeFile(renditionPath(original.hash, width, format), *encoded);
+    }
+    return Photo{std::move(*encoded), contentTypeFor(format), etagFor(original.hash, width, format)};
+}
+
+/**
+ * @details 원본이 목표 너비보다 작으면 확대하지 않는다. (JPEG 요청은 `render`가 미리 걸러 원본을 보냄)
+ */
+std::optional<std::string> PhotoRenditions::encode(const Original& original, int width, Format format) const {
+#ifdef CHERRY_HAVE_JPEG
+    Image image;
+    int source_width = 0;
+    if (!decodeJpeg(original.bytes, width, image, source_width)) {
+        return std::nullopt;
+    }
+    if (width > 0 && image.width > width) {
+        image = resizeArea(image, width);
+    }
+#ifdef CHERRY_HAVE_WEBP
+    if (format == Format::Webp) {
+        return encodeWebp(image, m_config.webp_quality);
+    }
+#endif
+    return encodeJpeg(image, m_config.jpeg_quality);
+#else
+    (void)original;
+    (void)width;
+    (void)format;
+    return std::nullopt;
+#endif
+}
+
+PhotoRenditions::Metrics PhotoRenditions::metrics() const {
+    Metrics result;
+    result.disk_hits = m_diskHits.load();
+    result.rendered = m_rendered.load();
+    result.fallbacks = m_fallbacks.load();
+    result.evicted = m_evicted.load();
+    {
+        std::lock_guard<std::mutex> lock(m_diskMutex);
+        result.disk_bytes = m_diskBytes;
+    }
+    return result;
+}
+
+std::filesystem::path PhotoRenditions::renditionPath(const std::string& hash, int width, Format format) const {
+    return m_dir / (hash + "-" + std::to_string(width) + (format == Format::Webp ? ".webp" : ".jpg"));
+}
+
+std::filesystem::path PhotoRenditions::originalPath(const std::string& hash) const {
+    return m_dir / (hash + ".orig");
+}
+
+std::filesystem::path PhotoRenditions::refPath(const std::string& reference) const {
+    return m_dir / ("ref-" + sha256Hex(reference).substr(0, 32));
+}
+
+std::optional<std::string> PhotoRenditions::readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (in.bad()) {
+        return std::nullopt;
+    }
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return data;
+}
+
+bool PhotoRenditions::writeFile(const std::filesystem::path& path, const std::string& data) {
+    std::filesystem::path tmp = path;
+    tmp += ".tmp" + std::to_string(m_tmpCounter.fetch_add(1));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            std::cerr << "[PhotoRenditions] Failed to write file: " << tmp << std::endl;
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_diskMutex);
+    std::error_code ec;
+    std::uintmax_t replaced = std::filesystem::file_size(path, ec);
+    if (ec) {
+        replaced = 0;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::cerr << "[PhotoRenditions] Failed to replace file: " << ec.message() << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    m_diskBytes = m_diskBytes + data.size() > replaced ? m_diskBytes + data.size() - replaced : 0;
+    if (m_diskBytes > m_config.max_disk_bytes) {
+        evictLocked();
+    }
+    return true;
+}
+
+/**
+ * @details 호출 측이 `m_diskMutex`를 잡고 있어야 한다. 디렉터리를 훑으며 실제 크기로 사용량을 다시 센다.
+ */
+void PhotoRenditions::evictLocked() {
+    struct Entry {
+        std::filesystem::file_time_type time;
+        std::uintmax_t size;
+        std::filesystem::path path;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(m_dir, ec)) {
+        std::error_code file_ec;
+        if (!file.is_regular_file(file_ec) || file.path().filename().string().find(".tmp") != std::string::npos) {
+            continue;
+        }
+        Entry entry{file.last_write_time(file_ec), file.file_size(file_ec), file.path()};
+        if (file_ec) {
+            continue;
+        }
+        total += entry.size;
+        entries.push_back(std::move(entry));
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+    const std::uint64_t target = m_config.max_disk_bytes / 10 * 9;
+    for (const auto& entry : entries) {
+        if (total <= target) {
+            break;
+        }
+        if (std::filesystem::remove(entry.path, ec)) {
+            total -= entry.size;
+            ++m_evicted;
+        }
+    }
+    m_diskBytes = total;
+}
+
+void PhotoRenditions::scanDisk() {
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+    if (ec) {
+        std::cerr << "[PhotoRenditions] Cannot create cache directory " << m_dir << ": " << ec.message()
+                  << " (disk cache disabled)" << std::endl;
+        m_dir.clear();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_diskMutex);
+    for (const auto& file : std::filesystem::directory_iterator(m_dir, ec)) {
+        std::error_code file_ec;
+        if (!file.is_regular_file(file_ec)) {
+            continue;
+        }
+        // 쓰다가 멈춘 임시 파일
+        if (file.path().filename().string().find(".tmp") != std::string::npos) {
+            std::filesystem::remove(file.path(), file_ec);
+            continue;
+        }
+        std::uintmax_t size = file.file_size(file_ec);
+        if (!file_ec) {
+            m_diskBytes += size;
+        }
+    }
+    if (m_diskBytes > m_config.max_disk_bytes) {
+        evictLocked();
+    }
+}
+
+bool PhotoRenditions::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_stopped || m_workers.empty() || m_jobs.size() >= m_config.max_queue) {
+            return false;
+        }
+        m_jobs.push_back(std::move(job));
+    }
+    m_queueCv.notify_one();
+    return true;
+}
+
+void PhotoRenditions::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    while (true) {
+        m_queueCv.wait(lock, [this]() { return m_stopped || !m_jobs.empty(); });
+        if (m_stopped) {
+            return;
+        }
+        auto job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+        job();   // 작업이 예외를 promise로 넘기므로 여기서는 던지지 않는다.
+        lock.lock();
+    }
+}
+
+std::string PhotoRenditions::sha256Hex(const std::string& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(data.data(), data.size(), digest, &length, EVP_sha256(), nullptr);
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(length * 2);
+    for (unsigned int i = 0; i < length; ++i) {
+        out.push_back(digits[digest[i] >> 4]);
+        out.push_back(digits[digest[i] & 0x0F]);
+    }
+    return out;
+}
+
+std::string PhotoRenditions::etagFor(const std::string& hash, int width, Format format) {
+    std::string tag = "\"" + hash.substr(0, 32);
+    if (width > 0 || format != Format::Jpeg) {
+        tag += "-" + std::to_string(width) + (format == Format::Webp ? "w" : "j");
+    }
+    return tag + "\"";
+}
+
+const char* PhotoRenditions::contentTypeFor(Format format) {
+    return format == Format::Webp ? "image/webp" : "image/jpeg";
+}
@@ -3,17 +3,25 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/asio/connect.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/json.hpp>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <chrono>
 #include <mutex>
 #include <thread>
 #include <cmath> // std::round 함수 사용을 위해 추가
+#include <cctype>
+#include <future>
+#include <iterator> // std::size
+#include <optional>
+#include <vector>
+#include <algorithm> // std::min
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -22,9 +30,182 @@ namespace json = boost::json;
 namespace ssl = boost::asio::ssl;
 using tcp = boost::asio::ip::tcp;
 
-PlacesApiHandler::PlacesApiHandler(const std::string& api_key)
-    : m_apiKey(api_key) {
-    std::cout << "PlacesApiHandler created with API key" << std::endl;
+namespace {
+    /// 선택 가능한 응답 필드 범위. 좁은 것부터 나열한다.
+    const PlacesProjection kProjections[] = {
+        {"summary",
+         "id,displayName,formattedAddress,location,rating,userRatingCount",
+         "places.id,places.displayName,places.formattedAddress,places.location"},
+        {"full",
+         "id,displayName,formattedAddress,location,rating,userRatingCount,reviews,photos",
+         "places.id,places.displayName,places.formattedAddress,places.location,places.rating,places.userRatingCount,places.photos"},
+    };
+
+    std::vector<std::string> splitFields(const std::string& fields) {
+        std::vector<std::string> result;
+        std::stringstream ss(fields);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            result.push_back(field);
+        }
+        return result;
+    }
+
+    /// `wider`의 상세 필드가 `narrower`의 상세 필드를 모두 포함하는지
+    bool covers(const PlacesProjection& wider, const PlacesProjection& narrower) {
+        auto fields = splitFields(wider.detailsFields);
+        for (const auto& field : splitFields(narrower.detailsFields)) {
+            if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// 검색 응답의 장소 항목을 로컬 색인 항목으로 바꾼다. ID나 위치가 없으면 nullopt.
+    std::optional<PlacesLocalIndex::Place> placeFromSearchItem(const json::value& item) {
+        if (!item.is_object()) {
+            return std::nullopt;
+        }
+        const json::object& obj = item.as_object();
+        const json::value* id = obj.if_contains("id");
+        const json::value* loc = obj.if_contains("loc");
+        if (id == nullptr || !id->is_string() || loc == nullptr || !loc->is_object() ||
+            !loc->as_object().contains("lat") || !loc->as_object().contains("lng")) {
+            return std::nullopt;
+        }
+        PlacesLocalIndex::Place place;
+        place.id = id->as_string().c_str();
+        place.latitude = loc->at("lat").to_number<double>();
+        place.longitude = loc->at("lng").to_number<double>();
+        if (const json::value* name = obj.if_contains("name"); name != nullptr && name->is_string()) {
+            place.name = name->as_string().c_str();
+        }
+        if (const json::value* addr = obj.if_contains("addr"); addr != nullptr && addr->is_string()) {
+            place.address = addr->as_string().c_str();
+        }
+        if (const json::value* rating = obj.if_contains("rating"); rating != nullptr && rating->is_number()) {
+            place.rating = rating->to_number<double>();
+        }
+        if (const json::value* count = obj.if_contains("ratingCount"); count != nullptr && count->is_number()) {
+            place.rating_count = count->to_number<std::int64_t>();
+        }
+        if (const json::value* photo = obj.if_contains("photo"); photo != nullptr && photo->is_string()) {
+            place.photo = photo->as_string().c_str();
+        }
+        return place;
+    }
+
+    /// 상세 조회 응답(Google 형식)을 로컬 색인 항목으로 바꾼다. ID나 위치가 없으면 nullopt.
+    std::optional<PlacesLocalIndex::Place> placeFromDetails(const json::value& details) {
+        if (!details.is_object()) {
+            return std::nullopt;
+        }
+        const json::object& obj = details.as_object();
+        const json::value* id = obj.if_contains("id");
+        const json::value* location = obj.if_contains("location");
+        if (id == nullptr || !id->is_string() || location == nullptr || !location->is_object() ||
+            !location->as_object().contains("latitude") || !location->as_object().contains("longitude")) {
+            return std::nullopt;
+        }
+        PlacesLocalIndex::Place place;
+        place.id = id->as_string().c_str();
+        place.latitude = location->at("latitude").to_number<double>();
+        place.longitude = location->at("longitude").to_number<double>();
+        if (const json::value* name = obj.if_contains("displayName");
+            name != nullptr && name->is_object() && name->as_object().contains("text")) {
+            place.name = name->at("text").as_string().c_str();
+        }
+        if (const json::value* addr = obj.if_contains("formattedAddress"); addr != nullptr && addr->is_string()) {
+            place.address = addr->as_string().c_str();
+        }
+        if (const json::value* rating = obj.if_contains("rating"); rating != nullptr && rating->is_number()) {
+            place.rating = rating->to_number<double>();
+        }
+        if (const json::value* count = obj.if_contains("userRatingCount"); count != nullptr && count->is_number()) {
+            place.rating_count = count->to_number<std::int64_t>();
+        }
+        if (const json::value* photos = obj.if_contains("photos");
+            photos != nullptr && photos->is_array() && !photos->as_array().empty() &&
+            photos->as_array()[0].is_object() && photos->as_array()[0].as_object().contains("name")) {
+            place.photo = photos->as_array()[0].at("name").as_string().c_str();
+        }
+        return place;
+    }
+
+    /// 로컬 색인 항목을 검색 응답의 장소 항목으로 바꾼다. (`detailed`이면 평점/사진 필드 포함)
+    json::object placeToSearchItem(const PlacesLocalIndex::Place& place, bool detailed) {
+        json::object item;
+        item["id"] = place.id;
+        item["name"] = place.name;
+        item["addr"] = place.address;
+        json::object location;
+        location["lat"] = place.latitude;
+        location["lng"] = place.longitude;
+        item["loc"] = std::move(location);
+        if (detailed) {
+            if (place.rating) {
+                item["rating"] = *place.rating;
+            }
+            if (place.rating_count) {
+                item["ratingCount"] = *place.rating_count;
+            }
+            if (!place.photo.empty()) {
+                item["photo"] = place.photo;
+            }
+        }
+        return item;
+    }
+
+    /// 상세 응답에서 `projection`에 없는 최상위 필드를 뺀다.
+    json::value trimToProjection(const json::value& place, const PlacesProjection& projection) {
+        if (!place.is_object()) {
+            return place;
+        }
+        json::object trimmed;
+        for (const auto& field : splitFields(projection.detailsFields)) {
+            if (const json::value* value = place.as_object().if_contains(field)) {
+                trimmed[field] = *value;
+            }
+        }
+        return trimmed;
+    }
+
+    /// 검색 응답(`places` 배열)에서 `full` projection에만 있는 평점/사진 필드를 뺀다.
+    json::value trimSearchToSummary(json::value result) {
+        json::value* places = result.is_object() ? result.as_object().if_contains("places") : nullptr;
+        if (places != nullptr && places->is_array()) {
+            for (auto& item : places->as_array()) {
+                if (item.is_object()) {
+                    item.as_object().erase("rating");
+                    item.as_object().erase("ratingCount");
+                    item.as_object().erase("photo");
+                }
+            }
+        }
+        return result;
+    }
+}
+
+PlacesApiHandler::PlacesApiHandler(const std::string& api_key, UpstreamGuardConfig guard_config,
+                                   PlacesCacheConfig cache_config, PlacesPrefetchConfig prefetch_config,
+                                   PlacesLocalIndexConfig local_config, PhotoRenditionsConfig photo_config)
+    : m_apiKey(api_key), m_guard(guard_config), m_cache(std::move(cache_config)), m_prefetch(prefetch_config),
+      m_prefetchTokens(static_cast<double>(prefetch_config.per_minute)),
+      m_prefetchRefilled(std::chrono::steady_clock::now()), m_local(local_config), m_photos(std::move(photo_config)) {
+    // 스냅샷에서 읽은 캐시 응답으로 로컬 색인(텍스트 검색/자동 완성)을 채운다. 주변 검색 영역은 새로 받을 때만 기록한다.
+    m_cache.forEach([this](const std::string& key, const json::value& data, PlacesCache::Clock::time_point stored) {
+        ingestCachedResponse(key, data, stored);
+    });
+    std::cout << "PlacesApiHandler created with API key (cached entries: " << m_cache.size()
+              << ", local places: " << m_local.size() << ")" << std::endl;
+}
+
+PlacesApiHandler::~PlacesApiHandler() {
+    // 갱신 작업이 m_cache/m_guard를 쓰므로 먼저 끝낸다. (m_cache는 소멸하면서 스냅샷을 저장한다)
+    m_fanoutPool.join();
+    m_backgroundPool.stop();
+    m_backgroundPool.join();
 }
 
 // 템플릿 함수 구현
@@ -39,6 +220,12 @@ http::response<http::string_body> PlacesApiHandler::handleNearbySearch(
         json::value req_json = json::parse(body_str);
         
         std::cout << "요청 본문 파싱 성공: " << body_str << std::endl;
+
+        const PlacesProjection* projection = findProjection(
+            req_json.as_object().contains("projection") ? req_json.at("projection").as_string().c_str() : "summary");
+        if (projection == nullptr) {
+            return this->createErrorResponse(http::status::bad_request, "Unknown projection");
+        }
         
         // 클라이언트 요청에서 필요한 파라미터 추출
         double latitude = req_json.at("latitude").as_double();
@@ -60,6 +247,14 @@ http::response<http::string_body> PlacesApiHandler::handleNearbySearch(
         
         std::cout << "위치 정보 추출: lat=" << latitude << ", lng=" << longitude 
                   << ", 반경=" << radius << "m" << std::endl;
+
+        // 이 원 안의 답을 이미 빠짐없이 알고 있으면 Google을 호출하지 않는다.
+        bool detailed = projection == &fullProjection();
+        if (auto local = m_local.nearby(latitude, longitude, radius, SEARCH_RESULT_COUNT, detailed)) {
+            ++m_localHits;
+            return this->createLocalResponse(*local, detailed, req);
+        }
+        ++m_localMisses;
         
         // Google Places API 요청 데이터 구성
         json::object request_data;
@@ -76,14 +271,19 @@ http::response<http::string_body> PlacesApiHandler::handleNearbySearch(
 
         // 필요한 파라미터 추가 (fieldMask는 searchNearby에서 지원하지 않음)
         request_data["includedPrimaryTypes"] = json::array{"restaurant", "cafe", "bakery", "bar"};
-        request_data["maxResultCount"] = 5; // 클라이언트가 5개만 표시하므로 최적화
+        request_data["maxResultCount"] = static_cast<std::int64_t>(SEARCH_RESULT_COUNT); // 클라이언트가 5개만 표시하므로 최적화
         request_data["rankPreference"] = "DISTANCE"; // 거리순 정렬 추가
         
-        // Google Places API 호출 (POST 사용)
-        json::value response_data = this->requestGooglePlacesApi(
+        // 같은 검색의 더 넓은 projection 응답이 신선하면 그것을 잘라 쓰고, 아니면 Google Places API 호출 (POST 사용)
+        const std::string endpoint = "https://places.googleapis.com/v1/places:searchNearby";
+        std::optional<json::value> wider = this->cachedWiderSearch(endpoint, request_data, *projection);
+        bool fetched = false;
+        json::value response_data = wider ? std::move(*wider) : this->requestGooglePlacesApi(
             http::verb::post, // 메서드 명시
-            "https://places.googleapis.com/v1/places:searchNearby", 
-            json::value(request_data));
+            endpoint,
+            json::value(request_data),
+            projection->searchFieldMask,
+            &fetched);
         
         // ===== Google API 오류 확인 및 전파 =====
         if (response_data.is_object() && response_data.as_object().contains("__error_status_code")) {
@@ -91,8 +291,21 @@ http::response<http::string_body> PlacesApiHandler::handleNearbySearch(
             std::string error_body = response_data.at("__error_body").as_string().c_str();
             return this->createErrorResponse(static_cast<http::status>(status_code), error_body);
         }
+        // 연결/TLS 오류는 "error" 필드만 있는 객체로 돌아온다.
+        if (response_data.is_object() && response_data.as_object().contains("error")) {
+            return this->createErrorResponse(http::status::bad_gateway, response_data.at("error").as_string().c_str());
+        }
         // ===== 추가 끝 =====
 
+        // Google이 방금 빠짐없이 돌려준 영역을 기록한다 (다음 검색은 Google 없이 답할 수 있음).
+        // 장소는 캐시에 넣을 때 이미 색인에 들어갔고, 캐시에서 꺼낸 응답은 지금 본 것으로 다시 기록하지 않는다.
+        if (fetched) {
+            this->markNearbyCovered(response_data, latitude, longitude, radius);
+        }
+
+        // 사용자가 곧 열어 볼 상위 결과의 상세 정보를 미리 받아 둔다 (응답은 기다리지 않음)
+        this->prefetchDetails(response_data);
+
         // 응답 반환 (정상)
         http::response<http::string_body> res{http::status::ok, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
@@ -120,6 +333,12 @@ http::response<http::string_body> PlacesApiHandler::handleTextSearch(
         const std::string& body_str = req.body();
         json::value req_json = json::parse(body_str);
         
+        const PlacesProjection* projection = findProjection(
+            req_json.as_object().contains("projection") ? req_json.at("projection").as_string().c_str() : "summary");
+        if (projection == nullptr) {
+            return this->createErrorResponse(http::status::bad_request, "Unknown projection");
+        }
+
         // 클라이언트 요청에서 필요한 파라미터 추출
         std::string query = req_json.at("query").as_string().c_str();
         double latitude = req_json.as_object().contains("latitude") ? 
@@ -167,17 +386,32 @@ http::response<http::string_body> PlacesApiHandler::handleTextSearch(
         }
         // 랜드마크 검색의 경우 위치 제한 없이 전국 검색
 
+        // 검색어에 맞는 신선한 장소를 로컬 색인에서 충분히 찾으면 Google을 호출하지 않는다.
+        bool detailed = projection == &fullProjection();
+        std::optional<std::pair<double, double>> bias_center;
+        if (!isLandmarkSearch && radius > 0) {
+            bias_center = std::make_pair(latitude, longitude);
+        }
+        if (auto local = m_local.search(query, bias_center, radius, SEARCH_RESULT_COUNT, detailed)) {
+            ++m_localHits;
+            return this->createLocalResponse(*local, detailed, req);
+        }
+        ++m_localMisses;
+
         // 필요한 파라미터 추가
-        request_data["maxResultCount"] = 5; // 클라이언트가 5개만 표시하므로 최적화
+        request_data["maxResultCount"] = static_cast<std::int64_t>(SEARCH_RESULT_COUNT); // 클라이언트가 5개만 표시하므로 최적화
         
         // 한국어 검색 결과 우선
         request_data["languageCode"] = "ko";
         
-        // Google Places API 호출 (POST 사용)
-        json::value response_data = this->requestGooglePlacesApi(
+        // 같은 검색의 더 넓은 projection 응답이 신선하면 그것을 잘라 쓰고, 아니면 Google Places API 호출 (POST 사용)
+        const std::string endpoint = "https://places.googleapis.com/v1/places:searchText";
+        std::optional<json::value> wider = this->cachedWiderSearch(endpoint, request_data, *projection);
+        json::value response_data = wider ? std::move(*wider) : this->requestGooglePlacesApi(
             http::verb::post, // 메서드 명시
-            "https://places.googleapis.com/v1/places:searchText", 
-            json::value(request_data));
+            endpoint,
+            json::value(request_data),
+            projection->searchFieldMask);
         
         // ===== Google API 오류 확인 및 전파 =====
         if (response_data.is_object() && response_data.as_object().contains("__error_status_code")) {
@@ -185,8 +419,15 @@ http::response<http::string_body> PlacesApiHandler::handleTextSearch(
             std::string error_body = response_data.at("__error_body").as_string().c_str();
             return this->createErrorResponse(static_cast<http::status>(status_code), error_body);
         }
+        // 연결/TLS 오류는 "error" 필드만 있는 객체로 돌아온다.
+        if (response_data.is_object() && response_data.as_object().contains("error")) {
+            return this->createErrorResponse(http::status::bad_gateway, response_data.at("error").as_string().c_str());
+        }
         // ===== 추가 끝 =====
 
+        // 사용자가 곧 열어 볼 상위 결과의 상세 정보를 미리 받아 둔다 (응답은 기다리지 않음)
+        this->prefetchDetails(response_data);
+
         // 응답 반환 (정상)
         http::response<http::string_body> res{http::status::ok, req.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
@@ -207,18 +448,17 @@ http::response<http::string_body> PlacesApiHandler::handleTextSearch(
 }
 
 http::response<http::string_body> PlacesApiHandler::handlePlaceDetails(
-    const std::string& place_id) {
+    const std::string& place_id,
+    const std::string& projection_name) {
     
     try {
-        // fieldMask를 사용하여 필요한 필드(사진 포함)를 명시적으로 요청
-        std::string fields = "id,displayName,formattedAddress,location,rating,userRatingCount,reviews,photos";
-        std::string api_url = "https://places.googleapis.com/v1/places/" + place_id + "?fields=" + fields;
-        
-        // Google Places API 호출 (GET 사용)
-        json::value response_data = this->requestGooglePlacesApi(
-            http::verb::get, 
-            api_url, 
-            json::object()); 
+        const PlacesProjection* projection = findProjection(projection_name);
+        if (projection == nullptr) {
+            return this->createErrorResponse(http::status::bad_request, "Unknown projection: " + projection_name);
+        }
+
+        // 캐시(더 넓은 projection 포함) 또는 Google Places API에서 가져옴 (GET 사용)
+        json::value response_data = this->fetchDetails(place_id, *projection); 
         
         // ===== Google API 오류 확인 및 전파 =====
         if (response_data.is_object() && response_data.as_object().contains("__error_status_code")) {
@@ -254,10 +494,532 @@ http::response<http::string_body> PlacesApiHandler::handlePlaceDetails(
     }
 }
 
+/**
+ * @details 응답 본문은 장소마다 결과가 준비되는 대로 요청 순서에 맞춰 문자열로 이어 붙이므로,
+ * 전체 결과를 하나의 JSON 트리로 다시 만들지 않는다. 같은 ID가 여러 번 오면 한 번만 가져온다.
+ * HttpServer가 요청마다 `string_body` 응답 하나를 쓰므로 본문은 청크로 나눠 보내지 않고 다 만든 뒤 보낸다.
+ * 그동안 이 함수를 부른 HTTP IO 스레드는 다른 Places 핸들러처럼 기다린다.
+ */
+http::response<http::string_body> PlacesApiHandler::handleBatchDetails(
+    const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req) {
+
+    std::vector<std::string> ids;
+    const PlacesProjection* projection = nullptr;
+    try {
+        json::value req_json = json::parse(req.body());
+        std::string projection_name = req_json.as_object().contains("projection")
+            ? req_json.at("projection").as_string().c_str() : "full";
+        projection = findProjection(projection_name);
+        if (projection == nullptr) {
+            return this->createErrorResponse(http::status::bad_request, "Unknown projection: " + projection_name);
+        }
+        const json::array& id_array = req_json.at("ids").as_array();
+        if (id_array.empty() || id_array.size() > MAX_BATCH_IDS) {
+            return this->createErrorResponse(http::status::bad_request,
+                "ids must contain 1 to " + std::to_string(MAX_BATCH_IDS) + " place IDs");
+        }
+        for (const auto& id_value : id_array) {
+            std::string id = id_value.as_string().c_str();
+            // 장소 ID는 URL 경로에 그대로 들어가므로 영문/숫자/-/_ 만 허용한다.
+            bool valid = !id.empty() && std::all_of(id.begin(), id.end(), [](unsigned char c) {
+                return std::isalnum(c) || c == '-' || c == '_';
+            });
+            if (!valid) {
+                return this->createErrorResponse(http::status::bad_request, "Invalid place ID: " + id);
+            }
+            ids.push_back(std::move(id));
+        }
+    }
+    catch (const std::exception& e) {
+        return this->createErrorResponse(http::status::bad_request,
+                                  std::string("Error processing batch details request: ") + e.what());
+    }
+
+    // 캐시에서 바로 채울 수 없는 장소만 동시에 가져온다. (Stale은 requestGooglePlacesApi가 바로 돌려주고 뒤에서 갱신)
+    std::unordered_map<std::string, std::shared_future<json::value>> pending;
+    for (const auto& id : ids) {
+        if (pending.count(id) != 0) {
+            continue;
+        }
+        if (auto cached = cachedDetails(id, *projection)) {
+            std::promise<json::value> ready;
+            ready.set_value(std::move(*cached));
+            pending.emplace(id, ready.get_future().share());
+            continue;
+        }
+        auto task = std::make_shared<std::packaged_task<json::value()>>([this, id, projection]() {
+            return fetchDetails(id, *projection, BATCH_PERMIT_WAIT);
+        });
+        pending.emplace(id, task->get_future().share());
+        net::post(m_fanoutPool, [task]() { (*task)(); });
+    }
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "application/json");
+    res.keep_alive(req.keep_alive());
+    std::string& body = res.body();
+    body = "{\"places\":[";
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        json::value place;
+        try {
+            place = pending.at(ids[i]).get();
+        }
+        catch (const std::exception& e) {
+            json::object error_obj;
+            error_obj["error"] = e.what();
+            place = std::move(error_obj);
+        }
+
+        json::object item;
+        item["id"] = ids[i];
+        if (place.is_object() && place.as_object().contains("__error_status_code")) {
+            item["status"] = place.at("__error_status_code").to_number<int>();
+            item["error"] = place.at("__error_body");
+        } else if (place.is_object() && place.as_object().size() == 1 && place.as_object().contains("error")) {
+            item["status"] = static_cast<int>(http::status::bad_gateway);
+            item["error"] = place.at("error");
+        } else {
+            item["status"] = 200;
+            item["place"] = std::move(place);
+        }
+        if (i != 0) {
+            body += ',';
+        }
+        body += json::serialize(item);
+    }
+    body += "]}";
+    res.prepare_payload();
+    return res;
+}
+
 json::value PlacesApiHandler::requestGooglePlacesApi(
+    http::verb method,
+    const std::string& endpoint,
+    const json::value& requestData,
+    const std::string& fieldMask,
+    bool* fetched,
+    std::chrono::milliseconds permit_wait) {
+
+    std::string cache_key = cacheKey(method, endpoint, requestData, fieldMask);
+
+    // soft TTL 안이면 그대로, hard TTL 안이면 오래된 응답을 바로 보내고 뒤에서 갱신한다.
+    PlacesCache::Lookup cached = m_cache.lookup(cache_key);
+    if (cached.state == PlacesCache::State::Fresh) {
+        return cached.data;
+    }
+    if (cached.state == PlacesCache::State::Stale) {
+        scheduleRefresh(cache_key, method, endpoint, requestData, fieldMask);
+        return cached.data;
+    }
+
+    int status_code = 0;
+    json::value result = fetchThroughGuard(method, endpoint, requestData, fieldMask, status_code, 1.0, permit_wait);
+    if (status_code == 200) {
+        cacheResponse(cache_key, result);
+        if (fetched != nullptr) {
+            *fetched = true;
+        }
+    } else if (cached.state == PlacesCache::State::Expired &&
+               UpstreamGuard::classify(status_code) == UpstreamGuard::Outcome::Failure) {
+        // 업스트림이 실패하거나 거절되면 hard TTL이 지난 응답이라도 대신 보낸다.
+        std::cerr << "[PlacesApiHandler] Serving expired cache entry (age " << cached.age.count()
+                  << "s) while upstream is unavailable" << std::endl;
+        return cached.data;
+    }
+    return result;
+}
+
+std::string PlacesApiHandler::cacheKey(
+    http::verb method,
+    const std::string& endpoint,
+    const json::value& requestData,
+    const std::string& fieldMask) {
+
+    std::string key = std::string(http::to_string(method)) + " " + endpoint;
+    if (method == http::verb::post) {
+        key += " " + json::serialize(requestData);
+    }
+    if (!fieldMask.empty()) {
+        key += " mask=" + fieldMask;
+    }
+    return key;
+}
+
+const PlacesProjection* PlacesApiHandler::findProjection(const std::string& name) {
+    for (const auto& projection : kProjections) {
+        if (name == projection.name) {
+            return &projection;
+        }
+    }
+    return nullptr;
+}
+
+const PlacesProjection& PlacesApiHandler::fullProjection() {
+    return kProjections[std::size(kProjections) - 1];
+}
+
+std::string PlacesApiHandler::detailsEndpoint(const std::string& place_id, const PlacesProjection& projection) {
+    // fields 파라미터로 projection에 필요한 필드만 요청 (필드가 적을수록 Google 요금 등급도 낮아짐)
+    return "https://places.googleapis.com/v1/places/" + place_id + "?fields=" + projection.detailsFields;
+}
+
+/**
+ * @details 요청한 projection의 항목이 신선하지 않으면, 같은 장소의 더 넓은 projection 항목(예: `full`)이 신선한지 보고
+ * 필요한 필드만 남겨 돌려준다.
+ */
+std::optional<json::value> PlacesApiHandler::cachedDetails(const std::string& place_id, const PlacesProjection& projection) {
+    for (const auto& candidate : kProjections) {
+        if (&candidate != &projection && !covers(candidate, projection)) {
+            continue;
+        }
+        auto cached = m_cache.lookup(cacheKey(http::verb::get, detailsEndpoint(place_id, candidate), json::object()));
+        if (cached.state == PlacesCache::State::Fresh) {
+            return &candidate == &projection ? std::move(cached.data) : trimToProjection(cached.data, projection);
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @details 검색 응답의 projection 차이는 평점/사진 필드뿐이므로, 더 넓은 항목에서 그 필드를 빼면 좁은 응답과 같다.
+ * 더 넓은 항목을 찾는다는 것은 요청한 projection이 `full`이 아니라는 뜻이므로 항상 잘라서 돌려준다.
+ * 요청한 projection 자신의 항목(Stale 처리 포함)은 `requestGooglePlacesApi`가 본다.
+ */
+std::optional<json::value> PlacesApiHandler::cachedWiderSearch(const std::string& endpoint, const json::value& requestData,
+                                                               const PlacesProjection& projection) {
+    for (const auto& candidate : kProjections) {
+        if (&candidate == &projection || !covers(candidate, projection)) {
+            continue;
+        }
+        auto cached = m_cache.lookup(cacheKey(http::verb::post, endpoint, requestData, candidate.searchFieldMask));
+        if (cached.state == PlacesCache::State::Fresh) {
+            return trimSearchToSummary(std::move(cached.data));
+        }
+    }
+    return std::nullopt;
+}
+
+json::value PlacesApiHandler::fetchDetails(const std::string& place_id, const PlacesProjection& projection,
+                                           std::chrono::milliseconds permit_wait) {
+    if (auto cached = cachedDetails(place_id, projection)) {
+        return std::move(*cached);
+    }
+    return requestGooglePlacesApi(http::verb::get, detailsEndpoint(place_id, projection), json::object(),
+                                  "", nullptr, permit_wait);
+}
+
+json::value PlacesApiHandler::fetchThroughGuard(
+    http::verb method,
+    const std::string& endpoint,
+    const json::value& requestData,
+    const std::string& fieldMask,
+    int& status_code,
+    double max_utilization,
+    std::chrono::milliseconds permit_wait) {
+
+    // 업스트림이 느리거나 오류가 많으면 새 연결을 열지 않고 503으로 답한다. (한도에 걸리면 `permit_wait`까지 기다린다)
+    UpstreamGuard::Permit permit = m_guard.acquire(permit_wait, max_utilization);
+    if (!permit.admitted()) {
+        bool open = permit.admission == UpstreamGuard::Admission::CircuitOpen;
+        json::object error_body;
+        error_body["error"] = open ? "Google Places API is temporarily unavailable"
+                                   : "Too many concurrent Google Places API requests";
+        json::object error_obj;
+        status_code = static_cast<int>(http::status::service_unavailable);
+        error_obj["__error_status_code"] = status_code;
+        error_obj["__error_body"] = json::serialize(error_body);
+        return error_obj;
+    }
+
+    json::value result = m_transport ? m_transport(method, endpoint, requestData, fieldMask)
+                                     : callGooglePlacesApi(method, endpoint, requestData, fieldMask);
+
+    // 연결/TLS 오류는 "error" 필드만 있는 객체로 돌아온다. (상태 코드 0으로 분류)
+    status_code = 200;
+    if (result.is_object() && result.as_object().contains("__error_status_code")) {
+        status_code = result.at("__error_status_code").to_number<int>();
+    } else if (result.is_object() && result.as_object().contains("error")) {
+        status_code = 0;
+    }
+    m_guard.release(permit, UpstreamGuard::classify(status_code));
+    return result;
+}
+
+void PlacesApiHandler::scheduleRefresh(
+    const std::string& key,
+    http::verb method,
+    const std::string& endpoint,
+    const json::value& requestData,
+    const std::string& fieldMask) {
+
+    if (!m_cache.beginRefresh(key)) {
+        return;
+    }
+    net::post(m_backgroundPool, [this, key, method, endpoint, requestData, fieldMask]() {
+        int status_code = 0;
+        json::value result = fetchThroughGuard(method, endpoint, requestData, fieldMask, status_code);
+        if (status_code == 200) {
+            cacheResponse(key, std::move(result));
+        }
+        m_cache.endRefresh(key);
+    });
+}
+
+/**
+ * @details 미리 받기는 사용자 요청보다 우선순위가 낮으므로, 분당 예산(`per_minute`)이 남아 있고
+ * 동시성 한도의 `max_utilization` 비율 안에서만 업스트림을 호출한다. 서킷이 열려 있으면 시험 호출도 하지 않는다.
+ * 이미 신선한 캐시가 있거나 같은 키를 받는 중이면 건너뛴다.
+ */
+void PlacesApiHandler::prefetchDetails(const json::value& search_result) {
+    if (m_prefetch.top_k == 0 || !search_result.is_object()) {
+        return;
+    }
+    const json::value* places = search_result.as_object().if_contains("places");
+    if (places == nullptr || !places->is_array()) {
+        return;
+    }
+
+    std::size_t scheduled = 0;
+    for (const auto& place : places->as_array()) {
+        if (scheduled >= m_prefetch.top_k) {
+            break;
+        }
+        const json::value* id = place.is_object() ? place.as_object().if_contains("id") : nullptr;
+        if (id == nullptr || !id->is_string() || id->as_string().empty()) {
+            continue;
+        }
+        ++scheduled;
+
+        // 가장 넓은 projection으로 받아 두면 좁은 projection 요청도 이 항목으로 채울 수 있다.
+        std::string endpoint = detailsEndpoint(id->as_string().c_str(), fullProjection());
+        std::string key = cacheKey(http::verb::get, endpoint, json::object());
+        if (m_cache.lookup(key).state == PlacesCache::State::Fresh || !m_cache.beginRefresh(key)) {
+            continue;
+        }
+        if (!takePrefetchToken()) {
+            m_cache.endRefresh(key);
+            ++m_prefetchSkipped;
+            break;
+        }
+        ++m_prefetchStarted;
+        net::post(m_backgroundPool, [this, key, endpoint]() {
+            int status_code = 0;
+            json::value result = fetchThroughGuard(http::verb::get, endpoint, json::object(), "", status_code,
+                                                   m_prefetch.max_utilization);
+            if (status_code == 200) {
+                cacheResponse(key, std::move(result));
+            } else {
+                ++m_prefetchSkipped;
+            }
+            m_cache.endRefresh(key);
+        });
+    }
+}
+
+bool PlacesApiHandler::takePrefetchToken() {
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    auto now = std::chrono::steady_clock::now();
+    double capacity = static_cast<double>(m_prefetch.per_minute);
+    double elapsed_minutes = std::chrono::duration<double, std::ratio<60>>(now - m_prefetchRefilled).count();
+    m_prefetchTokens = std::min(capacity, m_prefetchTokens + elapsed_minutes * capacity);
+    m_prefetchRefilled = now;
+    if (m_prefetchTokens < 1.0) {
+        return false;
+    }
+    m_prefetchTokens -= 1.0;
+    return true;
+}
+
+/**
+ * @details 주변 검색은 거리순으로 최대 `SEARCH_RESULT_COUNT`개를 받으므로, 결과가 그보다 적으면 반경 전체를,
+ * 한도만큼 왔으면 가장 먼 결과까지의 원을 빠짐없이 받은 영역으로 기록한다.
+ */
+void PlacesApiHandler::markNearbyCovered(const json::value& search_result, double latitude, double longitude,
+                                         double radius) {
+    const json::value* places = search_result.is_object() ? search_result.as_object().if_contains("places") : nullptr;
+    std::size_t count = 0;
+    double farthest = 0;
+    if (places != nullptr && places->is_array()) {
+        for (const auto& item : places->as_array()) {
+            if (auto place = placeFromSearchItem(item)) {
+                farthest = std::max(farthest, PlacesLocalIndex::distanceMeters(
+                    latitude, longitude, place->latitude, place->longitude));
+                ++count;
+            }
+        }
+    }
+    m_local.markCovered(latitude, longitude, count < SEARCH_RESULT_COUNT ? radius : farthest);
+}
+
+void PlacesApiHandler::cacheResponse(const std::string& key, json::value data) {
+    ingestCachedResponse(key, data, PlacesCache::Clock::now());
+    m_cache.put(key, std::move(data));
+}
+
+void PlacesApiHandler::ingestCachedResponse(const std::string& key, const json::value& data,
+                                            PlacesCache::Clock::time_point stored) {
+    // 캐시 키 끝의 필드 마스크/fields로 어떤 projection으로 받은 응답인지, 앞의 엔드포인트로 주변 검색인지 알 수 있다.
+    const PlacesProjection& full = fullProjection();
+    bool detailed = key.ends_with(std::string(" mask=") + full.searchFieldMask) ||
+                    key.ends_with(std::string("?fields=") + full.detailsFields);
+    bool from_nearby = key.starts_with("POST https://places.googleapis.com/v1/places:searchNearby ");
+    if (key.starts_with("GET ")) {
+        if (auto place = placeFromDetails(data)) {
+            place->detailed = detailed;
+            place->seen = stored;
+            m_local.upsert(std::move(*place));
+        }
+        return;
+    }
+    const json::value* places = data.is_object() ? data.as_object().if_contains("places") : nullptr;
+    if (places == nullptr || !places->is_array()) {
+        return;
+    }
+    for (const auto& item : places->as_array()) {
+        if (auto place = placeFromSearchItem(item)) {
+            place->detailed = detailed;
+            place->from_nearby = from_nearby;
+            place->seen = stored;
+            m_local.upsert(std::move(*place));
+        }
+    }
+}
+
+http::response<http::string_body> PlacesApiHandler::handleAutocomplete(
+    const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req) {
+
+    std::string input;
+    std::optional<std::pair<double, double>> center;
+    std::size_t limit = 5;
+    try {
+        json::value req_json = json::parse(req.body());
+        input = req_json.at("input").as_string().c_str();
+        if (req_json.as_object().contains("latitude") && req_json.as_object().contains("longitude")) {
+            center = std::make_pair(req_json.at("latitude").to_number<double>(),
+                                    req_json.at("longitude").to_number<double>());
+        }
+        if (req_json.as_object().contains("limit")) {
+            limit = req_json.at("limit").to_number<std::size_t>();
+        }
+    }
+    catch (const std::exception& e) {
+        return this->createErrorResponse(http::status::bad_request,
+                                  std::string("Error processing autocomplete request: ") + e.what());
+    }
+    if (input.empty() || input.size() > MAX_AUTOCOMPLETE_INPUT) {
+        return this->createErrorResponse(http::status::bad_request,
+            "input must be 1 to " + std::to_string(MAX_AUTOCOMPLETE_INPUT) + " bytes");
+    }
+    if (limit == 0 || limit > MAX_AUTOCOMPLETE_RESULTS) {
+        return this->createErrorResponse(http::status::bad_request,
+            "limit must be 1 to " + std::to_string(MAX_AUTOCOMPLETE_RESULTS));
+    }
+
+    ++m_autocompleteRequests;
+    json::array suggestions;
+    for (const auto& hit : m_local.autocomplete(input, center, limit)) {
+        json::object item = placeToSearchItem(hit.place, false);
+        if (center) {
+            item["distance"] = static_cast<std::int64_t>(std::lround(hit.distance_m));
+        }
+        suggestions.push_back(std::move(item));
+    }
+    json::object result;
+    result["suggestions"] = std::move(suggestions);
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "application/json");
+    res.keep_alive(req.keep_alive());
+    res.body() = json::serialize(result);
+    res.prepare_payload();
+    return res;
+}
+
+http::response<http::string_body> PlacesApiHandler::createLocalResponse(
+    const std::vector<PlacesLocalIndex::Hit>& hits,
+    bool detailed,
+    const http::request<http::string_body, http::basic_fields<std::allocator<char>>>& req) {
+
+    json::array places;
+    for (const auto& hit : hits) {
+        places.push_back(placeToSearchItem(hit.place, detailed));
+    }
+    json::object result;
+    result["places"] = std::move(places);
+
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "application/json");
+    res.set("X-Places-Source", "local");
+    res.keep_alive(req.keep_alive());
+    res.body() = json::serialize(result);
+    res.prepare_payload();
+    return res;
+}
+
+std::size_t PlacesApiHandler::importLocalPlaces(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[PlacesApiHandler] Cannot open local places file: " << path << std::endl;
+        return 0;
+    }
+    std::size_t imported = 0;
+    std::size_t skipped = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        boost::system::error_code ec;
+        json::value item = json::parse(line, ec);
+        std::optional<PlacesLocalIndex::Place> place;
+        if (!ec) {
+            place = placeFromSearchItem(item);
+        }
+        if (!place) {
+            ++skipped;
+            continue;
+        }
+        // 가져온 목록에는 어떤 projection인지 표시가 없으므로 평점/사진 필드가 하나라도 있으면 full로 본다.
+        place->detailed = place->rating || place->rating_count || !place->photo.empty();
+        m_local.upsert(std::move(*place));
+        ++imported;
+    }
+    std::cout << "[PlacesApiHandler] Imported " << imported << " local places from " << path
+              << " (skipped " << skipped << " malformed lines)" << std::endl;
+    return imported;
+}
+
+http::response<http::string_body> PlacesApiHandler::handleMetrics() const {
+    http::response<http::string_body> res{http::status::ok, 11};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "text/plain; version=0.0.4");
+    res.body() = m_guard.metricsText("places_upstream_");
+    res.body() += "# TYPE places_cache_entries gauge\nplaces_cache_entries " + std::to_string(m_cache.size()) + "\n";
+    res.body() += "# TYPE places_prefetch_started_total counter\nplaces_prefetch_started_total " + std::to_string(m_prefetchStarted.load()) + "\n";
+    res.body() += "# TYPE places_prefetch_skipped_total counter\nplaces_prefetch_skipped_total " + std::to_string(m_prefetchSkipped.load()) + "\n";
+    res.body() += "# TYPE places_local_entries gauge\nplaces_local_entries " + std::to_string(m_local.size()) + "\n";
+    res.body() += "# TYPE places_local_hits_total counter\nplaces_local_hits_total " + std::to_string(m_localHits.load()) + "\n";
+    res.body() += "# TYPE places_local_misses_total counter\nplaces_local_misses_total " + std::to_string(m_localMisses.load()) + "\n";
+    res.body() += "# TYPE places_autocomplete_requests_total counter\nplaces_autocomplete_requests_total " + std::to_string(m_autocompleteRequests.load()) + "\n";
+    const PhotoRenditions::Metrics photos = m_photos.metrics();
+    res.body() += "# TYPE places_photo_fetches_total counter\nplaces_photo_fetches_total " + std::to_string(m_photoFetches.load()) + "\n";
+    res.body() += "# TYPE places_photo_disk_hits_total counter\nplaces_photo_disk_hits_total " + std::to_string(photos.disk_hits) + "\n";
+    res.body() += "# TYPE places_photo_rendered_total counter\nplaces_photo_rendered_total " + std::to_string(photos.rendered) + "\n";
+    res.body() += "# TYPE places_photo_fallbacks_total counter\nplaces_photo_fallbacks_total " + std::to_string(photos.fallbacks) + "\n";
+    res.body() += "# TYPE places_photo_evicted_total counter\nplaces_photo_evicted_total " + std::to_string(photos.evicted) + "\n";
+    res.body() += "# TYPE places_photo_disk_bytes gauge\nplaces_photo_disk_bytes " + std::to_string(photos.disk_bytes) + "\n";
+    res.prepare_payload();
+    return res;
+}
+
+json::value PlacesApiHandler::callGooglePlacesApi(
     http::verb method, // HTTP 메서드 파라미터 추가
     const std::string& endpoint, 
-    const json::value& requestData) {
+    const json::value& requestData,
+    const std::string& fieldMask) {
     
     try {
         // 디버그 로그 주석 처리 (I/O 부하 감소)
@@ -339,7 +1101,7 @@ json::value PlacesApiHandler::requestGooglePlacesApi(
             // handlePlaceDetails에서 이미 fields 파라미터로 지정하므로 X-Goog-FieldMask 헤더는 설정하지 않음
             // req.set("X-Goog-FieldMask", "id,displayName,formattedAddress,location");
         } else { ///< Nearby Search, Text Search (POST)
-            req.set("X-Goog-FieldMask", "places.id,places.displayName,places.formattedAddress,places.location");
+            req.set("X-Goog-FieldMask", fieldMask.empty() ? std::string(kProjections[0].searchFieldMask) : fieldMask);
         }
         
         // POST 요청일 때만 본문 설정
@@ -483,6 +1245,19 @@ json::value PlacesApiHandler::requestGooglePlacesApi(
                      location["lng"] = 127.0276;
                  }
                  transformed_place["loc"] = location;
+
+                 // 아래 필드는 projection이 요청한 경우에만 응답에 있다
+                 if (const json::value* rating = place.as_object().if_contains("rating")) {
+                     transformed_place["rating"] = *rating;
+                 }
+                 if (const json::value* count = place.as_object().if_contains("userRatingCount")) {
+                     transformed_place["ratingCount"] = *count;
+                 }
+                 if (const json::value* photos = place.as_object().if_contains("photos");
+                     photos != nullptr && photos->is_array() && !photos->as_array().empty() &&
+                     photos->as_array()[0].is_object() && photos->as_array()[0].as_object().contains("name")) {
+                     transformed_place["photo"] = photos->as_array()[0].at("name");
+                 }
                  
                  transformed_places.push_back(transformed_place);
              }
@@ -520,12 +1295,21 @@ http::response<http::string_body> PlacesApiHandler::createErrorResponse(
 }
 
 http::response<http::string_body> PlacesApiHandler::handlePlacePhoto(
-    const std::string& photo_reference) {
+    const std::string& photo_reference,
+    const std::string& size,
+    const std::string& format,
+    const std::string& if_none_match) {
     
+    const std::optional<int> width = PhotoRenditions::widthFor(size);
+    if (!width) {
+        return this->createErrorResponse(http::status::bad_request, "Unknown photo size: " + size);
+    }
+    const std::optional<PhotoRenditions::Format> photo_format = PhotoRenditions::parseFormat(format);
+    if (!photo_format) {
+        return this->createErrorResponse(http::status::bad_request, "Unknown photo format: " + format);
+    }
+
     try {
-        // 디버그 로그 주석 처리 (I/O 부하 감소)
-        // std::cout << "handlePlacePhoto 호출됨, photo_reference: " << photo_reference << std::endl;
-        
         // Google Places API v1 형식의 photo reference 처리
         // 형식: places/ChIJXyQvMaRtZjURAln5cV-8xL4/photos/AXQCQNTelAdECPdcBwjlBRkJ0hUmnWUg...
         std::string actual_photo_reference = photo_reference;
@@ -535,142 +1319,25 @@ http::response<http::string_body> PlacesApiHandler::handlePlacePhoto(
         if (photos_pos != std::string::npos) {
             // "/photos/" 이후의 부분만 추출
             actual_photo_reference = photo_reference.substr(photos_pos + 8);
-            // 디버그 로그 주석 처리 (I/O 부하 감소)
-            // std::cout << "추출된 photo reference: " << actual_photo_reference << std::endl;
         }
-        
-        // Google Places Photo API URL 구성
-        std::string api_url = "https://maps.googleapis.com/maps/api/place/photo";
-        api_url += "?maxwidth=1600"; // 최대 너비 설정
-        api_url += "&photoreference=" + actual_photo_reference;
-        api_url += "&key=" + m_apiKey;
-        
-        // SSL 컨텍스트 및 IO 컨텍스트 설정
-        net::io_context ioc;
-        ssl::context ctx(ssl::context::tlsv12_client);
-        ctx.set_default_verify_paths();
-        
-        // HTTPS 연결 설정
-        tcp::resolver resolver(ioc);
-        ssl::stream<tcp::socket> stream(ioc, ctx);
-        
-        // 호스트 이름 추출
-        std::string host = "maps.googleapis.com";
-        auto const results = resolver.resolve(host, "443");
-        
-        // 연결 설정
-        net::connect(stream.next_layer(), results.begin(), results.end());
-        stream.handshake(ssl::stream_base::client);
-        
-        // HTTP 요청 준비
-        http::request<http::string_body> req{http::verb::get, api_url, 11};
-        req.set(http::field::host, host);
-        req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-        req.prepare_payload();
-        
-        // 요청 전송
-        http::write(stream, req);
-        
-        // 응답 수신 (이미지 데이터를 위해 dynamic_body 사용)
-        beast::flat_buffer buffer;
-        http::response<http::dynamic_body> res;
-        http::read(stream, buffer, res);
-        
-        // 연결 종료
-        beast::error_code ec;
-        stream.shutdown(ec);
-        if(ec == net::error::eof || ec == ssl::error::stream_truncated) {
-            ec = {}; // 정상적인 종료로 간주
+
+        // 1. 디스크에 만들어 둔 사본
+        if (auto photo = m_photos.lookup(actual_photo_reference, *width, *photo_format)) {
+            return this->createPhotoResponse(*photo, if_none_match);
         }
-        
-        // 정상 응답 로그 주석 처리 (I/O 부하 감소)
-        // std::cout << "Google API 응답 코드: " << res.result_int() << std::endl;
-        // std::cout << "응답 내용 일부: " << (res.body().length() > 100 ? res.body().substr(0, 100) + "..." : res.body()) << std::endl;
 
-        // 302 리다이렉트 처리
-        if (res.result_int() == 302) {
-            // Location 헤더에서 리다이렉트 URL 추출
-            auto location = res.find(http::field::location);
-            if (location != res.end()) {
-                std::string redirect_url = std::string(location->value());
-                // 디버그 로그 주석 처리 (I/O 부하 감소)
-                // std::cout << "리다이렉트 URL: " << redirect_url << std::endl;
-                
-                // 리다이렉트 URL 파싱
-                // URL 형식: https://lh3.googleusercontent.com/...
-                size_t host_start = redirect_url.find("://") + 3;
-                size_t path_start = redirect_url.find("/", host_start);
-                
-                std::string redirect_host = redirect_url.substr(host_start, path_start - host_start);
-                std::string redirect_path = redirect_url.substr(path_start);
-                
-                // 새로운 연결로 리다이렉트된 URL에 접속
-                tcp::resolver redirect_resolver(ioc);
-                ssl::stream<tcp::socket> redirect_stream(ioc, ctx);
-                
-                auto const redirect_results = redirect_resolver.resolve(redirect_host, "443");
-                net::connect(redirect_stream.next_layer(), redirect_results.begin(), redirect_results.end());
-                redirect_stream.handshake(ssl::stream_base::client);
-                
-                // 리다이렉트 요청
-                http::request<http::string_body> redirect_req{http::verb::get, redirect_path, 11};
-                redirect_req.set(http::field::host, redirect_host);
-                redirect_req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-                redirect_req.prepare_payload();
-                
-                http::write(redirect_stream, redirect_req);
-                
-                // 실제 이미지 응답 수신
-                beast::flat_buffer redirect_buffer;
-                http::response<http::dynamic_body> redirect_res;
-                http::read(redirect_stream, redirect_buffer, redirect_res);
-                
-                // 연결 종료
-                beast::error_code redirect_ec;
-                redirect_stream.shutdown(redirect_ec);
-                if(redirect_ec == net::error::eof || redirect_ec == ssl::error::stream_truncated) {
-                    redirect_ec = {};
-                }
-                
-                // 리다이렉트된 응답 사용
-                res = std::move(redirect_res);
+        // 2. 디스크(또는 메모리)의 원본, 없으면 Google에서 원본을 받아 둔다.
+        std::optional<PhotoRenditions::Original> original = m_photos.original(actual_photo_reference);
+        if (!original) {
+            PhotoFetch fetched = this->loadPhotoOriginal(actual_photo_reference);
+            if (!fetched.original) {
+                return std::move(fetched.error);
             }
+            original = std::move(fetched.original);
         }
-        
-        // 오류 상태 확인
-        if (res.result_int() < 200 || res.result_int() >= 300) {
-            // 오류 응답을 그대로 전달
-            http::response<http::string_body> error_res{res.result(), 11};
-            error_res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            error_res.set(http::field::content_type, "text/plain");
-            error_res.set(http::field::access_control_allow_origin, "*");
-            error_res.set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
-            error_res.set(http::field::access_control_allow_headers, "Content-Type, Authorization, Accept");
-            
-            // dynamic_body를 string으로 변환
-            error_res.body() = beast::buffers_to_string(res.body().data());
-            error_res.prepare_payload();
-            return error_res;
-        }
-        
-        // 성공 응답 생성 (이미지 데이터)
-        http::response<http::string_body> img_res{http::status::ok, 11};
-        img_res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        
-        // Content-Type 헤더 복사 (이미지 타입 유지)
-        if(res.count(http::field::content_type) > 0) {
-            img_res.set(http::field::content_type, res[http::field::content_type]);
-        } else {
-            img_res.set(http::field::content_type, "image/jpeg"); // 기본값
-        }
-        
-        // CORS 헤더는 HttpServer에서 중앙 관리하므로 여기서는 설정하지 않음
-        
-        // 이미지 데이터를 string으로 변환하여 저장
-        img_res.body() = beast::buffers_to_string(res.body().data());
-        img_res.prepare_payload();
-        
-        return img_res;
+
+        // 3. 작업 스레드에서 사본을 만든다. (큐가 가득 차면 원본)
+        return this->createPhotoResponse(m_photos.render(*original, *width, *photo_format), if_none_match);
     }
     catch (const std::exception& e) {
         std::cerr << "Error in handlePlacePhoto: " << e.what() << std::endl;
@@ -679,3 +1346,215 @@ http::response<http::string_body> PlacesApiHandler::handlePlacePhoto(
     }
 }
 
+PlacesApiHandler::PhotoFetch PlacesApiHandler::loadPhotoOriginal(const std::string& photo_reference) {
+    std::unique_lock<std::mutex> lock(m_photoFetchMutex);
+    if (auto it = m_photoFetchesInFlight.find(photo_reference); it != m_photoFetchesInFlight.end()) {
+        std::shared_future<PhotoFetch> pending = it->second;
+        lock.unlock();
+        return pending.get();
+    }
+    // 잠금을 잡기 전에 앞선 받기가 끝나 원본을 넣었을 수 있다.
+    if (auto original = m_photos.original(photo_reference)) {
+        return PhotoFetch{std::move(original), {}};
+    }
+    std::promise<PhotoFetch> promise;
+    m_photoFetchesInFlight.emplace(photo_reference, promise.get_future().share());
+    lock.unlock();
+
+    PhotoFetch result;
+    try {
+        auto upstream = this->fetchPhotoOriginal(photo_reference);
+        if (upstream.result() == http::status::ok) {
+            ++m_photoFetches;
+            std::string content_type(upstream[http::field::content_type]);
+            result.original = m_photos.storeOriginal(photo_reference, std::move(upstream.body()), std::move(content_type));
+        } else {
+            result.error = std::move(upstream);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error in loadPhotoOriginal: " << e.what() << std::endl;
+        result.error = this->createErrorResponse(http::status::internal_server_error,
+                                                 std::string("Error fetching place photo: ") + e.what());
+    }
+
+    lock.lock();
+    m_photoFetchesInFlight.erase(photo_reference);
+    lock.unlock();
+    promise.set_value(result);
+    return result;
+}
+
+http::response<http::string_body> PlacesApiHandler::createPhotoResponse(
+    const PhotoRenditions::Photo& photo,
+    const std::string& if_none_match) {
+    
+    // 사본은 내용 해시로 이름 붙였으므로 ETag가 같으면 내용도 같다.
+    const bool not_modified = !photo.fallback && !if_none_match.empty() &&
+                              if_none_match.find(photo.etag) != std::string::npos;
+    http::response<http::string_body> res{not_modified ? http::status::not_modified : http::status::ok, 11};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::etag, photo.etag);
+    // 사본 대신 보낸 원본은 다음 요청에 사본으로 바뀌므로 클라이언트/프록시가 저장하지 않게 한다.
+    res.set(http::field::cache_control, photo.fallback ? "no-store" : "public, max-age=86400");
+    if (!not_modified) {
+        res.set(http::field::content_type, photo.content_type);
+        res.body() = photo.bytes;
+    }
+    res.prepare_payload();
+    return res;
+}
+
+http::response<http::string_body> PlacesApiHandler::fetchPhotoOriginal(
+    const std::string& photo_reference) {
+    // Google Places Photo API URL 구성 (가장 큰 크기 등급으로 한 번만 받고 작은 사본은 서버에서 만든다)
+    std::string api_url = "https://maps.googleapis.com/maps/api/place/photo";
+    api_url += "?maxwidth=1600"; // 최대 너비 설정
+    api_url += "&photoreference=" + photo_reference;
+    api_url += "&key=" + m_apiKey;
+
+    // 업스트림 상태가 나쁘면 연결을 열지 않고 바로 503으로 답한다.
+    UpstreamGuard::Permit permit = m_guard.tryAcquire();
+    if (!permit.admitted()) {
+        auto busy = this->createErrorResponse(http::status::service_unavailable,
+                                              "Google Places API is temporarily unavailable");
+        busy.set(http::field::retry_after, "1");
+        return busy;
+    }
+    struct PermitRelease {
+        UpstreamGuard& guard;
+        const UpstreamGuard::Permit& permit;
+        int status_code = 0;   ///< 예외로 빠져나가면 연결 오류(0)로 기록
+        ~PermitRelease() { guard.release(permit, UpstreamGuard::classify(status_code)); }
+    } permit_release{m_guard, permit};
+    
+    // SSL 컨텍스트 및 IO 컨텍스트 설정
+    net::io_context ioc;
+    ssl::context ctx(ssl::context::tlsv12_client);
+    ctx.set_default_verify_paths();
+    
+    // HTTPS 연결 설정
+    tcp::resolver resolver(ioc);
+    ssl::stream<tcp::socket> stream(ioc, ctx);
+    
+    // 호스트 이름 추출
+    std::string host = "maps.googleapis.com";
+    auto const results = resolver.resolve(host, "443");
+    
+    // 연결 설정
+    net::connect(stream.next_layer(), results.begin(), results.end());
+    stream.handshake(ssl::stream_base::client);
+    
+    // HTTP 요청 준비
+    http::request<http::string_body> req{http::verb::get, api_url, 11};
+    req.set(http::field::host, host);
+    req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    req.prepare_payload();
+    
+    // 요청 전송
+    http::write(stream, req);
+    
+    // 응답 수신 (이미지 데이터를 위해 dynamic_body 사용)
+    beast::flat_buffer buffer;
+    http::response<http::dynamic_body> res;
+    http::read(stream, buffer, res);
+    
+    // 연결 종료
+    beast::error_code ec;
+    stream.shutdown(ec);
+    if(ec == net::error::eof || ec == ssl::error::stream_truncated) {
+        ec = {}; // 정상적인 종료로 간주
+    }
+    
+    // 정상 응답 로그 주석 처리 (I/O 부하 감소)
+    // std::cout << "Google API 응답 코드: " << res.result_int() << std::endl;
+    // std::cout << "응답 내용 일부: " << (res.body().length() > 100 ? res.body().substr(0, 100) + "..." : res.body()) << std::endl;
+
+    // 302 리다이렉트 처리
+    if (res.result_int() == 302) {
+        // Location 헤더에서 리다이렉트 URL 추출
+        auto location = res.find(http::field::location);
+        if (location != res.end()) {
+            std::string redirect_url = std::string(location->value());
+            // 디버그 로그 주석 처리 (I/O 부하 감소)
+            // std::cout << "리다이렉트 URL: " << redirect_url << std::endl;
+            
+            // 리다이렉트 URL 파싱
+            // URL 형식: https://lh3.googleusercontent.com/...
+            size_t host_start = redirect_url.find("://") + 3;
+            size_t path_start = redirect_url.find("/", host_start);
+            
+            std::string redirect_host = redirect_url.substr(host_start, path_start - host_start);
+            std::string redirect_path = redirect_url.substr(path_start);
+            
+            // 새로운 연결로 리다이렉트된 URL에 접속
+            tcp::resolver redirect_resolver(ioc);
+            ssl::stream<tcp::socket> redirect_stream(ioc, ctx);
+            
+            auto const redirect_results = redirect_resolver.resolve(redirect_host, "443");
+            net::connect(redirect_stream.next_layer(), redirect_results.begin(), redirect_results.end());
+            redirect_stream.handshake(ssl::stream_base::client);
+            
+            // 리다이렉트 요청
+            http::request<http::string_body> redirect_req{http::verb::get, redirect_path, 11};
+            redirect_req.set(http::field::host, redirect_host);
+            redirect_req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+            redirect_req.prepare_payload();
+            
+            http::write(redirect_stream, redirect_req);
+            
+            // 실제 이미지 응답 수신
+            beast::flat_buffer redirect_buffer;
+            http::response<http::dynamic_body> redirect_res;
+            http::read(redirect_stream, redirect_buffer, redirect_res);
+            
+            // 연결 종료
+            beast::error_code redirect_ec;
+            redirect_stream.shutdown(redirect_ec);
+            if(redirect_ec == net::error::eof || redirect_ec == ssl::error::stream_truncated) {
+                redirect_ec = {};
+            }
+            
+            // 리다이렉트된 응답 사용
+            res = std::move(redirect_res);
+        }
+    }
+    
+    permit_release.status_code = static_cast<int>(res.result_int());
+
+    // 오류 상태 확인
+    if (res.result_int() < 200 || res.result_int() >= 300) {
+        // 오류 응답을 그대로 전달
+        http::response<http::string_body> error_res{res.result(), 11};
+        error_res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        error_res.set(http::field::content_type, "text/plain");
+        error_res.set(http::field::access_control_allow_origin, "*");
+        error_res.set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
+        error_res.set(http::field::access_control_allow_headers, "Content-Type, Authorization, Accept");
+        
+        // dynamic_body를 string으로 변환
+        error_res.body() = beast::buffers_to_string(res.body().data());
+        error_res.prepare_payload();
+        return error_res;
+    }
+    
+    // 성공 응답 생성 (이미지 데이터)
+    http::response<http::string_body> img_res{http::status::ok, 11};
+    img_res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    
+    // Content-Type 헤더 복사 (이미지 타입 유지)
+    if(res.count(http::field::content_type) > 0) {
+        img_res.set(http::field::content_type, res[http::field::content_type]);
+    } else {
+        img_res.set(http::field::content_type, "image/jpeg"); // 기본값
+    }
+    
+    // CORS 헤더는 HttpServer에서 중앙 관리하므로 여기서는 설정하지 않음
+    
+    // 이미지 데이터를 string으로 변환하여 저장
+    img_res.body() = beast::buffers_to_string(res.body().data());
+    img_res.prepare_payload();
+    
+    return img_res;
+}
+
@@ -0,0 +1,208 @@
+#include "../include/handlers/PlacesCache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+PlacesCache::PlacesCache(PlacesCacheConfig config)
+    : m_config(std::move(config)) {
+    m_config.max_entries = std::max<std::size_t>(m_config.max_entries, 1);
+    m_config.hard_ttl = std::max(m_config.hard_ttl, m_config.soft_ttl);
+    if (!m_config.snapshot_path.empty()) {
+        load();
+        if (m_config.snapshot_interval.count() > 0) {
+            m_snapshotThread = std::thread(&PlacesCache::snapshotLoop, this);
+        }
+    }
+}
+
+PlacesCache::~PlacesCache() {
+    stop();
+    save();
+}
+
+PlacesCache::Lookup PlacesCache::lookup(const std::string& key) const {
+    Lookup result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return result;
+    }
+    result.age = std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - it->second.stored);
+    if (result.age < m_config.soft_ttl) {
+        result.state = State::Fresh;
+    } else if (result.age < m_config.hard_ttl) {
+        result.state = State::Stale;
+    } else {
+        result.state = State::Expired;
+    }
+    result.data = it->second.data;
+    return result;
+}
+
+void PlacesCache::put(const std::string& key, json::value data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[key] = Entry{std::move(data), Clock::now()};
+    evictLocked();
+}
+
+bool PlacesCache::beginRefresh(const std::string& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_refreshing.insert(key).second;
+}
+
+void PlacesCache::endRefresh(const std::string& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_refreshing.erase(key);
+}
+
+std::size_t PlacesCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void PlacesCache::forEach(
+    const std::function<void(const std::string&, const json::value&, Clock::time_point)>& fn) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [key, entry] : m_entries) {
+        fn(key, entry.data, entry.stored);
+    }
+}
+
+void PlacesCache::evictLocked() {
+    if (m_entries.size() <= m_config.max_entries) {
+        return;
+    }
+    std::vector<std::pair<Clock::time_point, std::string>> by_age;
+    by_age.reserve(m_entries.size());
+    for (const auto& [key, entry] : m_entries) {
+        by_age.emplace_back(entry.stored, key);
+    }
+    std::size_t drop = m_entries.size() - m_config.max_entries + m_config.max_entries / 10;
+    drop = std::min(drop, by_age.size());
+    std::nth_element(by_age.begin(), by_age.begin() + (drop - 1), by_age.end());
+    for (std::size_t i = 0; i < drop; ++i) {
+        m_entries.erase(by_age[i].second);
+    }
+}
+
+/**
+ * @details 한 줄에 항목 하나씩 `{"k": 키, "t": 저장 시각(epoch ms), "v": 응답}` 형식의 JSON을 쓴다.
+ * 깨진 줄은 건너뛰므로 저장 도중 종료되어도 나머지 항목은 살린다.
+ */
+bool PlacesCache::load() {
+    std::ifstream in(m_config.snapshot_path);
+    if (!in) {
+        return false;
+    }
+    auto now = Clock::now();
+    std::size_t loaded = 0;
+    std::size_t skipped = 0;
+    std::unordered_map<std::string, Entry> entries;
+    std::string line;
+    while (std::getline(in, line)) {
+        boost::system::error_code ec;
+        json::value row = json::parse(line, ec);
+        if (ec || !row.is_object()) {
+            ++skipped;
+            continue;
+        }
+        const json::object& obj = row.as_object();
+        const json::value* key = obj.if_contains("k");
+        const json::value* stored_ms = obj.if_contains("t");
+        const json::value* data = obj.if_contains("v");
+        if (!key || !key->is_string() || !stored_ms || !stored_ms->is_int64() || !data) {
+            ++skipped;
+            continue;
+        }
+        Clock::time_point stored{std::chrono::milliseconds(stored_ms->as_int64())};
+        if (now - stored >= m_config.hard_ttl) {
+            continue;
+        }
+        entries[key->as_string().c_str()] = Entry{*data, stored};
+        ++loaded;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& [key, entry] : entries) {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end() || it->second.stored < entry.stored) {
+            m_entries[key] = std::move(entry);
+        }
+    }
+    evictLocked();
+    std::cout << "[PlacesCache] Loaded " << loaded << " entries from " << m_config.snapshot_path
+              << " (skipped " << skipped << " malformed lines)" << std::endl;
+    return true;
+}
+
+bool PlacesCache::save() const {
+    if (m_config.snapshot_path.empty()) {
+        return false;
+    }
+    std::vector<std::pair<std::string, Entry>> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.reserve(m_entries.size());
+        for (const auto& [key, entry] : m_entries) {
+            entries.emplace_back(key, entry);
+        }
+    }
+
+    std::filesystem::path path(m_config.snapshot_path);
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    std::error_code fs_ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), fs_ec);
+    }
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            std::cerr << "[PlacesCache] Cannot open snapshot file: " << tmp << std::endl;
+            return false;
+        }
+        for (const auto& [key, entry] : entries) {
+            json::object row;
+            row["k"] = key;
+            row["t"] = static_cast<std::int64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(entry.stored.time_since_epoch()).count());
+            row["v"] = entry.data;
+            out << json::serialize(row) << '\n';
+        }
+        out.flush();
+        if (!out) {
+            std::cerr << "[PlacesCache] Failed to write snapshot file: " << tmp << std::endl;
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, fs_ec);
+    if (fs_ec) {
+        std::cerr << "[PlacesCache] Failed to replace snapshot file: " << fs_ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PlacesCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_stopped = true;
+    }
+    m_snapshotCv.notify_all();
+    if (m_snapshotThread.joinable()) {
+        m_snapshotThread.join();
+    }
+}
+
+void PlacesCache::snapshotLoop() {
+    std::unique_lock<std::mutex> lock(m_snapshotMutex);
+    while (!m_snapshotCv.wait_for(lock, m_config.snapshot_interval, [this]() { return m_stopped; })) {
+        lock.unlock();
+        save();
+        lock.lock();
+    }
+}
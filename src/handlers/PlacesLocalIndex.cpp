@@ -0,0 +1,482 @@
+#include "../include/handlers/PlacesLocalIndex.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+
+namespace bgi = boost::geometry::index;
+
+namespace {
+    constexpr double kEarthRadiusMeters = 6371000.0;
+    constexpr double kMetersPerDegree = 111320.0;
+    constexpr double kPi = 3.14159265358979323846;
+
+    double toRadians(double degrees) { return degrees * kPi / 180.0; }
+
+    /// UTF-8 문자 하나의 바이트 수. 잘못된 바이트는 1로 본다.
+    std::size_t codePointLength(const std::string& text, std::size_t pos) {
+        unsigned char c = static_cast<unsigned char>(text[pos]);
+        std::size_t length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 1;
+        return pos + length <= text.size() ? length : 1;
+    }
+
+    /// `word`가 `prefix`로 시작하는지
+    bool startsWith(const std::string& word, const std::string& prefix) {
+        return word.size() >= prefix.size() && word.compare(0, prefix.size(), prefix) == 0;
+    }
+}
+
+PlacesLocalIndex::PlacesLocalIndex(PlacesLocalIndexConfig config)
+    : m_config(std::move(config)) {
+    m_config.max_places = std::max<std::size_t>(m_config.max_places, 1);
+}
+
+void PlacesLocalIndex::upsert(Place place) {
+    if (place.id.empty()) {
+        return;
+    }
+    if (place.seen == Clock::time_point{}) {
+        place.seen = Clock::now();
+    }
+    std::unique_lock lock(m_mutex);
+    auto it = m_byId.find(place.id);
+    if (it != m_byId.end()) {
+        std::uint32_t slot = it->second;
+        Place& old = m_slots[slot].place;
+        ++m_slots[slot].seen_count;
+        place.seen = std::max(place.seen, old.seen);
+        place.from_nearby = place.from_nearby || old.from_nearby;
+        if (!place.detailed && old.detailed) {
+            // 요약 응답으로 다시 보았을 뿐이면 이전에 받은 평점/사진을 유지한다.
+            place.rating = old.rating;
+            place.rating_count = old.rating_count;
+            place.photo = old.photo;
+            place.detailed = true;
+        }
+        if (old.latitude != place.latitude || old.longitude != place.longitude) {
+            m_points.remove(PointValue(Point(old.longitude, old.latitude), slot));
+            m_points.insert(PointValue(Point(place.longitude, place.latitude), slot));
+        }
+        bool text_changed = old.name != place.name || old.address != place.address;
+        old = std::move(place);
+        if (text_changed) {
+            m_stalePostings += m_slots[slot].postings;
+            removeTermsLocked(slot);
+            indexLocked(slot);
+            compactPostingsLocked();
+        }
+        return;
+    }
+
+    std::uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+    m_points.insert(PointValue(Point(place.longitude, place.latitude), slot));
+    m_byId.emplace(place.id, slot);
+    m_slots[slot].place = std::move(place);
+    m_slots[slot].live = true;
+    m_slots[slot].seen_count = 1;
+    indexLocked(slot);
+    evictLocked();
+}
+
+void PlacesLocalIndex::markCovered(double latitude, double longitude, double radius_m) {
+    if (radius_m <= 0) {
+        return;
+    }
+    auto now = Clock::now();
+    std::unique_lock lock(m_mutex);
+    auto index = static_cast<std::uint32_t>(m_areas.size());
+    m_areas.push_back(Area{latitude, longitude, radius_m, now});
+    m_areaTree.insert(AreaValue(boxAround(latitude, longitude, radius_m), index));
+    if (m_areas.size() >= m_areaCompactAt) {
+        compactAreasLocked(now);
+    }
+}
+
+std::optional<std::vector<PlacesLocalIndex::Hit>> PlacesLocalIndex::nearby(
+    double latitude, double longitude, double radius_m, std::size_t limit, bool detailed) const {
+
+    if (m_config.max_age.count() <= 0 || limit == 0) {
+        return std::nullopt;
+    }
+    auto now = Clock::now();
+    std::shared_lock lock(m_mutex);
+
+    std::vector<Hit> hits;
+    for (auto it = m_points.qbegin(bgi::intersects(boxAround(latitude, longitude, radius_m)));
+         it != m_points.qend(); ++it) {
+        const Slot& slot = m_slots[it->second];
+        if (!slot.live || !slot.place.from_nearby || !isFresh(slot.place.seen, now)) {
+            continue;
+        }
+        double distance = distanceMeters(latitude, longitude, slot.place.latitude, slot.place.longitude);
+        if (distance <= radius_m) {
+            hits.push_back(Hit{slot.place, distance});
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.distance_m < b.distance_m; });
+    if (hits.size() > limit) {
+        hits.resize(limit);
+    }
+    if (detailed && std::any_of(hits.begin(), hits.end(), [](const Hit& hit) { return !hit.place.detailed; })) {
+        return std::nullopt;
+    }
+
+    // 결과가 한도에 닿았으면 마지막 결과까지만, 아니면 반경 전체를 빠짐없이 알고 있어야 한다.
+    double reach = hits.size() == limit ? hits.back().distance_m : radius_m;
+    if (!coveredLocked(latitude, longitude, reach, now)) {
+        return std::nullopt;
+    }
+    return hits;
+}
+
+std::optional<std::vector<PlacesLocalIndex::Hit>> PlacesLocalIndex::search(
+    const std::string& query, std::optional<std::pair<double, double>> center, double radius_m,
+    std::size_t limit, bool detailed) const {
+
+    if (m_config.max_age.count() <= 0 || limit == 0) {
+        return std::nullopt;
+    }
+    std::vector<std::string> tokens = words(query);
+    if (tokens.empty()) {
+        return std::nullopt;
+    }
+    auto now = Clock::now();
+    std::shared_lock lock(m_mutex);
+
+    // 가장 짧은 3-gram 목록만 후보로 삼고, 나머지 조건은 후보마다 직접 확인한다.
+    const std::vector<std::uint32_t>* shortest = nullptr;
+    for (const auto& token : tokens) {
+        for (const auto& gram : trigrams(token)) {
+            auto it = m_postings.find(gram);
+            if (it == m_postings.end()) {
+                return std::nullopt;
+            }
+            if (shortest == nullptr || it->second.size() < shortest->size()) {
+                shortest = &it->second;
+            }
+        }
+    }
+    std::vector<std::uint32_t> candidates(shortest->begin(), shortest->end());
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::pair<std::size_t, Hit>> ranked; // (이름에서 찾은 검색어 단어 수, 결과)
+    for (std::uint32_t index : candidates) {
+        const Slot& slot = m_slots[index];
+        if (!slot.live || !isFresh(slot.place.seen, now) || (detailed && !slot.place.detailed)) {
+            continue;
+        }
+        double distance = 0;
+        if (center) {
+            distance = distanceMeters(center->first, center->second, slot.place.latitude, slot.place.longitude);
+            if (radius_m > 0 && distance > radius_m) {
+                continue;
+            }
+        }
+        std::size_t name_matches = 0;
+        bool all = true;
+        for (const auto& token : tokens) {
+            auto match = std::find_if(slot.words.begin(), slot.words.end(),
+                                      [&token](const std::string& word) { return startsWith(word, token); });
+            if (match == slot.words.end()) {
+                all = false;
+                break;
+            }
+            if (static_cast<std::size_t>(match - slot.words.begin()) < slot.name_words) {
+                ++name_matches;
+            }
+        }
+        if (all) {
+            ranked.emplace_back(name_matches, Hit{slot.place, distance});
+        }
+    }
+    if (ranked.size() < std::max<std::size_t>(m_config.min_text_results, 1)) {
+        return std::nullopt;
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) {
+            return a.first > b.first;
+        }
+        return a.second.distance_m < b.second.distance_m;
+    });
+    std::vector<Hit> hits;
+    for (std::size_t i = 0; i < ranked.size() && i < limit; ++i) {
+        hits.push_back(std::move(ranked[i].second));
+    }
+    return hits;
+}
+
+std::vector<PlacesLocalIndex::Hit> PlacesLocalIndex::autocomplete(
+    const std::string& input, std::optional<std::pair<double, double>> center, std::size_t limit) const {
+
+    std::vector<std::string> tokens = words(input);
+    if (tokens.empty() || limit == 0) {
+        return {};
+    }
+    const std::string& last = tokens.back();
+    std::shared_lock lock(m_mutex);
+
+    // 마지막 단어로 시작하는 단어 구간만 훑는다.
+    std::vector<std::uint32_t> candidates;
+    for (auto it = m_terms.lower_bound(last);
+         it != m_terms.end() && startsWith(it->first, last) && candidates.size() < AUTOCOMPLETE_SCAN_LIMIT; ++it) {
+        candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<Hit> hits;
+    for (std::uint32_t index : candidates) {
+        const Slot& slot = m_slots[index];
+        if (!slot.live) {
+            continue;
+        }
+        std::size_t name_matches = 0;
+        bool all = true;
+        for (const auto& token : tokens) {
+            auto match = std::find_if(slot.words.begin(), slot.words.end(),
+                                      [&token](const std::string& word) { return startsWith(word, token); });
+            if (match == slot.words.end()) {
+                all = false;
+                break;
+            }
+            if (static_cast<std::size_t>(match - slot.words.begin()) < slot.name_words) {
+                ++name_matches;
+            }
+        }
+        if (!all) {
+            continue;
+        }
+        Hit hit{slot.place, 0, static_cast<double>(name_matches) / static_cast<double>(tokens.size())};
+        if (center) {
+            hit.distance_m = distanceMeters(center->first, center->second, slot.place.latitude, slot.place.longitude);
+            hit.score += 1.0 / (1.0 + hit.distance_m / 1000.0);
+        }
+        double reviews = static_cast<double>(slot.place.rating_count.value_or(0));
+        hit.score += 0.5 * std::min(1.0, std::log10(1.0 + std::max(0.0, reviews)) / 4.0);      // 리뷰 1만 개에서 최대
+        hit.score += 0.5 * std::min(1.0, std::log10(1.0 + slot.seen_count) / 2.0);             // 100번 본 장소에서 최대
+        hits.push_back(std::move(hit));
+    }
+
+    std::size_t keep = std::min(limit, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(keep), hits.end(),
+                      [](const Hit& a, const Hit& b) { return a.score > b.score; });
+    hits.resize(keep);
+    return hits;
+}
+
+std::size_t PlacesLocalIndex::size() const {
+    std::shared_lock lock(m_mutex);
+    return m_byId.size();
+}
+
+double PlacesLocalIndex::distanceMeters(double lat1, double lng1, double lat2, double lng2) {
+    double dlat = toRadians(lat2 - lat1);
+    double dlng = toRadians(lng2 - lng1);
+    double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+               std::cos(toRadians(lat1)) * std::cos(toRadians(lat2)) * std::sin(dlng / 2) * std::sin(dlng / 2);
+    return 2 * kEarthRadiusMeters * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+std::vector<std::string> PlacesLocalIndex::words(const std::string& text) {
+    std::vector<std::string> result;
+    std::string current;
+    for (std::size_t pos = 0; pos < text.size();) {
+        std::size_t length = codePointLength(text, pos);
+        unsigned char c = static_cast<unsigned char>(text[pos]);
+        bool word_char = c >= 0x80 ? text.compare(pos, length, "\xE3\x80\x80") != 0 // 전각 공백 제외
+                                   : std::isalnum(c) != 0;
+        if (word_char) {
+            if (length == 1) {
+                current.push_back(static_cast<char>(std::tolower(c)));
+            } else {
+                current.append(text, pos, length);
+            }
+        } else if (!current.empty()) {
+            result.push_back(std::move(current));
+            current.clear();
+        }
+        pos += length;
+    }
+    if (!current.empty()) {
+        result.push_back(std::move(current));
+    }
+    return result;
+}
+
+bool PlacesLocalIndex::isFresh(Clock::time_point seen, Clock::time_point now) const {
+    return now - seen < m_config.max_age;
+}
+
+bool PlacesLocalIndex::coveredLocked(double latitude, double longitude, double reach_m, Clock::time_point now) const {
+    constexpr double kToleranceMeters = 1.0; // 좌표 반올림(소수점 6자리) 오차
+    for (auto it = m_areaTree.qbegin(bgi::intersects(Point(longitude, latitude))); it != m_areaTree.qend(); ++it) {
+        const Area& area = m_areas[it->second];
+        if (!isFresh(area.seen, now)) {
+            continue;
+        }
+        double offset = distanceMeters(latitude, longitude, area.latitude, area.longitude);
+        if (offset + reach_m <= area.radius_m + kToleranceMeters) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PlacesLocalIndex::indexLocked(std::uint32_t slot) {
+    Slot& entry = m_slots[slot];
+    entry.words = words(entry.place.name);
+    entry.name_words = entry.words.size();
+    for (auto& word : words(entry.place.address)) {
+        entry.words.push_back(std::move(word));
+    }
+    for (const auto& word : entry.words) {
+        auto& slots = m_terms[word];
+        if (slots.empty() || slots.back() != slot) {
+            slots.push_back(slot);
+        }
+    }
+    postTrigramsLocked(slot);
+}
+
+void PlacesLocalIndex::postTrigramsLocked(std::uint32_t slot) {
+    Slot& entry = m_slots[slot];
+    entry.postings = 0;
+    for (const auto& word : entry.words) {
+        for (auto& gram : trigrams(word)) {
+            m_postings[std::move(gram)].push_back(slot);
+            ++entry.postings;
+        }
+    }
+    m_postingCount += entry.postings;
+}
+
+void PlacesLocalIndex::removeTermsLocked(std::uint32_t slot) {
+    for (const auto& word : m_slots[slot].words) {
+        auto it = m_terms.find(word);
+        if (it == m_terms.end()) {
+            continue;
+        }
+        auto& slots = it->second;
+        slots.erase(std::remove(slots.begin(), slots.end(), slot), slots.end());
+        if (slots.empty()) {
+            m_terms.erase(it);
+        }
+    }
+}
+
+void PlacesLocalIndex::removeLocked(std::uint32_t slot) {
+    Slot& entry = m_slots[slot];
+    m_points.remove(PointValue(Point(entry.place.longitude, entry.place.latitude), slot));
+    m_byId.erase(entry.place.id);
+    m_stalePostings += entry.postings;
+    removeTermsLocked(slot);
+    entry = Slot{};
+    m_freeSlots.push_back(slot);
+}
+
+void PlacesLocalIndex::evictLocked() {
+    if (m_byId.size() <= m_config.max_places) {
+        return;
+    }
+    std::vector<std::pair<Clock::time_point, std::uint32_t>> by_age;
+    by_age.reserve(m_byId.size());
+    for (const auto& [id, slot] : m_byId) {
+        by_age.emplace_back(m_slots[slot].place.seen, slot);
+    }
+    std::size_t drop = m_byId.size() - m_config.max_places + m_config.max_places / 10;
+    drop = std::min(drop, by_age.size());
+    std::nth_element(by_age.begin(), by_age.begin() + (drop - 1), by_age.end());
+    // 버린 장소가 들어 있던 커버된 영역은 더 이상 빠짐없는 답을 줄 수 없으므로 함께 버린다.
+    std::vector<bool> stale_areas(m_areas.size(), false);
+    bool any_stale = false;
+    for (std::size_t i = 0; i < drop; ++i) {
+        const Place& evicted = m_slots[by_age[i].second].place;
+        for (auto it = m_areaTree.qbegin(bgi::intersects(Point(evicted.longitude, evicted.latitude)));
+             it != m_areaTree.qend(); ++it) {
+            stale_areas[it->second] = true;
+            any_stale = true;
+        }
+        removeLocked(by_age[i].second);
+    }
+    compactPostingsLocked();
+    if (any_stale) {
+        std::vector<Area> kept;
+        kept.reserve(m_areas.size());
+        for (std::size_t i = 0; i < m_areas.size(); ++i) {
+            if (!stale_areas[i]) {
+                kept.push_back(m_areas[i]);
+            }
+        }
+        rebuildAreasLocked(std::move(kept));
+    }
+}
+
+void PlacesLocalIndex::compactPostingsLocked() {
+    if (m_stalePostings < 4096 || m_stalePostings * 2 < m_postingCount) {
+        return;
+    }
+    m_postings.clear();
+    m_postingCount = 0;
+    m_stalePostings = 0;
+    for (std::uint32_t slot = 0; slot < m_slots.size(); ++slot) {
+        if (m_slots[slot].live) {
+            postTrigramsLocked(slot);
+        }
+    }
+}
+
+void PlacesLocalIndex::compactAreasLocked(Clock::time_point now) {
+    std::vector<Area> kept;
+    kept.reserve(m_areas.size());
+    for (const auto& area : m_areas) {
+        if (isFresh(area.seen, now)) {
+            kept.push_back(area);
+        }
+    }
+    // 모두 신선한데도 많으면 오래된 절반을 버린다. (`m_areas`는 기록 순서이므로 앞쪽이 오래됨)
+    if (kept.size() > m_config.max_places) {
+        kept.erase(kept.begin(), kept.begin() + static_cast<std::ptrdiff_t>(kept.size() / 2));
+    }
+    rebuildAreasLocked(std::move(kept));
+}
+
+void PlacesLocalIndex::rebuildAreasLocked(std::vector<Area> kept) {
+    std::vector<AreaValue> values;
+    values.reserve(kept.size());
+    for (std::uint32_t i = 0; i < kept.size(); ++i) {
+        values.emplace_back(boxAround(kept[i].latitude, kept[i].longitude, kept[i].radius_m), i);
+    }
+    m_areas = std::move(kept);
+    m_areaTree = decltype(m_areaTree)(values.begin(), values.end()); // packing으로 한 번에 만든다
+    m_areaCompactAt = std::max<std::size_t>(1024, m_areas.size() * 2);
+}
+
+std::vector<std::string> PlacesLocalIndex::trigrams(const std::string& word) {
+    std::vector<std::string> chars{" ", " "};
+    for (std::size_t pos = 0; pos < word.size();) {
+        std::size_t length = codePointLength(word, pos);
+        chars.push_back(word.substr(pos, length));
+        pos += length;
+    }
+    std::vector<std::string> result;
+    result.reserve(chars.size() - 2);
+    for (std::size_t i = 0; i + 2 < chars.size(); ++i) {
+        result.push_back(chars[i] + chars[i + 1] + chars[i + 2]);
+    }
+    return result;
+}
+
+PlacesLocalIndex::Box PlacesLocalIndex::boxAround(double latitude, double longitude, double radius_m) {
+    double dlat = radius_m / kMetersPerDegree;
+    double dlng = radius_m / (kMetersPerDegree * std::max(0.01, std::cos(toRadians(latitude))));
+    return Box(Point(longitude - dlng, latitude - dlat), Point(longitude + dlng, latitude + dlat));
+}
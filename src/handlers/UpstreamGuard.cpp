@@ -0,0 +1,202 @@
+#include "../include/handlers/UpstreamGuard.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+UpstreamGuard::UpstreamGuard(UpstreamGuardConfig config)
+    : m_config(config) {
+    m_config.min_limit = std::max<std::size_t>(m_config.min_limit, 1);
+    m_config.max_limit = std::max(m_config.max_limit, m_config.min_limit);
+    m_config.window_size = std::max<std::size_t>(m_config.window_size, 1);
+    m_limit = static_cast<double>(std::clamp(m_config.initial_limit, m_config.min_limit, m_config.max_limit));
+    m_window.reserve(m_config.window_size);
+}
+
+UpstreamGuard::Permit UpstreamGuard::tryAcquire(double max_utilization) {
+    return acquire(std::chrono::milliseconds(0), max_utilization);
+}
+
+UpstreamGuard::Permit UpstreamGuard::acquire(std::chrono::milliseconds max_wait, double max_utilization) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto deadline = Clock::now() + max_wait;
+    Permit permit = admit(Clock::now(), max_utilization);
+    while (permit.admission == Admission::Overloaded && Clock::now() < deadline) {
+        m_released.wait_until(lock, deadline);
+        permit = admit(Clock::now(), max_utilization);
+    }
+    if (permit.admission == Admission::Overloaded)
+        ++m_counters.rejected_overload;
+    else if (permit.admission == Admission::CircuitOpen)
+        ++m_counters.rejected_open;
+    return permit;
+}
+
+UpstreamGuard::Permit UpstreamGuard::admit(Clock::time_point now, double max_utilization) {
+    Permit permit;
+    bool background = max_utilization < 1.0;
+
+    if (m_state != CircuitState::Closed && background) {
+        permit.admission = Admission::CircuitOpen;
+        return permit;
+    }
+    if (m_state != CircuitState::Closed) {
+        // 열린 서킷은 open_duration이 지나면 시험 호출 하나만 통과시킨다.
+        if (m_probeInFlight || now - m_openedAt < m_config.open_duration) {
+            permit.admission = Admission::CircuitOpen;
+            return permit;
+        }
+        m_state = CircuitState::HalfOpen;
+        m_probeInFlight = true;
+        permit.probe = true;
+    }
+    else if (static_cast<double>(m_inFlight) >= std::floor(m_limit * std::clamp(max_utilization, 0.0, 1.0))) {
+        permit.admission = Admission::Overloaded;
+        return permit;
+    }
+
+    ++m_inFlight;
+    ++m_counters.admitted;
+    permit.admission = Admission::Admitted;
+    permit.started = now;
+    return permit;
+}
+
+void UpstreamGuard::release(const Permit& permit, Outcome outcome) {
+    if (!permit.admitted())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_released.notify_all(); // 깨어난 호출은 이 잠금이 풀린 뒤 바뀐 한도로 다시 판단한다
+    auto now = Clock::now();
+    if (m_inFlight > 0)
+        --m_inFlight;
+    if (permit.probe)
+        m_probeInFlight = false;
+    if (outcome == Outcome::Ignored)
+        return;
+
+    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(now - permit.started);
+    bool failed = outcome == Outcome::Failure;
+    bool congested = failed || latency > m_config.latency_target;
+
+    if (failed) {
+        ++m_counters.failures;
+    }
+    else {
+        ++m_counters.successes;
+        double sample = static_cast<double>(latency.count());
+        m_latencyEwmaMs = m_latencyEwmaMs == 0 ? sample : m_latencyEwmaMs * 0.9 + sample * 0.1;
+    }
+
+    // AIMD: 혼잡하면 한 번에 절반으로, 아니면 한도만큼 성공할 때마다 1씩 늘린다.
+    // 이미 진행 중이던 호출들이 한꺼번에 실패해도 한 번만 줄이도록 latency_target 간격을 둔다.
+    if (congested) {
+        if (now - m_lastDecrease >= m_config.latency_target) {
+            m_limit = std::max(m_limit * m_config.backoff_ratio, static_cast<double>(m_config.min_limit));
+            m_lastDecrease = now;
+        }
+    }
+    else {
+        m_limit = std::min(m_limit + 1.0 / m_limit, static_cast<double>(m_config.max_limit));
+    }
+
+    if (permit.probe) {
+        if (failed) {
+            openCircuit(now);
+        }
+        else {
+            std::cout << "[UpstreamGuard] Circuit closed after successful probe" << std::endl;
+            m_state = CircuitState::Closed;
+            m_window.clear();
+            m_windowNext = 0;
+            m_windowFailures = 0;
+        }
+        return;
+    }
+
+    record(failed);
+    if (m_state == CircuitState::Closed && m_window.size() >= m_config.min_calls &&
+        errorRate() >= m_config.failure_threshold) {
+        openCircuit(now);
+    }
+}
+
+UpstreamGuard::Outcome UpstreamGuard::classify(int status_code) {
+    if (status_code >= 200 && status_code < 300)
+        return Outcome::Success;
+    if (status_code == 0 || status_code == 429 || status_code >= 500)
+        return Outcome::Failure;
+    return Outcome::Ignored;
+}
+
+void UpstreamGuard::openCircuit(Clock::time_point now) {
+    if (m_state != CircuitState::Open) {
+        ++m_counters.circuit_opens;
+        std::cerr << "[UpstreamGuard] Circuit opened (error rate " << errorRate() << ", limit " << m_limit << ")" << std::endl;
+    }
+    m_state = CircuitState::Open;
+    m_openedAt = now;
+}
+
+void UpstreamGuard::record(bool failed) {
+    if (m_window.size() < m_config.window_size) {
+        m_window.push_back(failed);
+    }
+    else {
+        if (m_window[m_windowNext])
+            --m_windowFailures;
+        m_window[m_windowNext] = failed;
+    }
+    if (failed)
+        ++m_windowFailures;
+    m_windowNext = (m_windowNext + 1) % m_config.window_size;
+}
+
+double UpstreamGuard::errorRate() const {
+    return m_window.empty() ? 0.0 : static_cast<double>(m_windowFailures) / static_cast<double>(m_window.size());
+}
+
+UpstreamGuard::Metrics UpstreamGuard::metrics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Metrics result = m_counters;
+    result.limit = m_limit;
+    result.in_flight = m_inFlight;
+    result.state = m_state;
+    result.error_rate = errorRate();
+    result.latency_ewma_ms = m_latencyEwmaMs;
+    return result;
+}
+
+std::string UpstreamGuard::metricsText(const std::string& prefix) const {
+    Metrics m = metrics();
+    std::ostringstream out;
+    auto gauge = [&](const char* name, double value) {
+        out << "# TYPE " << prefix << name << " gauge\n" << prefix << name << ' ' << value << '\n';
+    };
+    auto counter = [&](const char* name, std::uint64_t value) {
+        out << "# TYPE " << prefix << name << " counter\n" << prefix << name << ' ' << value << '\n';
+    };
+    gauge("concurrency_limit", m.limit);
+    gauge("in_flight", static_cast<double>(m.in_flight));
+    gauge("circuit_open", m.state == CircuitState::Closed ? 0 : 1);
+    gauge("error_rate", m.error_rate);
+    gauge("latency_ewma_ms", m.latency_ewma_ms);
+    counter("admitted_total", m.admitted);
+    counter("rejected_overload_total", m.rejected_overload);
+    counter("rejected_circuit_open_total", m.rejected_open);
+    counter("success_total", m.successes);
+    counter("failure_total", m.failures);
+    counter("circuit_opens_total", m.circuit_opens);
+    return out.str();
+}
+
+const char* UpstreamGuard::toString(CircuitState state) {
+    switch (state) {
+    case CircuitState::Closed: return "closed";
+    case CircuitState::Open: return "open";
+    case CircuitState::HalfOpen: return "half_open";
+    }
+    return "unknown";
+}
@@ -14,6 +14,8 @@
 #include <atomic>                  // std::atomic_bool
 #include <memory>                  // std::unique_ptr, std::make_shared
 #include <system_error>            // std::system_error (예외 처리)
+#include <algorithm>               // std::max, std::clamp
+#include <chrono>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -24,6 +26,9 @@
 // --- 추가된 include ---
 #include "../include/ChatServer.hpp"         // ChatServer 추가
 #include "../include/WebSocketListener.hpp"  // WebSocket Listener 추가
+#include "../include/cluster/SocketBus.hpp"  // 클러스터 버스 (SocketBus, BusBroker)
+#include "../include/cluster/HistoryReplication.hpp" // 히스토리 복제 (HistoryReplicator)
+#include "../include/ListenerHandoff.hpp"    // 무중단 재시작 (리스닝 소켓 인계)
 
 // --- 네임스페이스 별칭 ---
 // Boost.Asio와 Beast를 더 간결하게 사용하기 위함
@@ -36,6 +41,8 @@ namespace beast = boost::beast;
  *
  * 환경 변수에서 설정을 읽어 HTTP 서버와 Chat 서버를 생성하고 실행한다.
  * POSIX 시그널(SIGINT, SIGTERM)을 처리하여 서버의 정상 종료(graceful shutdown)를 지원한다.
+ * `CHAT_HANDOFF_PATH`가 설정되면 실행 중인 이전 프로세스로부터 리스닝 소켓을 넘겨받아 시작하고,
+ * 다음 프로세스가 시작되면 소켓을 넘겨준 뒤 기존 연결을 나누어 종료(drain)한다. (무중단 재시작)
  * Windows 환경에서는 콘솔 입출력 인코딩을 UTF-8로 설정하려고 시도한다.
  */
 
@@ -173,41 +180,155 @@ int main(int argc, char* argv[]) {
         std::string http_bind_ip = get_env_var("HTTP_BIND_IP", "0.0.0.0");
         int http_threads = get_int_env_var("HTTP_THREADS", 1); 
         unsigned short ws_port = get_required_port_env_var("WS_PORT", 33334);  // WebSocket 포트
+        // 클러스터 설정: CHAT_CLUSTER_BUS가 비어 있으면 단일 노드로 동작
+        std::string cluster_bus_uri = get_env_var("CHAT_CLUSTER_BUS", "");          // 예: tcp://10.0.0.5:7000, unix:///tmp/chat-bus.sock
+        std::string bus_broker_listen = get_env_var("CHAT_BUS_BROKER_LISTEN", "");  // 이 노드에서 브로커를 함께 띄울 주소
+        std::string node_id = get_env_var("CHAT_NODE_ID", "node-" + std::to_string(ws_port));
+        // 무중단 재시작 설정: CHAT_HANDOFF_PATH가 비어 있으면 사용하지 않음
+        std::string handoff_path = get_env_var("CHAT_HANDOFF_PATH", "");         // 예: /run/cherry/handoff.sock (이전/새 컨테이너가 공유하는 볼륨)
+        int drain_seconds = get_int_env_var("CHAT_DRAIN_SECONDS", 30);            // 인계 후 기존 연결을 나누어 닫는 시간
+        int resume_grace_seconds = get_int_env_var("CHAT_RESUME_GRACE_SECONDS", 60); // 끊긴 세션을 /resume으로 복원할 수 있는 시간 (0이면 사용 안 함)
+        std::string file_spill_dir = get_env_var("CHAT_FILE_SPILL_DIR", "");     // 느린 수신자 대신 파일 조각을 쌓아 둘 디렉터리 (비어 있으면 송신자 읽기를 멈춤)
+        int file_stall_seconds = get_int_env_var("CHAT_FILE_STALL_SECONDS", 30);  // 송신자 읽기를 멈춘 뒤 수신자가 진행하지 않으면 전송을 실패시키는 시간 (0이면 사용 안 함)
+        // 히스토리 보존 설정: 기간/크기가 모두 0이면 정리하지 않고 작은 블록 병합만 수행
+        int retention_days = get_int_env_var("CHAT_HISTORY_RETENTION_DAYS", 0);       // 이보다 오래된 기록 정리 (채널 공통)
+        int history_max_mb = get_int_env_var("CHAT_HISTORY_MAX_MB", 0);               // 채널별 저장 크기 상한
+        std::string retention_overrides = get_env_var("CHAT_HISTORY_RETENTION", "");  // 예: rooms/lobby=7d,private=90d:200mb
+        std::string history_archive_dir = get_env_var("CHAT_HISTORY_ARCHIVE_DIR", ""); // 정리한 기록을 압축해 옮길 디렉터리 (비어 있으면 삭제)
+        int maintenance_minutes = get_int_env_var("CHAT_HISTORY_MAINTENANCE_MINUTES", 60); // 정리 주기 (0이면 사용 안 함)
+        int maintenance_io_kbps = get_int_env_var("CHAT_HISTORY_IO_KBPS", 4096);      // 정리 작업의 디스크 읽기+쓰기 상한 (KB/s, 0이면 제한 없음)
+        // 히스토리 복제 설정: CHAT_HISTORY_FOLLOWER가 비어 있으면 복제하지 않음
+        std::string history_follower = get_env_var("CHAT_HISTORY_FOLLOWER", "");     // 예: tcp://10.0.0.6:7100, unix:///run/cherry/history.sock
+        int follower_reads = get_int_env_var("CHAT_HISTORY_FOLLOWER_READS", 1);       // 1이면 스크롤백/검색을 팔로워에서 읽음
+        std::string users_path = get_env_var("CHAT_USERS_PATH", "users/accounts");  // 계정 저장 경로 접두사 (.snapshot, .log), 비어 있으면 메모리에만 보관
+        int auth_threads = get_int_env_var("CHAT_AUTH_THREADS", 2);                 // 비밀번호 해시 전용 스레드 수
+        int auth_queue = get_int_env_var("CHAT_AUTH_QUEUE", 256);                   // 대기할 수 있는 로그인/등록 요청 수 (넘으면 바로 거절)
+        int auth_scrypt_log2n = get_int_env_var("CHAT_AUTH_SCRYPT_LOG2N", 15);      // 새 비밀번호의 scrypt 비용 N = 2^값 (15: 약 32MB)
+        int login_token_ttl = get_int_env_var("CHAT_LOGIN_TOKEN_TTL_SECONDS", 600); // 재로그인 토큰 유효 기간 (0이면 발급 안 함)
 
 
+        // 이전 프로세스가 실행 중이면 리스닝 소켓을 넘겨받는다 (포트를 다시 바인딩하지 않으므로 연결 수락이 끊기지 않음)
+        HandoffClient handoff_client;
+        bool inherited = !handoff_path.empty() && handoff_client.request(handoff_path);
+        HandoffSocket inherited_ws = handoff_client.take("ws");
+        HandoffSocket inherited_http = handoff_client.take("http");
+        // 인계를 확정하고 이전 프로세스가 계정/히스토리 저장소를 닫을 때까지 기다린 뒤에 저장소를 연다.
+        // 그사이 들어온 연결은 넘겨받은 리스닝 소켓의 backlog에서 기다린다.
+        if (inherited) {
+            if (handoff_client.confirm()) {
+                fprintf(stdout, "Took over listening sockets and storage from previous process.\n");
+            } else {
+                fprintf(stderr, "Warning: Previous process did not release its storage. Opening it may fail.\n");
+            }
+        }
+
         // --- 서버 객체 생성 (로컬 스마트 포인터 사용) ---
         auto http_server = std::make_unique<HttpServer>(http_bind_ip, http_port, http_threads);
         auto chat_server = std::make_shared<ChatServer>(ioc, ws_port);  // ChatServer를 여러 WebSocket 리스너가 공유
+        chat_server->set_resume_grace_period(std::chrono::seconds(std::max(resume_grace_seconds, 0)));
+        chat_server->set_file_spill_dir(file_spill_dir);
+        chat_server->set_file_stall_timeout(std::chrono::seconds(std::max(file_stall_seconds, 0)));
+        chat_server->set_users_path(users_path);
+        chat_server->load_users();
+        {
+            KdfParams kdf;
+            kdf.log2_n = std::clamp(auth_scrypt_log2n, 10, 20);
+            chat_server->set_password_hashing(static_cast<std::size_t>(std::max(auth_threads, 1)),
+                                              static_cast<std::size_t>(std::max(auth_queue, 1)), kdf);
+            chat_server->set_login_token_ttl(std::chrono::seconds(std::max(login_token_ttl, 0)));
+        }
+        {
+            RetentionConfig retention;
+            retention.defaults.max_age = std::chrono::hours(24) * std::max(retention_days, 0);
+            retention.defaults.max_bytes = static_cast<std::uint64_t>(std::max(history_max_mb, 0)) << 20;
+            if (!retention.parse_overrides(retention_overrides))
+                fprintf(stderr, "Warning: Ignoring malformed entries in CHAT_HISTORY_RETENTION: '%s'\n", retention_overrides.c_str());
+            retention.archive_dir = history_archive_dir;
+            retention.interval = std::chrono::minutes(std::max(maintenance_minutes, 0));
+            retention.io_bytes_per_second = static_cast<std::uint64_t>(std::max(maintenance_io_kbps, 0)) * 1024;
+            chat_server->set_history_retention(retention);
+        }
+        if (!history_follower.empty()) {
+            chat_server->enable_history_replication(std::make_shared<HistoryReplicator>(ioc, history_follower), follower_reads != 0);
+        }
         std::shared_ptr<WebSocketListener> ws_listener; // ws_listener를 미리 선언
+        std::shared_ptr<BusBroker> bus_broker;
+
+        // 클러스터 모드 설정 (브로커는 클러스터 내 한 노드에서만 띄우면 됨)
+        if (!bus_broker_listen.empty()) {
+            bus_broker = std::make_shared<BusBroker>(ioc, bus_broker_listen);
+            bus_broker->run();
+        }
+        if (!cluster_bus_uri.empty()) {
+            chat_server->enable_cluster(std::make_shared<SocketBus>(ioc, cluster_bus_uri), node_id);
+            fprintf(stdout, "Cluster mode enabled: node '%s', bus '%s'\n", node_id.c_str(), cluster_bus_uri.c_str());
+        }
 
         // WS 리스너 생성 (비보안 WebSocket)
         fprintf(stdout, "Attempting to create WS listener...\n");
-        ws_listener = std::make_shared<WebSocketListener>(
-            ioc,
-            net::ip::tcp::endpoint{net::ip::make_address("0.0.0.0"), ws_port},
-            chat_server
-        );
+        if (inherited_ws.fd >= 0) {
+            ws_listener = std::make_shared<WebSocketListener>(
+                ioc,
+                inherited_ws.ipv6 ? net::ip::tcp::v6() : net::ip::tcp::v4(),
+                inherited_ws.fd,
+                chat_server
+            );
+        } else {
+            ws_listener = std::make_shared<WebSocketListener>(
+                ioc,
+                net::ip::tcp::endpoint{net::ip::make_address("0.0.0.0"), ws_port},
+                chat_server
+            );
+        }
         fprintf(stdout, "WS listener created successfully.\n");
-        
+        if (inherited_http.fd >= 0) {
+            http_server->adopt_listener(inherited_http.ipv6 ? net::ip::tcp::v6() : net::ip::tcp::v4(), inherited_http.fd);
+        }
+
+        // --- 종료 처리 (시그널 또는 인계 후 drain 완료 시, 한 번만 실행) ---
+        std::atomic<bool> shutting_down{false};
+        std::atomic<bool> handed_off{false};
+        auto shutdown = [&ioc, &http_server, &chat_server, &bus_broker, &shutting_down]() {
+            if (shutting_down.exchange(true)) {
+                return;
+            }
+            // 각 서버의 stop() 메서드 호출 (람다 캡처 사용)
+            if (http_server) {
+                fprintf(stdout, "Requesting HTTP server stop...\n");
+                http_server->stop();
+            }
+            if (chat_server) {
+                fprintf(stdout, "Requesting Chat server stop...\n");
+                chat_server->stop();
+            }
+            if (bus_broker) {
+                bus_broker->stop();
+            }
+
+            // 공유 io_context 중지 요청
+            fprintf(stdout, "Requesting shared io_context stop...\n");
+            ioc.stop(); 
+        };
+#ifndef _WIN32
+        std::shared_ptr<HandoffServer> handoff_server;
+#endif
+
         // --- signal_set 핸들러 설정 (서버 객체 생성 후) ---
         signals.async_wait(
-            [&ioc, &http_server, &chat_server, &ws_listener]
-            (const beast::error_code& ec, int signal_number) {
-                fprintf(stdout, "\nSignal %d received. Shutting down...\n", signal_number);
-
-                // 각 서버의 stop() 메서드 호출 (람다 캡처 사용)
-                if (http_server) {
-                    fprintf(stdout, "Requesting HTTP server stop...\n");
-                    http_server->stop();
+            [&](const beast::error_code& ec, int signal_number) {
+                if (handed_off) {
+                    // 이미 새 프로세스에 인계하고 drain 중이면 남은 연결을 한꺼번에 끊지 않고 drain 완료 후 종료한다
+                    fprintf(stdout, "\nSignal %d received during drain. Exiting when drain completes...\n", signal_number);
+                    return;
                 }
-                if (chat_server) {
-                    fprintf(stdout, "Requesting Chat server stop...\n");
-                    chat_server->stop();
+                fprintf(stdout, "\nSignal %d received. Shutting down...\n", signal_number);
+#ifndef _WIN32
+                // 인계 없이 종료하는 경우에만 소켓 경로를 지운다
+                if (handoff_server) {
+                    handoff_server->stop(true);
                 }
-
-                // 공유 io_context 중지 요청
-                fprintf(stdout, "Requesting shared io_context stop...\n");
-                ioc.stop(); 
+#endif
+                shutdown();
             });
         // --- 시그널 설정 끝 ---
         
@@ -218,6 +339,33 @@ int main(int argc, char* argv[]) {
             fprintf(stdout, "Running WS listener...\n");
             ws_listener->run();
         }
+#ifndef _WIN32
+        // 다음 배포 때 새 프로세스에 리스닝 소켓을 넘겨주기 위해 대기
+        if (!handoff_path.empty()) {
+            handoff_server = std::make_shared<HandoffServer>(ioc, handoff_path,
+                [&http_server, &ws_listener]() {
+                    std::vector<HandoffSocket> sockets;
+                    sockets.push_back(HandoffSocket{"ws", static_cast<int>(ws_listener->native_handle()),
+                                                    ws_listener->local_endpoint().address().is_v6()});
+                    bool http_ipv6 = false;
+                    int http_fd = http_server->listener_native_handle(http_ipv6);
+                    sockets.push_back(HandoffSocket{"http", http_fd, http_ipv6});
+                    return sockets;
+                },
+                [&http_server, &ws_listener, &chat_server, &shutdown, &handed_off, drain_seconds]() {
+                    // 새 프로세스가 같은 소켓으로 연결을 받으므로 이 프로세스는 수락을 멈추고 기존 연결을 나누어 닫는다.
+                    // 저장소는 새 프로세스가 열 수 있도록 drain 전에 닫는다. (이 함수가 돌아온 뒤 새 프로세스에 알린다)
+                    handed_off = true;
+                    fprintf(stdout, "Handed off listening sockets. Draining connections over %d seconds...\n", drain_seconds);
+                    ws_listener->stop();
+                    http_server->stop_accepting();
+                    chat_server->release_storage();
+                    chat_server->drain(std::chrono::seconds(std::max(drain_seconds, 0)), shutdown);
+                });
+            handoff_server->run();
+        }
+#endif
+
         fprintf(stdout, "HTTP server starting on %s:%hu (%d threads)\n", http_bind_ip.c_str(), http_port, http_threads);
         fprintf(stdout, "WebSocket (WS) server starting on port %hu (using shared io_context)\n", ws_port);
         fprintf(stdout, "\n[알림] SSL/TLS는 nginx 또는 AWS ALB에서 처리합니다.\n");
@@ -0,0 +1,70 @@
+#include "../../include/MessageHistory.hpp"
+#include "../../include/cluster/HistoryReplication.hpp"
+#include "spdlog/spdlog.h"
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file HistoryFollower.cpp
+ * @brief 채팅 서버의 히스토리를 복제받아 스크롤백/검색 질의에 답하는 팔로워 프로세스 (`CherryRecorder-HistoryFollower`).
+ *
+ * 사용법: `CherryRecorder-HistoryFollower <리슨 주소> [히스토리 디렉터리] [스레드 수]`
+ * (예: `CherryRecorder-HistoryFollower tcp://0.0.0.0:7100 /data/history-replica 4`)
+ * 리더 서버는 `CHAT_HISTORY_FOLLOWER`에 이 주소를 지정합니다. 처음 시작할 때는 리더의 히스토리 디렉터리를 복사해 두면
+ * 그 뒤의 기록만 복제로 받습니다. 적용 위치는 `<히스토리 디렉터리>/replication.state`에 저장합니다.
+ * 질의는 여러 스레드에서 동시에 처리합니다.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <listen-uri> [history-dir] [threads]\n", argv[0]);
+        return 1;
+    }
+    std::string listen_uri = argv[1];
+    std::string history_dir = argc > 2 ? argv[2] : "history";
+    int threads = argc > 3 ? std::max(1, std::atoi(argv[3])) : 2;
+
+    MessageHistory history(history_dir);
+    if (!history.is_enabled()) {
+        std::fprintf(stderr, "Failed to open history directory: %s\n", history_dir.c_str());
+        return 1;
+    }
+
+    net::io_context ioc;
+    std::shared_ptr<HistoryFollower> follower;
+    try {
+        follower = std::make_shared<HistoryFollower>(ioc, listen_uri, history, history_dir + "/replication.state");
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Failed to listen on %s: %s\n", listen_uri.c_str(), e.what());
+        return 1;
+    }
+    follower->run();
+
+    net::signal_set signals(ioc, SIGINT, SIGTERM);
+    signals.async_wait([&](const boost::system::error_code&, int signal) {
+        spdlog::info("Signal {} received. Stopping history follower.", signal);
+        follower->stop();
+        ioc.stop();
+    });
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back([&ioc]() { ioc.run(); });
+    }
+    ioc.run();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    history.flush_search_index();
+    return 0;
+}
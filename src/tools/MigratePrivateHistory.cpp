@@ -0,0 +1,32 @@
+#include "../../include/MessageHistory.hpp"
+#include "spdlog/spdlog.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+/**
+ * @file MigratePrivateHistory.cpp
+ * @brief 대화별 개인 메시지 파일을 `private/messages.log` 저장소로 가져오는 도구 (`CherryRecorder-MigratePM`).
+ *
+ * 사용법: `CherryRecorder-MigratePM [히스토리 디렉터리]` (기본값 `history`)
+ * 서버를 새 버전으로 시작하기 전에 한 번 실행한다. 가져온 파일은 `private/migrated/`로 옮겨지므로
+ * 확인한 뒤 지워도 되고, 다시 실행해도 중복되지 않는다.
+ */
+int main(int argc, char* argv[])
+{
+    std::string history_dir = argc > 1 ? argv[1] : "history";
+    if (!std::filesystem::is_directory(history_dir + "/private")) {
+        std::fprintf(stderr, "No private history directory: %s/private\n", history_dir.c_str());
+        return 1;
+    }
+
+    MessageHistory history(history_dir);
+    if (!history.is_enabled()) {
+        std::fprintf(stderr, "Failed to open history directory: %s\n", history_dir.c_str());
+        return 1;
+    }
+    std::size_t migrated = history.migrate_private_files();
+    std::printf("Imported %zu conversation(s) into %s/private/messages.log\n", migrated, history_dir.c_str());
+    return 0;
+}
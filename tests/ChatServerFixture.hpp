@@ -0,0 +1,91 @@
+/**
+ * @file ChatServerFixture.hpp
+ * @brief 네트워크 리스너 없이 `ChatServer` 하나를 io 스레드 두 개로 돌리는 공용 테스트 픽스처.
+ * @details 서버 설정은 `configure`를 재정의해 바꾸고, 테스트마다 설정 값이 다르면 `SetUp`을 비워 두고
+ *          테스트 본문에서 `start_server`를 부른다.
+ */
+#pragma once
+
+#include "../include/ChatServer.hpp"
+#include "FakeSession.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ChatServerFixture
+ * @brief `<name>_<pid>` 임시 히스토리 디렉터리를 쓰는 `ChatServer`를 시작하고, 끝나면 멈추고 지우는 픽스처.
+ */
+class ChatServerFixture : public ::testing::Test {
+protected:
+    /// @param name 임시 히스토리 디렉터리와 설정 파일 이름에 쓰는 테스트 이름.
+    explicit ChatServerFixture(std::string name) : name_(std::move(name)) {}
+
+    /// 서버를 만든 직후, io 스레드를 시작하기 전에 호출된다. 설정을 바꾸려면 재정의한다.
+    virtual void configure(ChatServer&) {}
+
+    void SetUp() override { start_server(); }
+
+    void TearDown() override { stop_server(); }
+
+    void start_server() {
+        history_.emplace(name_ + "_history");
+        history_dir_ = history_->path;
+        work_guard_.emplace(ioc_.get_executor());
+        server_ = std::make_shared<ChatServer>(ioc_, 0, name_ + ".cfg", history_dir_);
+        configure(*server_);
+        for (int i = 0; i < 2; ++i) {
+            threads_.emplace_back([this]() { ioc_.run(); });
+        }
+    }
+
+    /**
+     * @details 정해진 시간만큼 자는 대신, 작업 보증을 풀고 `stop`이 올린 정리 작업이 모두 끝나 io_context가
+     *          스스로 멈출 때까지 기다린다. 남은 타이머 때문에 끝나지 않으면 5초 뒤 강제로 멈춘다.
+     */
+    void stop_server() {
+        if (!server_) {
+            return;
+        }
+        server_->stop();
+        work_guard_.reset();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!ioc_.stopped() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_TRUE(ioc_.stopped()) << "io_context still had work 5s after ChatServer::stop()";
+        ioc_.stop();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) thread.join();
+        }
+        threads_.clear();
+        history_.reset();
+    }
+
+    /// 닉네임을 등록하고 결과를 기다린다. (세션의 닉네임은 바꾸지 않는다)
+    bool register_nickname(const std::shared_ptr<FakeSession>& session, const std::string& nickname) {
+        std::promise<bool> result;
+        server_->try_register_nickname_async(nickname, session, [&result](bool ok) { result.set_value(ok); });
+        return result.get_future().get();
+    }
+
+    net::io_context ioc_;
+    std::shared_ptr<ChatServer> server_;
+    std::string history_dir_;
+
+private:
+    std::string name_;
+    std::optional<TempDir> history_;
+    std::optional<net::executor_work_guard<net::io_context::executor_type>> work_guard_;
+    std::vector<std::thread> threads_;
+};
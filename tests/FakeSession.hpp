@@ -0,0 +1,129 @@
+/**
+ * @file FakeSession.hpp
+ * @brief 네트워크 연결 없이 `ChatServer` 로직을 검증하기 위한 테스트용 세션.
+ * @details `deliver`로 전달된 메시지를 기록만 하며, 테스트에서 특정 메시지가 도착할 때까지 기다릴 수 있다.
+ */
+#pragma once
+
+#include "../include/SessionInterface.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class FakeSession
+ * @brief 전달된 메시지를 메모리에 기록하는 `SessionInterface` 구현체.
+ */
+class FakeSession : public SessionInterface, public std::enable_shared_from_this<FakeSession> {
+public:
+    FakeSession(net::io_context& ioc, const std::string& nickname)
+        : strand_(net::make_strand(net::any_io_executor(ioc.get_executor()))),
+          nickname_(nickname),
+          remote_id_("fake:" + nickname) {}
+
+    void deliver(const std::string& msg) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        received_.push_back(msg);
+        cv_.notify_all();
+    }
+
+    /// 바이너리 프레임은 기록만 하고, `ack_binary`를 호출할 때까지 전송이 끝나지 않은 것으로 둔다.
+    bool deliver_binary(std::shared_ptr<const std::string> frame, std::function<void()> on_sent) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        binary_.push_back(frame);
+        unacked_.push_back(std::move(on_sent));
+        cv_.notify_all();
+        return true;
+    }
+
+    void stop_session() override { stopped_ = true; }
+    const std::string& nickname() const override { return nickname_; }
+    const std::string& remote_id() const override { return remote_id_; }
+    net::strand<net::any_io_executor>& get_strand() override { return strand_; }
+    bool is_authenticated() const override { return authenticated_; }
+    void set_nickname(const std::string& nick) override { nickname_ = nick; }
+    void set_authenticated(bool auth) override { authenticated_ = auth; }
+    const std::string& current_room() const override { return current_room_; }
+    void set_current_room(const std::string& room_name) override { current_room_ = room_name; }
+    std::shared_ptr<SessionInterface> shared_from_this() override {
+        return std::enable_shared_from_this<FakeSession>::shared_from_this();
+    }
+
+    /**
+     * @brief `needle`을 포함하는 메시지가 도착할 때까지 기다린다.
+     * @return 제한 시간 안에 도착하면 true.
+     */
+    bool wait_for(const std::string& needle, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [&]() { return contains_locked(needle); });
+    }
+
+    /// 지금까지 받은 메시지 중 `needle`을 포함하는 메시지 수
+    size_t count(const std::string& needle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<size_t>(std::count_if(received_.begin(), received_.end(),
+            [&](const std::string& m) { return m.find(needle) != std::string::npos; }));
+    }
+
+    std::vector<std::string> received() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_;
+    }
+
+    bool stopped() const { return stopped_; }
+
+    /// 지금까지 받은 바이너리 프레임
+    /// 바이너리 프레임을 `count`개 이상 받을 때까지 최대 `timeout` 동안 기다린다.
+    bool wait_for_binary(size_t count, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [&]() { return binary_.size() >= count; });
+    }
+
+    std::vector<std::shared_ptr<const std::string>> binary() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return binary_;
+    }
+
+    /// 전송이 끝나지 않은 바이너리 프레임을 모두 보낸 것으로 처리하고 그 수를 돌려준다.
+    size_t ack_binary() {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callbacks.swap(unacked_);
+        }
+        for (auto& callback : callbacks) {
+            callback();
+        }
+        return callbacks.size();
+    }
+
+private:
+    bool contains_locked(const std::string& needle) const {
+        return std::any_of(received_.begin(), received_.end(),
+            [&](const std::string& m) { return m.find(needle) != std::string::npos; });
+    }
+
+    net::strand<net::any_io_executor> strand_;
+    std::string nickname_;
+    std::string remote_id_;
+    std::string current_room_;
+    bool authenticated_ = false;
+    std::atomic<bool> stopped_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::string> received_;
+    std::vector<std::shared_ptr<const std::string>> binary_;
+    std::vector<std::function<void()>> unacked_;
+};
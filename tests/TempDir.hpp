@@ -0,0 +1,32 @@
+/**
+ * @file TempDir.hpp
+ * @brief 테스트마다 비어 있는 임시 디렉터리를 만들고 끝나면 지우는 도우미.
+ */
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+/**
+ * @struct TempDir
+ * @brief 시스템 임시 디렉터리 아래 `<name>_<pid>` 디렉터리. 생성 시 비우고, 소멸 시 통째로 지운다.
+ */
+struct TempDir {
+    std::string path;
+
+    explicit TempDir(const std::string& name)
+        : path((std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))).string()) {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+};
@@ -0,0 +1,154 @@
+#include "../include/ChannelLog.hpp"
+#include "../include/ChatServer.hpp"
+#include "ChatServerFixture.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @brief 채널마다 순번이 따로 증가하고, 보관 범위 안의 요청은 빠짐없이, 밀려난 구간은 `missing`으로 돌려주는지 확인한다.
+ */
+TEST(ChannelLogTest, SinceReturnsRetainedEntriesAndCountsMissing) {
+    ChannelLog log(3);
+    for (int i = 1; i <= 5; ++i) {
+        EXPECT_EQ(log.append("lobby", "m" + std::to_string(i)), static_cast<std::uint64_t>(i));
+    }
+    EXPECT_EQ(log.append(ChannelLog::global_channel, "g1"), 1u);
+    EXPECT_EQ(log.last_seq("lobby"), 5u);
+    EXPECT_EQ(log.last_seq("unknown"), 0u);
+
+    const std::string epoch = log.epoch("lobby");
+    EXPECT_NE(epoch, log.epoch(ChannelLog::global_channel));
+
+    auto recent = log.since("lobby", epoch, 3);
+    ASSERT_EQ(recent.entries.size(), 2u);
+    EXPECT_EQ(recent.entries[0].seq, 4u);
+    EXPECT_EQ(recent.entries[0].message, "#lobby:" + epoch + ".4 m4");
+    EXPECT_EQ(recent.missing, 0u);
+    EXPECT_EQ(recent.epoch, epoch);
+
+    auto old = log.since("lobby", epoch, 0);
+    EXPECT_EQ(old.entries.size(), 3u); // 3, 4, 5
+    EXPECT_EQ(old.missing, 2u);        // 1, 2
+
+    EXPECT_TRUE(log.since("lobby", epoch, 5).entries.empty());
+
+    // 다른 실행의 순번이면 같은 숫자라도 처음부터 보낸다
+    auto restarted = log.since("lobby", "0", 3);
+    EXPECT_EQ(restarted.entries.size(), 3u);
+    EXPECT_EQ(restarted.missing, 2u);
+
+    // 채널이 비워져도 순번은 이어진다
+    log.drop_entries("lobby");
+    auto dropped = log.since("lobby", epoch, 4);
+    EXPECT_TRUE(dropped.entries.empty());
+    EXPECT_EQ(dropped.missing, 1u);
+    EXPECT_EQ(log.append("lobby", "m6"), 6u);
+}
+
+/**
+ * @brief 비운 뒤 쓰이지 않은 채널은 다른 채널이 생길 때 정리되고, 다시 생기면 새 에포크로 순번을 1부터 매기는지 확인한다.
+ */
+TEST(ChannelLogTest, EvictsIdleDroppedChannelsWithNewEpoch) {
+    ChannelLog log(8, std::chrono::milliseconds(0));
+    for (int i = 0; i < 5; ++i) {
+        log.append("old-room", "m");
+    }
+    log.append("busy", "m");
+    const std::string old_epoch = log.epoch("old-room");
+    log.drop_entries("old-room");
+
+    log.append("new-room", "m");
+    EXPECT_EQ(log.channel_count(), 2u); // old-room 정리, busy는 보관 메시지가 있어 남음
+    EXPECT_EQ(log.last_seq("old-room"), 0u);
+    EXPECT_EQ(log.last_seq("busy"), 1u);
+
+    for (int i = 0; i < 7; ++i) {
+        log.append("old-room", "again");
+    }
+    EXPECT_NE(log.epoch("old-room"), old_epoch);
+    // 정리되기 전 채널의 #5 이후를 요청해도 새 채널의 #6, #7만 받지 않고 처음부터 받는다.
+    auto replay = log.since("old-room", old_epoch, 5);
+    EXPECT_EQ(replay.entries.size(), 7u);
+}
+
+/**
+ * @class ChannelReplayTest
+ * @brief 채팅 서버가 채널 메시지에 순번을 붙이고 `/since` 요청에 놓친 메시지만 다시 보내는지 검증하는 테스트 픽스처.
+ */
+class ChannelReplayTest : public ChatServerFixture {
+protected:
+    ChannelReplayTest() : ChatServerFixture("replay_test") {}
+
+    std::shared_ptr<FakeSession> connect(const std::string& nickname, const std::string& room) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server_->join(session);
+        EXPECT_TRUE(register_nickname(session, nickname));
+        EXPECT_TRUE(server_->join_room(room, session));
+        return session;
+    }
+};
+
+/**
+ * @brief 방 메시지에 `#<방>:<순번>` 태그가 붙고, 재전송 요청에는 요청한 순번 이후의 메시지만 돌아오는지 확인한다.
+ */
+TEST_F(ChannelReplayTest, RoomMessagesAreStampedAndReplayedSinceSeq) {
+    auto alice = connect("alice", "lobby");
+    auto bob = connect("bob", "lobby");
+    std::uint64_t base = server_->channel_last_seq("lobby");
+    const std::string epoch = server_->channel_epoch("lobby");
+
+    for (int i = 1; i <= 3; ++i) {
+        server_->broadcast_to_room("lobby", "msg" + std::to_string(i), bob);
+    }
+    std::string first_tag = "#lobby:" + epoch + "." + std::to_string(base + 1) + " [bob @ lobby]: msg1";
+    ASSERT_TRUE(alice->wait_for(first_tag));
+    ASSERT_TRUE(alice->wait_for("msg3"));
+    EXPECT_EQ(server_->channel_last_seq("lobby"), base + 3);
+
+    auto late = std::make_shared<FakeSession>(ioc_, "late");
+    server_->replay_channel_async("lobby", epoch, base + 1, late);
+    std::string end_marker = "* REPLAY_END lobby " + epoch + "." + std::to_string(base + 3);
+    ASSERT_TRUE(late->wait_for(end_marker));
+    EXPECT_EQ(late->count("msg1"), 0u);
+    EXPECT_EQ(late->count("msg2"), 1u);
+    EXPECT_EQ(late->count("msg3"), 1u);
+    EXPECT_EQ(late->count("REPLAY_HISTORY"), 0u);
+}
+
+/**
+ * @brief 입장/퇴장 알림이 메시지 사이에 순번을 받아도, 히스토리 구간은 순번으로 골라 이미 받은 메시지를 다시 보내지 않는지 확인한다.
+ */
+TEST_F(ChannelReplayTest, HistoryBackfillSelectsLinesBySeqAcrossNotices) {
+    auto alice = connect("alice", "lobby");
+    auto bob = connect("bob", "lobby");
+    server_->broadcast_to_room("lobby", "msg1", bob);
+    std::uint64_t seen = server_->channel_last_seq("lobby");
+    const std::string epoch = server_->channel_epoch("lobby");
+
+    auto carol = connect("carol", "lobby"); // 입장 알림
+    server_->broadcast_to_room("lobby", "msg2", bob);
+    ASSERT_TRUE(server_->leave_room("lobby", carol)); // 퇴장 알림
+    server_->broadcast_to_room("lobby", "msg3", bob);
+    ASSERT_TRUE(alice->wait_for("msg3"));
+    EXPECT_EQ(server_->channel_last_seq("lobby"), seen + 4);
+    ASSERT_TRUE(server_->leave_room("lobby", alice));
+    ASSERT_TRUE(server_->leave_room("lobby", bob)); // 빈 방이 사라지며 메모리 로그도 비워진다
+    std::uint64_t last = server_->channel_last_seq("lobby");
+
+    auto late = std::make_shared<FakeSession>(ioc_, "late");
+    server_->replay_channel_async("lobby", epoch, seen, late);
+    ASSERT_TRUE(late->wait_for("* REPLAY_END lobby " + epoch + "." + std::to_string(last)));
+    EXPECT_EQ(late->count("* REPLAY_HISTORY lobby 2"), 1u);
+    EXPECT_EQ(late->count("msg1"), 0u);
+    EXPECT_EQ(late->count("#" + std::to_string(seen + 2) + " [bob]: msg2"), 1u);
+    EXPECT_EQ(late->count("#" + std::to_string(seen + 4) + " [bob]: msg3"), 1u);
+}
@@ -0,0 +1,740 @@
+#include "../include/ChatServer.hpp"
+#include "../include/cluster/ClusterBus.hpp"
+#include "../include/cluster/HashRing.hpp"
+#include "../include/cluster/NicknameDirectory.hpp"
+#include "../include/cluster/RoomRouter.hpp"
+#include "../include/cluster/SocketBus.hpp"
+#include "FakeSession.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace net = boost::asio;
+
+namespace {
+    /// 조건이 참이 될 때까지 최대 `timeout` 동안 기다린다.
+    template <typename Pred>
+    bool wait_until(Pred pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(3000)) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return pred();
+    }
+}
+
+/**
+ * @brief 메시지 묶음 직렬화/역직렬화가 모든 필드를 보존하는지 확인한다.
+ */
+TEST(ClusterMessageTest, BatchRoundTrip) {
+    std::vector<ClusterMessage> batch;
+    for (int i = 0; i < 3; ++i) {
+        ClusterMessage msg;
+        msg.kind = static_cast<ClusterMessage::Kind>(1 + i);
+        msg.origin_node = "node-a";
+        msg.msg_id = 1000000000000ULL + i;
+        msg.target = "room" + std::to_string(i);
+        msg.sender = "사용자" + std::to_string(i);
+        msg.payload = std::string(300, 'x') + "\r\n";
+        batch.push_back(msg);
+    }
+
+    std::string frame = ClusterMessage::encode_batch(batch);
+    std::vector<ClusterMessage> decoded;
+    ASSERT_TRUE(ClusterMessage::decode_batch(frame, decoded));
+    ASSERT_EQ(decoded.size(), batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_EQ(decoded[i].kind, batch[i].kind);
+        EXPECT_EQ(decoded[i].origin_node, batch[i].origin_node);
+        EXPECT_EQ(decoded[i].msg_id, batch[i].msg_id);
+        EXPECT_EQ(decoded[i].target, batch[i].target);
+        EXPECT_EQ(decoded[i].sender, batch[i].sender);
+        EXPECT_EQ(decoded[i].payload, batch[i].payload);
+    }
+
+    // 잘린 프레임과 뒤에 쓰레기가 붙은 프레임은 거부한다.
+    std::vector<ClusterMessage> ignored;
+    EXPECT_FALSE(ClusterMessage::decode_batch(frame.substr(0, frame.size() - 1), ignored));
+    ignored.clear();
+    EXPECT_FALSE(ClusterMessage::decode_batch(frame + "x", ignored));
+}
+
+/**
+ * @brief 중복 제거기가 중복/순서 뒤바뀜을 올바르게 처리하는지 확인한다.
+ */
+TEST(ClusterDeduplicatorTest, DropsDuplicatesAcrossReordering) {
+    ClusterDeduplicator dedup(8);
+    EXPECT_TRUE(dedup.accept("a", 10));
+    EXPECT_FALSE(dedup.accept("a", 10));
+    EXPECT_TRUE(dedup.accept("a", 12));
+    EXPECT_TRUE(dedup.accept("a", 11));
+    EXPECT_FALSE(dedup.accept("a", 12));
+    EXPECT_FALSE(dedup.accept("a", 9)); // 처음 본 ID보다 이전 메시지는 이미 지난 것으로 간주
+    EXPECT_TRUE(dedup.accept("b", 10)); // 노드별로 독립
+    dedup.forget("a");
+    EXPECT_TRUE(dedup.accept("a", 10));
+}
+
+/**
+ * @brief 여러 스레드가 동시에 발행해도 버스가 붙인 ID가 전달 순서대로 증가하여,
+ *        수신 측 중복 제거기가 처음 본 ID보다 늦게 도착한 정상 메시지를 버리지 않는지 확인한다.
+ */
+TEST(InProcessBusTest, ConcurrentPublishersDeliverIdsInOrder) {
+    auto hub = std::make_shared<InProcessBusHub>();
+    std::mutex mutex;
+    std::vector<std::uint64_t> ids;
+    std::size_t accepted = 0;
+    ClusterDeduplicator dedup;
+    auto receiver = std::make_shared<InProcessBus>(hub);
+    receiver->start("node-b", [&](const ClusterMessage& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.push_back(msg.msg_id);
+        if (dedup.accept(msg.origin_node, msg.msg_id)) ++accepted;
+    });
+    auto sender = std::make_shared<InProcessBus>(hub);
+    sender->start("node-a", [](const ClusterMessage&) {});
+
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < 4; ++t) {
+        publishers.emplace_back([&sender]() {
+            for (int i = 0; i < 500; ++i) {
+                ClusterMessage msg;
+                msg.target_node = "node-b";
+                sender->publish(std::move(msg));
+            }
+        });
+    }
+    for (auto& thread : publishers) thread.join();
+
+    ASSERT_EQ(ids.size(), 2000u);
+    for (std::size_t i = 1; i < ids.size(); ++i)
+        ASSERT_EQ(ids[i], ids[i - 1] + 1) << i;
+    EXPECT_EQ(accepted, 2000u);
+    sender->stop();
+    receiver->stop();
+}
+
+/**
+ * @brief 같은 프로세스의 두 `ChatServer`를 `InProcessBus`로 묶어 노드 간 전달을 검증하는 Fixture.
+ */
+class ClusterChatTest : public ::testing::Test {
+protected:
+    net::io_context ioc_;
+    std::unique_ptr<net::executor_work_guard<net::io_context::executor_type>> work_guard_;
+    std::vector<std::thread> threads_;
+    std::shared_ptr<InProcessBusHub> hub_ = std::make_shared<InProcessBusHub>();
+    std::shared_ptr<ChatServer> node_a_;
+    std::shared_ptr<ChatServer> node_b_;
+    std::string history_dir_;
+
+    void SetUp() override {
+        history_dir_ = (std::filesystem::temp_directory_path() /
+                        ("cluster_test_history_" + std::to_string(::getpid()))).string();
+        work_guard_ = std::make_unique<net::executor_work_guard<net::io_context::executor_type>>(ioc_.get_executor());
+        node_a_ = std::make_shared<ChatServer>(ioc_, 0, "cluster_a.cfg", history_dir_ + "/a");
+        node_b_ = std::make_shared<ChatServer>(ioc_, 0, "cluster_b.cfg", history_dir_ + "/b");
+        node_a_->enable_cluster(std::make_shared<InProcessBus>(hub_), "node-a", std::chrono::milliseconds(100));
+        node_b_->enable_cluster(std::make_shared<InProcessBus>(hub_), "node-b", std::chrono::milliseconds(100));
+        for (int i = 0; i < 2; ++i) {
+            threads_.emplace_back([this]() { ioc_.run(); });
+        }
+        ASSERT_TRUE(wait_until([this]() {
+            return node_a_->cluster_nodes().size() == 2 && node_b_->cluster_nodes().size() == 2;
+        }));
+    }
+
+    void TearDown() override {
+        node_a_->stop();
+        node_b_->stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        work_guard_.reset();
+        ioc_.stop();
+        for (auto& t : threads_) {
+            if (t.joinable()) t.join();
+        }
+        std::error_code ec;
+        std::filesystem::remove_all(history_dir_, ec);
+    }
+
+    std::shared_ptr<FakeSession> connect(const std::shared_ptr<ChatServer>& server, const std::string& nickname) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server->join(session);
+        std::promise<bool> registered;
+        server->try_register_nickname_async(nickname, session, [&registered](bool ok) { registered.set_value(ok); });
+        EXPECT_TRUE(registered.get_future().get());
+        return session;
+    }
+};
+
+TEST_F(ClusterChatTest, RoomMessageReachesMembersOnOtherNode) {
+    auto alice = connect(node_a_, "alice");
+    auto bob = connect(node_b_, "bob");
+    ASSERT_TRUE(node_a_->join_room("lobby", alice));
+    ASSERT_TRUE(node_b_->join_room("lobby", bob));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 구독 요청이 소유 노드에 반영될 시간
+
+    ASSERT_TRUE(node_a_->broadcast_to_room("lobby", "hello from a", alice));
+    EXPECT_TRUE(bob->wait_for("[alice @ lobby]: hello from a"));
+    ASSERT_TRUE(node_b_->broadcast_to_room("lobby", "hello from b", bob));
+    EXPECT_TRUE(alice->wait_for("[bob @ lobby]: hello from b"));
+    EXPECT_EQ(alice->count("hello from a"), 0u);
+    EXPECT_EQ(bob->count("hello from a"), 1u);
+}
+
+TEST_F(ClusterChatTest, GlobalBroadcastAndPrivateMessageCrossNodes) {
+    auto alice = connect(node_a_, "alice");
+    auto bob = connect(node_b_, "bob");
+
+    node_b_->broadcast("* 공지\r\n", nullptr);
+    EXPECT_TRUE(alice->wait_for("* 공지"));
+
+    ASSERT_TRUE(node_a_->send_private_message("psst", alice, "bob"));
+    EXPECT_TRUE(bob->wait_for("[PM from alice]: psst"));
+    EXPECT_TRUE(alice->wait_for("* To bob: psst"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(bob->count("[PM from alice]: psst"), 1u);
+}
+
+/**
+ * @brief 보낸 노드의 위치 캐시가 오래되어 받는 사람이 없는 노드로 간 개인 메시지는,
+ *        디렉터리 노드가 어느 쪽이든 조용히 버려지지 않고 보낸 사람에게 실패가 알려지는지 확인한다.
+ */
+TEST_F(ClusterChatTest, PrivateMessageToStaleLocationNotifiesSender) {
+    auto alice = connect(node_a_, "alice");
+    // 디렉터리 노드가 node-a인 닉네임과 node-b인 닉네임이 모두 나오도록 여러 명을 쓴다.
+    for (int i = 0; i < 4; ++i) {
+        std::string nickname = "bob" + std::to_string(i);
+        auto bob = connect(node_b_, nickname);
+        ASSERT_TRUE(node_a_->send_private_message("first", alice, nickname));
+        ASSERT_TRUE(bob->wait_for("[PM from alice]: first"));
+
+        node_b_->leave(bob);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 임대 반납이 디렉터리에 반영될 시간
+        ASSERT_TRUE(node_a_->send_private_message("second", alice, nickname));
+        EXPECT_TRUE(alice->wait_for("Error: 사용자 '" + nickname + "'")) << nickname;
+    }
+}
+
+/**
+ * @brief 위치 캐시 없이 디렉터리 노드를 거쳐 보낸 개인 메시지는 전달이 확인된 뒤에만 보낸 사람에게 확인을 보내고 기록하며,
+ *        없는 닉네임이면 확인 없이 실패만 알리고 기록하지 않는지 확인한다.
+ */
+TEST_F(ClusterChatTest, PrivateMessageViaDirectoryConfirmsOnlyAfterLookup) {
+    auto alice = connect(node_a_, "alice");
+    // 디렉터리 노드가 node-b인 닉네임이 나오도록 여러 명을 쓴다.
+    for (int i = 0; i < 4; ++i) {
+        std::string nickname = "ghost" + std::to_string(i);
+        ASSERT_TRUE(node_a_->send_private_message("boo", alice, nickname));
+        EXPECT_TRUE(alice->wait_for("Error: 사용자 '" + nickname + "'")) << nickname;
+        EXPECT_EQ(alice->count("* To " + nickname), 0u) << nickname;
+        EXPECT_TRUE(node_a_->load_private_history("alice", nickname).empty()) << nickname;
+
+        std::string present = "carol" + std::to_string(i);
+        auto carol = connect(node_b_, present);
+        ASSERT_TRUE(node_a_->send_private_message("hey", alice, present));
+        EXPECT_TRUE(carol->wait_for("[PM from alice]: hey"));
+        EXPECT_TRUE(alice->wait_for("* To " + present + ": hey")) << present;
+        EXPECT_EQ(node_a_->load_private_history("alice", present).size(), 1u) << present;
+    }
+}
+
+/**
+ * @brief 노드가 추가될 때 소유 노드가 바뀌는 키는 새 노드로만 옮겨가고, 분배가 크게 치우치지 않는지 확인한다.
+ */
+TEST(HashRingTest, AddingNodeMovesKeysOnlyToNewNode) {
+    HashRing ring(128);
+    ring.add_node("node-a");
+    ring.add_node("node-b");
+    ring.add_node("node-c");
+
+    std::map<std::string, std::string> before;
+    std::map<std::string, int> load;
+    for (int i = 0; i < 3000; ++i) {
+        std::string key = "room-" + std::to_string(i);
+        before[key] = ring.owner(key);
+        ++load[before[key]];
+    }
+    for (const auto& [node, count] : load) {
+        EXPECT_GT(count, 600) << node; // 평균 1000, 가상 노드로 고르게 분배
+    }
+
+    ring.add_node("node-d");
+    int moved = 0;
+    for (const auto& [key, owner] : before) {
+        std::string now = ring.owner(key);
+        if (now != owner) {
+            EXPECT_EQ(now, "node-d");
+            ++moved;
+        }
+    }
+    EXPECT_GT(moved, 400);
+    EXPECT_LT(moved, 1200);
+
+    ring.remove_node("node-d");
+    for (const auto& [key, owner] : before) {
+        EXPECT_EQ(ring.owner(key), owner);
+    }
+}
+
+/**
+ * @brief 구독/재분배 시 RoomRouter가 필요한 구독 요청만 만들어내는지 확인한다.
+ */
+TEST(RoomRouterTest, TracksSubscriptionsAndRebalances) {
+    auto now = RoomRouter::clock::now();
+    RoomRouter router("node-a", 64);
+    EXPECT_EQ(router.track_local_room("lobby"), ""); // 혼자일 때는 자신이 소유자
+    EXPECT_EQ(router.track_local_room("lobby"), ""); // 이미 추적 중
+
+    EXPECT_TRUE(router.observe_node("node-b", now));
+    EXPECT_FALSE(router.observe_node("node-b", now));
+    auto moved = router.rebalance();
+    if (router.owner_of("lobby") == "node-b") {
+        ASSERT_EQ(moved.size(), 1u);
+        EXPECT_EQ(moved[0].first, "lobby");
+        EXPECT_EQ(moved[0].second, "node-b");
+        EXPECT_EQ(router.untrack_local_room("lobby"), "node-b");
+    } else {
+        EXPECT_TRUE(moved.empty());
+        EXPECT_EQ(router.untrack_local_room("lobby"), "");
+    }
+
+    // 소유 노드 측 구독 관리
+    std::string owned_room;
+    for (int i = 0; owned_room.empty(); ++i) {
+        std::string room = "r" + std::to_string(i);
+        if (router.is_owner(room)) owned_room = room;
+    }
+    router.add_subscriber(owned_room, "node-b");
+    router.add_subscriber(owned_room, "node-c");
+    EXPECT_EQ(router.subscribers(owned_room).size(), 2u);
+    EXPECT_EQ(router.subscribers(owned_room, "node-b"), std::vector<std::string>{"node-c"});
+
+    // 만료된 노드는 링과 구독 목록에서 함께 제거된다.
+    auto expired = router.expire_nodes(now + std::chrono::seconds(10), std::chrono::seconds(3));
+    EXPECT_EQ(expired, std::vector<std::string>{"node-b"});
+    EXPECT_EQ(router.nodes().size(), 1u);
+    EXPECT_EQ(router.subscribers(owned_room), std::vector<std::string>{"node-c"});
+}
+
+/**
+ * @brief 방 멤버가 없는 노드에는 방 메시지가 전달되지 않는지, 노드가 떠나면 소유권이 재분배되는지 확인한다.
+ */
+TEST(ClusterRoutingTest, RoomTrafficOnlyReachesSubscribedNodes) {
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::vector<std::thread> threads;
+    auto hub = std::make_shared<InProcessBusHub>();
+    std::string history_dir = (std::filesystem::temp_directory_path() /
+                               ("cluster_routing_history_" + std::to_string(::getpid()))).string();
+
+    // 버스를 통과하는 방 메시지를 노드별로 세는 래퍼
+    struct CountingBus : ClusterBus {
+        std::shared_ptr<InProcessBus> inner;
+        std::atomic<int>* room_messages;
+        void start(const std::string& node_id, Handler handler) override {
+            inner->start(node_id, [this, handler](const ClusterMessage& msg) {
+                if (msg.kind == ClusterMessage::Kind::Room || msg.kind == ClusterMessage::Kind::RoomForward) {
+                    ++*room_messages;
+                }
+                handler(msg);
+            });
+        }
+        void publish(ClusterMessage msg) override { inner->publish(std::move(msg)); }
+        void stop() override { inner->stop(); }
+    };
+
+    std::vector<std::shared_ptr<ChatServer>> nodes;
+    std::atomic<int> room_messages[3] = {0, 0, 0};
+    for (int i = 0; i < 3; ++i) {
+        auto server = std::make_shared<ChatServer>(ioc, 0, "routing.cfg", history_dir + "/" + std::to_string(i));
+        auto bus = std::make_shared<CountingBus>();
+        bus->inner = std::make_shared<InProcessBus>(hub);
+        bus->room_messages = &room_messages[i];
+        server->enable_cluster(bus, "node-" + std::to_string(i), std::chrono::milliseconds(100));
+        nodes.push_back(server);
+    }
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&ioc]() { ioc.run(); });
+    }
+    ASSERT_TRUE(wait_until([&]() {
+        for (auto& n : nodes) if (n->cluster_nodes().size() != 3) return false;
+        return true;
+    }));
+
+    // 소유 노드가 아닌 두 노드에 멤버를 두고, 남은 한 노드(소유 노드)는 중계만 한다.
+    std::string room_name = "lobby";
+    int owner_index = std::stoi(nodes[0]->room_owner(room_name).substr(5));
+    int member_a = (owner_index + 1) % 3;
+    int member_b = (owner_index + 2) % 3;
+    auto alice = std::make_shared<FakeSession>(ioc, "alice");
+    auto bob = std::make_shared<FakeSession>(ioc, "bob");
+    nodes[member_a]->join(alice);
+    nodes[member_b]->join(bob);
+    ASSERT_TRUE(nodes[member_a]->join_room(room_name, alice));
+    ASSERT_TRUE(nodes[member_b]->join_room(room_name, bob));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for (int i = 0; i < 10; ++i) {
+        nodes[member_a]->broadcast_to_room(room_name, "msg" + std::to_string(i), alice);
+    }
+    EXPECT_TRUE(bob->wait_for("[alice @ lobby]: msg9"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(bob->count("@ lobby]: msg"), 10u);
+    EXPECT_EQ(room_messages[owner_index].load(), 10);  // 소유 노드로 한 번
+    EXPECT_EQ(room_messages[member_b].load(), 10);     // 구독 노드로 한 번
+    EXPECT_EQ(room_messages[member_a].load(), 0);      // 보낸 노드로는 되돌아오지 않음
+
+    // 소유 노드가 떠나면 남은 노드끼리 소유권을 다시 정하고 전달이 계속된다.
+    nodes[owner_index]->stop();
+    ASSERT_TRUE(wait_until([&]() {
+        return nodes[member_a]->cluster_nodes().size() == 2 && nodes[member_b]->cluster_nodes().size() == 2;
+    }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    nodes[member_a]->broadcast_to_room(room_name, "after rebalance", alice);
+    EXPECT_TRUE(bob->wait_for("[alice @ lobby]: after rebalance"));
+
+    for (auto& n : nodes) n->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    work_guard.reset();
+    ioc.stop();
+    for (auto& t : threads) t.join();
+    std::error_code ec;
+    std::filesystem::remove_all(history_dir, ec);
+}
+
+/**
+ * @brief 첫 하트비트를 받기 전이라 링에 자기 자신만 있는 노드의 방 메시지도 다른 노드의 멤버에게 전달되는지 확인한다.
+ */
+TEST(ClusterRoutingTest, RoomMessageBeforeFirstHeartbeatReachesOtherNodes) {
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::vector<std::thread> threads;
+    auto hub = std::make_shared<InProcessBusHub>();
+    TempDir history_dir("cluster_solo_history");
+
+    // 들어오는 하트비트를 버려, 이 노드의 링이 계속 자기 자신만 갖게 하는 래퍼
+    struct DeafBus : ClusterBus {
+        std::shared_ptr<InProcessBus> inner;
+        void start(const std::string& node_id, Handler handler) override {
+            inner->start(node_id, [handler](const ClusterMessage& msg) {
+                if (msg.kind != ClusterMessage::Kind::Heartbeat) handler(msg);
+            });
+        }
+        void publish(ClusterMessage msg) override { inner->publish(std::move(msg)); }
+        void stop() override { inner->stop(); }
+    };
+
+    auto node_a = std::make_shared<ChatServer>(ioc, 0, "solo_a.cfg", history_dir.path + "/a");
+    auto node_b = std::make_shared<ChatServer>(ioc, 0, "solo_b.cfg", history_dir.path + "/b");
+    auto deaf = std::make_shared<DeafBus>();
+    deaf->inner = std::make_shared<InProcessBus>(hub);
+    node_a->enable_cluster(deaf, "node-a", std::chrono::milliseconds(100));
+    node_b->enable_cluster(std::make_shared<InProcessBus>(hub), "node-b", std::chrono::milliseconds(100));
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&ioc]() { ioc.run(); });
+    }
+
+    ASSERT_TRUE(wait_until([&]() { return node_b->cluster_nodes().size() == 2; }));
+
+    // node-b가 소유한다고 보는 방이면 node-b는 node-a에 구독하지 않으므로, 소유 노드 경로만으로는 전달되지 않는다.
+    std::string room_name;
+    for (int i = 0; room_name.empty(); ++i) {
+        std::string candidate = "room" + std::to_string(i);
+        if (node_b->room_owner(candidate) == "node-b") room_name = candidate;
+    }
+    auto alice = std::make_shared<FakeSession>(ioc, "alice");
+    auto bob = std::make_shared<FakeSession>(ioc, "bob");
+    node_a->join(alice);
+    node_b->join(bob);
+    ASSERT_TRUE(node_a->join_room(room_name, alice));
+    ASSERT_TRUE(node_b->join_room(room_name, bob));
+    EXPECT_EQ(node_a->cluster_nodes().size(), 1u);
+
+    ASSERT_TRUE(node_a->broadcast_to_room(room_name, "early bird", alice));
+    EXPECT_TRUE(bob->wait_for("[alice @ " + room_name + "]: early bird"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(bob->count("early bird"), 1u);
+
+    node_a->stop();
+    node_b->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    work_guard.reset();
+    ioc.stop();
+    for (auto& t : threads) t.join();
+}
+
+/**
+ * @brief 닉네임 임대가 다른 노드의 선점을 막고, 만료/반납/노드 이탈 후에는 풀리는지 확인한다.
+ */
+TEST(NicknameDirectoryTest, LeasesBlockOtherNodesUntilExpiry) {
+    auto now = NicknameDirectory::clock::now();
+    NicknameDirectory directory(std::chrono::seconds(3));
+
+    EXPECT_TRUE(directory.claim("alice", "node-a", now));
+    EXPECT_TRUE(directory.claim("alice", "node-a", now)); // 같은 노드의 재요청은 연장
+    EXPECT_FALSE(directory.claim("alice", "node-b", now + std::chrono::seconds(1)));
+    EXPECT_EQ(directory.holder("alice", now), "node-a");
+
+    // 갱신이 끊기면 만료되어 다른 노드가 가져갈 수 있다.
+    EXPECT_TRUE(directory.renew("alice", "node-a", now + std::chrono::seconds(2)));
+    EXPECT_FALSE(directory.claim("alice", "node-b", now + std::chrono::seconds(4)));
+    EXPECT_EQ(directory.holder("alice", now + std::chrono::seconds(6)), "");
+    EXPECT_TRUE(directory.claim("alice", "node-b", now + std::chrono::seconds(6)));
+
+    // 다른 노드의 반납 요청은 무시된다.
+    directory.release("alice", "node-a");
+    EXPECT_EQ(directory.holder("alice", now + std::chrono::seconds(6)), "node-b");
+    directory.release("alice", "node-b");
+    EXPECT_EQ(directory.holder("alice", now + std::chrono::seconds(6)), "");
+
+    // 위치 캐시와 임대는 노드가 떠나면 함께 지워진다.
+    directory.claim("bob", "node-c", now);
+    directory.cache_location("carol", "node-c", now);
+    EXPECT_EQ(directory.cached_location("carol", now), "node-c");
+    directory.drop_node("node-c");
+    EXPECT_EQ(directory.holder("bob", now), "");
+    EXPECT_EQ(directory.cached_location("carol", now), "");
+
+    directory.claim("dave", "node-a", now);
+    directory.retain_owned([](const std::string& nickname) { return nickname != "dave"; });
+    EXPECT_EQ(directory.lease_count(), 0u);
+}
+
+/**
+ * @brief 소켓 브로커로 연결된 독립된 노드들(각자 io_context와 스레드를 가진 프로세스 역할)에서
+ *        닉네임이 클러스터 전체에서 유일하게 유지되고, 개인 메시지가 수신자 노드로 전달되는지 확인한다.
+ */
+TEST(ClusterNicknameTest, NicknamesAreUniqueAcrossSocketBusNodes) {
+    std::string uri = "unix://" + (std::filesystem::temp_directory_path() /
+                                   ("cluster_nick_" + std::to_string(::getpid()) + ".sock")).string();
+    std::string history_dir = (std::filesystem::temp_directory_path() /
+                               ("cluster_nick_history_" + std::to_string(::getpid()))).string();
+
+    net::io_context broker_ioc;
+    auto broker_guard = net::make_work_guard(broker_ioc);
+    auto broker = std::make_shared<BusBroker>(broker_ioc, uri);
+    broker->run();
+    std::thread broker_thread([&broker_ioc]() { broker_ioc.run(); });
+
+    struct Node {
+        net::io_context ioc;
+        std::optional<net::executor_work_guard<net::io_context::executor_type>> guard;
+        std::shared_ptr<ChatServer> server;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (int i = 0; i < 3; ++i) {
+        auto node = std::make_unique<Node>();
+        node->guard.emplace(node->ioc.get_executor());
+        node->server = std::make_shared<ChatServer>(node->ioc, 0, "nick.cfg", history_dir + "/" + std::to_string(i));
+        node->server->enable_cluster(std::make_shared<SocketBus>(node->ioc, uri, std::chrono::milliseconds(1)),
+                                     "node-" + std::to_string(i), std::chrono::milliseconds(100));
+        node->thread = std::thread([n = node.get()]() { n->ioc.run(); });
+        nodes.push_back(std::move(node));
+    }
+    ASSERT_TRUE(wait_until([&]() {
+        for (auto& n : nodes) if (n->server->cluster_nodes().size() != 3) return false;
+        return true;
+    }));
+
+    auto register_nick = [](Node& node, const std::shared_ptr<FakeSession>& session, const std::string& nickname) {
+        std::promise<bool> result;
+        node.server->try_register_nickname_async(nickname, session, [&result](bool ok) { result.set_value(ok); });
+        return result.get_future().get();
+    };
+
+    // 여러 닉네임을 등록하여 디렉터리 노드가 원격인 경우와 로컬인 경우를 모두 거친다.
+    std::vector<std::shared_ptr<FakeSession>> owners;
+    for (int i = 0; i < 6; ++i) {
+        std::string nickname = "user" + std::to_string(i);
+        auto owner = std::make_shared<FakeSession>(nodes[0]->ioc, nickname);
+        nodes[0]->server->join(owner);
+        ASSERT_TRUE(register_nick(*nodes[0], owner, nickname)) << nickname;
+        owners.push_back(owner);
+
+        auto rival = std::make_shared<FakeSession>(nodes[1]->ioc, nickname);
+        nodes[1]->server->join(rival);
+        EXPECT_FALSE(register_nick(*nodes[1], rival, nickname)) << nickname;
+    }
+
+    // 다른 노드의 사용자에게 개인 메시지: 첫 메시지는 디렉터리를 거치고, 이후는 캐시로 바로 간다.
+    auto sender = std::make_shared<FakeSession>(nodes[2]->ioc, "sender");
+    nodes[2]->server->join(sender);
+    ASSERT_TRUE(register_nick(*nodes[2], sender, "sender"));
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(nodes[2]->server->send_private_message("hi" + std::to_string(i), sender, "user0"));
+        EXPECT_TRUE(owners[0]->wait_for("[PM from sender]: hi" + std::to_string(i)));
+    }
+    ASSERT_TRUE(nodes[2]->server->send_private_message("hello?", sender, "nobody"));
+    EXPECT_TRUE(sender->wait_for("Error: 사용자 'nobody'"));
+
+    // 소유자가 떠나면 임대가 반납되어 다른 노드에서 같은 닉네임을 쓸 수 있다.
+    nodes[0]->server->leave(owners[0]);
+    auto successor = std::make_shared<FakeSession>(nodes[1]->ioc, "user0");
+    nodes[1]->server->join(successor);
+    ASSERT_TRUE(wait_until([&]() { return register_nick(*nodes[1], successor, "user0"); }));
+    ASSERT_TRUE(nodes[2]->server->send_private_message("moved", sender, "user0"));
+    EXPECT_TRUE(successor->wait_for("[PM from sender]: moved"));
+
+    for (auto& n : nodes) n->server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (auto& n : nodes) {
+        n->guard.reset();
+        n->ioc.stop();
+        n->thread.join();
+    }
+    broker->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    broker_guard.reset();
+    broker_ioc.stop();
+    broker_thread.join();
+    std::error_code ec;
+    std::filesystem::remove_all(history_dir, ec);
+}
+
+/**
+ * @brief `BusBroker`를 통해 두 `SocketBus`가 묶음 전송된 메시지를 정확히 한 번씩 주고받는지 확인한다.
+ */
+TEST(SocketBusTest, BrokerRoutesBatchedMessagesOverUnixSocket) {
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    std::string uri = "unix://" + (std::filesystem::temp_directory_path() /
+                                   ("cluster_bus_" + std::to_string(::getpid()) + ".sock")).string();
+    auto broker = std::make_shared<BusBroker>(ioc, uri);
+    broker->run();
+
+    std::mutex mutex;
+    std::vector<ClusterMessage> received_b;
+    std::atomic<int> received_a{0};
+    std::atomic<int> received_c{0};
+
+    auto bus_a = std::make_shared<SocketBus>(ioc, uri, std::chrono::milliseconds(2), 16);
+    auto bus_b = std::make_shared<SocketBus>(ioc, uri, std::chrono::milliseconds(2), 16);
+    bus_a->start("node-a", [&](const ClusterMessage&) { ++received_a; });
+    auto bus_c = std::make_shared<SocketBus>(ioc, uri, std::chrono::milliseconds(2), 16);
+    bus_b->start("node-b", [&](const ClusterMessage& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received_b.push_back(msg);
+    });
+    bus_c->start("node-c", [&](const ClusterMessage&) { ++received_c; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 모든 노드가 브로커에 등록될 시간
+
+    const int total = 100;
+    for (int i = 0; i < total; ++i) {
+        ClusterMessage msg;
+        msg.kind = ClusterMessage::Kind::Room;
+        msg.target = "lobby";
+        msg.sender = "alice";
+        msg.payload = "m" + std::to_string(i);
+        msg.target_node = "node-b"; // 단독 전달: node-c는 받지 않아야 한다
+        bus_a->publish(msg);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (received_b.size() >= static_cast<size_t>(total)) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(received_b.size(), static_cast<size_t>(total));
+        for (int i = 0; i < total; ++i) {
+            EXPECT_EQ(received_b[i].origin_node, "node-a");
+            EXPECT_EQ(received_b[i].payload, "m" + std::to_string(i));
+            if (i > 0) EXPECT_EQ(received_b[i].msg_id, received_b[i - 1].msg_id + 1);
+        }
+    }
+    EXPECT_EQ(received_a.load(), 0); // 발행 노드로는 되돌아오지 않는다.
+    EXPECT_EQ(received_c.load(), 0);
+
+    ClusterMessage everyone;
+    everyone.kind = ClusterMessage::Kind::Global;
+    everyone.payload = "all";
+    bus_a->publish(everyone);
+    ASSERT_TRUE(wait_until([&]() { return received_c.load() == 1; }));
+    EXPECT_EQ(received_a.load(), 0);
+
+    bus_a->stop();
+    bus_b->stop();
+    bus_c->stop();
+    broker->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    work_guard.reset();
+    ioc.stop();
+    io_thread.join();
+}
+
+/**
+ * @brief 읽지 않는 노드의 쓰기 큐가 한도를 넘으면 브로커가 그 연결을 끊는지 확인한다.
+ */
+TEST(SocketBusTest, BrokerDropsPeerThatStopsReading) {
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("cluster_bus_slow_" + std::to_string(::getpid()) + ".sock")).string();
+    std::string uri = "unix://" + path;
+    auto broker = std::make_shared<BusBroker>(ioc, uri, 256 * 1024);
+    broker->run();
+
+    // 노드 ID만 알리고 아무것도 읽지 않는 피어. 읽기 시간 제한을 걸어 테스트가 멈추지 않게 한다.
+    net::io_context client_ioc;
+    net::local::stream_protocol::socket slow(client_ioc);
+    slow.connect(net::local::stream_protocol::endpoint(path));
+    std::string hello_body = std::string("\x00\x00\x04", 3) + "slow";
+    std::string hello = std::string("\x00\x00\x00", 3) + static_cast<char>(hello_body.size()) + hello_body;
+    net::write(slow, net::buffer(hello));
+    timeval timeout{2, 0};
+    ::setsockopt(slow.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    auto bus_a = std::make_shared<SocketBus>(ioc, uri, std::chrono::milliseconds(2), 16);
+    bus_a->start("node-a", [](const ClusterMessage&) {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    for (int i = 0; i < 4000; ++i) {
+        ClusterMessage msg;
+        msg.kind = ClusterMessage::Kind::Global;
+        msg.payload = std::string(4096, 'x');
+        bus_a->publish(msg);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // 끊겼다면 커널 버퍼에 남은 것을 다 읽은 뒤 EOF가 온다. 끊기지 않았다면 시간 제한에 걸린다.
+    std::array<char, 65536> buffer{};
+    boost::system::error_code ec;
+    while (!ec) {
+        slow.read_some(net::buffer(buffer), ec);
+    }
+    EXPECT_TRUE(ec == net::error::eof || ec == net::error::connection_reset) << ec.message();
+
+    bus_a->stop();
+    broker->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    work_guard.reset();
+    ioc.stop();
+    io_thread.join();
+}
@@ -0,0 +1,83 @@
+#include "../include/ChatServer.hpp"
+#include "../include/EphemeralEvents.hpp"
+#include "ChatServerFixture.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @brief 같은 (방, 사용자)의 이벤트는 마지막 것만 남고, 방마다 최대 인원만 꺼낸 뒤 나머지는 다음 주기로 미루는지 확인한다.
+ */
+TEST(EphemeralCoalescerTest, CoalescesPerUserAndCapsUsersPerFlush) {
+    EphemeralCoalescer coalescer(2);
+    EXPECT_TRUE(coalescer.add("lobby", "alice", "active"));
+    EXPECT_FALSE(coalescer.add("lobby", "alice", "typing"));
+    EXPECT_FALSE(coalescer.add("lobby", "bob", "active"));
+    EXPECT_FALSE(coalescer.add("lobby", "carol", "typing"));
+
+    auto first = coalescer.flush();
+    ASSERT_EQ(first.size(), 1u);
+    EXPECT_EQ(first[0].line, "~ lobby active:bob typing:alice\r\n");
+    EXPECT_FALSE(coalescer.empty());
+
+    auto second = coalescer.flush();
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(second[0].line, "~ lobby typing:carol\r\n");
+    EXPECT_TRUE(coalescer.empty());
+}
+
+/**
+ * @class EphemeralEventTest
+ * @brief 일회성 이벤트가 기록과 순번 없이 모아서 전달되는지 검증하는 테스트 픽스처.
+ */
+class EphemeralEventTest : public ChatServerFixture {
+protected:
+    EphemeralEventTest() : ChatServerFixture("ephemeral_test") {}
+
+    void configure(ChatServer& server) override { server.set_ephemeral_window(std::chrono::milliseconds(100)); }
+
+    std::shared_ptr<FakeSession> connect(const std::string& nickname, const std::string& room) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server_->join(session);
+        EXPECT_TRUE(register_nickname(session, nickname));
+        EXPECT_TRUE(server_->join_room(room, session));
+        return session;
+    }
+};
+
+/**
+ * @brief 한 주기 안에 여러 번 보낸 이벤트가 방마다 한 줄로 합쳐지고, 방 순번과 재전송 로그에 남지 않는지 확인한다.
+ */
+TEST_F(EphemeralEventTest, BurstIsCoalescedIntoOneUnloggedLine) {
+    auto alice = connect("alice", "lobby");
+    auto bob = connect("bob", "lobby");
+    auto outsider = connect("outsider", "other");
+    std::uint64_t seq_before = server_->channel_last_seq("lobby");
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(server_->send_ephemeral_event("lobby", alice, "typing"));
+    }
+    server_->send_ephemeral_event("lobby", bob, "active");
+    server_->send_ephemeral_event("lobby", outsider, "typing"); // 참여하지 않은 방은 무시
+    EXPECT_FALSE(server_->send_ephemeral_event("lobby", alice, "shouting"));
+
+    ASSERT_TRUE(bob->wait_for("~ lobby active:bob typing:alice"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_EQ(bob->count("~ lobby"), 1u);
+    for (const auto& line : bob->received()) {
+        if (line.rfind("~ ", 0) == 0) {
+            EXPECT_EQ(line.find("outsider"), std::string::npos);
+        }
+    }
+    EXPECT_EQ(outsider->count("~ lobby"), 0u);
+    EXPECT_EQ(server_->channel_last_seq("lobby"), seq_before);
+}
@@ -0,0 +1,177 @@
+#include "../include/ChatServer.hpp"
+#include "../include/FileSpool.hpp"
+#include "ChatServerFixture.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @brief 임시 파일에 쌓은 프레임을 넣은 순서대로 꺼내고, 소멸 시 파일을 지우는지 확인한다.
+ */
+TEST(FileSpoolTest, PopsFramesInOrderAndRemovesFile) {
+    auto path = (std::filesystem::temp_directory_path() /
+                 ("file_spool_test_" + std::to_string(::getpid()) + ".part")).string();
+    {
+        FileSpool spool(path);
+        ASSERT_TRUE(spool.is_open());
+        EXPECT_TRUE(spool.push("first"));
+        EXPECT_TRUE(spool.push(std::string("\0bin\0", 5)));
+        ASSERT_EQ(spool.pop()->compare("first"), 0);
+        EXPECT_TRUE(spool.push("third"));
+        EXPECT_EQ(*spool.pop(), std::string("\0bin\0", 5));
+        EXPECT_EQ(*spool.pop(), "third");
+        EXPECT_TRUE(spool.empty());
+        EXPECT_EQ(spool.pop(), nullptr);
+    }
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+/**
+ * @class FileTransferTest
+ * @brief 바이너리 파일 조각 중계와 흐름 제어를 검증하는 테스트 픽스처.
+ */
+class FileTransferTest : public ChatServerFixture {
+protected:
+    FileTransferTest() : ChatServerFixture("file_transfer_test") {}
+
+    void configure(ChatServer& server) override { server.set_file_chunk_window(2); }
+
+    std::shared_ptr<FakeSession> connect(const std::string& nickname) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server_->join(session);
+        EXPECT_TRUE(register_nickname(session, nickname));
+        return session;
+    }
+
+    /// alice가 bob에게 `size`바이트 파일을 제안하고 bob이 수락한 전송의 ID
+    std::string start_transfer(const std::shared_ptr<FakeSession>& alice, const std::shared_ptr<FakeSession>& bob, std::size_t size) {
+        std::string id = server_->init_file_transfer("photo.jpg", size, alice, "bob");
+        EXPECT_EQ(id.size(), ChatServer::file_id_length);
+        EXPECT_TRUE(bob->wait_for("* FILE_OFFER " + id + " alice " + std::to_string(size) + " photo.jpg"));
+        EXPECT_TRUE(server_->accept_file_transfer(id, bob));
+        EXPECT_TRUE(alice->wait_for("* FILE_ACCEPTED " + id));
+        return id;
+    }
+
+    static std::shared_ptr<const std::string> chunk(const std::string& id, const std::string& payload) {
+        return std::make_shared<const std::string>(id + payload);
+    }
+};
+
+/**
+ * @brief 조각이 복사 없이 같은 버퍼로 수신자에게 전달되고, 창이 가득 차면 수신자가 보낼 때까지 송신자 읽기가 멈추는지 확인한다.
+ */
+TEST_F(FileTransferTest, RelaysSharedChunksAndPausesSenderWhenWindowIsFull) {
+    auto alice = connect("alice");
+    auto bob = connect("bob");
+    std::string id = start_transfer(alice, bob, 9);
+
+    std::atomic<int> ready{0};
+    auto on_ready = [&ready]() { ++ready; };
+    auto first = chunk(id, "abc");
+    ASSERT_TRUE(server_->process_file_data(id, first, alice, on_ready));
+    ASSERT_TRUE(server_->process_file_data(id, chunk(id, "def"), alice, on_ready));
+    EXPECT_EQ(ready.load(), 1); // 두 번째 조각으로 창(2)이 가득 참
+
+    auto frames = bob->binary();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].get(), first.get());
+    EXPECT_FALSE(server_->process_file_data(id, chunk(id, "x"), bob, on_ready)); // 수신자는 보낼 수 없음
+
+    EXPECT_EQ(bob->ack_binary(), 2u);
+    EXPECT_EQ(ready.load(), 2);
+    ASSERT_TRUE(server_->process_file_data(id, chunk(id, "ghi"), alice, on_ready));
+    EXPECT_EQ(bob->count("FILE_DONE"), 0u);
+    EXPECT_EQ(bob->ack_binary(), 1u);
+
+    EXPECT_TRUE(alice->wait_for("* FILE_DONE " + id));
+    EXPECT_TRUE(bob->wait_for("* FILE_DONE " + id));
+    EXPECT_FALSE(server_->process_file_data(id, chunk(id, "j"), alice, on_ready));
+}
+
+/**
+ * @brief 임시 파일 디렉터리가 있으면 창을 넘는 조각을 디스크에 쌓아 송신자가 멈추지 않고, 수신자에게는 순서대로 전달되는지 확인한다.
+ */
+TEST_F(FileTransferTest, SpillsToDiskInsteadOfPausingSender) {
+    server_->set_file_spill_dir(history_dir_);
+    auto alice = connect("alice");
+    auto bob = connect("bob");
+    std::string id = start_transfer(alice, bob, 8);
+
+    std::atomic<int> ready{0};
+    for (const char* payload : {"aa", "bb", "cc", "dd"}) {
+        ASSERT_TRUE(server_->process_file_data(id, chunk(id, payload), alice, [&ready]() { ++ready; }));
+    }
+    // 임시 파일 쓰기는 전송별 strand에서 끝나므로, 쓰기가 끝나면 송신자가 다시 읽게 된다.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (ready.load() < 4 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(ready.load(), 4);
+    EXPECT_EQ(bob->binary().size(), 2u);
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(history_dir_) / (id + ".part")));
+
+    EXPECT_EQ(bob->ack_binary(), 2u);
+    ASSERT_TRUE(bob->wait_for_binary(4));
+    EXPECT_EQ(bob->ack_binary(), 2u);
+    auto frames = bob->binary();
+    ASSERT_EQ(frames.size(), 4u);
+    EXPECT_EQ(*frames[2], id + "cc");
+    EXPECT_EQ(*frames[3], id + "dd");
+    EXPECT_TRUE(bob->wait_for("* FILE_DONE " + id));
+    EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(history_dir_) / (id + ".part")));
+}
+
+/**
+ * @brief 수신자가 나가면 전송이 실패로 끝나고, 창이 가득 차 멈춰 있던 송신자가 다시 읽기 시작하는지 확인한다.
+ */
+TEST_F(FileTransferTest, ReceiverDisconnectFailsTransferAndResumesSender) {
+    auto alice = connect("alice");
+    auto bob = connect("bob");
+    std::string id = start_transfer(alice, bob, 100);
+
+    std::atomic<int> ready{0};
+    ASSERT_TRUE(server_->process_file_data(id, chunk(id, "12"), alice, [&ready]() { ++ready; }));
+    ASSERT_TRUE(server_->process_file_data(id, chunk(id, "34"), alice, [&ready]() { ++ready; }));
+    EXPECT_EQ(ready.load(), 1);
+
+    server_->leave(bob);
+    EXPECT_TRUE(alice->wait_for("* FILE_FAILED " + id + " disconnected"));
+    EXPECT_EQ(ready.load(), 2);
+    EXPECT_EQ(server_->init_file_transfer("photo.jpg", 10, alice, "nobody"), "");
+}
+
+/**
+ * @brief 창이 가득 차 송신자가 멈춘 뒤 수신자가 진행하지 않으면 시간 제한 후 전송이 실패하고 송신자가 다시 읽는지 확인한다.
+ */
+TEST_F(FileTransferTest, StalledReceiverFailsTransferAfterTimeout) {
+    server_->set_file_stall_timeout(std::chrono::milliseconds(100));
+    auto alice = connect("alice");
+    auto bob = connect("bob");
+    std::string id = start_transfer(alice, bob, 100);
+
+    std::atomic<int> ready{0};
+    ASSERT_TRUE(server_->process_file_data(id, chunk(id, "12"), alice, [&ready]() { ++ready; }));
+    ASSERT_TRUE(server_->process_file_data(id, chunk(id, "34"), alice, [&ready]() { ++ready; }));
+    EXPECT_EQ(ready.load(), 1);
+
+    EXPECT_TRUE(alice->wait_for("* FILE_FAILED " + id + " stalled"));
+    EXPECT_TRUE(bob->wait_for("* FILE_FAILED " + id + " stalled"));
+    // 송신자는 실패 알림을 보낸 뒤에 깨운다.
+    for (int i = 0; i < 100 && ready.load() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(ready.load(), 2);
+    EXPECT_FALSE(server_->process_file_data(id, chunk(id, "56"), alice, [&ready]() { ++ready; }));
+}
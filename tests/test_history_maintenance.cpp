@@ -0,0 +1,222 @@
+#include "../include/HistoryMaintenance.hpp"
+#include "../include/HistorySegments.hpp"
+#include "../include/MessageHistory.hpp"
+#include "../include/PrivateMessageStore.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    /// 2020-01-<day> 기록 줄
+    std::string old_line(int day, int i) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "2020-01-%02d 10:00:%02d [u]: old %d", day, i % 60, i);
+        return buf;
+    }
+}
+
+/**
+ * @brief 채널별 정책 문자열을 읽고, 잘못된 항목은 건너뛰며 `rooms`가 모든 방에 적용되는지 확인한다.
+ */
+TEST(RetentionConfigTest, ParsesPoliciesAndOverrides) {
+    RetentionPolicy policy;
+    ASSERT_TRUE(RetentionConfig::parse_policy("30d:200MB", policy));
+    EXPECT_EQ(policy.max_age, std::chrono::hours(30 * 24));
+    EXPECT_EQ(policy.max_bytes, 200ull << 20);
+    EXPECT_FALSE(RetentionConfig::parse_policy("30x", policy));
+    EXPECT_FALSE(RetentionConfig::parse_policy("", policy));
+    EXPECT_FALSE(RetentionConfig::parse_policy("99999999999999999999999d", policy));
+
+    RetentionConfig config;
+    config.defaults.max_age = std::chrono::hours(24);
+    EXPECT_FALSE(config.parse_overrides("rooms/lobby=7d, rooms=12h, private=64kb, broken, global=1y"));
+    EXPECT_EQ(config.policy_for("rooms/lobby").max_age, std::chrono::hours(7 * 24));
+    EXPECT_EQ(config.policy_for("rooms/other").max_age, std::chrono::hours(12));
+    EXPECT_EQ(config.policy_for("private").max_bytes, 64u << 10);
+    EXPECT_EQ(config.policy_for("global").max_age, std::chrono::hours(24));
+}
+
+/**
+ * @brief 앞쪽 블록을 정리하고 작은 블록을 합쳐도 줄 번호가 그대로이며, 정리 중 봉인된 블록도 남는지 확인한다.
+ */
+TEST(SegmentedLogTest, CompactionDropsAndMergesBlocksKeepingLineNumbers) {
+    TempDir dir("segmented_log_compaction_test");
+    const std::string base = dir.path + "/room";
+    HistoryCodec codec(dir.path + "/history.dict");
+    SegmentedLog log(base, codec, 0, 4096);
+    // 5줄씩 봉인해 작은 블록 8개를 만든다.
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(log.append(old_line(1 + i / 5, i)));
+        if (i % 5 == 4)
+            log.seal();
+    }
+    ASSERT_EQ(log.blocks().size(), 8u);
+
+    HistoryCodec maintenance_codec(dir.path + "/history.dict");
+    std::vector<std::string> archived;
+    SegmentedLog::Rewrite rewrite;
+    auto throttle = [](std::uint64_t) { return true; };
+    ASSERT_TRUE(SegmentedLog::rewrite(base, log.blocks(), 2, maintenance_codec, 4096, throttle,
+                                      [&](const std::string& line) { archived.push_back(line); }, rewrite));
+    EXPECT_EQ(archived.size(), 10u);
+    EXPECT_EQ(archived.front(), old_line(1, 0));
+
+    // 정리하는 사이에 새로 봉인된 블록
+    for (int i = 40; i < 45; ++i)
+        ASSERT_TRUE(log.append(old_line(9, i)));
+    log.seal();
+    ASSERT_TRUE(log.install(rewrite));
+
+    EXPECT_EQ(rewrite.dropped, 2u);
+    EXPECT_EQ(rewrite.merged, 5u);
+    EXPECT_EQ(log.blocks().size(), 2u);
+    EXPECT_EQ(log.first_line(), 10u);
+    EXPECT_EQ(log.line_count(), 45u);
+    EXPECT_TRUE(log.lines(0, 10).empty());
+    EXPECT_EQ(log.lines(9, 2), std::vector<std::string>{old_line(3, 10)});
+    EXPECT_EQ(log.lines(44, 1), std::vector<std::string>{old_line(9, 44)});
+
+    ASSERT_TRUE(log.append(old_line(10, 45)));
+    EXPECT_EQ(log.line_count(), 46u);
+
+    // 다시 열어도 같은 색인을 읽는다.
+    SegmentedLog reopened(base, codec, 0, 4096);
+    EXPECT_EQ(reopened.first_line(), 10u);
+    EXPECT_EQ(reopened.line_count(), 46u);
+    EXPECT_EQ(reopened.last_lines(0).size(), 36u);
+}
+
+/**
+ * @brief 귓속말 저장소를 정리해도 대화별 줄 번호가 유지되고, 정리하는 사이 추가된 메시지도 남는지 확인한다.
+ */
+TEST(PrivateMessageStoreTest, RewriteKeepsConversationLineNumbers) {
+    TempDir dir("private_message_compaction_test");
+    const std::string path = dir.path + "/messages.log";
+    PrivateMessageStore store(path);
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(store.append("alice", "bob", (i < 4 ? "old " : "new ") + std::to_string(i)));
+        ASSERT_TRUE(store.append("carol", "dave", "old cd " + std::to_string(i)));
+    }
+
+    PrivateMessageStore::Rewrite rewrite;
+    auto keep = [](const PrivateMessageStore::Conversation&, const std::string& line, std::uint64_t) {
+        return line.rfind("old", 0) != 0;
+    };
+    std::vector<std::string> dropped;
+    ASSERT_TRUE(PrivateMessageStore::rewrite(path, store.size_bytes(), keep, [](std::uint64_t) { return true; },
+                                             [&](const std::string& line) { dropped.push_back(line); }, rewrite));
+    EXPECT_EQ(rewrite.dropped_records, 10u);
+    EXPECT_EQ(dropped.size(), 10u);
+
+    ASSERT_TRUE(store.append("bob", "alice", "late"));
+    ASSERT_TRUE(store.install(rewrite));
+
+    EXPECT_EQ(store.first_line("alice", "bob"), 4u);
+    EXPECT_EQ(store.line_count("alice", "bob"), 7u);
+    EXPECT_EQ(store.lines("alice", "bob", 0, 5), std::vector<std::string>{"new 4"});
+    EXPECT_EQ(store.last_lines("alice", "bob", 0), (std::vector<std::string>{"new 4", "new 5", "late"}));
+    EXPECT_EQ(store.line_count("carol", "dave"), 6u);
+    EXPECT_TRUE(store.last_lines("carol", "dave", 0).empty());
+    EXPECT_EQ(store.conversations().size(), 1u);
+
+    ASSERT_TRUE(store.append("carol", "dave", "again"));
+    EXPECT_EQ(store.line_count("carol", "dave"), 7u);
+    EXPECT_EQ(store.lines("carol", "dave", 6, 1), std::vector<std::string>{"again"});
+}
+
+/**
+ * @brief 속도 제한이 평균 속도를 지키고, 기다리는 도중 중단 요청에 바로 돌아오는지 확인한다.
+ */
+TEST(IoRateLimiterTest, ThrottlesAndStops) {
+    std::atomic<bool> stop{false};
+    IoRateLimiter limiter(100000);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(limiter.acquire(100000, stop));
+    EXPECT_TRUE(limiter.acquire(20000, stop));
+    EXPECT_TRUE(limiter.acquire(1, stop));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+
+    EXPECT_TRUE(limiter.acquire(1000000, stop));
+    std::thread stopper([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stop = true;
+    });
+    start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(limiter.acquire(1, stop));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    stopper.join();
+}
+
+/**
+ * @brief 보존 기간이 지난 방/귓속말 기록을 보관 디렉터리로 옮기고, 채널별 예외 정책과 최근 기록은 그대로 두는지 확인한다.
+ */
+TEST(MessageHistoryTest, MaintenanceAppliesRetentionAndArchives) {
+    TempDir dir("history_maintenance_test");
+    const std::string archive_dir = dir.path + "/archive";
+    std::filesystem::create_directories(dir.path + "/rooms");
+    std::filesystem::create_directories(dir.path + "/private");
+    {
+        HistoryCodec codec(dir.path + "/history.dict");
+        SegmentedLog lobby(dir.path + "/rooms/lobby", codec, 0, 1024);
+        SegmentedLog keep(dir.path + "/rooms/keep", codec, 0, 1024);
+        for (int i = 0; i < 30; ++i) {
+            ASSERT_TRUE(lobby.append(old_line(1, i)));
+            ASSERT_TRUE(keep.append(old_line(1, i)));
+        }
+        lobby.seal();
+        keep.seal();
+        PrivateMessageStore store(dir.path + "/private/messages.log");
+        ASSERT_TRUE(store.append("alice", "bob", old_line(1, 0)));
+    }
+
+    MessageHistory history(dir.path);
+    history.log_room_message("lobby", "recent", "carol");
+    history.log_private_message("recent pm", "bob", "alice");
+
+    RetentionConfig config;
+    config.defaults.max_age = std::chrono::hours(24 * 30);
+    ASSERT_TRUE(config.parse_overrides("rooms/keep=0d"));
+    config.archive_dir = archive_dir;
+    config.interval = std::chrono::minutes(0);
+    config.io_bytes_per_second = 0;
+    history.set_retention(config);
+    history.flush_search_index();
+    EXPECT_EQ(history.search("old", "alice", "", 0, 100).total, 61u);
+
+    MaintenanceReport report = history.run_maintenance();
+    EXPECT_EQ(report.channels_compacted, 2u);
+    EXPECT_EQ(report.private_dropped, 1u);
+    EXPECT_EQ(report.lines_archived, 31u);
+
+    auto lobby = history.load_room_history("lobby", 0);
+    ASSERT_EQ(lobby.size(), 1u);
+    EXPECT_NE(lobby[0].find("recent"), std::string::npos);
+    EXPECT_TRUE(history.load_room_range("lobby", 0, 30).empty());
+    EXPECT_EQ(history.load_room_range("lobby", 30, 1).size(), 1u);
+    EXPECT_EQ(history.load_room_history("keep", 0).size(), 30u);
+    auto pm = history.load_private_history("alice", "bob", 0);
+    ASSERT_EQ(pm.size(), 1u);
+    EXPECT_NE(pm[0].find("recent pm"), std::string::npos);
+
+    HistoryCodec archive_codec(archive_dir + "/history.dict");
+    SegmentedLog archived(archive_dir + "/rooms/lobby", archive_codec, 0, 1024);
+    EXPECT_EQ(archived.last_lines(0).size(), 30u);
+    SegmentedLog archived_pm(archive_dir + "/private/messages", archive_codec, 0, 1024);
+    EXPECT_EQ(archived_pm.last_lines(0), std::vector<std::string>{old_line(1, 0)});
+
+    // 정리한 줄은 검색 결과 수에도 들어가지 않아 페이지가 모자라지 않는다.
+    auto found = history.search("old", "alice", "", 0, 10);
+    EXPECT_EQ(found.total, 30u);
+    EXPECT_EQ(found.lines.size(), 10u);
+    EXPECT_EQ(history.search("old", "alice", "lobby", 0, 10).total, 0u);
+
+    // 이미 정리한 채널은 다시 쓰지 않는다.
+    EXPECT_EQ(history.run_maintenance().channels_compacted, 0u);
+}
@@ -0,0 +1,239 @@
+#include "../include/MessageHistory.hpp"
+#include "../include/cluster/HistoryReplication.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+namespace {
+    /// 조건이 참이 될 때까지 최대 `timeout` 동안 기다린다.
+    template <typename Pred>
+    bool wait_until(Pred pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return pred();
+    }
+
+    /// 질의를 보내고 결과를 기다린다.
+    std::pair<bool, HistoryQueryResult> query_sync(HistoryReplicator& replicator, HistoryQuery query) {
+        auto promise = std::make_shared<std::promise<std::pair<bool, HistoryQueryResult>>>();
+        auto future = promise->get_future();
+        replicator.query(std::move(query), std::chrono::milliseconds(2000), [promise](bool ok, HistoryQueryResult result) {
+            promise->set_value({ok, std::move(result)});
+        });
+        return future.get();
+    }
+}
+
+/**
+ * @brief 리더의 기록이 원래 줄 그대로 팔로워에 복제되고, 질의는 먼저 보낸 기록을 반영해 팔로워가 답하며,
+ *        팔로워를 다시 시작해도 끊긴 동안의 기록을 중복 없이 이어 받는지 확인한다.
+ */
+TEST(HistoryReplicationTest, FollowerAppliesStreamAndServesReads) {
+    TempDir leader_dir("history_replication_leader");
+    TempDir follower_dir("history_replication_follower");
+    const std::string uri = "unix://" + follower_dir.path + "/follower.sock";
+    const std::string state_path = follower_dir.path + "/replication.state";
+
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i)
+        threads.emplace_back([&ioc]() { ioc.run(); });
+
+    MessageHistory leader(leader_dir.path);
+    MessageHistory replica(follower_dir.path + "/history");
+    auto follower = std::make_shared<HistoryFollower>(ioc, uri, replica, state_path);
+    follower->run();
+
+    auto replicator = std::make_shared<HistoryReplicator>(ioc, uri, std::chrono::milliseconds(1), 16);
+    leader.set_append_listener([replicator](const HistoryRecord& record) { replicator->publish(record); });
+    replicator->start();
+    ASSERT_TRUE(wait_until([&]() { return replicator->ready(); }));
+
+    for (int i = 0; i < 50; ++i)
+        leader.log_room_message("lobby", "hello " + std::to_string(i), "alice");
+    leader.log_private_message("secret hello", "alice", "bob");
+    leader.log_global_message("notice", "system");
+
+    ASSERT_TRUE(wait_until([&]() { return replicator->acked_seq() == 52; }));
+    EXPECT_EQ(replica.load_room_history("lobby", 0), leader.load_room_history("lobby", 0));
+    EXPECT_EQ(replica.load_private_history("bob", "alice", 0), leader.load_private_history("alice", "bob", 0));
+    EXPECT_EQ(replica.load_global_history(0), leader.load_global_history(0));
+
+    replica.flush_search_index();
+    HistoryQuery search;
+    search.kind = HistoryQuery::Kind::Search;
+    search.text = "hello";
+    search.nickname = "bob";
+    search.limit = 10;
+    auto [ok, found] = query_sync(*replicator, search);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(found.total, 51u);
+    EXPECT_EQ(found.lines.size(), 10u);
+
+    // 팔로워를 내렸다가 같은 상태 파일로 다시 띄운다.
+    std::weak_ptr<HistoryFollower> stopped = follower;
+    follower->stop();
+    follower.reset();
+    ASSERT_TRUE(wait_until([&]() { return stopped.expired(); }));
+    for (int i = 50; i < 60; ++i)
+        leader.log_room_message("lobby", "hello " + std::to_string(i), "alice");
+    follower = std::make_shared<HistoryFollower>(ioc, uri, replica, state_path);
+    EXPECT_EQ(follower->applied_seq(), 52u);
+    follower->run();
+
+    ASSERT_TRUE(wait_until([&]() { return replicator->acked_seq() == 62; }));
+    EXPECT_EQ(replica.load_room_history("lobby", 0).size(), 60u);
+    EXPECT_EQ(replica.load_room_history("lobby", 0), leader.load_room_history("lobby", 0));
+
+    // 스크롤백 질의는 앞서 보낸 기록이 적용된 뒤 처리되므로 방금 기록한 줄도 포함한다.
+    leader.log_room_message("lobby", "just now", "carol");
+    HistoryQuery tail;
+    tail.kind = HistoryQuery::Kind::Room;
+    tail.room = "lobby";
+    tail.limit = 3;
+    auto [tail_ok, last] = query_sync(*replicator, tail);
+    ASSERT_TRUE(tail_ok);
+    ASSERT_EQ(last.lines.size(), 3u);
+    EXPECT_NE(last.lines.back().find("just now"), std::string::npos);
+    EXPECT_EQ(last.lines, leader.load_room_history("lobby", 3));
+
+    leader.set_append_listener(nullptr);
+    replicator->stop();
+    follower->stop();
+    work_guard.reset();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+/**
+ * @brief 팔로워가 없으면 질의가 기다리지 않고 실패하여, 호출한 쪽이 자신의 히스토리에서 읽을 수 있는지 확인한다.
+ */
+TEST(HistoryReplicationTest, QueryFailsFastWithoutFollower) {
+    TempDir dir("history_replication_nofollower");
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::thread thread([&ioc]() { ioc.run(); });
+
+    auto replicator = std::make_shared<HistoryReplicator>(ioc, "unix://" + dir.path + "/missing.sock");
+    replicator->start();
+    HistoryRecord record;
+    record.kind = HistoryRecord::Kind::Global;
+    record.line = "2026-10-17 12:00:00 [system]: kept";
+    replicator->publish(record);
+
+    auto started = std::chrono::steady_clock::now();
+    auto [ok, result] = query_sync(*replicator, HistoryQuery{});
+    EXPECT_FALSE(ok);
+    EXPECT_TRUE(result.lines.empty());
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(500));
+    EXPECT_FALSE(replicator->ready());
+    EXPECT_EQ(replicator->last_seq(), 1u);
+    EXPECT_EQ(replicator->acked_seq(), 0u);
+
+    replicator->stop();
+    work_guard.reset();
+    thread.join();
+}
+
+/**
+ * @brief 팔로워가 없는 동안 보관 한도를 넘겨 기록을 버리면, 팔로워가 접속해도 읽기를 맡기지 않고 이후 기록만 복제하는지 확인한다.
+ */
+TEST(HistoryReplicationTest, FollowerWithGapIsNotReadable) {
+    TempDir dir("history_replication_gap");
+    const std::string uri = "unix://" + dir.path + "/follower.sock";
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::thread thread([&ioc]() { ioc.run(); });
+
+    auto replicator = std::make_shared<HistoryReplicator>(ioc, uri, std::chrono::milliseconds(1), 16, 5);
+    replicator->start();
+    for (int i = 0; i < 10; ++i) {
+        HistoryRecord record;
+        record.kind = HistoryRecord::Kind::Global;
+        record.line = "2026-10-17 12:00:00 [system]: line " + std::to_string(i);
+        replicator->publish(record);
+    }
+    ASSERT_TRUE(wait_until([&]() { return replicator->last_seq() == 10; }));
+    EXPECT_TRUE(replicator->has_gap());
+
+    MessageHistory replica(dir.path + "/history");
+    auto follower = std::make_shared<HistoryFollower>(ioc, uri, replica, dir.path + "/replication.state");
+    follower->run();
+    ASSERT_TRUE(wait_until([&]() { return replicator->acked_seq() == 10; }));
+    EXPECT_TRUE(replicator->ready());
+    EXPECT_FALSE(replicator->readable());
+    EXPECT_EQ(replica.load_global_history(0).size(), 5u);
+
+    auto [ok, result] = query_sync(*replicator, HistoryQuery{});
+    EXPECT_FALSE(ok);
+
+    replicator->stop();
+    follower->stop();
+    work_guard.reset();
+    thread.join();
+}
+
+/**
+ * @brief 무중단 재시작 중처럼 두 리더가 같은 팔로워에 접속하면, 나중 리더는 이전 리더가 연결을 닫을 때까지 거절되고
+ *        그 사이 이전 리더의 연결과 적용 위치가 흔들리지 않아 빠진 구간이나 중복이 생기지 않는지 확인한다.
+ */
+TEST(HistoryReplicationTest, FollowerRefusesSecondLeaderUntilFirstLeaves) {
+    TempDir dir("history_replication_two_leaders");
+    const std::string uri = "unix://" + dir.path + "/follower.sock";
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::thread thread([&ioc]() { ioc.run(); });
+
+    auto make_record = [](const std::string& text) {
+        HistoryRecord record;
+        record.kind = HistoryRecord::Kind::Global;
+        record.line = "2026-10-17 12:00:00 [system]: " + text;
+        return record;
+    };
+
+    MessageHistory replica(dir.path + "/history");
+    auto follower = std::make_shared<HistoryFollower>(ioc, uri, replica, dir.path + "/replication.state");
+    follower->run();
+
+    auto old_leader = std::make_shared<HistoryReplicator>(ioc, uri, std::chrono::milliseconds(1));
+    old_leader->start();
+    ASSERT_TRUE(wait_until([&]() { return old_leader->ready(); }));
+
+    auto new_leader = std::make_shared<HistoryReplicator>(ioc, uri, std::chrono::milliseconds(1));
+    new_leader->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    EXPECT_FALSE(new_leader->ready());
+    EXPECT_TRUE(old_leader->readable());
+
+    for (int i = 0; i < 3; ++i)
+        old_leader->publish(make_record("old " + std::to_string(i)));
+    ASSERT_TRUE(wait_until([&]() { return old_leader->acked_seq() == 3; }));
+    EXPECT_FALSE(old_leader->has_gap());
+
+    old_leader->stop();
+    ASSERT_TRUE(wait_until([&]() { return new_leader->ready(); }));
+    EXPECT_FALSE(new_leader->has_gap());
+    new_leader->publish(make_record("new 0"));
+    ASSERT_TRUE(wait_until([&]() { return new_leader->acked_seq() == 1; }));
+    EXPECT_EQ(follower->applied_seq(), 1u);
+    EXPECT_EQ(replica.load_global_history(0).size(), 4u);
+
+    new_leader->stop();
+    follower->stop();
+    work_guard.reset();
+    thread.join();
+}
@@ -0,0 +1,141 @@
+#include "../include/MessageHistory.hpp"
+#include "../include/HistorySegments.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+    bool ends_with(const std::string& line, const std::string& suffix) {
+        return line.size() >= suffix.size() && line.compare(line.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+/**
+ * @brief 봉인된 블록을 색인으로 찾아 요청한 줄이 든 블록만 풀고, 최근 줄은 활성 세그먼트에서 읽는지 확인한다.
+ */
+TEST(SegmentedLogTest, RandomAccessDecodesOnlyTouchedBlocks) {
+    TempDir dir("segmented_log_test");
+    HistoryCodec codec(dir.path + "/history.dict");
+    SegmentedLog log(dir.path + "/lobby", codec, 2000, 500);
+    for (int i = 0; i < 200; ++i) {
+        log.append("2026-10-17 12:" + std::string(i < 100 ? "00" : "30") + ":00 [alice]: message " + std::to_string(i));
+        SegmentedLog::Seal seal;
+        if (log.prepare_seal(seal)) {
+            ASSERT_TRUE(SegmentedLog::build_seal(seal, codec));
+            ASSERT_TRUE(log.install_seal(seal));
+        }
+    }
+    ASSERT_GT(log.blocks().size(), 4u);
+    EXPECT_EQ(log.line_count(), 200u);
+
+    auto middle = log.lines(50, 3);
+    ASSERT_EQ(middle.size(), 3u);
+    EXPECT_TRUE(ends_with(middle[0], "message 50"));
+    EXPECT_TRUE(ends_with(middle[2], "message 52"));
+    EXPECT_LE(log.blocks_decoded(), 2u);
+
+    std::size_t decoded = log.blocks_decoded();
+    auto recent = log.last_lines(1);
+    ASSERT_EQ(recent.size(), 1u);
+    EXPECT_TRUE(ends_with(recent[0], "message 199"));
+    EXPECT_EQ(log.blocks_decoded(), decoded);
+
+    auto later = log.time_range("2026-10-17 12:30", "2026-10-17 12:30");
+    ASSERT_EQ(later.size(), 100u);
+    EXPECT_TRUE(ends_with(later.front(), "message 100"));
+
+    // 다시 열어도 색인과 활성 세그먼트에서 같은 내용을 읽는다.
+    SegmentedLog reopened(dir.path + "/lobby", codec, 2000, 500);
+    EXPECT_EQ(reopened.line_count(), 200u);
+    EXPECT_EQ(reopened.lines(0, 200).size(), 200u);
+}
+
+/**
+ * @brief 가득 찬 세그먼트는 압축하지 않고 봉인 대기로 돌리기만 하며, 봉인 전에도 읽히고 다시 열어도 남는지 확인한다.
+ */
+TEST(SegmentedLogTest, AppendRotatesWithoutCompressing) {
+    TempDir dir("segmented_log_rotate_test");
+    HistoryCodec codec(dir.path + "/history.dict");
+    SegmentedLog log(dir.path + "/lobby", codec, 1000, 500);
+    for (int i = 0; i < 60; ++i) {
+        ASSERT_TRUE(log.append("2026-10-17 12:00:00 [alice]: message " + std::to_string(i)));
+    }
+    EXPECT_TRUE(log.has_pending());
+    EXPECT_TRUE(log.blocks().empty());
+    EXPECT_FALSE(std::filesystem::exists(dir.path + "/lobby.blk"));
+    EXPECT_EQ(log.line_count(), 60u);
+    auto all = log.lines(0, 60);
+    ASSERT_EQ(all.size(), 60u);
+    EXPECT_TRUE(ends_with(all[0], "message 0"));
+    EXPECT_TRUE(ends_with(all[59], "message 59"));
+
+    SegmentedLog reopened(dir.path + "/lobby", codec, 1000, 500);
+    EXPECT_TRUE(reopened.has_pending());
+    reopened.seal();
+    EXPECT_FALSE(reopened.has_pending());
+    ASSERT_FALSE(reopened.blocks().empty());
+    EXPECT_EQ(std::filesystem::file_size(dir.path + "/lobby.idx"), reopened.blocks().size() * SegmentedLog::index_record_size);
+    EXPECT_EQ(reopened.last_lines(0), all);
+}
+
+/**
+ * @brief `MessageHistory`가 기존 API로는 봉인 전과 같은 결과를 돌려주고, 새 범위 조회로 임의 구간을 읽는지 확인한다.
+ */
+TEST(MessageHistoryTest, RoomHistorySpansSealedAndActiveSegments) {
+    TempDir dir("message_history_segments_test");
+    MessageHistory history(dir.path);
+    history.set_segment_limits(4096, 1024);
+    for (int i = 0; i < 300; ++i) {
+        history.log_room_message("lobby", "hello " + std::to_string(i), "bob");
+    }
+    history.flush_sealing();
+    EXPECT_TRUE(std::filesystem::exists(dir.path + "/rooms/lobby.idx"));
+    EXPECT_LT(std::filesystem::file_size(dir.path + "/rooms/lobby.txt"), 4096u);
+
+    auto last = history.load_room_history("lobby", 250);
+    ASSERT_EQ(last.size(), 250u);
+    EXPECT_TRUE(ends_with(last.front(), "[bob]: hello 50"));
+    EXPECT_TRUE(ends_with(last.back(), "[bob]: hello 299"));
+    EXPECT_EQ(history.load_room_history("lobby").size(), 300u);
+
+    auto range = history.load_room_range("lobby", 10, 2);
+    ASSERT_EQ(range.size(), 2u);
+    EXPECT_TRUE(ends_with(range[1], "[bob]: hello 11"));
+    EXPECT_EQ(history.load_room_between("lobby", "", "").size(), 300u);
+    EXPECT_TRUE(history.load_room_between("lobby", "1999", "2000").empty());
+    EXPECT_TRUE(history.load_room_history("missing", 10).empty());
+}
+
+/**
+ * @brief 다른 `MessageHistory`가 쓰고 있는 디렉터리는 기록을 끈 채로 열리고, `close()` 뒤에는
+ *        이전 쪽의 기록이 멈추며 새로 연 쪽이 줄 번호를 이어 가는지 확인한다. (무중단 재시작의 히스토리 인계)
+ */
+TEST(MessageHistoryTest, SecondWriterIsRefusedUntilClose) {
+    TempDir dir("message_history_lock_test");
+    MessageHistory old_history(dir.path);
+    ASSERT_TRUE(old_history.is_enabled());
+    old_history.log_room_message("lobby", "before handoff", "alice");
+    {
+        MessageHistory second(dir.path);
+        EXPECT_FALSE(second.is_enabled());
+        second.set_enabled(true);
+        EXPECT_FALSE(second.is_enabled());
+        second.log_room_message("lobby", "from second", "mallory");
+    }
+
+    old_history.close();
+    EXPECT_FALSE(old_history.is_enabled());
+    old_history.log_room_message("lobby", "after close", "alice");
+
+    MessageHistory new_history(dir.path);
+    ASSERT_TRUE(new_history.is_enabled());
+    new_history.log_room_message("lobby", "after handoff", "bob");
+    auto lines = new_history.load_room_history("lobby");
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_TRUE(ends_with(lines[0], "[alice]: before handoff"));
+    EXPECT_TRUE(ends_with(lines[1], "[bob]: after handoff"));
+}
@@ -0,0 +1,178 @@
+#include "../include/ChatServer.hpp"
+#include "../include/ListenerHandoff.hpp"
+#include "FakeSession.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace net = boost::asio;
+using tcp = boost::asio::ip::tcp;
+
+namespace {
+    /// 조건이 참이 될 때까지 최대 `timeout` 동안 기다린다.
+    template <typename Pred>
+    bool wait_until(Pred pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(3000)) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return pred();
+    }
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief 이전 프로세스 역할의 `HandoffServer`가 넘겨준 리스닝 소켓으로 새 acceptor가 연결을 받을 수 있고,
+ *        `confirm()` 이후에만 인계 완료 콜백이 호출되는지 확인한다.
+ */
+TEST(ListenerHandoffTest, PassesListeningSocketAndWaitsForConfirm) {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("handoff_test_" + std::to_string(::getpid()) + ".sock")).string();
+
+    net::io_context old_ioc;
+    tcp::acceptor old_acceptor(old_ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+    unsigned short port = old_acceptor.local_endpoint().port();
+
+    std::atomic<bool> handed_off{false};
+    auto server = std::make_shared<HandoffServer>(old_ioc, path,
+        [&old_acceptor]() {
+            return std::vector<HandoffSocket>{HandoffSocket{"ws", static_cast<int>(old_acceptor.native_handle()), false}};
+        },
+        [&handed_off]() { handed_off = true; });
+    server->run();
+    std::thread old_thread([&old_ioc]() { old_ioc.run(); });
+
+    {
+        HandoffClient client;
+        ASSERT_TRUE(client.request(path));
+        EXPECT_EQ(client.take("http").fd, -1);
+        HandoffSocket inherited = client.take("ws");
+        ASSERT_GE(inherited.fd, 0);
+        EXPECT_FALSE(inherited.ipv6);
+
+        // 넘겨받은 소켓은 같은 포트에서 바로 연결을 받을 수 있어야 한다
+        net::io_context new_ioc;
+        tcp::acceptor new_acceptor(new_ioc);
+        new_acceptor.assign(tcp::v4(), inherited.fd);
+        EXPECT_EQ(new_acceptor.local_endpoint().port(), port);
+
+        tcp::socket client_socket(new_ioc);
+        client_socket.connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), port));
+        tcp::socket accepted = new_acceptor.accept();
+        EXPECT_TRUE(accepted.is_open());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_FALSE(handed_off) << "confirm() 전에 이전 프로세스가 drain을 시작하면 안 된다";
+
+        // confirm()은 이전 프로세스의 인계 처리(저장소 닫기)가 끝난 뒤에 돌아온다
+        EXPECT_TRUE(client.confirm());
+        EXPECT_TRUE(handed_off);
+    }
+
+    // 인계가 끝난 서버는 더 이상 요청을 받지 않는다
+    HandoffClient late_client;
+    EXPECT_FALSE(late_client.request(path, std::chrono::milliseconds(200)));
+
+    old_ioc.stop();
+    old_thread.join();
+    ::unlink(path.c_str());
+}
+
+/**
+ * @brief 소켓을 받은 새 프로세스가 `READY`를 보내지 않으면, 이전 프로세스가 시간이 지난 뒤 다음 인계 요청을 받는지 확인한다.
+ */
+TEST(ListenerHandoffTest, AcceptsNextRequestAfterReadyTimeout) {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("handoff_timeout_test_" + std::to_string(::getpid()) + ".sock")).string();
+
+    net::io_context old_ioc;
+    tcp::acceptor old_acceptor(old_ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+
+    std::atomic<bool> handed_off{false};
+    auto server = std::make_shared<HandoffServer>(old_ioc, path,
+        [&old_acceptor]() {
+            return std::vector<HandoffSocket>{HandoffSocket{"ws", static_cast<int>(old_acceptor.native_handle()), false}};
+        },
+        [&handed_off]() { handed_off = true; },
+        std::chrono::milliseconds(100));
+    server->run();
+    std::thread old_thread([&old_ioc]() { old_ioc.run(); });
+
+    HandoffClient stalled; // 연결을 열어 둔 채 confirm()하지 않는다
+    ASSERT_TRUE(stalled.request(path));
+
+    HandoffClient next;
+    EXPECT_TRUE(next.request(path, std::chrono::milliseconds(2000)));
+    EXPECT_TRUE(next.confirm());
+    EXPECT_TRUE(wait_until([&]() { return handed_off.load(); }));
+
+    old_ioc.stop();
+    old_thread.join();
+    ::unlink(path.c_str());
+}
+
+/**
+ * @brief 실행 중인 이전 프로세스가 없으면 요청이 실패하여 직접 바인딩하도록 하는지 확인한다.
+ */
+TEST(ListenerHandoffTest, RequestFailsWithoutRunningProcess) {
+    HandoffClient client;
+    EXPECT_FALSE(client.request("/tmp/handoff_test_missing.sock", std::chrono::milliseconds(200)));
+    EXPECT_EQ(client.take("ws").fd, -1);
+    EXPECT_FALSE(client.confirm());
+}
+
+#endif // _WIN32
+
+/**
+ * @brief `drain`이 세션을 한 번에 닫지 않고 나누어 닫으며, 모두 닫은 뒤 완료 콜백을 호출하는지 확인한다.
+ */
+TEST(ChatServerDrainTest, ClosesSessionsGraduallyWithinWindow) {
+    net::io_context ioc;
+    auto work_guard = net::make_work_guard(ioc);
+    std::string history_dir = (std::filesystem::temp_directory_path() /
+                               ("drain_test_history_" + std::to_string(::getpid()))).string();
+    auto server = std::make_shared<ChatServer>(ioc, 0, "drain_test.cfg", history_dir);
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    std::vector<std::shared_ptr<FakeSession>> sessions;
+    for (int i = 0; i < 20; ++i) {
+        auto session = std::make_shared<FakeSession>(ioc, "user" + std::to_string(i));
+        server->join(session);
+        sessions.push_back(session);
+    }
+    auto stopped_count = [&sessions]() {
+        return std::count_if(sessions.begin(), sessions.end(), [](const auto& s) { return s->stopped(); });
+    };
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::promise<void> drained;
+    auto start = std::chrono::steady_clock::now();
+    server->drain(std::chrono::milliseconds(500), [&drained]() { drained.set_value(); });
+
+    ASSERT_TRUE(wait_until([&]() { return stopped_count() > 0; }));
+    EXPECT_LT(stopped_count(), 20) << "모든 세션을 한꺼번에 닫으면 재접속이 몰린다";
+
+    ASSERT_EQ(drained.get_future().wait_for(std::chrono::seconds(3)), std::future_status::ready);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(stopped_count(), 20);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(300));
+
+    server->stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    work_guard.reset();
+    ioc.stop();
+    io_thread.join();
+    std::error_code ec;
+    std::filesystem::remove_all(history_dir, ec);
+}
@@ -0,0 +1,124 @@
+#include "../include/ChatRoom.hpp"
+#include "../include/ChatServer.hpp"
+#include "ChatServerFixture.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @class MultiRoomTest
+ * @brief 한 세션이 여러 방에 동시에 참여하고, 방별로 태그된 메시지를 한 연결로 받는지 검증하는 테스트 픽스처.
+ */
+class MultiRoomTest : public ChatServerFixture {
+protected:
+    MultiRoomTest() : ChatServerFixture("multi_room_test") {}
+
+    std::shared_ptr<FakeSession> connect(const std::string& nickname) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server_->join(session);
+        EXPECT_TRUE(register_nickname(session, nickname));
+        return session;
+    }
+};
+
+/**
+ * @brief 다른 방에 입장해도 이전 방에 남아 있고, 두 방의 메시지를 방 태그와 함께 모두 받는지 확인한다.
+ *        활성 방에서 나가면 남은 방이 활성 방이 되어야 한다.
+ */
+TEST_F(MultiRoomTest, SessionReceivesMessagesFromAllJoinedRooms) {
+    auto alice = connect("alice");
+    auto bob = connect("bob");
+    auto carol = connect("carol");
+
+    ASSERT_TRUE(server_->join_room("lobby", alice));
+    ASSERT_TRUE(server_->join_room("games", alice));
+    ASSERT_TRUE(server_->join_room("lobby", bob));
+    ASSERT_TRUE(server_->join_room("games", carol));
+
+    EXPECT_EQ(alice->current_room(), "games");
+    EXPECT_EQ(server_->rooms_of(alice), (std::vector<std::string>{"games", "lobby"}));
+    EXPECT_TRUE(server_->is_in_room("lobby", alice));
+    EXPECT_EQ(bob->count("alice'님이 'lobby' 방에서 나갔습니다"), 0u);
+
+    server_->broadcast_to_room("lobby", "hi lobby", bob);
+    server_->broadcast_to_room("games", "hi games", carol);
+    EXPECT_TRUE(alice->wait_for("[bob @ lobby]: hi lobby"));
+    EXPECT_TRUE(alice->wait_for("[carol @ games]: hi games"));
+    EXPECT_TRUE(alice->wait_for("#lobby:"));
+    EXPECT_EQ(bob->count("hi games"), 0u);
+
+    // 활성 방에서 나가면 남은 방이 활성 방이 된다
+    ASSERT_TRUE(server_->leave_room("games", alice));
+    EXPECT_EQ(alice->current_room(), "lobby");
+    EXPECT_FALSE(server_->leave_room("games", alice));
+    EXPECT_EQ(server_->rooms_of(alice), std::vector<std::string>{"lobby"});
+
+    // 연결이 끊기면 모든 방에서 나간다
+    server_->leave(alice);
+    ASSERT_TRUE(bob->wait_for("alice'님이 'lobby' 방에서 나갔습니다"));
+    EXPECT_TRUE(server_->rooms_of(alice).empty());
+}
+
+/**
+ * @brief 이미 참여 중인 방에 다시 입장하면 멤버십은 그대로 두고 활성 방만 바뀌는지 확인한다.
+ */
+TEST_F(MultiRoomTest, RejoiningSwitchesActiveRoomOnly) {
+    auto alice = connect("alice");
+    ASSERT_TRUE(server_->join_room("lobby", alice));
+    ASSERT_TRUE(server_->join_room("games", alice));
+    ASSERT_TRUE(server_->join_room("lobby", alice));
+    EXPECT_EQ(alice->current_room(), "lobby");
+    EXPECT_TRUE(alice->wait_for("'lobby' 방이 활성 방이 되었습니다"));
+    EXPECT_EQ(server_->rooms_of(alice).size(), 2u);
+}
+
+/**
+ * @brief 명단이 입장/퇴장/닉네임 변경마다 버전을 올리고, 퇴장 후에도 남은 멤버만 페이지로 돌려주는지 확인한다.
+ */
+TEST(RoomRosterTest, RosterTracksMembershipWithVersions) {
+    net::io_context ioc;
+    ChatRoom room("lobby");
+    std::vector<std::shared_ptr<FakeSession>> members;
+    for (std::size_t i = 0; i < ChatRoom::roster_page_size + 5; ++i) {
+        members.push_back(std::make_shared<FakeSession>(ioc, "user" + std::to_string(i)));
+        ASSERT_TRUE(room.join(members.back()));
+    }
+    EXPECT_EQ(room.roster_version(), ChatRoom::roster_page_size + 5);
+    EXPECT_EQ(room.roster_page_count(), 2u);
+    EXPECT_EQ(room.roster_page(2), "user50, user51, user52, user53, user54");
+    EXPECT_EQ(room.roster_page(3), "");
+
+    room.leave(members[0]);  // 마지막 멤버가 빈 자리로 옮겨진다
+    EXPECT_EQ(room.roster_page(1).rfind("user54, user1,", 0), 0u);
+    EXPECT_EQ(room.roster_page(2), "user50, user51, user52, user53");
+
+    std::uint64_t before = room.roster_version();
+    EXPECT_TRUE(room.rename_participant(members[1], "renamed"));
+    EXPECT_EQ(room.roster_version(), before + 1);
+    EXPECT_NE(room.roster_page(1).find("renamed"), std::string::npos);
+    EXPECT_FALSE(room.rename_participant(members[0], "gone"));
+}
+
+/**
+ * @brief 입장한 세션은 자기 이름에 "(You)"가 붙은 첫 페이지 명단을, 기존 멤버는 버전이 붙은 입장 알림 한 줄만 받는지 확인한다.
+ */
+TEST_F(MultiRoomTest, JoinSendsSnapshotToJoinerAndDeltaToMembers) {
+    auto alice = connect("alice");
+    auto bob = connect("bob");
+    ASSERT_TRUE(server_->join_room("lobby", alice));
+    ASSERT_TRUE(server_->join_room("lobby", bob));
+
+    EXPECT_TRUE(bob->wait_for("현재 멤버 (2): alice, bob (You) [v2]"));
+    EXPECT_TRUE(alice->wait_for("사용자 'bob'님이 방에 들어왔습니다. [v2]"));
+    EXPECT_EQ(alice->count("현재 멤버 (2)"), 0u);
+    EXPECT_EQ(server_->room_roster_page("lobby", 1), "* 'lobby' 멤버 (2) 1/1 [v2]: alice, bob\r\n");
+    EXPECT_EQ(server_->room_roster_page("lobby", 2), "");
+}
@@ -0,0 +1,194 @@
+#include "../include/ChatServer.hpp"
+#include "../include/PasswordHasher.hpp"
+#include "ChatServerFixture.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+namespace {
+    /// 테스트가 빨리 끝나도록 낮춘 비용 (N = 2^10)
+    KdfParams fast_params() {
+        KdfParams params;
+        params.log2_n = 10;
+        return params;
+    }
+}
+
+/**
+ * @brief 해시가 매번 다른 솔트를 쓰고, 맞는 비밀번호만 통과하며, 형식이 잘못된 값은 거부하는지 확인한다.
+ */
+TEST(PasswordHasherTest, HashesAndVerifies) {
+    std::string first = PasswordHasher::hash("correct horse", fast_params());
+    std::string second = PasswordHasher::hash("correct horse", fast_params());
+    ASSERT_EQ(first.rfind("$scrypt$ln=10,r=8,p=1$", 0), 0u);
+    EXPECT_NE(first, second);
+    EXPECT_TRUE(PasswordHasher::verify("correct horse", first));
+    EXPECT_TRUE(PasswordHasher::verify("correct horse", second));
+    EXPECT_FALSE(PasswordHasher::verify("wrong horse", first));
+    EXPECT_FALSE(PasswordHasher::verify("correct horse", ""));
+    EXPECT_FALSE(PasswordHasher::verify("correct horse", "hashed_correct horse"));
+    EXPECT_FALSE(PasswordHasher::verify("correct horse", "$scrypt$ln=40,r=8,p=1$00$00"));
+    EXPECT_FALSE(PasswordHasher::verify("correct horse", first.substr(0, first.size() - 1)));
+}
+
+/**
+ * @brief 큐가 가득 차면 요청을 바로 거절하고, 멈추면 대기 중인 작업을 버리는지 확인한다.
+ */
+TEST(PasswordHasherTest, BoundedQueueRejectsWhenFull) {
+    PasswordHasher hasher(1, 2, fast_params());
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::atomic<int> done{0};
+
+    // 작업 스레드를 붙잡아 둔 뒤 큐를 채운다.
+    std::promise<void> started;
+    ASSERT_TRUE(hasher.hash_async("a", [&, gate](std::string) { started.set_value(); gate.wait(); ++done; }));
+    started.get_future().wait();
+    EXPECT_TRUE(hasher.hash_async("b", [&](std::string encoded) { EXPECT_FALSE(encoded.empty()); ++done; }));
+    EXPECT_TRUE(hasher.verify_async("c", "", [&](bool ok) { EXPECT_FALSE(ok); ++done; }));
+    EXPECT_FALSE(hasher.hash_async("d", [&](std::string) { ++done; }));
+    EXPECT_EQ(hasher.queued(), 2u);
+
+    release.set_value();
+    for (int i = 0; i < 200 && done < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(done, 3);
+
+    hasher.stop();
+    EXPECT_FALSE(hasher.hash_async("e", [&](std::string) { ++done; }));
+}
+
+/**
+ * @brief 토큰이 발급받은 사용자에게만 유효하고, 만료/폐기/개수 한도에 따라 사라지는지 확인한다.
+ */
+TEST(CredentialCacheTest, TokensExpireAndRevoke) {
+    CredentialCache cache(std::chrono::seconds(1), 3);
+    std::string alice = cache.issue("alice");
+    ASSERT_EQ(alice.size(), 32u);
+    EXPECT_TRUE(cache.check("alice", alice));
+    EXPECT_FALSE(cache.check("bob", alice));
+    EXPECT_FALSE(cache.check("alice", "deadbeef"));
+
+    std::string bob = cache.issue("bob");
+    cache.revoke_user("bob");
+    EXPECT_FALSE(cache.check("bob", bob));
+    EXPECT_TRUE(cache.check("alice", alice));
+
+    // 한도(3개)를 넘으면 가장 먼저 발급한 토큰부터 버린다.
+    cache.issue("carol");
+    cache.issue("dave");
+    cache.issue("erin");
+    EXPECT_FALSE(cache.check("alice", alice));
+    EXPECT_LE(cache.size(), 3u);
+
+    std::string late = cache.issue("frank");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(cache.check("frank", late));
+
+    cache.set_ttl(std::chrono::seconds(0));
+    EXPECT_TRUE(cache.issue("gina").empty());
+}
+
+/**
+ * @class ChatAuthTest
+ * @brief `ChatServer`의 등록/로그인 흐름을 검증하는 테스트 픽스처.
+ */
+class ChatAuthTest : public ChatServerFixture {
+protected:
+    ChatAuthTest() : ChatServerFixture("auth_test") {}
+
+    void configure(ChatServer& server) override { server.set_password_hashing(1, 4, fast_params()); }
+
+    ChatServer::AuthStatus register_user(const std::shared_ptr<FakeSession>& session, const std::string& user,
+                                         const std::string& password) {
+        std::promise<ChatServer::AuthStatus> result;
+        server_->register_user_async(user, password, session, [&result](ChatServer::AuthStatus status) {
+            result.set_value(status);
+        });
+        return result.get_future().get();
+    }
+
+    std::pair<ChatServer::AuthStatus, std::string> login(const std::shared_ptr<FakeSession>& session, const std::string& user,
+                                                         const std::string& secret, bool with_token = false) {
+        std::promise<std::pair<ChatServer::AuthStatus, std::string>> result;
+        auto handler = [&result](ChatServer::AuthStatus status, std::string token) {
+            result.set_value({status, token});
+        };
+        if (with_token)
+            server_->authenticate_token_async(user, secret, session, handler);
+        else
+            server_->authenticate_user_async(user, secret, session, handler);
+        return result.get_future().get();
+    }
+};
+
+/**
+ * @brief 등록한 계정으로 로그인하면 토큰을 받고, 토큰으로 다시 로그인할 수 있는지 확인한다.
+ */
+TEST_F(ChatAuthTest, RegisterLoginAndTokenRelogin) {
+    auto session = std::make_shared<FakeSession>(ioc_, "alice");
+    EXPECT_EQ(register_user(session, "alice", "s3cret"), ChatServer::AuthStatus::Ok);
+    EXPECT_EQ(register_user(session, "alice", "other"), ChatServer::AuthStatus::Failed);
+    EXPECT_EQ(register_user(session, "bad name", "x"), ChatServer::AuthStatus::Failed);
+
+    EXPECT_EQ(login(session, "alice", "wrong").first, ChatServer::AuthStatus::Failed);
+    EXPECT_EQ(login(session, "nobody", "s3cret").first, ChatServer::AuthStatus::Failed);
+    EXPECT_FALSE(session->is_authenticated());
+
+    auto [status, token] = login(session, "alice", "s3cret");
+    ASSERT_EQ(status, ChatServer::AuthStatus::Ok);
+    EXPECT_TRUE(session->is_authenticated());
+    ASSERT_FALSE(token.empty());
+
+    auto reconnect = std::make_shared<FakeSession>(ioc_, "alice2");
+    EXPECT_EQ(login(reconnect, "alice", token, true).first, ChatServer::AuthStatus::Ok);
+    EXPECT_TRUE(reconnect->is_authenticated());
+    auto intruder = std::make_shared<FakeSession>(ioc_, "mallory");
+    EXPECT_EQ(login(intruder, "mallory", token, true).first, ChatServer::AuthStatus::Failed);
+    EXPECT_FALSE(intruder->is_authenticated());
+}
+
+/**
+ * @brief 로그인이 몰리면 큐를 넘는 요청은 바로 거절되고, 그동안 채팅 처리(닉네임 등록)는 기다리지 않는지 확인한다.
+ */
+TEST_F(ChatAuthTest, LoginStormDoesNotStallChat) {
+    auto session = std::make_shared<FakeSession>(ioc_, "alice");
+    ASSERT_EQ(register_user(session, "alice", "s3cret"), ChatServer::AuthStatus::Ok);
+    server_->set_password_hashing(1, 4, KdfParams{14, 8, 1});
+
+    std::atomic<int> ok{0};
+    std::atomic<int> busy{0};
+    std::atomic<int> finished{0};
+    for (int i = 0; i < 20; ++i) {
+        server_->authenticate_user_async("alice", "wrong", session, [&](ChatServer::AuthStatus status, std::string) {
+            if (status == ChatServer::AuthStatus::Busy) ++busy;
+            else ++ok;
+            ++finished;
+        });
+    }
+
+    auto chatter = std::make_shared<FakeSession>(ioc_, "bob");
+    server_->join(chatter);
+    auto started = std::chrono::steady_clock::now();
+    std::promise<bool> registered;
+    server_->try_register_nickname_async("bob", chatter, [&registered](bool success) { registered.set_value(success); });
+    EXPECT_TRUE(registered.get_future().get());
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(100));
+
+    for (int i = 0; i < 500 && finished < 20; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(finished, 20);
+    EXPECT_GE(busy, 15);
+    EXPECT_EQ(ok + busy, 20);
+}
@@ -0,0 +1,222 @@
+#include "../include/handlers/PhotoRenditions.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+#ifdef CHERRY_HAVE_JPEG
+#include <jpeglib.h>
+#endif
+
+namespace {
+    std::filesystem::path temp_dir(const std::string& name) {
+        auto dir = std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()));
+        std::filesystem::remove_all(dir);
+        return dir;
+    }
+
+#ifdef CHERRY_HAVE_JPEG
+    /// 가로 그라데이션 JPEG
+    std::string make_jpeg(int width, int height) {
+        jpeg_compress_struct cinfo;
+        jpeg_error_mgr err;
+        cinfo.err = jpeg_std_error(&err);
+        jpeg_create_compress(&cinfo);
+        unsigned char* buffer = nullptr;
+        unsigned long size = 0;
+        jpeg_mem_dest(&cinfo, &buffer, &size);
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_start_compress(&cinfo, TRUE);
+        std::vector<unsigned char> row(static_cast<std::size_t>(width) * 3);
+        for (int x = 0; x < width; ++x) {
+            row[x * 3] = row[x * 3 + 1] = row[x * 3 + 2] = static_cast<unsigned char>(x * 255 / width);
+        }
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW ptr = row.data();
+            jpeg_write_scanlines(&cinfo, &ptr, 1);
+        }
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+        std::string out(reinterpret_cast<const char*>(buffer), size);
+        std::free(buffer);
+        return out;
+    }
+
+    int jpeg_width(const std::string& data) {
+        jpeg_decompress_struct cinfo;
+        jpeg_error_mgr err;
+        cinfo.err = jpeg_std_error(&err);
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char*>(const_cast<char*>(data.data())), data.size());
+        jpeg_read_header(&cinfo, TRUE);
+        int width = static_cast<int>(cinfo.image_width);
+        jpeg_destroy_decompress(&cinfo);
+        return width;
+    }
+#endif
+}
+
+/**
+ * @brief 크기 등급/형식 이름을 해석하고, 모르는 이름은 거절하는지 확인한다.
+ */
+TEST(PhotoRenditionsTest, ParsesSizeClassesAndFormats) {
+    EXPECT_EQ(PhotoRenditions::widthFor("thumb"), 320);
+    EXPECT_EQ(PhotoRenditions::widthFor("medium"), 800);
+    EXPECT_EQ(PhotoRenditions::widthFor("full"), 0);
+    EXPECT_FALSE(PhotoRenditions::widthFor("huge").has_value());
+    EXPECT_EQ(PhotoRenditions::parseFormat("webp"), PhotoRenditions::Format::Webp);
+    EXPECT_EQ(PhotoRenditions::parseFormat("jpeg"), PhotoRenditions::Format::Jpeg);
+    EXPECT_FALSE(PhotoRenditions::parseFormat("gif").has_value());
+}
+
+/**
+ * @brief 원본을 내용 해시로 디스크에 두고 다시 시작해도 찾으며, JPEG가 아닌 원본은 축소하지 않고 보내는지 확인한다.
+ */
+TEST(PhotoRenditionsTest, StoresOriginalsByContentHash) {
+    auto dir = temp_dir("photo_renditions_store");
+    PhotoRenditionsConfig config;
+    config.cache_dir = dir.string();
+    {
+        PhotoRenditions photos(config);
+        EXPECT_FALSE(photos.original("places/a/photos/1").has_value());
+        auto first = photos.storeOriginal("places/a/photos/1", "png-bytes", "image/png");
+        auto second = photos.storeOriginal("places/b/photos/2", "png-bytes", "image/png");
+        EXPECT_EQ(first.hash, second.hash);   // 같은 내용은 한 벌만
+
+        auto thumb = photos.render(first, 320, PhotoRenditions::Format::Jpeg);
+        EXPECT_EQ(thumb.bytes, "png-bytes");
+        EXPECT_EQ(thumb.content_type, "image/png");
+        EXPECT_FALSE(thumb.etag.empty());
+    }
+
+    PhotoRenditions reopened(config);
+    auto found = reopened.original("places/b/photos/2");
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(found->bytes, "png-bytes");
+    EXPECT_EQ(found->content_type, "image/png");
+    auto full = reopened.lookup("places/a/photos/1", 0, PhotoRenditions::Format::Jpeg);
+    ASSERT_TRUE(full.has_value());
+    EXPECT_EQ(full->bytes, "png-bytes");
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * @brief 디스크 사용량이 한도를 넘으면 한도의 90% 아래로 파일을 지우는지 확인한다.
+ */
+TEST(PhotoRenditionsTest, EvictsWhenOverDiskLimit) {
+    auto dir = temp_dir("photo_renditions_evict");
+    PhotoRenditionsConfig config;
+    config.cache_dir = dir.string();
+    config.max_disk_bytes = 2000;
+    PhotoRenditions photos(config);
+    for (int i = 0; i < 10; ++i) {
+        photos.storeOriginal("ref" + std::to_string(i), std::string(400, static_cast<char>('a' + i)), "image/png");
+    }
+    auto metrics = photos.metrics();
+    EXPECT_LE(metrics.disk_bytes, config.max_disk_bytes);
+    EXPECT_GT(metrics.evicted, 0u);
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * @brief JPEG 원본을 크기 등급 너비로 줄여 디스크에 두고, 원본보다 큰 등급은 원본을 그대로 쓰는지 확인한다.
+ */
+TEST(PhotoRenditionsTest, ResizesJpegAndCachesRendition) {
+    if (!PhotoRenditions::canResize()) {
+        GTEST_SKIP() << "built without libjpeg-turbo";
+    }
+#ifdef CHERRY_HAVE_JPEG
+    auto dir = temp_dir("photo_renditions_resize");
+    PhotoRenditionsConfig config;
+    config.cache_dir = dir.string();
+    PhotoRenditions photos(config);
+
+    auto original = photos.storeOriginal("places/a/photos/1", make_jpeg(1600, 1200), "image/jpeg");
+    EXPECT_FALSE(photos.lookup("places/a/photos/1", 320, PhotoRenditions::Format::Jpeg).has_value());
+
+    auto thumb = photos.render(original, 320, PhotoRenditions::Format::Jpeg);
+    EXPECT_EQ(thumb.content_type, "image/jpeg");
+    EXPECT_EQ(jpeg_width(thumb.bytes), 320);
+    EXPECT_LT(thumb.bytes.size(), original.bytes.size());
+    EXPECT_EQ(photos.metrics().rendered, 1u);
+
+    auto cached = photos.lookup("places/a/photos/1", 320, PhotoRenditions::Format::Jpeg);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->bytes, thumb.bytes);
+    EXPECT_EQ(cached->etag, thumb.etag);
+
+    // 원본(600px)이 등급(800px)보다 작으면 확대하지 않는다.
+    auto small = photos.storeOriginal("places/b/photos/2", make_jpeg(600, 400), "image/jpeg");
+    auto medium = photos.render(small, 800, PhotoRenditions::Format::Jpeg);
+    EXPECT_EQ(medium.bytes, small.bytes);
+    EXPECT_FALSE(medium.fallback);
+    // 원본과 같은 내용의 사본 파일은 만들지 않는다.
+    EXPECT_FALSE(photos.lookup("places/b/photos/2", 800, PhotoRenditions::Format::Jpeg).has_value());
+    EXPECT_EQ(photos.metrics().rendered, 1u);
+
+    // WebP를 만들 수 없는 빌드는 JPEG로 답한다.
+    auto webp = photos.render(original, 800, PhotoRenditions::Format::Webp);
+    EXPECT_EQ(webp.content_type,
+              PhotoRenditions::canEncode(PhotoRenditions::Format::Webp) ? "image/webp" : "image/jpeg");
+    std::filesystem::remove_all(dir);
+#endif
+}
+
+/**
+ * @brief 디스크 캐시가 없으면 최근 원본을 `memory_originals`개까지 메모리에 두고, 가장 오래 쓰지 않은 것부터 버리는지 확인한다.
+ */
+TEST(PhotoRenditionsTest, KeepsRecentOriginalsInMemoryWithoutDiskCache) {
+    PhotoRenditionsConfig config;
+    config.memory_originals = 2;
+    PhotoRenditions photos(config);
+    EXPECT_FALSE(photos.original("ref1").has_value());
+
+    photos.storeOriginal("ref1", "one", "image/png");
+    photos.storeOriginal("ref2", "two", "image/png");
+    ASSERT_TRUE(photos.original("ref1").has_value());   // ref1을 최근에 씀
+    photos.storeOriginal("ref3", "three", "image/png");
+
+    auto first = photos.original("ref1");
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->bytes, "one");
+    EXPECT_EQ(first->content_type, "image/png");
+    EXPECT_FALSE(photos.original("ref2").has_value());
+    EXPECT_TRUE(photos.original("ref3").has_value());
+}
+
+/**
+ * @brief 사본을 만들지 못해 원본을 대신 보낼 때는 `fallback`으로 표시하고, 사본과 다른 ETag를 붙이는지 확인한다.
+ */
+TEST(PhotoRenditionsTest, MarksFallbackWhenRenditionFails) {
+    if (!PhotoRenditions::canResize()) {
+        GTEST_SKIP() << "built without libjpeg-turbo";
+    }
+#ifdef CHERRY_HAVE_JPEG
+    auto dir = temp_dir("photo_renditions_fallback");
+    PhotoRenditionsConfig config;
+    config.cache_dir = dir.string();
+    PhotoRenditions photos(config);
+
+    auto broken = photos.storeOriginal("places/a/photos/1", "not a jpeg", "image/jpeg");
+    auto thumb = photos.render(broken, 320, PhotoRenditions::Format::Jpeg);
+    EXPECT_TRUE(thumb.fallback);
+    EXPECT_EQ(thumb.bytes, "not a jpeg");
+    EXPECT_EQ(photos.metrics().fallbacks, 1u);
+
+    // 같은 원본의 320px 사본 ETag(`"<해시>-320j"`)나 원본 ETag와 겹치지 않는다.
+    EXPECT_NE(thumb.etag, "\"" + broken.hash.substr(0, 32) + "-320j\"");
+    EXPECT_NE(thumb.etag, photos.render(broken, 0, PhotoRenditions::Format::Jpeg).etag);
+
+    auto good = photos.storeOriginal("places/b/photos/2", make_jpeg(1600, 1200), "image/jpeg");
+    EXPECT_FALSE(photos.render(good, 320, PhotoRenditions::Format::Jpeg).fallback);
+    std::filesystem::remove_all(dir);
+#endif
+}
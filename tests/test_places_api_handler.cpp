@@ -0,0 +1,434 @@
+#include "../include/handlers/PlacesApiHandler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    http::request<http::string_body> post_json(const std::string& target, const std::string& body) {
+        http::request<http::string_body> req{http::verb::post, target, 11};
+        req.set(http::field::content_type, "application/json");
+        req.body() = body;
+        req.prepare_payload();
+        return req;
+    }
+
+    /**
+     * @brief 네트워크 없이 응답하는 가짜 Google Places API. 검색은 `ids`의 장소를, 상세 조회는 요청한 장소 하나를 돌려준다.
+     * @note 응답은 `callGooglePlacesApi`가 돌려주는 형식(검색은 `{"places": [{"id", "name", "addr", "loc"}]}`)을 따르고,
+     * 실제 API처럼 필드 마스크/`fields`에 있는 필드만 채운다.
+     */
+    struct FakeGoogle {
+        std::vector<std::string> ids;
+        std::string missing; ///< 상세 조회하면 404를 돌려줄 장소 ID
+        std::atomic<bool> unreachable{false}; ///< 참이면 연결 오류처럼 "error" 필드만 있는 객체를 돌려준다
+        std::atomic<int> searches{0};
+        std::atomic<int> details{0};
+
+        PlacesApiHandler::UpstreamTransport transport() {
+            return [this](http::verb method, const std::string& endpoint, const json::value&,
+                          const std::string& field_mask) -> json::value {
+                if (unreachable) {
+                    json::object error_obj;
+                    error_obj["error"] = "Connection refused";
+                    return error_obj;
+                }
+                if (method == http::verb::post) {
+                    ++searches;
+                    json::array places;
+                    for (std::size_t i = 0; i < ids.size(); ++i) {
+                        json::object loc;
+                        loc["lat"] = 37.5 + 0.001 * static_cast<double>(i);
+                        loc["lng"] = 127.0;
+                        json::object item;
+                        item["id"] = ids[i];
+                        item["name"] = "Place " + ids[i];
+                        item["addr"] = "Seoul";
+                        item["loc"] = std::move(loc);
+                        if (field_mask.find("places.rating") != std::string::npos) {
+                            item["rating"] = 4.5;
+                            item["ratingCount"] = 10;
+                        }
+                        places.push_back(std::move(item));
+                    }
+                    json::object result;
+                    result["places"] = std::move(places);
+                    return result;
+                }
+                ++details;
+                std::string id = endpoint.substr(endpoint.find("/places/") + 8);
+                std::string fields = id.substr(id.find("?fields=") + 8);
+                id = id.substr(0, id.find('?'));
+                if (id == missing) {
+                    json::object error_obj;
+                    error_obj["__error_status_code"] = 404;
+                    error_obj["__error_body"] = "{\"error\":\"not found\"}";
+                    return error_obj;
+                }
+                json::object name;
+                name["text"] = "Place " + id;
+                json::object location;
+                location["latitude"] = 37.5;
+                location["longitude"] = 127.0;
+                json::object place;
+                place["id"] = id;
+                place["displayName"] = std::move(name);
+                place["formattedAddress"] = "Seoul";
+                place["location"] = std::move(location);
+                place["rating"] = 4.5;
+                place["userRatingCount"] = 10;
+                place["reviews"] = json::array();
+                json::object photo;
+                photo["name"] = "places/" + id + "/photos/p1";
+                json::array photos;
+                photos.push_back(std::move(photo));
+                place["photos"] = std::move(photos);
+
+                json::object requested;
+                std::stringstream ss(fields);
+                std::string field;
+                while (std::getline(ss, field, ',')) {
+                    if (const json::value* value = place.if_contains(field)) {
+                        requested[field] = *value;
+                    }
+                }
+                return requested;
+            };
+        }
+    };
+
+    /// `handleMetrics` 본문에서 지표 값을 읽는다. 없으면 0.
+    std::uint64_t metric(const PlacesApiHandler& handler, const std::string& name) {
+        std::string body = handler.handleMetrics().body();
+        auto pos = body.find("\n" + name + " ");
+        return pos == std::string::npos ? 0 : std::stoull(body.substr(pos + name.size() + 2));
+    }
+
+    /// 객체의 최상위 키 목록
+    std::set<std::string> keysOf(const json::value& value) {
+        std::set<std::string> keys;
+        for (const auto& field : value.as_object()) {
+            keys.emplace(field.key().data(), field.key().size());
+        }
+        return keys;
+    }
+
+    /// 백그라운드 작업이 끝나 `done`이 참이 될 때까지 최대 2초 기다린다.
+    bool waitFor(const std::function<bool()>& done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief 배치 상세 조회가 업스트림을 호출하기 전에 잘못된 요청(빈 목록, 한도 초과, URL에 넣을 수 없는 ID)을 거절하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, BatchDetailsRejectsInvalidRequests) {
+    PlacesApiHandler handler("test-key");
+
+    EXPECT_EQ(handler.handleBatchDetails(post_json("/places/details:batch", "not json")).result(),
+              http::status::bad_request);
+    EXPECT_EQ(handler.handleBatchDetails(post_json("/places/details:batch", "{\"ids\":[]}")).result(),
+              http::status::bad_request);
+
+    std::string many = "{\"ids\":[";
+    for (int i = 0; i < 21; ++i) {
+        many += (i == 0 ? "\"p" : ",\"p") + std::to_string(i) + "\"";
+    }
+    many += "]}";
+    EXPECT_EQ(handler.handleBatchDetails(post_json("/places/details:batch", many)).result(),
+              http::status::bad_request);
+
+    auto bad_id = handler.handleBatchDetails(post_json("/places/details:batch", "{\"ids\":[\"ok\",\"../key?x\"]}"));
+    EXPECT_EQ(bad_id.result(), http::status::bad_request);
+    EXPECT_NE(bad_id.body().find("Invalid place ID"), std::string::npos);
+}
+
+/**
+ * @brief 모르는 projection 이름은 업스트림을 호출하기 전에 400으로 거절하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, RejectsUnknownProjection) {
+    PlacesApiHandler handler("test-key");
+
+    EXPECT_NE(PlacesApiHandler::findProjection("summary"), nullptr);
+    EXPECT_NE(PlacesApiHandler::findProjection("full"), nullptr);
+    EXPECT_EQ(PlacesApiHandler::findProjection("everything"), nullptr);
+
+    EXPECT_EQ(handler.handlePlaceDetails("ChIJabc", "everything").result(), http::status::bad_request);
+    EXPECT_EQ(handler.handleBatchDetails(post_json("/places/details:batch",
+                                                   "{\"ids\":[\"a\"],\"projection\":\"everything\"}")).result(),
+              http::status::bad_request);
+    EXPECT_EQ(handler.handleTextSearch(post_json("/places/search",
+                                                 "{\"query\":\"cafe\",\"projection\":\"everything\"}")).result(),
+              http::status::bad_request);
+}
+
+/**
+ * @brief 자동 완성이 가져온 장소 목록에서 Google 호출 없이 답하고, 잘못된 요청은 400으로 거절하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, AutocompleteServesFromLocalIndex) {
+    auto path = std::filesystem::temp_directory_path() / ("places_local_" + std::to_string(::getpid()) + ".jsonl");
+    {
+        std::ofstream out(path);
+        out << "{\"id\":\"near\",\"name\":\"스타벅스 강남점\",\"addr\":\"서울 강남구\",\"loc\":{\"lat\":37.4989,\"lng\":127.0276}}\n";
+        out << "{\"id\":\"far\",\"name\":\"스타벅스 역삼점\",\"addr\":\"서울 강남구\",\"loc\":{\"lat\":37.5179,\"lng\":127.0276}}\n";
+        out << "not json\n";
+    }
+    PlacesApiHandler handler("test-key");
+    EXPECT_EQ(handler.importLocalPlaces(path.string()), 2u);
+    std::filesystem::remove(path);
+
+    auto res = handler.handleAutocomplete(post_json("/places/autocomplete",
+        "{\"input\":\"스타\",\"latitude\":37.4979,\"longitude\":127.0276}"));
+    ASSERT_EQ(res.result(), http::status::ok);
+    json::value body = json::parse(res.body());
+    const auto& suggestions = body.at("suggestions").as_array();
+    ASSERT_EQ(suggestions.size(), 2u);
+    EXPECT_EQ(suggestions[0].at("id").as_string(), "near");
+    EXPECT_EQ(handler.upstreamGuard().metrics().admitted, 0u);
+
+    EXPECT_EQ(handler.handleAutocomplete(post_json("/places/autocomplete", "{\"input\":\"\"}")).result(),
+              http::status::bad_request);
+    EXPECT_EQ(handler.handleAutocomplete(post_json("/places/autocomplete", "{\"input\":\"a\",\"limit\":0}")).result(),
+              http::status::bad_request);
+}
+
+/**
+ * @brief 모르는 사진 크기 등급/형식은 업스트림을 호출하기 전에 400으로 거절하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, PhotoRejectsUnknownSizeOrFormat) {
+    PlacesApiHandler handler("test-key");
+
+    EXPECT_EQ(handler.handlePlacePhoto("places/a/photos/b", "huge").result(), http::status::bad_request);
+    EXPECT_EQ(handler.handlePlacePhoto("places/a/photos/b", "thumb", "gif").result(), http::status::bad_request);
+    EXPECT_EQ(handler.upstreamGuard().metrics().admitted, 0u);
+}
+
+/**
+ * @brief 미리 받기가 분당 예산(`per_minute`)을 넘지 않고, 예산이 떨어지면 나머지 장소를 건너뛰는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, PrefetchStaysWithinPerMinuteBudget) {
+    PlacesPrefetchConfig prefetch;
+    prefetch.top_k = 3;
+    prefetch.per_minute = 2;
+    PlacesApiHandler handler("test-key", {}, {}, prefetch);
+    FakeGoogle google;
+    google.ids = {"a", "b", "c"};
+    handler.setUpstreamTransport(google.transport());
+
+    auto res = handler.handleTextSearch(post_json("/places/search", "{\"query\":\"cafe\"}"));
+    ASSERT_EQ(res.result(), http::status::ok);
+
+    EXPECT_EQ(metric(handler, "places_prefetch_started_total"), 2u);
+    EXPECT_EQ(metric(handler, "places_prefetch_skipped_total"), 1u);
+    ASSERT_TRUE(waitFor([&] { return google.details == 2; }));
+    EXPECT_TRUE(waitFor([&] { return metric(handler, "places_cache_entries") == 3; }));
+    EXPECT_EQ(google.details.load(), 2);
+}
+
+/**
+ * @brief 미리 받기는 동시성 한도의 `max_utilization` 비율 안에서만 업스트림을 호출하는지 확인한다. (0이면 호출하지 않음)
+ */
+TEST(PlacesApiHandlerTest, PrefetchRespectsMaxUtilization) {
+    PlacesPrefetchConfig prefetch;
+    prefetch.top_k = 2;
+    prefetch.max_utilization = 0.0;
+    PlacesApiHandler handler("test-key", {}, {}, prefetch);
+    FakeGoogle google;
+    google.ids = {"a", "b"};
+    handler.setUpstreamTransport(google.transport());
+
+    auto res = handler.handleTextSearch(post_json("/places/search", "{\"query\":\"cafe\"}"));
+    ASSERT_EQ(res.result(), http::status::ok);
+
+    EXPECT_EQ(metric(handler, "places_prefetch_started_total"), 2u);
+    ASSERT_TRUE(waitFor([&] { return metric(handler, "places_prefetch_skipped_total") == 2; }));
+    EXPECT_EQ(google.details.load(), 0);
+    EXPECT_EQ(handler.upstreamGuard().metrics().rejected_overload, 2u);
+}
+
+/**
+ * @brief 이미 신선한 상세 정보가 캐시에 있는 장소는 다시 미리 받지 않는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, PrefetchSkipsFreshCacheEntries) {
+    PlacesPrefetchConfig prefetch;
+    prefetch.top_k = 2;
+    PlacesApiHandler handler("test-key", {}, {}, prefetch);
+    FakeGoogle google;
+    google.ids = {"a", "b"};
+    handler.setUpstreamTransport(google.transport());
+
+    ASSERT_EQ(handler.handleTextSearch(post_json("/places/search", "{\"query\":\"cafe\"}")).result(),
+              http::status::ok);
+    ASSERT_TRUE(waitFor([&] { return metric(handler, "places_cache_entries") == 3; }));
+    EXPECT_EQ(google.details.load(), 2);
+
+    // 다른 검색어라 검색은 다시 Google로 가지만, 같은 장소의 상세 정보는 캐시에 있다.
+    ASSERT_EQ(handler.handleTextSearch(post_json("/places/search", "{\"query\":\"bakery\"}")).result(),
+              http::status::ok);
+    EXPECT_EQ(google.searches.load(), 2);
+    EXPECT_EQ(metric(handler, "places_prefetch_started_total"), 2u);
+    EXPECT_EQ(metric(handler, "places_prefetch_skipped_total"), 0u);
+    EXPECT_EQ(google.details.load(), 2);
+}
+
+/**
+ * @brief 배치 상세 조회가 요청 순서대로 답하고, 캐시에 있는 장소는 가져오지 않으며,
+ * 한 장소가 실패해도 그 항목만 오류로 표시하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, BatchDetailsKeepsOrderAndReportsPerItemErrors) {
+    PlacesApiHandler handler("test-key");
+    FakeGoogle google;
+    google.missing = "gone";
+    handler.setUpstreamTransport(google.transport());
+
+    ASSERT_EQ(handler.handlePlaceDetails("a").result(), http::status::ok);
+    EXPECT_EQ(google.details.load(), 1);
+
+    auto res = handler.handleBatchDetails(post_json("/places/details:batch",
+        "{\"ids\":[\"c\",\"a\",\"gone\",\"b\"]}"));
+    ASSERT_EQ(res.result(), http::status::ok);
+    // "a"는 캐시에서 채우므로 c, gone, b만 Google에 묻는다.
+    EXPECT_EQ(google.details.load(), 4);
+
+    json::value body = json::parse(res.body());
+    const auto& places = body.at("places").as_array();
+    ASSERT_EQ(places.size(), 4u);
+    const char* expected_ids[] = {"c", "a", "gone", "b"};
+    const int expected_status[] = {200, 200, 404, 200};
+    for (std::size_t i = 0; i < places.size(); ++i) {
+        EXPECT_EQ(places[i].at("id").as_string(), expected_ids[i]);
+        EXPECT_EQ(places[i].at("status").to_number<int>(), expected_status[i]);
+        if (expected_status[i] == 200) {
+            EXPECT_EQ(places[i].at("place").at("id").as_string(), expected_ids[i]);
+        } else {
+            EXPECT_TRUE(places[i].as_object().contains("error"));
+            EXPECT_FALSE(places[i].as_object().contains("place"));
+        }
+    }
+}
+
+/**
+ * @brief 동시성 한도가 가득 찬 배치 상세 조회가 장소마다 503을 내지 않고 허가를 기다려 모두 가져오는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, BatchDetailsWaitsForGuardPermits) {
+    UpstreamGuardConfig guard_config;
+    guard_config.initial_limit = 1;
+    guard_config.min_limit = 1;
+    guard_config.max_limit = 1;
+    guard_config.latency_target = std::chrono::seconds(10);
+    PlacesApiHandler handler("test-key", guard_config);
+    FakeGoogle google;
+    auto fake = google.transport();
+    handler.setUpstreamTransport([fake](http::verb method, const std::string& endpoint, const json::value& data,
+                                        const std::string& field_mask) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return fake(method, endpoint, data, field_mask);
+    });
+
+    auto res = handler.handleBatchDetails(post_json("/places/details:batch",
+        "{\"ids\":[\"a\",\"b\",\"c\",\"d\"]}"));
+    ASSERT_EQ(res.result(), http::status::ok);
+    EXPECT_EQ(google.details.load(), 4);
+    for (const auto& place : json::parse(res.body()).at("places").as_array()) {
+        EXPECT_EQ(place.at("status").to_number<int>(), 200);
+    }
+}
+
+/**
+ * @brief `summary`/`full` 상세 조회가 projection에 속한 필드만 돌려주고,
+ * 신선한 `full` 항목이 있으면 `summary` 요청을 Google 호출 없이 잘라서 채우는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, DetailsProjectionsReturnTheirFields) {
+    PlacesApiHandler handler("test-key");
+    FakeGoogle google;
+    handler.setUpstreamTransport(google.transport());
+
+    const std::set<std::string> summary_keys = {"id", "displayName", "formattedAddress", "location",
+                                                "rating", "userRatingCount"};
+    std::set<std::string> full_keys = summary_keys;
+    full_keys.insert({"reviews", "photos"});
+
+    auto summary = handler.handlePlaceDetails("s", "summary");
+    ASSERT_EQ(summary.result(), http::status::ok);
+    EXPECT_EQ(keysOf(json::parse(summary.body())), summary_keys);
+
+    auto full = handler.handlePlaceDetails("f", "full");
+    ASSERT_EQ(full.result(), http::status::ok);
+    EXPECT_EQ(keysOf(json::parse(full.body())), full_keys);
+    EXPECT_EQ(google.details.load(), 2);
+
+    auto trimmed = handler.handlePlaceDetails("f", "summary");
+    ASSERT_EQ(trimmed.result(), http::status::ok);
+    EXPECT_EQ(keysOf(json::parse(trimmed.body())), summary_keys);
+    EXPECT_EQ(google.details.load(), 2);
+}
+
+/**
+ * @brief 같은 검색의 신선한 `full` 응답이 있으면 `summary` 검색을 Google 호출 없이 평점/사진 필드를 빼고 답하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, SummarySearchServedFromFullCacheEntry) {
+    PlacesPrefetchConfig prefetch;
+    prefetch.top_k = 0;
+    PlacesApiHandler handler("test-key", {}, {}, prefetch);
+    FakeGoogle google;
+    google.ids = {"a", "b"};
+    handler.setUpstreamTransport(google.transport());
+
+    auto full = handler.handleTextSearch(post_json("/places/search", "{\"query\":\"cafe\",\"projection\":\"full\"}"));
+    ASSERT_EQ(full.result(), http::status::ok);
+    EXPECT_TRUE(json::parse(full.body()).at("places").at(0).as_object().contains("rating"));
+
+    auto summary = handler.handleTextSearch(post_json("/places/search", "{\"query\":\"cafe\"}"));
+    ASSERT_EQ(summary.result(), http::status::ok);
+    EXPECT_EQ(google.searches.load(), 1);
+    json::value body = json::parse(summary.body());
+    const auto& places = body.at("places").as_array();
+    ASSERT_EQ(places.size(), 2u);
+    EXPECT_EQ(keysOf(places[0]), (std::set<std::string>{"id", "name", "addr", "loc"}));
+}
+
+/**
+ * @brief Google에 연결하지 못한 주변 검색은 502로 답하고 커버된 영역으로 기록하지 않으며,
+ * 실제로 받은 응답만 다음 검색을 로컬에서 답하게 하는지 확인한다.
+ */
+TEST(PlacesApiHandlerTest, FailedNearbySearchIsNotCoveredLocally) {
+    PlacesPrefetchConfig prefetch;
+    prefetch.top_k = 0;
+    PlacesApiHandler handler("test-key", {}, {}, prefetch);
+    FakeGoogle google;
+    google.ids = {"a"};
+    google.unreachable = true;
+    handler.setUpstreamTransport(google.transport());
+    const std::string request = "{\"latitude\":37.5,\"longitude\":127.0,\"radius\":500.0}";
+
+    EXPECT_EQ(handler.handleNearbySearch(post_json("/places/nearby", request)).result(), http::status::bad_gateway);
+    EXPECT_EQ(handler.localIndex().size(), 0u);
+
+    google.unreachable = false;
+    auto res = handler.handleNearbySearch(post_json("/places/nearby", request));
+    ASSERT_EQ(res.result(), http::status::ok);
+    EXPECT_EQ(res.count("X-Places-Source"), 0u);
+    EXPECT_EQ(google.searches.load(), 1);
+
+    auto local = handler.handleNearbySearch(post_json("/places/nearby", request));
+    ASSERT_EQ(local.result(), http::status::ok);
+    EXPECT_EQ(local["X-Places-Source"], "local");
+    EXPECT_EQ(google.searches.load(), 1);
+}
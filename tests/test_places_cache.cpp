@@ -0,0 +1,122 @@
+#include "../include/handlers/PlacesCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+    PlacesCacheConfig memory_config(std::chrono::seconds soft_ttl, std::chrono::seconds hard_ttl) {
+        PlacesCacheConfig config;
+        config.soft_ttl = soft_ttl;
+        config.hard_ttl = hard_ttl;
+        return config;
+    }
+
+    json::value place(const std::string& name) {
+        json::object obj;
+        obj["name"] = name;
+        return obj;
+    }
+}
+
+/**
+ * @brief 저장한 지 얼마나 지났는지에 따라 Fresh / Stale / Expired로 나누는지 확인한다.
+ */
+TEST(PlacesCacheTest, ClassifiesBySoftAndHardTtl) {
+    PlacesCache fresh(memory_config(std::chrono::hours(1), std::chrono::hours(24)));
+    EXPECT_EQ(fresh.lookup("GET /places/a").state, PlacesCache::State::Miss);
+    fresh.put("GET /places/a", place("a"));
+    auto hit = fresh.lookup("GET /places/a");
+    EXPECT_EQ(hit.state, PlacesCache::State::Fresh);
+    EXPECT_EQ(hit.data.at("name").as_string(), "a");
+
+    PlacesCache stale(memory_config(std::chrono::seconds(0), std::chrono::hours(24)));
+    stale.put("k", place("a"));
+    EXPECT_EQ(stale.lookup("k").state, PlacesCache::State::Stale);
+
+    PlacesCache expired(memory_config(std::chrono::seconds(0), std::chrono::seconds(0)));
+    expired.put("k", place("a"));
+    auto old = expired.lookup("k");
+    EXPECT_EQ(old.state, PlacesCache::State::Expired);
+    EXPECT_EQ(old.data.at("name").as_string(), "a"); // 업스트림 실패 시 대신 보낼 수 있도록 데이터는 남는다
+}
+
+/**
+ * @brief 같은 키의 백그라운드 갱신은 한 번에 하나만 시작되는지 확인한다.
+ */
+TEST(PlacesCacheTest, RefreshIsDeduplicatedPerKey) {
+    PlacesCache cache;
+    EXPECT_TRUE(cache.beginRefresh("k"));
+    EXPECT_FALSE(cache.beginRefresh("k"));
+    EXPECT_TRUE(cache.beginRefresh("other"));
+    cache.endRefresh("k");
+    EXPECT_TRUE(cache.beginRefresh("k"));
+}
+
+/**
+ * @brief 한도를 넘으면 오래된 항목부터 버리는지 확인한다.
+ */
+TEST(PlacesCacheTest, EvictsOldestWhenFull) {
+    PlacesCacheConfig config;
+    config.max_entries = 10;
+    PlacesCache cache(config);
+    for (int i = 0; i < 11; ++i) {
+        cache.put("k" + std::to_string(i), place(std::to_string(i)));
+    }
+    EXPECT_LE(cache.size(), 10u);
+    EXPECT_EQ(cache.lookup("k10").state, PlacesCache::State::Fresh);
+}
+
+/**
+ * @brief 스냅샷을 저장했다가 새 인스턴스가 읽어 들이고, hard TTL이 지난 줄과 깨진 줄은 건너뛰는지 확인한다.
+ */
+TEST(PlacesCacheTest, SnapshotSurvivesRestart) {
+    auto dir = std::filesystem::temp_directory_path() / ("places_cache_test_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir);
+
+    PlacesCacheConfig config;
+    config.snapshot_path = (dir / "places.snapshot").string();
+    config.snapshot_interval = std::chrono::seconds(0); // 주기 저장은 사용하지 않음
+    {
+        PlacesCache cache(config);
+        EXPECT_EQ(cache.size(), 0u);
+        cache.put("GET /places/a", place("a"));
+        cache.put("POST search {\"q\":1}", place("b"));
+        EXPECT_TRUE(cache.save());
+    }
+    {
+        // 오래된 항목과 깨진 줄을 덧붙인다.
+        std::ofstream out(config.snapshot_path, std::ios::app);
+        out << "{\"k\":\"old\",\"t\":1000,\"v\":{\"name\":\"old\"}}\n";
+        out << "{not json\n";
+    }
+
+    PlacesCache restored(config);
+    EXPECT_EQ(restored.size(), 2u);
+    auto hit = restored.lookup("POST search {\"q\":1}");
+    EXPECT_EQ(hit.state, PlacesCache::State::Fresh);
+    EXPECT_EQ(hit.data.at("name").as_string(), "b");
+    EXPECT_EQ(restored.lookup("old").state, PlacesCache::State::Miss);
+
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * @brief `forEach`가 모든 항목을 저장 시각과 함께 돌려주는지 확인한다.
+ */
+TEST(PlacesCacheTest, ForEachVisitsAllEntries) {
+    PlacesCache cache;
+    cache.put("a", place("a"));
+    cache.put("b", place("b"));
+    std::size_t visited = 0;
+    cache.forEach([&visited](const std::string& key, const json::value& data, PlacesCache::Clock::time_point stored) {
+        EXPECT_EQ(data.at("name").as_string(), key);
+        EXPECT_LE(stored, PlacesCache::Clock::now());
+        ++visited;
+    });
+    EXPECT_EQ(visited, 2u);
+}
@@ -0,0 +1,164 @@
+#include "../include/handlers/PlacesLocalIndex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+    // 강남역 부근. 위도 0.001도는 약 111m
+    constexpr double kLat = 37.4979;
+    constexpr double kLng = 127.0276;
+
+    PlacesLocalIndex::Place place(const std::string& id, const std::string& name, double lat_offset,
+                                  const std::string& address = "서울 강남구 강남대로") {
+        PlacesLocalIndex::Place p;
+        p.id = id;
+        p.name = name;
+        p.address = address;
+        p.latitude = kLat + lat_offset;
+        p.longitude = kLng;
+        p.from_nearby = true;
+        return p;
+    }
+}
+
+/**
+ * @brief 주변 검색은 답이 커버된 영역 안에서 정해질 때만 로컬에서 답하고, 결과는 거리순인지 확인한다.
+ */
+TEST(PlacesLocalIndexTest, NearbyAnswersOnlyInsideCoveredArea) {
+    PlacesLocalIndex index;
+    index.upsert(place("a", "카페 A", 0.002));   // 약 222m
+    index.upsert(place("b", "카페 B", 0.001));   // 약 111m
+    index.upsert(place("c", "카페 C", 0.004));   // 약 445m
+
+    // 아직 Google에 물어본 영역이 없음
+    EXPECT_FALSE(index.nearby(kLat, kLng, 500, 5, false).has_value());
+
+    index.markCovered(kLat, kLng, 500);
+    auto hits = index.nearby(kLat, kLng, 300, 5, false);
+    ASSERT_TRUE(hits.has_value());
+    ASSERT_EQ(hits->size(), 2u);
+    EXPECT_EQ((*hits)[0].place.id, "b");
+    EXPECT_EQ((*hits)[1].place.id, "a");
+
+    // 커버된 영역을 벗어나는 반경은 업스트림에 맡긴다.
+    EXPECT_FALSE(index.nearby(kLat, kLng, 800, 5, false).has_value());
+    // 결과 수가 한도에 닿으면 마지막 결과까지만 커버되면 된다.
+    auto nearest = index.nearby(kLat, kLng, 800, 2, false);
+    ASSERT_TRUE(nearest.has_value());
+    EXPECT_EQ(nearest->size(), 2u);
+
+    // 평점/사진이 필요한데 요약으로만 본 장소가 있으면 업스트림에 맡긴다.
+    EXPECT_FALSE(index.nearby(kLat, kLng, 300, 5, true).has_value());
+}
+
+/**
+ * @brief 텍스트 검색은 모든 검색어 단어로 시작하는 단어를 가진 장소가 충분할 때만 답하고, 이름 일치를 앞에 두는지 확인한다.
+ */
+TEST(PlacesLocalIndexTest, TextSearchMatchesWordPrefixes) {
+    PlacesLocalIndexConfig config;
+    config.min_text_results = 2;
+    PlacesLocalIndex index(config);
+    index.upsert(place("far", "Starbucks 강남역점", 0.003));
+    index.upsert(place("near", "스타벅스 강남점", 0.001));
+    index.upsert(place("addr", "커피빈", 0.0005, "서울 강남구 강남역로 1"));
+    index.upsert(place("other", "파리바게뜨", 0.001, "서울 서초구"));
+
+    auto hits = index.search("강남역", std::nullopt, 0, 5, false);
+    ASSERT_TRUE(hits.has_value());
+    ASSERT_EQ(hits->size(), 2u);
+    EXPECT_EQ((*hits)[0].place.id, "far");   // 이름에서 찾은 장소가 먼저
+    EXPECT_EQ((*hits)[1].place.id, "addr");
+
+    auto ascii = index.search("STAR", std::make_pair(kLat, kLng), 1000, 5, false);
+    EXPECT_FALSE(ascii.has_value());   // 결과 1개 < min_text_results
+
+    auto by_distance = index.search("강남", std::make_pair(kLat, kLng), 1000, 5, false);
+    ASSERT_TRUE(by_distance.has_value());
+    EXPECT_EQ(by_distance->size(), 3u);
+    EXPECT_EQ((*by_distance)[0].place.id, "near");
+
+    EXPECT_FALSE(index.search("없는가게", std::nullopt, 0, 5, false).has_value());
+}
+
+/**
+ * @brief 갱신하면 이전 이름으로는 찾지 못하고, 한도를 넘으면 오래된 장소부터 버리며, max_age가 0이면 답하지 않는지 확인한다.
+ */
+TEST(PlacesLocalIndexTest, UpdatesEvictionAndDisabled) {
+    PlacesLocalIndexConfig config;
+    config.min_text_results = 1;
+    config.max_places = 10;
+    PlacesLocalIndex index(config);
+    index.upsert(place("p", "옛이름", 0.001));
+    index.upsert(place("p", "새이름", 0.001));
+    EXPECT_EQ(index.size(), 1u);
+    EXPECT_FALSE(index.search("옛이름", std::nullopt, 0, 5, false).has_value());
+    EXPECT_TRUE(index.search("새이름", std::nullopt, 0, 5, false).has_value());
+
+    for (int i = 0; i < 11; ++i) {
+        index.upsert(place("k" + std::to_string(i), "가게" + std::to_string(i), 0.0001 * i));
+    }
+    EXPECT_LE(index.size(), 10u);
+    EXPECT_TRUE(index.search("가게10", std::nullopt, 0, 5, false).has_value());
+
+    PlacesLocalIndexConfig disabled;
+    disabled.max_age = std::chrono::seconds(0);
+    PlacesLocalIndex off(disabled);
+    off.upsert(place("a", "카페", 0.001));
+    off.markCovered(kLat, kLng, 500);
+    EXPECT_FALSE(off.nearby(kLat, kLng, 300, 5, false).has_value());
+}
+
+/**
+ * @brief 커버된 영역 안의 장소가 한도 때문에 버려지면, 그 영역으로는 더 이상 주변 검색에 답하지 않는지 확인한다.
+ */
+TEST(PlacesLocalIndexTest, EvictionInvalidatesCoveredAreas) {
+    PlacesLocalIndexConfig config;
+    config.max_places = 10;
+    PlacesLocalIndex index(config);
+    auto old = place("old", "카페", 0.001);
+    old.seen = PlacesLocalIndex::Clock::now() - std::chrono::minutes(10);
+    index.upsert(old);
+    index.markCovered(kLat, kLng, 500);
+    ASSERT_TRUE(index.nearby(kLat, kLng, 300, 5, false).has_value());
+
+    // 먼 곳의 장소로 한도를 넘기면 가장 오래된 "old"가 버려진다.
+    for (int i = 0; i < 10; ++i) {
+        index.upsert(place("k" + std::to_string(i), "가게" + std::to_string(i), 0.1 + 0.0001 * i));
+    }
+    ASSERT_LE(index.size(), 10u);
+    EXPECT_FALSE(index.nearby(kLat, kLng, 300, 5, false).has_value());
+}
+
+/**
+ * @brief 자동 완성은 입력 중인 마지막 단어를 접두어로 맞추고, 가깝고 자주 본 장소를 앞에 두는지 확인한다.
+ */
+TEST(PlacesLocalIndexTest, AutocompleteRanksByProximityAndPopularity) {
+    PlacesLocalIndex index;
+    index.upsert(place("far", "스타벅스 역삼점", 0.02));      // 약 2.2km
+    index.upsert(place("near", "스타벅스 강남점", 0.001));    // 약 111m
+    index.upsert(place("other", "스타필드 코엑스", 0.001));
+    index.upsert(place("cafe", "커피빈", 0.001));
+
+    auto hits = index.autocomplete("스타", std::make_pair(kLat, kLng), 5);
+    ASSERT_EQ(hits.size(), 3u);
+    EXPECT_EQ(hits.back().place.id, "far");
+
+    // 앞 단어까지 맞아야 하고, 마지막 단어는 입력 중인 접두어
+    auto narrowed = index.autocomplete("스타벅스 강", std::make_pair(kLat, kLng), 5);
+    ASSERT_EQ(narrowed.size(), 2u);   // "강남점" 또는 주소의 "강남구"
+    EXPECT_EQ(narrowed[0].place.id, "near");
+
+    // 여러 번 본 장소는 거리가 같으면 앞에 둔다.
+    for (int i = 0; i < 20; ++i) {
+        index.upsert(place("other", "스타필드 코엑스", 0.001));
+    }
+    auto popular = index.autocomplete("스타", std::make_pair(kLat, kLng), 1);
+    ASSERT_EQ(popular.size(), 1u);
+    EXPECT_EQ(popular[0].place.id, "other");
+
+    // 이름이 바뀌면 이전 이름으로는 추천하지 않는다.
+    index.upsert(place("cafe", "블루보틀", 0.001));
+    EXPECT_TRUE(index.autocomplete("커피", std::nullopt, 5).empty());
+    EXPECT_EQ(index.autocomplete("블루", std::nullopt, 5).size(), 1u);
+}
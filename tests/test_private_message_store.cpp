@@ -0,0 +1,82 @@
+#include "../include/MessageHistory.hpp"
+#include "../include/PrivateMessageStore.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    size_t count_files(const std::string& dir) {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            count += entry.is_regular_file() ? 1 : 0;
+        }
+        return count;
+    }
+}
+
+/**
+ * @brief 여러 대화를 한 파일에 기록하고 대화별로 읽으며, 다시 열 때 잘린 마지막 레코드를 버리는지 확인한다.
+ */
+TEST(PrivateMessageStoreTest, KeepsConversationsApartInOneFile) {
+    TempDir dir("private_message_store_test");
+    const std::string path = dir.path + "/messages.log";
+    {
+        PrivateMessageStore store(path);
+        ASSERT_TRUE(store.is_open());
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_TRUE(store.append("alice", "bob", "ab " + std::to_string(i)));
+            EXPECT_TRUE(store.append("carol", "alice", "ca " + std::to_string(i)));
+        }
+        EXPECT_EQ(store.line_count("bob", "alice"), 5u);
+        auto tail = store.last_lines("alice", "carol", 2);
+        ASSERT_EQ(tail.size(), 2u);
+        EXPECT_EQ(tail[0], "ca 3");
+        EXPECT_EQ(tail[1], "ca 4");
+        EXPECT_EQ(store.lines("alice", "bob", 1, 2), (std::vector<std::string>{"ab 1", "ab 2"}));
+        EXPECT_TRUE(store.last_lines("alice", "dave", 10).empty());
+    }
+    EXPECT_EQ(count_files(dir.path), 1u);
+
+    // 기록 도중 멈춘 것처럼 레코드 머리 일부만 남긴다.
+    {
+        std::ofstream torn(path, std::ios::app | std::ios::binary);
+        torn.write("\x20\x00\x00", 3);
+    }
+    PrivateMessageStore reopened(path);
+    EXPECT_EQ(reopened.conversations().size(), 2u);
+    EXPECT_EQ(reopened.line_count("alice", "bob"), 5u);
+    EXPECT_TRUE(reopened.append("bob", "alice", "ab 5"));
+    EXPECT_EQ(reopened.last_lines("alice", "bob", 1), std::vector<std::string>{"ab 5"});
+    EXPECT_EQ(reopened.last_lines("alice", "bob", 0).size(), 6u);
+}
+
+/**
+ * @brief 예전 대화별 파일을 가져와 같은 API로 읽고, 가져온 파일은 옮겨 두어 다시 실행해도 중복되지 않는지 확인한다.
+ */
+TEST(MessageHistoryTest, MigratesLegacyPairFiles) {
+    TempDir dir("private_history_migration_test");
+    std::filesystem::create_directories(dir.path + "/private");
+    {
+        std::ofstream legacy(dir.path + "/private/a_b_c.txt");
+        legacy << "2026-10-01 10:00:00 [a_b -> c]: 안녕\n";
+        legacy << "2026-10-01 10:00:05 [c -> a_b]: 반가워\n";
+    }
+
+    MessageHistory history(dir.path);
+    EXPECT_EQ(history.migrate_private_files(), 1u);
+    EXPECT_EQ(history.migrate_private_files(), 0u);
+    EXPECT_TRUE(std::filesystem::exists(dir.path + "/private/migrated/a_b_c.txt"));
+
+    history.log_private_message("또 만나", "a_b", "c");
+    auto lines = history.load_private_history("c", "a_b");
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_NE(lines[0].find("[a_b -> c]: 안녕"), std::string::npos);
+    EXPECT_NE(lines[2].find("[a_b -> c]: 또 만나"), std::string::npos);
+    EXPECT_TRUE(history.load_private_history("a", "b_c").empty());
+    EXPECT_FALSE(std::filesystem::exists(dir.path + "/private/a_b_c.txt"));
+}
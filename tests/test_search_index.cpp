@@ -0,0 +1,228 @@
+#include "../include/ChatServer.hpp"
+#include "../include/MessageHistory.hpp"
+#include "../include/SearchIndex.hpp"
+#include "ChatServerFixture.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+namespace {
+    bool contains(const std::vector<std::string>& tokens, const std::string& token) {
+        return std::find(tokens.begin(), tokens.end(), token) != tokens.end();
+    }
+
+    std::uint64_t unix_now() {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+}
+
+/**
+ * @brief 한글은 음절 2-gram(한 음절이면 그대로)으로, 영문은 소문자 단어로 나누는지 확인한다.
+ */
+TEST(SearchIndexTest, TokenizesHangulBigramsAndLowercaseWords) {
+    auto tokens = SearchIndex::tokenize("CherryRecorder 위치저장, 밥!");
+    EXPECT_TRUE(contains(tokens, "cherryrecorder"));
+    EXPECT_TRUE(contains(tokens, "위치"));
+    EXPECT_TRUE(contains(tokens, "치저"));
+    EXPECT_TRUE(contains(tokens, "저장"));
+    EXPECT_TRUE(contains(tokens, "밥"));
+    EXPECT_FALSE(contains(tokens, "위"));
+    EXPECT_TRUE(SearchIndex::tokenize(std::string("\xEC\x9C", 2)).empty());
+}
+
+/**
+ * @brief 모든 토큰을 포함하는 문서만 찾고, 한 음절 검색어는 접두어로 찾으며, 페이지를 나누는지 확인한다.
+ */
+TEST(SearchIndexTest, MatchesAllTokensAndPaginates) {
+    SearchIndex index(4, std::chrono::milliseconds(1000));
+    index.add("rooms/lobby", 0, "오늘 점심 뭐 먹을까");
+    index.add("rooms/lobby", 1, "점심은 김치찌개");
+    index.add("rooms/dev", 0, "Build failed again");
+    index.add("private/alice_bob", 0, "점심 같이 먹자", {"alice", "bob"});
+    for (int i = 0; i < 12; ++i) {
+        index.add("rooms/spam", static_cast<std::uint64_t>(i), "deploy " + std::to_string(i));
+    }
+    index.flush();
+    EXPECT_EQ(index.document_count(), 16u);
+
+    auto lunch = index.search("점심 먹", nullptr, 0, 10);
+    EXPECT_EQ(lunch.total, 2u); // "먹"은 먹을, 먹자와 모두 맞음
+    auto build = index.search("BUILD failed", nullptr, 0, 10);
+    ASSERT_EQ(build.total, 1u);
+    EXPECT_EQ(build.hits[0].channel, "rooms/dev");
+    EXPECT_EQ(index.search("build passed", nullptr, 0, 10).total, 0u);
+
+    auto public_only = index.search("점심", [](const std::string& channel, const std::vector<std::string>&, std::uint64_t) {
+        return channel.rfind("rooms/", 0) == 0;
+    }, 0, 10);
+    EXPECT_EQ(public_only.total, 2u);
+
+    auto first = index.search("deploy", nullptr, 0, 5);
+    auto third = index.search("deploy", nullptr, 10, 5);
+    EXPECT_EQ(first.total, 12u);
+    ASSERT_EQ(first.hits.size(), 5u);
+    EXPECT_EQ(first.hits[0].line, 11u); // 같은 점수면 최신 문서가 먼저
+    ASSERT_EQ(third.hits.size(), 2u);
+    EXPECT_EQ(third.hits[1].line, 0u);
+
+    // 정리된 줄은 결과 수에서도 빠진다.
+    index.set_floor("rooms/spam", 10);
+    auto remaining = index.search("deploy", nullptr, 0, 5);
+    EXPECT_EQ(remaining.total, 2u);
+    ASSERT_EQ(remaining.hits.size(), 2u);
+    EXPECT_EQ(remaining.hits[1].line, 10u);
+}
+
+/**
+ * @brief `MessageHistory` 검색이 남의 귓속말을 제외하고, 다시 열면 기존 기록을 백필하는지 확인한다.
+ */
+TEST(MessageHistoryTest, SearchFiltersPrivateMessagesAndBackfills) {
+    TempDir dir("message_history_search_test");
+    {
+        MessageHistory history(dir.path);
+        history.log_room_message("lobby", "체리 레코더 출시", "alice");
+        history.log_room_message("dev", "레코더 빌드 완료", "bob");
+        history.log_private_message("레코더 비밀 계획", "alice", "carol");
+        history.log_global_message("레코더 전체 공지");
+        history.flush_search_index();
+
+        auto carol = history.search("레코더", "carol", "", 0, 10);
+        EXPECT_EQ(carol.total, 3u);
+        auto bob = history.search("레코더", "bob", "", 0, 10);
+        ASSERT_EQ(bob.total, 2u);
+        for (const auto& line : bob.lines) {
+            EXPECT_EQ(line.find("[PM]"), std::string::npos);
+        }
+        EXPECT_EQ(history.search("레코더", "", "", 0, 10).total, 2u); // 계정 확인이 안 된 검색은 귓속말 제외
+        EXPECT_EQ(history.search("레코더", "carol", "", 0, 10, unix_now()).total, 2u); // 계정에 묶기 전의 귓속말 제외
+        auto dev = history.search("레코더", "bob", "dev", 0, 10);
+        ASSERT_EQ(dev.lines.size(), 1u);
+        EXPECT_EQ(dev.lines[0].rfind("[#dev] ", 0), 0u);
+        EXPECT_NE(dev.lines[0].find("[bob]: 레코더 빌드 완료"), std::string::npos);
+    }
+
+    MessageHistory reopened(dir.path);
+    reopened.log_room_message("lobby", "레코더 새 소식", "dave");
+    reopened.flush_search_index();
+    EXPECT_EQ(reopened.search("레코더", "carol", "", 0, 10).total, 4u);
+    EXPECT_EQ(reopened.search("레코더", "dave", "", 0, 10).total, 3u);
+    EXPECT_EQ(reopened.search("비밀", "alice", "", 0, 10).total, 1u);
+}
+
+/**
+ * @class ChatSearchTest
+ * @brief `ChatServer`의 `/search`가 귓속말을 누구에게 보여 주는지 검증하는 테스트 픽스처.
+ */
+class ChatSearchTest : public ChatServerFixture {
+protected:
+    ChatSearchTest() : ChatServerFixture("chat_search_test") {}
+
+    void configure(ChatServer& server) override {
+        KdfParams params;
+        params.log2_n = 10;
+        server.set_password_hashing(1, 4, params);
+    }
+
+    bool set_nickname(const std::shared_ptr<FakeSession>& session, const std::string& nickname) {
+        if (!register_nickname(session, nickname))
+            return false;
+        session->set_nickname(nickname); // `/nick` 처리처럼 성공하면 세션의 닉네임을 바꾼다
+        return true;
+    }
+
+    std::shared_ptr<FakeSession> join(const std::string& nickname) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server_->join(session);
+        EXPECT_TRUE(set_nickname(session, nickname));
+        return session;
+    }
+
+    ChatServer::AuthStatus register_user(const std::shared_ptr<FakeSession>& session, const std::string& user) {
+        std::promise<ChatServer::AuthStatus> result;
+        server_->register_user_async(user, "s3cret", session, [&result](ChatServer::AuthStatus status) { result.set_value(status); });
+        return result.get_future().get();
+    }
+
+    ChatServer::AuthStatus login(const std::shared_ptr<FakeSession>& session, const std::string& user) {
+        std::promise<ChatServer::AuthStatus> result;
+        server_->authenticate_user_async(user, "s3cret", session, [&result](ChatServer::AuthStatus status, std::string) {
+            result.set_value(status);
+        });
+        return result.get_future().get();
+    }
+
+    /// 검색 색인에 반영될 시간을 기다린 뒤 `/search plan`의 마지막 응답을 돌려준다.
+    std::string search(const std::shared_ptr<FakeSession>& session) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::size_t before = session->count("* SEARCH");
+        server_->search_history_async("plan", "", 1, session);
+        for (int i = 0; i < 200 && session->count("* SEARCH") == before; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto received = session->received();
+        auto last = std::find_if(received.rbegin(), received.rend(), [](const std::string& m) {
+            return m.rfind("* SEARCH", 0) == 0;
+        });
+        return last == received.rend() ? std::string() : *last;
+    }
+};
+
+/**
+ * @brief `/search`가 귓속말을 닉네임만 가진 세션에는 보여 주지 않고, 같은 이름의 계정으로 로그인한 세션에만 보여 주는지 확인한다.
+ */
+TEST_F(ChatSearchTest, ShowsPrivateMessagesOnlyToLoggedInAccount) {
+    auto alice = join("alice");
+    auto bob = join("bob");
+    ASSERT_EQ(register_user(bob, "bob"), ChatServer::AuthStatus::Ok);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100)); // 기록 시각은 초 단위이므로 묶은 시각 다음 초에 보낸다
+    ASSERT_TRUE(server_->send_private_message("secret plan", alice, "bob"));
+    ASSERT_TRUE(bob->wait_for("[PM from alice]: secret plan"));
+
+    EXPECT_EQ(search(bob).find("[PM]"), std::string::npos);
+    EXPECT_EQ(search(alice).find("[PM]"), std::string::npos);
+
+    ASSERT_EQ(login(bob, "bob"), ChatServer::AuthStatus::Ok);
+    std::string found = search(bob);
+    EXPECT_NE(found.find("[PM]"), std::string::npos);
+    EXPECT_NE(found.find("secret plan"), std::string::npos);
+}
+
+/**
+ * @brief 예전에 쓰인 닉네임으로 새 계정을 만들어도 그 전의 귓속말은 볼 수 없고,
+ *        계정에 묶인 닉네임은 그 계정으로 로그인해야만 쓸 수 있는지 확인한다.
+ */
+TEST_F(ChatSearchTest, NewAccountCannotReadEarlierPrivateMessagesOfItsNickname) {
+    auto alice = join("alice");
+    auto carol = join("carol");
+    ASSERT_TRUE(server_->send_private_message("old plan", alice, "carol"));
+    ASSERT_TRUE(carol->wait_for("[PM from alice]: old plan"));
+
+    auto mallory = join("mallory");
+    EXPECT_EQ(register_user(mallory, "carol"), ChatServer::AuthStatus::Failed); // 다른 세션이 쓰는 닉네임
+    server_->leave(carol);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    ASSERT_EQ(register_user(mallory, "carol"), ChatServer::AuthStatus::Ok);
+    auto guest = join("guest");
+    EXPECT_FALSE(set_nickname(guest, "carol")); // 로그인하지 않은 세션은 계정의 닉네임을 쓸 수 없다
+    ASSERT_EQ(login(mallory, "carol"), ChatServer::AuthStatus::Ok);
+    ASSERT_TRUE(set_nickname(mallory, "carol"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT_TRUE(server_->send_private_message("new plan", alice, "carol"));
+    ASSERT_TRUE(mallory->wait_for("[PM from alice]: new plan"));
+    std::string found = search(mallory);
+    EXPECT_NE(found.find("new plan"), std::string::npos);
+    EXPECT_EQ(found.find("old plan"), std::string::npos);
+}
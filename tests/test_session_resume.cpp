@@ -0,0 +1,149 @@
+#include "../include/ChatServer.hpp"
+#include "ChatServerFixture.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @class SessionResumeTest
+ * @brief 재접속 토큰으로 끊긴 세션의 닉네임, 방, 놓친 메시지를 복원하는 흐름을 검증하는 테스트 픽스처.
+ */
+class SessionResumeTest : public ChatServerFixture {
+protected:
+    SessionResumeTest() : ChatServerFixture("resume_test") {}
+
+    std::chrono::milliseconds grace_{0};
+
+    void SetUp() override {} // 테스트마다 유예 기간이 달라 `start`에서 시작한다
+
+    void configure(ChatServer& server) override { server.set_resume_grace_period(grace_); }
+
+    void start(std::chrono::milliseconds grace) {
+        grace_ = grace;
+        start_server();
+    }
+
+    /// 닉네임을 정하고 방에 들어간 세션을 만든다.
+    std::shared_ptr<FakeSession> connect(const std::string& nickname, const std::string& room) {
+        auto session = std::make_shared<FakeSession>(ioc_, nickname);
+        server_->join(session);
+        EXPECT_TRUE(register_nickname(session, nickname));
+        EXPECT_TRUE(server_->join_room(room, session));
+        return session;
+    }
+
+    /// 아직 닉네임을 정하지 않은 새 연결을 만든다. (닉네임 == 원격 식별자)
+    std::shared_ptr<FakeSession> connect_anonymous(const std::string& id) {
+        auto session = std::make_shared<FakeSession>(ioc_, id);
+        session->set_nickname(session->remote_id());
+        server_->join(session);
+        return session;
+    }
+
+    std::string issue_token(const std::shared_ptr<FakeSession>& session) {
+        std::promise<std::string> token;
+        server_->issue_resume_token_async(session, [&token](std::string t) { token.set_value(t); });
+        return token.get_future().get();
+    }
+
+    bool resume(const std::string& token, const std::shared_ptr<FakeSession>& session) {
+        std::promise<bool> result;
+        server_->resume_session_async(token, session, [&result](bool ok) { result.set_value(ok); });
+        return result.get_future().get();
+    }
+};
+
+/**
+ * @brief 유예 기간 안에 재접속하면 닉네임과 방이 복원되고, 끊긴 동안의 방/개인 메시지를 한 번에 받는지 확인한다.
+ *        다른 사용자에게는 퇴장/입장 알림이 가지 않아야 한다.
+ */
+TEST_F(SessionResumeTest, ResumeRestoresNicknameRoomAndMissedMessages) {
+    start(std::chrono::seconds(5));
+    auto alice = connect("alice", "lobby");
+    auto bob = connect("bob", "lobby");
+    std::string token = issue_token(alice);
+    ASSERT_EQ(token.size(), 48u);
+
+    server_->leave(alice);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // 끊긴 동안에도 닉네임은 예약되어 있다
+    auto rival = connect_anonymous("rival");
+    EXPECT_FALSE(register_nickname(rival, "alice"));
+
+    server_->broadcast_to_room("lobby", "while you were away", bob);
+    server_->send_private_message("psst", bob, "alice");
+    ASSERT_TRUE(bob->wait_for("* To alice: psst"));
+
+    auto alice_again = connect_anonymous("alice-phone");
+    ASSERT_TRUE(resume(token, alice_again));
+    EXPECT_EQ(alice_again->nickname(), "alice");
+    EXPECT_EQ(alice_again->current_room(), "lobby");
+    EXPECT_TRUE(alice_again->wait_for("세션이 복원되었습니다"));
+    EXPECT_TRUE(alice_again->wait_for("while you were away"));
+    EXPECT_TRUE(alice_again->wait_for("[PM from bob]: psst"));
+
+    // 복원된 세션으로 방 메시지가 계속 전달된다
+    server_->broadcast_to_room("lobby", "welcome back", bob);
+    EXPECT_TRUE(alice_again->wait_for("welcome back"));
+    EXPECT_EQ(bob->count("퇴장"), 0u);
+    EXPECT_EQ(bob->count("나갔습니다"), 0u);
+
+    // 토큰은 한 번만 쓸 수 있다
+    auto replay = connect_anonymous("replay");
+    EXPECT_FALSE(resume(token, replay));
+}
+
+/**
+ * @brief 유예 기간이 지나면 퇴장 처리되어 닉네임이 풀리고 토큰도 쓸 수 없는지 확인한다.
+ */
+TEST_F(SessionResumeTest, ExpiredGracePeriodReleasesNickname) {
+    start(std::chrono::milliseconds(200));
+    auto alice = connect("alice", "lobby");
+    auto bob = connect("bob", "lobby");
+    std::string token = issue_token(alice);
+
+    server_->leave(alice);
+    ASSERT_TRUE(bob->wait_for("'alice'님이 퇴장했습니다"));
+
+    auto newcomer = connect_anonymous("newcomer");
+    EXPECT_FALSE(resume(token, newcomer));
+    EXPECT_TRUE(register_nickname(newcomer, "alice"));
+}
+
+/**
+ * @brief 이전 연결이 끊긴 것을 서버가 아직 모를 때(모바일 네트워크 전환 등) 새 연결이 이전 연결을 닫고 넘겨받는지 확인한다.
+ */
+TEST_F(SessionResumeTest, ResumeTakesOverStillOpenConnection) {
+    start(std::chrono::seconds(5));
+    auto alice = connect("alice", "lobby");
+    std::string token = issue_token(alice);
+
+    auto alice_again = connect_anonymous("alice-wifi");
+    // 토큰 ID가 같아도 비밀값이 다르면 거부된다
+    std::string forged = token;
+    forged.back() = forged.back() == '0' ? '1' : '0';
+    EXPECT_FALSE(resume(forged, alice_again));
+    EXPECT_FALSE(alice->stopped());
+    ASSERT_TRUE(resume(token, alice_again));
+    EXPECT_TRUE(alice->stopped());
+    EXPECT_EQ(alice_again->nickname(), "alice");
+
+    // 이전 연결의 뒤늦은 leave는 복원된 세션에 영향을 주지 않는다
+    server_->leave(alice);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto rival = connect_anonymous("rival");
+    EXPECT_FALSE(register_nickname(rival, "alice"));
+    std::promise<SessionPtr> found;
+    server_->find_session_by_nickname_async("alice", [&found](SessionPtr s) { found.set_value(s); });
+    EXPECT_EQ(found.get_future().get(), alice_again);
+}
@@ -0,0 +1,187 @@
+#include "../include/handlers/UpstreamGuard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    /// 테스트가 빨리 끝나도록 작게 잡은 설정 (서킷은 50ms 뒤 시험 호출 허용)
+    UpstreamGuardConfig test_config() {
+        UpstreamGuardConfig config;
+        config.initial_limit = 4;
+        config.min_limit = 1;
+        config.max_limit = 8;
+        config.latency_target = std::chrono::milliseconds(0);
+        config.window_size = 10;
+        config.min_calls = 4;
+        config.failure_threshold = 0.5;
+        config.open_duration = std::chrono::milliseconds(50);
+        return config;
+    }
+}
+
+/**
+ * @brief 상태 코드를 업스트림 상태 문제(429/5xx/연결 오류)와 요청 문제(그 밖의 4xx)로 나누는지 확인한다.
+ */
+TEST(UpstreamGuardTest, ClassifiesStatusCodes) {
+    EXPECT_EQ(UpstreamGuard::classify(200), UpstreamGuard::Outcome::Success);
+    EXPECT_EQ(UpstreamGuard::classify(204), UpstreamGuard::Outcome::Success);
+    EXPECT_EQ(UpstreamGuard::classify(0), UpstreamGuard::Outcome::Failure);
+    EXPECT_EQ(UpstreamGuard::classify(429), UpstreamGuard::Outcome::Failure);
+    EXPECT_EQ(UpstreamGuard::classify(503), UpstreamGuard::Outcome::Failure);
+    EXPECT_EQ(UpstreamGuard::classify(400), UpstreamGuard::Outcome::Ignored);
+    EXPECT_EQ(UpstreamGuard::classify(404), UpstreamGuard::Outcome::Ignored);
+}
+
+/**
+ * @brief 한도만큼만 동시에 허가하고, 실패하면 한도를 절반으로 줄이며, 성공이 이어지면 다시 늘리는지 확인한다.
+ */
+TEST(UpstreamGuardTest, LimitsConcurrencyWithAimd) {
+    auto config = test_config();
+    config.latency_target = std::chrono::seconds(10);
+    config.min_calls = 100; // 이 테스트에서는 서킷을 열지 않는다
+    UpstreamGuard guard(config);
+
+    std::vector<UpstreamGuard::Permit> permits;
+    for (int i = 0; i < 4; ++i) {
+        permits.push_back(guard.tryAcquire());
+        ASSERT_TRUE(permits.back().admitted());
+    }
+    EXPECT_EQ(guard.tryAcquire().admission, UpstreamGuard::Admission::Overloaded);
+    EXPECT_EQ(guard.metrics().in_flight, 4u);
+
+    // 한꺼번에 실패해도 한 번만 줄인다.
+    for (auto& permit : permits) {
+        guard.release(permit, UpstreamGuard::Outcome::Failure);
+    }
+    auto metrics = guard.metrics();
+    EXPECT_DOUBLE_EQ(metrics.limit, 2.0);
+    EXPECT_EQ(metrics.in_flight, 0u);
+    EXPECT_EQ(metrics.rejected_overload, 1u);
+
+    // 무시할 결과(4xx)는 한도를 바꾸지 않는다.
+    guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Ignored);
+    EXPECT_DOUBLE_EQ(guard.metrics().limit, 2.0);
+
+    for (int i = 0; i < 20; ++i) {
+        guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Success);
+    }
+    metrics = guard.metrics();
+    EXPECT_GT(metrics.limit, 4.0);
+    EXPECT_LE(metrics.limit, 8.0);
+    EXPECT_EQ(metrics.successes, 20u);
+}
+
+/**
+ * @brief 목표 지연을 넘는 성공 응답도 혼잡 신호로 보고 한도를 줄이는지 확인한다.
+ */
+TEST(UpstreamGuardTest, SlowResponsesShrinkLimit) {
+    auto config = test_config();
+    config.latency_target = std::chrono::milliseconds(5);
+    config.min_calls = 100;
+    UpstreamGuard guard(config);
+
+    auto permit = guard.tryAcquire();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    guard.release(permit, UpstreamGuard::Outcome::Success);
+    EXPECT_DOUBLE_EQ(guard.metrics().limit, 2.0);
+    EXPECT_GE(guard.metrics().latency_ewma_ms, 5.0);
+}
+
+/**
+ * @brief 오류율이 임계값을 넘으면 서킷을 열어 바로 거절하고, 시험 호출 결과에 따라 닫거나 다시 여는지 확인한다.
+ */
+TEST(UpstreamGuardTest, CircuitOpensAndRecoversThroughProbe) {
+    UpstreamGuard guard(test_config());
+
+    guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Success);
+    guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Failure);
+    guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Success);
+    EXPECT_EQ(guard.metrics().state, UpstreamGuard::CircuitState::Closed);
+    guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Failure); // 4번 중 2번 실패 -> 50%
+    EXPECT_EQ(guard.metrics().state, UpstreamGuard::CircuitState::Open);
+    EXPECT_EQ(guard.tryAcquire().admission, UpstreamGuard::Admission::CircuitOpen);
+
+    // open_duration이 지나면 시험 호출 하나만 통과한다.
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    auto probe = guard.tryAcquire();
+    ASSERT_TRUE(probe.admitted());
+    EXPECT_TRUE(probe.probe);
+    EXPECT_EQ(guard.metrics().state, UpstreamGuard::CircuitState::HalfOpen);
+    EXPECT_EQ(guard.tryAcquire().admission, UpstreamGuard::Admission::CircuitOpen);
+
+    guard.release(probe, UpstreamGuard::Outcome::Failure);
+    EXPECT_EQ(guard.metrics().state, UpstreamGuard::CircuitState::Open);
+    EXPECT_EQ(guard.tryAcquire().admission, UpstreamGuard::Admission::CircuitOpen);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    probe = guard.tryAcquire();
+    ASSERT_TRUE(probe.probe);
+    guard.release(probe, UpstreamGuard::Outcome::Success);
+    auto metrics = guard.metrics();
+    EXPECT_EQ(metrics.state, UpstreamGuard::CircuitState::Closed);
+    EXPECT_EQ(metrics.error_rate, 0.0);
+    EXPECT_EQ(metrics.circuit_opens, 2u); // 시험 호출 실패로 다시 연 것도 센다
+    EXPECT_TRUE(guard.tryAcquire().admitted());
+
+    std::string text = guard.metricsText("places_upstream_");
+    EXPECT_NE(text.find("places_upstream_circuit_open 0\n"), std::string::npos);
+    EXPECT_NE(text.find("places_upstream_rejected_circuit_open_total 3\n"), std::string::npos);
+}
+
+/**
+ * @brief 백그라운드 작업(미리 받기)은 한도의 일부만 쓰고, 서킷이 닫혀 있지 않으면 시험 호출도 받지 못하는지 확인한다.
+ */
+TEST(UpstreamGuardTest, BackgroundCallsUseOnlySpareCapacity) {
+    auto config = test_config();
+    config.latency_target = std::chrono::seconds(10);
+    UpstreamGuard guard(config); // 한도 4
+
+    auto first = guard.tryAcquire(0.5);
+    auto second = guard.tryAcquire(0.5);
+    ASSERT_TRUE(first.admitted());
+    ASSERT_TRUE(second.admitted());
+    EXPECT_EQ(guard.tryAcquire(0.5).admission, UpstreamGuard::Admission::Overloaded);
+    auto user = guard.tryAcquire();
+    EXPECT_TRUE(user.admitted()); // 나머지 한도는 사용자 요청용
+    guard.release(first, UpstreamGuard::Outcome::Success);
+    guard.release(second, UpstreamGuard::Outcome::Success);
+    guard.release(user, UpstreamGuard::Outcome::Success);
+
+    for (int i = 0; i < 4; ++i) {
+        guard.release(guard.tryAcquire(), UpstreamGuard::Outcome::Failure);
+    }
+    ASSERT_EQ(guard.metrics().state, UpstreamGuard::CircuitState::Open);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(guard.tryAcquire(0.5).admission, UpstreamGuard::Admission::CircuitOpen);
+    EXPECT_TRUE(guard.tryAcquire().probe);
+}
+
+/**
+ * @brief 기다리는 `acquire`는 한도가 찼을 때 반납을 기다려 허가를 받고, 반납이 없으면 기다린 끝에 과부하로 거절되는지 확인한다.
+ */
+TEST(UpstreamGuardTest, AcquireWaitsForReleasedPermit) {
+    auto config = test_config();
+    config.latency_target = std::chrono::seconds(10);
+    config.initial_limit = 1;
+    UpstreamGuard guard(config);
+
+    auto held = guard.tryAcquire();
+    ASSERT_TRUE(held.admitted());
+    auto started = std::chrono::steady_clock::now();
+    EXPECT_EQ(guard.acquire(std::chrono::milliseconds(30)).admission, UpstreamGuard::Admission::Overloaded);
+    EXPECT_GE(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(30));
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        guard.release(held, UpstreamGuard::Outcome::Success);
+    });
+    auto waited = guard.acquire(std::chrono::seconds(5));
+    releaser.join();
+    EXPECT_TRUE(waited.admitted());
+    guard.release(waited, UpstreamGuard::Outcome::Success);
+    EXPECT_EQ(guard.metrics().rejected_overload, 1u);
+}
@@ -0,0 +1,175 @@
+#include "../include/UserStore.hpp"
+#include "TempDir.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    UserAccount make_account(const std::string& name, const std::string& hash, bool admin = false) {
+        UserAccount account(name, hash, admin);
+        account.update_login_info("10.0.0.1", "2026-10-17 12:00:00");
+        return account;
+    }
+}
+
+/**
+ * @brief 저장/삭제가 다시 열어도 남아 있고, 합친 뒤에도 스냅샷에서 같은 계정을 찾는지 확인한다.
+ */
+TEST(UserStoreTest, PersistsChangesAcrossReopenAndCompaction) {
+    TempDir dir("user_store_test");
+    const std::string path = dir.path + "/accounts";
+    {
+        UserStore store(path);
+        ASSERT_TRUE(store.is_open());
+        UserAccount alice = make_account("alice", "h1", true);
+        alice.bind_nickname(1792224000);
+        ASSERT_TRUE(store.put(alice));
+        ASSERT_TRUE(store.put(make_account("bob", "h2")));
+        ASSERT_TRUE(store.put(make_account("carol", "h3")));
+        ASSERT_TRUE(store.remove("bob"));
+        EXPECT_FALSE(store.remove("bob"));
+        EXPECT_EQ(store.size(), 2u);
+    }
+    {
+        UserStore store(path);
+        EXPECT_EQ(store.size(), 2u);
+        EXPECT_EQ(store.pending_changes(), 3u);
+        auto alice = store.find("alice");
+        ASSERT_NE(alice, nullptr);
+        EXPECT_EQ(alice->password_hash(), "h1");
+        EXPECT_TRUE(alice->is_admin());
+        EXPECT_EQ(alice->last_ip(), "10.0.0.1");
+        EXPECT_EQ(alice->bound_at(), 1792224000u);
+        EXPECT_EQ(store.find("carol")->bound_at(), 0u);
+        EXPECT_EQ(store.find("bob"), nullptr);
+
+        ASSERT_TRUE(store.compact());
+        EXPECT_EQ(store.pending_changes(), 0u);
+        ASSERT_TRUE(store.put(make_account("carol", "h4")));
+    }
+    EXPECT_LT(std::filesystem::file_size(path + ".log"), 64u);
+    UserStore store(path);
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.pending_changes(), 1u);
+    EXPECT_EQ(store.find("carol")->password_hash(), "h4");
+    EXPECT_EQ(store.find("alice")->last_login(), "2026-10-17 12:00:00");
+    EXPECT_EQ(store.find("alice")->bound_at(), 1792224000u);
+    EXPECT_FALSE(store.contains("bob"));
+}
+
+/**
+ * @brief 중간에 멈춰 잘린 로그 항목은 버리고, 손상된 스냅샷이면 변경을 거부하는지 확인한다.
+ */
+TEST(UserStoreTest, DropsTruncatedLogTailAndRejectsCorruptSnapshot) {
+    TempDir dir("user_store_torn_test");
+    const std::string path = dir.path + "/accounts";
+    {
+        UserStore store(path);
+        ASSERT_TRUE(store.put(make_account("alice", "h1")));
+        ASSERT_TRUE(store.put(make_account("bob", "h2")));
+    }
+    auto size = std::filesystem::file_size(path + ".log");
+    std::filesystem::resize_file(path + ".log", size - 3);
+    {
+        UserStore store(path);
+        ASSERT_TRUE(store.is_open());
+        EXPECT_TRUE(store.contains("alice"));
+        EXPECT_FALSE(store.contains("bob"));
+        ASSERT_TRUE(store.put(make_account("bob", "h3")));
+    }
+    {
+        UserStore store(path);
+        EXPECT_EQ(store.find("bob")->password_hash(), "h3");
+    }
+
+    std::ofstream(path + ".snapshot", std::ios::binary) << "garbage";
+    UserStore store(path);
+    EXPECT_FALSE(store.is_open());
+    EXPECT_FALSE(store.put(make_account("dave", "h5")));
+}
+
+/**
+ * @brief 변경분이 한도에 이르면 백그라운드에서 합치고, 그동안 읽는 스레드는 항상 계정을 찾는지 확인한다.
+ */
+TEST(UserStoreTest, BackgroundCompactionKeepsReadersConsistent) {
+    TempDir dir("user_store_background_test");
+    const std::string path = dir.path + "/accounts";
+    UserStore store(path, 64, std::chrono::milliseconds(0));
+    ASSERT_TRUE(store.put(make_account("root", "r", true)));
+
+    std::atomic<bool> done{false};
+    std::atomic<int> misses{0};
+    std::thread reader([&]() {
+        while (!done) {
+            if (!store.find("root"))
+                ++misses;
+        }
+    });
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_TRUE(store.put(make_account("user" + std::to_string(i), "h" + std::to_string(i))));
+    done = true;
+    reader.join();
+    EXPECT_EQ(misses, 0);
+    EXPECT_EQ(store.size(), 1001u);
+    EXPECT_LE(store.pending_changes(), 1001u);
+
+    for (int i = 0; i < 100 && store.pending_changes() >= 64; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_LT(store.pending_changes(), 64u);
+    for (int i = 0; i < 1000; i += 97)
+        EXPECT_EQ(store.find("user" + std::to_string(i))->password_hash(), "h" + std::to_string(i));
+}
+
+/**
+ * @brief 다른 저장소가 열고 있는 경로는 열지 못하고, `close()` 뒤에는 이전 저장소의 변경이 실패하며
+ *        새 저장소가 합치지 않은 변경분까지 이어받는지 확인한다. (무중단 재시작의 저장소 인계)
+ */
+TEST(UserStoreTest, SecondWriterIsRefusedUntilClose) {
+    TempDir dir("user_store_lock_test");
+    const std::string path = dir.path + "/accounts";
+    UserStore old_store(path);
+    ASSERT_TRUE(old_store.is_open());
+    ASSERT_TRUE(old_store.put(make_account("alice", "h1")));
+    {
+        UserStore second(path);
+        EXPECT_FALSE(second.is_open());
+        EXPECT_FALSE(second.put(make_account("mallory", "h2")));
+    }
+
+    old_store.close();
+    EXPECT_FALSE(old_store.is_open());
+    EXPECT_FALSE(old_store.put(make_account("bob", "h3")));
+    EXPECT_FALSE(old_store.compact());
+    EXPECT_NE(old_store.find("alice"), nullptr); // 닫은 뒤에도 마지막 상태는 읽을 수 있다
+
+    UserStore new_store(path);
+    ASSERT_TRUE(new_store.is_open());
+    EXPECT_EQ(new_store.pending_changes(), 1u);
+    EXPECT_NE(new_store.find("alice"), nullptr);
+    EXPECT_EQ(new_store.find("bob"), nullptr);
+    EXPECT_TRUE(new_store.put(make_account("carol", "h4")));
+}
+
+/**
+ * @brief 파일 없이 메모리에서만 쓰는 경우에도 합치기 전후로 같은 결과를 내는지 확인한다.
+ */
+TEST(UserStoreTest, MemoryOnlyStore) {
+    UserStore store("");
+    ASSERT_TRUE(store.is_open());
+    ASSERT_TRUE(store.put(make_account("alice", "h1")));
+    ASSERT_TRUE(store.put(make_account("bob", "h2")));
+    ASSERT_TRUE(store.compact());
+    ASSERT_TRUE(store.remove("alice"));
+    ASSERT_TRUE(store.compact());
+    EXPECT_EQ(store.size(), 1u);
+    EXPECT_EQ(store.pending_changes(), 0u);
+    EXPECT_FALSE(store.contains("alice"));
+    EXPECT_EQ(store.find("bob")->password_hash(), "h2");
+}